@@ -65,6 +65,18 @@ find_package(Threads REQUIRED)
 list(APPEND CPP_SIMPLE_INCLUED_DIR ${CMAKE_PTHREADS_INCLUDE_DIR})
 list(APPEND CPP_SIMPLE_LIBRARIES ${CMAKE_THREAD_LIBS_INIT})
 
+# SIM Always built
+list(APPEND SIM_INCLUDE_DIRS ${CMAKE_PTHREADS_INCLUDE_DIR})
+list(APPEND SIM_LIBRARIES ${CMAKE_THREAD_LIBS_INIT})
+
+# SHM Always built
+list(APPEND SHM_INCLUDE_DIRS ${CMAKE_PTHREADS_INCLUDE_DIR})
+list(APPEND SHM_LIBRARIES ${CMAKE_THREAD_LIBS_INIT})
+
+# WS Always built
+list(APPEND WS_INCLUDE_DIRS ${CMAKE_PTHREADS_INCLUDE_DIR})
+list(APPEND WS_LIBRARIES ${CMAKE_THREAD_LIBS_INIT})
+
 if (TBB_ROOT)
 #   Threads package already required for CPP_SIMPLE
 #   find_package(Threads REQUIRED)
@@ -83,6 +95,24 @@ if (SHAD_RUNTIME_SYSTEM STREQUAL "CPP_SIMPLE")
   include_directories(${THREADS_PTHREADS_INCLUDE_DIR})
   set(HAVE_CPP_SIMPLE 1)
   set(SHAD_RUNTIME_LIB ${CMAKE_THREAD_LIBS_INIT})
+elseif (SHAD_RUNTIME_SYSTEM STREQUAL "SIM")
+  message(STATUS "Using the in-process multi-locality simulator (SIM) as backend of the Abstract Runtime API.")
+  find_package(Threads REQUIRED)
+  include_directories(${THREADS_PTHREADS_INCLUDE_DIR})
+  set(HAVE_SIM 1)
+  set(SHAD_RUNTIME_LIB ${CMAKE_THREAD_LIBS_INIT})
+elseif (SHAD_RUNTIME_SYSTEM STREQUAL "SHM")
+  message(STATUS "Using the single-node multi-process shared-memory (SHM) backend of the Abstract Runtime API.")
+  find_package(Threads REQUIRED)
+  include_directories(${THREADS_PTHREADS_INCLUDE_DIR})
+  set(HAVE_SHM 1)
+  set(SHAD_RUNTIME_LIB ${CMAKE_THREAD_LIBS_INIT})
+elseif (SHAD_RUNTIME_SYSTEM STREQUAL "WS")
+  message(STATUS "Using the native work-stealing (WS) backend of the Abstract Runtime API.")
+  find_package(Threads REQUIRED)
+  include_directories(${THREADS_PTHREADS_INCLUDE_DIR})
+  set(HAVE_WS 1)
+  set(SHAD_RUNTIME_LIB ${CMAKE_THREAD_LIBS_INIT})
 elseif (SHAD_RUNTIME_SYSTEM STREQUAL "TBB")
   message(STATUS "Using Intel Threading Building Blocks (TBB) as backend of the Abstract Runtime API.")
 
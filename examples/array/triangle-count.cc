@@ -63,8 +63,9 @@ size_t TriangleCount(CSRGraph &G) {
   // 1 - For each vertex in the graph i
   shad::rt::Handle handle;
 
+  // Vertex i is visited where its edge-list offsets live.
   shad::rt::asyncForEachOnAll(
-      handle,
+      handle, G.vertexPtr()->Affinity(),
       [](shad::rt::Handle &handle, const CSRGraph &G, size_t i) {
         auto vertexPtr = G.vertexPtr();
 
@@ -31,6 +31,7 @@
 
 #include "shad/data_structures/array.h"
 #include "shad/extensions/graph_library/edge_index.h"
+#include "shad/runtime/collectives.h"
 #include "shad/runtime/runtime.h"
 #include "shad/util/measure.h"
 
@@ -103,21 +104,11 @@ void PageRank(shad::EdgeIndex<uint64_t, uint64_t>::ObjectID &G, int maxIters,
     shad::rt::waitForCompletion(handle);
 
     // This performs a reduction into a single counter.
-    std::vector<double> reducer(shad::rt::numLocalities());
-
-    for (auto &locality : shad::rt::allLocalities()) {
-      shad::rt::asyncExecuteAtWithRet(
-          handle, locality,
-          [](shad::rt::Handle &, const size_t &, double *value) {
-            *value = error;
-          },
-          size_t(0), &reducer[static_cast<uint32_t>(locality)]);
-    }
-    shad::rt::waitForCompletion(handle);
-
-    for (double i : reducer) error += i;
+    double totalError;
+    shad::rt::reduce([](const size_t &, double *value) { *value = error; },
+                     size_t(0), &totalError);
 
-    if (error < epsilon) break;
+    if (totalError < epsilon) break;
 
     shad::rt::asyncExecuteOnAll(
         handle, [](shad::rt::Handle &, const size_t &) { error = 0; },
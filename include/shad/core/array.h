@@ -408,7 +408,10 @@ class array : public AbstractDataStructure<array<T, N>> {
   }
 
   /// @brief Constructor.
-  explicit array(ObjectID oid) : chunk_{new T[chunk_size()]}, oid_{oid} {}
+  explicit array(ObjectID oid) : chunk_{new T[chunk_size()]}, oid_{oid} {
+    rt::impl::NumaTopology::Instance().Place(chunk_.get(),
+                                             chunk_size() * sizeof(T));
+  }
 
  private:
   std::unique_ptr<T[]> chunk_;
@@ -301,10 +301,14 @@ local_map_init(
   std::vector<mapped_t> map_res(parts.size(), init);
 
   if (parts.size()) {
-    auto map_args = std::make_tuple(parts.data(), map_kernel, map_res.data());
+    auto map_args = std::make_tuple(parts.data(), map_kernel, map_res.data(),
+                                    parts.size());
     shad::rt::forEachAt(
         rt::thisLocality(),
         [](const typeof(map_args)& map_args, size_t iter) {
+          // run on the NUMA domain holding the partition
+          rt::impl::DomainScope scope(
+              rt::homeDomain(iter, std::get<3>(map_args)));
           auto pfirst = std::get<0>(map_args) + iter;
           auto map_kernel = std::get<1>(map_args);
           auto res_unit = std::get<2>(map_args) + iter;
@@ -339,10 +343,13 @@ void local_map_void(ForwardIt first, ForwardIt last, MapF&& map_kernel) {
       first, last, rt::impl::getConcurrency());
 
   if (parts.size()) {
-    auto map_args = std::make_tuple(parts.data(), map_kernel);
+    auto map_args = std::make_tuple(parts.data(), map_kernel, parts.size());
     shad::rt::forEachAt(
         rt::thisLocality(),
         [](const typeof(map_args)& map_args, size_t iter) {
+          // run on the NUMA domain holding the partition
+          rt::impl::DomainScope scope(
+              rt::homeDomain(iter, std::get<2>(map_args)));
           auto pfirst = std::get<0>(map_args) + iter;
           auto map_kernel = std::get<1>(map_args);
           // map over the partition
@@ -361,10 +368,14 @@ void local_map_void_offset(ForwardIt first, ForwardIt last, MapF&& map_kernel) {
       first, last, rt::impl::getConcurrency());
 
   if (parts.size()) {
-    auto map_args = std::make_tuple(parts.data(), map_kernel, first);
+    auto map_args =
+        std::make_tuple(parts.data(), map_kernel, first, parts.size());
     shad::rt::forEachAt(
         rt::thisLocality(),
         [](const typeof(map_args)& map_args, size_t iter) {
+          // run on the NUMA domain holding the partition
+          rt::impl::DomainScope scope(
+              rt::homeDomain(iter, std::get<3>(map_args)));
           auto pfirst = std::get<0>(map_args) + iter;
           auto map_kernel = std::get<1>(map_args);
           auto first = std::get<2>(map_args);
@@ -26,6 +26,7 @@
 #define INCLUDE_SHAD_CORE_IMPL_NUMERIC_OPS_H
 
 #include <algorithm>
+#include <cstddef>
 #include <functional>
 #include <iterator>
 #include <numeric>
@@ -33,12 +34,22 @@
 #include "shad/core/execution.h"
 #include "shad/distributed_iterator_traits.h"
 #include "shad/runtime/runtime.h"
+#include "shad/runtime/task_graph.h"
 
 #include "impl_patterns.h"
 
 namespace shad {
 namespace impl {
 
+// The scan of a chunk: the end of its output, as an offset from the start of
+// the whole output, and its total.  It is shipped back to the locality
+// running the scan by memcpy, hence it holds no iterator.
+template <typename T>
+struct scan_result {
+  std::ptrdiff_t last;
+  T total;
+};
+
 template <typename ForwardIterator, typename T>
 void iota(ForwardIterator first, ForwardIterator last, const T& value) {
   using itr_traits = distributed_iterator_traits<ForwardIterator>;
@@ -228,9 +239,8 @@ OutputIt adjacent_difference(distributed_parallel_tag&& policy, InputIt first,
             *d_first = acc;
           } else {
             auto it = itr_traits::iterator_from_local(gbegin, gend, begin);
-            --it;
             std::advance(d_first, (std::distance(gbegin, it)));
-            value_t val = *d_first;
+            --it;
             *d_first = op(*begin, *it);
           }
           while (++begin != end) {
@@ -509,22 +519,25 @@ OutputIt inclusive_scan(distributed_parallel_tag&& policy, InputIt first,
                         InputIt last, OutputIt d_first, BinaryOperation op) {
   using itr_traits = distributed_iterator_traits<InputIt>;
   using value_t = typename itr_traits::value_type;
+  using result_t = scan_result<value_t>;
+  using fixup_args_t = std::tuple<OutputIt, OutputIt, BinaryOperation, value_t>;
   auto localities = itr_traits::localities(first, last);
   auto startingLoc = localities.begin();
   uint32_t numLoc = localities.size();
   if (numLoc == 0) {
     return d_first;
   }
-  std::vector<std::pair<OutputIt, value_t>> res(numLoc);
-  rt::Handle h;
-  size_t i = 0;
+  // The fix-up of each chunk is released as soon as the chunks preceding it
+  // have been scanned, instead of waiting for the slowest chunk.
+  rt::TaskGraph graph;
+  std::vector<rt::TaskGraph::TaskId> scans;
   for (auto locality = startingLoc, end = localities.end(); locality != end;
-       ++locality, ++i) {
-    rt::asyncExecuteAtWithRet(
-        h, locality,
+       ++locality) {
+    scans.push_back(graph.AddTask(
+        locality,
         [](rt::Handle&,
            const std::tuple<InputIt, InputIt, OutputIt, BinaryOperation>& args,
-           std::pair<OutputIt, value_t>* result) {
+           result_t* result) {
           auto d_first = std::get<2>(args);
           auto df = d_first;
           auto gbegin = std::get<0>(args);
@@ -536,7 +549,7 @@ OutputIt inclusive_scan(distributed_parallel_tag&& policy, InputIt first,
           auto dist = std::distance(gbegin, it);
           std::advance(d_first, dist);
           if (begin == end) {
-            *result = std::make_pair(d_first, value_t{});
+            *result = result_t{dist, value_t{}};
             return;
           }
           BinaryOperation op = std::get<3>(args);
@@ -546,43 +559,55 @@ OutputIt inclusive_scan(distributed_parallel_tag&& policy, InputIt first,
             acc = op(std::move(acc), *begin);
             *++d_first = acc;
           }
-          *result = std::make_pair(++d_first, acc);
+          *result = result_t{std::distance(df, ++d_first), acc};
         },
-        std::make_tuple(first, last, d_first, op), &res[i]);
+        std::make_tuple(first, last, d_first, op)));
   }
-  rt::waitForCompletion(h);
-  auto d_f = res[0].first;
-  value_t acc = res[0].second;
-  OutputIt chunk_end = d_first;
-  for (i = 1; i < numLoc; ++i) {
-    chunk_end = res[i].first;
-    auto d_localities = itr_traits::localities(d_f, chunk_end);
-    auto d_startingLoc = d_localities.begin();
-    for (auto locality = d_startingLoc, end = d_localities.end();
-         locality != end; ++locality) {
-      rt::asyncExecuteAt(
-          h, locality,
-          [](rt::Handle&, const std::tuple<OutputIt, OutputIt, BinaryOperation,
-                                           value_t>& args) {
-            auto gbegin = std::get<0>(args);
-            auto gend = std::get<1>(args);
-            auto local_range =
-                itr_traits::local_range(std::get<0>(args), std::get<1>(args));
-            auto begin = local_range.begin();
-            auto end = local_range.end();
-            BinaryOperation op = std::get<2>(args);
-            auto acc = std::get<3>(args);
-            for (auto it = begin; it != end; ++it) {
-              *it = op(*it, std::move(acc));
-            }
-          },
-          std::make_tuple(d_f, chunk_end, op, acc));
-    }
-    d_f = chunk_end;
-    acc = op(std::move(acc), res[i].second);
+  for (size_t i = 1; i < numLoc; ++i) {
+    std::vector<rt::TaskGraph::TaskId> dependencies(scans.begin(),
+                                                    scans.begin() + i + 1);
+    graph.AddDeferredTask(
+        rt::thisLocality(),
+        [](rt::Handle& h, const fixup_args_t& args) {
+          auto d_localities =
+              itr_traits::localities(std::get<0>(args), std::get<1>(args));
+          for (auto locality = d_localities.begin(), end = d_localities.end();
+               locality != end; ++locality) {
+            rt::asyncExecuteAt(
+                h, locality,
+                [](rt::Handle&, const fixup_args_t& args) {
+                  auto local_range = itr_traits::local_range(std::get<0>(args),
+                                                             std::get<1>(args));
+                  auto begin = local_range.begin();
+                  auto end = local_range.end();
+                  BinaryOperation op = std::get<2>(args);
+                  auto acc = std::get<3>(args);
+                  for (auto it = begin; it != end; ++it) {
+                    *it = op(*it, std::move(acc));
+                  }
+                },
+                args);
+          }
+        },
+        [scans, i, op, d_first](const rt::TaskGraph& graph) {
+          BinaryOperation fold = op;
+          auto d_f = graph.Result<result_t>(scans[0]).last;
+          value_t acc = graph.Result<result_t>(scans[0]).total;
+          for (size_t j = 1; j < i; ++j) {
+            d_f = graph.Result<result_t>(scans[j]).last;
+            acc = fold(std::move(acc), graph.Result<result_t>(scans[j]).total);
+          }
+          return std::make_tuple(
+              std::next(d_first, d_f),
+              std::next(d_first, graph.Result<result_t>(scans[i]).last), op,
+              acc);
+        },
+        dependencies);
   }
+  rt::Handle h;
+  graph.Run(h);
   rt::waitForCompletion(h);
-  return chunk_end;
+  return std::next(d_first, graph.Result<result_t>(scans.back()).last);
 }
 
 template <class InputIt, class OutputIt, class BinaryOperation, class T>
@@ -628,19 +653,23 @@ OutputIt inclusive_scan(distributed_parallel_tag&& policy, InputIt first,
                         InputIt last, OutputIt d_first, BinaryOperation op,
                         T init) {
   using itr_traits = distributed_iterator_traits<InputIt>;
+  using outitr_traits = distributed_iterator_traits<OutputIt>;
+  using result_t = scan_result<T>;
+  using fixup_args_t = std::tuple<OutputIt, OutputIt, BinaryOperation, T>;
   auto localities = itr_traits::localities(first, last);
   auto startingLoc = localities.begin();
   uint32_t numLoc = localities.size();
-  std::vector<std::pair<OutputIt, T>> res(numLoc);
-  rt::Handle h;
-  size_t i = 0;
+  // The fix-up of each chunk is released as soon as the chunks preceding it
+  // have been scanned, instead of waiting for the slowest chunk.
+  rt::TaskGraph graph;
+  std::vector<rt::TaskGraph::TaskId> scans;
   for (auto locality = startingLoc, end = localities.end(); locality != end;
-       ++locality, ++i) {
-    rt::asyncExecuteAtWithRet(
-        h, locality,
+       ++locality) {
+    scans.push_back(graph.AddTask(
+        locality,
         [](rt::Handle&,
            const std::tuple<InputIt, InputIt, OutputIt, BinaryOperation>& args,
-           std::pair<OutputIt, T>* result) {
+           result_t* result) {
           auto d_first = std::get<2>(args);
           auto df = d_first;
           auto gbegin = std::get<0>(args);
@@ -652,7 +681,7 @@ OutputIt inclusive_scan(distributed_parallel_tag&& policy, InputIt first,
           auto dist = std::distance(gbegin, it);
           std::advance(d_first, dist);
           if (begin == end) {
-            *result = std::make_pair(d_first, T{});
+            *result = result_t{dist, T{}};
             return;
           }
           BinaryOperation op = std::get<3>(args);
@@ -662,44 +691,57 @@ OutputIt inclusive_scan(distributed_parallel_tag&& policy, InputIt first,
             acc = op(std::move(acc), *begin);
             *++d_first = acc;
           }
-          *result = std::make_pair(++d_first, acc);
+          *result = result_t{std::distance(df, ++d_first), acc};
         },
-        std::make_tuple(first, last, d_first, op), &res[i]);
+        std::make_tuple(first, last, d_first, op)));
   }
-  rt::waitForCompletion(h);
-  auto d_f = d_first;
-  auto acc = init;
-  OutputIt chunk_end = d_first;
-  using outitr_traits = distributed_iterator_traits<OutputIt>;
-  for (i = 0; i < numLoc; ++i) {
-    chunk_end = res[i].first;
-    auto d_localities = outitr_traits::localities(d_f, chunk_end);
-    auto d_startingLoc = d_localities.begin();
-    for (auto locality = d_startingLoc, end = d_localities.end();
-         locality != end; ++locality) {
-      rt::asyncExecuteAt(
-          h, locality,
-          [](rt::Handle&,
-             const std::tuple<OutputIt, OutputIt, BinaryOperation, T>& args) {
-            auto gbegin = std::get<0>(args);
-            auto gend = std::get<1>(args);
-            auto local_range =
-                itr_traits::local_range(std::get<0>(args), std::get<1>(args));
-            auto begin = local_range.begin();
-            auto end = local_range.end();
-            BinaryOperation op = std::get<2>(args);
-            auto acc = std::get<3>(args);
-            for (auto it = begin; it != end; ++it) {
-              *it = op(std::move(acc), *it);
-            }
-          },
-          std::make_tuple(d_f, chunk_end, op, acc));
-    }
-    d_f = chunk_end;
-    acc = op(std::move(acc), res[i].second);
+  for (size_t i = 0; i < numLoc; ++i) {
+    std::vector<rt::TaskGraph::TaskId> dependencies(scans.begin(),
+                                                    scans.begin() + i + 1);
+    graph.AddDeferredTask(
+        rt::thisLocality(),
+        [](rt::Handle& h, const fixup_args_t& args) {
+          auto d_localities =
+              outitr_traits::localities(std::get<0>(args), std::get<1>(args));
+          for (auto locality = d_localities.begin(), end = d_localities.end();
+               locality != end; ++locality) {
+            rt::asyncExecuteAt(
+                h, locality,
+                [](rt::Handle&, const fixup_args_t& args) {
+                  auto local_range = itr_traits::local_range(std::get<0>(args),
+                                                             std::get<1>(args));
+                  auto begin = local_range.begin();
+                  auto end = local_range.end();
+                  BinaryOperation op = std::get<2>(args);
+                  auto acc = std::get<3>(args);
+                  for (auto it = begin; it != end; ++it) {
+                    *it = op(std::move(acc), *it);
+                  }
+                },
+                args);
+          }
+        },
+        [scans, i, op, init, d_first](const rt::TaskGraph& graph) {
+          BinaryOperation fold = op;
+          std::ptrdiff_t d_f = 0;
+          T acc = init;
+          for (size_t j = 0; j < i; ++j) {
+            d_f = graph.Result<result_t>(scans[j]).last;
+            acc = fold(std::move(acc), graph.Result<result_t>(scans[j]).total);
+          }
+          return std::make_tuple(
+              std::next(d_first, d_f),
+              std::next(d_first, graph.Result<result_t>(scans[i]).last), op,
+              acc);
+        },
+        dependencies);
   }
+  rt::Handle h;
+  graph.Run(h);
   rt::waitForCompletion(h);
-  return chunk_end;
+  return numLoc == 0
+             ? d_first
+             : std::next(d_first, graph.Result<result_t>(scans.back()).last);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -400,6 +400,8 @@ class vector : public AbstractDataStructure<vector<T>> {
     for (std::uint32_t i = 0; i <= rt::numLocalities(); i++)
       p_.emplace_back(i * N / rt::numLocalities());
     chunk_ = std::unique_ptr<T[]>{new T[chunk_size()]};
+    rt::impl::NumaTopology::Instance().Place(chunk_.get(),
+                                             chunk_size() * sizeof(T));
 
     ptrs_.resize(rt::numLocalities());
   }
@@ -183,8 +183,10 @@ class AbstractDataStructure {
     }
 
     static Catalog *Instance() {
-      static Catalog instance;
-      return &instance;
+      // One catalog for each of the localities hosted by this process.
+      static std::unique_ptr<Catalog[]> instances(
+          new Catalog[rt::impl::numProcessLocalities()]);
+      return &instances[rt::impl::processLocalityIndex()];
     }
 
     ObjectID GetNextID() {
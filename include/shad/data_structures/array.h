@@ -31,11 +31,13 @@
 #include <iterator>
 #include <memory>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "shad/data_structures/abstract_data_structure.h"
 #include "shad/data_structures/buffer.h"
+#include "shad/runtime/affinity.h"
 #include "shad/runtime/runtime.h"
 
 namespace shad {
@@ -93,6 +95,30 @@ class Array : public AbstractDataStructure<Array<T>> {
   /// @return The size of the shad::Array.
   size_t Size() const noexcept { return size_; }
 
+  /// @brief The locality owning each position of the shad::Array.
+  ///
+  /// Typical usage:
+  /// @code
+  /// shad::rt::forEachOnAll(edsPtr->Affinity(),
+  ///     [](const ObjectID &oid, size_t i) {
+  ///       auto edsPtr = shad::Array<size_t>::GetPtr(oid);
+  ///       edsPtr->At(i);  // Local.
+  ///     },
+  ///     edsPtr->GetGlobalID(), edsPtr->Size());
+  /// @endcode
+  ///
+  /// @return The affinity of the positions of the shad::Array.
+  rt::IterationAffinity Affinity() const {
+    size_t chunkSize = size_ / rt::numLocalities();
+    std::vector<size_t> offsets(1, 0);
+    for (auto &locality : rt::allLocalities()) {
+      size_t localSize =
+          chunkSize + (locality < rt::Locality(pivot_) ? 0 : 1);
+      offsets.push_back(offsets.back() + localSize);
+    }
+    return rt::IterationAffinity::Blocks(std::move(offsets));
+  }
+
 #ifdef DOXYGEN_IS_RUNNING
   /// @brief Create method.
   ///
@@ -591,6 +617,20 @@ class Array : public AbstractDataStructure<Array<T>> {
   void AsyncGetElements(rt::Handle& h, T* local_data,
                         const uint64_t idx, const uint64_t num_el);
 
+  /// @brief Asynchronously read the elements at arbitrary positions.
+  ///
+  /// The positions held by each locality are read with a single gather,
+  /// merging the runs of consecutive positions.  FillPtrs() must have been
+  /// called, as for AsyncGetElements(), and indices must stay valid until
+  /// the handle has been waited for.
+  ///
+  /// @param[in,out] h The handle to be used to wait for completion.
+  /// @param[out] local_data The buffer receiving the elements, in order.
+  /// @param[in] indices The positions of the elements.
+  /// @param[in] num_el The number of positions.
+  void AsyncGatherElements(rt::Handle& h, T* local_data,
+                           const uint64_t* indices, const uint64_t num_el);
+
 
   void AsyncPutElements(rt::Handle& h, T* local_data,
                         const uint64_t idx, const uint64_t num_el);
@@ -694,11 +734,17 @@ void PrintAllElements() {
         start += chunkSize;
       }
     }
-    if ((rt::thisLocality() < pivot) & (chunkSize > 0)) {
-      data_.resize(chunkSize, initValue);
-    } else {
-      data_.resize(chunkSize + 1, initValue);
-    }
+    size_t localSize = chunkSize;
+    if (!(rt::thisLocality() < pivot) || chunkSize == 0) ++localSize;
+
+    // Spread the chunk across the NUMA domains before initializing it, so
+    // that its pages are allocated where they belong (std::vector<bool> does
+    // not expose its storage).
+    data_.reserve(localSize);
+    if constexpr (!std::is_same<T, bool>::value)
+      rt::impl::NumaTopology::Instance().Place(data_.data(),
+                                               localSize * sizeof(T));
+    data_.resize(localSize, initValue);
   }
 
    constexpr void DataStructurePointerCommunication() {
@@ -722,6 +768,32 @@ void PrintAllElements() {
   BuffersVector buffers_;
   std::vector<T*> ptrs_;
 
+  struct GatherBatch {
+    std::vector<rt::DmaSegment<T>> segments;
+    std::vector<uint64_t> positions;
+  };
+
+  static void AsyncGatherFun(
+      rt::Handle &,
+      const std::tuple<GatherBatch *, T *, rt::Locality> &args) {
+    std::unique_ptr<GatherBatch> batch(std::get<0>(args));
+    auto &segments = batch->segments;
+    size_t numElements = 0;
+    for (auto &segment : segments) numElements += segment.numElements;
+
+    std::unique_ptr<T[]> buffer(new T[numElements]);
+    rt::dmaGather(buffer.get(), std::get<2>(args), segments.data(),
+                  segments.size());
+
+    T *local_data = std::get<1>(args);
+    T *value = buffer.get();
+    for (size_t i = 0; i < segments.size(); ++i) {
+      std::copy(value, value + segments[i].numElements,
+                local_data + batch->positions[i]);
+      value += segments[i].numElements;
+    }
+  }
+
   struct InsertAtArgs {
     ObjectID oid;
     size_t pos;
@@ -1443,6 +1515,44 @@ void Array<T>::AsyncGetElements(rt::Handle& h, T* local_data,
 }
 
 
+template <typename T>
+void Array<T>::AsyncGatherElements(rt::Handle& h, T* local_data,
+                                   const uint64_t* indices,
+                                   const uint64_t num_el) {
+  if (size_ < rt::numLocalities()) {
+    for (size_t i = 0; i < num_el; ++i) {
+      AsyncAt(h, indices[i], local_data + i);
+    }
+    return;
+  }
+
+  std::vector<GatherBatch *> batches(rt::numLocalities(), nullptr);
+  for (size_t i = 0; i < num_el; ++i) {
+    auto target =
+        getTargetLocalityFromTargePosition(dataDistribution_, indices[i]);
+    auto &batch = batches[(uint32_t)target.first];
+    if (batch == nullptr) batch = new GatherBatch();
+
+    const T* address = ptrs_[(uint32_t)target.first] + target.second;
+    auto &segments = batch->segments;
+    if (!segments.empty() &&
+        segments.back().address + segments.back().numElements == address &&
+        batch->positions.back() + segments.back().numElements == i) {
+      ++segments.back().numElements;
+    } else {
+      segments.push_back({address, 1});
+      batch->positions.push_back(i);
+    }
+  }
+
+  for (uint32_t i = 0; i < batches.size(); ++i) {
+    if (batches[i] == nullptr) continue;
+    rt::asyncExecuteAt(h, rt::thisLocality(), AsyncGatherFun,
+                       std::make_tuple(batches[i], local_data,
+                                       rt::Locality(i)));
+  }
+}
+
 template <typename T>
 void Array<T>::AsyncPutElements(rt::Handle& h, T* local_data,
                                 const uint64_t idx, const uint64_t num_el) {
@@ -25,6 +25,8 @@
 #ifndef INCLUDE_SHAD_DATA_STRUCTURES_ATOMIC_H_
 #define INCLUDE_SHAD_DATA_STRUCTURES_ATOMIC_H_
 
+#include <atomic>
+
 #include "shad/data_structures/abstract_data_structure.h"
 
 namespace shad {
@@ -361,18 +363,8 @@ class Atomic : public AbstractDataStructure<Atomic<T>> {
       return atomic_compare_exchange_strong(&localInstance_,
                                            &expected, desired );
     }
-    bool ret;
-    using CasArgs = std::tuple<ObjectID, T, T>;
-    auto CasFun = [](const CasArgs &args, bool *result) {
-      auto ptr = Atomic<T>::GetPtr(std::get<0>(args));
-      T expected = std::get<1>(args);
-      *result = atomic_compare_exchange_strong(&(ptr->localInstance_),
-                                               &expected,
-                                               std::get<2>(args));
-    };
-    CasArgs args(oid_, expected, desired);
-    rt::executeAtWithRet(ownerLoc_, CasFun, args, &ret);
-    return ret;
+    return rt::atomicCompareExchange(ownerLoc_, OwnerAddress(), expected,
+                                     desired) == expected;
   }
 
   /// @brief Compare and exchange operation.
@@ -409,14 +401,7 @@ class Atomic : public AbstractDataStructure<Atomic<T>> {
     if (ownerLoc_ == rt::thisLocality()) {
      return localInstance_.fetch_add(add);
     }
-    T ret;
-    auto AddFun = [](const std::pair<ObjectID, T> &args, T *result) {
-      auto ptr = Atomic<T>::GetPtr(args.first);
-      *result = ptr->localInstance_.fetch_add(args.second);
-    };
-    auto args = std::make_pair(oid_, add);
-    rt::executeAtWithRet(ownerLoc_, AddFun, args, &ret);
-    return ret;
+    return rt::atomicFetchAdd(ownerLoc_, OwnerAddress(), add);
   }
 
   /// @brief Async Fetch Add operation.
@@ -430,14 +415,7 @@ class Atomic : public AbstractDataStructure<Atomic<T>> {
      *res = localInstance_.fetch_add(add);
      return;
     }
-    auto AddFun = [](rt::Handle&,
-                     const std::pair<ObjectID, T> &args, T *result) {
-      auto ptr = Atomic<T>::GetPtr(args.first);
-      *result = ptr->localInstance_.fetch_add(args.second);
-    };
-    auto args = std::make_pair(oid_, add);
-    rt::asyncExecuteAtWithRet(h, ownerLoc_, AddFun, args, res);
-    return;
+    rt::asyncAtomicFetchAdd(h, ownerLoc_, OwnerAddress(), add, res);
   }
 
   /// @brief Async Fetch Add operation, with no return value.
@@ -449,14 +427,7 @@ class Atomic : public AbstractDataStructure<Atomic<T>> {
      localInstance_.fetch_add(add);
      return;
     }
-    auto AddFun = [](rt::Handle&,
-                     const std::pair<ObjectID, T> &args) {
-      auto ptr = Atomic<T>::GetPtr(args.first);
-      ptr->localInstance_.fetch_add(args.second);
-    };
-    auto args = std::make_pair(oid_, add);
-    rt::asyncExecuteAt(h, ownerLoc_, AddFun, args);
-    return;
+    rt::asyncAtomicFetchAdd(h, ownerLoc_, OwnerAddress(), add);
   }
 
   /// @brief Fetch Sub operation.
@@ -467,14 +438,7 @@ class Atomic : public AbstractDataStructure<Atomic<T>> {
     if (ownerLoc_ == rt::thisLocality()) {
      return localInstance_.fetch_sub(sub);
     }
-    T ret;
-    auto SubFun = [](const std::pair<ObjectID, T> &args, T *result) {
-      auto ptr = Atomic<T>::GetPtr(args.first);
-      *result = ptr->localInstance_.fetch_sub(args.second);
-    };
-    auto args = std::make_pair(oid_, sub);
-    rt::executeAtWithRet(ownerLoc_, SubFun, args, &ret);
-    return ret;
+    return rt::atomicFetchSub(ownerLoc_, OwnerAddress(), sub);
   }
 
   /// @brief Async Fetch Sub operation.
@@ -488,14 +452,7 @@ class Atomic : public AbstractDataStructure<Atomic<T>> {
      *res = localInstance_.fetch_sub(sub);
      return;
     }
-    auto SubFun = [](rt::Handle&,
-                     const std::pair<ObjectID, T> &args, T *result) {
-      auto ptr = Atomic<T>::GetPtr(args.first);
-      *result = ptr->localInstance_.fetch_sub(args.second);
-    };
-    auto args = std::make_pair(oid_, sub);
-    rt::asyncExecuteAtWithRet(h, ownerLoc_, SubFun, args, res);
-    return;
+    rt::asyncAtomicFetchSub(h, ownerLoc_, OwnerAddress(), sub, res);
   }
 
   /// @brief Async Fetch Sub operation, with no return value.
@@ -507,14 +464,7 @@ class Atomic : public AbstractDataStructure<Atomic<T>> {
      localInstance_.fetch_sub(sub);
      return;
     }
-    auto SubFun = [](rt::Handle&,
-                     const std::pair<ObjectID, T> &args) {
-      auto ptr = Atomic<T>::GetPtr(args.first);
-      ptr->localInstance_.fetch_sub(args.second);
-    };
-    auto args = std::make_pair(oid_, sub);
-    rt::asyncExecuteAt(h, ownerLoc_, SubFun, args);
-    return;
+    rt::asyncAtomicFetchSub(h, ownerLoc_, OwnerAddress(), sub);
   }
 
   /// @brief Fetch And operation.
@@ -525,14 +475,7 @@ class Atomic : public AbstractDataStructure<Atomic<T>> {
     if (ownerLoc_ == rt::thisLocality()) {
      return localInstance_.fetch_and(operand);
     }
-    T ret;
-    auto AndFun = [](const std::pair<ObjectID, T> &args, T *result) {
-      auto ptr = Atomic<T>::GetPtr(args.first);
-      *result = ptr->localInstance_.fetch_and(args.second);
-    };
-    auto args = std::make_pair(oid_, operand);
-    rt::executeAtWithRet(ownerLoc_, AndFun, args, &ret);
-    return ret;
+    return rt::atomicFetchAnd(ownerLoc_, OwnerAddress(), operand);
   }
 
   /// @brief Async Fetch And operation.
@@ -546,14 +489,7 @@ class Atomic : public AbstractDataStructure<Atomic<T>> {
      *res = localInstance_.fetch_and(operand);
      return;
     }
-    auto AndFun = [](rt::Handle&,
-                     const std::pair<ObjectID, T> &args, T *result) {
-      auto ptr = Atomic<T>::GetPtr(args.first);
-      *result = ptr->localInstance_.fetch_and(args.second);
-    };
-    auto args = std::make_pair(oid_, operand);
-    rt::asyncExecuteAtWithRet(h, ownerLoc_, AndFun, args, res);
-    return;
+    rt::asyncAtomicFetchAnd(h, ownerLoc_, OwnerAddress(), operand, res);
   }
 
   /// @brief Async Fetch And operation, with no return value.
@@ -565,14 +501,7 @@ class Atomic : public AbstractDataStructure<Atomic<T>> {
      localInstance_.fetch_and(operand);
      return;
     }
-    auto AndFun = [](rt::Handle&,
-                     const std::pair<ObjectID, T> &args) {
-      auto ptr = Atomic<T>::GetPtr(args.first);
-      ptr->localInstance_.fetch_and(args.second);
-    };
-    auto args = std::make_pair(oid_, operand);
-    rt::asyncExecuteAt(h, ownerLoc_, AndFun, args);
-    return;
+    rt::asyncAtomicFetchAnd(h, ownerLoc_, OwnerAddress(), operand);
   }
 
   /// @brief Fetch Or operation.
@@ -583,14 +512,7 @@ class Atomic : public AbstractDataStructure<Atomic<T>> {
     if (ownerLoc_ == rt::thisLocality()) {
      return localInstance_.fetch_or(operand);
     }
-    T ret;
-    auto OrFun = [](const std::pair<ObjectID, T> &args, T *result) {
-      auto ptr = Atomic<T>::GetPtr(args.first);
-      *result = ptr->localInstance_.fetch_or(args.second);
-    };
-    auto args = std::make_pair(oid_, operand);
-    rt::executeAtWithRet(ownerLoc_, OrFun, args, &ret);
-    return ret;
+    return rt::atomicFetchOr(ownerLoc_, OwnerAddress(), operand);
   }
 
   /// @brief Async Fetch Or operation.
@@ -604,14 +526,7 @@ class Atomic : public AbstractDataStructure<Atomic<T>> {
      *res = localInstance_.fetch_or(operand);
      return;
     }
-    auto OrFun = [](rt::Handle&,
-                     const std::pair<ObjectID, T> &args, T *result) {
-      auto ptr = Atomic<T>::GetPtr(args.first);
-      *result = ptr->localInstance_.fetch_or(args.second);
-    };
-    auto args = std::make_pair(oid_, operand);
-    rt::asyncExecuteAtWithRet(h, ownerLoc_, OrFun, args, res);
-    return;
+    rt::asyncAtomicFetchOr(h, ownerLoc_, OwnerAddress(), operand, res);
   }
 
   /// @brief Async Fetch Or operation, with no return value.
@@ -623,14 +538,7 @@ class Atomic : public AbstractDataStructure<Atomic<T>> {
      localInstance_.fetch_or(operand);
      return;
     }
-    auto OrFun = [](rt::Handle&,
-                     const std::pair<ObjectID, T> &args) {
-      auto ptr = Atomic<T>::GetPtr(args.first);
-      ptr->localInstance_.fetch_or(args.second);
-    };
-    auto args = std::make_pair(oid_, operand);
-    rt::asyncExecuteAt(h, ownerLoc_, OrFun, args);
-    return;
+    rt::asyncAtomicFetchOr(h, ownerLoc_, OwnerAddress(), operand);
   }
 
   /// @brief Fetch Xor operation.
@@ -641,14 +549,7 @@ class Atomic : public AbstractDataStructure<Atomic<T>> {
     if (ownerLoc_ == rt::thisLocality()) {
      return localInstance_.fetch_xor(operand);
     }
-    T ret;
-    auto XorFun = [](const std::pair<ObjectID, T> &args, T *result) {
-      auto ptr = Atomic<T>::GetPtr(args.first);
-      *result = ptr->localInstance_.fetch_xor(args.second);
-    };
-    auto args = std::make_pair(oid_, operand);
-    rt::executeAtWithRet(ownerLoc_, XorFun, args, &ret);
-    return ret;
+    return rt::atomicFetchXor(ownerLoc_, OwnerAddress(), operand);
   }
 
   /// @brief Async Fetch Xor operation.
@@ -662,14 +563,7 @@ class Atomic : public AbstractDataStructure<Atomic<T>> {
      *res = localInstance_.fetch_xor(operand);
      return;
     }
-    auto XorFun = [](rt::Handle&,
-                     const std::pair<ObjectID, T> &args, T *result) {
-      auto ptr = Atomic<T>::GetPtr(args.first);
-      *result = ptr->localInstance_.fetch_xor(args.second);
-    };
-    auto args = std::make_pair(oid_, operand);
-    rt::asyncExecuteAtWithRet(h, ownerLoc_, XorFun, args, res);
-    return;
+    rt::asyncAtomicFetchXor(h, ownerLoc_, OwnerAddress(), operand, res);
   }
 
   /// @brief Async Fetch Xor operation, with no return value.
@@ -681,14 +575,7 @@ class Atomic : public AbstractDataStructure<Atomic<T>> {
      localInstance_.fetch_xor(operand);
      return;
     }
-    auto XorFun = [](rt::Handle&,
-                     const std::pair<ObjectID, T> &args) {
-      auto ptr = Atomic<T>::GetPtr(args.first);
-      ptr->localInstance_.fetch_xor(args.second);
-    };
-    auto args = std::make_pair(oid_, operand);
-    rt::asyncExecuteAt(h, ownerLoc_, XorFun, args);
-    return;
+    rt::asyncAtomicFetchXor(h, ownerLoc_, OwnerAddress(), operand);
   }
 
  protected:
@@ -701,9 +588,27 @@ class Atomic : public AbstractDataStructure<Atomic<T>> {
   template <typename>
   friend class AbstractDataStructure;
 
+  // The address of localInstance_ in the owner, fetched with the first
+  // remote operation: remote atomics act on it directly.
+  T *OwnerAddress() {
+    static_assert(sizeof(std::atomic<T>) == sizeof(T),
+                  "remote atomics require a lock-free std::atomic<T>");
+    T *address = ownerAddress_.load(std::memory_order_acquire);
+    if (address != nullptr) return address;
+
+    auto AddressFun = [](const ObjectID &oid, T **result) {
+      auto ptr = Atomic<T>::GetPtr(oid);
+      *result = reinterpret_cast<T *>(&ptr->localInstance_);
+    };
+    rt::executeAtWithRet(ownerLoc_, AddressFun, oid_, &address);
+    ownerAddress_.store(address, std::memory_order_release);
+    return address;
+  }
+
   ObjectID oid_;
   rt::Locality ownerLoc_;
   std::atomic<T> localInstance_;
+  std::atomic<T *> ownerAddress_{nullptr};
 };
 
 }  // namespace shad
@@ -28,6 +28,8 @@
 #include <algorithm>
 #include <array>
 #include <atomic>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "shad/data_structures/object_identifier.h"
@@ -52,6 +54,30 @@ constexpr static T const min(T const a, T const b) {
 
 namespace impl {
 
+template <typename DataStructure, typename EntryType, typename = void>
+struct HasBufferEntriesInsert : std::false_type {};
+
+template <typename DataStructure, typename EntryType>
+struct HasBufferEntriesInsert<
+    DataStructure, EntryType,
+    std::void_t<decltype(std::declval<DataStructure &>().BufferEntriesInsert(
+        std::declval<const EntryType *>(), size_t()))>> : std::true_type {};
+
+// Insert the entries of a flushed buffer.  Data structures providing
+// BufferEntriesInsert(const EntryType *, size_t) receive them all at once,
+// the others one by one through BufferEntryInsert.
+template <typename DataStructure, typename EntryType>
+void InsertBufferEntries(DataStructure *dsPtr, const EntryType *entries,
+                         size_t numEntries) {
+  if constexpr (HasBufferEntriesInsert<DataStructure, EntryType>::value) {
+    dsPtr->BufferEntriesInsert(entries, numEntries);
+  } else {
+    for (size_t i = 0; i < numEntries; i++) {
+      dsPtr->BufferEntryInsert(entries[i]);
+    }
+  }
+}
+
 /// @brief The Buffer utility.
 ///
 /// Buffer used to agregate data transfers in insertion methods.
@@ -100,9 +126,7 @@ class Buffer {
     FlushArgs args = {data_, size_, oid_};
     auto InsertBufferLambda = [](const FlushArgs& args) {
       auto dsPtr = DataStructure::GetPtr(args.oid);
-      for (size_t i = 0; i < args.numEntries; i++) {
-        dsPtr->BufferEntryInsert(args.data[i]);
-      }
+      InsertBufferEntries(dsPtr.get(), args.data.data(), args.numEntries);
     };
     rt::executeAt(tgtLoc_, InsertBufferLambda, args);
     size_ = 0;
@@ -113,9 +137,7 @@ class Buffer {
     FlushArgs args = {data_, size_, oid_};
     auto AsyncInsertLambda = [](rt::Handle&, const FlushArgs& args) {
       auto dsPtr = DataStructure::GetPtr(args.oid);
-      for (size_t i = 0; i < args.numEntries; i++) {
-        dsPtr->BufferEntryInsert(args.data[i]);
-      }
+      InsertBufferEntries(dsPtr.get(), args.data.data(), args.numEntries);
     };
     rt::asyncExecuteAt(handle, tgtLoc_, AsyncInsertLambda, args);
     size_ = 0;
@@ -36,6 +36,9 @@
 #include "shad/data_structures/compare_and_hash_utils.h"
 #include "shad/data_structures/local_hashmap.h"
 #include "shad/distributed_iterator_traits.h"
+#include "shad/runtime/affinity.h"
+#include "shad/runtime/all_to_all.h"
+#include "shad/runtime/collectives.h"
 #include "shad/runtime/runtime.h"
 
 namespace shad {
@@ -54,37 +57,38 @@ class map_iterator;
 /// (i.e. insertions overwrite previous values
 ///  associated to the same key, if any).
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE = MemCmp<KTYPE>,
-          typename INSERT_POLICY = Overwriter<VTYPE>>
+          typename INSERT_POLICY = Overwriter<VTYPE>,
+          template <typename, typename, typename, typename> class LOCAL_MAP =
+              LocalHashmap>
 class Hashmap : public AbstractDataStructure<
-                    Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>> {
+                    Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY,
+                            LOCAL_MAP>> {
   template <typename>
   friend class AbstractDataStructure;
-  friend class map_iterator<Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>,
+  friend class map_iterator<Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY,
+                                    LOCAL_MAP>,
                             const std::pair<KTYPE, VTYPE>,
                             std::pair<KTYPE, VTYPE>>;
-  friend class map_iterator<Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>,
+  friend class map_iterator<Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY,
+                                    LOCAL_MAP>,
                             const std::pair<KTYPE, VTYPE>,
                             std::pair<KTYPE, VTYPE>>;
 
  public:
   using value_type = std::pair<KTYPE, VTYPE>;
-  using HmapT = Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>;
-  using LMapT = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>;
+  using HmapT = Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY, LOCAL_MAP>;
+  using LMapT = LOCAL_MAP<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>;
   using ObjectID = typename AbstractDataStructure<HmapT>::ObjectID;
   using ShadHashmapPtr = typename AbstractDataStructure<HmapT>::SharedPtr;
 
   using iterator =
-      map_iterator<Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>,
+      map_iterator<Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY, LOCAL_MAP>,
                    const std::pair<KTYPE, VTYPE>, std::pair<KTYPE, VTYPE>>;
   using const_iterator =
-      map_iterator<Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>,
+      map_iterator<Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY, LOCAL_MAP>,
                    const std::pair<KTYPE, VTYPE>, std::pair<KTYPE, VTYPE>>;
-  using local_iterator =
-      lmap_iterator<LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>,
-                    const std::pair<KTYPE, VTYPE>>;
-  using const_local_iterator =
-      lmap_iterator<LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>,
-                    const std::pair<KTYPE, VTYPE>>;
+  using local_iterator = typename LMapT::iterator;
+  using const_local_iterator = typename LMapT::const_iterator;
   struct EntryT {
     EntryT(const KTYPE &k, const VTYPE &v) : key(k), value(v) {}
     EntryT() = default;
@@ -110,7 +114,7 @@ class Hashmap : public AbstractDataStructure<
   /// @brief Getter of the local hasmap.
   ///
   /// @return The pointer to the local hashmap instance.
-  LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY> * GetLocalHashmap() {
+  LMapT * GetLocalHashmap() {
     return & localMap_;
   };
 
@@ -129,6 +133,26 @@ class Hashmap : public AbstractDataStructure<
     return tgtLocality;
   }
 
+  /// @brief The locality owning each key, for loops whose iteration i
+  /// accesses the key KTYPE(i) (e.g., vertex identifiers).
+  ///
+  /// Typical usage:
+  /// @code
+  /// shad::rt::forEachOnAll(HashmapT::KeyAffinity(),
+  ///     [](const ObjectID &oid, size_t i) {
+  ///       auto mapPtr = HashmapT::GetPtr(oid);
+  ///       mapPtr->Lookup(i, &value);  // Local.
+  ///     },
+  ///     mapPtr->GetGlobalID(), numKeys);
+  /// @endcode
+  ///
+  /// @return The affinity of the keys built from the iterations.
+  static rt::IterationAffinity KeyAffinity() {
+    return rt::IterationAffinity::Owner([](size_t i) -> uint32_t {
+      return shad::hash<KTYPE>{}(static_cast<KTYPE>(i)) % rt::numLocalities();
+    });
+  }
+
   /// @brief Insert a key-value pair in the hashmap.
   /// @param[in] key the key.
   /// @param[in] value the value to copy into the hashmap.
@@ -207,6 +231,45 @@ class Hashmap : public AbstractDataStructure<
     rt::asyncExecuteOnAll(h, flushLambda_, oid_);
   }
 
+  /// @brief Inserter handed to the generator of BulkInsert().
+  class BulkInserter {
+    friend class Hashmap;
+
+   public:
+    /// @brief Insert a key-value pair in the hashmap.
+    /// @param[in] key The key.
+    /// @param[in] value The value.
+    void Insert(const KTYPE &key, const VTYPE &value) {
+      size_t targetId = shad::hash<KTYPE>{}(key) % rt::numLocalities();
+      buffers_.Insert(rt::Locality(targetId), EntryT(key, value));
+    }
+
+   private:
+    explicit BulkInserter(rt::AllToAllVBuffers<EntryT> &buffers)
+        : buffers_(buffers) {}
+
+    rt::AllToAllVBuffers<EntryT> &buffers_;
+  };
+
+  /// @brief Collective bulk insertion.
+  ///
+  /// The generator runs on every locality and inserts key-value pairs
+  /// through the BulkInserter it receives.  The pairs are then shipped to
+  /// the localities owning their keys with a single rt::allToAllV exchange.
+  /// The call returns when all the pairs have been inserted.
+  ///
+  /// @tparam GenFunT User-defined function type.  The function prototype
+  /// should be:
+  /// @code
+  /// void(const InArgsT &, BulkInserter &);
+  /// @endcode
+  /// @tparam InArgsT Type of the generator argument, must be memcopy-able.
+  ///
+  /// @param generator The function generating the local key-value pairs.
+  /// @param args The generator argument.
+  template <typename GenFunT, typename InArgsT>
+  void BulkInsert(GenFunT &&generator, const InArgsT &args);
+
   /// @brief Remove a key-value pair from the hashmap.
   /// @param[in] key the key.
   void Erase(const KTYPE &key);
@@ -228,9 +291,7 @@ class Hashmap : public AbstractDataStructure<
     rt::executeOnAll(clearLambda, oid_);
   }
 
-  using LookupResult = typename LocalHashmap<KTYPE, VTYPE,
-                                             KEY_COMPARE,
-                                             INSERT_POLICY>::LookupResult;
+  using LookupResult = typename LMapT::LookupResult;
 
   /// @brief Get the value associated to a key.
   /// @param[in] key the key.
@@ -423,6 +484,10 @@ class Hashmap : public AbstractDataStructure<
     localMap_.Insert(entry.key, entry.value);
   }
 
+  void BufferEntriesInsert(const EntryT *entries, size_t numEntries) {
+    localMap_.InsertBatch(entries, numEntries);
+  }
+
   iterator begin() { return iterator::map_begin(this); }
   iterator end() { return iterator::map_end(this); }
   const_iterator cbegin() const { return const_iterator::map_begin(this); }
@@ -458,7 +523,7 @@ class Hashmap : public AbstractDataStructure<
 
  private:
   ObjectID oid_;
-  LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY> localMap_;
+  LMapT localMap_;
   BuffersVector buffers_;
 
   struct InsertArgs {
@@ -480,6 +545,13 @@ class Hashmap : public AbstractDataStructure<
     KTYPE key;
   };
 
+  template <typename InArgsT>
+  struct BulkInsertArgs {
+    ObjectID oid;
+    void (*generator)(const InArgsT &, BulkInserter &);
+    InArgsT args;
+  };
+
  protected:
   Hashmap(ObjectID oid, const size_t numEntries)
       : oid_(oid),
@@ -491,37 +563,39 @@ class Hashmap : public AbstractDataStructure<
 };
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERT_POLICY>
-inline size_t Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::Size() const {
-  size_t size = localMap_.size_;
-  size_t remoteSize;
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
+inline size_t Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY,
+                      LOCAL_MAP>::Size() const {
+  size_t size;
   auto sizeLambda = [](const ObjectID &oid, size_t *res) {
     auto mapPtr = HmapT::GetPtr(oid);
     *res = mapPtr->localMap_.size_;
   };
-  for (auto tgtLoc : rt::allLocalities()) {
-    if (tgtLoc != rt::thisLocality()) {
-      rt::executeAtWithRet(tgtLoc, sizeLambda, oid_, &remoteSize);
-      size += remoteSize;
-    }
-  }
+  rt::reduce(sizeLambda, oid_, &size);
   return size;
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERT_POLICY>
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
 inline std::pair<
-    typename Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::iterator, bool>
-Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::Insert(const KTYPE &key,
-                                                          const VTYPE &value) {
+    typename Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY,
+                     LOCAL_MAP>::iterator, bool>
+Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY,
+        LOCAL_MAP>::Insert(const KTYPE &key,
+                           const VTYPE &value) {
   using itr_traits = distributed_iterator_traits<iterator>;
   size_t targetId = shad::hash<KTYPE>{}(key) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
   std::pair<iterator, bool> res;
 
   if (targetLocality == rt::thisLocality()) {
+    // Take begin() first: it completes any resize of the local map, which
+    // would invalidate the local iterator returned by Insert.
+    auto gbegin = begin(), gend = end();
     auto lres = localMap_.Insert(key, value);
-    res.first = itr_traits::iterator_from_local(begin(), end(), lres.first);
+    res.first = itr_traits::iterator_from_local(gbegin, gend, lres.first);
     res.second = lres.second;
   } else {
     auto insertLambda =
@@ -542,21 +616,25 @@ Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::Insert(const KTYPE &key,
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERT_POLICY>
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
 template <typename FUNTYPE>
 inline std::pair<
-    typename Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::iterator, bool>
-Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::Insert(FUNTYPE &insfun,
-                                                          const KTYPE &key,
-                                                          const VTYPE &value) {
+    typename Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY,
+                     LOCAL_MAP>::iterator, bool>
+Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY,
+        LOCAL_MAP>::Insert(FUNTYPE &insfun,
+                           const KTYPE &key,
+                           const VTYPE &value) {
   using itr_traits = distributed_iterator_traits<iterator>;
   size_t targetId = shad::hash<KTYPE>{}(key) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
   std::pair<iterator, bool> res;
 
   if (targetLocality == rt::thisLocality()) {
+    auto gbegin = begin(), gend = end();
     auto lres = localMap_.Insert(insfun, key, value);
-    res.first = itr_traits::iterator_from_local(begin(), end(), lres.first);
+    res.first = itr_traits::iterator_from_local(gbegin, gend, lres.first);
     res.second = lres.second;
   } else {
     auto insertLambda =
@@ -579,8 +657,10 @@ Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::Insert(FUNTYPE &insfun,
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERT_POLICY>
-inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::AsyncInsert(
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
+inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY,
+                    LOCAL_MAP>::AsyncInsert(
     rt::Handle &handle, const KTYPE &key, const VTYPE &value) {
   size_t targetId = shad::hash<KTYPE>{}(key) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
@@ -598,9 +678,11 @@ inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::AsyncInsert(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERT_POLICY>
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
 template <typename FUNTYPE>
-inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::AsyncInsert(
+inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY,
+                    LOCAL_MAP>::AsyncInsert(
     rt::Handle &handle, FUNTYPE &insfun,
     const KTYPE &key, const VTYPE &value) {
   size_t targetId = shad::hash<KTYPE>{}(key) % rt::numLocalities();
@@ -621,8 +703,10 @@ inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::AsyncInsert(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERT_POLICY>
-inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::BufferedInsert(
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
+inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY,
+                    LOCAL_MAP>::BufferedInsert(
     const KTYPE &key, const VTYPE &value) {
   size_t targetId = shad::hash<KTYPE>{}(key) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
@@ -630,19 +714,45 @@ inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::BufferedInsert(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERT_POLICY>
-inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE,
-                    INSERT_POLICY>::BufferedAsyncInsert(rt::Handle &handle,
-                                                        const KTYPE &key,
-                                                        const VTYPE &value) {
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
+inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY,
+                    LOCAL_MAP>::BufferedAsyncInsert(rt::Handle &handle,
+                                                    const KTYPE &key,
+                                                    const VTYPE &value) {
   size_t targetId = shad::hash<KTYPE>{}(key) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
   buffers_.AsyncInsert(handle, EntryT(key, value), targetLocality);
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERT_POLICY>
-inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::Erase(
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
+template <typename GenFunT, typename InArgsT>
+void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY, LOCAL_MAP>::BulkInsert(
+    GenFunT &&generator, const InArgsT &args) {
+  using GeneratorTy = void (*)(const InArgsT &, BulkInserter &);
+  GeneratorTy genFunPtr = std::forward<decltype(generator)>(generator);
+
+  auto packLambda = [](const BulkInsertArgs<InArgsT> &args,
+                       rt::AllToAllVBuffers<EntryT> &buffers) {
+    BulkInserter inserter(buffers);
+    args.generator(args.args, inserter);
+  };
+  auto receiveLambda = [](const BulkInsertArgs<InArgsT> &args,
+                          const rt::Locality &, const EntryT *entries,
+                          size_t count) {
+    auto mapPtr = HmapT::GetPtr(args.oid);
+    mapPtr->localMap_.InsertBatch(entries, count);
+  };
+  BulkInsertArgs<InArgsT> bulkArgs = {oid_, genFunPtr, args};
+  rt::allToAllV<EntryT>(packLambda, receiveLambda, bulkArgs);
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
+inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY, LOCAL_MAP>::Erase(
     const KTYPE &key) {
   size_t targetId = shad::hash<KTYPE>{}(key) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
@@ -660,8 +770,10 @@ inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::Erase(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERT_POLICY>
-inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::AsyncErase(
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
+inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY,
+                    LOCAL_MAP>::AsyncErase(
     rt::Handle &handle, const KTYPE &key) {
   size_t targetId = shad::hash<KTYPE>{}(key) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
@@ -679,8 +791,10 @@ inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::AsyncErase(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERT_POLICY>
-inline bool Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::Lookup(
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
+inline bool Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY,
+                    LOCAL_MAP>::Lookup(
     const KTYPE &key, VTYPE *res) {
   size_t targetId = shad::hash<KTYPE>{}(key) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
@@ -704,8 +818,10 @@ inline bool Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::Lookup(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERT_POLICY>
-inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::AsyncLookup(
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
+inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY,
+                    LOCAL_MAP>::AsyncLookup(
     rt::Handle &handle, const KTYPE &key, LookupResult *res) {
   size_t targetId = shad::hash<KTYPE>{}(key) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
@@ -726,31 +842,34 @@ inline void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::AsyncLookup(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERT_POLICY>
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
 template <typename ApplyFunT, typename... Args>
-void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::ForEachEntry(
+void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY, LOCAL_MAP>::ForEachEntry(
     ApplyFunT &&function, Args &... args) {
   using FunctionTy = void (*)(const KTYPE &, VTYPE &, Args &...);
   FunctionTy fn = std::forward<decltype(function)>(function);
   using feArgs = std::tuple<ObjectID, FunctionTy, std::tuple<Args...>>;
-  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE> *;
   using ArgsTuple = std::tuple<LMapT *, FunctionTy, std::tuple<Args...>>;
   feArgs arguments(oid_, fn, std::tuple<Args...>(args...));
   auto feLambda = [](const feArgs &args) {
     auto mapPtr = HmapT::GetPtr(std::get<0>(args));
     ArgsTuple argsTuple(&mapPtr->localMap_, std::get<1>(args),
                         std::get<2>(args));
-    rt::forEachAt(rt::thisLocality(),
-                  LMapT::template ForEachEntryFunWrapper<ArgsTuple, Args...>,
-                  argsTuple, mapPtr->localMap_.numBuckets_);
+    rt::forEachRangeAt(
+        rt::thisLocality(),
+        LMapT::template ForEachEntryFunWrapper<ArgsTuple, Args...>, argsTuple,
+        mapPtr->localMap_.numBuckets_);
   };
   rt::executeOnAll(feLambda, arguments);
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERT_POLICY>
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
 template <typename ApplyFunT, typename... Args>
-void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::AsyncForEachEntry(
+void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY,
+             LOCAL_MAP>::AsyncForEachEntry(
     rt::Handle &handle, ApplyFunT &&function, Args &... args) {
   using FunctionTy = void (*)(rt::Handle &, const KTYPE &, VTYPE &, Args &...);
   FunctionTy fn = std::forward<decltype(function)>(function);
@@ -770,9 +889,10 @@ void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::AsyncForEachEntry(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERT_POLICY>
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
 template <typename ApplyFunT, typename... Args>
-void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::ForEachKey(
+void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY, LOCAL_MAP>::ForEachKey(
     ApplyFunT &&function, Args &... args) {
   using FunctionTy = void (*)(const KTYPE &, Args &...);
   FunctionTy fn = std::forward<decltype(function)>(function);
@@ -783,17 +903,19 @@ void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::ForEachKey(
     auto mapPtr = HmapT::GetPtr(std::get<0>(args));
     ArgsTuple argsTuple(&mapPtr->localMap_, std::get<1>(args),
                         std::get<2>(args));
-    rt::forEachAt(rt::thisLocality(),
-                  LMapT::template ForEachKeyFunWrapper<ArgsTuple, Args...>,
-                  argsTuple, mapPtr->localMap_.numBuckets_);
+    rt::forEachRangeAt(rt::thisLocality(),
+                       LMapT::template ForEachKeyFunWrapper<ArgsTuple, Args...>,
+                       argsTuple, mapPtr->localMap_.numBuckets_);
   };
   rt::executeOnAll(feLambda, arguments);
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERT_POLICY>
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
 template <typename ApplyFunT, typename... Args>
-void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::AsyncForEachKey(
+void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY,
+             LOCAL_MAP>::AsyncForEachKey(
     rt::Handle &handle, ApplyFunT &&function, Args &... args) {
   using FunctionTy = void (*)(rt::Handle &, const KTYPE &, Args &...);
   FunctionTy fn = std::forward<decltype(function)>(function);
@@ -813,9 +935,10 @@ void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::AsyncForEachKey(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERT_POLICY>
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
 template <typename ApplyFunT, typename... Args>
-void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::Apply(
+void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY, LOCAL_MAP>::Apply(
     const KTYPE &key, ApplyFunT &&function, Args &... args) {
   size_t targetId = shad::hash<KTYPE>{}(key) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
@@ -840,9 +963,10 @@ void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::Apply(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERT_POLICY>
+          typename INSERT_POLICY,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
 template <typename ApplyFunT, typename... Args>
-void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::AsyncApply(
+void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY, LOCAL_MAP>::AsyncApply(
     rt::Handle &handle, const KTYPE &key, ApplyFunT &&function,
     Args &... args) {
   size_t targetId = shad::hash<KTYPE>{}(key) % rt::numLocalities();
@@ -871,11 +995,14 @@ void Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERT_POLICY>::AsyncApply(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
+          typename INSERTER,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
 template <typename ApplyFunT, typename... Args>
-typename Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::LMapT::ApplyResult
-Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::TryBlockingApply(const KTYPE &key,
-                                                               ApplyFunT &&function, Args &... args) {
+typename Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER,
+                 LOCAL_MAP>::LMapT::ApplyResult
+Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER,
+        LOCAL_MAP>::TryBlockingApply(const KTYPE &key,
+                                     ApplyFunT &&function, Args &... args) {
   size_t targetId = shad::hash<KTYPE>{}(key) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
   if (targetLocality == rt::thisLocality()) {
@@ -901,14 +1028,17 @@ Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::TryBlockingApply(const KTYPE &key,
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
+          typename INSERTER,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
 template <typename ApplyFunT, typename... Args>
-typename Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::LMapT::ApplyResult
-Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::TryBlockingApplyWithRetBuff(const KTYPE &key,
-                                                                          ApplyFunT &&function,
-                                                                          uint8_t* resultBuffer,
-                                                                          uint32_t* resultSize,
-                                                                          Args &... args) {
+typename Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER,
+                 LOCAL_MAP>::LMapT::ApplyResult
+Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER,
+        LOCAL_MAP>::TryBlockingApplyWithRetBuff(const KTYPE &key,
+                                                ApplyFunT &&function,
+                                                uint8_t* resultBuffer,
+                                                uint32_t* resultSize,
+                                                Args &... args) {
   size_t targetId = shad::hash<KTYPE>{}(key) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
   if (targetLocality == rt::thisLocality()) {
@@ -945,10 +1075,12 @@ Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::TryBlockingApplyWithRetBuff(const
 
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
+          typename INSERTER,
+          template <typename, typename, typename, typename> class LOCAL_MAP>
 template <typename ApplyFunT, typename RetT, typename... Args>
-typename Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::LMapT::ApplyResult
-Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::
+typename Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER,
+                 LOCAL_MAP>::LMapT::ApplyResult
+Hashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LOCAL_MAP>::
 TryBlockingApplyWithRet(const KTYPE &key, ApplyFunT &&function,
                         RetT* resultPtr, Args &... args) {
   size_t targetId = shad::hash<KTYPE>{}(key) % rt::numLocalities();
@@ -982,7 +1114,7 @@ class map_iterator : public std::iterator<std::forward_iterator_tag, T> {
  public:
   using OIDT = typename MapT::ObjectID;
   using LMap = typename MapT::LMapT;
-  using local_iterator_type = lmap_iterator<LMap, T>;
+  using local_iterator_type = typename LMap::iterator;
   using value_type = NonConstT;
 
   map_iterator() {}
@@ -1122,7 +1254,7 @@ class map_iterator : public std::iterator<std::forward_iterator_tag, T> {
 
  private:
   struct itData {
-    itData() : oid_(0), lmapIt_(nullptr, 0, 0, nullptr, nullptr) {}
+    itData() : oid_(0), lmapIt_(local_iterator_type::lmap_end(size_t(0))) {}
     itData(uint32_t locId, OIDT oid, local_iterator_type lmapIt, T element)
         : locId_(locId), oid_(oid), lmapIt_(lmapIt), element_(element) {}
     bool operator==(const itData &other) const {
@@ -0,0 +1,1411 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_DATA_STRUCTURES_LOCAL_FLAT_HASHMAP_H_
+#define INCLUDE_SHAD_DATA_STRUCTURES_LOCAL_FLAT_HASHMAP_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "shad/data_structures/compare_and_hash_utils.h"
+#include "shad/data_structures/local_hashmap.h"
+#include "shad/runtime/runtime.h"
+
+namespace shad {
+
+template <typename LMap, typename T>
+class lflatmap_iterator;
+
+namespace impl {
+
+/// @brief The control bytes of a group of slots of an open-addressing table.
+///
+/// A control byte is kEmpty, kDeleted, kPending (an insertion is in
+/// progress), or the 7 low bits of the hash of the key stored in the slot.
+/// A group is as wide as an SSE2 register, so that its slots are matched
+/// against a control byte with a single compare.
+struct alignas(16) FlatGroup {
+  static constexpr size_t kSize = 16;
+  static constexpr uint8_t kEmpty = 0x80;
+  static constexpr uint8_t kDeleted = 0xFE;
+  static constexpr uint8_t kPending = 0xFF;
+
+  uint8_t ctrl[kSize];
+
+  static bool IsFull(uint8_t byte) { return (byte & 0x80) == 0; }
+
+  /// @brief The mask of the slots whose control byte is byte.
+  uint32_t Match(uint8_t byte) const {
+#if defined(__SSE2__)
+    __m128i group = _mm_load_si128(reinterpret_cast<const __m128i *>(ctrl));
+    __m128i pattern = _mm_set1_epi8(static_cast<char>(byte));
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(group, pattern)));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kSize; ++i)
+      mask |= static_cast<uint32_t>(
+                  __atomic_load_n(&ctrl[i], __ATOMIC_RELAXED) == byte)
+              << i;
+    return mask;
+#endif
+  }
+};
+
+/// @brief A key-value slot of an open-addressing table.
+template <typename KTYPE, typename VTYPE, bool = std::is_empty<VTYPE>::value>
+struct FlatSlot {
+  KTYPE key;
+  VTYPE value;
+  VTYPE &Value() { return value; }
+};
+
+// Values of empty types (e.g., the values of a LocalFlatSet) take no space.
+template <typename KTYPE, typename VTYPE>
+struct FlatSlot<KTYPE, VTYPE, true> : VTYPE {
+  KTYPE key;
+  VTYPE &Value() { return *this; }
+};
+
+}  // namespace impl
+
+/// @brief The LocalFlatHashmap data structure.
+///
+/// SHAD's LocalFlatHashmap is a "local", thread-safe, associative container
+/// with the same interface of LocalHashmap.  Entries are stored in an
+/// open-addressing table: a one-byte control array per group of 16 slots
+/// lets lookups probe a whole group with a single SIMD compare and touch the
+/// slots only on a hash match, instead of walking chained buckets entry by
+/// entry.  When a table fills up, inserts continue in an overflow table
+/// twice as large, so no entry is ever moved.  The slots freed by Erase are
+/// reused by the following inserts, so that a map whose size stays constant
+/// does not grow under insert/erase churn.
+///
+/// LocalFlatHashmaps can be used ONLY on the Locality on which they are
+/// created.  They are picked as the storage of a Hashmap through its
+/// LOCAL_MAP template parameter:
+/// @code
+/// using MapT = shad::Hashmap<uint64_t, uint64_t, shad::MemCmp<uint64_t>,
+///                            shad::Overwriter<uint64_t>,
+///                            shad::LocalFlatHashmap>;
+/// @endcode
+///
+/// @tparam KTYPE type of the hashmap keys.
+/// @tparam VTYPE type of the hashmap values.
+/// @tparam KEY_COMPARE key comparison function; default is MemCmp<KTYPE>.
+/// @tparam INSERTER default is Overwriter
+/// (i.e. insertions overwrite previous values
+///  associated to the same key, if any).
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE = MemCmp<KTYPE>,
+          typename INSERTER = Overwriter<VTYPE>>
+class LocalFlatHashmap {
+  template <typename, typename, typename, typename,
+            template <typename, typename, typename, typename> class>
+  friend class Hashmap;
+  template <typename, typename>
+  friend class LocalFlatSet;
+  friend class lflatmap_iterator<
+      LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>,
+      const std::pair<KTYPE, VTYPE>>;
+  template <typename, typename, typename>
+  friend class map_iterator;
+
+ public:
+  using value_type = std::pair<KTYPE, VTYPE>;
+  using iterator =
+      lflatmap_iterator<LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>,
+                        const std::pair<KTYPE, VTYPE>>;
+  using const_iterator =
+      lflatmap_iterator<LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>,
+                        const std::pair<KTYPE, VTYPE>>;
+
+  /// @brief Constructor.
+  /// @param numInitBuckets initial number of Buckets, as for LocalHashmap
+  /// (i.e., the table is sized for numInitBuckets *
+  /// constants::kDefaultNumEntriesPerBucket entries).
+  explicit LocalFlatHashmap(const size_t numInitBuckets)
+      : numBuckets_(NumGroups(numInitBuckets *
+                              constants::kDefaultNumEntriesPerBucket)),
+        root_(nullptr),
+        isRootAllocated_(false),
+        size_(0) {}
+
+  LocalFlatHashmap(const LocalFlatHashmap &) = delete;
+  LocalFlatHashmap &operator=(const LocalFlatHashmap &) = delete;
+
+  ~LocalFlatHashmap() { delete root_.load(); }
+
+  /// @brief Size of the hashmap (number of entries).
+  /// @return the size of the hashmap.
+  size_t Size() const { return size_.load(); }
+
+  /// @brief Memory used by the hashmap, in bytes.
+  ///
+  /// Counts the hashmap and its tables of control bytes, locks and slots.
+  /// Memory owned by the keys and values themselves and the overhead of the
+  /// allocator are not counted.
+  ///
+  /// @return the number of bytes used by the hashmap.
+  size_t MemoryFootprint() const {
+    size_t bytes = sizeof(*this);
+    for (Table *table = root_.load(); table != nullptr;
+         table = table->next.load())
+      bytes += sizeof(Table) + table->numGroups * sizeof(Group) +
+               table->numGroups * kGroupSize * (1 + sizeof(Slot));
+    return bytes;
+  }
+
+  /// @brief Insert a key-value pair in the hashmap.
+  /// @param[in] key the key.
+  /// @param[in] value the value to copy into the hashMap.
+  /// @return an iterator to the inserted value and true if value was inserted.
+  std::pair<iterator, bool> Insert(const KTYPE &key, const VTYPE &value) {
+    return Insert(InsertPolicy_, key, value);
+  }
+
+  /// @brief Insert a key-value pair in the hashmap,
+  /// with a custom inserter.
+  /// @param[in] insfun inserter function or functor.
+  /// Look at the default inserter for an example.
+  /// @param[in] key the key.
+  /// @param[in] value the value to copy into the hashMap.
+  /// @return an iterator to the inserted value and true if value was inserted.
+  template <typename FUNTYPE>
+  std::pair<iterator, bool> Insert(FUNTYPE &insfun, const KTYPE &key,
+                                   const VTYPE &value) {
+    return InsertImpl(key, Hash(key), [&](VTYPE *lhs, bool sameKey) {
+      return insfun(lhs, value, sameKey);
+    });
+  }
+
+  template <typename ELTYPE>
+  std::pair<iterator, bool> Insert(const KTYPE &key, const ELTYPE &value) {
+    return InsertImpl(key, Hash(key), [&](VTYPE *lhs, bool sameKey) {
+      return INSERTER::Insert(lhs, value, sameKey);
+    });
+  }
+
+  /// @brief Asynchronously Insert a key-value pair in the hashmap.
+  /// @warning Asynchronous operations are guaranteed to have completed
+  /// only after calling the rt::waitForCompletion(rt::Handle &handle) method.
+  /// @param[in,out] handle Reference to the handle
+  /// to be used to wait for completion.
+  /// @param[in] key the key.
+  /// @param[in] value the value to copy into the hashMap.
+  void AsyncInsert(rt::Handle &handle, const KTYPE &key, const VTYPE &value) {
+    AsyncInsert(handle, InsertPolicy_, key, value);
+  }
+
+  /// @brief Asynchronously Insert a key-value pair in the hashmap,
+  /// with a custom inserter.
+  /// @warning Asynchronous operations are guaranteed to have completed
+  /// only after calling the rt::waitForCompletion(rt::Handle &handle) method.
+  /// @param[in,out] handle Reference to the handle
+  /// to be used to wait for completion.
+  /// @param[in] insfun inserter function or functor.
+  /// Look at the default inserter for an example.
+  /// @param[in] key the key.
+  /// @param[in] value the value to copy into the hashMap.
+  template <typename FUNTYPE>
+  void AsyncInsert(rt::Handle &handle, FUNTYPE &insfun, const KTYPE &key,
+                   const VTYPE &value) {
+    InsertImpl(key, Hash(key), [&](VTYPE *lhs, bool sameKey) {
+      return insfun(handle, lhs, value, sameKey);
+    });
+  }
+
+  template <typename ELTYPE>
+  void AsyncInsert(rt::Handle &handle, const KTYPE &key, const ELTYPE &value);
+
+  /// @brief Remove a key-value pair from the hashmap.
+  /// @param[in] key the key.
+  void Erase(const KTYPE &key);
+
+  /// @brief Asynchronously remove a key-value pair from the hashmap.
+  /// @warning Asynchronous operations are guaranteed to have completed.
+  /// only after calling the rt::waitForCompletion(rt::Handle &handle) method.
+  /// @param[in,out] handle Reference to the handle.
+  /// to be used to wait for completion.
+  /// @param[in] key the key.
+  void AsyncErase(rt::Handle &handle, const KTYPE &key);
+
+  /// @brief Clear the content of the hashmap.
+  void Clear() {
+    size_ = 0;
+    delete root_.exchange(nullptr);
+    isRootAllocated_ = false;
+  }
+
+  /// @brief Get the value associated to a key.
+  /// @param[in] key the key.
+  /// @param[out] res the address where to store the value,
+  /// if the the key-value is found.
+  /// @return true if the entry is found, false otherwise.
+  bool Lookup(const KTYPE &key, VTYPE *res) {
+    return LookupHash(key, Hash(key), res);
+  }
+
+  /// @brief Get the value associated to a key.
+  /// @param[in] key the key.
+  /// @return a pointer to the value if the the key-value is found
+  ///         and nullptr if it does not exists.
+  VTYPE *Lookup(const KTYPE &key);
+
+  /// @brief Asynchronously get the value associated to a key.
+  /// @warning Asynchronous operations are guaranteed to have completed
+  /// only after calling the rt::waitForCompletion(rt::Handle &handle) method.
+  /// @param[in,out] handle Reference to the handle
+  /// to be used to wait for completion.
+  /// @param[in] key the key.
+  /// @param[out] res the address where to storethe pointer to the value
+  ///                 if the the key-value was found,
+  ///                 or a nullptr otherwise.
+  void AsyncLookup(rt::Handle &handle, const KTYPE &key, VTYPE **res);
+
+  /// @brief Result for the
+  /// Lookup(const KTYPE&, LookupResult*) and
+  /// AsyncLookup(rt::Handle&, const KTYPE&, LookupResult*) methods.
+  struct LookupResult {
+    /// True if the key has been found in the Hashmap
+    bool found;
+    /// The value associated with the key.
+    VTYPE value;
+  };
+
+  /// @brief Lookup method.
+  /// @param[in] key The key.
+  /// @param[out] res The result of the lookup operation.
+  void Lookup(const KTYPE &key, LookupResult *res) {
+    res->found = LookupHash(key, Hash(key), &res->value);
+  }
+
+  /// @brief Asynchronous lookup method.
+  ///
+  /// @warning Asynchronous operations are guaranteed to have completed.  only
+  /// after calling the rt::waitForCompletion(rt::Handle &handle) method.
+  ///
+  /// @param[in,out] handle Reference to the handle.  to be used to wait for
+  /// completion.
+  /// @param[in] key The key.
+  /// @param[out] res The result of the lookup operation.
+  void AsyncLookup(rt::Handle &handle, const KTYPE &key, LookupResult *res);
+
+  /// @brief Apply a user-defined function to a key-value pair.
+  ///
+  /// @tparam ApplyFunT User-defined function type.  The function prototype
+  /// should be:
+  /// @code
+  /// void(const KTYPE&, VTYPE&, Args&);
+  /// @endcode
+  /// @tparam ...Args Types of the function arguments.
+  ///
+  /// @param[in] key The key.
+  /// @param function The function to apply.
+  /// @param args The function arguments.
+  template <typename ApplyFunT, typename... Args>
+  void Apply(const KTYPE &key, ApplyFunT &&function, Args &... args) {
+    VTYPE *value = Lookup(key);
+    if (value != nullptr) {
+      function(key, *value, args...);
+    }
+  }
+
+  /// @brief Get the values associated to a batch of keys.
+  ///
+  /// Equivalent to calling Lookup(keys[i], &out[i]) for every key, but the
+  /// groups probed by the following keys are prefetched while a key is
+  /// looked up.
+  ///
+  /// @param[in] keys The n keys.
+  /// @param[in] n The number of keys.
+  /// @param[out] out The values of the keys that are found.
+  /// @param[out] found Whether each key is found.
+  void LookupBatch(const KTYPE *keys, size_t n, VTYPE *out, bool *found) {
+    impl::BatchPipeline(
+        n,
+        [&](size_t first, size_t count, uint64_t *out) {
+          HashBatch(keys + first, count, out);
+        },
+        [&](size_t hash) { PrefetchGroup(hash); },
+        [&](size_t hash) { PrefetchSlots(hash); },
+        [&](size_t i, size_t hash) {
+          found[i] = LookupHash(keys[i], hash, &out[i]);
+        });
+  }
+
+  /// @brief Insert a batch of key-value pairs, prefetching the groups
+  /// probed by the following keys while a key is inserted.
+  ///
+  /// @param[in] keys The n keys.
+  /// @param[in] values The n values to copy into the hashmap.
+  /// @param[in] n The number of key-value pairs.
+  void InsertBatch(const KTYPE *keys, const VTYPE *values, size_t n) {
+    InsertInBatch(
+        n,
+        [&](size_t first, size_t count, uint64_t *out) {
+          HashBatch(keys + first, count, out);
+        },
+        [&](size_t i) -> const KTYPE & { return keys[i]; },
+        [&](size_t i) -> const VTYPE & { return values[i]; });
+  }
+
+  /// @brief Insert a batch of key-value pairs stored together.
+  ///
+  /// @tparam EntryT Type of the pairs, with key and value members (e.g.,
+  /// the entries of the Hashmap buffers).
+  ///
+  /// @param[in] entries The n key-value pairs.
+  /// @param[in] n The number of key-value pairs.
+  template <typename EntryT>
+  void InsertBatch(const EntryT *entries, size_t n) {
+    InsertInBatch(
+        n,
+        [&](size_t first, size_t count, uint64_t *out) {
+          for (size_t i = 0; i < count; ++i)
+            out[i] = Hash(entries[first + i].key);
+        },
+        [&](size_t i) -> const KTYPE & { return entries[i].key; },
+        [&](size_t i) -> const VTYPE & { return entries[i].value; });
+  }
+
+  /// @brief Apply a user-defined function to the key-value pairs of a batch
+  /// of keys, prefetching the groups probed by the following keys.
+  ///
+  /// @tparam ApplyFunT User-defined function type.  The function prototype
+  /// should be:
+  /// @code
+  /// void(const KTYPE&, VTYPE&, Args&);
+  /// @endcode
+  /// @tparam ...Args Types of the function arguments.
+  ///
+  /// @param[in] keys The n keys.
+  /// @param[in] n The number of keys.
+  /// @param function The function to apply to the keys that are found.
+  /// @param args The function arguments.
+  template <typename ApplyFunT, typename... Args>
+  void ApplyBatch(const KTYPE *keys, size_t n, ApplyFunT &&function,
+                  Args &... args) {
+    impl::BatchPipeline(
+        n,
+        [&](size_t first, size_t count, uint64_t *out) {
+          HashBatch(keys + first, count, out);
+        },
+        [&](size_t hash) { PrefetchGroup(hash); },
+        [&](size_t hash) { PrefetchSlots(hash); },
+        [&](size_t i, size_t hash) {
+          VTYPE *value = LookupHash(keys[i], hash);
+          if (value != nullptr) function(keys[i], *value, args...);
+        });
+  }
+
+  /// @brief Asynchronously apply a user-defined function to a key-value pair.
+  ///
+  /// @tparam ApplyFunT User-defined function type.  The function prototype
+  /// should be:
+  /// @code
+  /// void(rt::Handle &handle, const KTYPE&, VTYPE&, Args&);
+  /// @endcode
+  /// @tparam ...Args Types of the function arguments.
+  ///
+  /// @param[in,out] handle Reference to the handle.
+  /// @param[in] key The key.
+  /// @param function The function to apply.
+  /// @param args The function arguments.
+  template <typename ApplyFunT, typename... Args>
+  void AsyncApply(rt::Handle &handle, const KTYPE &key, ApplyFunT &&function,
+                  Args &... args);
+
+  enum ApplyResult { FAILED, SUCCESS, NOT_FOUND };
+
+  /// @brief Tries to apply a user-defined function to an entry's value.
+  /// Thread safe wrt other operations.
+  /// @tparam ApplyFunT User-defined function type. The function prototype
+  /// should be:
+  /// @code
+  /// void(const KTYPE&, VTYPE&, Args&);
+  /// @endcode
+  /// @tparam ...Args Types of the function arguments.
+  ///
+  /// @param[in] key The key.
+  /// @param function The function to apply.
+  /// @param args The function arguments.
+  /// @return SUCCESS if the function has been successfully applied,
+  /// NOT_FOUND if the key is not found, FAILED otherwise.
+  template <typename ApplyFunT, typename... Args>
+  ApplyResult TryBlockingApply(const KTYPE &key, ApplyFunT &&function,
+                               Args &... args) {
+    return TryLocked(key, [&](VTYPE &value) { function(key, value, args...); });
+  }
+
+  /// @brief Tries to apply a user-defined function to an entry's value.
+  /// Thread safe wrt other operations.
+  /// @tparam ApplyFunT User-defined function type. The function prototype
+  /// should be:
+  /// @code
+  /// void(const KTYPE&, VTYPE&, uint8_t*, size_t*, Args&);
+  /// @endcode
+  /// @tparam ...Args Types of the function arguments.
+  ///
+  /// @param[in] key The key.
+  /// @param function The function to apply.
+  /// @param[out] ResultBuffer Pointer to the result buffer.
+  /// @param[out] ResultSize Size (in bytes) of data written in the buffer.
+  /// @param args The function arguments.
+  /// @return SUCCESS if the function has been successfully applied,
+  /// NOT_FOUND if the key is not found, FAILED otherwise.
+  template <typename ApplyFunT, typename... Args>
+  ApplyResult TryBlockingApplyWithRetBuff(const KTYPE &key,
+                                          ApplyFunT &&function,
+                                          uint8_t *resultBuffer,
+                                          uint32_t *resultSize,
+                                          Args &... args) {
+    return TryLocked(key, [&](VTYPE &value) {
+      function(key, value, resultBuffer, resultSize, args...);
+    });
+  }
+
+  /// @brief Tries to apply a user-defined function to an entry's value.
+  /// Thread safe wrt other operations.
+  /// @tparam ApplyFunT User-defined function type. The function prototype
+  /// should be:
+  /// @code
+  /// void(const KTYPE&, VTYPE&, RetT*, Args&);
+  /// @endcode
+  /// @tparam RetT Return Data Type
+  /// @tparam ...Args Types of the function arguments.
+  ///
+  /// @param[in] key The key.
+  /// @param function The function to apply.
+  /// @param[out] retPtr Pointer to the result.
+  /// @param args The function arguments.
+  /// @return SUCCESS if the function has been successfully applied,
+  /// NOT_FOUND if the key is not found, FAILED otherwise.
+  template <typename ApplyFunT, typename RetT, typename... Args>
+  ApplyResult TryBlockingApplyWithRet(const KTYPE &key, ApplyFunT &&function,
+                                      RetT *retPtr, Args &... args) {
+    return TryLocked(key, [&](VTYPE &value) {
+      function(key, value, retPtr, args...);
+    });
+  }
+
+  /// @brief Apply a user-defined function to each key-value pair.
+  ///
+  /// @tparam ApplyFunT User-defined function type.  The function prototype
+  /// should be:
+  /// @code
+  /// void(const KTYPE&, VTYPE&, Args&);
+  /// @endcode
+  /// @tparam ...Args Types of the function arguments.
+  ///
+  /// @param function The function to apply.
+  /// @param args The function arguments.
+  template <typename ApplyFunT, typename... Args>
+  void ForEachEntry(ApplyFunT &&function, Args &... args);
+
+  /// @brief Asynchronously apply a user-defined function to each key-value
+  /// pair.
+  ///
+  /// @tparam ApplyFunT User-defined function type.  The function prototype
+  /// should be:
+  /// @code
+  /// void(shad::rt::Handle&, const KTYPE&, VTYPE&, Args&);
+  /// @endcode
+  /// @tparam ...Args Types of the function arguments.
+  ///
+  /// @warning Asynchronous operations are guaranteed to have completed.  only
+  /// after calling the rt::waitForCompletion(rt::Handle &handle) method.
+  ///
+  /// @param[in,out] handle Reference to the handle.  to be used to wait for
+  /// completion.
+  /// @param function The function to apply.
+  /// @param args The function arguments.
+  template <typename ApplyFunT, typename... Args>
+  void AsyncForEachEntry(rt::Handle &handle, ApplyFunT &&function,
+                         Args &... args);
+
+  /// @brief Apply a user-defined function to each key.
+  /// @tparam ApplyFunT User-defined function type.
+  /// The function prototype should be:
+  /// @code
+  /// void(const KTYPE&, Args&);
+  /// @endcode
+  /// @tparam ...Args Types of the function arguments.
+  /// @param function The function to apply.
+  /// @param args The function arguments.
+  template <typename ApplyFunT, typename... Args>
+  void ForEachKey(ApplyFunT &&function, Args &... args);
+
+  /// @brief Asynchronously apply a user-defined function to each key.
+  /// @tparam ApplyFunT User-defined function type.
+  /// The function prototype should be:
+  /// @code
+  /// void(shad::rt::Handle&, const KTYPE&, Args&);
+  /// @endcode
+  /// @tparam ...Args Types of the function arguments.
+  /// @warning Asynchronous operations are guaranteed to have completed.
+  /// only after calling the rt::waitForCompletion(rt::Handle &handle) method.
+  /// @param[in,out] handle Reference to the handle.
+  /// to be used to wait for completion.
+  /// @param function The function to apply.
+  /// @param args The function arguments.
+  template <typename ApplyFunT, typename... Args>
+  void AsyncForEachKey(rt::Handle &handle, ApplyFunT &&function,
+                       Args &... args);
+
+  /// @brief Print all the entries in the hashmap.
+  /// @warning std::ostream & operator<< must be defined for both
+  /// KTYPE and VTYPE
+  void PrintAllEntries();
+
+  iterator begin() { return iterator::lmap_begin(this); }
+  iterator end() { return iterator::lmap_end(numBuckets_); }
+  const_iterator cbegin() { return const_iterator::lmap_begin(this); }
+  const_iterator cend() { return const_iterator::lmap_end(numBuckets_); }
+
+ private:
+  using Group = impl::FlatGroup;
+  static constexpr size_t kGroupSize = Group::kSize;
+
+  typedef KEY_COMPARE KeyCompare;
+
+  using Slot = impl::FlatSlot<KTYPE, VTYPE>;
+
+  // An open-addressing table of numGroups * kGroupSize slots.  Inserts stop
+  // claiming empty slots once the table is sealed, which happens when 7/8 of
+  // the slots have been claimed, and continue in the next table.  Deleted
+  // slots are reused in any table.
+  struct Table {
+    explicit Table(size_t groups)
+        : numGroups(groups),
+          maxClaims(groups * kGroupSize * 7 / 8),
+          claims(0),
+          sealed(false),
+          groups(new Group[groups]),
+          locks(new uint8_t[groups * kGroupSize]),
+          slots(new Slot[groups * kGroupSize]),
+          next(nullptr),
+          isNextAllocated(false) {
+      auto &numa = rt::impl::NumaTopology::Instance();
+      numa.Place(this->groups, numGroups * sizeof(Group));
+      numa.Place(locks, numGroups * kGroupSize);
+      numa.Place(slots, numGroups * kGroupSize * sizeof(Slot));
+      for (size_t g = 0; g < numGroups; ++g)
+        std::memset(this->groups[g].ctrl, Group::kEmpty, kGroupSize);
+      std::memset(locks, 0, numGroups * kGroupSize);
+    }
+
+    ~Table() {
+      delete next.load();
+      delete[] slots;
+      delete[] locks;
+      delete[] groups;
+    }
+
+    uint8_t *Ctrl(size_t slot) {
+      return &groups[slot / kGroupSize].ctrl[slot % kGroupSize];
+    }
+
+    uint8_t LoadCtrl(size_t slot) {
+      return __atomic_load_n(Ctrl(slot), __ATOMIC_ACQUIRE);
+    }
+
+    void Lock(size_t slot) {
+      while (!__sync_bool_compare_and_swap(&locks[slot], 0, 1))
+        rt::impl::yield();
+    }
+
+    bool TryLock(size_t slot) {
+      return __sync_bool_compare_and_swap(&locks[slot], 0, 1);
+    }
+
+    void Unlock(size_t slot) {
+      __atomic_store_n(&locks[slot], 0, __ATOMIC_RELEASE);
+    }
+
+    size_t numGroups;
+    size_t maxClaims;
+    std::atomic<size_t> claims;
+    std::atomic<bool> sealed;
+    Group *groups;
+    uint8_t *locks;
+    Slot *slots;
+    std::atomic<Table *> next;
+    bool isNextAllocated;
+  };
+
+  // The table and slot holding a key, if table is not nullptr.  The lock of
+  // the slot is held by whoever found it.
+  struct Position {
+    Table *table;
+    size_t slot;
+  };
+
+  // Inserts of new keys hold the lock of their key, so that two inserts of
+  // the same key never claim two slots.
+  static constexpr size_t kNumInsertLocks = 1024;
+
+  INSERTER InsertPolicy_;
+  KeyCompare KeyComp_;
+  // Number of groups of the first table.  Each following table is twice as
+  // large as the previous one, so that the i-th "bucket" of the iterations
+  // is made of the i-th group of the first table, of the groups 2i and
+  // 2i + 1 of the second one, and so on.
+  size_t numBuckets_;
+  std::atomic<Table *> root_;
+  bool isRootAllocated_;
+  std::atomic<size_t> size_;
+  uint8_t insertLocks_[kNumInsertLocks] = {};
+
+  // The number of groups (a power of 2) keeping numEntries under the
+  // maximum load factor.
+  static size_t NumGroups(size_t numEntries) {
+    size_t numGroups = 1;
+    while (numGroups * kGroupSize * 7 / 8 < numEntries) numGroups <<= 1;
+    return numGroups;
+  }
+
+  // std::hash is the identity on integers: spread the bits before splitting
+  // the hash in the index of the first group to probe (high bits) and the
+  // control byte (low 7 bits).
+  static uint64_t Mix(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+  }
+
+  static size_t Hash(const KTYPE &key) { return Mix(shad::hash<KTYPE>{}(key)); }
+
+  // Hash(keys[i]) for the n keys of a batch.
+  static void HashBatch(const KTYPE *keys, size_t n, uint64_t *out) {
+    HashMany(keys, n, out);
+    for (size_t i = 0; i < n; ++i) out[i] = Mix(out[i]);
+  }
+
+  static uint8_t H2(size_t hash) { return hash & 0x7F; }
+
+  uint8_t *InsertLock(size_t hash) {
+    return &insertLocks_[(hash >> 7) % kNumInsertLocks];
+  }
+
+  // Whether the slot holds key, with the lock of the slot held.
+  bool HoldsKey(Table *table, size_t slot, const KTYPE &key, uint8_t h2) {
+    return table->LoadCtrl(slot) == h2 &&
+           KeyComp_(&table->slots[slot].key, &key) == 0;
+  }
+
+  // Claim the first slot free for key in the probe sequence of table: a
+  // deleted slot, or an empty one if the table is not sealed.  Returns false
+  // if there is none.
+  bool ClaimSlot(Table *table, size_t hash, size_t *slotPtr);
+
+  static Table *Allocate(std::atomic<Table *> &table, bool *isAllocated,
+                         size_t numGroups) {
+    Table *result = table.load();
+    if (result != nullptr) return result;
+    if (__sync_bool_compare_and_swap(isAllocated, false, true)) {
+      result = new Table(numGroups);
+      table.store(result);
+      return result;
+    }
+    // Wait for the allocation to happen
+    while ((result = table.load()) == nullptr) rt::impl::yield();
+    return result;
+  }
+
+  static Table *NextTable(Table *table) {
+    return Allocate(table->next, &table->isNextAllocated,
+                    2 * table->numGroups);
+  }
+
+  // The bucket of the iterations holding a slot of a table.
+  size_t BucketOf(const Table *table, size_t slot) const {
+    return slot / kGroupSize / (table->numGroups / numBuckets_);
+  }
+
+  // Find key, holding the lock of its slot on return.  Erased slots are
+  // reused by the inserts of other keys, which rewrite the key and the value
+  // under the lock of the slot: keys are compared, and values read, only
+  // under it.  With busy, the lock is only tried: *busy is set and nothing
+  // is found if it is held.
+  Position Find(const KTYPE &key, size_t hash, bool *busy = nullptr);
+
+  template <typename InsertFunT>
+  std::pair<iterator, bool> InsertImpl(const KTYPE &key, size_t hash,
+                                       InsertFunT &&insert);
+
+  VTYPE *LookupHash(const KTYPE &key, size_t hash) {
+    Position pos = Find(key, hash);
+    if (pos.table == nullptr) return nullptr;
+    pos.table->Unlock(pos.slot);
+    return &pos.table->slots[pos.slot].Value();
+  }
+
+  // Copy the value of key, under the lock of its slot.
+  bool LookupHash(const KTYPE &key, size_t hash, VTYPE *res) {
+    Position pos = Find(key, hash);
+    if (pos.table == nullptr) return false;
+    *res = pos.table->slots[pos.slot].Value();
+    pos.table->Unlock(pos.slot);
+    return true;
+  }
+
+  // Prefetch the control bytes of the first group probed by a hash.
+  void PrefetchGroup(size_t hash) {
+    Table *table = root_.load();
+    if (table != nullptr)
+      __builtin_prefetch(&table->groups[(hash >> 7) & (table->numGroups - 1)]);
+  }
+
+  // Prefetch the first slots of the first group probed by a hash.
+  void PrefetchSlots(size_t hash) {
+    Table *table = root_.load();
+    if (table != nullptr) {
+      size_t g = (hash >> 7) & (table->numGroups - 1);
+      __builtin_prefetch(&table->slots[g * kGroupSize]);
+    }
+  }
+
+  template <typename HashManyFunT, typename KeyAtT, typename ValueAtT>
+  void InsertInBatch(size_t n, HashManyFunT &&hashMany, KeyAtT &&keyAt,
+                     ValueAtT &&valueAt) {
+    impl::BatchPipeline(
+        n, hashMany, [&](size_t hash) { PrefetchGroup(hash); },
+        [&](size_t hash) { PrefetchSlots(hash); },
+        [&](size_t i, size_t hash) {
+          InsertImpl(keyAt(i), hash, [&](VTYPE *lhs, bool sameKey) {
+            return InsertPolicy_(lhs, valueAt(i), sameKey);
+          });
+        });
+  }
+
+  template <typename FunT>
+  ApplyResult TryLocked(const KTYPE &key, FunT &&function) {
+    bool busy = false;
+    Position pos = Find(key, Hash(key), &busy);
+    if (busy) return ApplyResult::FAILED;
+    if (pos.table == nullptr) return ApplyResult::NOT_FOUND;
+    function(pos.table->slots[pos.slot].Value());
+    pos.table->Unlock(pos.slot);
+    return ApplyResult::SUCCESS;
+  }
+
+  // Visit the slots of the i-th bucket of the iterations.
+  template <typename VisitFunT>
+  static void ForEachSlot(
+      LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+      const size_t i, VisitFunT &&visit) {
+    for (Table *table = mapPtr->root_.load(); table != nullptr;
+         table = table->next.load()) {
+      size_t span = table->numGroups / mapPtr->numBuckets_ * kGroupSize;
+      for (size_t s = i * span; s < (i + 1) * span; ++s) {
+        if (Group::IsFull(table->LoadCtrl(s))) visit(table->slots[s]);
+      }
+    }
+  }
+
+  template <typename ApplyFunT, typename... Args, std::size_t... is>
+  static void CallForEachEntryFun(
+      const size_t i,
+      LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+      ApplyFunT function, std::tuple<Args...> &args,
+      std::index_sequence<is...>) {
+    ForEachSlot(mapPtr, i, [&](Slot &slot) {
+      function(slot.key, slot.Value(), std::get<is>(args)...);
+    });
+  }
+
+  template <typename Tuple, typename... Args>
+  static void ForEachEntryFunWrapper(const Tuple &args, size_t begin,
+                                     size_t end) {
+    constexpr auto Size = std::tuple_size<
+        typename std::decay<decltype(std::get<2>(args))>::type>::value;
+    Tuple &tuple = const_cast<Tuple &>(args);
+    for (size_t i = begin; i < end; ++i)
+      CallForEachEntryFun(i, std::get<0>(tuple), std::get<1>(tuple),
+                          std::get<2>(tuple), std::make_index_sequence<Size>{});
+  }
+
+  template <typename ApplyFunT, typename... Args, std::size_t... is>
+  static void AsyncCallForEachEntryFun(
+      rt::Handle &handle, const size_t i,
+      LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+      ApplyFunT function, std::tuple<Args...> &args,
+      std::index_sequence<is...>) {
+    ForEachSlot(mapPtr, i, [&](Slot &slot) {
+      function(handle, slot.key, slot.Value(), std::get<is>(args)...);
+    });
+  }
+
+  template <typename Tuple, typename... Args>
+  static void AsyncForEachEntryFunWrapper(rt::Handle &handle, const Tuple &args,
+                                          size_t i) {
+    constexpr auto Size = std::tuple_size<
+        typename std::decay<decltype(std::get<2>(args))>::type>::value;
+    Tuple &tuple = const_cast<Tuple &>(args);
+    AsyncCallForEachEntryFun(handle, i, std::get<0>(tuple), std::get<1>(tuple),
+                             std::get<2>(tuple),
+                             std::make_index_sequence<Size>{});
+  }
+
+  template <typename ApplyFunT, typename... Args, std::size_t... is>
+  static void CallForEachKeyFun(
+      const size_t i,
+      LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+      ApplyFunT function, std::tuple<Args...> &args,
+      std::index_sequence<is...>) {
+    ForEachSlot(mapPtr, i,
+                [&](Slot &slot) { function(slot.key, std::get<is>(args)...); });
+  }
+
+  template <typename Tuple, typename... Args>
+  static void ForEachKeyFunWrapper(const Tuple &args, size_t begin,
+                                   size_t end) {
+    constexpr auto Size = std::tuple_size<
+        typename std::decay<decltype(std::get<2>(args))>::type>::value;
+    Tuple &tuple = const_cast<Tuple &>(args);
+    for (size_t i = begin; i < end; ++i)
+      CallForEachKeyFun(i, std::get<0>(tuple), std::get<1>(tuple),
+                        std::get<2>(tuple), std::make_index_sequence<Size>{});
+  }
+
+  template <typename ApplyFunT, typename... Args, std::size_t... is>
+  static void AsyncCallForEachKeyFun(
+      rt::Handle &handle, const size_t i,
+      LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+      ApplyFunT function, std::tuple<Args...> &args,
+      std::index_sequence<is...>) {
+    ForEachSlot(mapPtr, i, [&](Slot &slot) {
+      function(handle, slot.key, std::get<is>(args)...);
+    });
+  }
+
+  template <typename Tuple, typename... Args>
+  static void AsyncForEachKeyFunWrapper(rt::Handle &handle, const Tuple &args,
+                                        size_t i) {
+    constexpr auto Size = std::tuple_size<
+        typename std::decay<decltype(std::get<2>(args))>::type>::value;
+    Tuple &tuple = const_cast<Tuple &>(args);
+    AsyncCallForEachKeyFun(handle, i, std::get<0>(tuple), std::get<1>(tuple),
+                           std::get<2>(tuple),
+                           std::make_index_sequence<Size>{});
+  }
+
+  template <typename ApplyFunT, typename... Args, std::size_t... is>
+  static ApplyResult CallTryBlockingApplyFun(
+      LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+      const KTYPE &key, ApplyFunT function, std::tuple<Args...> &args,
+      std::index_sequence<is...>) {
+    return mapPtr->TryBlockingApply(key, function, std::get<is>(args)...);
+  }
+
+  template <typename ApplyFunT, typename... Args, std::size_t... is>
+  static ApplyResult CallTryBlockingApplyWithRetBuffFun(
+      LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+      const KTYPE &key, ApplyFunT function, uint8_t *buff, uint32_t *size,
+      std::tuple<Args...> &args, std::index_sequence<is...>) {
+    return mapPtr->TryBlockingApplyWithRetBuff(key, function, buff, size,
+                                               std::get<is>(args)...);
+  }
+
+  template <typename ApplyFunT, typename RetT, typename... Args,
+            std::size_t... is>
+  static ApplyResult CallTryBlockingApplyWithRetFun(
+      LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+      const KTYPE &key, ApplyFunT function, RetT *retPtr,
+      std::tuple<Args...> &args, std::index_sequence<is...>) {
+    return mapPtr->TryBlockingApplyWithRet(key, function, retPtr,
+                                           std::get<is>(args)...);
+  }
+
+  template <typename ApplyFunT, typename... Args, std::size_t... is>
+  static void AsyncCallApplyFun(
+      rt::Handle &handle,
+      LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+      const KTYPE &key, ApplyFunT function, std::tuple<Args...> &args,
+      std::index_sequence<is...>) {
+    VTYPE *value = mapPtr->Lookup(key);
+    if (value != nullptr) function(handle, key, *value, std::get<is>(args)...);
+  }
+
+  template <typename ApplyFunT, typename... Args, std::size_t... is>
+  static void CallApplyFun(
+      LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+      const KTYPE &key, ApplyFunT function, std::tuple<Args...> &args,
+      std::index_sequence<is...>) {
+    VTYPE *value = mapPtr->Lookup(key);
+    if (value != nullptr) function(key, *value, std::get<is>(args)...);
+  }
+
+  template <typename Tuple, typename... Args>
+  static void AsyncApplyFunWrapper(rt::Handle &handle, const Tuple &args) {
+    constexpr auto Size = std::tuple_size<
+        typename std::decay<decltype(std::get<3>(args))>::type>::value;
+    Tuple &tuple = const_cast<Tuple &>(args);
+    AsyncCallApplyFun(handle, std::get<0>(tuple), std::get<1>(tuple),
+                      std::get<2>(tuple), std::get<3>(tuple),
+                      std::make_index_sequence<Size>{});
+  }
+};
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER>
+typename LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::Position
+LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::Find(const KTYPE &key,
+                                                            size_t hash,
+                                                            bool *busy) {
+  uint8_t h2 = H2(hash);
+  for (Table *table = root_.load(); table != nullptr;
+       table = table->next.load()) {
+    size_t mask = table->numGroups - 1;
+    size_t g = (hash >> 7) & mask;
+    // Triangular probing visits every group once.
+    for (size_t i = 0; i < table->numGroups; ++i) {
+      Group &group = table->groups[g];
+      for (uint32_t m = group.Match(h2); m != 0; m &= m - 1) {
+        size_t slot = g * kGroupSize + __builtin_ctz(m);
+        if (table->LoadCtrl(slot) != h2) continue;
+        if (busy == nullptr) {
+          table->Lock(slot);
+        } else if (!table->TryLock(slot)) {
+          // The key held by the slot is unknown until the lock is released.
+          *busy = true;
+          return Position{nullptr, 0};
+        }
+        if (HoldsKey(table, slot, key, h2)) return Position{table, slot};
+        table->Unlock(slot);
+      }
+      // The key would have been inserted in the first empty slot.
+      if (group.Match(Group::kEmpty) != 0) break;
+      g = (g + i + 1) & mask;
+    }
+  }
+  return Position{nullptr, 0};
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER>
+bool LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::ClaimSlot(
+    Table *table, size_t hash, size_t *slotPtr) {
+  for (;;) {
+    bool sealed = table->sealed.load();
+    size_t mask = table->numGroups - 1;
+    size_t g = (hash >> 7) & mask;
+    size_t i = 0;
+    for (; i < table->numGroups; ++i) {
+      Group &group = table->groups[g];
+      uint32_t deleted = group.Match(Group::kDeleted);
+      if (deleted != 0) {
+        size_t slot = g * kGroupSize + __builtin_ctz(deleted);
+        // Lost to the insert of another key: probe again.
+        if (!__sync_bool_compare_and_swap(table->Ctrl(slot), Group::kDeleted,
+                                          Group::kPending))
+          break;
+        *slotPtr = slot;
+        return true;
+      }
+      uint32_t empty = group.Match(Group::kEmpty);
+      if (empty != 0) {
+        if (sealed) return false;
+        size_t slot = g * kGroupSize + __builtin_ctz(empty);
+        if (!__sync_bool_compare_and_swap(table->Ctrl(slot), Group::kEmpty,
+                                          Group::kPending))
+          break;
+        // The table was sealed in the meantime: leave the slot for reuse.
+        if (table->sealed.load()) {
+          __atomic_store_n(table->Ctrl(slot), Group::kDeleted,
+                           __ATOMIC_RELEASE);
+          return false;
+        }
+        if (table->claims.fetch_add(1) + 1 >= table->maxClaims)
+          table->sealed.store(true);
+        *slotPtr = slot;
+        return true;
+      }
+      g = (g + i + 1) & mask;
+    }
+    // No empty slot left: seal the table.
+    if (i == table->numGroups) {
+      table->sealed.store(true);
+      return false;
+    }
+  }
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER>
+template <typename InsertFunT>
+std::pair<
+    typename LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::iterator,
+    bool>
+LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::InsertImpl(
+    const KTYPE &key, size_t hash, InsertFunT &&insert) {
+  uint8_t h2 = H2(hash);
+  Table *root = Allocate(root_, &isRootAllocated_, numBuckets_);
+
+  // Update of an existing entry, found with the lock of its slot held.
+  auto update = [&](Position pos) -> std::pair<iterator, bool> {
+    bool inserted = insert(&pos.table->slots[pos.slot].Value(), true);
+    pos.table->Unlock(pos.slot);
+    return std::make_pair(
+        iterator(this, BucketOf(pos.table, pos.slot), pos.table, pos.slot),
+        inserted);
+  };
+
+  Position pos = Find(key, hash);
+  if (pos.table != nullptr) return update(pos);
+
+  // First time insertion.  The inserts of the key are serialized from here
+  // on, hence the key is either found again or claims a single slot: the
+  // first deleted slot of its probe sequences, or the first empty slot of a
+  // table that is not sealed.
+  uint8_t *lock = InsertLock(hash);
+  while (!__sync_bool_compare_and_swap(lock, 0, 1)) rt::impl::yield();
+  pos = Find(key, hash);
+  if (pos.table != nullptr) {
+    auto res = update(pos);
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+    return res;
+  }
+
+  size_t slot;
+  Table *table = root;
+  while (!ClaimSlot(table, hash, &slot)) table = NextTable(table);
+  // A deleted slot may still be locked by a reader of its previous key.
+  table->Lock(slot);
+  table->slots[slot].key = key;
+  bool inserted = insert(&table->slots[slot].Value(), false);
+  size_ += 1;
+  __atomic_store_n(table->Ctrl(slot), h2, __ATOMIC_RELEASE);
+  table->Unlock(slot);
+  __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+  return std::make_pair(iterator(this, BucketOf(table, slot), table, slot),
+                        inserted);
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER>
+VTYPE *LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::Lookup(
+    const KTYPE &key) {
+  return LookupHash(key, Hash(key));
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER>
+void LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::Erase(
+    const KTYPE &key) {
+  Position pos = Find(key, Hash(key));
+  if (pos.table == nullptr) return;
+  __atomic_store_n(pos.table->Ctrl(pos.slot), Group::kDeleted,
+                   __ATOMIC_RELEASE);
+  size_ -= 1;
+  pos.table->Unlock(pos.slot);
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER>
+void LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncErase(
+    rt::Handle &handle, const KTYPE &key) {
+  using LMapPtr = LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  auto args = std::tuple<LMapPtr, KTYPE>(this, key);
+  auto eraseLambda = [](rt::Handle &, const std::tuple<LMapPtr, KTYPE> &t) {
+    (std::get<0>(t))->Erase(std::get<1>(t));
+  };
+  rt::asyncExecuteAt(handle, rt::thisLocality(), eraseLambda, args);
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER>
+template <typename ELTYPE>
+void LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncInsert(
+    rt::Handle &handle, const KTYPE &key, const ELTYPE &value) {
+  using LMapPtr = LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  auto args = std::tuple<LMapPtr, KTYPE, ELTYPE>(this, key, value);
+  auto insertLambda = [](rt::Handle &,
+                         const std::tuple<LMapPtr, KTYPE, ELTYPE> &t) {
+    (std::get<0>(t))->Insert(std::get<1>(t), std::get<2>(t));
+  };
+  rt::asyncExecuteAt(handle, rt::thisLocality(), insertLambda, args);
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER>
+void LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncLookup(
+    rt::Handle &handle, const KTYPE &key, VTYPE **result) {
+  using LMapPtr = LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  auto args = std::tuple<LMapPtr, KTYPE, VTYPE **>(this, key, result);
+  auto lookupLambda = [](rt::Handle &,
+                         const std::tuple<LMapPtr, KTYPE, VTYPE **> &t) {
+    *std::get<2>(t) = (std::get<0>(t))->Lookup(std::get<1>(t));
+  };
+  rt::asyncExecuteAt(handle, rt::thisLocality(), lookupLambda, args);
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER>
+void LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncLookup(
+    rt::Handle &handle, const KTYPE &key, LookupResult *result) {
+  using LMapPtr = LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  auto args = std::tuple<LMapPtr, KTYPE, LookupResult *>(this, key, result);
+  auto lookupLambda = [](rt::Handle &,
+                         const std::tuple<LMapPtr, KTYPE, LookupResult *> &t) {
+    (std::get<0>(t))->Lookup(std::get<1>(t), std::get<2>(t));
+  };
+  rt::asyncExecuteAt(handle, rt::thisLocality(), lookupLambda, args);
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER>
+template <typename ApplyFunT, typename... Args>
+void LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::ForEachEntry(
+    ApplyFunT &&function, Args &... args) {
+  using FunctionTy = void (*)(const KTYPE &, VTYPE &, Args &...);
+  FunctionTy fn = std::forward<decltype(function)>(function);
+  using LMapPtr = LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  using ArgsTuple = std::tuple<LMapPtr, FunctionTy, std::tuple<Args...>>;
+  ArgsTuple argsTuple(this, fn, std::tuple<Args...>(args...));
+  rt::forEachRangeAt(rt::thisLocality(),
+                     ForEachEntryFunWrapper<ArgsTuple, Args...>, argsTuple,
+                     numBuckets_);
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER>
+template <typename ApplyFunT, typename... Args>
+void LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncForEachEntry(
+    rt::Handle &handle, ApplyFunT &&function, Args &... args) {
+  using FunctionTy = void (*)(rt::Handle &, const KTYPE &, VTYPE &, Args &...);
+  FunctionTy fn = std::forward<decltype(function)>(function);
+  using LMapPtr = LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  using ArgsTuple = std::tuple<LMapPtr, FunctionTy, std::tuple<Args...>>;
+  ArgsTuple argsTuple(this, fn, std::tuple<Args...>(args...));
+  rt::asyncForEachAt(handle, rt::thisLocality(),
+                     AsyncForEachEntryFunWrapper<ArgsTuple, Args...>, argsTuple,
+                     numBuckets_);
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER>
+template <typename ApplyFunT, typename... Args>
+void LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::ForEachKey(
+    ApplyFunT &&function, Args &... args) {
+  using FunctionTy = void (*)(const KTYPE &, Args &...);
+  FunctionTy fn = std::forward<decltype(function)>(function);
+  using LMapPtr = LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  using ArgsTuple = std::tuple<LMapPtr, FunctionTy, std::tuple<Args...>>;
+  ArgsTuple argsTuple(this, fn, std::tuple<Args...>(args...));
+  rt::forEachRangeAt(rt::thisLocality(),
+                     ForEachKeyFunWrapper<ArgsTuple, Args...>, argsTuple,
+                     numBuckets_);
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER>
+template <typename ApplyFunT, typename... Args>
+void LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncForEachKey(
+    rt::Handle &handle, ApplyFunT &&function, Args &... args) {
+  using FunctionTy = void (*)(rt::Handle &, const KTYPE &, Args &...);
+  FunctionTy fn = std::forward<decltype(function)>(function);
+  using LMapPtr = LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  using ArgsTuple = std::tuple<LMapPtr, FunctionTy, std::tuple<Args...>>;
+  ArgsTuple argsTuple(this, fn, std::tuple<Args...>(args...));
+  rt::asyncForEachAt(handle, rt::thisLocality(),
+                     AsyncForEachKeyFunWrapper<ArgsTuple, Args...>, argsTuple,
+                     numBuckets_);
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER>
+template <typename ApplyFunT, typename... Args>
+void LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncApply(
+    rt::Handle &handle, const KTYPE &key, ApplyFunT &&function,
+    Args &... args) {
+  using FunctionTy = void (*)(rt::Handle &, const KTYPE &, VTYPE &, Args &...);
+  FunctionTy fn = std::forward<decltype(function)>(function);
+  using LMapPtr = LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  using ArgsTuple =
+      std::tuple<LMapPtr, const KTYPE, FunctionTy, std::tuple<Args...>>;
+
+  ArgsTuple argsTuple(this, key, fn, std::tuple<Args...>(args...));
+  rt::asyncExecuteAt(handle, rt::thisLocality(),
+                     AsyncApplyFunWrapper<ArgsTuple, Args...>, argsTuple);
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER>
+void LocalFlatHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::PrintAllEntries() {
+  size_t tableId = 0;
+  for (Table *table = root_.load(); table != nullptr;
+       table = table->next.load(), ++tableId) {
+    std::cout << "Table: " << tableId << std::endl;
+    for (size_t s = 0; s < table->numGroups * kGroupSize; ++s) {
+      if (!Group::IsFull(table->LoadCtrl(s))) continue;
+      std::cout << s << ": [" << table->slots[s].key << "] ["
+                << table->slots[s].Value() << "]\n";
+    }
+  }
+}
+
+template <typename LMap, typename T>
+class lflatmap_iterator {
+  template <typename, typename, typename>
+  friend class map_iterator;
+
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using pointer = T *;
+  using reference = T &;
+  using Table = typename LMap::Table;
+
+  lflatmap_iterator() {}
+  lflatmap_iterator(const LMap *mapPtr, size_t bId, Table *table, size_t slot)
+      : mapPtr_(mapPtr), bucketId_(bId), table_(table), slot_(slot) {}
+
+  static lflatmap_iterator lmap_begin(const LMap *mapPtr) {
+    return first_in_bucket(mapPtr, 0);
+  }
+
+  static lflatmap_iterator lmap_end(const LMap *mapPtr) {
+    return lmap_end(mapPtr->numBuckets_);
+  }
+
+  static lflatmap_iterator lmap_end(size_t numBuckets) {
+    return lflatmap_iterator(nullptr, numBuckets, nullptr, 0);
+  }
+
+  bool operator==(const lflatmap_iterator &other) const {
+    return table_ == other.table_ && slot_ == other.slot_;
+  }
+  bool operator!=(const lflatmap_iterator &other) const {
+    return !(*this == other);
+  }
+
+  T operator*() const {
+    return T(table_->slots[slot_].key, table_->slots[slot_].Value());
+  }
+
+  lflatmap_iterator &operator++() {
+    ++slot_;
+    settle();
+    return *this;
+  }
+  lflatmap_iterator operator++(int) {
+    lflatmap_iterator tmp = *this;
+    operator++();
+    return tmp;
+  }
+
+  class partition_range {
+   public:
+    partition_range(const lflatmap_iterator &begin,
+                    const lflatmap_iterator &end)
+        : begin_(begin), end_(end) {}
+    lflatmap_iterator begin() { return begin_; }
+    lflatmap_iterator end() { return end_; }
+
+   private:
+    lflatmap_iterator begin_;
+    lflatmap_iterator end_;
+  };
+
+  // split a range into at most n_parts non-empty sub-ranges
+  static std::vector<partition_range> partitions(lflatmap_iterator begin,
+                                                 lflatmap_iterator end,
+                                                 size_t n_parts) {
+    std::vector<partition_range> res;
+    if (begin == end || n_parts == 0) return res;
+
+    auto map_ptr = begin.mapPtr_;
+    auto b_end = end.table_ != nullptr ? end.bucketId_ : map_ptr->numBuckets_;
+    auto n_buckets = b_end - begin.bucketId_ + (end.table_ != nullptr);
+    auto part_step = (n_buckets + n_parts - 1) / n_parts;
+    auto pbegin = begin;
+    for (auto bi = begin.bucketId_ + part_step; bi < b_end;) {
+      auto pend = first_in_bucket(map_ptr, bi);
+      if (pend.table_ == nullptr || pend.bucketId_ >= b_end) break;
+      res.push_back(partition_range{pbegin, pend});
+      pbegin = pend;
+      bi = pend.bucketId_ + part_step;
+    }
+    res.push_back(partition_range{pbegin, end});
+    return res;
+  }
+
+ private:
+  const LMap *mapPtr_;
+  size_t bucketId_;
+  Table *table_;
+  size_t slot_;
+
+  // returns an iterator pointing to the first entry of the first non-empty
+  // bucket from the input bucket (included)
+  static lflatmap_iterator first_in_bucket(const LMap *mapPtr, size_t bi) {
+    lflatmap_iterator it(mapPtr, bi, mapPtr->root_.load(), 0);
+    if (it.table_ == nullptr || bi >= mapPtr->numBuckets_)
+      return lmap_end(mapPtr);
+    it.slot_ = it.first_slot();
+    it.settle();
+    return it;
+  }
+
+  size_t span() const {
+    return table_->numGroups / mapPtr_->numBuckets_ * LMap::kGroupSize;
+  }
+
+  size_t first_slot() const { return bucketId_ * span(); }
+
+  // Move forward to the first used slot, visiting the buckets in order and
+  // for each bucket its groups in every table.
+  void settle() {
+    while (table_ != nullptr) {
+      for (size_t last = (bucketId_ + 1) * span(); slot_ < last; ++slot_) {
+        if (LMap::Group::IsFull(table_->LoadCtrl(slot_))) return;
+      }
+      table_ = table_->next.load();
+      if (table_ == nullptr && ++bucketId_ < mapPtr_->numBuckets_)
+        table_ = mapPtr_->root_.load();
+      if (table_ != nullptr) slot_ = first_slot();
+    }
+    *this = lmap_end(mapPtr_);
+  }
+};
+
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_DATA_STRUCTURES_LOCAL_FLAT_HASHMAP_H_
@@ -0,0 +1,401 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_DATA_STRUCTURES_LOCAL_FLAT_SET_H_
+#define INCLUDE_SHAD_DATA_STRUCTURES_LOCAL_FLAT_SET_H_
+
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "shad/data_structures/compare_and_hash_utils.h"
+#include "shad/data_structures/local_flat_hashmap.h"
+#include "shad/runtime/runtime.h"
+
+namespace shad {
+
+template <typename LSet, typename T>
+class lflatset_iterator;
+
+namespace impl {
+
+/// @brief The (empty) value associated to the elements of a LocalFlatSet.
+struct FlatSetValue {};
+
+}  // namespace impl
+
+/// @brief The LocalFlatSet data structure.
+///
+/// SHAD's LocalFlatSet is a "local", unordered, set with the same interface
+/// of LocalSet, storing its elements in the open-addressing tables of a
+/// LocalFlatHashmap.  LocalFlatSets can be used ONLY on the Locality on which
+/// they are created.  They are picked as the storage of a Set through its
+/// LOCAL_SET template parameter, or as the neighbor lists of an edge index.
+/// @tparam T type of the entries stored in the set.
+/// @tparam ELEM_COMPARE key comparison function; default is MemCmp<T>.
+template <typename T, typename ELEM_COMPARE = MemCmp<T>>
+class LocalFlatSet {
+  template <typename, typename, template <typename, typename> class>
+  friend class Set;
+  template <typename, typename, typename>
+  friend class LocalEdgeIndex;
+  template <typename, typename>
+  friend class AttrEdgesPair;
+
+  friend class lflatset_iterator<LocalFlatSet<T, ELEM_COMPARE>, const T>;
+  template <typename, typename, typename>
+  friend class set_iterator;
+
+  using MapT = LocalFlatHashmap<T, impl::FlatSetValue, ELEM_COMPARE,
+                                Overwriter<impl::FlatSetValue>>;
+
+ public:
+  using value_type = T;
+  using iterator = lflatset_iterator<LocalFlatSet<T, ELEM_COMPARE>, const T>;
+  using const_iterator =
+      lflatset_iterator<LocalFlatSet<T, ELEM_COMPARE>, const T>;
+
+  /// @brief Constructor.
+  /// @param numInitBuckets initial number of Buckets, as for LocalSet
+  /// (i.e., the set is sized for numInitBuckets *
+  /// constants::kDefaultNumEntriesPerBucket elements).
+  explicit LocalFlatSet(const size_t numInitBuckets = 1)
+      : map_(numInitBuckets), numBuckets_(map_.numBuckets_) {}
+
+  /// @brief Size of the set (number of entries).
+  /// @return the size of the set.
+  size_t Size() const { return map_.Size(); }
+
+  /// @brief Insert an element in the set.
+  /// @param[in] element the element to insert.
+  /// @return a pair consisting of an iterator to the inserted element (or to
+  /// the element that prevented the insertion) and a bool denoting whether the
+  /// insertion took place.
+  std::pair<iterator, bool> Insert(const T& element) {
+    auto res = map_.InsertImpl(
+        element, MapT::Hash(element),
+        [](impl::FlatSetValue*, bool sameKey) { return !sameKey; });
+    return std::make_pair(iterator(res.first), res.second);
+  }
+
+  /// @brief Asynchronously Insert an element in the set.
+  /// @warning Asynchronous operations are guaranteed to have completed
+  /// only after calling the rt::waitForCompletion(rt::Handle &handle) method.
+  /// @param[in,out] handle Reference to the handle
+  /// to be used to wait for completion.
+  /// @param[in] element the element to insert.
+  void AsyncInsert(rt::Handle& handle, const T& element);
+
+  /// @brief Remove an element from the set.
+  /// @param[in] element the element to remove.
+  void Erase(const T& element) { map_.Erase(element); }
+
+  /// @brief Asynchronously removen element from the set.
+  /// @warning Asynchronous operations are guaranteed to have completed.
+  /// only after calling the rt::waitForCompletion(rt::Handle &handle) method.
+  /// @param[in,out] handle Reference to the handle.
+  /// to be used to wait for completion.
+  /// @param[in] element the element to insert.
+  void AsyncErase(rt::Handle& handle, const T& element) {
+    map_.AsyncErase(handle, element);
+  }
+
+  /// @brief Clear the content of the set.
+  void Clear() { map_.Clear(); }
+
+  /// @brief Clear the content of the set.
+  void Reset(size_t expectedEntries) {
+    map_.Clear();
+    map_.numBuckets_ = MapT::NumGroups(expectedEntries);
+    numBuckets_ = map_.numBuckets_;
+  }
+
+  /// @brief Check if the set contains a given element.
+  /// @param[in] element the element to find.
+  /// @return true if the element is found, false otherwise.
+  bool Find(const T& element) {
+    return map_.LookupHash(element, MapT::Hash(element)) != nullptr;
+  }
+
+  /// @brief Asynchronously check if the set contains a given element.
+  /// @warning Asynchronous operations are guaranteed to have completed
+  /// only after calling the rt::waitForCompletion(rt::Handle &handle) method.
+  /// @param[in,out] handle Reference to the handle
+  /// to be used to wait for completion.
+  /// @param[in] element the element to find.
+  /// @param[out] found the address where to store the result of the operation.
+  void AsyncFind(rt::Handle& handle, const T& element, bool* found);
+
+  /// @brief Apply a user-defined function to each element in the set.
+  /// @tparam ApplyFunT User-defined function type.
+  /// The function prototype should be:
+  /// @code
+  /// void(const T&, Args&);
+  /// @endcode
+  /// @tparam ...Args Types of the function arguments.
+  /// @param function The function to apply.
+  /// @param args The function arguments.
+  template <typename ApplyFunT, typename... Args>
+  void ForEachElement(ApplyFunT&& function, Args&... args);
+
+  /// @brief Asynchronously apply a user-defined function
+  /// to each element in the set.
+  /// @tparam ApplyFunT User-defined function type.
+  /// The function prototype should be:
+  /// @code
+  /// void(shad::rt::Handle&, const T&, Args&);
+  /// @endcode
+  /// @tparam ...Args Types of the function arguments.
+  /// @warning Asynchronous operations are guaranteed to have completed.
+  /// only after calling the rt::waitForCompletion(rt::Handle &handle) method.
+  /// @param[in,out] handle Reference to the handle.
+  /// to be used to wait for completion.
+  /// @param function The function to apply.
+  /// @param args The function arguments.
+  template <typename ApplyFunT, typename... Args>
+  void AsyncForEachElement(rt::Handle& handle, ApplyFunT&& function,
+                           Args&... args);
+
+  /// @brief Print all the entries in the set.
+  /// @warning std::ostream & operator<< must be defined for T.
+  void PrintAllElements() {
+    ForEachNeighbor(
+        [](const size_t&, const T& element) {
+          std::cout << "[" << element << "]\n";
+        },
+        size_t(0));
+  }
+
+  iterator begin() { return iterator::lset_begin(this); }
+  iterator end() { return iterator::lset_end(numBuckets_); }
+  const_iterator cbegin() { return const_iterator::lset_begin(this); }
+  const_iterator cend() { return const_iterator::lset_end(numBuckets_); }
+
+ private:
+  using Slot = typename MapT::Slot;
+
+  MapT map_;
+  // The number of buckets of the iterations over the set (see
+  // LocalFlatHashmap).
+  size_t numBuckets_;
+
+  template <typename ApplyFunT, typename... Args, std::size_t... is>
+  static void AsyncCallForEachElementFun(rt::Handle& handle, const size_t i,
+                                         LocalFlatSet<T, ELEM_COMPARE>* setPtr,
+                                         ApplyFunT function,
+                                         std::tuple<Args...>& args,
+                                         std::index_sequence<is...>) {
+    MapT::ForEachSlot(&setPtr->map_, i, [&](Slot& slot) {
+      function(handle, slot.key, std::get<is>(args)...);
+    });
+  }
+
+  template <typename Tuple, typename... Args>
+  static void AsyncForEachElementFunWrapper(rt::Handle& handle,
+                                            const Tuple& args, size_t i) {
+    constexpr auto Size = std::tuple_size<
+        typename std::decay<decltype(std::get<2>(args))>::type>::value;
+    Tuple& tuple = const_cast<Tuple&>(args);
+    AsyncCallForEachElementFun(handle, i, std::get<0>(tuple),
+                               std::get<1>(tuple), std::get<2>(tuple),
+                               std::make_index_sequence<Size>{});
+  }
+
+  template <typename ApplyFunT, typename... Args, std::size_t... is>
+  static void CallForEachElementFun(const size_t i,
+                                    LocalFlatSet<T, ELEM_COMPARE>* setPtr,
+                                    ApplyFunT function,
+                                    std::tuple<Args...>& args,
+                                    std::index_sequence<is...>) {
+    MapT::ForEachSlot(&setPtr->map_, i, [&](Slot& slot) {
+      function(slot.key, std::get<is>(args)...);
+    });
+  }
+
+  template <typename Tuple, typename... Args>
+  static void ForEachElementFunWrapper(const Tuple& args, size_t i) {
+    constexpr auto Size = std::tuple_size<
+        typename std::decay<decltype(std::get<2>(args))>::type>::value;
+    Tuple& tuple = const_cast<Tuple&>(args);
+    CallForEachElementFun(i, std::get<0>(tuple), std::get<1>(tuple),
+                          std::get<2>(tuple), std::make_index_sequence<Size>{});
+  }
+
+ protected:
+  // Custom ForEach for the Local Edge Index
+  template <typename ApplyFunT, typename SrcT, typename... Args>
+  void AsyncForEachNeighbor(rt::Handle& handle, ApplyFunT&& function, SrcT src,
+                            Args... args) {
+    for (size_t i = 0; i < numBuckets_; ++i) {
+      MapT::ForEachSlot(&map_, i, [&](Slot& slot) {
+        function(handle, src, slot.key, args...);
+      });
+    }
+  }
+  // Custom ForEach for the Local Edge Index
+  template <typename ApplyFunT, typename SrcT, typename... Args>
+  void ForEachNeighbor(ApplyFunT&& function, SrcT src, Args... args) {
+    for (size_t i = 0; i < numBuckets_; ++i) {
+      MapT::ForEachSlot(&map_, i,
+                        [&](Slot& slot) { function(src, slot.key, args...); });
+    }
+  }
+};
+
+template <typename T, typename ELEM_COMPARE>
+void LocalFlatSet<T, ELEM_COMPARE>::AsyncInsert(rt::Handle& handle,
+                                                const T& element) {
+  auto args = std::tuple<LocalFlatSet<T, ELEM_COMPARE>*, T>(this, element);
+  auto insertLambda =
+      [](rt::Handle&, const std::tuple<LocalFlatSet<T, ELEM_COMPARE>*, T>& t) {
+        (std::get<0>(t))->Insert(std::get<1>(t));
+      };
+  rt::asyncExecuteAt(handle, rt::thisLocality(), insertLambda, args);
+}
+
+template <typename T, typename ELEM_COMPARE>
+void LocalFlatSet<T, ELEM_COMPARE>::AsyncFind(rt::Handle& handle,
+                                              const T& element, bool* found) {
+  auto args = std::tuple<LocalFlatSet<T, ELEM_COMPARE>*, T, bool*>(
+      this, element, found);
+  auto findLambda =
+      [](rt::Handle&,
+         const std::tuple<LocalFlatSet<T, ELEM_COMPARE>*, T, bool*>& t) {
+        *std::get<2>(t) = (std::get<0>(t))->Find(std::get<1>(t));
+      };
+  rt::asyncExecuteAt(handle, rt::thisLocality(), findLambda, args);
+}
+
+template <typename T, typename ELEM_COMPARE>
+template <typename ApplyFunT, typename... Args>
+void LocalFlatSet<T, ELEM_COMPARE>::ForEachElement(ApplyFunT&& function,
+                                                   Args&... args) {
+  using FunctionTy = void (*)(const T&, Args&...);
+  FunctionTy fn = std::forward<decltype(function)>(function);
+  using ArgsTuple = std::tuple<LocalFlatSet<T, ELEM_COMPARE>*, FunctionTy,
+                               std::tuple<Args...>>;
+  ArgsTuple argsTuple(this, fn, std::tuple<Args...>(args...));
+  rt::forEachAt(rt::thisLocality(),
+                ForEachElementFunWrapper<ArgsTuple, Args...>, argsTuple,
+                numBuckets_);
+}
+
+template <typename T, typename ELEM_COMPARE>
+template <typename ApplyFunT, typename... Args>
+void LocalFlatSet<T, ELEM_COMPARE>::AsyncForEachElement(rt::Handle& handle,
+                                                        ApplyFunT&& function,
+                                                        Args&... args) {
+  using FunctionTy = void (*)(rt::Handle&, const T&, Args&...);
+  FunctionTy fn = std::forward<decltype(function)>(function);
+  using ArgsTuple = std::tuple<LocalFlatSet<T, ELEM_COMPARE>*, FunctionTy,
+                               std::tuple<Args...>>;
+  ArgsTuple argsTuple(this, fn, std::tuple<Args...>(args...));
+  rt::asyncForEachAt(handle, rt::thisLocality(),
+                     AsyncForEachElementFunWrapper<ArgsTuple, Args...>,
+                     argsTuple, numBuckets_);
+}
+
+template <typename LSet, typename T>
+class lflatset_iterator {
+  template <typename, typename, typename>
+  friend class set_iterator;
+
+  using map_iterator_type = typename LSet::MapT::iterator;
+
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using pointer = T*;
+  using reference = T&;
+
+  lflatset_iterator() {}
+  explicit lflatset_iterator(const map_iterator_type& mapIt) : mapIt_(mapIt) {}
+
+  static lflatset_iterator lset_begin(const LSet* setPtr) {
+    return lflatset_iterator(map_iterator_type::lmap_begin(&setPtr->map_));
+  }
+
+  static lflatset_iterator lset_end(const LSet* setPtr) {
+    return lset_end(setPtr->numBuckets_);
+  }
+
+  static lflatset_iterator lset_end(size_t numBuckets) {
+    return lflatset_iterator(map_iterator_type::lmap_end(numBuckets));
+  }
+
+  bool operator==(const lflatset_iterator& other) const {
+    return mapIt_ == other.mapIt_;
+  }
+  bool operator!=(const lflatset_iterator& other) const {
+    return !(*this == other);
+  }
+
+  T operator*() const { return (*mapIt_).first; }
+
+  lflatset_iterator& operator++() {
+    ++mapIt_;
+    return *this;
+  }
+  lflatset_iterator operator++(int) {
+    lflatset_iterator tmp = *this;
+    operator++();
+    return tmp;
+  }
+
+  class partition_range {
+   public:
+    partition_range(const lflatset_iterator& begin,
+                    const lflatset_iterator& end)
+        : begin_(begin), end_(end) {}
+    lflatset_iterator begin() { return begin_; }
+    lflatset_iterator end() { return end_; }
+
+   private:
+    lflatset_iterator begin_;
+    lflatset_iterator end_;
+  };
+
+  // split a range into at most n_parts non-empty sub-ranges
+  static std::vector<partition_range> partitions(lflatset_iterator begin,
+                                                 lflatset_iterator end,
+                                                 size_t n_parts) {
+    std::vector<partition_range> res;
+    for (auto& part :
+         map_iterator_type::partitions(begin.mapIt_, end.mapIt_, n_parts))
+      res.push_back(partition_range{lflatset_iterator(part.begin()),
+                                    lflatset_iterator(part.end())});
+    return res;
+  }
+
+ private:
+  map_iterator_type mapIt_;
+};
+
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_DATA_STRUCTURES_LOCAL_FLAT_SET_H_
@@ -27,14 +27,18 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cassert>
 #include <functional>
 #include <memory>
+#include <new>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "shad/data_structures/compare_and_hash_utils.h"
 #include "shad/runtime/runtime.h"
+#include "shad/runtime/scheduling_policy.h"
 
 namespace shad {
 
@@ -42,6 +46,157 @@ namespace constants {
 constexpr size_t kDefaultNumEntriesPerBucket = 128;
 }
 
+/// @brief LocalHashmap layout storing each entry as a structure.
+///
+/// The key, the value and the state of an entry are next to each other, so
+/// that the value of a key is usually found in the same cache line.
+struct AoSLayout {};
+
+/// @brief LocalHashmap layout storing the entries as a structure of arrays.
+///
+/// Each bucket keeps the states, the keys and the values of its entries in
+/// three arrays of the same memory block.  Small keys and values are not
+/// padded to each other's alignment, and ForEachKey does not bring the
+/// values into the cache.
+struct SoALayout {};
+
+namespace impl {
+
+inline size_t AlignUp(size_t offset, size_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Where the layout stores the i-th of the n entries of a bucket, in the
+// memory block holding the entries of the bucket.
+template <typename KTYPE, typename VTYPE, typename StateT, typename LAYOUT>
+struct EntryLayout;
+
+template <typename KTYPE, typename VTYPE, typename StateT>
+struct EntryLayout<KTYPE, VTYPE, StateT, AoSLayout> {
+  struct Slot {
+    KTYPE key;
+    VTYPE value;
+    volatile StateT state;
+    explicit Slot(StateT s) : state(s) {}
+  };
+
+  static constexpr size_t kAlignment = alignof(Slot);
+
+  static size_t Bytes(size_t n) { return n * sizeof(Slot); }
+
+  static void Construct(uint8_t *block, size_t n, StateT empty) {
+    for (size_t i = 0; i < n; ++i) new (block + i * sizeof(Slot)) Slot(empty);
+  }
+
+  static void Destroy(uint8_t *block, size_t n) {
+    for (size_t i = 0; i < n; ++i) Slots(block)[i].~Slot();
+  }
+
+  static KTYPE *Key(uint8_t *block, size_t, size_t i) {
+    return &Slots(block)[i].key;
+  }
+  static VTYPE *Value(uint8_t *block, size_t, size_t i) {
+    return &Slots(block)[i].value;
+  }
+  static volatile StateT *State(uint8_t *block, size_t, size_t i) {
+    return &Slots(block)[i].state;
+  }
+
+ private:
+  static Slot *Slots(uint8_t *block) { return reinterpret_cast<Slot *>(block); }
+};
+
+// The states come first, as they drive the scans of a bucket.
+template <typename KTYPE, typename VTYPE, typename StateT>
+struct EntryLayout<KTYPE, VTYPE, StateT, SoALayout> {
+  static constexpr size_t kAlignment =
+      std::max({alignof(KTYPE), alignof(VTYPE), alignof(StateT)});
+
+  static size_t Bytes(size_t n) { return ValuesOffset(n) + n * sizeof(VTYPE); }
+
+  static void Construct(uint8_t *block, size_t n, StateT empty) {
+    for (size_t i = 0; i < n; ++i) {
+      new (block + i * sizeof(StateT)) StateT(empty);
+      new (Key(block, n, i)) KTYPE;
+      new (Value(block, n, i)) VTYPE;
+    }
+  }
+
+  static void Destroy(uint8_t *block, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      Key(block, n, i)->~KTYPE();
+      Value(block, n, i)->~VTYPE();
+    }
+  }
+
+  static KTYPE *Key(uint8_t *block, size_t n, size_t i) {
+    return reinterpret_cast<KTYPE *>(block + KeysOffset(n)) + i;
+  }
+  static VTYPE *Value(uint8_t *block, size_t n, size_t i) {
+    return reinterpret_cast<VTYPE *>(block + ValuesOffset(n)) + i;
+  }
+  static volatile StateT *State(uint8_t *block, size_t, size_t i) {
+    return reinterpret_cast<volatile StateT *>(block) + i;
+  }
+
+ private:
+  static size_t KeysOffset(size_t n) {
+    return AlignUp(n * sizeof(StateT), alignof(KTYPE));
+  }
+  static size_t ValuesOffset(size_t n) {
+    return AlignUp(KeysOffset(n) + n * sizeof(KTYPE), alignof(VTYPE));
+  }
+};
+
+// Allocate and construct the block of n entries of a bucket in one piece.
+template <typename Layout, typename StateT>
+uint8_t *AllocateEntries(size_t n, StateT empty) {
+  uint8_t *block = static_cast<uint8_t *>(::operator new(
+      Layout::Bytes(n), std::align_val_t(Layout::kAlignment)));
+  Layout::Construct(block, n, empty);
+  return block;
+}
+
+template <typename Layout>
+void FreeEntries(uint8_t *block, size_t n) {
+  Layout::Destroy(block, n);
+  ::operator delete(block, std::align_val_t(Layout::kAlignment));
+}
+
+/// Number of keys a batch operation of the local hashmaps looks ahead.
+constexpr size_t kBatchPrefetchDistance = 16;
+
+// Run the stages of a batch operation over n keys as a software pipeline.
+// hashMany(first, count, out) hashes count keys from the first-th one (see
+// HashMany), prefetch(hash) prefetches the bucket of a key, touch(hash)
+// prefetches the memory reached through the bucket, and resolve(i, hash)
+// performs the operation.  The keys are hashed kBatchPrefetchDistance at a
+// time, and a bucket is prefetched kBatchPrefetchDistance iterations before
+// its key is resolved, so that the cache misses of the keys in flight
+// overlap instead of being paid one at a time.
+template <typename HashManyFunT, typename PrefetchFunT, typename TouchFunT,
+          typename ResolveFunT>
+void BatchPipeline(size_t n, HashManyFunT &&hashMany, PrefetchFunT &&prefetch,
+                   TouchFunT &&touch, ResolveFunT &&resolve) {
+  constexpr size_t kDistance = kBatchPrefetchDistance;
+  constexpr size_t kRing = 2 * kDistance;
+  // A block of hashes replaces the one of keys that are already resolved.
+  uint64_t hashes[kRing];
+  for (size_t i = 0; i < n + kDistance; ++i) {
+    if (i < n) {
+      if (i % kDistance == 0)
+        hashMany(i, std::min(kDistance, n - i), &hashes[i % kRing]);
+      prefetch(hashes[i % kRing]);
+    }
+    size_t j = i - kDistance / 2;
+    if (i >= kDistance / 2 && j < n) touch(hashes[j % kRing]);
+    j = i - kDistance;
+    if (i >= kDistance) resolve(j, hashes[j % kRing]);
+  }
+}
+
+}  // namespace impl
+
 template <typename LMap, typename T>
 class lmap_iterator;
 
@@ -102,41 +257,62 @@ struct Updater {
 /// SHAD's LocalHashmap is a "local", thread-safe, associative container.
 /// LocalHashmaps can be used ONLY on the Locality
 /// on which they are created.
+///
+/// The hashmap doubles its number of buckets when they hold more than
+/// kNumEntriesPerBucket entries on average, or when the chain of a bucket
+/// grows too long.  Resizing is incremental: buckets are migrated to the new
+/// table by the insertions that follow, while other operations keep running
+/// on either table.  A resize moves the entries, hence it invalidates the
+/// pointers returned by Lookup(const KTYPE&) and the iterators.  Hashmaps
+/// whose keys or values are not move-assignable (e.g., values holding a
+/// const member or a std::atomic) never resize, so their entries do not move.
 /// @tparam KTYPE type of the hashmap keys.
 /// @tparam VTYPE type of the hashmap values.
 /// @tparam KEY_COMPARE key comparison function; default is MemCmp<KTYPE>.
 /// @tparam INSERTER default is Overwriter
 /// (i.e. insertions overwrite previous values
 ///  associated to the same key, if any).
+/// @tparam LAYOUT layout of the entries of a bucket, AoSLayout (default) or
+/// SoALayout.
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE = MemCmp<KTYPE>,
-          typename INSERTER = Overwriter<VTYPE>>
+          typename INSERTER = Overwriter<VTYPE>, typename LAYOUT = AoSLayout>
 class LocalHashmap {
-  template <typename, typename, typename, typename>
+  template <typename, typename, typename, typename,
+            template <typename, typename, typename, typename> class>
   friend class Hashmap;
-  friend class lmap_iterator<LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>,
-                             const std::pair<KTYPE, VTYPE>>;
-  friend class lmap_iterator<LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>,
-                             const std::pair<KTYPE, VTYPE>>;
+  friend class lmap_iterator<LocalHashmap, const std::pair<KTYPE, VTYPE>>;
   template <typename, typename, typename>
   friend class map_iterator;
 
  public:
   using value_type = std::pair<KTYPE, VTYPE>;
-  using iterator =
-      lmap_iterator<LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>,
-                    const std::pair<KTYPE, VTYPE>>;
+  using iterator = lmap_iterator<LocalHashmap, const std::pair<KTYPE, VTYPE>>;
   using const_iterator =
-      lmap_iterator<LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>,
-                    const std::pair<KTYPE, VTYPE>>;
+      lmap_iterator<LocalHashmap, const std::pair<KTYPE, VTYPE>>;
   /// @brief Constructor.
   /// @param numInitBuckets initial number of Buckets.
   explicit LocalHashmap(const size_t numInitBuckets)
-      : numBuckets_(numInitBuckets), buckets_array_(numInitBuckets), size_(0) {}
+      : numBuckets_(numInitBuckets),
+        root_(numInitBuckets),
+        table_(&root_),
+        size_(0) {
+    PlaceBuckets(&root_);
+  }
 
   /// @brief Size of the hashmap (number of entries).
   /// @return the size of the hashmap.
   size_t Size() const { return size_.load(); }
 
+  /// @brief Memory used by the hashmap, in bytes.
+  ///
+  /// Counts the hashmap, its bucket arrays and the entries of the buckets.
+  /// Memory owned by the keys and values themselves (e.g., the elements of
+  /// a std::vector) and the overhead of the allocator are not counted.  The
+  /// method completes an ongoing resize, like PrintAllEntries.
+  ///
+  /// @return the number of bytes used by the hashmap.
+  size_t MemoryFootprint();
+
   /// @brief Insert a key-value pair in the hashmap.
   /// @param[in] key the key.
   /// @param[in] value the value to copy into the hashMap.
@@ -195,23 +371,42 @@ class LocalHashmap {
   void AsyncErase(rt::Handle &handle, const KTYPE &key);
 
   /// @brief Clear the content of the hashmap.
+  ///
+  /// The hashmap goes back to its initial number of buckets.
   void Clear() {
     size_ = 0;
-    buckets_array_.clear();
-    buckets_array_ = std::vector<Bucket>(numBuckets_);
+    grownTables_.clear();
+    root_.Reset(numBuckets_);
+    table_ = &root_;
+    PlaceBuckets(&root_);
   }
+
+  /// @brief Grow the hashmap to hold numEntries entries without chaining.
+  ///
+  /// The buckets are migrated in parallel and the method returns when the
+  /// resize is complete.  Other operations can run concurrently, but
+  /// Reserve must not be called from a ForEach function on the same hashmap.
+  /// It has no effect on hashmaps that do not resize.
+  ///
+  /// @param[in] numEntries the expected number of entries.
+  void Reserve(size_t numEntries);
+
   /// @brief Get the value associated to a key.
   /// @param[in] key the key.
   /// @param[out] res the address where to store the value,
   /// if the the key-value is found.
   /// @return true if the entry is found, false otherwise.
   bool Lookup(const KTYPE &key, VTYPE *res) {
-    VTYPE *result = Lookup(key);
+    size_t bucketIdx;
+    Bucket *bucket = AcquireBucket(key, &bucketIdx);
+    VTYPE *result = LookupInChain(bucket, key);
     if (result != nullptr) *res = *result;
+    ReleaseBucket(bucket);
     return result != nullptr;
   }
 
   /// @brief Get the value associated to a key.
+  /// @warning The pointer is invalidated when the hashmap resizes.
   /// @param[in] key the key.
   /// @return a pointer to the value if the the key-value is found
   ///         and nullptr if it does not exists.
@@ -242,10 +437,12 @@ class LocalHashmap {
   /// @param[in] key The key.
   /// @param[out] res The result of the lookup operation.
   void Lookup(const KTYPE &key, LookupResult *res) {
-    VTYPE empty;
-    VTYPE *result = Lookup(key);
+    size_t bucketIdx;
+    Bucket *bucket = AcquireBucket(key, &bucketIdx);
+    VTYPE *result = LookupInChain(bucket, key);
     if (result != nullptr) res->value = *result;
     res->found = (result != nullptr);
+    ReleaseBucket(bucket);
   }
 
   /// @brief Asynchronous lookup method.
@@ -273,10 +470,88 @@ class LocalHashmap {
   /// @param args The function arguments.
   template <typename ApplyFunT, typename... Args>
   void Apply(const KTYPE &key, ApplyFunT &&function, Args &... args) {
-    VTYPE *value = Lookup(key);
+    size_t bucketIdx;
+    Bucket *bucket = AcquireBucket(key, &bucketIdx);
+    VTYPE *value = LookupInChain(bucket, key);
     if (value != nullptr) {
       function(key, *value, args...);
     }
+    ReleaseBucket(bucket);
+  }
+
+  /// @brief Get the values associated to a batch of keys.
+  ///
+  /// Equivalent to calling Lookup(keys[i], &out[i]) for every key, but the
+  /// buckets of the following keys are prefetched while a key is looked up.
+  ///
+  /// @param[in] keys The n keys.
+  /// @param[in] n The number of keys.
+  /// @param[out] out The values of the keys that are found.
+  /// @param[out] found Whether each key is found.
+  void LookupBatch(const KTYPE *keys, size_t n, VTYPE *out, bool *found) {
+    ForEachChainInBatch(n, keys, [&](size_t i, Bucket *bucket) {
+      VTYPE *result = LookupInChain(bucket, keys[i]);
+      found[i] = (result != nullptr);
+      if (found[i]) out[i] = *result;
+    });
+  }
+
+  /// @brief Insert a batch of key-value pairs, prefetching the buckets of
+  /// the following keys while a key is inserted.
+  ///
+  /// @param[in] keys The n keys.
+  /// @param[in] values The n values to copy into the hashmap.
+  /// @param[in] n The number of key-value pairs.
+  void InsertBatch(const KTYPE *keys, const VTYPE *values, size_t n) {
+    InsertInBatch(
+        n,
+        [&](size_t first, size_t count, uint64_t *out) {
+          HashMany(keys + first, count, out);
+        },
+        [&](size_t i) -> const KTYPE & { return keys[i]; },
+        [&](size_t i) -> const VTYPE & { return values[i]; });
+  }
+
+  /// @brief Insert a batch of key-value pairs stored together.
+  ///
+  /// @tparam EntryT Type of the pairs, with key and value members (e.g.,
+  /// the entries of the Hashmap buffers).
+  ///
+  /// @param[in] entries The n key-value pairs.
+  /// @param[in] n The number of key-value pairs.
+  template <typename EntryT>
+  void InsertBatch(const EntryT *entries, size_t n) {
+    InsertInBatch(
+        n,
+        [&](size_t first, size_t count, uint64_t *out) {
+          for (size_t i = 0; i < count; ++i)
+            out[i] = shad::hash<KTYPE>{}(entries[first + i].key);
+        },
+        [&](size_t i) -> const KTYPE & { return entries[i].key; },
+        [&](size_t i) -> const VTYPE & { return entries[i].value; });
+  }
+
+  /// @brief Apply a user-defined function to the key-value pairs of a batch
+  /// of keys, prefetching the buckets of the following keys.
+  ///
+  /// @tparam ApplyFunT User-defined function type.  The function prototype
+  /// should be:
+  /// @code
+  /// void(const KTYPE&, VTYPE&, Args&);
+  /// @endcode
+  /// @tparam ...Args Types of the function arguments.
+  ///
+  /// @param[in] keys The n keys.
+  /// @param[in] n The number of keys.
+  /// @param function The function to apply to the keys that are found.
+  /// @param args The function arguments.
+  template <typename ApplyFunT, typename... Args>
+  void ApplyBatch(const KTYPE *keys, size_t n, ApplyFunT &&function,
+                  Args &... args) {
+    ForEachChainInBatch(n, keys, [&](size_t i, Bucket *bucket) {
+      VTYPE *value = LookupInChain(bucket, keys[i]);
+      if (value != nullptr) function(keys[i], *value, args...);
+    });
   }
 
   /// @brief Asynchronously apply a user-defined function to a key-value pair.
@@ -313,7 +588,7 @@ class LocalHashmap {
   /// @return SUCCESS if the function has been successfully applied, 
   /// NOT_FOUND if the key is not found, FAILED otherwise.
   template <typename ApplyFunT, typename... Args>
-  LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::ApplyResult
+  LocalHashmap::ApplyResult
   TryBlockingApply(const KTYPE &key, ApplyFunT &&function, Args &...args);
 
   /// @brief Tries to apply a user-defined function to an entry's value.
@@ -333,7 +608,7 @@ class LocalHashmap {
   /// @return SUCCESS if the function has been successfully applied, 
   /// NOT_FOUND if the key is not found, FAILED otherwise.
   template <typename ApplyFunT, typename... Args>
-  LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::ApplyResult
+  LocalHashmap::ApplyResult
   TryBlockingApplyWithRetBuff(const KTYPE &key, ApplyFunT &&function,
                               uint8_t* resultBuffer, uint32_t* resultSize,
                               Args &...args);
@@ -355,7 +630,7 @@ class LocalHashmap {
   /// @return SUCCESS if the function has been successfully applied, 
   /// NOT_FOUND if the key is not found, FAILED otherwise.
   template <typename ApplyFunT, typename RetT, typename... Args>
-  LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::ApplyResult
+  LocalHashmap::ApplyResult
   TryBlockingApplyWithRet(const KTYPE &key, ApplyFunT &&function,
                           RetT* retPtr, Args &...args);
 
@@ -428,25 +703,11 @@ class LocalHashmap {
   /// KTYPE and VTYPE
   void PrintAllEntries();
 
-  iterator begin() {
-    Entry *firstEntry = &buckets_array_[0].getEntry(0);
-    iterator cbeg(this, 0, 0, &buckets_array_[0], firstEntry);
-    if (firstEntry->state == USED) {
-      return cbeg;
-    }
-    return ++cbeg;
-  }
+  iterator begin() { return iterator::lmap_begin(this); }
 
   iterator end() { return iterator::lmap_end(numBuckets_); }
 
-  const_iterator cbegin() {
-    Entry *firstEntry = &buckets_array_[0].getEntry(0);
-    const_iterator cbeg(this, 0, 0, &buckets_array_[0], firstEntry);
-    if (firstEntry->state == USED) {
-      return cbeg;
-    }
-    return ++cbeg;
-  }
+  const_iterator cbegin() { return const_iterator::lmap_begin(this); }
 
   const_iterator cend() { return const_iterator::lmap_end(numBuckets_); }
 
@@ -458,107 +719,439 @@ class LocalHashmap {
                                         ? sizeof(KTYPE) / sizeof(uint64_t)
                                         : 1;
   static const uint8_t kHashSeed = 0;
+  // A chain of kMaxChainLength bucket arrays triggers a resize, unless the
+  // hashmap is less than 1/kMaxChainLength full (i.e., the hash is poor).
+  static const size_t kMaxChainLength = 4;
+  // Buckets migrated by each insertion while a resize is ongoing.
+  static const size_t kMigrationStep = 2;
+  static constexpr bool kResizable = std::is_move_assignable<KTYPE>::value &&
+                                     std::is_move_assignable<VTYPE>::value;
 
   typedef KEY_COMPARE KeyCompare;
 
-  enum State { EMPTY, USED, PENDING_INSERT, PENDING_UPDATE };
+  enum State : uint8_t { EMPTY, USED, PENDING_INSERT, PENDING_UPDATE };
 
-  struct Entry {
-    KTYPE key;
-    VTYPE value;
-    volatile State state;
-    Entry() : state(EMPTY) {}
+  enum Migration : uint8_t { NOT_MIGRATED, MIGRATING, MIGRATED };
+
+  using Layout = impl::EntryLayout<KTYPE, VTYPE, State, LAYOUT>;
+
+  // The key, value and state of an entry, wherever the layout stores them.
+  // A null EntryRef refers to no entry.
+  struct EntryRef {
+    KTYPE *key = nullptr;
+    VTYPE *value = nullptr;
+    volatile State *state = nullptr;
+
+    explicit operator bool() const { return state != nullptr; }
+    bool operator==(const EntryRef &other) const {
+      return state == other.state;
+    }
+    bool operator!=(const EntryRef &other) const { return !(*this == other); }
   };
 
   struct Bucket {
     std::shared_ptr<Bucket> next;
     bool isNextAllocated;
+    // Whether the chain moved to the next table, and the operations working
+    // on it.  Only used for the first bucket of each chain.
+    std::atomic<uint8_t> migration;
+    std::atomic<uint32_t> users;
 
     explicit Bucket(size_t bsize = kNumEntriesPerBucket)
         : next(nullptr),
           isNextAllocated(false),
-          entries(nullptr),
-          bucketSize_(bsize) {}
-
-    Entry &getEntry(size_t i) {
-      if (!entries) {
-        std::lock_guard<rt::Lock> _(_entriesLock);
-        if (!entries) {
-          entries = std::move(std::shared_ptr<Entry>(
-              new Entry[bucketSize_], std::default_delete<Entry[]>()));
-        }
-      }
-      return entries.get()[i];
+          migration(NOT_MIGRATED),
+          users(0),
+          bucketSize_(bsize),
+          entries(nullptr) {}
+
+    ~Bucket() { FreeEntries(); }
+
+    EntryRef getEntry(size_t i) {
+      uint8_t *block = entries.load();
+      if (block == nullptr) block = AllocateEntries();
+      return EntryRef{Layout::Key(block, bucketSize_, i),
+                      Layout::Value(block, bucketSize_, i),
+                      Layout::State(block, bucketSize_, i)};
+    }
+
+    bool HasEntries() const { return entries.load() != nullptr; }
+
+    // The entries, or nullptr if not allocated yet.  Only a hint when the
+    // chain is not acquired.
+    const void *EntriesHint() const { return entries.load(); }
+
+    void FreeEntries() {
+      next.reset();
+      uint8_t *block = entries.exchange(nullptr);
+      if (block != nullptr) impl::FreeEntries<Layout>(block, bucketSize_);
     }
 
     size_t BucketSize() const { return bucketSize_; }
 
    private:
     size_t bucketSize_;
-    std::shared_ptr<Entry> entries;
-    rt::Lock _entriesLock;
+    std::atomic<uint8_t *> entries;
+
+    // The entries are allocated on first use.  When two operations race,
+    // the block of the loser is freed.
+    uint8_t *AllocateEntries() {
+      uint8_t *block = impl::AllocateEntries<Layout>(bucketSize_, EMPTY);
+      uint8_t *expected = nullptr;
+      if (entries.compare_exchange_strong(expected, block)) return block;
+      impl::FreeEntries<Layout>(block, bucketSize_);
+      return expected;
+    }
+  };
+
+  // The buckets of the hashmap.  While a resize is ongoing, next points to
+  // the table receiving the buckets, whose size is a multiple of this one.
+  struct Table {
+    explicit Table(size_t nBuckets)
+        : numBuckets(nBuckets),
+          buckets(nBuckets),
+          next(nullptr),
+          cursor(0),
+          migrated(0) {}
+
+    void Reset(size_t nBuckets) {
+      numBuckets = nBuckets;
+      buckets.clear();
+      buckets = std::vector<Bucket>(nBuckets);
+      next = nullptr;
+      cursor = 0;
+      migrated = 0;
+    }
+
+    size_t numBuckets;
+    std::vector<Bucket> buckets;
+    std::atomic<Table *> next;
+    std::atomic<size_t> cursor;
+    std::atomic<size_t> migrated;
   };
 
   INSERTER InsertPolicy_;
   KeyCompare KeyComp_;
+  // The initial number of buckets.  Every table is a multiple of it, so that
+  // ForEach operations visit numBuckets_ disjoint slices of the buckets.
   size_t numBuckets_;
-  std::vector<Bucket> buckets_array_;
+  Table root_;
+  std::atomic<Table *> table_;
+  std::vector<std::unique_ptr<Table>> grownTables_;
+  rt::Lock resizeLock_;
   std::atomic<size_t> size_;
 
-  template <typename ApplyFunT, typename... Args, std::size_t... is>
-  static void CallForEachEntryFun(
-      const size_t i, LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
-      ApplyFunT function, std::tuple<Args...> &args,
-      std::index_sequence<is...>) {
-    Bucket *bucket = &mapPtr->buckets_array_[i];
+  // Spread the bucket array across the NUMA domains of the locality.
+  static void PlaceBuckets(Table *table) {
+    rt::impl::NumaTopology::Instance().Place(
+        table->buckets.data(), table->buckets.size() * sizeof(Bucket));
+  }
+
+  // The number of chains the calling thread uses, e.g., while it runs the
+  // function of an Apply or of a ForEach.  Those chains cannot migrate
+  // before the thread releases them.
+  static size_t &HeldChains() {
+    static thread_local size_t held = 0;
+    return held;
+  }
+
+  // Register as a user of the first bucket of a chain, unless the chain is
+  // being or has been migrated.  Returns the migration state observed.
+  static uint8_t EnterBucket(Bucket *bucket) {
+    bucket->users.fetch_add(1);
+    uint8_t state = bucket->migration.load();
+    if (state != NOT_MIGRATED)
+      bucket->users.fetch_sub(1);
+    else
+      HeldChains() += 1;
+    return state;
+  }
+
+  static void ReleaseBucket(Bucket *bucket) {
+    HeldChains() -= 1;
+    bucket->users.fetch_sub(1);
+  }
+
+  // Returns the chain holding key, following the tables it migrated to.
+  // The chain cannot migrate until ReleaseBucket is called.
+  Bucket *AcquireBucket(const KTYPE &key, size_t *bucketIdx) {
+    return AcquireHashBucket(shad::hash<KTYPE>{}(key), bucketIdx);
+  }
+
+  // The table holding the chain is stored in tablePtr, if not nullptr.
+  Bucket *AcquireHashBucket(size_t hash, size_t *bucketIdx,
+                            Table **tablePtr = nullptr) {
+    Table *table = table_.load();
+    for (;;) {
+      *bucketIdx = hash % table->numBuckets;
+      Bucket *bucket = &table->buckets[*bucketIdx];
+      uint8_t state = EnterBucket(bucket);
+      if (state == NOT_MIGRATED) {
+        if (tablePtr != nullptr) *tablePtr = table;
+        return bucket;
+      }
+      if (state == MIGRATED)
+        table = table->next.load();
+      else
+        rt::impl::yield();
+    }
+  }
+
+  // Returns the entry holding key in an acquired chain, or a null EntryRef.
+  EntryRef FindEntry(Bucket *bucket, const KTYPE &key) {
     while (bucket != nullptr) {
-      Bucket *next_bucket = bucket->next.get();
-      uint64_t j;
-      for (j = 0; j < bucket->BucketSize(); ++j) {
-        Entry *entry = &bucket->getEntry(j);
-        if (entry->state == USED) {
-          function(entry->key, entry->value, std::get<is>(args)...);
-        } else if (entry->state != EMPTY) {
+      for (size_t i = 0; i < bucket->BucketSize(); ++i) {
+        EntryRef entry = bucket->getEntry(i);
+
+        // Stop at the first empty or pending insert entry.
+        if ((*entry.state == EMPTY) or (*entry.state == PENDING_INSERT)) {
+          break;
+        }
+        // Entry is USED.
+        if (KeyComp_(entry.key, &key) == 0) return entry;
+      }
+      bucket = bucket->next.get();
+    }
+    return EntryRef();
+  }
+
+  VTYPE *LookupInChain(Bucket *bucket, const KTYPE &key) {
+    EntryRef entry = FindEntry(bucket, key);
+    if (!entry) return nullptr;
+    // wait for updates before returning
+    while (*entry.state == PENDING_UPDATE) {
+      rt::impl::yield();
+    }
+    return entry.value;
+  }
+
+  void EraseInChain(Bucket *root, const KTYPE &key);
+
+  // Returns an iterator to the entry of key, or end() if there is none.  The
+  // iterator walks the table holding the chain of key, which is the table
+  // receiving the buckets when the chain was migrated by an ongoing resize.
+  iterator FindIterator(const KTYPE &key, size_t hash) {
+    size_t bucketIdx;
+    Table *table;
+    Bucket *root = AcquireHashBucket(hash, &bucketIdx, &table);
+    for (Bucket *bucket = root; bucket != nullptr;
+         bucket = bucket->next.get()) {
+      for (size_t i = 0; i < bucket->BucketSize(); ++i) {
+        EntryRef entry = bucket->getEntry(i);
+        if (*entry.state == EMPTY || *entry.state == PENDING_INSERT) break;
+        if (KeyComp_(entry.key, &key) == 0) {
+          ReleaseBucket(root);
+          return iterator(this, table, bucketIdx, i, bucket, entry);
+        }
+      }
+    }
+    ReleaseBucket(root);
+    return end();
+  }
+
+  // Insert or update the entry of key, calling insertFn(VTYPE *, bool
+  // sameKey) on its value.
+  template <typename InsertFunT>
+  std::pair<iterator, bool> InsertEntry(const KTYPE &key, size_t hash,
+                                        InsertFunT &&insertFn);
+
+  // Prefetch the bucket of a hash.
+  void PrefetchBucket(size_t hash) {
+    Table *table = table_.load();
+    __builtin_prefetch(&table->buckets[hash % table->numBuckets]);
+  }
+
+  // Prefetch the first entries of the bucket of a hash.  Nothing is
+  // prefetched when the entries are not allocated yet.
+  void PrefetchEntries(size_t hash) {
+    Table *table = table_.load();
+    __builtin_prefetch(table->buckets[hash % table->numBuckets].EntriesHint());
+  }
+
+  // Run op(i, chain) on the acquired chain of each key of a batch.
+  template <typename ChainFunT>
+  void ForEachChainInBatch(size_t n, const KTYPE *keys, ChainFunT &&op) {
+    impl::BatchPipeline(
+        n,
+        [&](size_t first, size_t count, uint64_t *out) {
+          HashMany(keys + first, count, out);
+        },
+        [&](size_t hash) { PrefetchBucket(hash); },
+        [&](size_t hash) { PrefetchEntries(hash); },
+        [&](size_t i, size_t hash) {
+          size_t bucketIdx;
+          Bucket *bucket = AcquireHashBucket(hash, &bucketIdx);
+          op(i, bucket);
+          ReleaseBucket(bucket);
+        });
+  }
+
+  template <typename HashManyFunT, typename KeyAtT, typename ValueAtT>
+  void InsertInBatch(size_t n, HashManyFunT &&hashMany, KeyAtT &&keyAt,
+                     ValueAtT &&valueAt) {
+    impl::BatchPipeline(
+        n, hashMany, [&](size_t hash) { PrefetchBucket(hash); },
+        [&](size_t hash) { PrefetchEntries(hash); },
+        [&](size_t i, size_t hash) {
+          InsertEntry(keyAt(i), hash, [&](VTYPE *entryValue, bool sameKey) {
+            return InsertPolicy_(entryValue, valueAt(i), sameKey);
+          });
+        });
+  }
+
+  // Start a resize when the hashmap is too loaded or one of its chains too
+  // long, and take part in the ongoing one.
+  void GrowAfterInsert(size_t chainLength) {
+    if constexpr (kResizable) {
+      Table *table = table_.load();
+      size_t capacity = table->numBuckets * kNumEntriesPerBucket;
+      if (table->next.load() == nullptr &&
+          (size_.load() > capacity ||
+           (chainLength >= kMaxChainLength &&
+            size_.load() * kMaxChainLength > capacity)))
+        StartResize(table, 2 * table->numBuckets);
+      HelpResize(kMigrationStep);
+    }
+  }
+
+  void StartResize(Table *table, size_t numBuckets) {
+    std::lock_guard<rt::Lock> _(resizeLock_);
+    if (table_.load() != table || table->next.load() != nullptr) return;
+    grownTables_.emplace_back(new Table(numBuckets));
+    PlaceBuckets(grownTables_.back().get());
+    table->next.store(grownTables_.back().get());
+  }
+
+  // Move the chain of a bucket to the next table.  Returns false if the chain
+  // is in use, or if it is being or has been migrated by someone else.
+  bool MigrateBucket(Table *table, size_t bucketIdx);
+
+  void HelpResize(size_t numBuckets) {
+    Table *table = table_.load();
+    if (table->next.load() == nullptr) return;
+    for (size_t i = 0;
+         i < numBuckets && table->migrated.load() < table->numBuckets; ++i)
+      MigrateBucket(table, table->cursor.fetch_add(1) % table->numBuckets);
+  }
+
+  // Complete the ongoing resize, waiting for the chains in use.  A caller
+  // holding chains would wait for itself: it migrates the chains that are
+  // not in use instead, and the resize may be left ongoing.
+  void FinishResize() {
+    if constexpr (kResizable) {
+      if (HeldChains() != 0) {
+        Table *table = table_.load();
+        if (table->next.load() == nullptr) return;
+        for (size_t i = 0; i < table->numBuckets; ++i) MigrateBucket(table, i);
+        return;
+      }
+      for (Table *table = table_.load(); table->next.load() != nullptr;
+           table = table_.load()) {
+        for (size_t i = 0; i < table->numBuckets; ++i) {
+          while (table->buckets[i].migration.load() != MIGRATED) {
+            if (!MigrateBucket(table, i)) rt::impl::yield();
+          }
+        }
+        while (table_.load() == table) rt::impl::yield();
+      }
+    }
+  }
+
+  // The iterations walk the buckets of the table receiving the chains of an
+  // ongoing resize.  Until the chain of the previous table congruent to i is
+  // migrated, the i-th of them is that chain, for i smaller than the size of
+  // the previous table, and an empty chain otherwise.
+  static size_t NumIterationBuckets(Table *table) {
+    Table *next = table->next.load();
+    return next == nullptr ? table->numBuckets : next->numBuckets;
+  }
+
+  static Bucket *IterationBucket(Table *table, size_t i) {
+    Table *next = table->next.load();
+    if (next == nullptr) return &table->buckets[i];
+    if (i < table->numBuckets &&
+        table->buckets[i].migration.load() != MIGRATED)
+      return &table->buckets[i];
+    return &next->buckets[i];
+  }
+
+  static void MigrateFunWrapper(const std::tuple<LocalHashmap *, Table *> &args,
+                                size_t i) {
+    std::get<0>(args)->MigrateBucket(std::get<1>(args), i);
+  }
+
+  // Apply visit to the entries of the chain at bucketIdx, or of the chains it
+  // migrated to.
+  template <typename VisitFunT>
+  static void VisitBucket(Table *table, size_t bucketIdx, VisitFunT &visit) {
+    Bucket *root = &table->buckets[bucketIdx];
+    for (;;) {
+      uint8_t state = EnterBucket(root);
+      if (state == NOT_MIGRATED) break;
+      if (state == MIGRATED) {
+        Table *next = table->next.load();
+        for (size_t i = bucketIdx; i < next->numBuckets;
+             i += table->numBuckets)
+          VisitBucket(next, i, visit);
+        return;
+      }
+      rt::impl::yield();
+    }
+    for (Bucket *bucket = root; bucket != nullptr;
+         bucket = bucket->next.get()) {
+      for (size_t j = 0; j < bucket->BucketSize(); ++j) {
+        EntryRef entry = bucket->getEntry(j);
+        if (*entry.state == USED) {
+          visit(entry);
+        } else if (*entry.state != EMPTY) {
           printf(
               "Entry in PENDING state"
               " while iterating over entries\n");
         }
       }
-      bucket = next_bucket;
     }
+    ReleaseBucket(root);
+  }
+
+  // Apply visit to the entries of the i-th slice of the buckets (i.e., the
+  // buckets congruent to i modulo numBuckets_).
+  template <typename VisitFunT>
+  void ForEachInSlice(size_t i, VisitFunT &&visit) {
+    Table *table = table_.load();
+    for (size_t b = i; b < table->numBuckets; b += numBuckets_)
+      VisitBucket(table, b, visit);
+  }
+
+  template <typename ApplyFunT, typename... Args, std::size_t... is>
+  static void CallForEachEntryFun(
+      const size_t i, LocalHashmap *mapPtr,
+      ApplyFunT function, std::tuple<Args...> &args,
+      std::index_sequence<is...>) {
+    mapPtr->ForEachInSlice(i, [&](EntryRef entry) {
+      function(*entry.key, *entry.value, std::get<is>(args)...);
+    });
   }
 
   template <typename Tuple, typename... Args>
-  static void ForEachEntryFunWrapper(const Tuple &args, size_t i) {
+  static void ForEachEntryFunWrapper(const Tuple &args, size_t begin,
+                                     size_t end) {
     constexpr auto Size = std::tuple_size<
         typename std::decay<decltype(std::get<2>(args))>::type>::value;
     Tuple &tuple = const_cast<Tuple &>(args);
-    CallForEachEntryFun(i, std::get<0>(tuple), std::get<1>(tuple),
-                        std::get<2>(tuple), std::make_index_sequence<Size>{});
+    for (size_t i = begin; i < end; ++i)
+      CallForEachEntryFun(i, std::get<0>(tuple), std::get<1>(tuple),
+                          std::get<2>(tuple), std::make_index_sequence<Size>{});
   }
 
   template <typename ApplyFunT, typename... Args, std::size_t... is>
   static void AsyncCallForEachEntryFun(
       rt::Handle &handle, const size_t i,
-      LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+      LocalHashmap *mapPtr,
       ApplyFunT function, std::tuple<Args...> &args,
       std::index_sequence<is...>) {
-    Bucket *bucket = &mapPtr->buckets_array_[i];
-    while (bucket != nullptr) {
-      Bucket *next_bucket = bucket->next.get();
-      uint64_t j;
-      for (j = 0; j < bucket->BucketSize(); ++j) {
-        Entry *entry = &bucket->getEntry(j);
-        if (entry->state == USED) {
-          function(handle, entry->key, entry->value, std::get<is>(args)...);
-        } else if (entry->state != EMPTY) {
-          printf(
-              "Entry in PENDING state"
-              " while iterating over entries\n");
-        }
-      }
-      bucket = next_bucket;
-    }
+    mapPtr->ForEachInSlice(i, [&](EntryRef entry) {
+      function(handle, *entry.key, *entry.value, std::get<is>(args)...);
+    });
   }
 
   template <typename Tuple, typename... Args>
@@ -574,61 +1167,34 @@ class LocalHashmap {
 
   template <typename ApplyFunT, typename... Args, std::size_t... is>
   static void CallForEachKeyFun(
-      const size_t i, LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+      const size_t i, LocalHashmap *mapPtr,
       ApplyFunT function, std::tuple<Args...> &args,
       std::index_sequence<is...>) {
-    Bucket *buckets_array = mapPtr->buckets_array_.data();
-    Bucket *bucket = &buckets_array[i];
-    size_t cnt = 0;
-    while (bucket != nullptr) {
-      Bucket *next_bucket = bucket->next.get();
-      uint64_t j;
-      for (j = 0; j < bucket->BucketSize(); ++j) {
-        Entry *entry = &bucket->getEntry(j);
-        if (entry->state == USED) {
-          function(entry->key, std::get<is>(args)...);
-        } else if (entry->state != EMPTY) {
-          printf(
-              "Entry in PENDING state"
-              " while iterating over entries\n");
-        }
-      }
-      bucket = next_bucket;
-    }
+    mapPtr->ForEachInSlice(i, [&](EntryRef entry) {
+      function(*entry.key, std::get<is>(args)...);
+    });
   }
 
   template <typename Tuple, typename... Args>
-  static void ForEachKeyFunWrapper(const Tuple &args, size_t i) {
+  static void ForEachKeyFunWrapper(const Tuple &args, size_t begin,
+                                   size_t end) {
     constexpr auto Size = std::tuple_size<
         typename std::decay<decltype(std::get<2>(args))>::type>::value;
     Tuple &tuple = const_cast<Tuple &>(args);
-    CallForEachKeyFun(i, std::get<0>(tuple), std::get<1>(tuple),
-                      std::get<2>(tuple), std::make_index_sequence<Size>{});
+    for (size_t i = begin; i < end; ++i)
+      CallForEachKeyFun(i, std::get<0>(tuple), std::get<1>(tuple),
+                        std::get<2>(tuple), std::make_index_sequence<Size>{});
   }
 
   template <typename ApplyFunT, typename... Args, std::size_t... is>
   static void AsyncCallForEachKeyFun(
       rt::Handle &handle, const size_t i,
-      LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+      LocalHashmap *mapPtr,
       ApplyFunT function, std::tuple<Args...> &args,
       std::index_sequence<is...>) {
-    Bucket *buckets_array = mapPtr->buckets_array_.data();
-    Bucket *bucket = &buckets_array[i];
-    while (bucket != nullptr) {
-      Bucket *next_bucket = bucket->next.get();
-      uint64_t j;
-      for (j = 0; j < bucket->BucketSize(); ++j) {
-        Entry *entry = &bucket->getEntry(j);
-        if (entry->state == USED) {
-          function(handle, entry->key, std::get<is>(args)...);
-        } else if (entry->state != EMPTY) {
-          printf(
-              "Entry in PENDING state"
-              " while iterating over entries\n");
-        }
-      }
-      bucket = next_bucket;
-    }
+    mapPtr->ForEachInSlice(i, [&](EntryRef entry) {
+      function(handle, *entry.key, std::get<is>(args)...);
+    });
   }
 
   template <typename Tuple, typename... Args>
@@ -643,8 +1209,8 @@ class LocalHashmap {
   }
 
   template <typename ApplyFunT, typename... Args, std::size_t... is>
-  static LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::ApplyResult 
-  CallTryBlockingApplyFun(LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+  static LocalHashmap::ApplyResult 
+  CallTryBlockingApplyFun(LocalHashmap *mapPtr,
                            const KTYPE &key, ApplyFunT function,
                            std::tuple<Args...> &args,
                            std::index_sequence<is...>) {
@@ -652,8 +1218,8 @@ class LocalHashmap {
   }
 
   template <typename ApplyFunT, typename... Args, std::size_t... is>
-  static LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::ApplyResult 
-  CallTryBlockingApplyWithRetBuffFun(LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+  static LocalHashmap::ApplyResult 
+  CallTryBlockingApplyWithRetBuffFun(LocalHashmap *mapPtr,
                            const KTYPE &key, ApplyFunT function,
                            uint8_t* buff,
                            uint32_t * size,
@@ -665,8 +1231,8 @@ class LocalHashmap {
   }
 
   template <typename ApplyFunT, typename RetT, typename... Args, std::size_t... is>
-  static LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::ApplyResult 
-  CallTryBlockingApplyWithRetFun(LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+  static LocalHashmap::ApplyResult 
+  CallTryBlockingApplyWithRetFun(LocalHashmap *mapPtr,
                            const KTYPE &key, ApplyFunT function,
                            RetT* retPtr,
                            std::tuple<Args...> &args,
@@ -677,66 +1243,30 @@ class LocalHashmap {
   template <typename ApplyFunT, typename... Args, std::size_t... is>
   static void AsyncCallApplyFun(
       rt::Handle &handle,
-      LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+      LocalHashmap *mapPtr,
       const KTYPE &key, ApplyFunT function, std::tuple<Args...> &args,
       std::index_sequence<is...>) {
-    size_t bucketIdx = shad::hash<KTYPE>{}(key) % mapPtr->numBuckets_;
-    Bucket *bucket = &(mapPtr->buckets_array_[bucketIdx]);
-
-    while (bucket != nullptr) {
-      for (size_t i = 0; i < bucket->BucketSize(); ++i) {
-        Entry *entry = &bucket->getEntry(i);
-
-        // Stop at the first empty or pending insert entries.
-        if ((entry->state == EMPTY) or (entry->state == PENDING_INSERT)) {
-          break;
-        }
-        // Entry is USED.
-        if (mapPtr->KeyComp_(&entry->key, &key) == 0) {
-          // wait for updates before returning
-          while (entry->state == PENDING_UPDATE) {
-            rt::impl::yield();
-          }
-          function(handle, key, entry->value, std::get<is>(args)...);
-          return;
-        }
-      }
-
-      bucket = bucket->next.get();
+    size_t bucketIdx;
+    Bucket *bucket = mapPtr->AcquireBucket(key, &bucketIdx);
+    VTYPE *value = mapPtr->LookupInChain(bucket, key);
+    if (value != nullptr) {
+      function(handle, key, *value, std::get<is>(args)...);
     }
-    return;
+    ReleaseBucket(bucket);
   }
 
   template <typename ApplyFunT, typename... Args, std::size_t... is>
   static void CallApplyFun(
-      LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *mapPtr,
+      LocalHashmap *mapPtr,
       const KTYPE &key, ApplyFunT function, std::tuple<Args...> &args,
       std::index_sequence<is...>) {
-    size_t bucketIdx = shad::hash<KTYPE>{}(key) % mapPtr->numBuckets_;
-    Bucket *bucket = &(mapPtr->buckets_array_[bucketIdx]);
-
-    while (bucket != nullptr) {
-      for (size_t i = 0; i < bucket->BucketSize(); ++i) {
-        Entry *entry = &bucket->getEntry(i);
-
-        // Stop at the first empty or pending insert entry.
-        if ((entry->state == EMPTY) or (entry->state == PENDING_INSERT)) {
-          break;
-        }
-        // Entry is USED.
-        if (mapPtr->KeyComp_(&entry->key, &key) == 0) {
-          // wait for updates before returning
-          while (entry->state == PENDING_UPDATE) {
-            rt::impl::yield();
-          }
-          function(key, entry->value, std::get<is>(args)...);
-          return;
-        }
-      }
-
-      bucket = bucket->next.get();
+    size_t bucketIdx;
+    Bucket *bucket = mapPtr->AcquireBucket(key, &bucketIdx);
+    VTYPE *value = mapPtr->LookupInChain(bucket, key);
+    if (value != nullptr) {
+      function(key, *value, std::get<is>(args)...);
     }
-    return;
+    ReleaseBucket(bucket);
   }
 
   template <typename Tuple, typename... Args>
@@ -750,56 +1280,128 @@ class LocalHashmap {
   }
 };
 
+/// @brief LocalHashmap storing its entries with the SoALayout.
+///
+/// It can be used as the local map of a Hashmap, e.g.:
+/// @code
+/// Hashmap<uint32_t, uint64_t, MemCmp<uint32_t>, Overwriter<uint64_t>,
+///         LocalSoAHashmap>
+/// @endcode
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE = MemCmp<KTYPE>,
+          typename INSERTER = Overwriter<VTYPE>>
+using LocalSoAHashmap =
+    LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, SoALayout>;
+
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
-VTYPE *LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::Lookup(
+          typename INSERTER, typename LAYOUT>
+VTYPE *LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::Lookup(
     const KTYPE &key) {
-  size_t bucketIdx = shad::hash<KTYPE>{}(key) % numBuckets_;
-  Bucket *bucket = &(buckets_array_[bucketIdx]);
+  size_t bucketIdx;
+  Bucket *bucket = AcquireBucket(key, &bucketIdx);
+  VTYPE *result = LookupInChain(bucket, key);
+  ReleaseBucket(bucket);
+  return result;
+}
 
-  VTYPE *result = nullptr;
-  while (bucket != nullptr && result == nullptr) {
-    for (size_t i = 0; i < bucket->BucketSize(); ++i) {
-      Entry *entry = &bucket->getEntry(i);
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER, typename LAYOUT>
+void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::Reserve(
+    size_t numEntries) {
+  if constexpr (kResizable) {
+    size_t numBuckets =
+        (numEntries + kNumEntriesPerBucket - 1) / kNumEntriesPerBucket;
+    for (;;) {
+      FinishResize();
+      Table *table = table_.load();
+      // Left ongoing by a caller holding chains.
+      if (table->next.load() != nullptr) return;
+      size_t newNumBuckets = table->numBuckets;
+      while (newNumBuckets < numBuckets) newNumBuckets *= 2;
+      if (newNumBuckets == table->numBuckets) return;
+
+      StartResize(table, newNumBuckets);
+      rt::forEachAt(rt::thisLocality(), MigrateFunWrapper,
+                    std::tuple<LocalHashmap *, Table *>(this, table),
+                    table->numBuckets);
+    }
+  }
+}
 
-      // Stop at the first empty or pending insert entry.
-      if ((entry->state == EMPTY) or (entry->state == PENDING_INSERT)) {
-        break;
-      }
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER, typename LAYOUT>
+bool LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::MigrateBucket(
+    Table *table, size_t bucketIdx) {
+  Bucket *root = &table->buckets[bucketIdx];
+  uint8_t expected = NOT_MIGRATED;
+  if (!root->migration.compare_exchange_strong(expected, MIGRATING))
+    return false;
+  // Operations register as users before checking the migration state, so
+  // either they see MIGRATING or we see them.
+  if (root->users.load() != 0) {
+    root->migration.store(NOT_MIGRATED);
+    return false;
+  }
 
-      // Entry is USED.
-      if (KeyComp_(&entry->key, &key) == 0) {
-        // wait for updates before returning
-        while (entry->state == PENDING_UPDATE) {
-          rt::impl::yield();
+  // The chains of the next table congruent to bucketIdx only receive entries
+  // from this chain, and nobody uses them before it is marked as MIGRATED.
+  Table *next = table->next.load();
+  for (Bucket *bucket = root; bucket != nullptr && bucket->HasEntries();
+       bucket = bucket->next.get()) {
+    for (size_t i = 0; i < bucket->BucketSize(); ++i) {
+      EntryRef entry = bucket->getEntry(i);
+      if (*entry.state != USED) continue;
+
+      Bucket *dest =
+          &next->buckets[shad::hash<KTYPE>{}(*entry.key) % next->numBuckets];
+      for (size_t j = 0;; ++j) {
+        if (j == dest->BucketSize()) {
+          if (dest->next == nullptr) {
+            dest->next.reset(new Bucket(kNumEntriesPerBucket));
+            dest->isNextAllocated = true;
+          }
+          dest = dest->next.get();
+          j = 0;
+        }
+        EntryRef destEntry = dest->getEntry(j);
+        if (*destEntry.state == EMPTY) {
+          *destEntry.key = std::move(*entry.key);
+          *destEntry.value = std::move(*entry.value);
+          *destEntry.state = USED;
+          break;
         }
-        result = &entry->value;
       }
     }
-
-    bucket = bucket->next.get();
   }
-  return result;
+  root->FreeEntries();
+  root->migration.store(MIGRATED);
+
+  if (table->migrated.fetch_add(1) + 1 == table->numBuckets)
+    table_.store(next);
+  return true;
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
-void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::PrintAllEntries() {
-  for (size_t bucketIdx = 0; bucketIdx < numBuckets_; bucketIdx++) {
+          typename INSERTER, typename LAYOUT>
+void
+LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::PrintAllEntries() {
+  FinishResize();
+  Table *table = table_.load();
+  for (size_t bucketIdx = 0; bucketIdx < NumIterationBuckets(table);
+       bucketIdx++) {
     size_t pos = 0;
-    Bucket *bucket = &(buckets_array_[bucketIdx]);
+    Bucket *bucket = IterationBucket(table, bucketIdx);
     std::cout << "Bucket: " << bucketIdx << std::endl;
     while (bucket != nullptr) {
       for (size_t i = 0; i < bucket->BucketSize(); ++i, ++pos) {
-        Entry *entry = &bucket->getEntry(i);
+        EntryRef entry = bucket->getEntry(i);
         // Stop at the first empty entry.
-        if (entry->state == EMPTY) break;
+        if (*entry.state == EMPTY) break;
         // Yield on pending entries.
-        while (entry->state == PENDING_INSERT ||
-               entry->state == PENDING_UPDATE) {
+        while (*entry.state == PENDING_INSERT ||
+               *entry.state == PENDING_UPDATE) {
           rt::impl::yield();
         }
-        std::cout << pos << ": [" << entry->key << "] [" << entry->value
+        std::cout << pos << ": [" << *entry.key << "] [" << *entry.value
                   << "]\n";
       }
       bucket = bucket->next.get();
@@ -808,44 +1410,70 @@ void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::PrintAllEntries() {
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
-void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::Erase(
+          typename INSERTER, typename LAYOUT>
+size_t
+LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::MemoryFootprint() {
+  FinishResize();
+  std::lock_guard<rt::Lock> _(resizeLock_);
+  size_t bytes = sizeof(*this) + root_.buckets.capacity() * sizeof(Bucket);
+  // The tables left behind by the resizes only keep their bucket arrays.
+  for (auto &table : grownTables_)
+    bytes += sizeof(Table) + table->buckets.capacity() * sizeof(Bucket);
+  // The migrated chains of a resize left ongoing hold no entries.
+  for (Table *table = table_.load(); table != nullptr;
+       table = table->next.load()) {
+    for (Bucket &root : table->buckets) {
+      for (Bucket *bucket = &root; bucket != nullptr;
+           bucket = bucket->next.get()) {
+        if (bucket != &root) bytes += sizeof(Bucket);
+        if (bucket->HasEntries()) bytes += Layout::Bytes(bucket->BucketSize());
+      }
+    }
+  }
+  return bytes;
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER, typename LAYOUT>
+void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::Erase(
     const KTYPE &key) {
-  size_t bucketIdx = shad::hash<KTYPE>{}(key) % numBuckets_;
-  Bucket *bucket = &(buckets_array_[bucketIdx]);
-  Entry *prevEntry = nullptr;
-  Entry *toDelete = nullptr;
-  Entry *lastEntry = nullptr;
-  auto printEntryState = [](size_t num, Entry *todel, Entry *last,
-                            Entry *prev) {
-    size_t tds = todel->state, ls = 42, ps = 42;
-    if (last != nullptr) ls = last->state;
-    if (prev != nullptr) ps = prev->state;
-    printf("loop %lu, todel-s: %lu, last-s: %lu, prev-s: %lu\n", num, tds, ls,
-           ps);
-  };
+  size_t bucketIdx;
+  Bucket *bucket = AcquireBucket(key, &bucketIdx);
+  EraseInChain(bucket, key);
+  ReleaseBucket(bucket);
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER, typename LAYOUT>
+void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::EraseInChain(
+    Bucket *root, const KTYPE &key) {
+  Bucket *bucket = root;
+  EntryRef prevEntry;
+  EntryRef toDelete;
+  EntryRef lastEntry;
   for (;;) {
     for (size_t i = 0; i < bucket->BucketSize(); ++i) {
-      Entry *entry = &bucket->getEntry(i);
+      EntryRef entry = bucket->getEntry(i);
 
       // 1. Key not found, returning
-      if (entry->state == EMPTY) {
-        if (toDelete != nullptr)
+      if (*entry.state == EMPTY) {
+        if (toDelete)
           throw std::logic_error(
               "A problem occured with"
               "the map erase operation");
         break;
       }
-      while (entry->state == PENDING_INSERT) {
+      while (*entry.state == PENDING_INSERT) {
         rt::impl::yield();
       }
 
-      if (KeyComp_(&entry->key, &key) == 0) {
+      if (KeyComp_(entry.key, &key) == 0) {
         // 2. Key found, try to acquire a lock on it
-        if (!__sync_bool_compare_and_swap(&entry->state, USED,
+        if (!__sync_bool_compare_and_swap(entry.state, USED,
                                           PENDING_INSERT)) {
           // entry has already been deleted by another operation
-          Erase(key);
+          EraseInChain(root, key);
+          return;
         }
         // 3. The entry to remove has been found,
         // and its status set to PENDING_INSERT
@@ -858,13 +1486,13 @@ void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::Erase(
         for (;;) {
           size_t numBuck = 0;
           for (; j < bucket->BucketSize(); ++j) {
-            lastEntry = &bucket->getEntry(j);
-            if (__sync_bool_compare_and_swap(&lastEntry->state, EMPTY,
+            lastEntry = bucket->getEntry(j);
+            if (__sync_bool_compare_and_swap(lastEntry.state, EMPTY,
                                              PENDING_INSERT)) {
               // 3. Last entry found (EMPTY->PENDING)
               if (prevEntry == toDelete) {  // just set it to EMPTY and return;
-                lastEntry->state = EMPTY;
-                toDelete->state = EMPTY;
+                *lastEntry.state = EMPTY;
+                *toDelete.state = EMPTY;
                 return;
               }
               // STATUS:
@@ -872,31 +1500,30 @@ void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::Erase(
               // lastEntry found and status is PENDING_INSERT
               // need to find prevEntry
 
-              if (!__sync_bool_compare_and_swap(&prevEntry->state, USED,
+              if (!__sync_bool_compare_and_swap(prevEntry.state, USED,
                                                 PENDING_INSERT)) {
-                // printEntryState(2, toDelete, lastEntry, prevEntry);
                 rt::impl::yield();
-                lastEntry->state = EMPTY;
-                toDelete->state = USED;
+                *lastEntry.state = EMPTY;
+                *toDelete.state = USED;
                 size_++;
-                Erase(key);
+                EraseInChain(root, key);
                 return;
               }
               // now prevEntry is locked
               // 4. free the last entry
-              lastEntry->state = EMPTY;
+              *lastEntry.state = EMPTY;
               // move prevEntry into toDelete
-              toDelete->key = std::move(prevEntry->key);
-              toDelete->value = std::move(prevEntry->value);
-              toDelete->state = USED;
+              *toDelete.key = std::move(*prevEntry.key);
+              *toDelete.value = std::move(*prevEntry.value);
+              *toDelete.state = USED;
               // free prevEntry
-              prevEntry->state = EMPTY;
+              *prevEntry.state = EMPTY;
               return;
             } else {
-              if (lastEntry->state == PENDING_INSERT) {
-                toDelete->state = USED;
+              if (*lastEntry.state == PENDING_INSERT) {
+                *toDelete.state = USED;
                 size_++;
-                Erase(key);
+                EraseInChain(root, key);
                 return;
               }
             }
@@ -908,54 +1535,32 @@ void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::Erase(
             bucket = bucket->next.get();
           } else {
             // STATUS last entry is not empty and has not been locked
-            if (lastEntry == nullptr) {
+            if (!lastEntry) {
               // toDelete has not been found or
               // it is the last entry at the end of the last bucket
-              if (toDelete != nullptr) toDelete->state = EMPTY;
+              if (toDelete) *toDelete.state = EMPTY;
               return;
             }
-            if (!__sync_bool_compare_and_swap(&lastEntry->state, USED,
+            if (!__sync_bool_compare_and_swap(lastEntry.state, USED,
                                               PENDING_INSERT)) {
-              toDelete->state = USED;
+              *toDelete.state = USED;
               size_++;
-              Erase(key);
+              EraseInChain(root, key);
               return;
             }
-            if (lastEntry == prevEntry) {
-              if (toDelete == prevEntry) {
-                // No move is necessary, just set to EMPTY
-                lastEntry->state = EMPTY;
-                toDelete->state = EMPTY;
-                return;
-              } else {
-                toDelete->key = std::move(lastEntry->key);
-                toDelete->value = std::move(lastEntry->value);
-                toDelete->state = USED;
-                lastEntry->state = EMPTY;
-                return;
-              }
-            } else {
-              // FIXME check if this state is reachable
-              if (toDelete == prevEntry) {
-                toDelete->key = std::move(lastEntry->key);
-                toDelete->value = std::move(lastEntry->value);
-                toDelete->state = USED;
-                lastEntry->state = EMPTY;
-                return;
-              } else {
-                // Need to lock prev entry as well
-                while (!__sync_bool_compare_and_swap(&prevEntry->state, USED,
-                                                     PENDING_INSERT)) {
-                  rt::impl::yield();
-                  printEntryState(6, toDelete, lastEntry, prevEntry);
-                }
-                lastEntry->state = EMPTY;
-                toDelete->key = std::move(prevEntry->key);
-                toDelete->value = std::move(prevEntry->value);
-                toDelete->state = USED;
-                prevEntry->state = EMPTY;
-              }
+            // The scan ended on the last entry of the chain, which is the
+            // previous one of every entry it went through.
+            assert(lastEntry == prevEntry);
+            if (toDelete == lastEntry) {
+              // No move is necessary, just set to EMPTY
+              *lastEntry.state = EMPTY;
+              *toDelete.state = EMPTY;
+              return;
             }
+            *toDelete.key = std::move(*lastEntry.key);
+            *toDelete.value = std::move(*lastEntry.value);
+            *toDelete.state = USED;
+            *lastEntry.state = EMPTY;
             return;
           }
         }
@@ -965,9 +1570,8 @@ void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::Erase(
     if (bucket->next != nullptr) {
       bucket = bucket->next.get();
     } else {
-      VTYPE v;
-      if (Lookup(key, &v)) {
-        Erase(key);
+      if (LookupInChain(root, key) != nullptr) {
+        EraseInChain(root, key);
       }
       break;
     }
@@ -975,10 +1579,10 @@ void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::Erase(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
-void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncErase(
+          typename INSERTER, typename LAYOUT>
+void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::AsyncErase(
     rt::Handle &handle, const KTYPE &key) {
-  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT> *;
   auto args = std::tuple<LMapPtr, KTYPE>(this, key);
   auto eraseLambda = [](rt::Handle &, const std::tuple<LMapPtr, KTYPE> &t) {
     (std::get<0>(t))->Erase(std::get<1>(t));
@@ -987,50 +1591,74 @@ void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncErase(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
-std::pair<typename LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::iterator,
+          typename INSERTER, typename LAYOUT>
+std::pair<typename LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER,
+                                LAYOUT>::iterator,
           bool>
-LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::Insert(const KTYPE &key,
-                                                          const VTYPE &value) {
+LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::Insert(
+    const KTYPE &key, const VTYPE &value) {
   return Insert(InsertPolicy_, key, value);
 }
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
+          typename INSERTER, typename LAYOUT>
 template <typename FUNTYPE>
-std::pair<typename LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::iterator,
+std::pair<typename LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER,
+                                LAYOUT>::iterator,
           bool>
-LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::Insert(FUNTYPE &insfun,
-                                                          const KTYPE &key,
-                                                          const VTYPE &value) {
-  size_t bucketIdx = shad::hash<KTYPE>{}(key) % numBuckets_;
-  Bucket *bucket = &(buckets_array_[bucketIdx]);
+LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::Insert(
+    FUNTYPE &insfun, const KTYPE &key, const VTYPE &value) {
+  size_t hash = shad::hash<KTYPE>{}(key);
+  return InsertEntry(key, hash, [&](VTYPE *entryValue, bool sameKey) {
+    return insfun(entryValue, value, sameKey);
+  });
+}
+
+template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
+          typename INSERTER, typename LAYOUT>
+template <typename InsertFunT>
+std::pair<typename LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER,
+                                LAYOUT>::iterator,
+          bool>
+LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::InsertEntry(
+    const KTYPE &key, size_t hash, InsertFunT &&insertFn) {
+  size_t bucketIdx;
+  Table *table;
+  Bucket *root = AcquireHashBucket(hash, &bucketIdx, &table);
+  Bucket *bucket = root;
+  size_t chainLength = 1;
 
   // Forever or until we find an insertion point.
   for (;;) {
     for (size_t i = 0; i < bucket->BucketSize(); ++i) {
-      Entry *entry = &bucket->getEntry(i);
+      EntryRef entry = bucket->getEntry(i);
 
-      if (__sync_bool_compare_and_swap(&entry->state, EMPTY, PENDING_INSERT)) {
+      if (__sync_bool_compare_and_swap(entry.state, EMPTY, PENDING_INSERT)) {
         // First time insertion.
-        entry->key = std::move(key);
-        bool inserted = insfun(&entry->value, value, false);
+        *entry.key = std::move(key);
+        bool inserted = insertFn(entry.value, false);
         size_ += 1;
-        entry->state = USED;
-        return std::make_pair(iterator(this, bucketIdx, i, bucket, entry),
-                              inserted);
+        *entry.state = USED;
+        ReleaseBucket(root);
+        GrowAfterInsert(chainLength);
+        // Growing may have migrated the chain and freed the entry.
+        if (root->migration.load() != NOT_MIGRATED)
+          return std::make_pair(FindIterator(key, hash), inserted);
+        return std::make_pair(
+            iterator(this, table, bucketIdx, i, bucket, entry), inserted);
       } else {
         // Update of an existing entry
-        while (entry->state == PENDING_INSERT) rt::impl::yield();
+        while (*entry.state == PENDING_INSERT) rt::impl::yield();
 
-        if (KeyComp_(&entry->key, &key) == 0) {
-          while (!__sync_bool_compare_and_swap(&entry->state, USED,
+        if (KeyComp_(entry.key, &key) == 0) {
+          while (!__sync_bool_compare_and_swap(entry.state, USED,
                                                PENDING_UPDATE))
             rt::impl::yield();
 
-          auto inserted = insfun(&entry->value, value, true);
-          entry->state = USED;
-          return std::make_pair(iterator(this, bucketIdx, i, bucket, entry),
-                                inserted);
+          bool inserted = insertFn(entry.value, true);
+          *entry.state = USED;
+          ReleaseBucket(root);
+          return std::make_pair(
+              iterator(this, table, bucketIdx, i, bucket, entry), inserted);
         }
       }
     }
@@ -1049,74 +1677,35 @@ LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::Insert(FUNTYPE &insfun,
     }
 
     bucket = bucket->next.get();
+    ++chainLength;
   }
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
-inline void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncInsert(
+          typename INSERTER, typename LAYOUT>
+inline void
+LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::AsyncInsert(
     rt::Handle &handle, const KTYPE &key, const VTYPE &value) {
   AsyncInsert(handle, InsertPolicy_, key, value);
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
+          typename INSERTER, typename LAYOUT>
 template <typename FUNTYPE>
-void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncInsert(
+void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::AsyncInsert(
     rt::Handle &handle, FUNTYPE &insfun,
     const KTYPE &key, const VTYPE &value) {
-  size_t bucketIdx = shad::hash<KTYPE>{}(key) % numBuckets_;
-  Bucket *bucket = &(buckets_array_[bucketIdx]);
-
-  // Forever or until we find an insertion point.
-  for (;;) {
-    for (size_t i = 0; i < bucket->BucketSize(); ++i) {
-      Entry *entry = &bucket->getEntry(i);
-      if (__sync_bool_compare_and_swap(&entry->state, EMPTY, PENDING_INSERT)) {
-        // First time insertion.
-        entry->key = std::move(key);
-        bool inserted = insfun(handle, &entry->value, value, false);
-        size_ += 1;
-        entry->state = USED;
-        return;
-      } else {
-        // Update of an existing entry
-        while (entry->state == PENDING_INSERT) rt::impl::yield();
-
-        if (KeyComp_(&entry->key, &key) == 0) {
-          while (!__sync_bool_compare_and_swap(&entry->state, USED,
-                                               PENDING_UPDATE))
-            rt::impl::yield();
-
-          auto inserted = insfun(handle, &entry->value, value, true);
-          entry->state = USED;
-          return;
-        }
-      }
-    }
-
-    if (bucket->next == nullptr) {
-      // We need to allocate a new buffer
-      if (__sync_bool_compare_and_swap(&bucket->isNextAllocated, false, true)) {
-        // Allocate the bucket
-        std::shared_ptr<Bucket> newBucket(
-            new Bucket(constants::kDefaultNumEntriesPerBucket));
-        bucket->next.swap(newBucket);
-      } else {
-        // Wait for the allocation to happen
-        while (bucket->next == nullptr) rt::impl::yield();
-      }
-    }
-
-    bucket = bucket->next.get();
-  }
+  size_t hash = shad::hash<KTYPE>{}(key);
+  InsertEntry(key, hash, [&](VTYPE *entryValue, bool sameKey) {
+    return insfun(handle, entryValue, value, sameKey);
+  });
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
-void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncLookup(
+          typename INSERTER, typename LAYOUT>
+void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::AsyncLookup(
     rt::Handle &handle, const KTYPE &key, VTYPE **result) {
-  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT> *;
   auto args = std::tuple<LMapPtr, KTYPE, VTYPE **>(this, key, result);
   auto lookupLambda = [](rt::Handle &,
                          const std::tuple<LMapPtr, KTYPE, VTYPE **> &t) {
@@ -1126,10 +1715,10 @@ void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncLookup(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
-void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncLookup(
+          typename INSERTER, typename LAYOUT>
+void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::AsyncLookup(
     rt::Handle &handle, const KTYPE &key, LookupResult *result) {
-  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT> *;
   auto args = std::tuple<LMapPtr, KTYPE, LookupResult *>(this, key, result);
   auto lookupLambda = [](rt::Handle &,
                          const std::tuple<LMapPtr, KTYPE, LookupResult *> &t) {
@@ -1139,27 +1728,29 @@ void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncLookup(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
+          typename INSERTER, typename LAYOUT>
 template <typename ApplyFunT, typename... Args>
-void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::ForEachEntry(
+void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::ForEachEntry(
     ApplyFunT &&function, Args &... args) {
   using FunctionTy = void (*)(const KTYPE &, VTYPE &, Args &...);
   FunctionTy fn = std::forward<decltype(function)>(function);
-  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT> *;
   using ArgsTuple = std::tuple<LMapPtr, FunctionTy, std::tuple<Args...>>;
   ArgsTuple argsTuple(this, fn, std::tuple<Args...>(args...));
-  rt::forEachAt(rt::thisLocality(), ForEachEntryFunWrapper<ArgsTuple, Args...>,
-                argsTuple, numBuckets_);
+  rt::forEachRangeAt(rt::thisLocality(),
+                     ForEachEntryFunWrapper<ArgsTuple, Args...>, argsTuple,
+                     numBuckets_);
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
+          typename INSERTER, typename LAYOUT>
 template <typename ApplyFunT, typename... Args>
-void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncForEachEntry(
+void
+LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::AsyncForEachEntry(
     rt::Handle &handle, ApplyFunT &&function, Args &... args) {
   using FunctionTy = void (*)(rt::Handle &, const KTYPE &, VTYPE &, Args &...);
   FunctionTy fn = std::forward<decltype(function)>(function);
-  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT> *;
   using ArgsTuple = std::tuple<LMapPtr, FunctionTy, std::tuple<Args...>>;
   ArgsTuple argsTuple(this, fn, std::tuple<Args...>(args...));
   rt::asyncForEachAt(handle, rt::thisLocality(),
@@ -1168,29 +1759,30 @@ void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncForEachEntry(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
+          typename INSERTER, typename LAYOUT>
 template <typename ApplyFunT, typename... Args>
-void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::ForEachKey(
+void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::ForEachKey(
     ApplyFunT &&function, Args &... args) {
   using FunctionTy = void (*)(const KTYPE &, Args &...);
   FunctionTy fn = std::forward<decltype(function)>(function);
 
-  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT> *;
   using ArgsTuple = std::tuple<LMapPtr, FunctionTy, std::tuple<Args...>>;
   ArgsTuple argsTuple(this, fn, std::tuple<Args...>(args...));
 
-  rt::forEachAt(rt::thisLocality(), ForEachKeyFunWrapper<ArgsTuple, Args...>,
-                argsTuple, numBuckets_);
+  rt::forEachRangeAt(rt::thisLocality(),
+                     ForEachKeyFunWrapper<ArgsTuple, Args...>, argsTuple,
+                     numBuckets_);
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
+          typename INSERTER, typename LAYOUT>
 template <typename ApplyFunT, typename... Args>
-void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncForEachKey(
+void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::AsyncForEachKey(
     rt::Handle &handle, ApplyFunT &&function, Args &... args) {
   using FunctionTy = void (*)(rt::Handle &, const KTYPE &, Args &...);
   FunctionTy fn = std::forward<decltype(function)>(function);
-  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT> *;
   using ArgsTuple = std::tuple<LMapPtr, FunctionTy, std::tuple<Args...>>;
   ArgsTuple argsTuple(this, fn, std::tuple<Args...>(args...));
   rt::asyncForEachAt(handle, rt::thisLocality(),
@@ -1199,14 +1791,14 @@ void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncForEachKey(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
+          typename INSERTER, typename LAYOUT>
 template <typename ApplyFunT, typename... Args>
-void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncApply(
+void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::AsyncApply(
     rt::Handle &handle, const KTYPE &key, ApplyFunT &&function,
     Args &... args) {
   using FunctionTy = void (*)(rt::Handle &, const KTYPE &, VTYPE &, Args &...);
   FunctionTy fn = std::forward<decltype(function)>(function);
-  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT> *;
   using ArgsTuple =
       std::tuple<LMapPtr, const KTYPE, FunctionTy, std::tuple<Args...>>;
 
@@ -1216,180 +1808,109 @@ void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncApply(
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
+          typename INSERTER, typename LAYOUT>
 template <typename ApplyFunT, typename... Args>
-typename LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::ApplyResult 
-LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::TryBlockingApply(
+typename LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::ApplyResult 
+LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::TryBlockingApply(
                                                   const KTYPE &key,
                                                   ApplyFunT &&function,
                                                   Args &...args) {
-  size_t bucketIdx = shad::hash<KTYPE>{}(key) % numBuckets_;
-  Bucket *bucket = &(buckets_array_[bucketIdx]);
-  while (bucket != nullptr) {
-    for (size_t i = 0; i < bucket->BucketSize(); ++i) {
-      Entry *entry = &bucket->getEntry(i);
-
-      // Stop at the first empty or pending insert entry.
-      if ((entry->state == EMPTY) or (entry->state == PENDING_INSERT)) {
-        break;
-      }
-
-      // Entry is USED.
-      if (KeyComp_(&entry->key, &key) == 0) {
-        // try to tag as pending update
-        if (!__sync_bool_compare_and_swap(&entry->state, USED,
-                                             PENDING_UPDATE)) {
-          return ApplyResult::FAILED;
-        }
-        function(key, entry->value, args...);
-        entry->state = USED;
-        return ApplyResult::SUCCESS;
-      }
+  size_t bucketIdx;
+  Bucket *bucket = AcquireBucket(key, &bucketIdx);
+  EntryRef entry = FindEntry(bucket, key);
+  ApplyResult result = ApplyResult::NOT_FOUND;
+  if (entry) {
+    // try to tag as pending update
+    if (__sync_bool_compare_and_swap(entry.state, USED, PENDING_UPDATE)) {
+      function(key, *entry.value, args...);
+      *entry.state = USED;
+      result = ApplyResult::SUCCESS;
+    } else {
+      result = ApplyResult::FAILED;
     }
-    bucket = bucket->next.get();
   }
-  return ApplyResult::NOT_FOUND;
+  ReleaseBucket(bucket);
+  return result;
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
+          typename INSERTER, typename LAYOUT>
 template <typename ApplyFunT, typename... Args>
-typename LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::ApplyResult 
-LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::TryBlockingApplyWithRetBuff(
+typename LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::ApplyResult 
+LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::
+TryBlockingApplyWithRetBuff(
                                                   const KTYPE &key,
                                                   ApplyFunT &&function,
                                                   uint8_t* resultBuffer,
                                                   uint32_t* resultSize,
                                                   Args &...args) {
-  size_t bucketIdx = shad::hash<KTYPE>{}(key) % numBuckets_;
-  Bucket *bucket = &(buckets_array_[bucketIdx]);
-  while (bucket != nullptr) {
-    for (size_t i = 0; i < bucket->BucketSize(); ++i) {
-      Entry *entry = &bucket->getEntry(i);
-
-      // Stop at the first empty or pending insert entry.
-      if ((entry->state == EMPTY) or (entry->state == PENDING_INSERT)) {
-        break;
-      }
-
-      // Entry is USED.
-      if (KeyComp_(&entry->key, &key) == 0) {
-        // try to tag as pending update
-        if (!__sync_bool_compare_and_swap(&entry->state, USED,
-                                             PENDING_UPDATE)) {
-          return ApplyResult::FAILED;
-        }
-        function(key, entry->value, resultBuffer, resultSize, args...);
-        entry->state = USED;
-        return ApplyResult::SUCCESS;
-      }
+  size_t bucketIdx;
+  Bucket *bucket = AcquireBucket(key, &bucketIdx);
+  EntryRef entry = FindEntry(bucket, key);
+  ApplyResult result = ApplyResult::NOT_FOUND;
+  if (entry) {
+    // try to tag as pending update
+    if (__sync_bool_compare_and_swap(entry.state, USED, PENDING_UPDATE)) {
+      function(key, *entry.value, resultBuffer, resultSize, args...);
+      *entry.state = USED;
+      result = ApplyResult::SUCCESS;
+    } else {
+      result = ApplyResult::FAILED;
     }
-    bucket = bucket->next.get();
   }
-  return ApplyResult::NOT_FOUND;
+  ReleaseBucket(bucket);
+  return result;
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
+          typename INSERTER, typename LAYOUT>
 template <typename ApplyFunT, typename RetT, typename... Args>
-typename LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::ApplyResult 
-LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::TryBlockingApplyWithRet(
+typename LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::ApplyResult 
+LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::
+TryBlockingApplyWithRet(
                                                   const KTYPE &key,
                                                   ApplyFunT &&function,
                                                   RetT* resultPtr,
                                                   Args &...args) {
-  size_t bucketIdx = shad::hash<KTYPE>{}(key) % numBuckets_;
-  Bucket *bucket = &(buckets_array_[bucketIdx]);
-  while (bucket != nullptr) {
-    for (size_t i = 0; i < bucket->BucketSize(); ++i) {
-      Entry *entry = &bucket->getEntry(i);
-
-      // Stop at the first empty or pending insert entry.
-      if ((entry->state == EMPTY) or (entry->state == PENDING_INSERT)) {
-        break;
-      }
-
-      // Entry is USED.
-      if (KeyComp_(&entry->key, &key) == 0) {
-        // try to tag as pending update
-        if (!__sync_bool_compare_and_swap(&entry->state, USED,
-                                             PENDING_UPDATE)) {
-          return ApplyResult::FAILED;
-        }
-        function(key, entry->value, resultPtr, args...);
-        entry->state = USED;
-        return ApplyResult::SUCCESS;
-      }
+  size_t bucketIdx;
+  Bucket *bucket = AcquireBucket(key, &bucketIdx);
+  EntryRef entry = FindEntry(bucket, key);
+  ApplyResult result = ApplyResult::NOT_FOUND;
+  if (entry) {
+    // try to tag as pending update
+    if (__sync_bool_compare_and_swap(entry.state, USED, PENDING_UPDATE)) {
+      function(key, *entry.value, resultPtr, args...);
+      *entry.state = USED;
+      result = ApplyResult::SUCCESS;
+    } else {
+      result = ApplyResult::FAILED;
     }
-    bucket = bucket->next.get();
   }
-  return ApplyResult::NOT_FOUND;
+  ReleaseBucket(bucket);
+  return result;
 }
 
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
+          typename INSERTER, typename LAYOUT>
 template <typename ELTYPE>
-std::pair<typename LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::iterator,
+std::pair<typename LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER,
+                                LAYOUT>::iterator,
           bool>
-LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::Insert(const KTYPE &key,
-                                                          const ELTYPE &value) {
-  size_t bucketIdx = shad::hash<KTYPE>{}(key) % numBuckets_;
-  Bucket *bucket = &(buckets_array_[bucketIdx]);
-
-  // Forever or until we find an insertion point.
-  for (;;) {
-    for (size_t i = 0; i < bucket->BucketSize(); ++i) {
-      Entry *entry = &bucket->getEntry(i);
-
-      if (__sync_bool_compare_and_swap(&entry->state, EMPTY, PENDING_INSERT)) {
-        // First time insertion.
-        entry->key = std::move(key);
-        auto inserted = INSERTER::Insert(&entry->value, value, false);
-        size_ += 1;
-        entry->state = USED;
-        return std::make_pair(iterator(this, bucketIdx, i, bucket, entry),
-                              inserted);
-      } else {
-        // Update of an existing entry
-        while (entry->state == PENDING_INSERT) rt::impl::yield();
-
-        if (KeyComp_(&entry->key, &key) == 0) {
-          while (!__sync_bool_compare_and_swap(&entry->state, USED,
-                                               PENDING_UPDATE))
-            rt::impl::yield();
-
-          auto inserted = INSERTER::Insert(&entry->value, value, true);
-          entry->state = USED;
-          return std::make_pair(iterator(this, bucketIdx, i, bucket, entry),
-                                inserted);
-        }
-      }
-    }
-
-    if (bucket->next == nullptr) {
-      // We need to allocate a new buffer
-      if (__sync_bool_compare_and_swap(&bucket->isNextAllocated, false, true)) {
-        // Allocate the bucket
-        std::shared_ptr<Bucket> newBucket(
-            new Bucket(constants::kDefaultNumEntriesPerBucket));
-        bucket->next.swap(newBucket);
-      } else {
-        // Wait for the allocation to happen
-        while (bucket->next == nullptr) rt::impl::yield();
-      }
-    }
-
-    bucket = bucket->next.get();
-  }
+LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::Insert(
+    const KTYPE &key, const ELTYPE &value) {
+  size_t hash = shad::hash<KTYPE>{}(key);
+  return InsertEntry(key, hash, [&](VTYPE *entryValue, bool sameKey) {
+    return INSERTER::Insert(entryValue, value, sameKey);
+  });
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE,
-          typename INSERTER>
+          typename INSERTER, typename LAYOUT>
 template <typename ELTYPE>
-void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER>::AsyncInsert(
+void LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT>::AsyncInsert(
     rt::Handle &handle, const KTYPE &key, const ELTYPE &value) {
-  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER> *;
+  using LMapPtr = LocalHashmap<KTYPE, VTYPE, KEY_COMPARE, INSERTER, LAYOUT> *;
   auto args = std::tuple<LMapPtr, KTYPE, ELTYPE>(this, key, value);
   auto insertLambda = [](rt::Handle &,
                          const std::tuple<LMapPtr, KTYPE, ELTYPE> &t) {
@@ -1405,24 +1926,28 @@ class lmap_iterator : public std::iterator<std::forward_iterator_tag, T> {
 
  public:
   using value_type = T;
-  using Entry = typename LMap::Entry;
+  using EntryRef = typename LMap::EntryRef;
   using State = typename LMap::State;
   using Bucket = typename LMap::Bucket;
+  using Table = typename LMap::Table;
 
   lmap_iterator() {}
-  lmap_iterator(const LMap *mapPtr, size_t bId, size_t pos, Bucket *cb,
-                Entry *ePtr)
+  lmap_iterator(const LMap *mapPtr, Table *table, size_t bId, size_t pos,
+                Bucket *cb, EntryRef entry)
       : mapPtr_(mapPtr),
+        table_(table),
         bucketId_(bId),
         position_(pos),
         currBucket_(cb),
-        entryPtr_(ePtr) {}
+        entry_(entry) {}
 
   static lmap_iterator lmap_begin(const LMap *mapPtr) {
-    Bucket *rootPtr = &(const_cast<LMap *>(mapPtr)->buckets_array_[0]);
-    Entry *firstEntry = &(rootPtr->getEntry(0));
-    lmap_iterator beg(mapPtr, 0, 0, rootPtr, firstEntry);
-    if (firstEntry->state == LMap::USED) {
+    const_cast<LMap *>(mapPtr)->FinishResize();
+    Table *table = mapPtr->table_.load();
+    Bucket *rootPtr = LMap::IterationBucket(table, 0);
+    EntryRef firstEntry = rootPtr->getEntry(0);
+    lmap_iterator beg(mapPtr, table, 0, 0, rootPtr, firstEntry);
+    if (*firstEntry.state == LMap::USED) {
       return beg;
     }
     return ++beg;
@@ -1433,22 +1958,23 @@ class lmap_iterator : public std::iterator<std::forward_iterator_tag, T> {
   }
 
   static lmap_iterator lmap_end(size_t numBuckets) {
-    return lmap_iterator(nullptr, numBuckets, 0, nullptr, nullptr);
+    return lmap_iterator(nullptr, nullptr, numBuckets, 0, nullptr,
+                         EntryRef());
   }
   bool operator==(const lmap_iterator &other) const {
-    return entryPtr_ == other.entryPtr_;
+    return entry_ == other.entry_;
   }
   bool operator!=(const lmap_iterator &other) const {
     return !(*this == other);
   }
 
-  T operator*() const { return T(entryPtr_->key, entryPtr_->value); }
+  T operator*() const { return T(*entry_.key, *entry_.value); }
 
   lmap_iterator &operator++() {
     ++position_;
-    if (position_ < constants::kDefaultNumEntriesPerBucket) {
-      entryPtr_++;
-      if (entryPtr_->state == LMap::USED) {
+    if (position_ < currBucket_->BucketSize()) {
+      entry_ = currBucket_->getEntry(position_);
+      if (*entry_.state == LMap::USED) {
         return *this;
       }
       position_ = 0;
@@ -1456,23 +1982,25 @@ class lmap_iterator : public std::iterator<std::forward_iterator_tag, T> {
       position_ = 0;
       currBucket_ = currBucket_->next.get();
       if (currBucket_ != nullptr) {
-        entryPtr_ = &currBucket_->getEntry(position_);
-        if (entryPtr_->state == LMap::USED) {
+        entry_ = currBucket_->getEntry(position_);
+        if (*entry_.state == LMap::USED) {
           return *this;
         }
       }
     }
     // check the first entry of the following bucket lists
-    for (++bucketId_; bucketId_ < mapPtr_->numBuckets_; ++bucketId_) {
-      currBucket_ = &const_cast<LMap *>(mapPtr_)->buckets_array_[bucketId_];
-      entryPtr_ = &currBucket_->getEntry(position_);
-      if (entryPtr_->state == LMap::USED) {
+    for (++bucketId_; bucketId_ < LMap::NumIterationBuckets(table_);
+         ++bucketId_) {
+      currBucket_ = LMap::IterationBucket(table_, bucketId_);
+      entry_ = currBucket_->getEntry(position_);
+      if (*entry_.state == LMap::USED) {
         return *this;
       }
     }
     // next it not found, returning end iterator (n, 0, nullptr)
     mapPtr_ = nullptr;
-    entryPtr_ = nullptr;
+    table_ = nullptr;
+    entry_ = EntryRef();
     currBucket_ = nullptr;
     return *this;
   }
@@ -1506,15 +2034,16 @@ class lmap_iterator : public std::iterator<std::forward_iterator_tag, T> {
       auto part_step =
           (n_buckets >= n_parts) ? (n_buckets + n_parts - 1) / n_parts : 1;
       auto map_ptr = begin.mapPtr_;
-      auto &buckets = map_ptr->buckets_array_;
-      auto b_end =
-          (end != lmap_end(map_ptr)) ? end.bucketId_ : map_ptr->numBuckets_;
+      auto table = begin.table_;
+      auto b_end = (end != lmap_end(map_ptr))
+                       ? end.bucketId_
+                       : LMap::NumIterationBuckets(table);
       auto bi = begin.bucketId_;
       auto pbegin = begin;
       while (true) {
-        bi = first_used_bucket(map_ptr, bi + part_step);
+        bi = first_used_bucket(table, bi + part_step);
         if (bi < b_end) {
-          auto pend = first_in_bucket(map_ptr, bi);
+          auto pend = first_in_bucket(map_ptr, table, bi);
           assert(pbegin != pend);
           res.push_back(partition_range{pbegin, pend});
           pbegin = pend;
@@ -1532,43 +2061,44 @@ class lmap_iterator : public std::iterator<std::forward_iterator_tag, T> {
 
  private:
   const LMap *mapPtr_;
+  // the table being iterated
+  Table *table_;
   size_t bucketId_;
   size_t position_;
   Bucket *currBucket_;
-  Entry *entryPtr_;
+  EntryRef entry_;
 
-  // returns a pointer to the first entry of a bucket
-  static typename LMap::Entry &first_bucket_entry(const LMap *mapPtr_,
-                                                  size_t bi) {
-    assert(mapPtr_);
-    assert(bi < mapPtr_->numBuckets_);
-    return const_cast<LMap *>(mapPtr_)->buckets_array_[bi].getEntry(0);
+  // returns the first entry of a bucket
+  static EntryRef first_bucket_entry(Table *table, size_t bi) {
+    assert(table);
+    assert(bi < LMap::NumIterationBuckets(table));
+    return LMap::IterationBucket(table, bi)->getEntry(0);
   }
 
   // returns an iterator pointing to the beginning of the first active bucket
   // from the input bucket (included)
-  static lmap_iterator first_in_bucket(const LMap *mapPtr_, size_t bi) {
+  static lmap_iterator first_in_bucket(const LMap *mapPtr_, Table *table,
+                                       size_t bi) {
     assert(mapPtr_);
-    assert(bi < mapPtr_->numBuckets_);
+    assert(bi < LMap::NumIterationBuckets(table));
 
-    auto &entry = first_bucket_entry(mapPtr_, bi);
+    EntryRef entry = first_bucket_entry(table, bi);
 
     // sanity check - bucket is used
-    assert(entry.state == LMap::USED);
+    assert(*entry.state == LMap::USED);
 
-    return lmap_iterator(mapPtr_, bi, 0,
-                         &const_cast<LMap *>(mapPtr_)->buckets_array_[bi],
-                         &entry);
+    return lmap_iterator(mapPtr_, table, bi, 0,
+                         LMap::IterationBucket(table, bi), entry);
   }
 
   // returns the index of the first active bucket, starting from the input
   // bucket (included). If not such bucket, it returns the number of buckets.
-  static size_t first_used_bucket(const LMap *mapPtr_, size_t bi) {
-    assert(mapPtr_);
+  static size_t first_used_bucket(Table *table, size_t bi) {
+    assert(table);
     // scan for the first used entry with the same logic as operator++
-    for (; bi < mapPtr_->numBuckets_; ++bi)
-      if (first_bucket_entry(mapPtr_, bi).state == LMap::USED) return bi;
-    return mapPtr_->numBuckets_;
+    for (; bi < LMap::NumIterationBuckets(table); ++bi)
+      if (*first_bucket_entry(table, bi).state == LMap::USED) return bi;
+    return LMap::NumIterationBuckets(table);
   }
 
   // returns the number of buckets spanned by the input range
@@ -1582,15 +2112,15 @@ class lmap_iterator : public std::iterator<std::forward_iterator_tag, T> {
       // - the end of the set; or
       // - an iterator pointing to an used entry
       assert(end == lmap_end(map_ptr) ||
-             first_bucket_entry(map_ptr, end.bucketId_).state == LMap::USED);
+             *first_bucket_entry(end.table_, end.bucketId_).state ==
+                 LMap::USED);
 
       if (end != lmap_end(map_ptr)) {
         // count one more if end is not on a bucket edge
         return end.bucketId_ - begin.bucketId_ +
-               (end.entryPtr_ !=
-                &first_bucket_entry(end.mapPtr_, end.bucketId_));
+               (end.entry_ != first_bucket_entry(end.table_, end.bucketId_));
       }
-      return map_ptr->numBuckets_ - begin.bucketId_;
+      return LMap::NumIterationBuckets(begin.table_) - begin.bucketId_;
     }
     return 0;
   }
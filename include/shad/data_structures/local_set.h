@@ -31,6 +31,7 @@
 #include <functional>
 #include <memory>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -51,11 +52,15 @@ class lset_iterator;
 /// SHAD's LocalSet is a "local", unordered, set.
 /// LocalSets can be used ONLY on the Locality
 /// on which they are created.
+///
+/// Like LocalHashmap, the set doubles its number of buckets when they get too
+/// loaded, migrating them incrementally while other operations keep running.
+/// A resize invalidates the iterators.
 /// @tparam T type of the entries stored in the set.
 /// @tparam ELEM_COMPARE key comparison function; default is MemCmp<T>.
 template <typename T, typename ELEM_COMPARE = MemCmp<T>>
 class LocalSet {
-  template <typename, typename>
+  template <typename, typename, template <typename, typename> class>
   friend class Set;
   template <typename, typename, typename>
   friend class LocalEdgeIndex;
@@ -75,7 +80,10 @@ class LocalSet {
   /// @brief Constructor.
   /// @param numInitBuckets initial number of Buckets.
   explicit LocalSet(const size_t numInitBuckets = 16)
-      : numBuckets_(numInitBuckets), buckets_array_(numInitBuckets), size_(0) {}
+      : numBuckets_(numInitBuckets),
+        root_(numInitBuckets),
+        table_(&root_),
+        size_(0) {}
 
   /// @brief Size of the set (number of entries).
   /// @return the size of the set.
@@ -111,17 +119,26 @@ class LocalSet {
   /// @brief Clear the content of the set.
   void Clear() {
     size_ = 0;
-    buckets_array_.clear();
-    buckets_array_ = std::vector<Bucket>(numBuckets_);
+    grownTables_.clear();
+    root_.Reset(numBuckets_);
+    table_ = &root_;
   }
 
   /// @brief Clear the content of the set.
   void Reset(size_t expectedEntries) {
-    size_ = 0;
-    buckets_array_.clear();
     numBuckets_ = std::max(1lu, expectedEntries / 16);
-    buckets_array_ = std::vector<Bucket>(numBuckets_);
+    Clear();
   }
+
+  /// @brief Grow the set to hold numEntries elements without chaining.
+  ///
+  /// The buckets are migrated in parallel and the method returns when the
+  /// resize is complete.  Other operations can run concurrently, but
+  /// Reserve must not be called from a ForEach function on the same set.
+  ///
+  /// @param[in] numEntries the expected number of elements.
+  void Reserve(size_t numEntries);
+
   /// @brief Check if the set contains a given element.
   /// @param[in] element the element to find.
   /// @return true if the element is found, false otherwise.
@@ -170,25 +187,11 @@ class LocalSet {
   /// @warning std::ostream & operator<< must be defined for T.
   void PrintAllElements();
 
-  iterator begin() {
-    Entry* firstEntry = &buckets_array_[0].getEntry(0);
-    iterator cbeg(this, 0, 0, &buckets_array_[0], firstEntry);
-    if (firstEntry->state == USED) {
-      return cbeg;
-    }
-    return ++cbeg;
-  }
+  iterator begin() { return iterator::lset_begin(this); }
 
   iterator end() { return iterator::lset_end(numBuckets_); }
 
-  const_iterator cbegin() {
-    Entry* firstEntry = &buckets_array_[0].getEntry(0);
-    const_iterator cbeg(this, 0, 0, &buckets_array_[0], firstEntry);
-    if (firstEntry->state == USED) {
-      return cbeg;
-    }
-    return ++cbeg;
-  }
+  const_iterator cbegin() { return const_iterator::lset_begin(this); }
 
   const_iterator cend() { return const_iterator::lset_end(numBuckets_); }
 
@@ -200,10 +203,18 @@ class LocalSet {
                                         ? sizeof(T) / sizeof(uint64_t)
                                         : 1;
   static const uint8_t kHashSeed = 0;
+  // A chain of kMaxChainLength bucket arrays triggers a resize, unless the
+  // set is less than 1/kMaxChainLength full (i.e., the hash is poor).
+  static const size_t kMaxChainLength = 4;
+  // Buckets migrated by each insertion while a resize is ongoing.
+  static const size_t kMigrationStep = 2;
+  static constexpr bool kResizable = std::is_move_assignable<T>::value;
   typedef ELEM_COMPARE ElemCompare;
 
   enum State { EMPTY, USED, PENDING_INSERT };
 
+  enum Migration : uint8_t { NOT_MIGRATED, MIGRATING, MIGRATED };
+
   struct Entry {
     T element;
     volatile State state;
@@ -213,10 +224,20 @@ class LocalSet {
   struct Bucket {
     std::shared_ptr<Bucket> next;
     bool isNextAllocated;
+    // Whether the chain moved to the next table, and the operations working
+    // on it.  Only used for the first bucket of each chain.
+    std::atomic<uint8_t> migration;
+    std::atomic<uint32_t> users;
+    // Set while an erase compacts the chain.  Only used for the first bucket
+    // of each chain.
+    std::atomic<bool> erasing;
 
     explicit Bucket(size_t bsize = kNumEntriesPerBucket)
         : next(nullptr),
           isNextAllocated(false),
+          migration(NOT_MIGRATED),
+          users(0),
+          erasing(false),
           entries(nullptr),
           bucketSize_(bsize) {}
 
@@ -231,6 +252,13 @@ class LocalSet {
       return entries.get()[i];
     }
 
+    bool HasEntries() const { return entries != nullptr; }
+
+    void FreeEntries() {
+      next.reset();
+      entries.reset();
+    }
+
     size_t BucketSize() const { return bucketSize_; }
 
    private:
@@ -239,33 +267,186 @@ class LocalSet {
     rt::Lock _entriesLock;
   };
 
+  // The buckets of the set.  While a resize is ongoing, next points to the
+  // table receiving the buckets, whose size is a multiple of this one.
+  struct Table {
+    explicit Table(size_t nBuckets)
+        : numBuckets(nBuckets),
+          buckets(nBuckets),
+          next(nullptr),
+          cursor(0),
+          migrated(0) {}
+
+    void Reset(size_t nBuckets) {
+      numBuckets = nBuckets;
+      buckets.clear();
+      buckets = std::vector<Bucket>(nBuckets);
+      next = nullptr;
+      cursor = 0;
+      migrated = 0;
+    }
+
+    size_t numBuckets;
+    std::vector<Bucket> buckets;
+    std::atomic<Table*> next;
+    std::atomic<size_t> cursor;
+    std::atomic<size_t> migrated;
+  };
+
   ElemCompare ElemComp_;
+  // The initial number of buckets.  Every table is a multiple of it, so that
+  // ForEach operations visit numBuckets_ disjoint slices of the buckets.
   size_t numBuckets_;
-  std::vector<Bucket> buckets_array_;
+  Table root_;
+  std::atomic<Table*> table_;
+  std::vector<std::unique_ptr<Table>> grownTables_;
+  rt::Lock resizeLock_;
   std::atomic<size_t> size_;
 
-  template <typename ApplyFunT, typename... Args, std::size_t... is>
-  static void AsyncCallForEachElementFun(rt::Handle& handle, const size_t i,
-                                         LocalSet<T, ELEM_COMPARE>* setPtr,
-                                         ApplyFunT function,
-                                         std::tuple<Args...>& args,
-                                         std::index_sequence<is...>) {
-    Bucket* bucket = &setPtr->buckets_array_[i];
-    while (bucket != nullptr) {
-      Bucket* next_bucket = bucket->next.get();
-      uint64_t j;
-      for (j = 0; j < bucket->BucketSize(); ++j) {
+  // Register as a user of the first bucket of a chain, unless the chain is
+  // being or has been migrated.  Returns the migration state observed.
+  static uint8_t EnterBucket(Bucket* bucket) {
+    bucket->users.fetch_add(1);
+    uint8_t state = bucket->migration.load();
+    if (state != NOT_MIGRATED) bucket->users.fetch_sub(1);
+    return state;
+  }
+
+  static void ReleaseBucket(Bucket* bucket) { bucket->users.fetch_sub(1); }
+
+  // Returns the chain holding element, following the tables it migrated to.
+  // The chain cannot migrate until ReleaseBucket is called.  The table
+  // holding the chain is stored in tablePtr, if not nullptr.
+  Bucket* AcquireBucket(const T& element, size_t* bucketIdx,
+                        Table** tablePtr = nullptr) {
+    size_t hash = shad::hash<T>{}(element);
+    Table* table = table_.load();
+    for (;;) {
+      *bucketIdx = hash % table->numBuckets;
+      Bucket* bucket = &table->buckets[*bucketIdx];
+      uint8_t state = EnterBucket(bucket);
+      if (state == NOT_MIGRATED) {
+        if (tablePtr != nullptr) *tablePtr = table;
+        return bucket;
+      }
+      if (state == MIGRATED)
+        table = table->next.load();
+      else
+        rt::impl::yield();
+    }
+  }
+
+  bool FindInChain(Bucket* bucket, const T& element);
+  // Returns an iterator to element, or end() if it is not in the set.
+  iterator FindIterator(const T& element);
+
+  void EraseInChain(Bucket* root, const T& element);
+
+  // Start a resize when the set is too loaded or one of its chains too long,
+  // and take part in the ongoing one.
+  void GrowAfterInsert(size_t chainLength) {
+    if constexpr (kResizable) {
+      Table* table = table_.load();
+      size_t capacity = table->numBuckets * kNumEntriesPerBucket;
+      if (table->next.load() == nullptr &&
+          (size_.load() > capacity ||
+           (chainLength >= kMaxChainLength &&
+            size_.load() * kMaxChainLength > capacity)))
+        StartResize(table, 2 * table->numBuckets);
+      HelpResize(kMigrationStep);
+    }
+  }
+
+  void StartResize(Table* table, size_t numBuckets) {
+    std::lock_guard<rt::Lock> _(resizeLock_);
+    if (table_.load() != table || table->next.load() != nullptr) return;
+    grownTables_.emplace_back(new Table(numBuckets));
+    table->next.store(grownTables_.back().get());
+  }
+
+  // Move the chain of a bucket to the next table.  Returns false if the chain
+  // is in use, or if it is being or has been migrated by someone else.
+  bool MigrateBucket(Table* table, size_t bucketIdx);
+
+  void HelpResize(size_t numBuckets) {
+    Table* table = table_.load();
+    if (table->next.load() == nullptr) return;
+    for (size_t i = 0;
+         i < numBuckets && table->migrated.load() < table->numBuckets; ++i)
+      MigrateBucket(table, table->cursor.fetch_add(1) % table->numBuckets);
+  }
+
+  // Complete the ongoing resize, waiting for the chains in use.
+  void FinishResize() {
+    if constexpr (kResizable) {
+      for (Table* table = table_.load(); table->next.load() != nullptr;
+           table = table_.load()) {
+        for (size_t i = 0; i < table->numBuckets; ++i) {
+          while (table->buckets[i].migration.load() != MIGRATED) {
+            if (!MigrateBucket(table, i)) rt::impl::yield();
+          }
+        }
+        while (table_.load() == table) rt::impl::yield();
+      }
+    }
+  }
+
+  static void MigrateFunWrapper(const std::tuple<LocalSet*, Table*>& args,
+                                size_t i) {
+    std::get<0>(args)->MigrateBucket(std::get<1>(args), i);
+  }
+
+  // Apply visit to the entries of the chain at bucketIdx, or of the chains it
+  // migrated to.
+  template <typename VisitFunT>
+  static void VisitBucket(Table* table, size_t bucketIdx, VisitFunT& visit) {
+    Bucket* root = &table->buckets[bucketIdx];
+    for (;;) {
+      uint8_t state = EnterBucket(root);
+      if (state == NOT_MIGRATED) break;
+      if (state == MIGRATED) {
+        Table* next = table->next.load();
+        for (size_t i = bucketIdx; i < next->numBuckets;
+             i += table->numBuckets)
+          VisitBucket(next, i, visit);
+        return;
+      }
+      rt::impl::yield();
+    }
+    for (Bucket* bucket = root; bucket != nullptr;
+         bucket = bucket->next.get()) {
+      for (size_t j = 0; j < bucket->BucketSize(); ++j) {
         Entry* entry = &bucket->getEntry(j);
         if (entry->state == USED) {
-          function(handle, entry->element, std::get<is>(args)...);
+          visit(entry);
         } else if (entry->state != EMPTY) {
           printf(
               "Entry in PENDING state"
               " while iterating over entries\n");
         }
       }
-      bucket = next_bucket;
     }
+    ReleaseBucket(root);
+  }
+
+  // Apply visit to the entries of the i-th slice of the buckets (i.e., the
+  // buckets congruent to i modulo numBuckets_).
+  template <typename VisitFunT>
+  void ForEachInSlice(size_t i, VisitFunT&& visit) {
+    Table* table = table_.load();
+    for (size_t b = i; b < table->numBuckets; b += numBuckets_)
+      VisitBucket(table, b, visit);
+  }
+
+  template <typename ApplyFunT, typename... Args, std::size_t... is>
+  static void AsyncCallForEachElementFun(rt::Handle& handle, const size_t i,
+                                         LocalSet<T, ELEM_COMPARE>* setPtr,
+                                         ApplyFunT function,
+                                         std::tuple<Args...>& args,
+                                         std::index_sequence<is...>) {
+    setPtr->ForEachInSlice(i, [&](Entry* entry) {
+      function(handle, entry->element, std::get<is>(args)...);
+    });
   }
 
   template <typename Tuple, typename... Args>
@@ -284,22 +465,9 @@ class LocalSet {
                                     ApplyFunT function,
                                     std::tuple<Args...>& args,
                                     std::index_sequence<is...>) {
-    Bucket* bucket = &setPtr->buckets_array_.data()[i];
-    while (bucket != nullptr) {
-      Bucket* next_bucket = bucket->next.get();
-      uint64_t j;
-      for (j = 0; j < bucket->BucketSize(); ++j) {
-        Entry* entry = &bucket->getEntry(j);
-        if (entry->state == USED) {
-          function(entry->element, std::get<is>(args)...);
-        } else if (entry->state != EMPTY) {
-          printf(
-              "Entry in PENDING state"
-              " while iterating over entries\n");
-        }
-      }
-      bucket = next_bucket;
-    }
+    setPtr->ForEachInSlice(i, [&](Entry* entry) {
+      function(entry->element, std::get<is>(args)...);
+    });
   }
 
   template <typename Tuple, typename... Args>
@@ -316,54 +484,35 @@ class LocalSet {
   template <typename ApplyFunT, typename SrcT, typename... Args>
   void AsyncForEachNeighbor(rt::Handle& handle, ApplyFunT&& function, SrcT src,
                             Args... args) {
-    for (auto& curr_bucket : buckets_array_) {
-      Bucket* bucket = &curr_bucket;
-      while (bucket != nullptr) {
-        Bucket* next_bucket = bucket->next.get();
-        uint64_t j;
-        for (j = 0; j < bucket->BucketSize(); ++j) {
-          Entry* entry = &bucket->getEntry(j);
-          if (entry->state == USED) {
-            function(handle, src, entry->element, args...);
-          } else if (entry->state != EMPTY) {
-            printf(
-                "Entry in PENDING state"
-                " while iterating over entries\n");
-          }
-        }
-        bucket = next_bucket;
-      }
+    for (size_t i = 0; i < numBuckets_; ++i) {
+      ForEachInSlice(i, [&](Entry* entry) {
+        function(handle, src, entry->element, args...);
+      });
     }
   }
   // Custom ForEach for the Local Edge Index
   template <typename ApplyFunT, typename SrcT, typename... Args>
   void ForEachNeighbor(ApplyFunT&& function, SrcT src, Args... args) {
-    for (auto& curr_bucket : buckets_array_) {
-      Bucket* bucket = &curr_bucket;
-      while (bucket != nullptr) {
-        Bucket* next_bucket = bucket->next.get();
-        uint64_t j;
-        for (j = 0; j < bucket->BucketSize(); ++j) {
-          Entry* entry = &bucket->getEntry(j);
-          if (entry->state == USED) {
-            function(src, entry->element, args...);
-          } else if (entry->state != EMPTY) {
-            printf(
-                "Entry in PENDING state"
-                " while iterating over entries\n");
-          }
-        }
-        bucket = next_bucket;
-      }
+    for (size_t i = 0; i < numBuckets_; ++i) {
+      ForEachInSlice(i, [&](Entry* entry) {
+        function(src, entry->element, args...);
+      });
     }
   }
 };
 
 template <typename T, typename ELEM_COMPARE>
 bool LocalSet<T, ELEM_COMPARE>::Find(const T& element) {
-  size_t bucketIdx = shad::hash<T>{}(element) % numBuckets_;
-  Bucket* bucket = &(buckets_array_[bucketIdx]);
+  size_t bucketIdx;
+  Bucket* bucket = AcquireBucket(element, &bucketIdx);
+  bool found = FindInChain(bucket, element);
+  ReleaseBucket(bucket);
+  return found;
+}
 
+template <typename T, typename ELEM_COMPARE>
+bool LocalSet<T, ELEM_COMPARE>::FindInChain(Bucket* bucket,
+                                            const T& element) {
   while (bucket != nullptr) {
     for (size_t i = 0; i < bucket->BucketSize(); ++i) {
       Entry* entry = &bucket->getEntry(i);
@@ -381,11 +530,84 @@ bool LocalSet<T, ELEM_COMPARE>::Find(const T& element) {
   return false;
 }
 
+template <typename T, typename ELEM_COMPARE>
+void LocalSet<T, ELEM_COMPARE>::Reserve(size_t numEntries) {
+  if constexpr (kResizable) {
+    size_t numBuckets =
+        (numEntries + kNumEntriesPerBucket - 1) / kNumEntriesPerBucket;
+    for (;;) {
+      FinishResize();
+      Table* table = table_.load();
+      size_t newNumBuckets = table->numBuckets;
+      while (newNumBuckets < numBuckets) newNumBuckets *= 2;
+      if (newNumBuckets == table->numBuckets) return;
+
+      StartResize(table, newNumBuckets);
+      rt::forEachAt(rt::thisLocality(), MigrateFunWrapper,
+                    std::tuple<LocalSet*, Table*>(this, table),
+                    table->numBuckets);
+    }
+  }
+}
+
+template <typename T, typename ELEM_COMPARE>
+bool LocalSet<T, ELEM_COMPARE>::MigrateBucket(Table* table,
+                                              size_t bucketIdx) {
+  Bucket* root = &table->buckets[bucketIdx];
+  uint8_t expected = NOT_MIGRATED;
+  if (!root->migration.compare_exchange_strong(expected, MIGRATING))
+    return false;
+  // Operations register as users before checking the migration state, so
+  // either they see MIGRATING or we see them.
+  if (root->users.load() != 0) {
+    root->migration.store(NOT_MIGRATED);
+    return false;
+  }
+
+  // The chains of the next table congruent to bucketIdx only receive entries
+  // from this chain, and nobody uses them before it is marked as MIGRATED.
+  Table* next = table->next.load();
+  for (Bucket* bucket = root; bucket != nullptr && bucket->HasEntries();
+       bucket = bucket->next.get()) {
+    for (size_t i = 0; i < bucket->BucketSize(); ++i) {
+      Entry* entry = &bucket->getEntry(i);
+      if (entry->state != USED) continue;
+
+      Bucket* dest =
+          &next->buckets[shad::hash<T>{}(entry->element) % next->numBuckets];
+      for (size_t j = 0;; ++j) {
+        if (j == dest->BucketSize()) {
+          if (dest->next == nullptr) {
+            dest->next.reset(new Bucket(kNumEntriesPerBucket));
+            dest->isNextAllocated = true;
+          }
+          dest = dest->next.get();
+          j = 0;
+        }
+        Entry* destEntry = &dest->getEntry(j);
+        if (destEntry->state == EMPTY) {
+          destEntry->element = std::move(entry->element);
+          destEntry->state = USED;
+          break;
+        }
+      }
+    }
+  }
+  root->FreeEntries();
+  root->migration.store(MIGRATED);
+
+  if (table->migrated.fetch_add(1) + 1 == table->numBuckets)
+    table_.store(next);
+  return true;
+}
+
 template <typename T, typename ELEM_COMPARE>
 void LocalSet<T, ELEM_COMPARE>::PrintAllElements() {
-  for (size_t bucketIdx = 0; bucketIdx < numBuckets_; bucketIdx++) {
+  FinishResize();
+  Table* table = table_.load();
+  for (size_t bucketIdx = 0; bucketIdx < table->numBuckets; bucketIdx++) {
     size_t pos = 0;
-    Bucket* bucket = &(buckets_array_[bucketIdx]);
+    Bucket* bucket = &(table->buckets[bucketIdx]);
     std::cout << "Bucket: " << bucketIdx << std::endl;
     while (bucket != nullptr) {
       for (size_t i = 0; i < bucket->BucketSize(); ++i, ++pos) {
@@ -403,8 +625,20 @@ void LocalSet<T, ELEM_COMPARE>::PrintAllElements() {
 
 template <typename T, typename ELEM_COMPARE>
 void LocalSet<T, ELEM_COMPARE>::Erase(const T& element) {
-  size_t bucketIdx = shad::hash<T>{}(element) % numBuckets_;
-  Bucket* bucket = &(buckets_array_[bucketIdx]);
+  size_t bucketIdx;
+  Bucket* bucket = AcquireBucket(element, &bucketIdx);
+  // Erasures move the last entry of the chain into the erased one.  Another
+  // erasure walking the chain at the same time could miss its element, moved
+  // behind it, hence they are serialized.
+  while (bucket->erasing.exchange(true)) rt::impl::yield();
+  EraseInChain(bucket, element);
+  bucket->erasing.store(false);
+  ReleaseBucket(bucket);
+}
+
+template <typename T, typename ELEM_COMPARE>
+void LocalSet<T, ELEM_COMPARE>::EraseInChain(Bucket* root, const T& element) {
+  Bucket* bucket = root;
   Entry* prevEntry = nullptr;
   Entry* toDelete = nullptr;
   Entry* lastEntry = nullptr;
@@ -426,7 +660,7 @@ void LocalSet<T, ELEM_COMPARE>::Erase(const T& element) {
         // 2. Key found, try to acquire a lock on it
         if (!__sync_bool_compare_and_swap(&entry->state, USED,
                                           PENDING_INSERT)) {
-          Erase(element);
+          EraseInChain(root, element);
           return;
         }
         // 3. The entry to remove has been found,
@@ -459,7 +693,7 @@ void LocalSet<T, ELEM_COMPARE>::Erase(const T& element) {
                 lastEntry->state = EMPTY;
                 toDelete->state = USED;
                 ++size_;
-                Erase(element);
+                EraseInChain(root, element);
                 return;
               }
               // now prevEntry is locked
@@ -475,7 +709,7 @@ void LocalSet<T, ELEM_COMPARE>::Erase(const T& element) {
               if (lastEntry->state == PENDING_INSERT) {
                 toDelete->state = USED;
                 ++size_;
-                Erase(element);
+                EraseInChain(root, element);
                 return;
               }
             }
@@ -496,7 +730,7 @@ void LocalSet<T, ELEM_COMPARE>::Erase(const T& element) {
                                               PENDING_INSERT)) {
               toDelete->state = USED;
               ++size_;
-              Erase(element);
+              EraseInChain(root, element);
               return;
             }
             if (lastEntry == prevEntry) {
@@ -558,8 +792,11 @@ void LocalSet<T, ELEM_COMPARE>::AsyncErase(rt::Handle& handle,
 template <typename T, typename ELEM_COMPARE>
 std::pair<typename LocalSet<T, ELEM_COMPARE>::iterator, bool>
 LocalSet<T, ELEM_COMPARE>::Insert(const T& element) {
-  size_t bucketIdx = shad::hash<T>{}(element) % numBuckets_;
-  Bucket* bucket = &(buckets_array_[bucketIdx]);
+  size_t bucketIdx;
+  Table* table;
+  Bucket* root = AcquireBucket(element, &bucketIdx, &table);
+  Bucket* bucket = root;
+  size_t chainLength = 1;
 
   // Forever or until we find an insertion point.
   for (;;) {
@@ -570,13 +807,19 @@ LocalSet<T, ELEM_COMPARE>::Insert(const T& element) {
         entry->element = std::move(element);
         ++size_;
         entry->state = USED;
-        return std::make_pair(iterator(this, bucketIdx, i, bucket, entry),
-                              true);
+        ReleaseBucket(root);
+        GrowAfterInsert(chainLength);
+        // Growing may have migrated the chain and freed the entry.
+        if (root->migration.load() != NOT_MIGRATED)
+          return std::make_pair(FindIterator(element), true);
+        return std::make_pair(
+            iterator(this, table, bucketIdx, i, bucket, entry), true);
       } else {
         while (entry->state == PENDING_INSERT) rt::impl::yield();
         if (ElemComp_(&entry->element, &element) == 0) {
-          return std::make_pair(iterator(this, bucketIdx, i, bucket, entry),
-                                false);
+          ReleaseBucket(root);
+          return std::make_pair(
+              iterator(this, table, bucketIdx, i, bucket, entry), false);
         }
       }
     }
@@ -595,7 +838,30 @@ LocalSet<T, ELEM_COMPARE>::Insert(const T& element) {
     }
 
     bucket = bucket->next.get();
+    ++chainLength;
+  }
+}
+
+template <typename T, typename ELEM_COMPARE>
+typename LocalSet<T, ELEM_COMPARE>::iterator
+LocalSet<T, ELEM_COMPARE>::FindIterator(const T& element) {
+  // The iterator walks the table holding the chain of element, which is the
+  // table receiving the buckets when an ongoing resize migrated the chain.
+  size_t bucketIdx;
+  Table* table;
+  Bucket* root = AcquireBucket(element, &bucketIdx, &table);
+  for (Bucket* bucket = root; bucket != nullptr; bucket = bucket->next.get()) {
+    for (size_t i = 0; i < bucket->BucketSize(); ++i) {
+      Entry* entry = &bucket->getEntry(i);
+      if (entry->state == EMPTY || entry->state == PENDING_INSERT) break;
+      if (ElemComp_(&entry->element, &element) == 0) {
+        ReleaseBucket(root);
+        return iterator(this, table, bucketIdx, i, bucket, entry);
+      }
+    }
   }
+  ReleaseBucket(root);
+  return end();
 }
 
 template <typename T, typename ELEM_COMPARE>
@@ -663,20 +929,25 @@ class lset_iterator : public std::iterator<std::forward_iterator_tag, T> {
   using Entry = typename LSet::Entry;
   using State = typename LSet::State;
   using Bucket = typename LSet::Bucket;
+  using Table = typename LSet::Table;
 
   lset_iterator(){};
-  lset_iterator(const LSet* setPtr, size_t bId, size_t pos, Bucket* cb,
-                Entry* ePtr)
+  lset_iterator(const LSet* setPtr, Table* table, size_t bId, size_t pos,
+                Bucket* cb, Entry* ePtr)
       : setPtr_(setPtr),
+        table_(table),
         bucketId_(bId),
         position_(pos),
         currBucket_(cb),
         entryPtr_(ePtr) {}
 
   static lset_iterator lset_begin(const LSet* setPtr) {
-    Bucket* rootPtr = &(const_cast<LSet*>(setPtr)->buckets_array_[0]);
+    // Iterators walk a single table.
+    const_cast<LSet*>(setPtr)->FinishResize();
+    Table* table = setPtr->table_.load();
+    Bucket* rootPtr = &table->buckets[0];
     Entry* firstEntry = &(rootPtr->getEntry(0));
-    lset_iterator beg(setPtr, 0, 0, rootPtr, firstEntry);
+    lset_iterator beg(setPtr, table, 0, 0, rootPtr, firstEntry);
     if (firstEntry->state == LSet::USED) {
       return beg;
     }
@@ -688,7 +959,7 @@ class lset_iterator : public std::iterator<std::forward_iterator_tag, T> {
   }
 
   static lset_iterator lset_end(size_t numBuckets) {
-    return lset_iterator(nullptr, numBuckets, 0, nullptr, nullptr);
+    return lset_iterator(nullptr, nullptr, numBuckets, 0, nullptr, nullptr);
   }
   bool operator==(const lset_iterator& other) const {
     return entryPtr_ == other.entryPtr_;
@@ -718,8 +989,8 @@ class lset_iterator : public std::iterator<std::forward_iterator_tag, T> {
       }
     }
     // check the first entry of the following bucket lists
-    for (++bucketId_; bucketId_ < setPtr_->numBuckets_; ++bucketId_) {
-      currBucket_ = &const_cast<LSet*>(setPtr_)->buckets_array_[bucketId_];
+    for (++bucketId_; bucketId_ < table_->numBuckets; ++bucketId_) {
+      currBucket_ = &table_->buckets[bucketId_];
       entryPtr_ = &currBucket_->getEntry(position_);
       if (entryPtr_->state == LSet::USED) {
         return *this;
@@ -727,6 +998,7 @@ class lset_iterator : public std::iterator<std::forward_iterator_tag, T> {
     }
     // next it not found, returning end iterator (n, 0, nullptr)
     setPtr_ = nullptr;
+    table_ = nullptr;
     entryPtr_ = nullptr;
     currBucket_ = nullptr;
     return *this;
@@ -761,15 +1033,15 @@ class lset_iterator : public std::iterator<std::forward_iterator_tag, T> {
       auto part_step =
           (n_buckets >= n_parts) ? (n_buckets + n_parts - 1) / n_parts : 1;
       auto set_ptr = begin.setPtr_;
-      auto& buckets = set_ptr->buckets_array_;
+      auto table = begin.table_;
       auto b_end =
-          (end != lset_end(set_ptr)) ? end.bucketId_ : set_ptr->numBuckets_;
+          (end != lset_end(set_ptr)) ? end.bucketId_ : table->numBuckets;
       auto bi = begin.bucketId_;
       auto pbegin = begin;
       while (true) {
-        bi = first_used_bucket(set_ptr, bi + part_step);
+        bi = first_used_bucket(table, bi + part_step);
         if (bi < b_end) {
-          auto pend = first_in_bucket(set_ptr, bi);
+          auto pend = first_in_bucket(set_ptr, table, bi);
           assert(pbegin != pend);
           res.push_back(partition_range{pbegin, pend});
           pbegin = pend;
@@ -787,43 +1059,43 @@ class lset_iterator : public std::iterator<std::forward_iterator_tag, T> {
 
  private:
   const LSet* setPtr_;
+  // the table being iterated
+  Table* table_;
   size_t bucketId_;
   size_t position_;
   Bucket* currBucket_;
   Entry* entryPtr_;
 
   // returns a pointer to the first entry of a bucket
-  static typename LSet::Entry& first_bucket_entry(const LSet* setPtr_,
-                                                  size_t bi) {
-    assert(setPtr_);
-    assert(bi < setPtr_->numBuckets_);
-    return const_cast<LSet*>(setPtr_)->buckets_array_[bi].getEntry(0);
+  static typename LSet::Entry& first_bucket_entry(Table* table, size_t bi) {
+    assert(table);
+    assert(bi < table->numBuckets);
+    return table->buckets[bi].getEntry(0);
   }
 
   // returns an iterator pointing to the beginning of the first active bucket
   // from the input bucket (included)
-  static lset_iterator first_in_bucket(const LSet* setPtr_, size_t bi) {
+  static lset_iterator first_in_bucket(const LSet* setPtr_, Table* table,
+                                       size_t bi) {
     assert(setPtr_);
-    assert(bi < setPtr_->numBuckets_);
+    assert(bi < table->numBuckets);
 
-    auto& entry = first_bucket_entry(setPtr_, bi);
+    auto& entry = first_bucket_entry(table, bi);
 
     // sanity check - bucket is used
     assert(entry.state == LSet::USED);
 
-    return lset_iterator(setPtr_, bi, 0,
-                         &const_cast<LSet*>(setPtr_)->buckets_array_[bi],
-                         &entry);
+    return lset_iterator(setPtr_, table, bi, 0, &table->buckets[bi], &entry);
   }
 
   // returns the index of the first active bucket, starting from the input
   // bucket (included). If not such bucket, it returns the number of buckets.
-  static size_t first_used_bucket(const LSet* setPtr_, size_t bi) {
-    assert(setPtr_);
+  static size_t first_used_bucket(Table* table, size_t bi) {
+    assert(table);
     // scan for the first used entry with the same logic as operator++
-    for (; bi < setPtr_->numBuckets_; ++bi)
-      if (first_bucket_entry(setPtr_, bi).state == LSet::USED) return bi;
-    return setPtr_->numBuckets_;
+    for (; bi < table->numBuckets; ++bi)
+      if (first_bucket_entry(table, bi).state == LSet::USED) return bi;
+    return table->numBuckets;
   }
 
   // returns the number of buckets spanned by the input range
@@ -837,15 +1109,16 @@ class lset_iterator : public std::iterator<std::forward_iterator_tag, T> {
       // - the end of the set; or
       // - an iterator pointing to an used entry
       assert(end == lset_end(set_ptr) ||
-             first_bucket_entry(set_ptr, end.bucketId_).state == LSet::USED);
+             first_bucket_entry(end.table_, end.bucketId_).state ==
+                 LSet::USED);
 
       if (end != lset_end(set_ptr)) {
         // count one more if end is not on a bucket edge
         return end.bucketId_ - begin.bucketId_ +
                (end.entryPtr_ !=
-                &first_bucket_entry(end.setPtr_, end.bucketId_));
+                &first_bucket_entry(end.table_, end.bucketId_));
       }
-      return set_ptr->numBuckets_ - begin.bucketId_;
+      return begin.table_->numBuckets - begin.bucketId_;
     }
     return 0;
   }
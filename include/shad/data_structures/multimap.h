@@ -39,6 +39,7 @@
 #include "shad/data_structures/compare_and_hash_utils.h"
 #include "shad/data_structures/local_multimap.h"
 #include "shad/distributed_iterator_traits.h"
+#include "shad/runtime/collectives.h"
 #include "shad/runtime/runtime.h"
 
 #define PREFIX_SIZE 80
@@ -500,36 +501,27 @@ class Multimap : public AbstractDataStructure< Multimap<KTYPE, VTYPE, KEY_COMPAR
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE>
 inline size_t Multimap<KTYPE, VTYPE, KEY_COMPARE>::Size() const {
-  size_t remoteSize, size = 0;
+  size_t size;
 
   auto sizeLambda = [](const ObjectID & oid, size_t * res) {
     * res = HmapT::GetPtr(oid)->GetLocalMultimap()->Size();
   };
 
-  for (auto tgtLoc : rt::allLocalities()) {
-      rt::executeAtWithRet(tgtLoc, sizeLambda, oid_, & remoteSize);
-      size += remoteSize;
-  }
+  rt::reduce(sizeLambda, oid_, & size);
 
   return size;
 }
 
 template <typename KTYPE, typename VTYPE, typename KEY_COMPARE>
 inline size_t Multimap<KTYPE, VTYPE, KEY_COMPARE>::NumberKeys() const {
-  size_t size = localMultimap_.numberKeys_.load();
-  size_t remoteKeys;
+  size_t size;
 
   auto sizeLambda = [](const ObjectID &oid, size_t *res) {
     auto mapPtr = HmapT::GetPtr(oid);
     *res = mapPtr->localMultimap_.numberKeys_.load();
   };
 
-  for (auto tgtLoc : rt::allLocalities()) {
-    if (tgtLoc != rt::thisLocality()) {
-      rt::executeAtWithRet(tgtLoc, sizeLambda, oid_, &remoteKeys);
-      size += remoteKeys;
-    }
-  }
+  rt::reduce(sizeLambda, oid_, &size);
 
   return size;
 }
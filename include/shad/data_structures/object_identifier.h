@@ -27,6 +27,8 @@
 
 #include <atomic>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include "shad/runtime/runtime.h"
 
 namespace shad {
@@ -212,9 +214,22 @@ template <typename T>
 class ObjectIdentifierCounter {
  public:
   /// @brief Get the singleton instance of the counter for the type T.
+  ///
+  /// Each locality hosted by the calling process owns its own counter.
+  ///
   /// @return A reference to the singleton counter object for the type T.
   static ObjectIdentifierCounter<T> &Instance() {
-    static ObjectIdentifierCounter<T> instance;
+    static std::unique_ptr<ObjectIdentifierCounter<T>[]> instances(
+        new ObjectIdentifierCounter<T>[rt::impl::numProcessLocalities()]);
+    auto &instance = instances[rt::impl::processLocalityIndex()];
+    std::call_once(instance.initFlag_, [&instance]() {
+      // note that in the following, the cast to uint32_t invokes the
+      // conversion operator of the rt::thisLocality object, but we need a
+      // uint64_t.
+      instance.counter_ =
+          static_cast<uint64_t>(static_cast<uint32_t>(rt::thisLocality()))
+          << ObjectIdentifier<T>::kIdentifierBitsize;
+    });
     return instance;
   }
   /// @brief Operator post-increment.
@@ -227,14 +242,10 @@ class ObjectIdentifierCounter {
   explicit operator uint64_t() const { return static_cast<uint64_t>(counter_); }
 
  private:
-  ObjectIdentifierCounter() {
-    // note that in the following, the cast to uint32_t invokes the conversion
-    // operator of the rt::thisLocality object, but we need a uint64_t.
-    counter_ = static_cast<uint64_t>(static_cast<uint32_t>(rt::thisLocality()))
-               << ObjectIdentifier<T>::kIdentifierBitsize;
-  }
+  ObjectIdentifierCounter() : counter_(0) {}
 
   std::atomic<uint64_t> counter_;
+  std::once_flag initFlag_;
 };
 
 /// Output operator to streams.
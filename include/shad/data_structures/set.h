@@ -36,6 +36,8 @@
 #include "shad/data_structures/compare_and_hash_utils.h"
 #include "shad/data_structures/local_set.h"
 #include "shad/distributed_iterator_traits.h"
+#include "shad/runtime/all_to_all.h"
+#include "shad/runtime/collectives.h"
 #include "shad/runtime/runtime.h"
 
 namespace shad {
@@ -49,26 +51,27 @@ class set_iterator;
 /// @tparam T type of the entries stored in the set.
 /// @tparam ELEM_COMPARE element comparison function; default is MemCmp<T>.
 /// @warning obects of type T need to be trivially copiable.
-template <typename T, typename ELEM_COMPARE = MemCmp<T>>
-class Set : public AbstractDataStructure<Set<T, ELEM_COMPARE>> {
+template <typename T, typename ELEM_COMPARE = MemCmp<T>,
+          template <typename, typename> class LOCAL_SET = LocalSet>
+class Set : public AbstractDataStructure<Set<T, ELEM_COMPARE, LOCAL_SET>> {
   template <typename>
   friend class AbstractDataStructure;
 
-  friend class set_iterator<Set<T, ELEM_COMPARE>, const T, T>;
+  friend class set_iterator<Set<T, ELEM_COMPARE, LOCAL_SET>, const T, T>;
 
  public:
   using value_type = T;
-  using SetT = Set<T, ELEM_COMPARE>;
-  using LSetT = LocalSet<T, ELEM_COMPARE>;
+  using SetT = Set<T, ELEM_COMPARE, LOCAL_SET>;
+  using LSetT = LOCAL_SET<T, ELEM_COMPARE>;
   using ObjectID = typename AbstractDataStructure<SetT>::ObjectID;
   using ShadSetPtr = typename AbstractDataStructure<SetT>::SharedPtr;
   using BuffersVector = typename impl::BuffersVector<T, SetT>;
 
-  using iterator = set_iterator<Set<T, ELEM_COMPARE>, const T, T>;
-  using const_iterator = set_iterator<Set<T, ELEM_COMPARE>, const T, T>;
-  using local_iterator = lset_iterator<LocalSet<T, ELEM_COMPARE>, const T>;
-  using const_local_iterator =
-      lset_iterator<LocalSet<T, ELEM_COMPARE>, const T>;
+  using iterator = set_iterator<Set<T, ELEM_COMPARE, LOCAL_SET>, const T, T>;
+  using const_iterator =
+      set_iterator<Set<T, ELEM_COMPARE, LOCAL_SET>, const T, T>;
+  using local_iterator = typename LSetT::iterator;
+  using const_local_iterator = typename LSetT::const_iterator;
   /// @brief Create method.
   ///
   /// Creates a new set instance.
@@ -86,7 +89,7 @@ class Set : public AbstractDataStructure<Set<T, ELEM_COMPARE>> {
   /// @brief Getter of the local set.
   ///
   /// @return The pointer to the local set instance.
-  LocalSet<T, ELEM_COMPARE> * GetLocalSet() {
+  LSetT * GetLocalSet() {
     return & localSet_;
   };
 
@@ -146,6 +149,44 @@ class Set : public AbstractDataStructure<Set<T, ELEM_COMPARE>> {
     rt::asyncExecuteOnAll(h, flushLambda_, oid_);
   }
 
+  /// @brief Inserter handed to the generator of BulkInsert().
+  class BulkInserter {
+    friend class Set;
+
+   public:
+    /// @brief Insert an element in the set.
+    /// @param[in] element The element.
+    void Insert(const T& element) {
+      size_t targetId = shad::hash<T>{}(element) % rt::numLocalities();
+      buffers_.Insert(rt::Locality(targetId), element);
+    }
+
+   private:
+    explicit BulkInserter(rt::AllToAllVBuffers<T>& buffers)
+        : buffers_(buffers) {}
+
+    rt::AllToAllVBuffers<T>& buffers_;
+  };
+
+  /// @brief Collective bulk insertion.
+  ///
+  /// The generator runs on every locality and inserts elements through the
+  /// BulkInserter it receives.  The elements are then shipped to the
+  /// localities owning them with a single rt::allToAllV exchange.  The call
+  /// returns when all the elements have been inserted.
+  ///
+  /// @tparam GenFunT User-defined function type.  The function prototype
+  /// should be:
+  /// @code
+  /// void(const InArgsT &, BulkInserter &);
+  /// @endcode
+  /// @tparam InArgsT Type of the generator argument, must be memcopy-able.
+  ///
+  /// @param generator The function generating the local elements.
+  /// @param args The generator argument.
+  template <typename GenFunT, typename InArgsT>
+  void BulkInsert(GenFunT&& generator, const InArgsT& args);
+
   /// @brief Remove an element from the set.
   /// @param[in] element the element.
   void Erase(const T& element);
@@ -269,7 +310,7 @@ class Set : public AbstractDataStructure<Set<T, ELEM_COMPARE>> {
 
  private:
   ObjectID oid_;
-  LocalSet<T, ELEM_COMPARE> localSet_;
+  LSetT localSet_;
   BuffersVector buffers_;
 
   struct ExeAtArgs {
@@ -277,6 +318,13 @@ class Set : public AbstractDataStructure<Set<T, ELEM_COMPARE>> {
     T element;
   };
 
+  template <typename InArgsT>
+  struct BulkInsertArgs {
+    ObjectID oid;
+    void (*generator)(const InArgsT&, BulkInserter&);
+    InArgsT args;
+  };
+
  protected:
   Set(ObjectID oid, const size_t numEntries)
       : oid_(oid),
@@ -287,33 +335,32 @@ class Set : public AbstractDataStructure<Set<T, ELEM_COMPARE>> {
         buffers_(oid) {}
 };
 
-template <typename T, typename ELEM_COMPARE>
-inline size_t Set<T, ELEM_COMPARE>::Size() const {
-  size_t size = localSet_.size_;
-  size_t remoteSize(0);
+template <typename T, typename ELEM_COMPARE,
+          template <typename, typename> class LOCAL_SET>
+inline size_t Set<T, ELEM_COMPARE, LOCAL_SET>::Size() const {
+  size_t size;
   auto sizeLambda = [](const ObjectID& oid, size_t* res) {
     auto setPtr = SetT::GetPtr(oid);
-    *res = setPtr->localSet_.size_;
+    *res = setPtr->localSet_.Size();
   };
-  for (auto tgtLoc : rt::allLocalities()) {
-    if (tgtLoc != rt::thisLocality()) {
-      rt::executeAtWithRet(tgtLoc, sizeLambda, oid_, &remoteSize);
-      size += remoteSize;
-    }
-  }
+  rt::reduce(sizeLambda, oid_, &size);
   return size;
 }
 
-template <typename T, typename ELEM_COMPARE>
-inline std::pair<typename Set<T, ELEM_COMPARE>::iterator, bool>
-Set<T, ELEM_COMPARE>::Insert(const T& element) {
+template <typename T, typename ELEM_COMPARE,
+          template <typename, typename> class LOCAL_SET>
+inline std::pair<typename Set<T, ELEM_COMPARE, LOCAL_SET>::iterator, bool>
+Set<T, ELEM_COMPARE, LOCAL_SET>::Insert(const T& element) {
   size_t targetId = shad::hash<T>{}(element) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
 
   using itr_traits = distributed_iterator_traits<iterator>;
   if (targetLocality == rt::thisLocality()) {
+    // Take begin() first: it completes any resize of the local set, which
+    // would invalidate the local iterator returned by Insert.
+    auto gbegin = begin(), gend = end();
     auto lres = localSet_.Insert(element);
-    auto git = itr_traits::iterator_from_local(begin(), end(), lres.first);
+    auto git = itr_traits::iterator_from_local(gbegin, gend, lres.first);
     return std::make_pair(git, lres.second);
   }
   std::pair<iterator, bool> res;
@@ -331,9 +378,10 @@ Set<T, ELEM_COMPARE>::Insert(const T& element) {
   return res;
 }
 
-template <typename T, typename ELEM_COMPARE>
-inline void Set<T, ELEM_COMPARE>::AsyncInsert(rt::Handle& handle,
-                                              const T& element) {
+template <typename T, typename ELEM_COMPARE,
+          template <typename, typename> class LOCAL_SET>
+inline void Set<T, ELEM_COMPARE, LOCAL_SET>::AsyncInsert(rt::Handle& handle,
+                                                         const T& element) {
   size_t targetId = shad::hash<T>{}(element) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
   if (targetLocality == rt::thisLocality()) {
@@ -348,23 +396,49 @@ inline void Set<T, ELEM_COMPARE>::AsyncInsert(rt::Handle& handle,
   }
 }
 
-template <typename T, typename ELEM_COMPARE>
-inline void Set<T, ELEM_COMPARE>::BufferedInsert(const T& element) {
+template <typename T, typename ELEM_COMPARE,
+          template <typename, typename> class LOCAL_SET>
+inline void Set<T, ELEM_COMPARE, LOCAL_SET>::BufferedInsert(const T& element) {
   size_t targetId = shad::hash<T>{}(element) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
   buffers_.Insert(element, targetLocality);
 }
 
-template <typename T, typename ELEM_COMPARE>
-inline void Set<T, ELEM_COMPARE>::BufferedAsyncInsert(rt::Handle& handle,
-                                                      const T& element) {
+template <typename T, typename ELEM_COMPARE,
+          template <typename, typename> class LOCAL_SET>
+inline void Set<T, ELEM_COMPARE, LOCAL_SET>::BufferedAsyncInsert(
+    rt::Handle& handle, const T& element) {
   size_t targetId = shad::hash<T>{}(element) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
   buffers_.AsyncInsert(handle, element, targetLocality);
 }
 
-template <typename T, typename ELEM_COMPARE>
-inline void Set<T, ELEM_COMPARE>::Erase(const T& element) {
+template <typename T, typename ELEM_COMPARE,
+          template <typename, typename> class LOCAL_SET>
+template <typename GenFunT, typename InArgsT>
+void Set<T, ELEM_COMPARE, LOCAL_SET>::BulkInsert(GenFunT&& generator,
+                                                 const InArgsT& args) {
+  using GeneratorTy = void (*)(const InArgsT&, BulkInserter&);
+  GeneratorTy genFunPtr = std::forward<decltype(generator)>(generator);
+
+  auto packLambda = [](const BulkInsertArgs<InArgsT>& args,
+                       rt::AllToAllVBuffers<T>& buffers) {
+    BulkInserter inserter(buffers);
+    args.generator(args.args, inserter);
+  };
+  auto receiveLambda = [](const BulkInsertArgs<InArgsT>& args,
+                          const rt::Locality&, const T* elements,
+                          size_t count) {
+    auto setPtr = SetT::GetPtr(args.oid);
+    for (size_t i = 0; i < count; ++i) setPtr->localSet_.Insert(elements[i]);
+  };
+  BulkInsertArgs<InArgsT> bulkArgs = {oid_, genFunPtr, args};
+  rt::allToAllV<T>(packLambda, receiveLambda, bulkArgs);
+}
+
+template <typename T, typename ELEM_COMPARE,
+          template <typename, typename> class LOCAL_SET>
+inline void Set<T, ELEM_COMPARE, LOCAL_SET>::Erase(const T& element) {
   size_t targetId = shad::hash<T>{}(element) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
   if (targetLocality == rt::thisLocality()) {
@@ -379,9 +453,10 @@ inline void Set<T, ELEM_COMPARE>::Erase(const T& element) {
   }
 }
 
-template <typename T, typename ELEM_COMPARE>
-inline void Set<T, ELEM_COMPARE>::AsyncErase(rt::Handle& handle,
-                                             const T& element) {
+template <typename T, typename ELEM_COMPARE,
+          template <typename, typename> class LOCAL_SET>
+inline void Set<T, ELEM_COMPARE, LOCAL_SET>::AsyncErase(rt::Handle& handle,
+                                                        const T& element) {
   size_t targetId = shad::hash<T>{}(element) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
   if (targetLocality == rt::thisLocality()) {
@@ -396,8 +471,9 @@ inline void Set<T, ELEM_COMPARE>::AsyncErase(rt::Handle& handle,
   }
 }
 
-template <typename T, typename ELEM_COMPARE>
-inline bool Set<T, ELEM_COMPARE>::Find(const T& element) {
+template <typename T, typename ELEM_COMPARE,
+          template <typename, typename> class LOCAL_SET>
+inline bool Set<T, ELEM_COMPARE, LOCAL_SET>::Find(const T& element) {
   size_t targetId = shad::hash<T>{}(element) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
   if (targetLocality == rt::thisLocality()) {
@@ -415,9 +491,11 @@ inline bool Set<T, ELEM_COMPARE>::Find(const T& element) {
   return false;
 }
 
-template <typename T, typename ELEM_COMPARE>
-inline void Set<T, ELEM_COMPARE>::AsyncFind(rt::Handle& handle,
-                                            const T& element, bool* found) {
+template <typename T, typename ELEM_COMPARE,
+          template <typename, typename> class LOCAL_SET>
+inline void Set<T, ELEM_COMPARE, LOCAL_SET>::AsyncFind(rt::Handle& handle,
+                                                       const T& element,
+                                                       bool* found) {
   size_t targetId = shad::hash<T>{}(element) % rt::numLocalities();
   rt::Locality targetLocality(targetId);
 
@@ -433,9 +511,11 @@ inline void Set<T, ELEM_COMPARE>::AsyncFind(rt::Handle& handle,
   }
 }
 
-template <typename T, typename ELEM_COMPARE>
+template <typename T, typename ELEM_COMPARE,
+          template <typename, typename> class LOCAL_SET>
 template <typename ApplyFunT, typename... Args>
-void Set<T, ELEM_COMPARE>::ForEachElement(ApplyFunT&& function, Args&... args) {
+void Set<T, ELEM_COMPARE, LOCAL_SET>::ForEachElement(ApplyFunT&& function,
+                                                     Args&... args) {
   using FunctionTy = void (*)(const T&, Args&...);
   FunctionTy fn = std::forward<decltype(function)>(function);
   using feArgs = std::tuple<ObjectID, FunctionTy, std::tuple<Args...>>;
@@ -452,11 +532,12 @@ void Set<T, ELEM_COMPARE>::ForEachElement(ApplyFunT&& function, Args&... args) {
   rt::executeOnAll(feLambda, arguments);
 }
 
-template <typename T, typename ELEM_COMPARE>
+template <typename T, typename ELEM_COMPARE,
+          template <typename, typename> class LOCAL_SET>
 template <typename ApplyFunT, typename... Args>
-void Set<T, ELEM_COMPARE>::AsyncForEachElement(rt::Handle& handle,
-                                               ApplyFunT&& function,
-                                               Args&... args) {
+void Set<T, ELEM_COMPARE, LOCAL_SET>::AsyncForEachElement(rt::Handle& handle,
+                                                          ApplyFunT&& function,
+                                                          Args&... args) {
   using FunctionTy = void (*)(rt::Handle&, const T&, Args&...);
   FunctionTy fn = std::forward<decltype(function)>(function);
   using feArgs = std::tuple<ObjectID, FunctionTy, std::tuple<Args...>>;
@@ -480,7 +561,7 @@ class set_iterator : public std::iterator<std::forward_iterator_tag, T> {
   using value_type = NonConstT;
   using OIDT = typename SetT::ObjectID;
   using LSet = typename SetT::LSetT;
-  using local_iterator_type = lset_iterator<LSet, T>;
+  using local_iterator_type = typename LSet::iterator;
 
   set_iterator() {}
   set_iterator(uint32_t locID, const OIDT setOID, local_iterator_type& lit,
@@ -618,7 +699,7 @@ class set_iterator : public std::iterator<std::forward_iterator_tag, T> {
 
  private:
   struct itData {
-    itData() : oid_(0), lsetIt_(nullptr, 0, 0, nullptr, nullptr) {}
+    itData() : oid_(0), lsetIt_(local_iterator_type::lset_end(size_t(0))) {}
     itData(uint32_t locId, OIDT oid, local_iterator_type lsetIt, T element)
         : locId_(locId), oid_(oid), lsetIt_(lsetIt), element_(element) {}
     bool operator==(const itData& other) const {
@@ -38,6 +38,7 @@
 
 #include "shad/data_structures/abstract_data_structure.h"
 #include "shad/data_structures/buffer.h"
+#include "shad/runtime/affinity.h"
 #include "shad/runtime/runtime.h"
 
 namespace shad {
@@ -84,6 +85,15 @@ class Vector : public AbstractDataStructure<Vector<T, Allocator>> {
   /// @return the number of element in the container.
   size_type Size() const noexcept;
 
+  /// @brief The locality owning each position of the shad::Vector.
+  ///
+  /// Positions are stored in blocks assigned to the localities round-robin,
+  /// whatever the size of the container.
+  /// @return The affinity of the positions of the shad::Vector.
+  rt::IterationAffinity Affinity() const {
+    return rt::IterationAffinity::CyclicBlocks(kBlockSize);
+  }
+
   /// @brief Returns the maximum number of elements that shad::Vector can hold.
   ///
   /// This methods returns the maximum potential size of the container.
@@ -536,9 +546,7 @@ class Vector : public AbstractDataStructure<Vector<T, Allocator>> {
 
     if (n == 0 && static_cast<uint32_t>(rt::thisLocality()) != 0) return;
 
-    for (size_t i = 0; i < blocksToAllocate; ++i)
-      dataBlocks_.emplace_back(std::allocator_traits<allocator_type>::allocate(
-          allocator_, kBlockSize));
+    for (size_t i = 0; i < blocksToAllocate; ++i) _allocateBlock();
   }
 
  private:
@@ -611,11 +619,7 @@ class Vector : public AbstractDataStructure<Vector<T, Allocator>> {
           [](rt::Handle &, const std::pair<ObjectID, size_type> &args) {
             auto This = Vector<T, Allocator>::GetPtr(args.first);
 
-            for (size_t i = 0; i < args.second; ++i) {
-              This->dataBlocks_.emplace_back(
-                  std::allocator_traits<allocator_type>::allocate(
-                      This->allocator_, kBlockSize));
-            }
+            for (size_t i = 0; i < args.second; ++i) This->_allocateBlock();
           },
           std::make_pair(oid_, newBlocks[i]));
     }
@@ -625,6 +629,16 @@ class Vector : public AbstractDataStructure<Vector<T, Allocator>> {
     capacity_ += kBlockSize * blocksToAllocate;
   }
 
+  // Blocks are dealt round-robin to the NUMA domains of the locality.
+  void _allocateBlock() {
+    value_type *block =
+        std::allocator_traits<allocator_type>::allocate(allocator_, kBlockSize);
+    rt::impl::NumaTopology::Instance().PlaceOnDomain(
+        block, kBlockSize * sizeof(value_type),
+        dataBlocks_.size() % rt::numDomains());
+    dataBlocks_.emplace_back(block);
+  }
+
   void _clear() {
     for (auto block : dataBlocks_) {
       for (T *toDestroy = block; toDestroy < block + kBlockSize; ++toDestroy) {
@@ -35,6 +35,7 @@
 #include "shad/data_structures/set.h"
 #include "shad/extensions/graph_library/edge_index.h"
 #include "shad/runtime/runtime.h"
+#include "shad/runtime/termination.h"
 #include "shad/util/measure.h"
 
 /// @brief Length of the shortest path between two vertices.
@@ -45,11 +46,30 @@
 /// @param src The source vertex.
 /// @param dest The destination vertex.
 /// @return The length of the shortest path between two vertices if any;
-///         returns numeric limits'infinity if no path is found.
+///         returns numeric limits' max if no path is found.
 ///
 template <typename GraphT, typename VertexT>
 size_t sssp_length(typename GraphT::ObjectID gid, VertexT src, VertexT dest);
 
+/// @brief Length of the shortest path between two vertices, computed with
+/// asynchronous relaxations instead of level-synchronous frontiers.
+///
+/// Every vertex whose distance improves spawns the relaxation of its
+/// neighbors, and the search ends when no relaxation is left, as detected by
+/// rt::waitForTermination.
+///
+/// @tparam GraphT Graph Type.
+/// @tparam VertexT VertexType.
+/// @param gid ObjectID of the graph.
+/// @param src The source vertex.
+/// @param dest The destination vertex.
+/// @return The length of the shortest path between two vertices if any;
+///         returns numeric limits' max if no path is found.
+///
+template <typename GraphT, typename VertexT>
+size_t async_sssp_length(typename GraphT::ObjectID gid, VertexT src,
+                         VertexT dest);
+
 template <typename GraphT, typename VertexT>
 void __sssp_neigh_iter(shad::rt::Handle &handle, const VertexT &src,
                        const VertexT &dest,
@@ -114,7 +134,7 @@ size_t __sssp_length(  // GraphT::SharedPtr gPtr,
     qPtr->Reset(num_vertices / 2);
     qPtr.swap(nextqPtr);
   }
-  return std::numeric_limits<size_t>::infinity();
+  return std::numeric_limits<size_t>::max();
 }
 
 template <typename GraphT, typename VertexT>
@@ -125,12 +145,93 @@ size_t sssp_length(typename GraphT::ObjectID gid, VertexT src, VertexT dest) {
   auto q1Ptr = shad::Set<VertexT>::Create(num_vertices / 2);
   auto visited = shad::Array<bool>::Create(num_vertices, false);
   auto found = shad::Array<bool>::Create(1, false);
-  return __sssp_length<GraphT, VertexT>(gid, num_vertices, q0Ptr, q1Ptr,
-                                        visited, found, src, dest);
+  size_t length = __sssp_length<GraphT, VertexT>(
+      gid, num_vertices, q0Ptr, q1Ptr, visited, found, src, dest);
   shad::Set<VertexT>::Destroy(q0Ptr->GetGlobalID());
   shad::Set<VertexT>::Destroy(q1Ptr->GetGlobalID());
   shad::Array<bool>::Destroy(visited->GetGlobalID());
   shad::Array<bool>::Destroy(found->GetGlobalID());
+  return length;
+}
+
+template <typename GraphT, typename VertexT>
+struct __async_sssp_args {
+  typename GraphT::ObjectID gid;
+  shad::Array<size_t>::ObjectID distID;
+  VertexT vertex;
+  size_t distance;
+};
+
+template <typename GraphT, typename VertexT>
+void __async_sssp_relax(const shad::rt::Epoch &epoch,
+                        const __async_sssp_args<GraphT, VertexT> &args);
+
+template <typename GraphT, typename VertexT>
+void __async_sssp_neigh_iter(const VertexT &src, const VertexT &dest,
+                             shad::rt::Epoch &epoch,
+                             typename GraphT::ObjectID &gid,
+                             shad::Array<size_t>::ObjectID &distID,
+                             size_t &distance) {
+  __async_sssp_args<GraphT, VertexT> args{gid, distID, dest, distance};
+  shad::rt::asyncExecuteAt(epoch, shad::rt::thisLocality(),
+                           __async_sssp_relax<GraphT, VertexT>, args);
+}
+
+template <typename GraphT, typename VertexT>
+void __async_sssp_expand(const shad::rt::Epoch &epoch,
+                         const __async_sssp_args<GraphT, VertexT> &args) {
+  auto graphPtr = GraphT::GetPtr(args.gid);
+  shad::rt::Epoch e = epoch;
+  auto gid = args.gid;
+  auto distID = args.distID;
+  size_t distance = args.distance + 1;
+  graphPtr->ForEachNeighbor(args.vertex,
+                            __async_sssp_neigh_iter<GraphT, VertexT>, e, gid,
+                            distID, distance);
+}
+
+template <typename GraphT, typename VertexT>
+void __async_sssp_update(size_t, size_t &distance, shad::rt::Epoch &epoch,
+                         __async_sssp_args<GraphT, VertexT> &args) {
+  size_t current = __atomic_load_n(&distance, __ATOMIC_SEQ_CST);
+  while (args.distance < current) {
+    if (__atomic_compare_exchange_n(&distance, &current, args.distance, false,
+                                    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+      shad::rt::asyncExecuteAt(epoch, shad::rt::thisLocality(),
+                               __async_sssp_expand<GraphT, VertexT>, args);
+      return;
+    }
+  }
+}
+
+template <typename GraphT, typename VertexT>
+void __async_sssp_relax(const shad::rt::Epoch &epoch,
+                        const __async_sssp_args<GraphT, VertexT> &args) {
+  auto distPtr = shad::Array<size_t>::GetPtr(args.distID);
+  shad::rt::Epoch e = epoch;
+  auto updateArgs = args;
+  distPtr->Apply(args.vertex, __async_sssp_update<GraphT, VertexT>, e,
+                 updateArgs);
+}
+
+template <typename GraphT, typename VertexT>
+size_t async_sssp_length(typename GraphT::ObjectID gid, VertexT src,
+                         VertexT dest) {
+  auto gPtr = GraphT::GetPtr(gid);
+  size_t num_vertices = gPtr->Size();
+  auto distance = shad::Array<size_t>::Create(
+      num_vertices, std::numeric_limits<size_t>::max());
+
+  auto epoch = shad::rt::createEpoch();
+  __async_sssp_args<GraphT, VertexT> args{gid, distance->GetGlobalID(), src,
+                                          0};
+  shad::rt::asyncExecuteAt(epoch, shad::rt::thisLocality(),
+                           __async_sssp_relax<GraphT, VertexT>, args);
+  shad::rt::waitForTermination(epoch);
+
+  size_t length = distance->At(dest);
+  shad::Array<size_t>::Destroy(distance->GetGlobalID());
+  return length;
 }
 
 #endif  // INCLUDE_SHAD_EXTENSIONS_GRAPH_LIBRARY_ALGORITHMS_SSSP_H_
@@ -69,7 +69,9 @@ class AttrEdgesPair {
 };
 
 template <typename SrcT, typename DestT, typename SrcAttrT,
-          typename NeighborsStorageT = AttrEdgesPair<SrcAttrT, DestT>>
+          typename NeighborsStorageT = AttrEdgesPair<SrcAttrT, DestT>,
+          template <typename, typename, typename, typename> class
+              EDGE_LIST_MAP = LocalHashmap>
 class AttributedEdgeIndexStorage {
  public:
   using SrcAttributesT = SrcAttrT;
@@ -147,13 +149,13 @@ class AttributedEdgeIndexStorage {
 
   using NeighborListStorageT = NeighborsStorageT;
   using EdgeListStorageT =
-      LocalHashmap<SrcT, NeighborsStorageT, IDCmp<SrcT>, ElementInserter>;
+      EDGE_LIST_MAP<SrcT, NeighborsStorageT, IDCmp<SrcT>, ElementInserter>;
   EdgeListStorageT edgeList_;
 
   template <typename ApplyFunT, typename... Args, std::size_t... is>
   static void CallVertexAttributesApplyFun(
-      AttributedEdgeIndexStorage<SrcT, DestT, SrcAttrT, NeighborListStorageT>
-          *stPtr,
+      AttributedEdgeIndexStorage<SrcT, DestT, SrcAttrT, NeighborListStorageT,
+                                 EDGE_LIST_MAP> *stPtr,
       const SrcT &src, ApplyFunT function, std::tuple<Args...> &args,
       std::index_sequence<is...>) {
     NeighborsStorageT *entry = stPtr->edgeList_.Lookup(src);
@@ -36,6 +36,7 @@
 #include "shad/data_structures/compare_and_hash_utils.h"
 #include "shad/data_structures/local_set.h"
 #include "shad/extensions/graph_library/local_edge_index.h"
+#include "shad/runtime/collectives.h"
 #include "shad/runtime/runtime.h"
 
 namespace shad {
@@ -453,35 +454,23 @@ class EdgeIndex
 
 template <typename SrcT, typename DestT, typename StorageT>
 inline size_t EdgeIndex<SrcT, DestT, StorageT>::Size() const {
-  size_t size = localIndex_.Size();
-  size_t remoteSize;
+  size_t size;
   auto sizeLambda = [](const ObjectID &oid, size_t *res) {
     auto ptr = EdgeIndex<SrcT, DestT, StorageT>::GetPtr(oid);
     *res = ptr->localIndex_.Size();
   };
-  for (auto tgtLoc : rt::allLocalities()) {
-    if (tgtLoc != rt::thisLocality()) {
-      rt::executeAtWithRet(tgtLoc, sizeLambda, oid_, &remoteSize);
-      size += remoteSize;
-    }
-  }
+  rt::reduce(sizeLambda, oid_, &size);
   return size;
 }
 
 template <typename SrcT, typename DestT, typename StorageT>
 inline size_t EdgeIndex<SrcT, DestT, StorageT>::NumEdges() {
-  size_t size = localIndex_.UpdateNumEdges();
-  size_t remoteSize;
+  size_t size;
   auto sizeLambda = [](const ObjectID &oid, size_t *res) {
     auto ptr = EdgeIndex<SrcT, DestT, StorageT>::GetPtr(oid);
     *res = ptr->localIndex_.UpdateNumEdges();
   };
-  for (auto tgtLoc : rt::allLocalities()) {
-    if (tgtLoc != rt::thisLocality()) {
-      rt::executeAtWithRet(tgtLoc, sizeLambda, oid_, &remoteSize);
-      size += remoteSize;
-    }
-  }
+  rt::reduce(sizeLambda, oid_, &size);
   return size;
 }
 
@@ -33,6 +33,8 @@
 #include <vector>
 
 #include "shad/data_structures/compare_and_hash_utils.h"
+#include "shad/data_structures/local_flat_hashmap.h"
+#include "shad/data_structures/local_flat_set.h"
 #include "shad/data_structures/local_hashmap.h"
 #include "shad/data_structures/local_set.h"
 #include "shad/runtime/runtime.h"
@@ -45,8 +47,15 @@ class IDCmp {
   bool operator()(const T* first, const T* sec) const { return *first != *sec; }
 };
 
+/// @brief The default storage of the neighbors lists of a LocalEdgeIndex.
+/// @tparam NeighborsStorageT the set of neighbors of a vertex (e.g., LocalSet
+/// or LocalFlatSet).
+/// @tparam EDGE_LIST_MAP the local map from vertices to their neighbors lists
+/// (e.g., LocalHashmap or LocalFlatHashmap).
 template <typename SrcT, typename DestT,
-          typename NeighborsStorageT = LocalSet<DestT>>
+          typename NeighborsStorageT = LocalSet<DestT>,
+          template <typename, typename, typename, typename> class
+              EDGE_LIST_MAP = LocalHashmap>
 class DefaultEdgeIndexStorage {
  public:
   struct EmptyAttr {};
@@ -135,12 +144,13 @@ class DefaultEdgeIndexStorage {
 
   using NeighborListStorageT = NeighborsStorageT;
   using EdgeListStorageT =
-      LocalHashmap<SrcT, NeighborsStorageT, IDCmp<SrcT>, ElementInserter>;
+      EDGE_LIST_MAP<SrcT, NeighborsStorageT, IDCmp<SrcT>, ElementInserter>;
   EdgeListStorageT edgeList_;
 
   template <typename ApplyFunT, typename... Args, std::size_t... is>
   static void CallVertexAttributesApplyFun(
-      DefaultEdgeIndexStorage<SrcT, DestT, NeighborListStorageT>* stPtr,
+      DefaultEdgeIndexStorage<SrcT, DestT, NeighborListStorageT,
+                              EDGE_LIST_MAP>* stPtr,
       const SrcT& key, ApplyFunT function, std::tuple<Args...>& args,
       std::index_sequence<is...>) {
     printf("WARNING: Function not implemented for non attributed graphs\n");
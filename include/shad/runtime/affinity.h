@@ -0,0 +1,304 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#ifndef INCLUDE_SHAD_RUNTIME_AFFINITY_H_
+#define INCLUDE_SHAD_RUNTIME_AFFINITY_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "shad/runtime/runtime.h"
+#include "shad/runtime/scheduling_policy.h"
+
+namespace shad {
+namespace rt {
+
+/// @brief The locality owning the data accessed by each iteration of a loop.
+///
+/// Loops over the indices of a distributed container (e.g., the vertices of
+/// a graph stored in an Array) take the affinity of the container, so that
+/// iteration i runs where element i lives and accesses it locally.
+/// Containers provide their affinity through their Affinity() method.
+///
+/// Typical Usage:
+/// @code
+/// forEachOnAll(arrayPtr->Affinity(),
+///     [](const Args & input, size_t i) {
+///         // arrayPtr->At(i) is local.
+///     },
+///     args, arrayPtr->Size());
+/// @endcode
+class IterationAffinity {
+ public:
+  using OwnerFunT = uint32_t (*)(size_t iteration);
+
+  /// @brief Locality L owns the iterations [offsets[L], offsets[L + 1]).
+  ///
+  /// Iterations past offsets.back() belong to the last locality.
+  ///
+  /// @param offsets numLocalities() + 1 non-decreasing offsets, the first
+  /// one being 0.
+  static IterationAffinity Blocks(std::vector<size_t> offsets) {
+    IterationAffinity affinity;
+    affinity.offsets_ = std::move(offsets);
+    return affinity;
+  }
+
+  /// @brief Blocks of blockSize iterations are assigned to the localities
+  /// round-robin, the first block going to locality 0.
+  static IterationAffinity CyclicBlocks(size_t blockSize) {
+    IterationAffinity affinity;
+    affinity.blockSize_ = std::max<size_t>(blockSize, 1);
+    return affinity;
+  }
+
+  /// @brief Locality owner(i) owns iteration i.
+  ///
+  /// Every locality evaluates owner on all the iterations of the loop, hence
+  /// owner must be cheap (e.g., the hash of a key).
+  static IterationAffinity Owner(OwnerFunT owner) {
+    IterationAffinity affinity;
+    affinity.owner_ = owner;
+    return affinity;
+  }
+
+  /// @brief The locality owning an iteration.
+  Locality OwnerOf(size_t iteration) const {
+    if (owner_ != nullptr) return Locality(owner_(iteration));
+    if (blockSize_ != 0)
+      return Locality((iteration / blockSize_) % numLocalities());
+    auto next =
+        std::upper_bound(offsets_.begin() + 1, offsets_.end() - 1, iteration);
+    return Locality(static_cast<uint32_t>(next - offsets_.begin() - 1));
+  }
+
+  /// @brief The owner function, or nullptr.
+  OwnerFunT OwnerFunction() const { return owner_; }
+
+  /// @brief The size of the blocks assigned round-robin, or 0.
+  size_t BlockSize() const { return blockSize_; }
+
+  /// @brief The iterations of a loop of numIters iterations owned by a
+  /// locality, for affinities made of Blocks.
+  std::pair<size_t, size_t> Block(const Locality &locality,
+                                  size_t numIters) const {
+    auto L = static_cast<uint32_t>(locality);
+    size_t first = std::min(offsets_[L], numIters);
+    size_t last = L + 2 == offsets_.size()
+                      ? numIters
+                      : std::min(offsets_[L + 1], numIters);
+    return std::make_pair(first, std::max(first, last));
+  }
+
+ private:
+  IterationAffinity() : blockSize_(0), owner_(nullptr) {}
+
+  std::vector<size_t> offsets_;
+  size_t blockSize_;
+  OwnerFunT owner_;
+};
+
+namespace impl {
+
+template <typename InArgsT>
+void syncLoopTask(Handle &, const LoopArgs<InArgsT> &loop) {
+  loopTask(loop);
+}
+
+// Run the loop described by loop on the localities owning its iterations,
+// asynchronously when handle is not null.
+template <typename InArgsT>
+void affinityLoop(Handle *handle, const IterationAffinity &affinity,
+                  LoopArgs<InArgsT> loop) {
+  size_t numIters = loop.end;
+  loop.onAll = false;
+  if (affinity.OwnerFunction() != nullptr || affinity.BlockSize() != 0) {
+    loop.placement = LoopPlacement{affinity.OwnerFunction(),
+                                   affinity.BlockSize(), numIters};
+    if (handle != nullptr)
+      asyncExecuteOnAll(*handle, asyncLoopTask<InArgsT>, loop);
+    else
+      executeOnAll(loopTask<InArgsT>, loop);
+    return;
+  }
+
+  Handle localHandle;
+  for (auto &locality : allLocalities()) {
+    auto block = affinity.Block(locality, numIters);
+    if (block.first == block.second) continue;
+    loop.begin = block.first;
+    loop.end = block.second;
+    if (handle != nullptr)
+      asyncExecuteAt(*handle, locality, asyncLoopTask<InArgsT>, loop);
+    else
+      asyncExecuteAt(localHandle, locality, syncLoopTask<InArgsT>, loop);
+  }
+  if (handle == nullptr) waitForCompletion(localHandle);
+}
+
+}  // namespace impl
+
+/// @brief Execute a parallel loop on the whole system, running every
+/// iteration on the locality that owns it.
+///
+/// Typical Usage:
+/// @code
+/// forEachOnAll(arrayPtr->Affinity(),
+///     [](const Args & input, size_t itrNum) {
+///         // Do something with arrayPtr->At(itrNum).
+///     },
+///     args, iterations);
+/// @endcode
+///
+/// @tparam FunT The type of the function to be executed.  The function
+/// prototype must be:
+/// @code
+/// void(const ArgsT &, size_t itrNum);
+/// @endcode
+/// where the itrNum is the n-th iteration of the loop.
+///
+/// @tparam InArgsT The type of the argument accepted by the function.  The type
+/// can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @param affinity The locality owning each iteration.
+/// @param func The function to execute.
+/// @param args The arguments to be passed to the function.
+/// @param numIters The total number of iteration of the loop.
+/// @param policy How the iterations of a locality are split in chunks.
+template <typename FunT, typename InArgsT>
+void forEachOnAll(const IterationAffinity &affinity, FunT &&func,
+                  const InArgsT &args, const size_t numIters,
+                  const SchedulingPolicy &policy = SchedulingPolicy::Auto()) {
+  using FunctionTy = void (*)(const InArgsT &, size_t);
+  FunctionTy fn = std::forward<decltype(func)>(func);
+  impl::affinityLoop(
+      nullptr, affinity,
+      impl::makeLoopArgs(fn, false, false, policy, numIters, args));
+}
+
+/// @brief Execute asynchronously a parallel loop on the whole system,
+/// running every iteration on the locality that owns it.
+///
+/// @tparam FunT The type of the function to be executed.  The function
+/// prototype must be:
+/// @code
+/// void(Handle &, const ArgsT &, size_t itrNum);
+/// @endcode
+/// where the itrNum is the n-th iteration of the loop.
+///
+/// @tparam InArgsT The type of the argument accepted by the function.  The type
+/// can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @param handle An Handle for the associated task-group.
+/// @param affinity The locality owning each iteration.
+/// @param func The function to execute.
+/// @param args The arguments to be passed to the function.
+/// @param numIters The total number of iteration of the loop.
+/// @param policy How the iterations of a locality are split in chunks.
+template <typename FunT, typename InArgsT>
+void asyncForEachOnAll(
+    Handle &handle, const IterationAffinity &affinity, FunT &&func,
+    const InArgsT &args, const size_t numIters,
+    const SchedulingPolicy &policy = SchedulingPolicy::Auto()) {
+  using FunctionTy = void (*)(Handle &, const InArgsT &, size_t);
+  FunctionTy fn = std::forward<decltype(func)>(func);
+  impl::affinityLoop(
+      &handle, affinity,
+      impl::makeLoopArgs(fn, false, false, policy, numIters, args));
+}
+
+/// @brief Execute a parallel loop on the whole system, passing to the
+/// function chunks of iterations owned by the locality running it.
+///
+/// @tparam FunT The type of the function to be executed.  The function
+/// prototype must be:
+/// @code
+/// void(const ArgsT &, size_t begin, size_t end);
+/// @endcode
+/// where [begin, end) are the iterations of the chunk.
+///
+/// @tparam InArgsT The type of the argument accepted by the function.  The type
+/// can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @param affinity The locality owning each iteration.
+/// @param func The function to execute.
+/// @param args The arguments to be passed to the function.
+/// @param numIters The total number of iteration of the loop.
+/// @param policy How the iterations of a locality are split in chunks.
+template <typename FunT, typename InArgsT>
+void forEachRangeOnAll(
+    const IterationAffinity &affinity, FunT &&func, const InArgsT &args,
+    const size_t numIters,
+    const SchedulingPolicy &policy = SchedulingPolicy::Auto()) {
+  using FunctionTy = void (*)(const InArgsT &, size_t, size_t);
+  FunctionTy fn = std::forward<decltype(func)>(func);
+  impl::affinityLoop(
+      nullptr, affinity,
+      impl::makeLoopArgs(fn, true, false, policy, numIters, args));
+}
+
+/// @brief Execute asynchronously a parallel loop on the whole system,
+/// passing to the function chunks of iterations owned by the locality
+/// running it.
+///
+/// @tparam FunT The type of the function to be executed.  The function
+/// prototype must be:
+/// @code
+/// void(Handle &, const ArgsT &, size_t begin, size_t end);
+/// @endcode
+/// where [begin, end) are the iterations of the chunk.
+///
+/// @tparam InArgsT The type of the argument accepted by the function.  The type
+/// can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @param handle An Handle for the associated task-group.
+/// @param affinity The locality owning each iteration.
+/// @param func The function to execute.
+/// @param args The arguments to be passed to the function.
+/// @param numIters The total number of iteration of the loop.
+/// @param policy How the iterations of a locality are split in chunks.
+template <typename FunT, typename InArgsT>
+void asyncForEachRangeOnAll(
+    Handle &handle, const IterationAffinity &affinity, FunT &&func,
+    const InArgsT &args, const size_t numIters,
+    const SchedulingPolicy &policy = SchedulingPolicy::Auto()) {
+  using FunctionTy = void (*)(Handle &, const InArgsT &, size_t, size_t);
+  FunctionTy fn = std::forward<decltype(func)>(func);
+  impl::affinityLoop(
+      &handle, affinity,
+      impl::makeLoopArgs(fn, true, false, policy, numIters, args));
+}
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_AFFINITY_H_
@@ -0,0 +1,389 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#ifndef INCLUDE_SHAD_RUNTIME_ALL_TO_ALL_H_
+#define INCLUDE_SHAD_RUNTIME_ALL_TO_ALL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "shad/runtime/runtime.h"
+
+namespace shad {
+namespace rt {
+
+template <typename T>
+class AllToAllVBuffers;
+
+namespace impl {
+
+template <typename T, typename InArgsT>
+struct AllToAllVArgs {
+  void (*pack)(const InArgsT &, AllToAllVBuffers<T> &);
+  void (*receive)(const InArgsT &, const Locality &, const T *, size_t);
+  uint64_t exchange;
+  InArgsT args;
+};
+
+struct AllToAllVRoundArgs {
+  uint64_t exchange;
+  uint32_t round;
+};
+
+template <typename T, typename InArgsT>
+void allToAllVPack(const AllToAllVArgs<T, InArgsT> &args);
+
+template <typename T, typename InArgsT>
+void allToAllVRound(const AllToAllVRoundArgs &args);
+
+/// @brief The send buffers of the exchanges in progress on the localities
+/// hosted by the process, kept between the rounds.
+class AllToAllVStates {
+ public:
+  static AllToAllVStates &Instance() {
+    static AllToAllVStates *instance = new AllToAllVStates();
+    return *instance;
+  }
+
+  void Put(uint64_t exchange, uint32_t locality,
+           std::shared_ptr<void> buffers) {
+    std::lock_guard<std::mutex> _(lock_);
+    states_[std::make_pair(exchange, locality)] = std::move(buffers);
+  }
+
+  std::shared_ptr<void> Get(uint64_t exchange, uint32_t locality) {
+    std::lock_guard<std::mutex> _(lock_);
+    return states_[std::make_pair(exchange, locality)];
+  }
+
+  void Erase(uint64_t exchange, uint32_t locality) {
+    std::lock_guard<std::mutex> _(lock_);
+    states_.erase(std::make_pair(exchange, locality));
+  }
+
+ private:
+  AllToAllVStates() = default;
+
+  std::mutex lock_;
+  std::map<std::pair<uint64_t, uint32_t>, std::shared_ptr<void>> states_;
+};
+
+/// @brief The peer of rank in a round of the pairwise exchange.
+///
+/// With a power of two number of localities, the ranks are paired (rank
+/// exchanges with rank ^ round), otherwise every rank sends to the rank round
+/// steps ahead and receives from the rank round steps behind.  In both cases
+/// every locality receives from exactly one peer per round.
+inline uint32_t allToAllVPeer(uint32_t rank, uint32_t round, uint32_t size) {
+  if ((size & (size - 1)) == 0) return rank ^ round;
+  return (rank + round) % size;
+}
+
+/// @brief The header of every chunk shipped by allToAllV.
+template <typename InArgsT>
+struct AllToAllVHeader {
+  void (*receive)();
+  uint32_t src;
+  uint32_t count;
+  InArgsT args;
+};
+
+/// Offset of the payload in a chunk, keeping the payload aligned.
+template <typename InArgsT>
+constexpr uint32_t allToAllVPayloadOffset() {
+  return (sizeof(AllToAllVHeader<InArgsT>) + alignof(std::max_align_t) - 1) &
+         ~uint32_t(alignof(std::max_align_t) - 1);
+}
+
+template <typename T, typename InArgsT>
+void allToAllVDeliver(const uint8_t *chunk) {
+  using ReceiveTy = void (*)(const InArgsT &, const Locality &, const T *,
+                             size_t);
+  // The header is not necessarily aligned in the received buffer.
+  using HeaderTy = AllToAllVHeader<InArgsT>;
+  typename std::aligned_storage<sizeof(HeaderTy), alignof(HeaderTy)>::type
+      storage;
+  std::memcpy(&storage, chunk, sizeof(storage));
+  const HeaderTy &header = *reinterpret_cast<const HeaderTy *>(&storage);
+  ReceiveTy receive = reinterpret_cast<ReceiveTy>(header.receive);
+
+  const uint8_t *payload = chunk + allToAllVPayloadOffset<InArgsT>();
+  if (reinterpret_cast<uintptr_t>(payload) % alignof(T) == 0) {
+    receive(header.args, Locality(header.src),
+            reinterpret_cast<const T *>(payload), header.count);
+    return;
+  }
+
+  // The runtime delivered a misaligned buffer: hand out an aligned copy.
+  std::unique_ptr<T[]> values(new T[header.count]);
+  std::memcpy(values.get(), payload, header.count * sizeof(T));
+  receive(header.args, Locality(header.src), values.get(), header.count);
+}
+
+template <typename T, typename InArgsT>
+void allToAllVReceive(Handle &, const uint8_t *chunk, const uint32_t) {
+  allToAllVDeliver<T, InArgsT>(chunk);
+}
+
+}  // namespace impl
+
+/// @brief Per-destination send buffers of allToAllV.
+///
+/// Values are appended to fixed-size chunks, that already reserve room for
+/// the header of the message, so that a full chunk is shipped as is.
+/// Insertions to the same destination are serialized, insertions to
+/// different destinations can proceed concurrently.
+///
+/// @tparam T The type of the values exchanged.  The type must be trivially
+/// copyable.
+template <typename T>
+class AllToAllVBuffers {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "allToAllV values must be trivially copyable");
+
+  template <typename U, typename InArgsT>
+  friend void impl::allToAllVPack(const impl::AllToAllVArgs<U, InArgsT> &);
+  template <typename U, typename InArgsT>
+  friend void impl::allToAllVRound(const impl::AllToAllVRoundArgs &);
+
+ public:
+  /// Target size in bytes of the messages shipped by allToAllV.
+  static constexpr uint32_t kChunkBytes = 1 << 16;
+
+  AllToAllVBuffers(const AllToAllVBuffers &) = delete;
+  AllToAllVBuffers &operator=(const AllToAllVBuffers &) = delete;
+
+  /// @brief Append a value to the buffer of a destination.
+  ///
+  /// @param dst The destination locality.
+  /// @param value The value to append.
+  void Insert(const Locality &dst, const T &value) { Insert(dst, &value, 1); }
+
+  /// @brief Append values to the buffer of a destination.
+  ///
+  /// @param dst The destination locality.
+  /// @param values The values to append.
+  /// @param count The number of values to append.
+  void Insert(const Locality &dst, const T *values, size_t count) {
+    Destination &destination = destinations_[static_cast<uint32_t>(dst)];
+    destination.lock.lock();
+    while (count != 0) {
+      if (destination.chunks.empty() ||
+          destination.chunks.back().count == capacity_)
+        destination.chunks.push_back(Chunk(payloadOffset_, capacity_));
+
+      Chunk &chunk = destination.chunks.back();
+      size_t n = std::min<size_t>(count, capacity_ - chunk.count);
+      std::memcpy(chunk.data.get() + payloadOffset_ + chunk.count * sizeof(T),
+                  values, n * sizeof(T));
+      chunk.count += n;
+      destination.size += n;
+      values += n;
+      count -= n;
+    }
+    destination.lock.unlock();
+  }
+
+  /// @brief The number of values appended for a destination.
+  size_t Size(const Locality &dst) const {
+    return destinations_[static_cast<uint32_t>(dst)].size;
+  }
+
+ private:
+  struct Chunk {
+    Chunk(uint32_t payloadOffset, uint32_t capacity)
+        : data(allocateArgsBuffer(payloadOffset + capacity * sizeof(T))),
+          count(0) {}
+
+    std::shared_ptr<uint8_t> data;
+    uint32_t count;
+  };
+
+  struct Destination {
+    Lock lock;
+    std::vector<Chunk> chunks;
+    size_t size = 0;
+  };
+
+  explicit AllToAllVBuffers(uint32_t payloadOffset)
+      : payloadOffset_(payloadOffset),
+        capacity_(std::max<uint32_t>(
+            (kChunkBytes - std::min(kChunkBytes, payloadOffset)) / sizeof(T),
+            1)),
+        destinations_(numLocalities()) {}
+
+  uint32_t payloadOffset_;
+  uint32_t capacity_;
+  std::vector<Destination> destinations_;
+};
+
+namespace impl {
+
+template <typename T, typename InArgsT>
+void allToAllVPack(const AllToAllVArgs<T, InArgsT> &args) {
+  constexpr uint32_t payloadOffset = allToAllVPayloadOffset<InArgsT>();
+  std::shared_ptr<AllToAllVBuffers<T>> buffers(
+      new AllToAllVBuffers<T>(payloadOffset));
+  args.pack(args.args, *buffers);
+
+  uint32_t rank = static_cast<uint32_t>(thisLocality());
+  for (auto &destination : buffers->destinations_) {
+    for (auto &chunk : destination.chunks) {
+      AllToAllVHeader<InArgsT> header{
+          reinterpret_cast<void (*)()>(args.receive), rank, chunk.count,
+          args.args};
+      std::memcpy(chunk.data.get(), &header, sizeof(header));
+    }
+  }
+  // The rounds ship the chunks of the other localities.
+  if (numLocalities() > 1)
+    AllToAllVStates::Instance().Put(args.exchange, rank, buffers);
+
+  auto &localChunks = buffers->destinations_[rank].chunks;
+  for (auto &chunk : localChunks)
+    allToAllVDeliver<T, InArgsT>(chunk.data.get());
+  localChunks.clear();
+}
+
+template <typename T, typename InArgsT>
+void allToAllVRound(const AllToAllVRoundArgs &args) {
+  constexpr uint32_t payloadOffset = allToAllVPayloadOffset<InArgsT>();
+  uint32_t rank = static_cast<uint32_t>(thisLocality());
+  uint32_t size = numLocalities();
+  auto buffers = std::static_pointer_cast<AllToAllVBuffers<T>>(
+      AllToAllVStates::Instance().Get(args.exchange, rank));
+
+  uint32_t peer = allToAllVPeer(rank, args.round, size);
+  auto &chunks = buffers->destinations_[peer].chunks;
+  Handle handle;
+  for (auto &chunk : chunks) {
+    asyncExecuteAt(handle, Locality(peer), allToAllVReceive<T, InArgsT>,
+                   chunk.data, payloadOffset + chunk.count * sizeof(T));
+  }
+  waitForCompletion(handle);
+  // Release the memory of the chunks as soon as they have been delivered.
+  chunks.clear();
+
+  if (args.round == size - 1)
+    AllToAllVStates::Instance().Erase(args.exchange, rank);
+}
+
+}  // namespace impl
+
+/// @brief Personalized all-to-all exchange of variable amounts of data.
+///
+/// Every locality runs the pack function, which appends to per-destination
+/// buffers the values to be sent to every locality (itself included).  The
+/// buffers are then exchanged in numLocalities() - 1 rounds of a pairwise
+/// exchange, so that in every round each locality receives from a single
+/// peer instead of all the localities sending to the same destination at
+/// once.  A round starts on all the localities once all of them have
+/// completed the previous one.  The values are shipped in chunks of about
+/// AllToAllVBuffers<T>::kChunkBytes bytes, and the receive function is
+/// called on the destination for every chunk, with a pointer into the
+/// received message.  The call returns when all the values have been
+/// received.
+///
+/// The receive function is called on a locality only once its pack function
+/// has returned: the values a locality sends to itself are received right
+/// after its pack, possibly while other localities are still packing, and the
+/// values from the other localities are received during the rounds, which
+/// start once every locality has packed.  The chunks of a round are received
+/// concurrently, hence the receive function must be thread-safe.
+///
+/// Typical Usage:
+/// @code
+/// void pack(const ObjectID & oid, AllToAllVBuffers<Edge> & buffers) {
+///   for (auto & edge : /* local edges of oid */)
+///     buffers.Insert(Locality(edge.src % numLocalities()), edge);
+/// }
+///
+/// void receive(const ObjectID & oid, const Locality & src,
+///              const Edge * edges, size_t count) {
+///   for (size_t i = 0; i < count; ++i) /* store edges[i] */;
+/// }
+///
+/// allToAllV<Edge>(pack, receive, oid);
+/// @endcode
+///
+/// @tparam T The type of the values exchanged.  The type must be trivially
+/// copyable.
+///
+/// @tparam FunT The type of the pack function.  The function prototype must
+/// be:
+/// @code
+/// void(const InArgsT &, AllToAllVBuffers<T> &);
+/// @endcode
+///
+/// @tparam RecvFunT The type of the receive function.  The function prototype
+/// must be:
+/// @code
+/// void(const InArgsT &, const Locality &, const T *, size_t);
+/// @endcode
+///
+/// @tparam InArgsT The type of the argument accepted by the functions.  The
+/// type can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @param pack The function filling the send buffers of a locality.
+/// @param receive The function consuming the values received by a locality.
+/// @param args The arguments to be passed to the functions.
+template <typename T, typename FunT, typename RecvFunT, typename InArgsT>
+void allToAllV(FunT &&pack, RecvFunT &&receive, const InArgsT &args) {
+  using PackTy = void (*)(const InArgsT &, AllToAllVBuffers<T> &);
+  using ReceiveTy = void (*)(const InArgsT &, const Locality &, const T *,
+                             size_t);
+  PackTy packFn = std::forward<decltype(pack)>(pack);
+  ReceiveTy receiveFn = std::forward<decltype(receive)>(receive);
+
+  // Exchanges started by different localities, or concurrently by the same
+  // locality, have different identifiers.
+  static std::atomic<uint32_t> nextExchange(0);
+  uint64_t exchange = (uint64_t(static_cast<uint32_t>(thisLocality())) << 32) |
+                      nextExchange.fetch_add(1);
+
+  impl::AllToAllVArgs<T, InArgsT> allToAllVArgs{packFn, receiveFn, exchange,
+                                                args};
+  executeOnAll(impl::allToAllVPack<T, InArgsT>, allToAllVArgs);
+  // executeOnAll returns once every locality has completed the round.
+  for (uint32_t round = 1; round < numLocalities(); ++round) {
+    executeOnAll(impl::allToAllVRound<T, InArgsT>,
+                 impl::AllToAllVRoundArgs{exchange, round});
+  }
+}
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_ALL_TO_ALL_H_
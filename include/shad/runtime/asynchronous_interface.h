@@ -29,6 +29,7 @@
 #include <cstdint>
 #include <memory>
 
+#include "shad/runtime/atomics.h"
 #include "shad/runtime/handle.h"
 #include "shad/runtime/locality.h"
 
@@ -98,6 +99,10 @@ struct AsynchronousInterface {
                                 const std::shared_ptr<uint8_t> &argsBuffer,
                                 const uint32_t bufferSize,
                                 const size_t numIters);
+
+  template <typename T>
+  static void asyncAtomic(Handle &handle, const Locality &loc,
+                          const AtomicArgs<T> &args, T *result);
 };
 
 }  // namespace impl
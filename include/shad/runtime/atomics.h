@@ -0,0 +1,110 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_ATOMICS_H_
+#define INCLUDE_SHAD_RUNTIME_ATOMICS_H_
+
+#include <cstdint>
+#include <type_traits>
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+/// @brief The read-modify-write operations on remote memory.
+enum class AtomicOp : uint32_t {
+  kFetchAdd,
+  kFetchSub,
+  kFetchAnd,
+  kFetchOr,
+  kFetchXor,
+  kCompareExchange
+};
+
+/// @brief An atomic operation on the memory of a locality.
+///
+/// @tparam T The type of the target: integral types for the fetch operations,
+/// any trivially copyable type for the compare-exchange.
+template <typename T>
+struct AtomicArgs {
+  AtomicOp op;
+  /// The target, in the memory of the locality executing the operation.
+  T *address;
+  /// The operand of the fetch operations, or the desired value of the
+  /// compare-exchange.
+  T operand;
+  /// The expected value of the compare-exchange.
+  T expected;
+};
+
+/// @brief Apply the atomic operation in the memory of the calling locality.
+///
+/// The target is accessed with the __atomic builtins, sequentially
+/// consistent, so that it can be shared with std::atomic<T> objects.
+///
+/// @return The value of the target before the operation.
+template <typename T>
+T applyAtomic(const AtomicArgs<T> &args) {
+  if (args.op == AtomicOp::kCompareExchange) {
+    T expected = args.expected;
+    T desired = args.operand;
+    __atomic_compare_exchange(args.address, &expected, &desired, false,
+                              __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return expected;
+  }
+
+  if constexpr (std::is_integral<T>::value) {
+    switch (args.op) {
+      case AtomicOp::kFetchAdd:
+        return __atomic_fetch_add(args.address, args.operand,
+                                  __ATOMIC_SEQ_CST);
+      case AtomicOp::kFetchSub:
+        return __atomic_fetch_sub(args.address, args.operand,
+                                  __ATOMIC_SEQ_CST);
+      case AtomicOp::kFetchAnd:
+        return __atomic_fetch_and(args.address, args.operand,
+                                  __ATOMIC_SEQ_CST);
+      case AtomicOp::kFetchOr:
+        return __atomic_fetch_or(args.address, args.operand,
+                                 __ATOMIC_SEQ_CST);
+      case AtomicOp::kFetchXor:
+        return __atomic_fetch_xor(args.address, args.operand,
+                                  __ATOMIC_SEQ_CST);
+      default:
+        break;
+    }
+  }
+
+  T value;
+  __atomic_load(args.address, &value, __ATOMIC_SEQ_CST);
+  return value;
+}
+
+}  // namespace impl
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_ATOMICS_H_
@@ -0,0 +1,309 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_COALESCING_H_
+#define INCLUDE_SHAD_RUNTIME_COALESCING_H_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "shad/runtime/handle.h"
+#include "shad/runtime/locality.h"
+#include "shad/runtime/mapping_traits.h"
+#include "shad/runtime/mappings/available_mappings.h"
+#include "shad/runtime/priority.h"
+#include "shad/runtime/task_arena.h"
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+/// @brief Runtime-level coalescing of small asynchronous tasks.
+///
+/// When enabled, the asyncExecuteAt calls directed to a remote locality, with
+/// a small trivially copyable argument, are packed per source locality, Handle
+/// and destination in a batch, which is shipped as a single task and unpacked
+/// on the destination.  A batch is shipped when it reaches the size threshold,
+/// when a task joins it after the time threshold expired, when its Handle is
+/// waited on the source locality, or by a flush task attached to the same
+/// Handle.  The flush task is a Priority::kBulk task, so it runs once the
+/// source locality has no more urgent work, and keeps the Handle busy until
+/// then, hence waitForCompletion covers the coalesced tasks.
+class Coalescer {
+ public:
+  /// Largest argument that is coalesced.
+  static constexpr size_t kMaxArgsSize = 256;
+  /// Default size threshold of a batch, in bytes.
+  static constexpr size_t kDefaultMaxBatchBytes = 4096;
+  /// Default time threshold of a batch, in nanoseconds.
+  static constexpr uint64_t kDefaultMaxDelayNs = 20000;
+
+  /// @brief Check if tasks with arguments of type InArgsT can be coalesced.
+  template <typename InArgsT>
+  static constexpr bool IsCoalescible() {
+    return std::is_trivially_copyable<InArgsT>::value &&
+           sizeof(InArgsT) <= kMaxArgsSize;
+  }
+
+  /// @brief Get the coalescer of the process.
+  ///
+  /// Its batches are keyed by source locality, as the localities of some
+  /// mappings share the process.
+  static Coalescer &Instance() {
+    static Coalescer instance;
+    return instance;
+  }
+
+  /// @brief Check if the coalescing is enabled.
+  static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  /// @brief Check if a task for loc has to be coalesced.
+  static bool ShouldCoalesce(const Locality &loc) {
+    return enabled_.load(std::memory_order_relaxed) &&
+           static_cast<uint32_t>(loc) !=
+               RuntimeInternalsTrait<TargetSystemTag>::ThisLocality();
+  }
+
+  /// @brief Enable or disable the coalescing on the calling process.
+  ///
+  /// @param enabled true to enable the coalescing.
+  /// @param maxBatchBytes The size threshold of a batch.
+  /// @param maxDelayNs The time threshold of a batch.
+  void Configure(bool enabled, size_t maxBatchBytes, uint64_t maxDelayNs) {
+    maxBatchBytes_ = std::max<size_t>(maxBatchBytes, RecordSize(kMaxArgsSize));
+    maxDelay_ = std::chrono::nanoseconds(maxDelayNs);
+    enabled_ = enabled;
+  }
+
+  /// @brief Add a task to the batch of handle and loc.
+  template <typename InArgsT>
+  void Enqueue(Handle &handle, const Locality &loc,
+               void (*function)(Handle &, const InArgsT &),
+               const InArgsT &args) {
+    if (handle.IsNull())
+      handle = Handle(HandleTrait<TargetSystemTag>::CreateNewHandle());
+
+    RecordHeader header{Invoke<InArgsT>,
+                        reinterpret_cast<GenericFunctionTy>(function),
+                        sizeof(InArgsT)};
+    uint32_t recordSize = RecordSize(sizeof(InArgsT));
+    uint32_t dst = static_cast<uint32_t>(loc);
+    Key key{static_cast<uint64_t>(handle), ThisLocality(), dst};
+    Shard &shard = shards_[KeyHash()(key) % kNumShards];
+
+    std::shared_ptr<uint8_t> fullData;
+    uint32_t fullSize = 0;
+    bool spawnFlush = false;
+
+    LockTrait<TargetSystemTag>::lock(shard.lock);
+    Batch &batch = shard.batches[key];
+    if (batch.size != 0 &&
+        (batch.size + recordSize > maxBatchBytes_ ||
+         std::chrono::steady_clock::now() - batch.oldest >= maxDelay_)) {
+      fullData = std::move(batch.data);
+      fullSize = batch.size;
+      batch.size = 0;
+    }
+    if (batch.size == 0) {
+      batch.data = allocateArgsBuffer(maxBatchBytes_);
+      batch.oldest = std::chrono::steady_clock::now();
+    }
+    uint8_t *record = batch.data.get() + batch.size;
+    memcpy(record, &header, sizeof(header));
+    memcpy(record + sizeof(header), &args, sizeof(InArgsT));
+    batch.size += recordSize;
+    if (!batch.flushPending) {
+      batch.flushPending = true;
+      spawnFlush = true;
+    }
+    LockTrait<TargetSystemTag>::unlock(shard.lock);
+
+    if (fullSize != 0) Ship(handle, dst, fullData, fullSize);
+    if (spawnFlush) SpawnFlush(handle, dst);
+  }
+
+  /// @brief Ship the batches of handle built on the calling locality.
+  void Flush(Handle &handle) {
+    if (handle.IsNull()) return;
+
+    uint64_t handleId = static_cast<uint64_t>(handle);
+    uint32_t src = ThisLocality();
+    for (auto &shard : shards_) {
+      std::vector<std::pair<uint32_t, Batch>> ready;
+      LockTrait<TargetSystemTag>::lock(shard.lock);
+      for (auto &entry : shard.batches) {
+        const Key &key = entry.first;
+        Batch &batch = entry.second;
+        if (key.handle != handleId || key.src != src || batch.size == 0)
+          continue;
+        // The batch stays in the map, so that its flush task finds it empty.
+        ready.emplace_back(key.dst, std::move(batch));
+        batch.size = 0;
+      }
+      LockTrait<TargetSystemTag>::unlock(shard.lock);
+
+      for (auto &batch : ready)
+        Ship(handle, batch.first, batch.second.data, batch.second.size);
+    }
+  }
+
+ private:
+  using GenericFunctionTy = void (*)();
+  using InvokerTy = void (*)(Handle &, GenericFunctionTy, const uint8_t *);
+
+  struct RecordHeader {
+    InvokerTy invoker;
+    GenericFunctionTy function;
+    uint32_t argsSize;
+  };
+
+  struct Key {
+    uint64_t handle;
+    uint32_t src;
+    uint32_t dst;
+    bool operator==(const Key &rhs) const {
+      return handle == rhs.handle && src == rhs.src && dst == rhs.dst;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key &key) const {
+      return std::hash<uint64_t>()((key.handle * 31 + key.src) * 31 + key.dst);
+    }
+  };
+
+  struct Batch {
+    std::shared_ptr<uint8_t> data;
+    uint32_t size = 0;
+    bool flushPending = false;
+    std::chrono::steady_clock::time_point oldest;
+  };
+
+  struct Shard {
+    typename LockTrait<TargetSystemTag>::LockTy lock;
+    std::unordered_map<Key, Batch, KeyHash> batches;
+  };
+
+  struct FlushArgs {
+    uint32_t dst;
+  };
+
+  static constexpr size_t kNumShards = 64;
+
+  Coalescer()
+      : maxBatchBytes_(kDefaultMaxBatchBytes),
+        maxDelay_(std::chrono::nanoseconds(kDefaultMaxDelayNs)) {}
+
+  static uint32_t ThisLocality() {
+    return RuntimeInternalsTrait<TargetSystemTag>::ThisLocality();
+  }
+
+  static constexpr uint32_t RecordSize(size_t argsSize) {
+    // Records are 8-bytes aligned.
+    return (sizeof(RecordHeader) + argsSize + 7) & ~size_t(7);
+  }
+
+  template <typename InArgsT>
+  static void Invoke(Handle &handle, GenericFunctionTy function,
+                     const uint8_t *args) {
+    // Arguments are not aligned in the batch.
+    typename std::aligned_storage<sizeof(InArgsT), alignof(InArgsT)>::type
+        storage;
+    memcpy(&storage, args, sizeof(InArgsT));
+    reinterpret_cast<void (*)(Handle &, const InArgsT &)>(function)(
+        handle, *reinterpret_cast<const InArgsT *>(&storage));
+  }
+
+  static void Unpack(Handle &handle, const uint8_t *data, const uint32_t size) {
+    for (uint32_t offset = 0; offset < size;) {
+      RecordHeader header;
+      memcpy(&header, data + offset, sizeof(header));
+      header.invoker(handle, header.function, data + offset + sizeof(header));
+      offset += RecordSize(header.argsSize);
+    }
+  }
+
+  static void FlushTask(Handle &handle, const FlushArgs &args) {
+    Instance().Flush(handle, args.dst);
+  }
+
+  void Ship(Handle &handle, uint32_t dst, const std::shared_ptr<uint8_t> &data,
+            uint32_t size) {
+    AsynchronousInterface<TargetSystemTag>::asyncExecuteAt(
+        handle, Locality(dst), Unpack, data, size);
+  }
+
+  void SpawnFlush(Handle &handle, uint32_t dst) {
+    // The flush waits behind the tasks of the locality that may still join
+    // the batch.
+    PriorityScope scope(Priority::kBulk);
+    AsynchronousInterface<TargetSystemTag>::asyncExecuteAt(
+        handle, Locality(ThisLocality()), FlushTask, FlushArgs{dst});
+  }
+
+  void Flush(Handle &handle, uint32_t dst) {
+    Key key{static_cast<uint64_t>(handle), ThisLocality(), dst};
+    Shard &shard = shards_[KeyHash()(key) % kNumShards];
+
+    LockTrait<TargetSystemTag>::lock(shard.lock);
+    auto itr = shard.batches.find(key);
+    if (itr == shard.batches.end()) {
+      LockTrait<TargetSystemTag>::unlock(shard.lock);
+      return;
+    }
+
+    Batch &batch = itr->second;
+    std::shared_ptr<uint8_t> data = std::move(batch.data);
+    uint32_t size = batch.size;
+    shard.batches.erase(itr);
+    LockTrait<TargetSystemTag>::unlock(shard.lock);
+
+    if (size != 0) Ship(handle, dst, data, size);
+  }
+
+  static std::atomic<bool> enabled_;
+
+  size_t maxBatchBytes_;
+  std::chrono::nanoseconds maxDelay_;
+  std::array<Shard, kNumShards> shards_;
+};
+
+inline std::atomic<bool> Coalescer::enabled_{false};
+
+}  // namespace impl
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_COALESCING_H_
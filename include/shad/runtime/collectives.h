@@ -0,0 +1,390 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#ifndef INCLUDE_SHAD_RUNTIME_COLLECTIVES_H_
+#define INCLUDE_SHAD_RUNTIME_COLLECTIVES_H_
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "shad/runtime/runtime.h"
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+/// @brief The rank of a locality in a collective rooted at root.
+inline uint32_t collectiveRank(uint32_t root) {
+  uint32_t size = numLocalities();
+  return (static_cast<uint32_t>(thisLocality()) + size - root) % size;
+}
+
+/// @brief The locality holding a rank in a collective rooted at root.
+inline Locality collectiveLocality(uint32_t rank, uint32_t root) {
+  return Locality((rank + root) % numLocalities());
+}
+
+/// @brief The ranks of the children of rank in the binomial tree spanning
+/// numLocalities() ranks, the largest subtree first.
+inline std::vector<uint32_t> collectiveChildren(uint32_t rank) {
+  uint32_t size = numLocalities();
+  uint32_t mask = 1;
+  if (rank == 0) {
+    while (mask < size) mask <<= 1;
+  } else {
+    mask = rank & (~rank + 1);
+  }
+
+  std::vector<uint32_t> children;
+  for (mask >>= 1; mask > 0; mask >>= 1)
+    if (rank + mask < size) children.push_back(rank + mask);
+  return children;
+}
+
+template <typename InArgsT>
+struct BroadcastArgs {
+  void (*function)(const InArgsT &);
+  uint32_t root;
+  InArgsT args;
+};
+
+template <typename InArgsT>
+void broadcastSubtree(Handle &, const BroadcastArgs<InArgsT> &args) {
+  Handle handle;
+  for (auto child : collectiveChildren(collectiveRank(args.root)))
+    asyncExecuteAt(handle, collectiveLocality(child, args.root),
+                   broadcastSubtree<InArgsT>, args);
+  args.function(args.args);
+  waitForCompletion(handle);
+}
+
+struct BroadcastBufferHeader {
+  void (*function)(const uint8_t *, const uint32_t);
+  uint32_t root;
+};
+
+inline void broadcastBufferSubtree(Handle &, const uint8_t *buffer,
+                                   const uint32_t bufferSize) {
+  BroadcastBufferHeader header;
+  std::memcpy(&header, buffer, sizeof(header));
+
+  Handle handle;
+  auto children = collectiveChildren(collectiveRank(header.root));
+  if (!children.empty()) {
+    std::shared_ptr<uint8_t> forward = allocateArgsBuffer(bufferSize);
+    std::memcpy(forward.get(), buffer, bufferSize);
+    for (auto child : children)
+      asyncExecuteAt(handle, collectiveLocality(child, header.root),
+                     broadcastBufferSubtree, forward, bufferSize);
+  }
+  header.function(buffer + sizeof(header), bufferSize - sizeof(header));
+  waitForCompletion(handle);
+}
+
+template <typename InArgsT, typename ResT>
+struct ReduceArgs {
+  void (*contribute)(const InArgsT &, ResT *);
+  ResT (*op)(const ResT &, const ResT &);
+  uint32_t root;
+  InArgsT args;
+};
+
+template <typename InArgsT, typename ResT>
+void reduceSubtree(Handle &, const ReduceArgs<InArgsT, ResT> &args,
+                   ResT *result) {
+  auto children = collectiveChildren(collectiveRank(args.root));
+  std::unique_ptr<ResT[]> partials(new ResT[children.size()]);
+
+  Handle handle;
+  for (size_t i = 0; i < children.size(); ++i)
+    asyncExecuteAtWithRet(handle, collectiveLocality(children[i], args.root),
+                          reduceSubtree<InArgsT, ResT>, args, &partials[i]);
+  args.contribute(args.args, result);
+  waitForCompletion(handle);
+
+  for (size_t i = 0; i < children.size(); ++i)
+    *result = args.op(*result, partials[i]);
+}
+
+template <typename InArgsT, typename ResT>
+struct AllReduceArgs {
+  void (*deliver)(const InArgsT &, const ResT &);
+  InArgsT args;
+  ResT value;
+};
+
+template <typename InArgsT, typename ResT>
+void allReduceDeliver(const AllReduceArgs<InArgsT, ResT> &args) {
+  args.deliver(args.args, args.value);
+}
+
+inline void barrierArrive(const uint32_t &) {}
+
+template <typename ResT>
+ResT collectiveSum(const ResT &lhs, const ResT &rhs) {
+  return lhs + rhs;
+}
+
+}  // namespace impl
+
+/// @brief Execute a function on all localities, propagating it along a
+/// binomial tree rooted at the calling locality.
+///
+/// Every locality forwards the call to its children before running the
+/// function, so the latency is logarithmic in the number of localities and
+/// no locality sends more than log2(numLocalities()) messages.  The call
+/// returns when the function has completed on all localities.
+///
+/// Typical Usage:
+/// @code
+/// struct Args {
+///   int a;
+///   char b;
+/// };
+///
+/// void configure(const Args & args) { /* set up local state */ }
+///
+/// Args args { 2, 'a' };
+/// broadcast(configure, args);
+/// @endcode
+///
+/// @tparam FunT The type of the function to be executed.  The function
+/// prototype must be:
+/// @code
+/// void(const InArgsT &);
+/// @endcode
+///
+/// @tparam InArgsT The type of the argument accepted by the function.  The type
+/// can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @param func The function to execute.
+/// @param args The arguments to be passed to the function.
+template <typename FunT, typename InArgsT>
+void broadcast(FunT &&func, const InArgsT &args) {
+  using FunctionTy = void (*)(const InArgsT &);
+  FunctionTy fn = std::forward<decltype(func)>(func);
+
+  Handle handle;
+  impl::BroadcastArgs<InArgsT> broadcastArgs{
+      fn, static_cast<uint32_t>(thisLocality()), args};
+  impl::broadcastSubtree(handle, broadcastArgs);
+}
+
+/// @brief Execute a function taking a buffer on all localities, propagating
+/// it along a binomial tree rooted at the calling locality.
+///
+/// @tparam FunT The type of the function to be executed.  The function
+/// prototype must be:
+/// @code
+/// void(const uint8_t *, const uint32_t);
+/// @endcode
+///
+/// @param func The function to execute.
+/// @param argsBuffer A buffer of bytes to be passed to the function.
+/// @param bufferSize The size of the buffer argsBuffer passed.
+template <typename FunT>
+void broadcast(FunT &&func, const std::shared_ptr<uint8_t> &argsBuffer,
+               const uint32_t bufferSize) {
+  using FunctionTy = void (*)(const uint8_t *, const uint32_t);
+  FunctionTy fn = std::forward<decltype(func)>(func);
+
+  impl::BroadcastBufferHeader header{fn,
+                                     static_cast<uint32_t>(thisLocality())};
+  const uint32_t size = sizeof(header) + bufferSize;
+  std::unique_ptr<uint8_t[]> buffer(new uint8_t[size]);
+  std::memcpy(buffer.get(), &header, sizeof(header));
+  std::memcpy(buffer.get() + sizeof(header), argsBuffer.get(), bufferSize);
+
+  Handle handle;
+  impl::broadcastBufferSubtree(handle, buffer.get(), size);
+}
+
+/// @brief Combine a value contributed by every locality.
+///
+/// Partial results are combined along a binomial tree rooted at the calling
+/// locality: every locality waits for the partial results of its children,
+/// combines them with its own contribution and hands the result to its
+/// parent.  Compared to querying every locality from the caller, the
+/// latency is logarithmic in the number of localities and the caller only
+/// combines log2(numLocalities()) partial results.
+///
+/// Typical Usage:
+/// @code
+/// void localCount(const ObjectID & oid, size_t * count) {
+///   *count = /* the number of local elements of oid */;
+/// }
+///
+/// size_t max(const size_t & a, const size_t & b) { return std::max(a, b); }
+///
+/// size_t largest;
+/// reduce(localCount, oid, max, &largest);
+/// @endcode
+///
+/// @tparam FunT The type of the function computing the contribution of a
+/// locality.  The function prototype must be:
+/// @code
+/// void(const InArgsT &, ResT *);
+/// @endcode
+///
+/// @tparam InArgsT The type of the argument accepted by the function.  The type
+/// can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @tparam OpT The type of the combining operator.  The operator prototype
+/// must be:
+/// @code
+/// ResT(const ResT &, const ResT &);
+/// @endcode
+/// and the operator must be associative and commutative.
+///
+/// @tparam ResT The type of the result value.  The type can be a structure or a
+/// class (e.g., std::array for element-wise reductions) but with the
+/// restriction that must be memcopy-able.
+///
+/// @param func The function computing the contribution of a locality.
+/// @param args The arguments to be passed to the function.
+/// @param op The combining operator.
+/// @param result The location where to store the result.
+template <typename FunT, typename InArgsT, typename OpT, typename ResT>
+void reduce(FunT &&func, const InArgsT &args, OpT &&op, ResT *result) {
+  using FunctionTy = void (*)(const InArgsT &, ResT *);
+  using OperatorTy = ResT (*)(const ResT &, const ResT &);
+  FunctionTy fn = std::forward<decltype(func)>(func);
+  OperatorTy opFn = std::forward<decltype(op)>(op);
+
+  Handle handle;
+  impl::ReduceArgs<InArgsT, ResT> reduceArgs{
+      fn, opFn, static_cast<uint32_t>(thisLocality()), args};
+  impl::reduceSubtree(handle, reduceArgs, result);
+}
+
+/// @brief Sum a value contributed by every locality.
+///
+/// Typical Usage:
+/// @code
+/// void localCount(const ObjectID & oid, size_t * count) {
+///   *count = /* the number of local elements of oid */;
+/// }
+///
+/// size_t total;
+/// reduce(localCount, oid, &total);
+/// @endcode
+///
+/// @tparam FunT The type of the function computing the contribution of a
+/// locality.  The function prototype must be:
+/// @code
+/// void(const InArgsT &, ResT *);
+/// @endcode
+///
+/// @param func The function computing the contribution of a locality.
+/// @param args The arguments to be passed to the function.
+/// @param result The location where to store the sum.
+template <typename FunT, typename InArgsT, typename ResT>
+void reduce(FunT &&func, const InArgsT &args, ResT *result) {
+  rt::reduce(std::forward<FunT>(func), args, impl::collectiveSum<ResT>,
+             result);
+}
+
+/// @brief Combine a value contributed by every locality and deliver the
+/// result to all localities.
+///
+/// The values are combined as in reduce(), and the result is then sent down
+/// the same binomial tree as in broadcast().
+///
+/// Typical Usage:
+/// @code
+/// double localError;
+/// double globalError;
+///
+/// void getError(const uint8_t &, double * error) { *error = localError; }
+/// void setError(const uint8_t &, const double & error) {
+///   globalError = error;
+/// }
+///
+/// double sum(const double & a, const double & b) { return a + b; }
+///
+/// double error;
+/// allReduce(getError, uint8_t(0), sum, setError, &error);
+/// @endcode
+///
+/// @tparam FunT The type of the function computing the contribution of a
+/// locality.  The function prototype must be:
+/// @code
+/// void(const InArgsT &, ResT *);
+/// @endcode
+///
+/// @tparam InArgsT The type of the argument accepted by the functions.  The
+/// type can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @tparam OpT The type of the combining operator.  The operator prototype
+/// must be:
+/// @code
+/// ResT(const ResT &, const ResT &);
+/// @endcode
+/// and the operator must be associative and commutative.
+///
+/// @tparam DeliverT The type of the function receiving the result on every
+/// locality.  The function prototype must be:
+/// @code
+/// void(const InArgsT &, const ResT &);
+/// @endcode
+///
+/// @tparam ResT The type of the result value.  The type can be a structure or a
+/// class but with the restriction that must be memcopy-able.
+///
+/// @param func The function computing the contribution of a locality.
+/// @param args The arguments to be passed to the functions.
+/// @param op The combining operator.
+/// @param deliver The function receiving the result on every locality.
+/// @param result The location where to store the result.
+template <typename FunT, typename InArgsT, typename OpT, typename DeliverT,
+          typename ResT>
+void allReduce(FunT &&func, const InArgsT &args, OpT &&op, DeliverT &&deliver,
+               ResT *result) {
+  using DeliverTy = void (*)(const InArgsT &, const ResT &);
+  DeliverTy deliverFn = std::forward<decltype(deliver)>(deliver);
+
+  rt::reduce(std::forward<FunT>(func), args, std::forward<OpT>(op), result);
+
+  impl::AllReduceArgs<InArgsT, ResT> deliverArgs{deliverFn, args, *result};
+  rt::broadcast(impl::allReduceDeliver<InArgsT, ResT>, deliverArgs);
+}
+
+/// @brief Synchronize with all localities.
+///
+/// The call returns once every locality has been reached along a binomial
+/// tree rooted at the calling locality, and has answered.
+inline void barrier() { rt::broadcast(impl::barrierArrive, uint32_t(0)); }
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_COLLECTIVES_H_
@@ -0,0 +1,139 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_DMA_H_
+#define INCLUDE_SHAD_RUNTIME_DMA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace shad {
+namespace rt {
+
+/// @brief A run of contiguous elements in the memory of a locality.
+///
+/// Lists of segments describe the remote side of the vectored transfers
+/// (dmaScatter, dmaGather), in the style of an iovec.
+///
+/// @tparam T The type of the elements.
+template <typename T>
+struct DmaSegment {
+  /// The address of the first element.
+  const T *address;
+  /// The number of elements.
+  size_t numElements;
+};
+
+namespace impl {
+
+/// @brief The segments of the strided transfers: count elements starting at
+/// base, stride elements apart.
+template <typename T>
+struct DmaStride {
+  const T *base;
+  size_t stride;
+  size_t count;
+};
+
+/// @brief Copy the segments into the contiguous buffer.
+template <typename T>
+void gatherSegments(const T *buffer, const DmaSegment<T> *segments,
+                    size_t numSegments) {
+  auto out = reinterpret_cast<uint8_t *>(const_cast<T *>(buffer));
+  for (size_t i = 0; i < numSegments; ++i) {
+    size_t numBytes = segments[i].numElements * sizeof(T);
+    memcpy(out, segments[i].address, numBytes);
+    out += numBytes;
+  }
+}
+
+/// @brief Copy the contiguous buffer into the segments.
+template <typename T>
+void scatterSegments(const DmaSegment<T> *segments, size_t numSegments,
+                     const T *buffer) {
+  auto in = reinterpret_cast<const uint8_t *>(buffer);
+  for (size_t i = 0; i < numSegments; ++i) {
+    size_t numBytes = segments[i].numElements * sizeof(T);
+    memcpy(const_cast<T *>(segments[i].address), in, numBytes);
+    in += numBytes;
+  }
+}
+
+/// @brief Copy the strided elements into the contiguous buffer.
+template <typename T>
+void gatherStrided(const T *buffer, const DmaStride<T> &stride) {
+  auto out = const_cast<T *>(buffer);
+  for (size_t i = 0; i < stride.count; ++i)
+    memcpy(out + i, stride.base + i * stride.stride, sizeof(T));
+}
+
+/// @brief Copy the contiguous buffer into the strided elements.
+template <typename T>
+void scatterStrided(const DmaStride<T> &stride, const T *buffer) {
+  auto out = const_cast<T *>(stride.base);
+  for (size_t i = 0; i < stride.count; ++i)
+    memcpy(out + i * stride.stride, buffer + i, sizeof(T));
+}
+
+/// @brief Total number of elements of the segments.
+template <typename T>
+size_t numSegmentElements(const DmaSegment<T> *segments, size_t numSegments) {
+  size_t numElements = 0;
+  for (size_t i = 0; i < numSegments; ++i)
+    numElements += segments[i].numElements;
+  return numElements;
+}
+
+/// @brief The segments, with their size in bytes, for the mappings moving
+/// raw memory.
+template <typename T>
+std::vector<DmaSegment<uint8_t>> byteSegments(const DmaSegment<T> *segments,
+                                              size_t numSegments) {
+  std::vector<DmaSegment<uint8_t>> result(numSegments);
+  for (size_t i = 0; i < numSegments; ++i)
+    result[i] = {reinterpret_cast<const uint8_t *>(segments[i].address),
+                 segments[i].numElements * sizeof(T)};
+  return result;
+}
+
+/// @brief The strided elements as segments of one element each, for the
+/// mappings moving raw memory.
+template <typename T>
+std::vector<DmaSegment<uint8_t>> byteSegments(const DmaStride<T> &stride) {
+  std::vector<DmaSegment<uint8_t>> result(stride.count);
+  for (size_t i = 0; i < stride.count; ++i)
+    result[i] = {reinterpret_cast<const uint8_t *>(stride.base +
+                                                   i * stride.stride),
+                 sizeof(T)};
+  return result;
+}
+
+}  // namespace impl
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_DMA_H_
@@ -0,0 +1,391 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_FUTURE_H_
+#define INCLUDE_SHAD_RUNTIME_FUTURE_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#include <exception>
+#endif
+
+#include "shad/runtime/runtime.h"
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+/// @brief The state shared by a Future and the operation producing its value.
+template <typename T>
+struct FutureState {
+  using ContinuationTy = std::function<void(Handle &, const T &)>;
+
+  explicit FutureState(const Handle &handle) : handle(handle) {}
+
+  /// @brief Store the value and run the pending continuations.
+  void SetValue(Handle &taskHandle, const T &result) {
+    std::vector<ContinuationTy> pending;
+    lock.lock();
+    value = result;
+    ready = true;
+    pending.swap(continuations);
+    lock.unlock();
+
+    for (auto &continuation : pending) continuation(taskHandle, value);
+  }
+
+  /// @brief Register a continuation.
+  ///
+  /// @return false if the value is already available, and the continuation
+  /// has not been registered.
+  bool AddContinuation(ContinuationTy &&continuation) {
+    lock.lock();
+    if (ready) {
+      lock.unlock();
+      return false;
+    }
+    continuations.emplace_back(std::move(continuation));
+    lock.unlock();
+    return true;
+  }
+
+  Handle handle;
+  T value;
+  bool ready = false;
+  Lock lock;
+  std::vector<ContinuationTy> continuations;
+};
+
+template <typename FunctionTy, typename InArgsT, typename ResT>
+struct FutureCallArgs {
+  FunctionTy function;
+  uint32_t origin;
+  uint64_t token;
+  InArgsT args;
+};
+
+template <typename ResT>
+struct FutureResultArgs {
+  uint64_t token;
+  ResT result;
+};
+
+template <typename ResT>
+void futureComplete(Handle &handle, const FutureResultArgs<ResT> &args) {
+  // The token holds a reference to the state until the value is delivered.
+  auto *token = reinterpret_cast<std::shared_ptr<FutureState<ResT>> *>(
+      static_cast<uintptr_t>(args.token));
+  (*token)->SetValue(handle, args.result);
+  delete token;
+}
+
+template <typename FunctionTy, typename InArgsT, typename ResT>
+void futureCall(Handle &handle,
+                const FutureCallArgs<FunctionTy, InArgsT, ResT> &args) {
+  FutureResultArgs<ResT> result{args.token, ResT()};
+  args.function(handle, args.args, &result.result);
+
+  if (args.origin == static_cast<uint32_t>(thisLocality())) {
+    futureComplete(handle, result);
+    return;
+  }
+  asyncExecuteAt(handle, Locality(args.origin), futureComplete<ResT>, result);
+}
+
+/// @brief Extract the result type of a function run by asyncExecuteAtWithRet.
+template <typename FunctionTy>
+struct FutureResultOf;
+
+template <typename InArgsT, typename ResT>
+struct FutureResultOf<void (*)(Handle &, const InArgsT &, ResT *)> {
+  using type = ResT;
+};
+
+}  // namespace impl
+
+/// @brief The result of an asynchronous operation.
+///
+/// A Future is produced by asyncExecuteAtWithRet, and its value is delivered
+/// to the locality that started the operation as soon as the remote function
+/// returns.  Continuations registered with then() run on that locality as
+/// part of the task-group of the operation, so that dependent operations can
+/// be chained without waiting for the whole task-group.
+///
+/// @tparam T The type of the value.  The type must be memcopy-able.
+template <typename T>
+class Future {
+ public:
+  /// @brief Constructor.  Creates an invalid Future.
+  Future() = default;
+
+  /// @brief Constructor.
+  /// @param state The state shared with the operation producing the value.
+  explicit Future(const std::shared_ptr<impl::FutureState<T>> &state)
+      : state_(state) {}
+
+  /// @brief Check if the Future is associated to an operation.
+  bool valid() const { return state_ != nullptr; }
+
+  /// @brief Check if the value is available.
+  bool ready() const {
+    state_->lock.lock();
+    bool ready = state_->ready;
+    state_->lock.unlock();
+    return ready;
+  }
+
+  /// @brief Get the value.
+  ///
+  /// The value is available once the Handle of the operation has been
+  /// waited, or within continuations.
+  ///
+  /// @return The value produced by the operation.
+  const T &get() const {
+    if (!ready()) {
+      std::stringstream ss;
+      ss << "The value of the Future is not available yet.  Wait for the"
+         << " Handle of the operation or use then().";
+      throw std::system_error(0xdeadc0de, std::generic_category(), ss.str());
+    }
+    return state_->value;
+  }
+
+  /// @brief Register a continuation.
+  ///
+  /// The continuation is executed on the locality that started the operation,
+  /// as part of its task-group, once the value is available.  It must be
+  /// registered before the Handle of the operation is waited.
+  ///
+  /// Typical Usage:
+  /// @code
+  /// void lookup(Handle &, const Key &key, Value *result) { /* lookup */ }
+  /// void update(Handle &, const Value &value) { /* update */ }
+  ///
+  /// Handle handle;
+  /// auto future = asyncExecuteAtWithRet(handle, locality, lookup, key);
+  /// future.then([](Handle &handle, const Value &value) {
+  ///   asyncExecuteAt(handle, owner(value), update, value);
+  /// });
+  ///
+  /// waitForCompletion(handle);
+  /// @endcode
+  ///
+  /// @tparam FunT The type of the continuation.  The prototype must be:
+  /// @code
+  /// void(Handle &, const T &);
+  /// @endcode
+  ///
+  /// @param func The continuation.
+  template <typename FunT>
+  void then(FunT &&func) {
+    typename impl::FutureState<T>::ContinuationTy continuation(
+        std::forward<FunT>(func));
+    if (!state_->AddContinuation(std::move(continuation)))
+      continuation(state_->handle, state_->value);
+  }
+
+#if defined(__cpp_impl_coroutine)
+  /// @brief Awaiter suspending a coroutine until the value is available.
+  ///
+  /// The coroutine is resumed on the locality that started the operation,
+  /// as part of its task-group.
+  struct Awaiter {
+    std::shared_ptr<impl::FutureState<T>> state;
+
+    bool await_ready() const { return false; }
+
+    bool await_suspend(std::coroutine_handle<> coroutine) {
+      return state->AddContinuation(
+          [coroutine](Handle &, const T &) { coroutine.resume(); });
+    }
+
+    const T &await_resume() const { return state->value; }
+  };
+
+  /// @brief Suspend a coroutine until the value is available.
+  Awaiter operator co_await() const { return Awaiter{state_}; }
+#endif
+
+ private:
+  std::shared_ptr<impl::FutureState<T>> state_;
+};
+
+/// @brief Execute a function on a selected locality asynchronously and get a
+/// Future of its result.
+///
+/// Typical Usage:
+/// @code
+/// struct Args {
+///   int a;
+///   char b;
+/// };
+///
+/// void task(Handle &, const Args &args, int *result) { *result = args.a; }
+///
+/// Args args { 2, 'a' };
+/// Handle handle;
+/// auto future = asyncExecuteAtWithRet(handle, locality, task, args);
+/// future.then([](Handle &handle, const int &result) { /* continue */ });
+///
+/// waitForCompletion(handle);
+/// int result = future.get();
+/// @endcode
+///
+/// @tparam FunT The type of the function to be executed.  The function must
+/// be convertible to a function pointer with prototype:
+/// @code
+/// void(Handle &, const InArgsT &, ResT *);
+/// @endcode
+///
+/// @tparam InArgsT The type of the argument accepted by the function.  The type
+/// can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @param handle An Handle for the associated task-group.
+/// @param loc The Locality where the function must be executed.
+/// @param func The function to execute.
+/// @param args The arguments to be passed to the function.
+///
+/// @return A Future of the value written by the function in its last argument.
+template <typename FunT, typename InArgsT>
+auto asyncExecuteAtWithRet(Handle &handle, const Locality &loc, FunT &&func,
+                           const InArgsT &args) {
+  using FunctionTy = decltype(+std::declval<std::decay_t<FunT>>());
+  using ResT = typename impl::FutureResultOf<FunctionTy>::type;
+  static_assert(std::is_trivially_copyable<ResT>::value,
+                "The result type must be memcopy-able.");
+
+  if (handle.IsNull()) handle = impl::createHandle();
+
+  auto state = std::make_shared<impl::FutureState<ResT>>(handle);
+  auto *token = new std::shared_ptr<impl::FutureState<ResT>>(state);
+
+  impl::FutureCallArgs<FunctionTy, InArgsT, ResT> callArgs{
+      +func, static_cast<uint32_t>(thisLocality()),
+      static_cast<uint64_t>(reinterpret_cast<uintptr_t>(token)), args};
+  asyncExecuteAt(handle, loc, impl::futureCall<FunctionTy, InArgsT, ResT>,
+                 callArgs);
+  return Future<ResT>(state);
+}
+
+#if defined(__cpp_impl_coroutine)
+namespace impl {
+
+struct HandleResumeArgs {
+  uint64_t awaited;
+  uint64_t coroutine;
+};
+
+inline void resumeAfterCompletion(Handle &, const HandleResumeArgs &args) {
+  std::unique_ptr<Handle> awaited(
+      reinterpret_cast<Handle *>(static_cast<uintptr_t>(args.awaited)));
+  waitForCompletion(*awaited);
+  std::coroutine_handle<>::from_address(
+      reinterpret_cast<void *>(static_cast<uintptr_t>(args.coroutine)))
+      .resume();
+}
+
+}  // namespace impl
+
+/// @brief Awaiter suspending a coroutine until a Handle has completed.
+///
+/// The coroutine is resumed by a task spawned on group, which waits for
+/// handle, so that neither the caller of the coroutine nor its locality are
+/// blocked while handle completes.
+struct HandleAwaiter {
+  Handle &group;
+  Handle &handle;
+
+  bool await_ready() const { return handle.IsNull(); }
+
+  void await_suspend(std::coroutine_handle<> coroutine) {
+    impl::HandleResumeArgs args{
+        static_cast<uint64_t>(reinterpret_cast<uintptr_t>(new Handle(handle))),
+        static_cast<uint64_t>(
+            reinterpret_cast<uintptr_t>(coroutine.address()))};
+    asyncExecuteAt(group, thisLocality(), impl::resumeAfterCompletion, args);
+  }
+
+  void await_resume() const {}
+};
+
+/// @brief Wait for the completion of handle from a coroutine.
+///
+/// Typical Usage:
+/// @code
+/// Coroutine gatherAndReduce(Handle group) {
+///   Handle gather;
+///   for (auto &locality : allLocalities())
+///     asyncExecuteAt(gather, locality, collect, args);
+///   co_await completionOf(group, gather);
+///   asyncExecuteAt(group, thisLocality(), reduce, args);
+/// }
+/// @endcode
+///
+/// @param group The task-group of the coroutine.  The coroutine is resumed by
+/// a task of group.  It must be a different task-group than handle.
+/// @param handle The Handle to wait for.
+inline HandleAwaiter completionOf(Handle &group, Handle &handle) {
+  return HandleAwaiter{group, handle};
+}
+
+/// @brief A fire-and-forget coroutine.
+///
+/// The coroutine runs until its first suspension point on the caller, and is
+/// resumed by the operations it awaits.  Operations awaited must belong to a
+/// task-group that is waited, in order to wait for the coroutine.
+///
+/// Typical Usage:
+/// @code
+/// Coroutine lookupAndUpdate(Handle handle, Key key) {
+///   Value value = co_await asyncExecuteAtWithRet(handle, owner(key), lookup,
+///                                                key);
+///   asyncExecuteAt(handle, owner(value), update, value);
+/// }
+/// @endcode
+struct Coroutine {
+  struct promise_type {
+    Coroutine get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+#endif
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_FUTURE_H_
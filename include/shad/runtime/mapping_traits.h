@@ -28,6 +28,7 @@
 #include <string>
 
 #include "shad/config/config.h"
+#include "shad/runtime/priority.h"
 
 namespace shad {
 
@@ -72,6 +73,16 @@ struct RuntimeInternalsTrait {
   static uint32_t ThisLocality();
   static uint32_t NullLocality();
   static uint32_t NumLocalities();
+
+  /// @brief Number of localities hosted by the calling process.
+  static uint32_t NumProcessLocalities();
+  /// @brief Index of the calling locality among the ones hosted by the
+  /// calling process.
+  static uint32_t ProcessLocalityIndex();
+
+  /// @brief Number of tasks of class p waiting to be executed on the
+  /// calling locality.
+  static size_t QueueDepth(Priority p);
 };
 
 }  // namespace impl
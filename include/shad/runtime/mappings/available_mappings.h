@@ -28,6 +28,15 @@
 #if defined HAVE_CPP_SIMPLE
 #include "shad/runtime/mappings/cpp_simple/cpp_simple_asynchronous_interface.h"
 #include "shad/runtime/mappings/cpp_simple/cpp_simple_synchronous_interface.h"
+#elif defined HAVE_SIM
+#include "shad/runtime/mappings/sim/sim_asynchronous_interface.h"
+#include "shad/runtime/mappings/sim/sim_synchronous_interface.h"
+#elif defined HAVE_SHM
+#include "shad/runtime/mappings/shm/shm_asynchronous_interface.h"
+#include "shad/runtime/mappings/shm/shm_synchronous_interface.h"
+#elif defined HAVE_WS
+#include "shad/runtime/mappings/ws/ws_asynchronous_interface.h"
+#include "shad/runtime/mappings/ws/ws_synchronous_interface.h"
 #elif defined HAVE_TBB
 #include "shad/runtime/mappings/tbb/tbb_asynchronous_interface.h"
 #include "shad/runtime/mappings/tbb/tbb_synchronous_interface.h"
@@ -27,6 +27,12 @@
 
 #if defined HAVE_CPP_SIMPLE
 #include "shad/runtime/mappings/cpp_simple/cpp_simple_traits_mapping.h"
+#elif defined HAVE_SIM
+#include "shad/runtime/mappings/sim/sim_traits_mapping.h"
+#elif defined HAVE_SHM
+#include "shad/runtime/mappings/shm/shm_traits_mapping.h"
+#elif defined HAVE_WS
+#include "shad/runtime/mappings/ws/ws_traits_mapping.h"
 #elif defined HAVE_TBB
 #include "shad/runtime/mappings/tbb/tbb_traits_mapping.h"
 #elif defined HAVE_GMT
@@ -193,6 +193,13 @@ struct AsynchronousInterface<cpp_tag> {
     for (auto i = 0; i < numIters; ++i)
       fn(handle, argsBuffer.get(), bufferSize, i);
   }
+
+  template <typename T>
+  static void asyncAtomic(Handle &, const Locality &,
+                          const AtomicArgs<T> &args, T *result) {
+    T value = applyAtomic(args);
+    if (result != nullptr) *result = value;
+  }
 };
 
 }  // namespace impl
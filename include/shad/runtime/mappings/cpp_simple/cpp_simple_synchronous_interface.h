@@ -167,6 +167,38 @@ struct SynchronousInterface<cpp_tag> {
     memcpy((uint8_t*)localAddress, (uint8_t*)remoteData,
            numElements*sizeof(T));
   }
+
+  template <typename T>
+  static void dmaScatter(const Locality &, const DmaSegment<T> *remoteSegments,
+                         const size_t numSegments, const T *localData) {
+    scatterSegments(remoteSegments, numSegments, localData);
+  }
+
+  template <typename T>
+  static void dmaGather(const T *localAddress, const Locality &,
+                        const DmaSegment<T> *remoteSegments,
+                        const size_t numSegments) {
+    gatherSegments(localAddress, remoteSegments, numSegments);
+  }
+
+  template <typename T>
+  static void dmaStrided(const Locality &, const T *remoteBase,
+                         const size_t stride, const T *localData,
+                         const size_t numElements) {
+    scatterStrided(DmaStride<T>{remoteBase, stride, numElements}, localData);
+  }
+
+  template <typename T>
+  static void dmaStrided(const T *localAddress, const Locality &,
+                         const T *remoteBase, const size_t stride,
+                         const size_t numElements) {
+    gatherStrided(localAddress, DmaStride<T>{remoteBase, stride, numElements});
+  }
+
+  template <typename T>
+  static T atomic(const Locality &, const AtomicArgs<T> &args) {
+    return applyAtomic(args);
+  }
 };
 
 }  // namespace impl
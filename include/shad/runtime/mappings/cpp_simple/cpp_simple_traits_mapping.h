@@ -87,6 +87,12 @@ struct RuntimeInternalsTrait<cpp_tag> {
   static uint32_t ThisLocality() { return 0; }
   static uint32_t NullLocality() { return -1; }
   static uint32_t NumLocalities() { return 1; }
+
+  static uint32_t NumProcessLocalities() { return 1; }
+  static uint32_t ProcessLocalityIndex() { return 0; }
+
+  // Tasks are executed in place: nothing is ever queued.
+  static size_t QueueDepth(Priority p) { return 0; }
 };
 
 }  // namespace impl
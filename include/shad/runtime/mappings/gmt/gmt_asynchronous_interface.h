@@ -55,16 +55,17 @@ struct AsynchronousInterface<gmt_tag> {
     FunctionTy fn = std::forward<decltype(function)>(function);
 
     checkLocality(loc);
-    checkInputSize(sizeof(InArgsT));
 
     ExecFunWrapperArgs<FunctionTy, InArgsT> funArgs{fn, args};
 
     handle = (handle.IsNull()) ? Handle(HandleTrait<gmt_tag>::CreateNewHandle())
                                : handle;
+    TaskPayload payload(execAsyncFunWrapper<FunT, InArgsT>,
+                        reinterpret_cast<const uint8_t *>(&funArgs),
+                        sizeof(funArgs), 1);
     gmt_execute_on_node_with_handle(
-        getNodeId(loc), execAsyncFunWrapper<FunT, InArgsT>,
-        reinterpret_cast<const uint8_t *>(&funArgs), sizeof(funArgs), nullptr,
-        nullptr, GMT_PREEMPTABLE, getGmtHandle(handle));
+        getNodeId(loc), payload.task(), payload.args(), payload.size(),
+        nullptr, nullptr, GMT_PREEMPTABLE, getGmtHandle(handle));
   }
 
   template <typename FunT>
@@ -77,7 +78,6 @@ struct AsynchronousInterface<gmt_tag> {
     FunctionTy fn = std::forward<decltype(function)>(function);
 
     checkLocality(loc);
-    checkInputSize(bufferSize);
 
     uint32_t newBufferSize = bufferSize + sizeof(fn);
     std::unique_ptr<uint8_t[]> buffer(new uint8_t[newBufferSize]);
@@ -90,8 +90,9 @@ struct AsynchronousInterface<gmt_tag> {
     handle = (handle.IsNull()) ? Handle(HandleTrait<gmt_tag>::CreateNewHandle())
                                : handle;
 
+    TaskPayload payload(execAsyncFunWrapper, buffer.get(), newBufferSize, 1);
     gmt_execute_on_node_with_handle(
-        getNodeId(loc), execAsyncFunWrapper, buffer.get(), newBufferSize,
+        getNodeId(loc), payload.task(), payload.args(), payload.size(),
         nullptr, nullptr, GMT_PREEMPTABLE, getGmtHandle(handle));
   }
 
@@ -106,17 +107,20 @@ struct AsynchronousInterface<gmt_tag> {
     FunctionTy fn = std::forward<decltype(function)>(function);
 
     checkLocality(loc);
-    checkInputSize(sizeof(InArgsT));
 
-    ExecFunWrapperArgs<FunctionTy, InArgsT> funArgs{fn, args};
+    ResultTarget target{gmt_node_id(), resultBuffer, resultSize, true};
+    ExecFunWithRetBuffWrapperArgs<FunctionTy, InArgsT> funArgs{target, fn,
+                                                               args};
 
     handle = (handle.IsNull()) ? Handle(HandleTrait<gmt_tag>::CreateNewHandle())
                                : handle;
 
+    TaskPayload payload(asyncExecFunWithRetBuffWrapper<FunctionTy, InArgsT>,
+                        reinterpret_cast<const uint8_t *>(&funArgs),
+                        sizeof(funArgs), 1);
     gmt_execute_on_node_with_handle(
-        getNodeId(loc), asyncExecFunWithRetBuffWrapper<FunctionTy, InArgsT>,
-        reinterpret_cast<const uint8_t *>(&funArgs), sizeof(funArgs),
-        resultBuffer, resultSize, GMT_PREEMPTABLE, getGmtHandle(handle));
+        getNodeId(loc), payload.task(), payload.args(), payload.size(),
+        nullptr, nullptr, GMT_PREEMPTABLE, getGmtHandle(handle));
   }
 
   template <typename FunT>
@@ -130,23 +134,27 @@ struct AsynchronousInterface<gmt_tag> {
     FunctionTy fn = std::forward<decltype(function)>(function);
 
     checkLocality(loc);
-    checkInputSize(bufferSize);
 
-    uint32_t newBufferSize = bufferSize + sizeof(fn);
+    ResultTarget target{gmt_node_id(), resultBuffer, resultSize, true};
+
+    uint32_t newBufferSize = bufferSize + sizeof(target) + sizeof(fn);
     std::unique_ptr<uint8_t[]> buffer(new uint8_t[newBufferSize]);
 
-    *reinterpret_cast<FunctionTy *>(const_cast<uint8_t *>(buffer.get())) = fn;
+    memcpy(buffer.get(), &target, sizeof(target));
+    memcpy(buffer.get() + sizeof(target), &fn, sizeof(fn));
 
     if (argsBuffer != nullptr && bufferSize)
-      memcpy(buffer.get() + sizeof(fn), argsBuffer.get(), bufferSize);
+      memcpy(buffer.get() + sizeof(target) + sizeof(fn), argsBuffer.get(),
+             bufferSize);
 
     handle = (handle.IsNull()) ? Handle(HandleTrait<gmt_tag>::CreateNewHandle())
                                : handle;
 
+    TaskPayload payload(asyncExecFunWithRetBuffWrapper, buffer.get(),
+                        newBufferSize, 1);
     gmt_execute_on_node_with_handle(
-        getNodeId(loc), asyncExecFunWithRetBuffWrapper, buffer.get(),
-        newBufferSize, resultBuffer, resultSize, GMT_PREEMPTABLE,
-        getGmtHandle(handle));
+        getNodeId(loc), payload.task(), payload.args(), payload.size(),
+        nullptr, nullptr, GMT_PREEMPTABLE, getGmtHandle(handle));
   }
 
   template <typename FunT, typename ResT>
@@ -160,7 +168,6 @@ struct AsynchronousInterface<gmt_tag> {
     FunctionTy fn = std::forward<decltype(function)>(function);
 
     checkLocality(loc);
-    checkInputSize(bufferSize);
 
     uint32_t newBufferSize = bufferSize + sizeof(fn);
     std::unique_ptr<uint8_t[]> buffer(new uint8_t[newBufferSize]);
@@ -173,10 +180,11 @@ struct AsynchronousInterface<gmt_tag> {
     handle = (handle.IsNull()) ? Handle(HandleTrait<gmt_tag>::CreateNewHandle())
                                : handle;
 
+    TaskPayload payload(asyncExecFunWithRetWrapper<ResT>, buffer.get(),
+                        newBufferSize, 1);
     gmt_execute_on_node_with_handle(
-        getNodeId(loc), asyncExecFunWithRetWrapper<ResT>, buffer.get(),
-        newBufferSize, result, &garbageSize, GMT_PREEMPTABLE,
-        getGmtHandle(handle));
+        getNodeId(loc), payload.task(), payload.args(), payload.size(), result,
+        &garbageSize, GMT_PREEMPTABLE, getGmtHandle(handle));
   }
 
   template <typename FunT, typename InArgsT, typename ResT>
@@ -188,18 +196,17 @@ struct AsynchronousInterface<gmt_tag> {
     FunctionTy fn = std::forward<decltype(function)>(function);
 
     checkLocality(loc);
-    checkInputSize(sizeof(InArgsT));
 
     ExecFunWrapperArgs<FunctionTy, InArgsT> funArgs{fn, args};
 
-    uint32_t resultSize = 0;
-
     handle = (handle.IsNull()) ? Handle(HandleTrait<gmt_tag>::CreateNewHandle())
                                : handle;
 
+    TaskPayload payload(asyncExecFunWithRetWrapper<FunctionTy, InArgsT, ResT>,
+                        reinterpret_cast<const uint8_t *>(&funArgs),
+                        sizeof(funArgs), 1);
     gmt_execute_on_node_with_handle(
-        getNodeId(loc), asyncExecFunWithRetWrapper<FunctionTy, InArgsT, ResT>,
-        reinterpret_cast<const uint8_t *>(&funArgs), sizeof(funArgs), result,
+        getNodeId(loc), payload.task(), payload.args(), payload.size(), result,
         &garbageSize, GMT_PREEMPTABLE, getGmtHandle(handle));
   }
 
@@ -210,16 +217,16 @@ struct AsynchronousInterface<gmt_tag> {
 
     FunctionTy fn = std::forward<decltype(function)>(function);
 
-    checkInputSize(sizeof(InArgsT));
-
     ExecFunWrapperArgs<FunctionTy, InArgsT> funArgs{fn, args};
 
     handle = (handle.IsNull()) ? Handle(HandleTrait<gmt_tag>::CreateNewHandle())
                                : handle;
 
-    gmt_execute_on_all_with_handle(execAsyncFunWrapper<FunctionTy, InArgsT>,
-                                   reinterpret_cast<const uint8_t *>(&funArgs),
-                                   sizeof(funArgs), GMT_PREEMPTABLE,
+    TaskPayload payload(execAsyncFunWrapper<FunctionTy, InArgsT>,
+                        reinterpret_cast<const uint8_t *>(&funArgs),
+                        sizeof(funArgs), gmt_num_nodes());
+    gmt_execute_on_all_with_handle(payload.task(), payload.args(),
+                                   payload.size(), GMT_PREEMPTABLE,
                                    getGmtHandle(handle));
   }
 
@@ -231,8 +238,6 @@ struct AsynchronousInterface<gmt_tag> {
 
     FunctionTy fn = std::forward<decltype(function)>(function);
 
-    checkInputSize(bufferSize);
-
     uint32_t newBufferSize = bufferSize + sizeof(fn);
     std::unique_ptr<uint8_t[]> buffer(new uint8_t[newBufferSize]);
 
@@ -244,8 +249,10 @@ struct AsynchronousInterface<gmt_tag> {
     handle = (handle.IsNull()) ? Handle(HandleTrait<gmt_tag>::CreateNewHandle())
                                : handle;
 
-    gmt_execute_on_all_with_handle(execAsyncFunWrapper, buffer.get(),
-                                   newBufferSize, GMT_PREEMPTABLE,
+    TaskPayload payload(execAsyncFunWrapper, buffer.get(), newBufferSize,
+                        gmt_num_nodes());
+    gmt_execute_on_all_with_handle(payload.task(), payload.args(),
+                                   payload.size(), GMT_PREEMPTABLE,
                                    getGmtHandle(handle));
   }
 
@@ -384,6 +391,20 @@ struct AsynchronousInterface<gmt_tag> {
                              buffer.get(), newBufferSize, GMT_SPAWN_SPREAD,
                              getGmtHandle(handle));
   }
+
+  template <typename T>
+  static void asyncAtomic(Handle &handle, const Locality &loc,
+                          const AtomicArgs<T> &args, T *result) {
+    checkLocality(loc);
+
+    handle = (handle.IsNull()) ? Handle(HandleTrait<gmt_tag>::CreateNewHandle())
+                               : handle;
+
+    gmt_execute_on_node_with_handle(
+        getNodeId(loc), atomicWrapper<T>,
+        reinterpret_cast<const uint8_t *>(&args), sizeof(args), result,
+        &garbageSize, GMT_PREEMPTABLE, getGmtHandle(handle));
+  }
 };
 
 }  // namespace impl
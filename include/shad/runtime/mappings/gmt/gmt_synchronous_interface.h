@@ -53,13 +53,14 @@ struct SynchronousInterface<gmt_tag> {
     FunctionTy fn = std::forward<decltype(function)>(function);
 
     checkLocality(loc);
-    checkInputSize(sizeof(InArgsT));
 
     ExecFunWrapperArgs<FunctionTy, InArgsT> funArgs{fn, args};
 
-    gmt_execute_on_node(getNodeId(loc), execFunWrapper<FunctionTy, InArgsT>,
+    TaskPayload payload(execFunWrapper<FunctionTy, InArgsT>,
                         reinterpret_cast<const uint8_t *>(&funArgs),
-                        sizeof(funArgs), nullptr, nullptr, GMT_PREEMPTABLE);
+                        sizeof(funArgs));
+    gmt_execute_on_node(getNodeId(loc), payload.task(), payload.args(),
+                        payload.size(), nullptr, nullptr, GMT_PREEMPTABLE);
   }
 
   template <typename FunT>
@@ -71,7 +72,6 @@ struct SynchronousInterface<gmt_tag> {
     FunctionTy fn = std::forward<decltype(function)>(function);
 
     impl::checkLocality(loc);
-    impl::checkInputSize(bufferSize);
 
     uint32_t newBufferSize = bufferSize + sizeof(fn);
     std::unique_ptr<uint8_t[]> buffer(new uint8_t[newBufferSize]);
@@ -81,8 +81,9 @@ struct SynchronousInterface<gmt_tag> {
     if (argsBuffer != nullptr && bufferSize)
       memcpy(buffer.get() + sizeof(fn), argsBuffer.get(), bufferSize);
 
-    gmt_execute_on_node(impl::getNodeId(loc), execFunWrapper, buffer.get(),
-                        newBufferSize, nullptr, nullptr, GMT_PREEMPTABLE);
+    TaskPayload payload(execFunWrapper, buffer.get(), newBufferSize);
+    gmt_execute_on_node(impl::getNodeId(loc), payload.task(), payload.args(),
+                        payload.size(), nullptr, nullptr, GMT_PREEMPTABLE);
   }
 
   template <typename FunT, typename InArgsT>
@@ -94,14 +95,21 @@ struct SynchronousInterface<gmt_tag> {
     FunctionTy fn = std::forward<decltype(function)>(function);
 
     checkLocality(loc);
-    checkInputSize(sizeof(InArgsT));
 
-    ExecFunWrapperArgs<FunctionTy, InArgsT> funArgs{fn, args};
+    // Results not fitting in the reply are written in resultBuffer and
+    // largeResultSize.
+    uint32_t largeResultSize = 0;
+    ResultTarget target{gmt_node_id(), resultBuffer, &largeResultSize, false};
+    ExecFunWithRetBuffWrapperArgs<FunctionTy, InArgsT> funArgs{target, fn,
+                                                               args};
 
-    gmt_execute_on_node(
-        getNodeId(loc), execFunWithRetBuffWrapper<FunctionTy, InArgsT>,
-        reinterpret_cast<const uint8_t *>(&funArgs), sizeof(funArgs),
-        resultBuffer, resultSize, GMT_PREEMPTABLE);
+    TaskPayload payload(execFunWithRetBuffWrapper<FunctionTy, InArgsT>,
+                        reinterpret_cast<const uint8_t *>(&funArgs),
+                        sizeof(funArgs));
+    gmt_execute_on_node(getNodeId(loc), payload.task(), payload.args(),
+                        payload.size(), resultBuffer, resultSize,
+                        GMT_PREEMPTABLE);
+    if (largeResultSize != 0) *resultSize = largeResultSize;
   }
 
   template <typename FunT>
@@ -116,19 +124,27 @@ struct SynchronousInterface<gmt_tag> {
     FunctionTy fn = std::forward<decltype(function)>(function);
 
     checkLocality(loc);
-    checkInputSize(bufferSize);
 
-    uint32_t newBufferSize = bufferSize + sizeof(fn);
+    // Results not fitting in the reply are written in resultBuffer and
+    // largeResultSize.
+    uint32_t largeResultSize = 0;
+    ResultTarget target{gmt_node_id(), resultBuffer, &largeResultSize, false};
+
+    uint32_t newBufferSize = bufferSize + sizeof(target) + sizeof(fn);
     std::unique_ptr<uint8_t[]> buffer(new uint8_t[newBufferSize]);
 
-    *reinterpret_cast<FunctionTy *>(const_cast<uint8_t *>(buffer.get())) = fn;
+    memcpy(buffer.get(), &target, sizeof(target));
+    memcpy(buffer.get() + sizeof(target), &fn, sizeof(fn));
 
     if (argsBuffer != nullptr && bufferSize)
-      memcpy(buffer.get() + sizeof(fn), argsBuffer.get(), bufferSize);
+      memcpy(buffer.get() + sizeof(target) + sizeof(fn), argsBuffer.get(),
+             bufferSize);
 
-    gmt_execute_on_node(getNodeId(loc), execFunWithRetBuffWrapper, buffer.get(),
-                        newBufferSize, resultBuffer, resultSize,
+    TaskPayload payload(execFunWithRetBuffWrapper, buffer.get(), newBufferSize);
+    gmt_execute_on_node(getNodeId(loc), payload.task(), payload.args(),
+                        payload.size(), resultBuffer, resultSize,
                         GMT_PREEMPTABLE);
+    if (largeResultSize != 0) *resultSize = largeResultSize;
   }
 
   template <typename FunT, typename InArgsT, typename ResT>
@@ -139,15 +155,15 @@ struct SynchronousInterface<gmt_tag> {
     FunctionTy fn = std::forward<decltype(function)>(function);
 
     checkLocality(loc);
-    checkInputSize(sizeof(InArgsT));
 
     ExecFunWrapperArgs<FunctionTy, InArgsT> funArgs{fn, args};
 
     uint32_t resultSize = 0;
-    gmt_execute_on_node(getNodeId(loc),
-                        execFunWithRetWrapper<FunctionTy, InArgsT, ResT>,
+    TaskPayload payload(execFunWithRetWrapper<FunctionTy, InArgsT, ResT>,
                         reinterpret_cast<const uint8_t *>(&funArgs),
-                        sizeof(funArgs), result, &resultSize, GMT_PREEMPTABLE);
+                        sizeof(funArgs));
+    gmt_execute_on_node(getNodeId(loc), payload.task(), payload.args(),
+                        payload.size(), result, &resultSize, GMT_PREEMPTABLE);
   }
 
   template <typename FunT, typename ResT>
@@ -159,7 +175,6 @@ struct SynchronousInterface<gmt_tag> {
     FunctionTy fn = std::forward<decltype(function)>(function);
 
     checkLocality(loc);
-    checkInputSize(bufferSize);
 
     uint32_t newBufferSize = bufferSize + sizeof(fn);
     std::unique_ptr<uint8_t[]> buffer(new uint8_t[newBufferSize]);
@@ -170,9 +185,10 @@ struct SynchronousInterface<gmt_tag> {
       memcpy(buffer.get() + sizeof(fn), argsBuffer.get(), bufferSize);
 
     uint32_t retSize;
-    gmt_execute_on_node(getNodeId(loc), execFunWithRetWrapper<ResT>,
-                        buffer.get(), newBufferSize, result, &retSize,
-                        GMT_PREEMPTABLE);
+    TaskPayload payload(execFunWithRetWrapper<ResT>, buffer.get(),
+                        newBufferSize);
+    gmt_execute_on_node(getNodeId(loc), payload.task(), payload.args(),
+                        payload.size(), result, &retSize, GMT_PREEMPTABLE);
   }
 
   template <typename FunT, typename InArgsT>
@@ -181,13 +197,13 @@ struct SynchronousInterface<gmt_tag> {
 
     FunctionTy fn = std::forward<decltype(function)>(function);
 
-    checkInputSize(sizeof(InArgsT));
-
     ExecFunWrapperArgs<FunctionTy, InArgsT> funArgs{fn, args};
 
-    gmt_execute_on_all(execFunWrapper<FunctionTy, InArgsT>,
-                       reinterpret_cast<const uint8_t *>(&funArgs),
-                       sizeof(funArgs), GMT_PREEMPTABLE);
+    TaskPayload payload(execFunWrapper<FunctionTy, InArgsT>,
+                        reinterpret_cast<const uint8_t *>(&funArgs),
+                        sizeof(funArgs));
+    gmt_execute_on_all(payload.task(), payload.args(), payload.size(),
+                       GMT_PREEMPTABLE);
   }
 
   template <typename FunT>
@@ -198,8 +214,6 @@ struct SynchronousInterface<gmt_tag> {
 
     FunctionTy fn = std::forward<decltype(function)>(function);
 
-    impl::checkInputSize(bufferSize);
-
     uint32_t newBufferSize = bufferSize + sizeof(fn);
     std::unique_ptr<uint8_t[]> buffer(new uint8_t[newBufferSize]);
 
@@ -208,7 +222,8 @@ struct SynchronousInterface<gmt_tag> {
     if (argsBuffer != nullptr && bufferSize)
       memcpy(buffer.get() + sizeof(fn), argsBuffer.get(), bufferSize);
 
-    gmt_execute_on_all(impl::execFunWrapper, buffer.get(), newBufferSize,
+    TaskPayload payload(impl::execFunWrapper, buffer.get(), newBufferSize);
+    gmt_execute_on_all(payload.task(), payload.args(), payload.size(),
                        GMT_PREEMPTABLE);
   }
 
@@ -338,6 +353,59 @@ struct SynchronousInterface<gmt_tag> {
     gmt_mem_get(getNodeId(srcLoc), (uint8_t*)localAddress,
                 (uint8_t*)(remoteData), numElements*sizeof(T));
   }
+
+  template <typename T>
+  static void dmaScatter(const Locality &destLoc,
+                         const DmaSegment<T> *remoteSegments,
+                         const size_t numSegments, const T *localData) {
+    checkLocality(destLoc);
+    dmaSegments(getNodeId(destLoc), dmaScatterWrapper,
+                byteSegments(remoteSegments, numSegments), nullptr,
+                reinterpret_cast<const uint8_t *>(localData),
+                numSegmentElements(remoteSegments, numSegments) * sizeof(T));
+  }
+
+  template <typename T>
+  static void dmaGather(const T *localAddress, const Locality &srcLoc,
+                        const DmaSegment<T> *remoteSegments,
+                        const size_t numSegments) {
+    checkLocality(srcLoc);
+    dmaSegments(getNodeId(srcLoc), dmaGatherWrapper,
+                byteSegments(remoteSegments, numSegments),
+                (uint8_t *)localAddress, nullptr, 0);
+  }
+
+  template <typename T>
+  static void dmaStrided(const Locality &destLoc, const T *remoteBase,
+                         const size_t stride, const T *localData,
+                         const size_t numElements) {
+    checkLocality(destLoc);
+    dmaSegments(getNodeId(destLoc), dmaScatterWrapper,
+                byteSegments(DmaStride<T>{remoteBase, stride, numElements}),
+                nullptr, reinterpret_cast<const uint8_t *>(localData),
+                numElements * sizeof(T));
+  }
+
+  template <typename T>
+  static void dmaStrided(const T *localAddress, const Locality &srcLoc,
+                         const T *remoteBase, const size_t stride,
+                         const size_t numElements) {
+    checkLocality(srcLoc);
+    dmaSegments(getNodeId(srcLoc), dmaGatherWrapper,
+                byteSegments(DmaStride<T>{remoteBase, stride, numElements}),
+                (uint8_t *)localAddress, nullptr, 0);
+  }
+
+  template <typename T>
+  static T atomic(const Locality &loc, const AtomicArgs<T> &args) {
+    checkLocality(loc);
+    T value;
+    uint32_t resultSize = 0;
+    gmt_execute_on_node(getNodeId(loc), atomicWrapper<T>,
+                        reinterpret_cast<const uint8_t *>(&args), sizeof(args),
+                        &value, &resultSize, GMT_PREEMPTABLE);
+    return value;
+  }
 };
 
 }  // namespace impl
@@ -94,6 +94,12 @@ struct RuntimeInternalsTrait<gmt_tag> {
   static uint32_t ThisLocality() { return gmt_node_id(); }
   static uint32_t NullLocality() { return -1; }
   static uint32_t NumLocalities() { return gmt_num_nodes(); }
+
+  static uint32_t NumProcessLocalities() { return 1; }
+  static uint32_t ProcessLocalityIndex() { return 0; }
+
+  // GMT does not expose its queues: tasks are not classified.
+  static size_t QueueDepth(Priority p) { return 0; }
 };
 
 }  // namespace impl
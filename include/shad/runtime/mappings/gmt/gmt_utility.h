@@ -25,11 +25,19 @@
 #ifndef INCLUDE_SHAD_RUNTIME_MAPPINGS_GMT_GMT_UTILITY_H_
 #define INCLUDE_SHAD_RUNTIME_MAPPINGS_GMT_GMT_UTILITY_H_
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <sstream>
 #include <system_error>
+#include <vector>
 
+#include "shad/runtime/atomics.h"
+#include "shad/runtime/dma.h"
 #include "shad/runtime/locality.h"
 
 namespace shad {
@@ -52,24 +60,280 @@ inline void checkLocality(const Locality &loc) {
   }
 }
 
+/// The largest result buffer that a task can return.
+static constexpr size_t kMaxReturnBufferSize = 64 << 10;
+
 inline void checkInputSize(size_t size) {
   if (size > gmt_max_args_per_task()) {
     std::stringstream ss;
     ss << "The input size exeeds the hard limit of " << gmt_max_args_per_task()
-       << "B imposed by GMT.  A more general solution is under development.";
+       << "B imposed by GMT on parallel loops.";
     throw std::system_error(0xdeadc0de, std::generic_category(), ss.str());
   }
 }
 
 inline void checkOutputSize(size_t size) {
-  if (size > gmt_max_return_size()) {
+  if (size > kMaxReturnBufferSize) {
     std::stringstream ss;
-    ss << "The output size exeeds the hard limit of " << gmt_max_return_size()
-       << "B imposed by GMT.  A more general solution is under development.";
+    ss << "The output size exeeds the hard limit of " << kMaxReturnBufferSize
+       << "B.";
     throw std::system_error(0xdeadc0de, std::generic_category(), ss.str());
   }
 }
 
+/// The type of the tasks spawned through gmt_execute_on_node/all.
+using GmtTaskTy = void (*)(const void *, uint32_t, void *, uint32_t *,
+                           gmt_handle_t);
+
+/// @brief Header of the copy of a payload sent asynchronously.
+///
+/// The copy is released by the last of its receivers.
+struct StagedPayloadHeader {
+  std::atomic<uint32_t> receivers;
+};
+
+/// @brief The arguments of a task whose payload stays on the sender.
+struct StagedPayloadArgs {
+  GmtTaskTy task;
+  uint32_t srcNode;
+  const uint8_t *payload;
+  uint32_t size;
+  StagedPayloadHeader *header;
+};
+
+inline void releaseStagedPayload(const void *args, uint32_t, void *, uint32_t *,
+                                 gmt_handle_t) {
+  StagedPayloadHeader *header =
+      *reinterpret_cast<StagedPayloadHeader *const *>(args);
+  if (header->receivers.fetch_sub(1) == 1) {
+    header->~StagedPayloadHeader();
+    delete[] reinterpret_cast<uint8_t *>(header);
+  }
+}
+
+inline void stagedPayloadWrapper(const void *args, uint32_t, void *result,
+                                 uint32_t *resultSize, gmt_handle_t handle) {
+  const StagedPayloadArgs &staged =
+      *reinterpret_cast<const StagedPayloadArgs *>(args);
+
+  std::unique_ptr<uint8_t[]> payload(new uint8_t[staged.size]);
+  gmt_mem_get(staged.srcNode, payload.get(),
+              const_cast<uint8_t *>(staged.payload), staged.size);
+
+  // The release is attached to the handle of the task, so that waiting for
+  // the handle also waits for the copy on the sender to be released.
+  if (staged.header != nullptr)
+    gmt_execute_on_node_with_handle(
+        staged.srcNode, releaseStagedPayload,
+        reinterpret_cast<const uint8_t *>(&staged.header),
+        sizeof(staged.header), nullptr, nullptr, GMT_PREEMPTABLE, handle);
+
+  staged.task(payload.get(), staged.size, result, resultSize, handle);
+}
+
+/// @brief The payload of a task spawned through gmt_execute_on_node/all.
+///
+/// Payloads fitting in a GMT task are sent as they are.  Larger payloads stay
+/// on the sender and the task carries a descriptor, used by the receiver to
+/// pull them with gmt_mem_get: GMT moves them in network-sized blocks with no
+/// intermediate copy, so that large arguments travel at link bandwidth.
+/// Synchronous calls pull from the buffer of the caller.  Asynchronous calls
+/// pull from a copy, released by the last receiver.
+class TaskPayload {
+ public:
+  /// @brief Constructor.
+  ///
+  /// @param task The task to be executed.
+  /// @param data The payload of the task.
+  /// @param size The size of the payload.
+  /// @param asyncReceivers The number of receivers of an asynchronous call, or
+  /// 0 for a synchronous call.
+  TaskPayload(GmtTaskTy task, const uint8_t *data, uint32_t size,
+              uint32_t asyncReceivers = 0)
+      : task_(task), args_(data), size_(size) {
+    if (size <= gmt_max_args_per_task()) return;
+
+    staged_ = StagedPayloadArgs{task, gmt_node_id(), data, size, nullptr};
+    if (asyncReceivers != 0) {
+      uint8_t *copy = new uint8_t[sizeof(StagedPayloadHeader) + size];
+      staged_.header = new (copy) StagedPayloadHeader{{asyncReceivers}};
+      staged_.payload = copy + sizeof(StagedPayloadHeader);
+      memcpy(copy + sizeof(StagedPayloadHeader), data, size);
+    }
+    task_ = stagedPayloadWrapper;
+    args_ = reinterpret_cast<const uint8_t *>(&staged_);
+    size_ = sizeof(staged_);
+  }
+
+  TaskPayload(const TaskPayload &) = delete;
+  TaskPayload &operator=(const TaskPayload &) = delete;
+
+  GmtTaskTy task() const { return task_; }
+  const uint8_t *args() const { return args_; }
+  uint32_t size() const { return size_; }
+
+ private:
+  GmtTaskTy task_;
+  const uint8_t *args_;
+  uint32_t size_;
+  StagedPayloadArgs staged_;
+};
+
+/// @brief Where a task returning a buffer delivers its result.
+///
+/// Results fitting in a GMT reply travel with it.  Larger ones are written
+/// with gmt_mem_put in buffer, and their size in size.  Asynchronous calls
+/// always use gmt_mem_put, as their reply is not waited by the caller.
+struct ResultTarget {
+  uint32_t node;
+  uint8_t *buffer;
+  uint32_t *size;
+  bool async;
+};
+
+/// @brief Pool of the kMaxReturnBufferSize buffers where remote tasks build
+/// their result.
+///
+/// GMT tasks can be preempted inside the user function, so the buffers cannot
+/// be thread_local.
+class ResultBufferPool {
+ public:
+  static uint8_t *Acquire() {
+    auto &shared = Shared();
+    {
+      std::lock_guard<std::mutex> _(shared.lock);
+      if (!shared.buffers.empty()) {
+        uint8_t *buffer = shared.buffers.back();
+        shared.buffers.pop_back();
+        return buffer;
+      }
+    }
+    return new uint8_t[kMaxReturnBufferSize];
+  }
+
+  static void Release(uint8_t *buffer) {
+    auto &shared = Shared();
+    {
+      std::lock_guard<std::mutex> _(shared.lock);
+      if (shared.buffers.size() < kPoolSize) {
+        shared.buffers.push_back(buffer);
+        return;
+      }
+    }
+    delete[] buffer;
+  }
+
+ private:
+  static constexpr size_t kPoolSize = 64;
+
+  struct SharedList {
+    ~SharedList() {
+      for (auto buffer : buffers) delete[] buffer;
+    }
+
+    std::mutex lock;
+    std::vector<uint8_t *> buffers;
+  };
+
+  static SharedList &Shared() {
+    static SharedList shared;
+    return shared;
+  }
+};
+
+/// @brief Runs fn(buffer, &size) and delivers the result to target.
+///
+/// When the task runs on the node of the caller, fn writes straight in the
+/// caller's buffer.  Otherwise it writes in a pooled buffer of
+/// kMaxReturnBufferSize bytes.  The size is checked before anything is
+/// copied into the reply or put on the caller.
+template <typename FunT>
+void produceResult(const ResultTarget &target, void *result,
+                   uint32_t *resultSize, FunT &&fn) {
+  uint32_t size = 0;
+  if (target.node == gmt_node_id()) {
+    fn(target.buffer, &size);
+    checkOutputSize(size);
+    *target.size = size;
+    if (resultSize != nullptr) *resultSize = 0;
+    return;
+  }
+
+  std::unique_ptr<uint8_t[], void (*)(uint8_t *)> buffer(
+      ResultBufferPool::Acquire(), ResultBufferPool::Release);
+  fn(buffer.get(), &size);
+  checkOutputSize(size);
+
+  if (!target.async && size <= gmt_max_return_size()) {
+    memcpy(result, buffer.get(), size);
+    *resultSize = size;
+    return;
+  }
+
+  gmt_mem_put(target.node, target.buffer, buffer.get(), size);
+  gmt_mem_put(target.node, reinterpret_cast<uint8_t *>(target.size),
+              reinterpret_cast<uint8_t *>(&size), sizeof(size));
+  if (resultSize != nullptr) *resultSize = 0;
+}
+
+/// @brief Header of the payload of the vectored transfers, followed by the
+/// segments and, for the scatter, by the data.
+struct DmaSegmentsHeader {
+  uint32_t node;
+  uint8_t *localAddress;
+  size_t numSegments;
+};
+
+inline void dmaScatterWrapper(const void *args, uint32_t, void *, uint32_t *,
+                              gmt_handle_t) {
+  auto &header = *reinterpret_cast<const DmaSegmentsHeader *>(args);
+  auto segments = reinterpret_cast<const DmaSegment<uint8_t> *>(&header + 1);
+  scatterSegments(
+      segments, header.numSegments,
+      reinterpret_cast<const uint8_t *>(segments + header.numSegments));
+}
+
+inline void dmaGatherWrapper(const void *args, uint32_t, void *, uint32_t *,
+                             gmt_handle_t) {
+  auto &header = *reinterpret_cast<const DmaSegmentsHeader *>(args);
+  auto segments = reinterpret_cast<const DmaSegment<uint8_t> *>(&header + 1);
+  std::vector<uint8_t> buffer(
+      numSegmentElements(segments, header.numSegments));
+  gatherSegments(buffer.data(), segments, header.numSegments);
+  gmt_mem_put(header.node, header.localAddress, buffer.data(), buffer.size());
+}
+
+/// @brief Execute a vectored transfer with a single task on node.
+///
+/// The scatter sends the data with the segments.  The gather packs the
+/// segments on node and writes them back with one gmt_mem_put.
+inline void dmaSegments(uint32_t node, GmtTaskTy task,
+                        const std::vector<DmaSegment<uint8_t>> &segments,
+                        uint8_t *localAddress, const uint8_t *data,
+                        size_t numBytes) {
+  size_t segmentsSize = segments.size() * sizeof(DmaSegment<uint8_t>);
+  std::vector<uint8_t> args(sizeof(DmaSegmentsHeader) + segmentsSize +
+                            numBytes);
+  DmaSegmentsHeader header{gmt_node_id(), localAddress, segments.size()};
+  memcpy(args.data(), &header, sizeof(header));
+  memcpy(args.data() + sizeof(header), segments.data(), segmentsSize);
+  if (numBytes != 0)
+    memcpy(args.data() + sizeof(header) + segmentsSize, data, numBytes);
+  TaskPayload payload(task, args.data(), args.size());
+  gmt_execute_on_node(node, payload.task(), payload.args(), payload.size(),
+                      nullptr, nullptr, GMT_PREEMPTABLE);
+}
+
+/// @brief The task of the atomic operations: it returns the previous value
+/// of the target in the reply.
+template <typename T>
+void atomicWrapper(const void *args, uint32_t, void *result,
+                   uint32_t *resultSize, gmt_handle_t) {
+  T value = applyAtomic(*reinterpret_cast<const AtomicArgs<T> *>(args));
+  memcpy(result, &value, sizeof(T));
+  *resultSize = sizeof(T);
+}
+
 /// @brief Structure to build the function closure to be sent.
 template <typename FunT, typename InArgsT>
 struct ExecFunWrapperArgs {
@@ -95,15 +359,26 @@ inline void execFunWrapper(const void *args, uint32_t args_size, void *,
               args_size - sizeof(functionPtr));
 }
 
+/// @brief Structure to build the closure of a function returning a buffer.
+template <typename FunT, typename InArgsT>
+struct ExecFunWithRetBuffWrapperArgs {
+  ResultTarget target;
+  FunT fun;
+  InArgsT args;
+};
+
 template <typename FunT, typename InArgsT>
 void execFunWithRetBuffWrapper(const void *args, uint32_t, void *result,
                                uint32_t *resultSize, gmt_handle_t) {
-  const impl::ExecFunWrapperArgs<FunT, InArgsT> *funArgs =
-      reinterpret_cast<const impl::ExecFunWrapperArgs<FunT, InArgsT> *>(args);
+  const impl::ExecFunWithRetBuffWrapperArgs<FunT, InArgsT> *funArgs =
+      reinterpret_cast<
+          const impl::ExecFunWithRetBuffWrapperArgs<FunT, InArgsT> *>(args);
   const InArgsT &fnargs = funArgs->args;
-  funArgs->fun(fnargs, reinterpret_cast<uint8_t *>(result), resultSize);
 
-  checkOutputSize(*resultSize);
+  produceResult(funArgs->target, result, resultSize,
+                [&](uint8_t *buffer, uint32_t *size) {
+                  funArgs->fun(fnargs, buffer, size);
+                });
 }
 
 inline void execFunWithRetBuffWrapper(const void *args, uint32_t argsSize,
@@ -112,13 +387,18 @@ inline void execFunWithRetBuffWrapper(const void *args, uint32_t argsSize,
   using FunctionTy =
       void (*)(const uint8_t *, const uint32_t, uint8_t *, uint32_t *);
 
-  FunctionTy functionPtr =
-      *reinterpret_cast<FunctionTy *>(const_cast<void *>(args));
-  functionPtr(reinterpret_cast<const uint8_t *>(args) + sizeof(functionPtr),
-              argsSize - sizeof(functionPtr),
-              reinterpret_cast<uint8_t *>(result), resultSize);
-
-  checkOutputSize(*resultSize);
+  const uint8_t *basePtr = reinterpret_cast<const uint8_t *>(args);
+  ResultTarget target;
+  memcpy(&target, basePtr, sizeof(target));
+  FunctionTy functionPtr;
+  memcpy(&functionPtr, basePtr + sizeof(target), sizeof(functionPtr));
+  size_t headerSize = sizeof(target) + sizeof(functionPtr);
+
+  produceResult(target, result, resultSize,
+                [&](uint8_t *buffer, uint32_t *size) {
+                  functionPtr(basePtr + headerSize, argsSize - headerSize,
+                              buffer, size);
+                });
 }
 
 template <typename FunT, typename InArgsT, typename ResT>
@@ -239,14 +519,16 @@ void asyncExecFunWithRetWrapper(const void *args, uint32_t args_size,
 template <typename FunT, typename InArgsT>
 void asyncExecFunWithRetBuffWrapper(const void *args, uint32_t, void *result,
                                     uint32_t *resultSize, gmt_handle_t handle) {
-  const ExecFunWrapperArgs<FunT, InArgsT> *funArgs =
-      reinterpret_cast<const ExecFunWrapperArgs<FunT, InArgsT> *>(args);
+  const ExecFunWithRetBuffWrapperArgs<FunT, InArgsT> *funArgs =
+      reinterpret_cast<const ExecFunWithRetBuffWrapperArgs<FunT, InArgsT> *>(
+          args);
   const InArgsT &fnargs = funArgs->args;
 
   Handle H(handle);
-  funArgs->fun(H, fnargs, reinterpret_cast<uint8_t *>(result), resultSize);
-
-  checkOutputSize(*resultSize);
+  produceResult(funArgs->target, result, resultSize,
+                [&](uint8_t *buffer, uint32_t *size) {
+                  funArgs->fun(H, fnargs, buffer, size);
+                });
 }
 
 inline void asyncExecFunWithRetBuffWrapper(const void *args, uint32_t argsSize,
@@ -255,15 +537,19 @@ inline void asyncExecFunWithRetBuffWrapper(const void *args, uint32_t argsSize,
   using FunctionTy = void (*)(Handle &, const uint8_t *, const uint32_t,
                               uint8_t *, uint32_t *);
 
-  FunctionTy functionPtr =
-      *reinterpret_cast<FunctionTy *>(const_cast<void *>(args));
+  const uint8_t *basePtr = reinterpret_cast<const uint8_t *>(args);
+  ResultTarget target;
+  memcpy(&target, basePtr, sizeof(target));
+  FunctionTy functionPtr;
+  memcpy(&functionPtr, basePtr + sizeof(target), sizeof(functionPtr));
+  size_t headerSize = sizeof(target) + sizeof(functionPtr);
 
   Handle H(handle);
-  functionPtr(H, reinterpret_cast<const uint8_t *>(args) + sizeof(functionPtr),
-              argsSize - sizeof(functionPtr),
-              reinterpret_cast<uint8_t *>(result), resultSize);
-
-  checkOutputSize(*resultSize);
+  produceResult(target, result, resultSize,
+                [&](uint8_t *buffer, uint32_t *size) {
+                  functionPtr(H, basePtr + headerSize, argsSize - headerSize,
+                              buffer, size);
+                });
 }
 
 inline void asyncForEachWrapper(uint64_t startIt, uint64_t numIters,
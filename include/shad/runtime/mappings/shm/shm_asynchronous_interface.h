@@ -0,0 +1,326 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_MAPPINGS_SHM_SHM_ASYNCHRONOUS_INTERFACE_H_
+#define INCLUDE_SHAD_RUNTIME_MAPPINGS_SHM_SHM_ASYNCHRONOUS_INTERFACE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "shad/runtime/asynchronous_interface.h"
+#include "shad/runtime/handle.h"
+#include "shad/runtime/locality.h"
+#include "shad/runtime/mapping_traits.h"
+#include "shad/runtime/mappings/shm/shm_scheduler.h"
+#include "shad/runtime/mappings/shm/shm_utility.h"
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+template <>
+struct AsynchronousInterface<shm_tag> {
+  template <typename FunT, typename InArgsT>
+  static void asyncExecuteAt(Handle &handle, const Locality &loc,
+                             FunT &&function, const InArgsT &args) {
+    using FunctionTy = void (*)(Handle &, const InArgsT &);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<shm_tag>::CreateNewHandle() : handle.id_;
+
+    ExecFunWrapperArgs<FunctionTy, InArgsT> funArgs{fn, args};
+    ShmScheduler::Instance().Spawn(
+        getNodeId(loc), handle.id_, asyncExecFunWrapper<FunctionTy, InArgsT>,
+        reinterpret_cast<const uint8_t *>(&funArgs), sizeof(funArgs), nullptr,
+        nullptr, 0);
+  }
+
+  template <typename FunT>
+  static void asyncExecuteAt(Handle &handle, const Locality &loc,
+                             FunT &&function,
+                             const std::shared_ptr<uint8_t> &argsBuffer,
+                             const uint32_t bufferSize) {
+    using FunctionTy = void (*)(Handle &, const uint8_t *, const uint32_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<shm_tag>::CreateNewHandle() : handle.id_;
+
+    auto payload = makeBufferPayload(fn, argsBuffer.get(), bufferSize);
+    ShmScheduler::Instance().Spawn(getNodeId(loc), handle.id_,
+                                   asyncExecFunWrapper<FunctionTy>,
+                                   payload.data(), payload.size(), nullptr,
+                                   nullptr, 0);
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void asyncExecuteAtWithRetBuff(Handle &handle, const Locality &loc,
+                                        FunT &&function, const InArgsT &args,
+                                        uint8_t *resultBuffer,
+                                        uint32_t *resultSize) {
+    using FunctionTy =
+        void (*)(Handle &, const InArgsT &, uint8_t *, uint32_t *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<shm_tag>::CreateNewHandle() : handle.id_;
+
+    ExecFunWrapperArgs<FunctionTy, InArgsT> funArgs{fn, args};
+    ShmScheduler::Instance().Spawn(
+        getNodeId(loc), handle.id_,
+        asyncExecFunWithRetBuffWrapper<FunctionTy, InArgsT>,
+        reinterpret_cast<const uint8_t *>(&funArgs), sizeof(funArgs),
+        resultBuffer, resultSize, ShmScheduler::kMaxReturnBufferSize);
+  }
+
+  template <typename FunT>
+  static void asyncExecuteAtWithRetBuff(
+      Handle &handle, const Locality &loc, FunT &&function,
+      const std::shared_ptr<uint8_t> &argsBuffer, const uint32_t bufferSize,
+      uint8_t *resultBuffer, uint32_t *resultSize) {
+    using FunctionTy = void (*)(Handle &, const uint8_t *, const uint32_t,
+                                uint8_t *, uint32_t *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<shm_tag>::CreateNewHandle() : handle.id_;
+
+    auto payload = makeBufferPayload(fn, argsBuffer.get(), bufferSize);
+    ShmScheduler::Instance().Spawn(
+        getNodeId(loc), handle.id_, asyncExecFunWithRetBuffWrapper<FunctionTy>,
+        payload.data(), payload.size(), resultBuffer, resultSize,
+        ShmScheduler::kMaxReturnBufferSize);
+  }
+
+  template <typename FunT, typename InArgsT, typename ResT>
+  static void asyncExecuteAtWithRet(Handle &handle, const Locality &loc,
+                                    FunT &&function, const InArgsT &args,
+                                    ResT *result) {
+    using FunctionTy = void (*)(Handle &, const InArgsT &, ResT *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<shm_tag>::CreateNewHandle() : handle.id_;
+
+    ExecFunWrapperArgs<FunctionTy, InArgsT> funArgs{fn, args};
+    ShmScheduler::Instance().Spawn(
+        getNodeId(loc), handle.id_,
+        asyncExecFunWithRetWrapper<FunctionTy, InArgsT, ResT>,
+        reinterpret_cast<const uint8_t *>(&funArgs), sizeof(funArgs),
+        reinterpret_cast<uint8_t *>(result), nullptr, sizeof(ResT));
+  }
+
+  template <typename FunT, typename ResT>
+  static void asyncExecuteAtWithRet(Handle &handle, const Locality &loc,
+                                    FunT &&function,
+                                    const std::shared_ptr<uint8_t> &argsBuffer,
+                                    const uint32_t bufferSize, ResT *result) {
+    using FunctionTy =
+        void (*)(Handle &, const uint8_t *, const uint32_t, ResT *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<shm_tag>::CreateNewHandle() : handle.id_;
+
+    auto payload = makeBufferPayload(fn, argsBuffer.get(), bufferSize);
+    ShmScheduler::Instance().Spawn(
+        getNodeId(loc), handle.id_, asyncExecFunWithRetWrapper<FunctionTy, ResT>,
+        payload.data(), payload.size(), reinterpret_cast<uint8_t *>(result),
+        nullptr, sizeof(ResT));
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void asyncExecuteOnAll(Handle &handle, FunT &&function,
+                                const InArgsT &args) {
+    using FunctionTy = void (*)(Handle &, const InArgsT &);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<shm_tag>::CreateNewHandle() : handle.id_;
+
+    auto &scheduler = ShmScheduler::Instance();
+    ExecFunWrapperArgs<FunctionTy, InArgsT> funArgs{fn, args};
+    for (uint32_t L = 0; L < scheduler.NumLocalities(); ++L) {
+      scheduler.Spawn(L, handle.id_, asyncExecFunWrapper<FunctionTy, InArgsT>,
+                      reinterpret_cast<const uint8_t *>(&funArgs),
+                      sizeof(funArgs), nullptr, nullptr, 0);
+    }
+  }
+
+  template <typename FunT>
+  static void asyncExecuteOnAll(Handle &handle, FunT &&function,
+                                const std::shared_ptr<uint8_t> &argsBuffer,
+                                const uint32_t bufferSize) {
+    using FunctionTy = void (*)(Handle &, const uint8_t *, const uint32_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<shm_tag>::CreateNewHandle() : handle.id_;
+
+    auto &scheduler = ShmScheduler::Instance();
+    auto payload = makeBufferPayload(fn, argsBuffer.get(), bufferSize);
+    for (uint32_t L = 0; L < scheduler.NumLocalities(); ++L) {
+      scheduler.Spawn(L, handle.id_, asyncExecFunWrapper<FunctionTy>,
+                      payload.data(), payload.size(), nullptr, nullptr, 0);
+    }
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void asyncForEachAt(Handle &handle, const Locality &loc,
+                             FunT &&function, const InArgsT &args,
+                             const size_t numIters) {
+    using FunctionTy = void (*)(Handle &, const InArgsT &, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<shm_tag>::CreateNewHandle() : handle.id_;
+
+    ForEachWrapperArgs<FunctionTy, InArgsT> funArgs{fn, 0, numIters, args};
+    ShmScheduler::Instance().Spawn(
+        getNodeId(loc), handle.id_, asyncForEachWrapper<FunctionTy, InArgsT>,
+        reinterpret_cast<const uint8_t *>(&funArgs), sizeof(funArgs), nullptr,
+        nullptr, 0);
+  }
+
+  template <typename FunT>
+  static void asyncForEachAt(Handle &handle, const Locality &loc,
+                             FunT &&function,
+                             const std::shared_ptr<uint8_t> &argsBuffer,
+                             const uint32_t bufferSize, const size_t numIters) {
+    using FunctionTy =
+        void (*)(Handle &, const uint8_t *, const uint32_t, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<shm_tag>::CreateNewHandle() : handle.id_;
+
+    auto payload =
+        makeBufferPayload(fn, argsBuffer.get(), bufferSize, 0, numIters);
+    ShmScheduler::Instance().Spawn(getNodeId(loc), handle.id_,
+                                   asyncForEachWrapper<FunctionTy>,
+                                   payload.data(), payload.size(), nullptr,
+                                   nullptr, 0);
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void asyncForEachOnAll(Handle &handle, FunT &&function,
+                                const InArgsT &args, const size_t numIters) {
+    using FunctionTy = void (*)(Handle &, const InArgsT &, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<shm_tag>::CreateNewHandle() : handle.id_;
+
+    auto &scheduler = ShmScheduler::Instance();
+    size_t numLocalities = scheduler.NumLocalities();
+    size_t block = (numIters + numLocalities - 1) / numLocalities;
+    for (size_t L = 0; L < numLocalities && L * block < numIters; ++L) {
+      size_t first = L * block;
+      size_t last = std::min(first + block, numIters);
+      ForEachWrapperArgs<FunctionTy, InArgsT> funArgs{fn, first, last, args};
+      scheduler.Spawn(L, handle.id_, asyncForEachWrapper<FunctionTy, InArgsT>,
+                      reinterpret_cast<const uint8_t *>(&funArgs),
+                      sizeof(funArgs), nullptr, nullptr, 0);
+    }
+  }
+
+  template <typename FunT>
+  static void asyncForEachOnAll(Handle &handle, FunT &&function,
+                                const std::shared_ptr<uint8_t> &argsBuffer,
+                                const uint32_t bufferSize,
+                                const size_t numIters) {
+    using FunctionTy =
+        void (*)(Handle &, const uint8_t *, const uint32_t, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<shm_tag>::CreateNewHandle() : handle.id_;
+
+    auto &scheduler = ShmScheduler::Instance();
+    size_t numLocalities = scheduler.NumLocalities();
+    size_t block = (numIters + numLocalities - 1) / numLocalities;
+    for (size_t L = 0; L < numLocalities && L * block < numIters; ++L) {
+      size_t first = L * block;
+      size_t last = std::min(first + block, numIters);
+      auto payload =
+          makeBufferPayload(fn, argsBuffer.get(), bufferSize, first, last);
+      scheduler.Spawn(L, handle.id_, asyncForEachWrapper<FunctionTy>,
+                      payload.data(), payload.size(), nullptr, nullptr, 0);
+    }
+  }
+
+  template <typename T>
+  static void asyncAtomic(Handle &handle, const Locality &loc,
+                          const AtomicArgs<T> &args, T *result) {
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<shm_tag>::CreateNewHandle() : handle.id_;
+
+    ShmScheduler::Instance().SpawnInline(
+        getNodeId(loc), handle.id_, atomicWrapper<T>,
+        reinterpret_cast<const uint8_t *>(&args), sizeof(args),
+        reinterpret_cast<uint8_t *>(result), nullptr, sizeof(T));
+  }
+};
+
+}  // namespace impl
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_MAPPINGS_SHM_SHM_ASYNCHRONOUS_INTERFACE_H_
@@ -0,0 +1,272 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_MAPPINGS_SHM_SHM_SCHEDULER_H_
+#define INCLUDE_SHAD_RUNTIME_MAPPINGS_SHM_SHM_SCHEDULER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "shad/runtime/dma.h"
+#include "shad/runtime/priority.h"
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+class ShmCounter;
+
+/// @brief Type of the functions executing a task delivered to a locality.
+///
+/// @param payload The bytes of the task (function pointer and arguments).
+/// @param size The size of the payload.
+/// @param counter The counter the task belongs to (asynchronous tasks only).
+/// @param result The buffer where the task stores its result.
+/// @param resultSize The size of the result stored in result.
+using ShmInvokerTy = void (*)(const uint8_t *payload, size_t size,
+                              ShmCounter *counter,
+                              uint8_t *result, uint32_t *resultSize);
+
+/// @brief Completion counter used by the SHM mapping.
+///
+/// The counter tracks the outstanding tasks of a Handle.  Tasks spawned on
+/// another locality are tracked there by a proxy counter, which notifies
+/// the counter of the spawning locality once the task and all the tasks it
+/// spawned have completed, and then deletes itself.
+class ShmCounter {
+ public:
+  ShmCounter() : count_(0), parentLocality_(0), parentToken_(0) {}
+
+  /// @brief Proxy counter of a task spawned by parentLocality.
+  ShmCounter(uint32_t parentLocality, uint64_t parentToken)
+      : count_(1),
+        parentLocality_(parentLocality),
+        parentToken_(parentToken) {}
+
+  /// @brief Register n new outstanding tasks.
+  void Increment(size_t n = 1) { count_.fetch_add(n); }
+
+  /// @brief Signal the completion of an outstanding task.
+  void Decrement();
+
+  /// @brief Wait until all the outstanding tasks have completed.
+  void Wait();
+
+ private:
+  std::atomic<size_t> count_;
+  uint32_t parentLocality_;
+  uint64_t parentToken_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+/// @brief Scheduler of the SHM mapping.
+///
+/// The SHM mapping forks one process for each locality.  Localities
+/// communicate through single-producer/single-consumer ring buffers, one for
+/// each pair of localities, allocated in a memory segment shared by all the
+/// processes.  Every process runs a progress thread, draining the rings, and
+/// a pool of workers executing the tasks delivered to the locality.  Tasks
+/// carry the priority of the thread that spawned them, and are queued by
+/// class: workers serve the most urgent non-empty queue first.
+///
+/// The scheduler is configured through the following environment variables:
+///  - SHAD_SHM_LOCALITIES: number of localities (default 2);
+///  - SHAD_SHM_WORKERS: workers per locality (default: hardware concurrency
+///    divided by the number of localities);
+///  - SHAD_SHM_RING_BYTES: capacity of each ring buffer (default 1MB).
+class ShmScheduler {
+ public:
+  using TaskTy = std::function<void()>;
+  using RangeTaskTy = std::function<void(size_t, size_t)>;
+
+  /// @brief Maximum size of the buffer returned by the WithRetBuff calls.
+  static constexpr size_t kMaxReturnBufferSize = 64 << 10;
+
+  /// @brief Get the singleton instance of the scheduler.
+  static ShmScheduler &Instance();
+
+  /// @brief Allocate the shared segment and fork the localities.
+  ///
+  /// Returns in every process, once its locality is up and running.
+  void Start();
+  /// @brief Serve the requests of other localities until locality 0 shuts
+  /// the system down.
+  void Serve();
+  /// @brief Shut down the calling locality.
+  ///
+  /// When called by locality 0, shuts down the whole system and returns the
+  /// exit status of the other localities.
+  int Stop();
+
+  uint32_t NumLocalities() const { return numLocalities_; }
+  size_t WorkersPerLocality() const { return workersPerLocality_; }
+  static uint32_t ThisLocality();
+
+  /// @brief Synchronously execute invoker on the locality dst.
+  ///
+  /// @param dst The target locality.
+  /// @param invoker The function executing the payload.
+  /// @param payload The bytes of the task.
+  /// @param size The size of the payload.
+  /// @param result The buffer receiving the result of the task.
+  /// @param resultSize Receives the size of the result (can be nullptr).
+  /// @param maxResultSize The maximum size of the result.
+  void Call(uint32_t dst, ShmInvokerTy invoker, const uint8_t *payload,
+            size_t size, uint8_t *result, uint32_t *resultSize,
+            size_t maxResultSize);
+
+  /// @brief Asynchronously execute invoker on the locality dst.
+  ///
+  /// The task is attached to counter; result and resultSize must stay valid
+  /// until the counter has been waited for.
+  void Spawn(uint32_t dst, ShmCounter *counter,
+             ShmInvokerTy invoker, const uint8_t *payload, size_t size,
+             uint8_t *result, uint32_t *resultSize, size_t maxResultSize);
+
+  /// @brief Synchronously execute invoker on the locality dst, in its progress
+  /// thread.
+  ///
+  /// The invoker runs as soon as the message is received, without going
+  /// through the queues of the workers: it must be short, and it must not
+  /// block or communicate.  Used for the remote atomic operations.
+  void CallInline(uint32_t dst, ShmInvokerTy invoker, const uint8_t *payload,
+                  size_t size, uint8_t *result, uint32_t *resultSize,
+                  size_t maxResultSize);
+
+  /// @brief Asynchronously execute invoker on the locality dst, in its
+  /// progress thread.  See CallInline().
+  ///
+  /// The invoker receives no counter; result (can be nullptr) and resultSize
+  /// must stay valid until counter has been waited for.
+  void SpawnInline(uint32_t dst, ShmCounter *counter, ShmInvokerTy invoker,
+                   const uint8_t *payload, size_t size, uint8_t *result,
+                   uint32_t *resultSize, size_t maxResultSize);
+
+  /// @brief Copy numBytes from localData to the address remoteAddress of the
+  /// locality dst.
+  void Put(uint32_t dst, void *remoteAddress, const void *localData,
+           size_t numBytes);
+  /// @brief Copy numBytes from the address remoteData of the locality src
+  /// to localAddress.
+  void Get(void *localAddress, uint32_t src, const void *remoteData,
+           size_t numBytes);
+  /// @brief Copy the contiguous localData to the segments of the locality
+  /// dst.
+  void Scatter(uint32_t dst, const DmaSegment<uint8_t> *remoteSegments,
+               size_t numSegments, const void *localData);
+  /// @brief Copy the segments of the locality src to the contiguous
+  /// localAddress.
+  void Gather(void *localAddress, uint32_t src,
+              const DmaSegment<uint8_t> *remoteSegments, size_t numSegments);
+
+  /// @brief Execute a task on a worker of the calling locality.
+  void Post(TaskTy &&task, Priority priority = CurrentPriority());
+
+  /// @brief Number of tasks of class p waiting for a worker.
+  size_t QueueDepth(Priority p);
+
+  /// @brief Split [0, numIters) in chunks executed by the workers of the
+  /// calling locality, and attach them to counter.
+  void AsyncParallelFor(ShmCounter *counter,
+                        size_t numIters, RangeTaskTy &&task);
+  /// @brief Execute [0, numIters) on the workers of the calling locality.
+  void ParallelFor(size_t numIters, RangeTaskTy &&task);
+
+  /// @brief Get a counter for a new Handle.
+  ShmCounter *AcquireCounter();
+  /// @brief Give back the counter of a Handle that has been waited for.
+  ///
+  /// Counters are recycled and never freed, as copies of a Handle can
+  /// outlive the wait.
+  void ReleaseCounter(ShmCounter *counter);
+
+  /// @brief Notify the completion of a task to the locality that spawned it.
+  void SendAck(uint32_t dst, uint64_t token);
+
+  /// @brief Notify the scheduler that the calling thread is about to block.
+  void EnterBlocking();
+  /// @brief Notify the scheduler that the calling thread has resumed.
+  void ExitBlocking();
+
+ private:
+  struct Segment;
+  struct MessageHeader;
+  struct ReceiveState;
+
+  ShmScheduler();
+  ~ShmScheduler();
+
+  void Send(uint32_t dst, const MessageHeader &header, const uint8_t *payload);
+  void RingWrite(uint32_t dst, const uint8_t *data, size_t size);
+  bool Poll(uint32_t src);
+  void Dispatch(uint32_t src, ReceiveState &state);
+  void ProgressLoop();
+  void WorkerLoop();
+  void SpawnWorker();
+  void CheckLocalities();
+  bool HasPendingTasks() const;
+
+  uint32_t numLocalities_;
+  size_t workersPerLocality_;
+  size_t ringCapacity_;
+  Segment *segment_;
+  size_t segmentSize_;
+  std::atomic<bool> crossMemoryAttach_;
+
+  std::mutex countersLock_;
+  std::vector<ShmCounter *> freeCounters_;
+
+  std::unique_ptr<std::mutex[]> sendLocks_;
+  std::vector<ReceiveState> receiveStates_;
+
+  std::atomic<bool> stopProgress_;
+  std::thread progress_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::condition_variable shutdownCv_;
+  bool shutdown_;
+  bool stopWorkers_;
+  std::deque<TaskTy> inbox_[kNumPriorities];
+  std::vector<std::thread> workers_;
+  size_t active_;
+  size_t idle_;
+};
+
+}  // namespace impl
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_MAPPINGS_SHM_SHM_SCHEDULER_H_
@@ -0,0 +1,342 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_MAPPINGS_SHM_SHM_SYNCHRONOUS_INTERFACE_H_
+#define INCLUDE_SHAD_RUNTIME_MAPPINGS_SHM_SHM_SYNCHRONOUS_INTERFACE_H_
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#include "shad/runtime/locality.h"
+#include "shad/runtime/mappings/shm/shm_scheduler.h"
+#include "shad/runtime/mappings/shm/shm_traits_mapping.h"
+#include "shad/runtime/mappings/shm/shm_utility.h"
+#include "shad/runtime/synchronous_interface.h"
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+template <>
+struct SynchronousInterface<shm_tag> {
+  template <typename FunT, typename InArgsT>
+  static void executeAt(const Locality &loc, FunT &&function,
+                        const InArgsT &args) {
+    using FunctionTy = void (*)(const InArgsT &);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    ExecFunWrapperArgs<FunctionTy, InArgsT> funArgs{fn, args};
+    ShmScheduler::Instance().Call(
+        getNodeId(loc), execFunWrapper<FunctionTy, InArgsT>,
+        reinterpret_cast<const uint8_t *>(&funArgs), sizeof(funArgs), nullptr,
+        nullptr, 0);
+  }
+
+  template <typename FunT>
+  static void executeAt(const Locality &loc, FunT &&function,
+                        const std::shared_ptr<uint8_t> &argsBuffer,
+                        const uint32_t bufferSize) {
+    using FunctionTy = void (*)(const uint8_t *, const uint32_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    auto payload = makeBufferPayload(fn, argsBuffer.get(), bufferSize);
+    ShmScheduler::Instance().Call(getNodeId(loc), execFunWrapper<FunctionTy>,
+                                  payload.data(), payload.size(), nullptr,
+                                  nullptr, 0);
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void executeAtWithRetBuff(const Locality &loc, FunT &&function,
+                                   const InArgsT &args, uint8_t *resultBuffer,
+                                   uint32_t *resultSize) {
+    using FunctionTy = void (*)(const InArgsT &, uint8_t *, uint32_t *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    ExecFunWrapperArgs<FunctionTy, InArgsT> funArgs{fn, args};
+    ShmScheduler::Instance().Call(
+        getNodeId(loc), execFunWithRetBuffWrapper<FunctionTy, InArgsT>,
+        reinterpret_cast<const uint8_t *>(&funArgs), sizeof(funArgs),
+        resultBuffer, resultSize, ShmScheduler::kMaxReturnBufferSize);
+  }
+
+  template <typename FunT>
+  static void executeAtWithRetBuff(const Locality &loc, FunT &&function,
+                                   const std::shared_ptr<uint8_t> &argsBuffer,
+                                   const uint32_t bufferSize,
+                                   uint8_t *resultBuffer,
+                                   uint32_t *resultSize) {
+    using FunctionTy =
+        void (*)(const uint8_t *, const uint32_t, uint8_t *, uint32_t *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    auto payload = makeBufferPayload(fn, argsBuffer.get(), bufferSize);
+    ShmScheduler::Instance().Call(
+        getNodeId(loc), execFunWithRetBuffWrapper<FunctionTy>, payload.data(),
+        payload.size(), resultBuffer, resultSize,
+        ShmScheduler::kMaxReturnBufferSize);
+  }
+
+  template <typename FunT, typename InArgsT, typename ResT>
+  static void executeAtWithRet(const Locality &loc, FunT &&function,
+                               const InArgsT &args, ResT *result) {
+    using FunctionTy = void (*)(const InArgsT &, ResT *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    ExecFunWrapperArgs<FunctionTy, InArgsT> funArgs{fn, args};
+    ShmScheduler::Instance().Call(
+        getNodeId(loc), execFunWithRetWrapper<FunctionTy, InArgsT, ResT>,
+        reinterpret_cast<const uint8_t *>(&funArgs), sizeof(funArgs),
+        reinterpret_cast<uint8_t *>(result), nullptr, sizeof(ResT));
+  }
+
+  template <typename FunT, typename ResT>
+  static void executeAtWithRet(const Locality &loc, FunT &&function,
+                               const std::shared_ptr<uint8_t> &argsBuffer,
+                               const uint32_t bufferSize, ResT *result) {
+    using FunctionTy = void (*)(const uint8_t *, const uint32_t, ResT *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    auto payload = makeBufferPayload(fn, argsBuffer.get(), bufferSize);
+    ShmScheduler::Instance().Call(
+        getNodeId(loc), execFunWithRetWrapper<FunctionTy, ResT>,
+        payload.data(), payload.size(), reinterpret_cast<uint8_t *>(result),
+        nullptr, sizeof(ResT));
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void executeOnAll(FunT &&function, const InArgsT &args) {
+    using FunctionTy = void (*)(const InArgsT &);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    auto &scheduler = ShmScheduler::Instance();
+    ShmCounter counter;
+    ExecFunWrapperArgs<FunctionTy, InArgsT> funArgs{fn, args};
+    for (uint32_t L = 0; L < scheduler.NumLocalities(); ++L) {
+      scheduler.Spawn(L, &counter, execFunWrapper<FunctionTy, InArgsT>,
+                      reinterpret_cast<const uint8_t *>(&funArgs),
+                      sizeof(funArgs), nullptr, nullptr, 0);
+    }
+    counter.Wait();
+  }
+
+  template <typename FunT>
+  static void executeOnAll(FunT &&function,
+                           const std::shared_ptr<uint8_t> &argsBuffer,
+                           const uint32_t bufferSize) {
+    using FunctionTy = void (*)(const uint8_t *, const uint32_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    auto &scheduler = ShmScheduler::Instance();
+    ShmCounter counter;
+    auto payload = makeBufferPayload(fn, argsBuffer.get(), bufferSize);
+    for (uint32_t L = 0; L < scheduler.NumLocalities(); ++L) {
+      scheduler.Spawn(L, &counter, execFunWrapper<FunctionTy>, payload.data(),
+                      payload.size(), nullptr, nullptr, 0);
+    }
+    counter.Wait();
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void forEachAt(const Locality &loc, FunT &&function,
+                        const InArgsT &args, const size_t numIters) {
+    using FunctionTy = void (*)(const InArgsT &, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    ForEachWrapperArgs<FunctionTy, InArgsT> funArgs{fn, 0, numIters, args};
+    ShmScheduler::Instance().Call(
+        getNodeId(loc), forEachWrapper<FunctionTy, InArgsT>,
+        reinterpret_cast<const uint8_t *>(&funArgs), sizeof(funArgs), nullptr,
+        nullptr, 0);
+  }
+
+  template <typename FunT>
+  static void forEachAt(const Locality &loc, FunT &&function,
+                        const std::shared_ptr<uint8_t> &argsBuffer,
+                        const uint32_t bufferSize, const size_t numIters) {
+    using FunctionTy = void (*)(const uint8_t *, const uint32_t, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    auto payload =
+        makeBufferPayload(fn, argsBuffer.get(), bufferSize, 0, numIters);
+    ShmScheduler::Instance().Call(getNodeId(loc), forEachWrapper<FunctionTy>,
+                                  payload.data(), payload.size(), nullptr,
+                                  nullptr, 0);
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void forEachOnAll(FunT &&function, const InArgsT &args,
+                           const size_t numIters) {
+    using FunctionTy = void (*)(const InArgsT &, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    // No need to do anything.
+    if (!numIters) return;
+
+    auto &scheduler = ShmScheduler::Instance();
+    size_t numLocalities = scheduler.NumLocalities();
+    size_t block = (numIters + numLocalities - 1) / numLocalities;
+    ShmCounter counter;
+    for (size_t L = 0; L < numLocalities && L * block < numIters; ++L) {
+      size_t first = L * block;
+      size_t last = std::min(first + block, numIters);
+      ForEachWrapperArgs<FunctionTy, InArgsT> funArgs{fn, first, last, args};
+      scheduler.Spawn(L, &counter, forEachWrapper<FunctionTy, InArgsT>,
+                      reinterpret_cast<const uint8_t *>(&funArgs),
+                      sizeof(funArgs), nullptr, nullptr, 0);
+    }
+    counter.Wait();
+  }
+
+  template <typename FunT>
+  static void forEachOnAll(FunT &&function,
+                           const std::shared_ptr<uint8_t> &argsBuffer,
+                           const uint32_t bufferSize, const size_t numIters) {
+    using FunctionTy = void (*)(const uint8_t *, const uint32_t, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    // No need to do anything.
+    if (!numIters) return;
+
+    auto &scheduler = ShmScheduler::Instance();
+    size_t numLocalities = scheduler.NumLocalities();
+    size_t block = (numIters + numLocalities - 1) / numLocalities;
+    ShmCounter counter;
+    for (size_t L = 0; L < numLocalities && L * block < numIters; ++L) {
+      size_t first = L * block;
+      size_t last = std::min(first + block, numIters);
+      auto payload =
+          makeBufferPayload(fn, argsBuffer.get(), bufferSize, first, last);
+      scheduler.Spawn(L, &counter, forEachWrapper<FunctionTy>, payload.data(),
+                      payload.size(), nullptr, nullptr, 0);
+    }
+    counter.Wait();
+  }
+
+  template <typename T>
+  static void dma(const Locality &destLoc, const T *remoteAddress,
+                  const T *localData, const size_t numElements) {
+    checkLocality(destLoc);
+    ShmScheduler::Instance().Put(getNodeId(destLoc), (void *)remoteAddress,
+                                 localData, numElements * sizeof(T));
+  }
+
+  template <typename T>
+  static void dma(const T *localAddress, const Locality &srcLoc,
+                  const T *remoteData, const size_t numElements) {
+    checkLocality(srcLoc);
+    ShmScheduler::Instance().Get((void *)localAddress, getNodeId(srcLoc),
+                                 remoteData, numElements * sizeof(T));
+  }
+
+  template <typename T>
+  static void dmaScatter(const Locality &destLoc,
+                         const DmaSegment<T> *remoteSegments,
+                         const size_t numSegments, const T *localData) {
+    checkLocality(destLoc);
+    auto segments = byteSegments(remoteSegments, numSegments);
+    ShmScheduler::Instance().Scatter(getNodeId(destLoc), segments.data(),
+                                     segments.size(), localData);
+  }
+
+  template <typename T>
+  static void dmaGather(const T *localAddress, const Locality &srcLoc,
+                        const DmaSegment<T> *remoteSegments,
+                        const size_t numSegments) {
+    checkLocality(srcLoc);
+    auto segments = byteSegments(remoteSegments, numSegments);
+    ShmScheduler::Instance().Gather((void *)localAddress, getNodeId(srcLoc),
+                                    segments.data(), segments.size());
+  }
+
+  template <typename T>
+  static void dmaStrided(const Locality &destLoc, const T *remoteBase,
+                         const size_t stride, const T *localData,
+                         const size_t numElements) {
+    checkLocality(destLoc);
+    auto segments =
+        byteSegments(DmaStride<T>{remoteBase, stride, numElements});
+    ShmScheduler::Instance().Scatter(getNodeId(destLoc), segments.data(),
+                                     segments.size(), localData);
+  }
+
+  template <typename T>
+  static void dmaStrided(const T *localAddress, const Locality &srcLoc,
+                         const T *remoteBase, const size_t stride,
+                         const size_t numElements) {
+    checkLocality(srcLoc);
+    auto segments =
+        byteSegments(DmaStride<T>{remoteBase, stride, numElements});
+    ShmScheduler::Instance().Gather((void *)localAddress, getNodeId(srcLoc),
+                                    segments.data(), segments.size());
+  }
+
+  template <typename T>
+  static T atomic(const Locality &loc, const AtomicArgs<T> &args) {
+    checkLocality(loc);
+    T value;
+    ShmScheduler::Instance().CallInline(
+        getNodeId(loc), atomicWrapper<T>,
+        reinterpret_cast<const uint8_t *>(&args), sizeof(args),
+        reinterpret_cast<uint8_t *>(&value), nullptr, sizeof(T));
+    return value;
+  }
+};
+
+}  // namespace impl
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_MAPPINGS_SHM_SHM_SYNCHRONOUS_INTERFACE_H_
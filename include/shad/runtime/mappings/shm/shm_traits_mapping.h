@@ -0,0 +1,130 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_MAPPINGS_SHM_SHM_TRAITS_MAPPING_H_
+#define INCLUDE_SHAD_RUNTIME_MAPPINGS_SHM_SHM_TRAITS_MAPPING_H_
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "shad/runtime/mapping_traits.h"
+#include "shad/runtime/mappings/shm/shm_scheduler.h"
+
+namespace shad {
+
+namespace rt {
+namespace impl {
+
+struct shm_tag {};
+
+// Handles are copied by value in the arguments of the tasks, hence they must
+// be trivially copyable: they refer to a counter owned by the scheduler.
+template <>
+struct HandleTrait<shm_tag> {
+  using HandleTy = ShmCounter *;
+  using ParameterTy = ShmCounter *&;
+  using ConstParameterTy = ShmCounter *const &;
+
+  static void Init(ParameterTy H, HandleTy V) { H = V; }
+
+  static constexpr HandleTy NullValue() { return nullptr; }
+
+  static bool Equal(ConstParameterTy lhs, ConstParameterTy rhs) {
+    return lhs == rhs;
+  }
+
+  static std::string toString(ConstParameterTy H) {
+    return std::to_string(toUnsignedInt(H));
+  }
+
+  static uint64_t toUnsignedInt(ConstParameterTy H) {
+    return reinterpret_cast<uint64_t>(H);
+  }
+
+  static HandleTy CreateNewHandle() {
+    return ShmScheduler::Instance().AcquireCounter();
+  }
+
+  static void WaitFor(ParameterTy H) {
+    if (H == NullValue()) return;
+    H->Wait();
+    ShmScheduler::Instance().ReleaseCounter(H);
+    H = NullValue();
+  }
+};
+
+template <>
+struct LockTrait<shm_tag> {
+  using LockTy = std::mutex;
+
+  static void lock(LockTy &L) {
+    if (L.try_lock()) return;
+
+    // Waiting for the lock must not starve the workers of the locality.
+    auto &scheduler = ShmScheduler::Instance();
+    scheduler.EnterBlocking();
+    L.lock();
+    scheduler.ExitBlocking();
+  }
+  static void unlock(LockTy &L) { L.unlock(); }
+};
+
+template <>
+struct RuntimeInternalsTrait<shm_tag> {
+  static void Initialize(int argc, char *argv[]) {}
+
+  static void Finalize() {}
+
+  static size_t Concurrency() {
+    return ShmScheduler::Instance().WorkersPerLocality();
+  }
+
+  static void Yield() { std::this_thread::yield(); }
+
+  static uint32_t ThisLocality() { return ShmScheduler::ThisLocality(); }
+  static uint32_t NullLocality() { return -1; }
+  static uint32_t NumLocalities() {
+    return ShmScheduler::Instance().NumLocalities();
+  }
+
+  static uint32_t NumProcessLocalities() { return 1; }
+  static uint32_t ProcessLocalityIndex() { return 0; }
+
+  static size_t QueueDepth(Priority p) {
+    return ShmScheduler::Instance().QueueDepth(p);
+  }
+};
+
+}  // namespace impl
+
+using TargetSystemTag = impl::shm_tag;
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_MAPPINGS_SHM_SHM_TRAITS_MAPPING_H_
@@ -0,0 +1,315 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_MAPPINGS_SHM_SHM_UTILITY_H_
+#define INCLUDE_SHAD_RUNTIME_MAPPINGS_SHM_SHM_UTILITY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <system_error>
+#include <vector>
+
+#include "shad/runtime/atomics.h"
+#include "shad/runtime/handle.h"
+#include "shad/runtime/locality.h"
+#include "shad/runtime/mappings/shm/shm_scheduler.h"
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+inline uint32_t getNodeId(const Locality &loc) {
+  return static_cast<uint32_t>(loc);
+}
+
+inline void checkLocality(const Locality &loc) {
+  uint32_t nodeID = getNodeId(loc);
+  if (nodeID >= ShmScheduler::Instance().NumLocalities()) {
+    std::stringstream ss;
+    ss << "The system does not include " << loc;
+    throw std::system_error(0xdeadc0de, std::generic_category(), ss.str());
+  }
+}
+
+inline void checkOutputSize(size_t size) {
+  if (size > ShmScheduler::kMaxReturnBufferSize) {
+    std::stringstream ss;
+    ss << "The output size exeeds the hard limit of "
+       << ShmScheduler::kMaxReturnBufferSize << "B imposed by SHM.";
+    throw std::system_error(0xdeadc0de, std::generic_category(), ss.str());
+  }
+}
+
+/// @brief Structure to build the function closure to be sent.
+template <typename FunT, typename InArgsT>
+struct ExecFunWrapperArgs {
+  FunT fun;
+  InArgsT args;
+};
+
+/// @brief Structure to build the closure of a loop to be sent.
+template <typename FunT, typename InArgsT>
+struct ForEachWrapperArgs {
+  FunT fun;
+  size_t first;
+  size_t last;
+  InArgsT args;
+};
+
+/// @brief Header of the closures carrying an arguments buffer.
+template <typename FunT>
+struct BufferWrapperArgs {
+  FunT fun;
+  size_t first;
+  size_t last;
+};
+
+/// @brief Build the payload of a closure carrying an arguments buffer.
+template <typename FunT>
+std::vector<uint8_t> makeBufferPayload(FunT fun, const uint8_t *argsBuffer,
+                                       const uint32_t bufferSize,
+                                       size_t first = 0, size_t last = 0) {
+  std::vector<uint8_t> payload(sizeof(BufferWrapperArgs<FunT>) + bufferSize);
+  BufferWrapperArgs<FunT> header{fun, first, last};
+  memcpy(payload.data(), &header, sizeof(header));
+  if (argsBuffer != nullptr && bufferSize)
+    memcpy(payload.data() + sizeof(header), argsBuffer, bufferSize);
+  return payload;
+}
+
+template <typename FunT>
+const BufferWrapperArgs<FunT> &bufferHeader(const uint8_t *payload) {
+  return *reinterpret_cast<const BufferWrapperArgs<FunT> *>(payload);
+}
+
+inline const uint8_t *bufferArgs(const uint8_t *payload, size_t headerSize) {
+  return payload + headerSize;
+}
+
+template <typename FunT, typename InArgsT>
+void execFunWrapper(const uint8_t *payload, size_t,
+                    ShmCounter *, uint8_t *,
+                    uint32_t *) {
+  const auto &funArgs =
+      *reinterpret_cast<const ExecFunWrapperArgs<FunT, InArgsT> *>(payload);
+  funArgs.fun(funArgs.args);
+}
+
+template <typename FunT>
+void execFunWrapper(const uint8_t *payload, size_t size,
+                    ShmCounter *, uint8_t *,
+                    uint32_t *) {
+  constexpr size_t kHeaderSize = sizeof(BufferWrapperArgs<FunT>);
+  bufferHeader<FunT>(payload).fun(bufferArgs(payload, kHeaderSize),
+                                  size - kHeaderSize);
+}
+
+template <typename FunT, typename InArgsT>
+void execFunWithRetBuffWrapper(const uint8_t *payload, size_t,
+                               ShmCounter *,
+                               uint8_t *result, uint32_t *resultSize) {
+  const auto &funArgs =
+      *reinterpret_cast<const ExecFunWrapperArgs<FunT, InArgsT> *>(payload);
+  funArgs.fun(funArgs.args, result, resultSize);
+
+  checkOutputSize(*resultSize);
+}
+
+template <typename FunT>
+void execFunWithRetBuffWrapper(const uint8_t *payload, size_t size,
+                               ShmCounter *,
+                               uint8_t *result, uint32_t *resultSize) {
+  constexpr size_t kHeaderSize = sizeof(BufferWrapperArgs<FunT>);
+  bufferHeader<FunT>(payload).fun(bufferArgs(payload, kHeaderSize),
+                                  size - kHeaderSize, result, resultSize);
+
+  checkOutputSize(*resultSize);
+}
+
+template <typename FunT, typename InArgsT, typename ResT>
+void execFunWithRetWrapper(const uint8_t *payload, size_t,
+                           ShmCounter *,
+                           uint8_t *result, uint32_t *resultSize) {
+  const auto &funArgs =
+      *reinterpret_cast<const ExecFunWrapperArgs<FunT, InArgsT> *>(payload);
+  funArgs.fun(funArgs.args, reinterpret_cast<ResT *>(result));
+  *resultSize = sizeof(ResT);
+}
+
+template <typename FunT, typename ResT>
+void execFunWithRetWrapper(const uint8_t *payload, size_t size,
+                           ShmCounter *,
+                           uint8_t *result, uint32_t *resultSize) {
+  constexpr size_t kHeaderSize = sizeof(BufferWrapperArgs<FunT>);
+  bufferHeader<FunT>(payload).fun(bufferArgs(payload, kHeaderSize),
+                                  size - kHeaderSize,
+                                  reinterpret_cast<ResT *>(result));
+  *resultSize = sizeof(ResT);
+}
+
+template <typename FunT, typename InArgsT>
+void forEachWrapper(const uint8_t *payload, size_t,
+                    ShmCounter *, uint8_t *,
+                    uint32_t *) {
+  const auto &funArgs =
+      *reinterpret_cast<const ForEachWrapperArgs<FunT, InArgsT> *>(payload);
+  ShmScheduler::Instance().ParallelFor(
+      funArgs.last - funArgs.first, [&](size_t begin, size_t end) {
+        for (size_t i = funArgs.first + begin; i < funArgs.first + end; ++i)
+          funArgs.fun(funArgs.args, i);
+      });
+}
+
+template <typename FunT>
+void forEachWrapper(const uint8_t *payload, size_t size,
+                    ShmCounter *, uint8_t *,
+                    uint32_t *) {
+  constexpr size_t kHeaderSize = sizeof(BufferWrapperArgs<FunT>);
+  const auto &header = bufferHeader<FunT>(payload);
+  const uint8_t *argsBuffer = bufferArgs(payload, kHeaderSize);
+  const uint32_t bufferSize = size - kHeaderSize;
+  ShmScheduler::Instance().ParallelFor(
+      header.last - header.first, [&](size_t begin, size_t end) {
+        for (size_t i = header.first + begin; i < header.first + end; ++i)
+          header.fun(argsBuffer, bufferSize, i);
+      });
+}
+
+template <typename FunT, typename InArgsT>
+void asyncExecFunWrapper(const uint8_t *payload, size_t,
+                         ShmCounter *counter,
+                         uint8_t *, uint32_t *) {
+  const auto &funArgs =
+      *reinterpret_cast<const ExecFunWrapperArgs<FunT, InArgsT> *>(payload);
+  Handle H(counter);
+  funArgs.fun(H, funArgs.args);
+}
+
+template <typename FunT>
+void asyncExecFunWrapper(const uint8_t *payload, size_t size,
+                         ShmCounter *counter,
+                         uint8_t *, uint32_t *) {
+  constexpr size_t kHeaderSize = sizeof(BufferWrapperArgs<FunT>);
+  Handle H(counter);
+  bufferHeader<FunT>(payload).fun(H, bufferArgs(payload, kHeaderSize),
+                                  size - kHeaderSize);
+}
+
+template <typename FunT, typename InArgsT>
+void asyncExecFunWithRetBuffWrapper(const uint8_t *payload, size_t,
+                                    ShmCounter *counter,
+                                    uint8_t *result, uint32_t *resultSize) {
+  const auto &funArgs =
+      *reinterpret_cast<const ExecFunWrapperArgs<FunT, InArgsT> *>(payload);
+  Handle H(counter);
+  funArgs.fun(H, funArgs.args, result, resultSize);
+
+  checkOutputSize(*resultSize);
+}
+
+template <typename FunT>
+void asyncExecFunWithRetBuffWrapper(const uint8_t *payload, size_t size,
+                                    ShmCounter *counter,
+                                    uint8_t *result, uint32_t *resultSize) {
+  constexpr size_t kHeaderSize = sizeof(BufferWrapperArgs<FunT>);
+  Handle H(counter);
+  bufferHeader<FunT>(payload).fun(H, bufferArgs(payload, kHeaderSize),
+                                  size - kHeaderSize, result, resultSize);
+
+  checkOutputSize(*resultSize);
+}
+
+template <typename FunT, typename InArgsT, typename ResT>
+void asyncExecFunWithRetWrapper(const uint8_t *payload, size_t,
+                                ShmCounter *counter,
+                                uint8_t *result, uint32_t *resultSize) {
+  const auto &funArgs =
+      *reinterpret_cast<const ExecFunWrapperArgs<FunT, InArgsT> *>(payload);
+  Handle H(counter);
+  funArgs.fun(H, funArgs.args, reinterpret_cast<ResT *>(result));
+  *resultSize = sizeof(ResT);
+}
+
+template <typename FunT, typename ResT>
+void asyncExecFunWithRetWrapper(const uint8_t *payload, size_t size,
+                                ShmCounter *counter,
+                                uint8_t *result, uint32_t *resultSize) {
+  constexpr size_t kHeaderSize = sizeof(BufferWrapperArgs<FunT>);
+  Handle H(counter);
+  bufferHeader<FunT>(payload).fun(H, bufferArgs(payload, kHeaderSize),
+                                  size - kHeaderSize,
+                                  reinterpret_cast<ResT *>(result));
+  *resultSize = sizeof(ResT);
+}
+
+template <typename FunT, typename InArgsT>
+void asyncForEachWrapper(const uint8_t *payload, size_t,
+                         ShmCounter *counter,
+                         uint8_t *, uint32_t *) {
+  const auto funArgs =
+      *reinterpret_cast<const ForEachWrapperArgs<FunT, InArgsT> *>(payload);
+  ShmScheduler::Instance().AsyncParallelFor(
+      counter, funArgs.last - funArgs.first,
+      [funArgs, counter](size_t begin, size_t end) {
+        Handle H(counter);
+        for (size_t i = funArgs.first + begin; i < funArgs.first + end; ++i)
+          funArgs.fun(H, funArgs.args, i);
+      });
+}
+
+template <typename FunT>
+void asyncForEachWrapper(const uint8_t *payload, size_t size,
+                         ShmCounter *counter,
+                         uint8_t *, uint32_t *) {
+  constexpr size_t kHeaderSize = sizeof(BufferWrapperArgs<FunT>);
+  const auto header = bufferHeader<FunT>(payload);
+  auto argsBuffer = std::make_shared<std::vector<uint8_t>>(
+      bufferArgs(payload, kHeaderSize), payload + size);
+  ShmScheduler::Instance().AsyncParallelFor(
+      counter, header.last - header.first,
+      [header, argsBuffer, counter](size_t begin, size_t end) {
+        Handle H(counter);
+        for (size_t i = header.first + begin; i < header.first + end; ++i)
+          header.fun(H, argsBuffer->data(), argsBuffer->size(), i);
+      });
+}
+
+template <typename T>
+void atomicWrapper(const uint8_t *payload, size_t, ShmCounter *,
+                   uint8_t *result, uint32_t *resultSize) {
+  T value = applyAtomic(*reinterpret_cast<const AtomicArgs<T> *>(payload));
+  if (result != nullptr) memcpy(result, &value, sizeof(T));
+  *resultSize = sizeof(T);
+}
+
+}  // namespace impl
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_MAPPINGS_SHM_SHM_UTILITY_H_
@@ -0,0 +1,370 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_MAPPINGS_SIM_SIM_ASYNCHRONOUS_INTERFACE_H_
+#define INCLUDE_SHAD_RUNTIME_MAPPINGS_SIM_SIM_ASYNCHRONOUS_INTERFACE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "shad/runtime/asynchronous_interface.h"
+#include "shad/runtime/handle.h"
+#include "shad/runtime/locality.h"
+#include "shad/runtime/mapping_traits.h"
+#include "shad/runtime/mappings/sim/sim_scheduler.h"
+#include "shad/runtime/mappings/sim/sim_utility.h"
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+template <>
+struct AsynchronousInterface<sim_tag> {
+  template <typename FunT, typename InArgsT>
+  static void asyncExecuteAt(Handle &handle, const Locality &loc,
+                             FunT &&function, const InArgsT &args) {
+    using FunctionTy = void (*)(Handle &, const InArgsT &);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<sim_tag>::CreateNewHandle() : handle.id_;
+
+    auto counter = handle.id_;
+    counter->Increment();
+    SimScheduler::Instance().Post(getNodeId(loc), sizeof(InArgsT), [=] {
+      Handle H(counter);
+      fn(H, args);
+      counter->Decrement();
+    });
+  }
+
+  template <typename FunT>
+  static void asyncExecuteAt(Handle &handle, const Locality &loc,
+                             FunT &&function,
+                             const std::shared_ptr<uint8_t> &argsBuffer,
+                             const uint32_t bufferSize) {
+    using FunctionTy = void (*)(Handle &, const uint8_t *, const uint32_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<sim_tag>::CreateNewHandle() : handle.id_;
+
+    auto counter = handle.id_;
+    counter->Increment();
+    SimScheduler::Instance().Post(getNodeId(loc), bufferSize, [=] {
+      Handle H(counter);
+      fn(H, argsBuffer.get(), bufferSize);
+      counter->Decrement();
+    });
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void asyncExecuteAtWithRetBuff(Handle &handle, const Locality &loc,
+                                        FunT &&function, const InArgsT &args,
+                                        uint8_t *resultBuffer,
+                                        uint32_t *resultSize) {
+    using FunctionTy =
+        void (*)(Handle &, const InArgsT &, uint8_t *, uint32_t *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<sim_tag>::CreateNewHandle() : handle.id_;
+
+    auto counter = handle.id_;
+    counter->Increment();
+    SimScheduler::Instance().Post(getNodeId(loc), sizeof(InArgsT), [=] {
+      Handle H(counter);
+      fn(H, args, resultBuffer, resultSize);
+      counter->Decrement();
+    });
+  }
+
+  template <typename FunT>
+  static void asyncExecuteAtWithRetBuff(
+      Handle &handle, const Locality &loc, FunT &&function,
+      const std::shared_ptr<uint8_t> &argsBuffer, const uint32_t bufferSize,
+      uint8_t *resultBuffer, uint32_t *resultSize) {
+    using FunctionTy = void (*)(Handle &, const uint8_t *, const uint32_t,
+                                uint8_t *, uint32_t *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<sim_tag>::CreateNewHandle() : handle.id_;
+
+    auto counter = handle.id_;
+    counter->Increment();
+    SimScheduler::Instance().Post(getNodeId(loc), bufferSize, [=] {
+      Handle H(counter);
+      fn(H, argsBuffer.get(), bufferSize, resultBuffer, resultSize);
+      counter->Decrement();
+    });
+  }
+
+  template <typename FunT, typename InArgsT, typename ResT>
+  static void asyncExecuteAtWithRet(Handle &handle, const Locality &loc,
+                                    FunT &&function, const InArgsT &args,
+                                    ResT *result) {
+    using FunctionTy = void (*)(Handle &, const InArgsT &, ResT *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<sim_tag>::CreateNewHandle() : handle.id_;
+
+    auto counter = handle.id_;
+    counter->Increment();
+    SimScheduler::Instance().Post(getNodeId(loc), sizeof(InArgsT), [=] {
+      Handle H(counter);
+      fn(H, args, result);
+      counter->Decrement();
+    });
+  }
+
+  template <typename FunT, typename ResT>
+  static void asyncExecuteAtWithRet(Handle &handle, const Locality &loc,
+                                    FunT &&function,
+                                    const std::shared_ptr<uint8_t> &argsBuffer,
+                                    const uint32_t bufferSize, ResT *result) {
+    using FunctionTy =
+        void (*)(Handle &, const uint8_t *, const uint32_t, ResT *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<sim_tag>::CreateNewHandle() : handle.id_;
+
+    auto counter = handle.id_;
+    counter->Increment();
+    SimScheduler::Instance().Post(getNodeId(loc), bufferSize, [=] {
+      Handle H(counter);
+      fn(H, argsBuffer.get(), bufferSize, result);
+      counter->Decrement();
+    });
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void asyncExecuteOnAll(Handle &handle, FunT &&function,
+                                const InArgsT &args) {
+    using FunctionTy = void (*)(Handle &, const InArgsT &);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<sim_tag>::CreateNewHandle() : handle.id_;
+
+    auto &scheduler = SimScheduler::Instance();
+    auto counter = handle.id_;
+    counter->Increment(scheduler.NumLocalities());
+    for (uint32_t L = 0; L < scheduler.NumLocalities(); ++L) {
+      scheduler.Post(L, sizeof(InArgsT), [=] {
+        Handle H(counter);
+        fn(H, args);
+        counter->Decrement();
+      });
+    }
+  }
+
+  template <typename FunT>
+  static void asyncExecuteOnAll(Handle &handle, FunT &&function,
+                                const std::shared_ptr<uint8_t> &argsBuffer,
+                                const uint32_t bufferSize) {
+    using FunctionTy = void (*)(Handle &, const uint8_t *, const uint32_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<sim_tag>::CreateNewHandle() : handle.id_;
+
+    auto &scheduler = SimScheduler::Instance();
+    auto counter = handle.id_;
+    counter->Increment(scheduler.NumLocalities());
+    for (uint32_t L = 0; L < scheduler.NumLocalities(); ++L) {
+      scheduler.Post(L, bufferSize, [=] {
+        Handle H(counter);
+        fn(H, argsBuffer.get(), bufferSize);
+        counter->Decrement();
+      });
+    }
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void asyncForEachAt(Handle &handle, const Locality &loc,
+                             FunT &&function, const InArgsT &args,
+                             const size_t numIters) {
+    using FunctionTy = void (*)(Handle &, const InArgsT &, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<sim_tag>::CreateNewHandle() : handle.id_;
+
+    auto counter = handle.id_;
+    counter->Increment();
+    SimScheduler::Instance().Post(getNodeId(loc), sizeof(InArgsT), [=] {
+      SimScheduler::Instance().AsyncParallelFor(
+          counter, numIters, [=](size_t begin, size_t end) {
+            Handle H(counter);
+            for (size_t i = begin; i < end; ++i) fn(H, args, i);
+          });
+      counter->Decrement();
+    });
+  }
+
+  template <typename FunT>
+  static void asyncForEachAt(Handle &handle, const Locality &loc,
+                             FunT &&function,
+                             const std::shared_ptr<uint8_t> &argsBuffer,
+                             const uint32_t bufferSize, const size_t numIters) {
+    using FunctionTy =
+        void (*)(Handle &, const uint8_t *, const uint32_t, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<sim_tag>::CreateNewHandle() : handle.id_;
+
+    auto counter = handle.id_;
+    counter->Increment();
+    SimScheduler::Instance().Post(getNodeId(loc), bufferSize, [=] {
+      SimScheduler::Instance().AsyncParallelFor(
+          counter, numIters, [=](size_t begin, size_t end) {
+            Handle H(counter);
+            for (size_t i = begin; i < end; ++i)
+              fn(H, argsBuffer.get(), bufferSize, i);
+          });
+      counter->Decrement();
+    });
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void asyncForEachOnAll(Handle &handle, FunT &&function,
+                                const InArgsT &args, const size_t numIters) {
+    using FunctionTy = void (*)(Handle &, const InArgsT &, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<sim_tag>::CreateNewHandle() : handle.id_;
+
+    auto &scheduler = SimScheduler::Instance();
+    auto counter = handle.id_;
+    size_t numLocalities = scheduler.NumLocalities();
+    size_t block = (numIters + numLocalities - 1) / numLocalities;
+    for (size_t L = 0; L < numLocalities && L * block < numIters; ++L) {
+      size_t first = L * block;
+      size_t last = std::min(first + block, numIters);
+      counter->Increment();
+      scheduler.Post(L, sizeof(InArgsT), [=] {
+        SimScheduler::Instance().AsyncParallelFor(
+            counter, last - first, [=](size_t begin, size_t end) {
+              Handle H(counter);
+              for (size_t i = first + begin; i < first + end; ++i)
+                fn(H, args, i);
+            });
+        counter->Decrement();
+      });
+    }
+  }
+
+  template <typename FunT>
+  static void asyncForEachOnAll(Handle &handle, FunT &&function,
+                                const std::shared_ptr<uint8_t> &argsBuffer,
+                                const uint32_t bufferSize,
+                                const size_t numIters) {
+    using FunctionTy =
+        void (*)(Handle &, const uint8_t *, const uint32_t, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<sim_tag>::CreateNewHandle() : handle.id_;
+
+    auto &scheduler = SimScheduler::Instance();
+    auto counter = handle.id_;
+    size_t numLocalities = scheduler.NumLocalities();
+    size_t block = (numIters + numLocalities - 1) / numLocalities;
+    for (size_t L = 0; L < numLocalities && L * block < numIters; ++L) {
+      size_t first = L * block;
+      size_t last = std::min(first + block, numIters);
+      counter->Increment();
+      scheduler.Post(L, bufferSize, [=] {
+        SimScheduler::Instance().AsyncParallelFor(
+            counter, last - first, [=](size_t begin, size_t end) {
+              Handle H(counter);
+              for (size_t i = first + begin; i < first + end; ++i)
+                fn(H, argsBuffer.get(), bufferSize, i);
+            });
+        counter->Decrement();
+      });
+    }
+  }
+
+  template <typename T>
+  static void asyncAtomic(Handle &handle, const Locality &loc,
+                          const AtomicArgs<T> &args, T *result) {
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<sim_tag>::CreateNewHandle() : handle.id_;
+
+    auto counter = handle.id_;
+    counter->Increment();
+    SimScheduler::Instance().Post(getNodeId(loc), sizeof(args), [=] {
+      T value = applyAtomic(args);
+      if (result != nullptr) *result = value;
+      counter->Decrement();
+    });
+  }
+};
+
+}  // namespace impl
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_MAPPINGS_SIM_SIM_ASYNCHRONOUS_INTERFACE_H_
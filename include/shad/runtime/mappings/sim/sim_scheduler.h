@@ -0,0 +1,185 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_MAPPINGS_SIM_SIM_SCHEDULER_H_
+#define INCLUDE_SHAD_RUNTIME_MAPPINGS_SIM_SIM_SCHEDULER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "shad/runtime/priority.h"
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+/// @brief Completion counter used by the SIM mapping.
+///
+/// The counter tracks the number of outstanding tasks attached to it.  It is
+/// used both as the Handle of asynchronous operations and to implement the
+/// blocking wait of synchronous remote operations.
+class SimCounter {
+ public:
+  SimCounter() : count_(0) {}
+
+  /// @brief Register n new outstanding tasks.
+  void Increment(size_t n = 1) { count_.fetch_add(n); }
+
+  /// @brief Signal the completion of an outstanding task.
+  void Decrement() {
+    if (count_.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> _(mutex_);
+      cv_.notify_all();
+    }
+  }
+
+  /// @brief Wait until all the outstanding tasks have completed.
+  void Wait();
+
+ private:
+  std::atomic<size_t> count_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+/// @brief Scheduler of the SIM mapping.
+///
+/// The SIM mapping runs N localities as groups of threads within a single
+/// process.  Every locality owns a pool of workers and an inbox per
+/// scheduling class: remote operations are delivered to the inbox of the
+/// target locality, after a delay modeling the latency and the bandwidth of
+/// the interconnect.  Workers serve the most urgent class with a delivered
+/// message first.
+///
+/// The scheduler is configured through the following environment variables:
+///  - SHAD_SIM_LOCALITIES: number of localities (default 2);
+///  - SHAD_SIM_WORKERS: workers per locality (default: hardware concurrency
+///    divided by the number of localities);
+///  - SHAD_SIM_LATENCY_NS: injected one-way latency in nanoseconds
+///    (default 0);
+///  - SHAD_SIM_BANDWIDTH_MBPS: bandwidth of the inbound link of each
+///    locality in MB/s (default 0, meaning unlimited).
+///
+/// @warning Localities share the address space of the process: global and
+/// static variables are shared among all the localities.
+class SimScheduler {
+ public:
+  using TaskTy = std::function<void()>;
+  using RangeTaskTy = std::function<void(size_t, size_t)>;
+  using ClockTy = std::chrono::steady_clock;
+
+  /// @brief Get the singleton instance of the scheduler.
+  static SimScheduler &Instance();
+
+  /// @brief Start the worker pools of all the localities.
+  void Start();
+  /// @brief Drain the inboxes and join all the workers.
+  void Stop();
+
+  uint32_t NumLocalities() const { return numLocalities_; }
+  size_t WorkersPerLocality() const { return workersPerLocality_; }
+
+  /// @brief The locality of the calling thread.
+  ///
+  /// The main thread of the program belongs to locality 0.
+  static uint32_t ThisLocality();
+
+  /// @brief Deliver a task to the inbox of a locality.
+  ///
+  /// Messages between different localities are subject to the injected
+  /// latency and bandwidth; messages to the calling locality are not.  The
+  /// task is queued with the priority of the calling thread.
+  ///
+  /// @param dst The target locality.
+  /// @param numBytes The size of the payload carried by the message.
+  /// @param task The task to be executed at dst.
+  void Post(uint32_t dst, size_t numBytes, TaskTy &&task);
+
+  /// @brief Number of messages of class p in the inbox of a locality.
+  size_t QueueDepth(uint32_t locality, Priority p);
+
+  /// @brief Synchronously execute a task on a locality.
+  ///
+  /// Tasks targeting the calling locality are executed in place.
+  ///
+  /// @param dst The target locality.
+  /// @param numBytes The size of the payload carried by the request.
+  /// @param task The task to be executed at dst; it returns the size of the
+  /// payload carried by the reply.
+  void Call(uint32_t dst, size_t numBytes, const std::function<size_t()> &task);
+
+  /// @brief Split [0, numIters) in chunks executed by the workers of the
+  /// calling locality, and attach them to counter.
+  void AsyncParallelFor(const std::shared_ptr<SimCounter> &counter,
+                        size_t numIters, RangeTaskTy &&task);
+
+  /// @brief Execute [0, numIters) on the workers of the calling locality.
+  void ParallelFor(size_t numIters, RangeTaskTy &&task);
+
+  /// @brief Notify the scheduler that the calling thread is about to block.
+  ///
+  /// Blocked workers are compensated so that a locality never runs out of
+  /// workers able to serve its inbox.
+  void EnterBlocking();
+  /// @brief Notify the scheduler that the calling thread has resumed.
+  void ExitBlocking();
+
+ private:
+  struct Message {
+    ClockTy::time_point readyAt;
+    TaskTy task;
+  };
+
+  struct LocalityState;
+
+  SimScheduler();
+  ~SimScheduler();
+
+  void WorkerLoop(uint32_t locality);
+  void SpawnWorker(LocalityState &state, uint32_t locality);
+  ClockTy::duration TransferTime(size_t numBytes) const;
+  void Delay(ClockTy::duration duration) const;
+
+  uint32_t numLocalities_;
+  size_t workersPerLocality_;
+  ClockTy::duration latency_;
+  double bytesPerNanosecond_;
+  bool running_;
+  std::vector<std::unique_ptr<LocalityState>> localities_;
+};
+
+}  // namespace impl
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_MAPPINGS_SIM_SIM_SCHEDULER_H_
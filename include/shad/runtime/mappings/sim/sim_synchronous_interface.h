@@ -0,0 +1,376 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_MAPPINGS_SIM_SIM_SYNCHRONOUS_INTERFACE_H_
+#define INCLUDE_SHAD_RUNTIME_MAPPINGS_SIM_SIM_SYNCHRONOUS_INTERFACE_H_
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#include "shad/runtime/locality.h"
+#include "shad/runtime/mappings/sim/sim_scheduler.h"
+#include "shad/runtime/mappings/sim/sim_traits_mapping.h"
+#include "shad/runtime/mappings/sim/sim_utility.h"
+#include "shad/runtime/synchronous_interface.h"
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+template <>
+struct SynchronousInterface<sim_tag> {
+  template <typename FunT, typename InArgsT>
+  static void executeAt(const Locality &loc, FunT &&function,
+                        const InArgsT &args) {
+    using FunctionTy = void (*)(const InArgsT &);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+    SimScheduler::Instance().Call(getNodeId(loc), sizeof(InArgsT),
+                                  [&]() -> size_t {
+                                    fn(args);
+                                    return 0;
+                                  });
+  }
+
+  template <typename FunT>
+  static void executeAt(const Locality &loc, FunT &&function,
+                        const std::shared_ptr<uint8_t> &argsBuffer,
+                        const uint32_t bufferSize) {
+    using FunctionTy = void (*)(const uint8_t *, const uint32_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+    SimScheduler::Instance().Call(getNodeId(loc), bufferSize,
+                                  [&]() -> size_t {
+                                    fn(argsBuffer.get(), bufferSize);
+                                    return 0;
+                                  });
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void executeAtWithRetBuff(const Locality &loc, FunT &&function,
+                                   const InArgsT &args, uint8_t *resultBuffer,
+                                   uint32_t *resultSize) {
+    using FunctionTy = void (*)(const InArgsT &, uint8_t *, uint32_t *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+    SimScheduler::Instance().Call(getNodeId(loc), sizeof(InArgsT),
+                                  [&]() -> size_t {
+                                    fn(args, resultBuffer, resultSize);
+                                    return *resultSize;
+                                  });
+  }
+
+  template <typename FunT>
+  static void executeAtWithRetBuff(const Locality &loc, FunT &&function,
+                                   const std::shared_ptr<uint8_t> &argsBuffer,
+                                   const uint32_t bufferSize,
+                                   uint8_t *resultBuffer,
+                                   uint32_t *resultSize) {
+    using FunctionTy =
+        void (*)(const uint8_t *, const uint32_t, uint8_t *, uint32_t *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+    SimScheduler::Instance().Call(
+        getNodeId(loc), bufferSize, [&]() -> size_t {
+          fn(argsBuffer.get(), bufferSize, resultBuffer, resultSize);
+          return *resultSize;
+        });
+  }
+
+  template <typename FunT, typename InArgsT, typename ResT>
+  static void executeAtWithRet(const Locality &loc, FunT &&function,
+                               const InArgsT &args, ResT *result) {
+    using FunctionTy = void (*)(const InArgsT &, ResT *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+    SimScheduler::Instance().Call(getNodeId(loc), sizeof(InArgsT),
+                                  [&]() -> size_t {
+                                    fn(args, result);
+                                    return sizeof(ResT);
+                                  });
+  }
+
+  template <typename FunT, typename ResT>
+  static void executeAtWithRet(const Locality &loc, FunT &&function,
+                               const std::shared_ptr<uint8_t> &argsBuffer,
+                               const uint32_t bufferSize, ResT *result) {
+    using FunctionTy = void (*)(const uint8_t *, const uint32_t, ResT *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+    SimScheduler::Instance().Call(getNodeId(loc), bufferSize,
+                                  [&]() -> size_t {
+                                    fn(argsBuffer.get(), bufferSize, result);
+                                    return sizeof(ResT);
+                                  });
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void executeOnAll(FunT &&function, const InArgsT &args) {
+    using FunctionTy = void (*)(const InArgsT &);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    auto &scheduler = SimScheduler::Instance();
+    auto counter = std::make_shared<SimCounter>();
+    counter->Increment(scheduler.NumLocalities());
+    for (uint32_t L = 0; L < scheduler.NumLocalities(); ++L) {
+      scheduler.Post(L, sizeof(InArgsT), [=] {
+        fn(args);
+        counter->Decrement();
+      });
+    }
+    counter->Wait();
+  }
+
+  template <typename FunT>
+  static void executeOnAll(FunT &&function,
+                           const std::shared_ptr<uint8_t> &argsBuffer,
+                           const uint32_t bufferSize) {
+    using FunctionTy = void (*)(const uint8_t *, const uint32_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    auto &scheduler = SimScheduler::Instance();
+    auto counter = std::make_shared<SimCounter>();
+    counter->Increment(scheduler.NumLocalities());
+    for (uint32_t L = 0; L < scheduler.NumLocalities(); ++L) {
+      scheduler.Post(L, bufferSize, [=] {
+        fn(argsBuffer.get(), bufferSize);
+        counter->Decrement();
+      });
+    }
+    counter->Wait();
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void forEachAt(const Locality &loc, FunT &&function,
+                        const InArgsT &args, const size_t numIters) {
+    using FunctionTy = void (*)(const InArgsT &, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+    SimScheduler::Instance().Call(
+        getNodeId(loc), sizeof(InArgsT), [&]() -> size_t {
+          SimScheduler::Instance().ParallelFor(
+              numIters, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) fn(args, i);
+              });
+          return 0;
+        });
+  }
+
+  template <typename FunT>
+  static void forEachAt(const Locality &loc, FunT &&function,
+                        const std::shared_ptr<uint8_t> &argsBuffer,
+                        const uint32_t bufferSize, const size_t numIters) {
+    using FunctionTy = void (*)(const uint8_t *, const uint32_t, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+    SimScheduler::Instance().Call(
+        getNodeId(loc), bufferSize, [&]() -> size_t {
+          SimScheduler::Instance().ParallelFor(
+              numIters, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                  fn(argsBuffer.get(), bufferSize, i);
+              });
+          return 0;
+        });
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void forEachOnAll(FunT &&function, const InArgsT &args,
+                           const size_t numIters) {
+    using FunctionTy = void (*)(const InArgsT &, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    // No need to do anything.
+    if (!numIters) return;
+
+    auto &scheduler = SimScheduler::Instance();
+    size_t numLocalities = scheduler.NumLocalities();
+    size_t block = (numIters + numLocalities - 1) / numLocalities;
+    auto counter = std::make_shared<SimCounter>();
+    for (size_t L = 0; L < numLocalities && L * block < numIters; ++L) {
+      size_t first = L * block;
+      size_t last = std::min(first + block, numIters);
+      counter->Increment();
+      scheduler.Post(L, sizeof(InArgsT), [=] {
+        SimScheduler::Instance().ParallelFor(
+            last - first, [&](size_t begin, size_t end) {
+              for (size_t i = first + begin; i < first + end; ++i) fn(args, i);
+            });
+        counter->Decrement();
+      });
+    }
+    counter->Wait();
+  }
+
+  template <typename FunT>
+  static void forEachOnAll(FunT &&function,
+                           const std::shared_ptr<uint8_t> &argsBuffer,
+                           const uint32_t bufferSize, const size_t numIters) {
+    using FunctionTy = void (*)(const uint8_t *, const uint32_t, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    // No need to do anything.
+    if (!numIters) return;
+
+    auto &scheduler = SimScheduler::Instance();
+    size_t numLocalities = scheduler.NumLocalities();
+    size_t block = (numIters + numLocalities - 1) / numLocalities;
+    auto counter = std::make_shared<SimCounter>();
+    for (size_t L = 0; L < numLocalities && L * block < numIters; ++L) {
+      size_t first = L * block;
+      size_t last = std::min(first + block, numIters);
+      counter->Increment();
+      scheduler.Post(L, bufferSize, [=] {
+        SimScheduler::Instance().ParallelFor(
+            last - first, [&](size_t begin, size_t end) {
+              for (size_t i = first + begin; i < first + end; ++i)
+                fn(argsBuffer.get(), bufferSize, i);
+            });
+        counter->Decrement();
+      });
+    }
+    counter->Wait();
+  }
+
+  template <typename T>
+  static void dma(const Locality &destLoc, const T *remoteAddress,
+                  const T *localData, const size_t numElements) {
+    checkLocality(destLoc);
+    SimScheduler::Instance().Call(
+        getNodeId(destLoc), numElements * sizeof(T), [&]() -> size_t {
+          memcpy((uint8_t *)remoteAddress, (uint8_t *)(localData),
+                 numElements * sizeof(T));
+          return 0;
+        });
+  }
+
+  template <typename T>
+  static void dma(const T *localAddress, const Locality &srcLoc,
+                  const T *remoteData, const size_t numElements) {
+    checkLocality(srcLoc);
+    SimScheduler::Instance().Call(
+        getNodeId(srcLoc), 0, [&]() -> size_t {
+          memcpy((uint8_t *)localAddress, (uint8_t *)(remoteData),
+                 numElements * sizeof(T));
+          return numElements * sizeof(T);
+        });
+  }
+
+  // The segment list travels with the request: one message per transfer.
+  template <typename T>
+  static void dmaScatter(const Locality &destLoc,
+                         const DmaSegment<T> *remoteSegments,
+                         const size_t numSegments, const T *localData) {
+    checkLocality(destLoc);
+    size_t numBytes =
+        numSegmentElements(remoteSegments, numSegments) * sizeof(T);
+    SimScheduler::Instance().Call(
+        getNodeId(destLoc), numBytes + numSegments * sizeof(DmaSegment<T>),
+        [&]() -> size_t {
+          scatterSegments(remoteSegments, numSegments, localData);
+          return 0;
+        });
+  }
+
+  template <typename T>
+  static void dmaGather(const T *localAddress, const Locality &srcLoc,
+                        const DmaSegment<T> *remoteSegments,
+                        const size_t numSegments) {
+    checkLocality(srcLoc);
+    SimScheduler::Instance().Call(
+        getNodeId(srcLoc), numSegments * sizeof(DmaSegment<T>),
+        [&]() -> size_t {
+          gatherSegments(localAddress, remoteSegments, numSegments);
+          return numSegmentElements(remoteSegments, numSegments) * sizeof(T);
+        });
+  }
+
+  template <typename T>
+  static void dmaStrided(const Locality &destLoc, const T *remoteBase,
+                         const size_t stride, const T *localData,
+                         const size_t numElements) {
+    checkLocality(destLoc);
+    SimScheduler::Instance().Call(
+        getNodeId(destLoc), numElements * sizeof(T), [&]() -> size_t {
+          scatterStrided(DmaStride<T>{remoteBase, stride, numElements},
+                         localData);
+          return 0;
+        });
+  }
+
+  template <typename T>
+  static void dmaStrided(const T *localAddress, const Locality &srcLoc,
+                         const T *remoteBase, const size_t stride,
+                         const size_t numElements) {
+    checkLocality(srcLoc);
+    SimScheduler::Instance().Call(
+        getNodeId(srcLoc), 0, [&]() -> size_t {
+          gatherStrided(localAddress,
+                        DmaStride<T>{remoteBase, stride, numElements});
+          return numElements * sizeof(T);
+        });
+  }
+
+  template <typename T>
+  static T atomic(const Locality &loc, const AtomicArgs<T> &args) {
+    checkLocality(loc);
+    T value;
+    SimScheduler::Instance().Call(
+        getNodeId(loc), sizeof(args), [&]() -> size_t {
+          value = applyAtomic(args);
+          return sizeof(T);
+        });
+    return value;
+  }
+};
+
+}  // namespace impl
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_MAPPINGS_SIM_SIM_SYNCHRONOUS_INTERFACE_H_
@@ -0,0 +1,122 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_MAPPINGS_SIM_SIM_TRAITS_MAPPING_H_
+#define INCLUDE_SHAD_RUNTIME_MAPPINGS_SIM_SIM_TRAITS_MAPPING_H_
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "shad/runtime/mapping_traits.h"
+#include "shad/runtime/mappings/sim/sim_scheduler.h"
+
+namespace shad {
+
+namespace rt {
+namespace impl {
+
+struct sim_tag {};
+
+template <>
+struct HandleTrait<sim_tag> {
+  using HandleTy = std::shared_ptr<SimCounter>;
+  using ParameterTy = std::shared_ptr<SimCounter> &;
+  using ConstParameterTy = const std::shared_ptr<SimCounter> &;
+
+  static void Init(ParameterTy H, ConstParameterTy V) { H = V; }
+
+  static HandleTy NullValue() { return nullptr; }
+
+  static bool Equal(ConstParameterTy lhs, ConstParameterTy rhs) {
+    return lhs == rhs;
+  }
+
+  static std::string toString(ConstParameterTy H) { return ""; }
+
+  static uint64_t toUnsignedInt(ConstParameterTy H) {
+    return reinterpret_cast<uint64_t>(H.get());
+  }
+
+  static HandleTy CreateNewHandle() { return std::make_shared<SimCounter>(); }
+
+  static void WaitFor(ParameterTy H) {
+    if (H == nullptr) return;
+    H->Wait();
+  }
+};
+
+template <>
+struct LockTrait<sim_tag> {
+  using LockTy = std::mutex;
+
+  static void lock(LockTy &L) {
+    if (L.try_lock()) return;
+
+    // Waiting for the lock must not starve the inbox of the locality.
+    auto &scheduler = SimScheduler::Instance();
+    scheduler.EnterBlocking();
+    L.lock();
+    scheduler.ExitBlocking();
+  }
+  static void unlock(LockTy &L) { L.unlock(); }
+};
+
+template <>
+struct RuntimeInternalsTrait<sim_tag> {
+  static void Initialize(int argc, char *argv[]) {}
+
+  static void Finalize() {}
+
+  static size_t Concurrency() {
+    return SimScheduler::Instance().WorkersPerLocality();
+  }
+
+  static void Yield() { std::this_thread::yield(); }
+
+  static uint32_t ThisLocality() { return SimScheduler::ThisLocality(); }
+  static uint32_t NullLocality() { return -1; }
+  static uint32_t NumLocalities() {
+    return SimScheduler::Instance().NumLocalities();
+  }
+
+  static uint32_t NumProcessLocalities() { return NumLocalities(); }
+  static uint32_t ProcessLocalityIndex() { return ThisLocality(); }
+
+  static size_t QueueDepth(Priority p) {
+    return SimScheduler::Instance().QueueDepth(ThisLocality(), p);
+  }
+};
+
+}  // namespace impl
+
+using TargetSystemTag = impl::sim_tag;
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_MAPPINGS_SIM_SIM_TRAITS_MAPPING_H_
@@ -28,6 +28,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <type_traits>
 #include <utility>
 
 #include "shad/runtime/asynchronous_interface.h"
@@ -35,6 +36,7 @@
 #include "shad/runtime/locality.h"
 #include "shad/runtime/mapping_traits.h"
 #include "shad/runtime/mappings/tbb/tbb_utility.h"
+#include "shad/runtime/task_arena.h"
 
 namespace shad {
 namespace rt {
@@ -43,6 +45,21 @@ namespace impl {
 
 template <>
 struct AsynchronousInterface<tbb_tag> {
+ private:
+  // Tasks receive their own copy of the Handle, as the one of the caller may
+  // not outlive them.  The closure lives in the TaskArena, and is recycled
+  // as soon as the task completes.
+  template <typename TaskT>
+  static void runTask(Handle &handle, TaskT &&task) {
+    auto state = handle.id_;
+    TbbPriorityArenas::Run(
+        state, makeArenaTask([state, task = std::forward<TaskT>(task)] {
+          Handle H(state);
+          task(H);
+        }));
+  }
+
+ public:
   template <typename FunT, typename InArgsT>
   static void asyncExecuteAt(Handle &handle, const Locality &loc,
                              FunT &&function, const InArgsT &args) {
@@ -55,7 +72,24 @@ struct AsynchronousInterface<tbb_tag> {
     handle.id_ =
         handle.IsNull() ? HandleTrait<tbb_tag>::CreateNewHandle() : handle.id_;
 
-    handle.id_->run([=, &handle] { fn(handle, args); });
+    runTask(handle, [=](Handle &H) { fn(H, args); });
+  }
+
+  template <typename FunT, typename InArgsT,
+            typename = typename std::enable_if<
+                !std::is_reference<InArgsT>::value>::type>
+  static void asyncExecuteAt(Handle &handle, const Locality &loc,
+                             FunT &&function, InArgsT &&args) {
+    using FunctionTy = void (*)(Handle &, const InArgsT &);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<tbb_tag>::CreateNewHandle() : handle.id_;
+
+    runTask(handle, [fn, args = std::move(args)](Handle &H) { fn(H, args); });
   }
 
   template <typename FunT>
@@ -72,7 +106,7 @@ struct AsynchronousInterface<tbb_tag> {
     handle.id_ =
         handle.IsNull() ? HandleTrait<tbb_tag>::CreateNewHandle() : handle.id_;
 
-    handle.id_->run([=, &handle] { fn(handle, argsBuffer.get(), bufferSize); });
+    runTask(handle, [=](Handle &H) { fn(H, argsBuffer.get(), bufferSize); });
   }
 
   template <typename FunT, typename InArgsT>
@@ -90,8 +124,7 @@ struct AsynchronousInterface<tbb_tag> {
     handle.id_ =
         handle.IsNull() ? HandleTrait<tbb_tag>::CreateNewHandle() : handle.id_;
 
-    handle.id_->run(
-        [=, &handle] { fn(handle, args, resultBuffer, resultSize); });
+    runTask(handle, [=](Handle &H) { fn(H, args, resultBuffer, resultSize); });
   }
 
   template <typename FunT>
@@ -109,8 +142,8 @@ struct AsynchronousInterface<tbb_tag> {
     handle.id_ =
         handle.IsNull() ? HandleTrait<tbb_tag>::CreateNewHandle() : handle.id_;
 
-    handle.id_->run([=, &handle] {
-      fn(handle, argsBuffer.get(), bufferSize, resultBuffer, resultSize);
+    runTask(handle, [=](Handle &H) {
+      fn(H, argsBuffer.get(), bufferSize, resultBuffer, resultSize);
     });
   }
 
@@ -127,7 +160,7 @@ struct AsynchronousInterface<tbb_tag> {
     handle.id_ =
         handle.IsNull() ? HandleTrait<tbb_tag>::CreateNewHandle() : handle.id_;
 
-    handle.id_->run([=, &handle] { fn(handle, args, result); });
+    runTask(handle, [=](Handle &H) { fn(H, args, result); });
   }
 
   template <typename FunT, typename ResT>
@@ -145,8 +178,8 @@ struct AsynchronousInterface<tbb_tag> {
     handle.id_ =
         handle.IsNull() ? HandleTrait<tbb_tag>::CreateNewHandle() : handle.id_;
 
-    handle.id_->run([&, fn, argsBuffer, bufferSize, result] {
-      fn(handle, argsBuffer.get(), bufferSize, result);
+    runTask(handle, [=](Handle &H) {
+      fn(H, argsBuffer.get(), bufferSize, result);
     });
   }
 
@@ -160,7 +193,7 @@ struct AsynchronousInterface<tbb_tag> {
     handle.id_ =
         handle.IsNull() ? HandleTrait<tbb_tag>::CreateNewHandle() : handle.id_;
 
-    handle.id_->run([=, &handle] { fn(handle, args); });
+    runTask(handle, [=](Handle &H) { fn(H, args); });
   }
 
   template <typename FunT>
@@ -174,7 +207,7 @@ struct AsynchronousInterface<tbb_tag> {
     handle.id_ =
         handle.IsNull() ? HandleTrait<tbb_tag>::CreateNewHandle() : handle.id_;
 
-    handle.id_->run([=, &handle] { fn(handle, argsBuffer.get(), bufferSize); });
+    runTask(handle, [=](Handle &H) { fn(H, argsBuffer.get(), bufferSize); });
   }
 
   template <typename FunT, typename InArgsT>
@@ -190,11 +223,13 @@ struct AsynchronousInterface<tbb_tag> {
     handle.id_ =
         handle.IsNull() ? HandleTrait<tbb_tag>::CreateNewHandle() : handle.id_;
 
-    handle.id_->run([=, &handle] {
+    auto state = handle.id_;
+    TbbPriorityArenas::Run(state, [=] {
       tbb::parallel_for(tbb::blocked_range<size_t>(0, numIters),
-                        [=, &handle](const tbb::blocked_range<size_t> &range) {
+                        [=](const tbb::blocked_range<size_t> &range) {
+                          Handle H(state);
                           for (auto i = range.begin(); i < range.end(); ++i)
-                            fn(handle, args, i);
+                            fn(H, args, i);
                         });
     });
   }
@@ -214,11 +249,13 @@ struct AsynchronousInterface<tbb_tag> {
     handle.id_ =
         handle.IsNull() ? HandleTrait<tbb_tag>::CreateNewHandle() : handle.id_;
 
-    handle.id_->run([=, &handle] {
+    auto state = handle.id_;
+    TbbPriorityArenas::Run(state, [=] {
       tbb::parallel_for(tbb::blocked_range<size_t>(0, numIters),
-                        [=, &handle](const tbb::blocked_range<size_t> &range) {
+                        [=](const tbb::blocked_range<size_t> &range) {
+                          Handle H(state);
                           for (auto i = range.begin(); i < range.end(); ++i)
-                            fn(handle, argsBuffer.get(), bufferSize, i);
+                            fn(H, argsBuffer.get(), bufferSize, i);
                         });
     });
   }
@@ -233,11 +270,13 @@ struct AsynchronousInterface<tbb_tag> {
     handle.id_ =
         handle.IsNull() ? HandleTrait<tbb_tag>::CreateNewHandle() : handle.id_;
 
-    handle.id_->run([=, &handle] {
+    auto state = handle.id_;
+    TbbPriorityArenas::Run(state, [=] {
       tbb::parallel_for(tbb::blocked_range<size_t>(0, numIters),
-                        [&](const tbb::blocked_range<size_t> &range) {
+                        [=](const tbb::blocked_range<size_t> &range) {
+                          Handle H(state);
                           for (auto i = range.begin(); i < range.end(); ++i)
-                            fn(handle, args, i);
+                            fn(H, args, i);
                         });
     });
   }
@@ -255,14 +294,23 @@ struct AsynchronousInterface<tbb_tag> {
     handle.id_ =
         handle.IsNull() ? HandleTrait<tbb_tag>::CreateNewHandle() : handle.id_;
 
-    handle.id_->run([=, &handle] {
+    auto state = handle.id_;
+    TbbPriorityArenas::Run(state, [=] {
       tbb::parallel_for(tbb::blocked_range<size_t>(0, numIters),
-                        [=, &handle](const tbb::blocked_range<size_t> &range) {
+                        [=](const tbb::blocked_range<size_t> &range) {
+                          Handle H(state);
                           for (auto i = range.begin(); i < range.end(); ++i)
-                            fn(handle, argsBuffer.get(), bufferSize, i);
+                            fn(H, argsBuffer.get(), bufferSize, i);
                         });
     });
   }
+
+  template <typename T>
+  static void asyncAtomic(Handle &, const Locality &,
+                          const AtomicArgs<T> &args, T *result) {
+    T value = applyAtomic(args);
+    if (result != nullptr) *result = value;
+  }
 };
 
 }  // namespace impl
@@ -25,16 +25,21 @@
 #ifndef INCLUDE_SHAD_RUNTIME_MAPPINGS_TBB_TBB_TRAITS_MAPPING_H_
 #define INCLUDE_SHAD_RUNTIME_MAPPINGS_TBB_TBB_TRAITS_MAPPING_H_
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <limits>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "tbb/task_group.h"
 #include "tbb/tbb.h"
 
 #include "shad/runtime/mapping_traits.h"
+#include "shad/runtime/topology.h"
+#include "shad/runtime/tracing.h"
 
 namespace shad {
 
@@ -43,35 +48,250 @@ namespace impl {
 
 struct tbb_tag {};
 
+/// @brief State of a TBB Handle.
+///
+/// States are recycled through TbbHandlePool, so creating a Handle does not
+/// allocate in steady state.  Handles hold a reference to their state (see
+/// TbbHandleRef): a state returns to the pool only once no Handle, and hence
+/// no task, refers to it anymore.
+///
+/// Tasks are attached to the group of their scheduling class.
+struct TbbHandleState {
+  TbbHandleState() : total(0), refs(0) {
+    for (auto &counter : pending) counter = 0;
+  }
+
+  tbb::task_group groups[kNumPriorities];
+  /// Tasks of each class that have not completed yet.
+  std::atomic<size_t> pending[kNumPriorities];
+  /// Tasks of any class that have not completed yet.
+  std::atomic<size_t> total;
+  /// Handles referring to this state.
+  std::atomic<size_t> refs;
+};
+
+/// @brief Scheduling classes of the TBB mapping.
+///
+/// Normal tasks are spawned in the arena of the calling thread.  Latency and
+/// bulk tasks are enqueued in two arenas of high and low priority: TBB
+/// assigns its workers to the arenas in priority order.
+class TbbPriorityArenas {
+ public:
+  /// @brief Spawn body in the group of state matching the priority of the
+  /// calling thread.
+  template <typename FunT>
+  static void Run(TbbHandleState *state, FunT &&body) {
+    auto p = static_cast<size_t>(CurrentPriority());
+    auto &instance = Instance();
+    state->total.fetch_add(1);
+    state->pending[p].fetch_add(1);
+    instance.depth_[p].fetch_add(1);
+
+    auto task = [state, p,
+                 body = TraceTask(0, std::forward<FunT>(body))] {
+      Instance().depth_[p].fetch_sub(1);
+      {
+        PriorityScope scope(static_cast<Priority>(p));
+        body();
+      }
+      state->pending[p].fetch_sub(1);
+      state->total.fetch_sub(1);
+    };
+
+    auto &group = state->groups[p];
+    if (p == static_cast<size_t>(Priority::kNormal))
+      group.run(std::move(task));
+    else
+      instance.Arena(p).enqueue(group.defer(std::move(task)));
+  }
+
+  /// @brief Wait for all the tasks attached to state.
+  ///
+  /// The calling thread waits for each group from within its arena, so that
+  /// it can execute the tasks it is waiting for.  Tasks of a class can spawn
+  /// tasks of another one, hence the loop.
+  static void Wait(TbbHandleState *state) {
+    auto &instance = Instance();
+    while (state->total.load() != 0) {
+      for (size_t p = 0; p < kNumPriorities; ++p) {
+        if (state->pending[p].load() == 0) continue;
+        auto &group = state->groups[p];
+        if (p == static_cast<size_t>(Priority::kNormal))
+          group.wait();
+        else
+          instance.Arena(p).execute([&group] { group.wait(); });
+      }
+    }
+  }
+
+  /// @brief Number of tasks of class p waiting to start.
+  static size_t Depth(Priority p) {
+    return Instance().depth_[static_cast<size_t>(p)].load();
+  }
+
+ private:
+  TbbPriorityArenas()
+      : latency_(tbb::task_arena::automatic, 1,
+                 tbb::task_arena::priority::high),
+        bulk_(tbb::task_arena::automatic, 1, tbb::task_arena::priority::low) {
+    for (auto &depth : depth_) depth = 0;
+  }
+
+  static TbbPriorityArenas &Instance() {
+    static TbbPriorityArenas *instance = new TbbPriorityArenas();
+    return *instance;
+  }
+
+  tbb::task_arena &Arena(size_t p) {
+    return p == static_cast<size_t>(Priority::kLatency) ? latency_ : bulk_;
+  }
+
+  tbb::task_arena latency_;
+  tbb::task_arena bulk_;
+  std::atomic<size_t> depth_[kNumPriorities];
+};
+
+/// @brief Pool of TbbHandleState.
+///
+/// Each thread keeps a small cache of states in front of a shared list.
+/// States are never freed.
+class TbbHandlePool {
+ public:
+  static TbbHandleState *Acquire() {
+    auto &cache = LocalCache();
+    if (cache.states.empty()) {
+      auto &shared = Shared();
+      std::lock_guard<std::mutex> _(shared.lock);
+      size_t n = std::min(shared.states.size(), kCacheSize / 2);
+      cache.states.assign(shared.states.end() - n, shared.states.end());
+      shared.states.resize(shared.states.size() - n);
+    }
+    if (cache.states.empty()) return new TbbHandleState();
+
+    TbbHandleState *state = cache.states.back();
+    cache.states.pop_back();
+    return state;
+  }
+
+  static void Release(TbbHandleState *state) {
+    auto &cache = LocalCache();
+    cache.states.push_back(state);
+    if (cache.states.size() > kCacheSize) cache.Flush(kCacheSize / 2);
+  }
+
+ private:
+  static constexpr size_t kCacheSize = 64;
+
+  struct SharedList {
+    std::mutex lock;
+    std::vector<TbbHandleState *> states;
+  };
+
+  struct Cache {
+    ~Cache() { Flush(states.size()); }
+
+    void Flush(size_t n) {
+      auto &shared = Shared();
+      std::lock_guard<std::mutex> _(shared.lock);
+      shared.states.insert(shared.states.end(), states.end() - n,
+                           states.end());
+      states.resize(states.size() - n);
+    }
+
+    std::vector<TbbHandleState *> states;
+  };
+
+  static SharedList &Shared() {
+    static SharedList *shared = new SharedList();
+    return *shared;
+  }
+
+  static Cache &LocalCache() {
+    static thread_local Cache cache;
+    return cache;
+  }
+};
+
+/// @brief Counted reference to a TbbHandleState.
+///
+/// Every copy of a Handle, including the ones captured by its tasks, holds a
+/// reference, so that the state is recycled only after the last copy is
+/// gone.  A reference is an intrusive counter on a pooled state: copying a
+/// Handle costs one atomic increment and no allocation.
+class TbbHandleRef {
+ public:
+  TbbHandleRef() : state_(nullptr) {}
+  explicit TbbHandleRef(TbbHandleState *state) : state_(state) { Retain(); }
+  TbbHandleRef(const TbbHandleRef &rhs) : state_(rhs.state_) { Retain(); }
+  TbbHandleRef(TbbHandleRef &&rhs) : state_(rhs.state_) {
+    rhs.state_ = nullptr;
+  }
+  ~TbbHandleRef() { Drop(); }
+
+  TbbHandleRef &operator=(const TbbHandleRef &rhs) {
+    TbbHandleRef tmp(rhs);
+    std::swap(state_, tmp.state_);
+    return *this;
+  }
+  TbbHandleRef &operator=(TbbHandleRef &&rhs) {
+    std::swap(state_, rhs.state_);
+    return *this;
+  }
+
+  TbbHandleState *get() const { return state_; }
+  TbbHandleState *operator->() const { return state_; }
+  operator TbbHandleState *() const { return state_; }
+
+  friend bool operator==(const TbbHandleRef &lhs, const TbbHandleRef &rhs) {
+    return lhs.state_ == rhs.state_;
+  }
+
+ private:
+  void Retain() {
+    if (state_ != nullptr) state_->refs.fetch_add(1);
+  }
+  void Drop() {
+    if (state_ != nullptr && state_->refs.fetch_sub(1) == 1)
+      TbbHandlePool::Release(state_);
+    state_ = nullptr;
+  }
+
+  TbbHandleState *state_;
+};
+
 template <>
 struct HandleTrait<tbb_tag> {
-  using HandleTy = std::shared_ptr<tbb::task_group>;
-  using ParameterTy = std::shared_ptr<tbb::task_group> &;
-  using ConstParameterTy = const std::shared_ptr<tbb::task_group> &;
+  using HandleTy = TbbHandleRef;
+  using ParameterTy = TbbHandleRef &;
+  using ConstParameterTy = const TbbHandleRef &;
 
-  static void Init(ParameterTy H, ConstParameterTy V) {}
+  static void Init(ParameterTy H, HandleTy V) { H = std::move(V); }
 
-  static HandleTy NullValue() {
-    return std::shared_ptr<tbb::task_group>(nullptr);
-  }
+  static HandleTy NullValue() { return TbbHandleRef(); }
 
   static bool Equal(ConstParameterTy lhs, ConstParameterTy rhs) {
     return lhs == rhs;
   }
 
-  static std::string toString(ConstParameterTy H) { return ""; }
+  static std::string toString(ConstParameterTy H) {
+    return std::to_string(toUnsignedInt(H));
+  }
 
   static uint64_t toUnsignedInt(ConstParameterTy H) {
     return reinterpret_cast<uint64_t>(H.get());
   }
 
   static HandleTy CreateNewHandle() {
-    return std::shared_ptr<tbb::task_group>(new tbb::task_group());
+    return TbbHandleRef(TbbHandlePool::Acquire());
   }
 
+  // Other copies of H keep the state alive: waiting on them after this call
+  // returns immediately, as all the tasks of the state have completed.
   static void WaitFor(ParameterTy H) {
-    if (H == nullptr) return;
-    H->wait();
+    if (H == NullValue()) return;
+    // The calling thread executes pending tasks while waiting.
+    TbbPriorityArenas::Wait(H.get());
+    H = NullValue();
   }
 };
 
@@ -90,7 +310,7 @@ struct RuntimeInternalsTrait<tbb_tag> {
   static void Finalize() {}
 
   static size_t Concurrency() {
-    return std::thread::hardware_concurrency();
+    return CpuTopology::Instance().WorkerCpus().size();
   }
 
   static void Yield() {
@@ -100,6 +320,11 @@ struct RuntimeInternalsTrait<tbb_tag> {
   static uint32_t ThisLocality() { return 0; }
   static uint32_t NullLocality() { return -1; }
   static uint32_t NumLocalities() { return 1; }
+
+  static uint32_t NumProcessLocalities() { return 1; }
+  static uint32_t ProcessLocalityIndex() { return 0; }
+
+  static size_t QueueDepth(Priority p) { return TbbPriorityArenas::Depth(p); }
 };
 
 }  // namespace impl
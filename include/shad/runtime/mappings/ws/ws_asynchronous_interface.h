@@ -0,0 +1,316 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_MAPPINGS_WS_WS_ASYNCHRONOUS_INTERFACE_H_
+#define INCLUDE_SHAD_RUNTIME_MAPPINGS_WS_WS_ASYNCHRONOUS_INTERFACE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "shad/runtime/asynchronous_interface.h"
+#include "shad/runtime/handle.h"
+#include "shad/runtime/locality.h"
+#include "shad/runtime/mapping_traits.h"
+#include "shad/runtime/mappings/ws/ws_scheduler.h"
+#include "shad/runtime/mappings/ws/ws_utility.h"
+#include "shad/runtime/task_arena.h"
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+template <>
+struct AsynchronousInterface<ws_tag> {
+ private:
+  // Tasks receive their own copy of the Handle, as the one of the caller may
+  // not outlive them.  The closure lives in the TaskArena, and is recycled
+  // as soon as the task completes.
+  template <typename TaskT>
+  static void spawnTask(Handle &handle, TaskT &&task) {
+    auto counter = handle.id_;
+    counter->Increment();
+    WsScheduler::Instance().Spawn(
+        makeArenaTask([counter, task = std::forward<TaskT>(task)] {
+          Handle H(counter);
+          task(H);
+          counter->Decrement();
+        }));
+  }
+
+ public:
+  template <typename FunT, typename InArgsT>
+  static void asyncExecuteAt(Handle &handle, const Locality &loc,
+                             FunT &&function, const InArgsT &args) {
+    using FunctionTy = void (*)(Handle &, const InArgsT &);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<ws_tag>::CreateNewHandle() : handle.id_;
+
+    spawnTask(handle, [=](Handle &H) { fn(H, args); });
+  }
+
+  template <typename FunT, typename InArgsT,
+            typename = typename std::enable_if<
+                !std::is_reference<InArgsT>::value>::type>
+  static void asyncExecuteAt(Handle &handle, const Locality &loc,
+                             FunT &&function, InArgsT &&args) {
+    using FunctionTy = void (*)(Handle &, const InArgsT &);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<ws_tag>::CreateNewHandle() : handle.id_;
+
+    spawnTask(handle,
+              [fn, args = std::move(args)](Handle &H) { fn(H, args); });
+  }
+
+  template <typename FunT>
+  static void asyncExecuteAt(Handle &handle, const Locality &loc,
+                             FunT &&function,
+                             const std::shared_ptr<uint8_t> &argsBuffer,
+                             const uint32_t bufferSize) {
+    using FunctionTy = void (*)(Handle &, const uint8_t *, const uint32_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<ws_tag>::CreateNewHandle() : handle.id_;
+
+    spawnTask(handle, [=](Handle &H) { fn(H, argsBuffer.get(), bufferSize); });
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void asyncExecuteAtWithRetBuff(Handle &handle, const Locality &loc,
+                                        FunT &&function, const InArgsT &args,
+                                        uint8_t *resultBuffer,
+                                        uint32_t *resultSize) {
+    using FunctionTy =
+        void (*)(Handle &, const InArgsT &, uint8_t *, uint32_t *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<ws_tag>::CreateNewHandle() : handle.id_;
+
+    spawnTask(handle,
+              [=](Handle &H) { fn(H, args, resultBuffer, resultSize); });
+  }
+
+  template <typename FunT>
+  static void asyncExecuteAtWithRetBuff(
+      Handle &handle, const Locality &loc, FunT &&function,
+      const std::shared_ptr<uint8_t> &argsBuffer, const uint32_t bufferSize,
+      uint8_t *resultBuffer, uint32_t *resultSize) {
+    using FunctionTy = void (*)(Handle &, const uint8_t *, const uint32_t,
+                                uint8_t *, uint32_t *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<ws_tag>::CreateNewHandle() : handle.id_;
+
+    spawnTask(handle, [=](Handle &H) {
+      fn(H, argsBuffer.get(), bufferSize, resultBuffer, resultSize);
+    });
+  }
+
+  template <typename FunT, typename InArgsT, typename ResT>
+  static void asyncExecuteAtWithRet(Handle &handle, const Locality &loc,
+                                    FunT &&function, const InArgsT &args,
+                                    ResT *result) {
+    using FunctionTy = void (*)(Handle &, const InArgsT &, ResT *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<ws_tag>::CreateNewHandle() : handle.id_;
+
+    spawnTask(handle, [=](Handle &H) { fn(H, args, result); });
+  }
+
+  template <typename FunT, typename ResT>
+  static void asyncExecuteAtWithRet(Handle &handle, const Locality &loc,
+                                    FunT &&function,
+                                    const std::shared_ptr<uint8_t> &argsBuffer,
+                                    const uint32_t bufferSize, ResT *result) {
+    using FunctionTy =
+        void (*)(Handle &, const uint8_t *, const uint32_t, ResT *);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<ws_tag>::CreateNewHandle() : handle.id_;
+
+    spawnTask(handle, [=](Handle &H) {
+      fn(H, argsBuffer.get(), bufferSize, result);
+    });
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void asyncExecuteOnAll(Handle &handle, FunT &&function,
+                                const InArgsT &args) {
+    using FunctionTy = void (*)(Handle &, const InArgsT &);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<ws_tag>::CreateNewHandle() : handle.id_;
+
+    spawnTask(handle, [=](Handle &H) { fn(H, args); });
+  }
+
+  template <typename FunT>
+  static void asyncExecuteOnAll(Handle &handle, FunT &&function,
+                                const std::shared_ptr<uint8_t> &argsBuffer,
+                                const uint32_t bufferSize) {
+    using FunctionTy = void (*)(Handle &, const uint8_t *, const uint32_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<ws_tag>::CreateNewHandle() : handle.id_;
+
+    spawnTask(handle, [=](Handle &H) { fn(H, argsBuffer.get(), bufferSize); });
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void asyncForEachAt(Handle &handle, const Locality &loc,
+                             FunT &&function, const InArgsT &args,
+                             const size_t numIters) {
+    using FunctionTy = void (*)(Handle &, const InArgsT &, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<ws_tag>::CreateNewHandle() : handle.id_;
+
+    auto counter = handle.id_;
+    WsScheduler::Instance().AsyncParallelFor(
+        counter, numIters, [=](size_t begin, size_t end) {
+          Handle H(counter);
+          for (size_t i = begin; i < end; ++i) fn(H, args, i);
+        });
+  }
+
+  template <typename FunT>
+  static void asyncForEachAt(Handle &handle, const Locality &loc,
+                             FunT &&function,
+                             const std::shared_ptr<uint8_t> &argsBuffer,
+                             const uint32_t bufferSize, const size_t numIters) {
+    using FunctionTy =
+        void (*)(Handle &, const uint8_t *, const uint32_t, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    checkLocality(loc);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<ws_tag>::CreateNewHandle() : handle.id_;
+
+    auto counter = handle.id_;
+    WsScheduler::Instance().AsyncParallelFor(
+        counter, numIters, [=](size_t begin, size_t end) {
+          Handle H(counter);
+          for (size_t i = begin; i < end; ++i)
+            fn(H, argsBuffer.get(), bufferSize, i);
+        });
+  }
+
+  template <typename FunT, typename InArgsT>
+  static void asyncForEachOnAll(Handle &handle, FunT &&function,
+                                const InArgsT &args, const size_t numIters) {
+    using FunctionTy = void (*)(Handle &, const InArgsT &, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<ws_tag>::CreateNewHandle() : handle.id_;
+
+    auto counter = handle.id_;
+    WsScheduler::Instance().AsyncParallelFor(
+        counter, numIters, [=](size_t begin, size_t end) {
+          Handle H(counter);
+          for (size_t i = begin; i < end; ++i) fn(H, args, i);
+        });
+  }
+
+  template <typename FunT>
+  static void asyncForEachOnAll(Handle &handle, FunT &&function,
+                                const std::shared_ptr<uint8_t> &argsBuffer,
+                                const uint32_t bufferSize,
+                                const size_t numIters) {
+    using FunctionTy =
+        void (*)(Handle &, const uint8_t *, const uint32_t, size_t);
+
+    FunctionTy fn = std::forward<decltype(function)>(function);
+
+    handle.id_ =
+        handle.IsNull() ? HandleTrait<ws_tag>::CreateNewHandle() : handle.id_;
+
+    auto counter = handle.id_;
+    WsScheduler::Instance().AsyncParallelFor(
+        counter, numIters, [=](size_t begin, size_t end) {
+          Handle H(counter);
+          for (size_t i = begin; i < end; ++i)
+            fn(H, argsBuffer.get(), bufferSize, i);
+        });
+  }
+
+  template <typename T>
+  static void asyncAtomic(Handle &, const Locality &,
+                          const AtomicArgs<T> &args, T *result) {
+    T value = applyAtomic(args);
+    if (result != nullptr) *result = value;
+  }
+};
+
+}  // namespace impl
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_MAPPINGS_WS_WS_ASYNCHRONOUS_INTERFACE_H_
@@ -0,0 +1,272 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_MAPPINGS_WS_WS_SCHEDULER_H_
+#define INCLUDE_SHAD_RUNTIME_MAPPINGS_WS_WS_SCHEDULER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "shad/runtime/priority.h"
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+/// @brief Chase-Lev work-stealing deque.
+///
+/// The owner pushes and pops at the bottom, thieves steal from the top.  The
+/// circular array grows when full; retired arrays are kept until the deque is
+/// destroyed, as thieves may still be reading them.
+///
+/// @tparam T The (pointer) type of the elements.
+template <typename T>
+class WsDeque {
+ public:
+  explicit WsDeque(int64_t capacity = 256)
+      : top_(0), bottom_(0), array_(new Array(capacity)) {
+    arrays_.emplace_back(array_.load());
+  }
+
+  WsDeque(const WsDeque &) = delete;
+  WsDeque &operator=(const WsDeque &) = delete;
+
+  /// @brief Push an element (owner only).
+  void Push(T element) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    Array *array = array_.load(std::memory_order_relaxed);
+    if (b - t > array->capacity - 1) {
+      array = array->Grow(b, t);
+      arrays_.emplace_back(array);
+      array_.store(array, std::memory_order_release);
+    }
+    array->Put(b, element);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+
+  /// @brief Pop the most recently pushed element (owner only).
+  /// @return The element, or nullptr if the deque is empty.
+  T Pop() {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Array *array = array_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+
+    T element = nullptr;
+    if (t <= b) {
+      element = array->Get(b);
+      if (t == b) {
+        // Last element: race against the thieves.
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed))
+          element = nullptr;
+        bottom_.store(b + 1, std::memory_order_relaxed);
+      }
+    } else {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return element;
+  }
+
+  /// @brief Steal the least recently pushed element (any thread).
+  /// @return The element, or nullptr if the deque is empty or the steal
+  /// lost a race.
+  T Steal() {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+
+    if (t >= b) return nullptr;
+
+    Array *array = array_.load(std::memory_order_acquire);
+    T element = array->Get(t);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed))
+      return nullptr;
+    return element;
+  }
+
+  /// @brief Check if the deque looks empty.
+  bool Empty() const {
+    return bottom_.load(std::memory_order_relaxed) <=
+           top_.load(std::memory_order_relaxed);
+  }
+
+  /// @brief Approximate number of elements in the deque.
+  size_t Size() const {
+    int64_t size = bottom_.load(std::memory_order_relaxed) -
+                   top_.load(std::memory_order_relaxed);
+    return size > 0 ? size : 0;
+  }
+
+ private:
+  struct Array {
+    explicit Array(int64_t capacity)
+        : capacity(capacity), buffer(new std::atomic<T>[capacity]) {}
+
+    T Get(int64_t i) const {
+      return buffer[i & (capacity - 1)].load(std::memory_order_relaxed);
+    }
+
+    void Put(int64_t i, T element) {
+      buffer[i & (capacity - 1)].store(element, std::memory_order_relaxed);
+    }
+
+    Array *Grow(int64_t bottom, int64_t top) const {
+      Array *array = new Array(capacity * 2);
+      for (int64_t i = top; i < bottom; ++i) array->Put(i, Get(i));
+      return array;
+    }
+
+    int64_t capacity;
+    std::unique_ptr<std::atomic<T>[]> buffer;
+  };
+
+  alignas(64) std::atomic<int64_t> top_;
+  alignas(64) std::atomic<int64_t> bottom_;
+  std::atomic<Array *> array_;
+  std::vector<std::unique_ptr<Array>> arrays_;
+};
+
+/// @brief Completion counter of the WS mapping.
+class WsCounter {
+ public:
+  WsCounter() : count_(0) {}
+
+  /// @brief Register n new outstanding tasks.
+  void Increment(size_t n = 1) { count_.fetch_add(n); }
+
+  /// @brief Signal the completion of an outstanding task.
+  void Decrement() {
+    if (count_.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> _(mutex_);
+      cv_.notify_all();
+    }
+  }
+
+  /// @brief Wait until all the outstanding tasks have completed.
+  ///
+  /// The waiting thread executes queued tasks while the counter is not
+  /// zero, and blocks only when there is nothing left to run.
+  void Wait();
+
+ private:
+  friend class WsScheduler;
+
+  std::atomic<size_t> count_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+/// @brief Work-stealing scheduler of the WS mapping.
+///
+/// Every worker owns a WsDeque: tasks spawned by a worker are pushed on its
+/// deque, while tasks spawned by other threads go to a shared queue.  Idle
+/// workers steal from random victims, and sleep after a while without work.
+///
+/// Deques and shared queues are replicated for each scheduling class: tasks
+/// are queued with the priority of the thread spawning them, and a thread
+/// looking for work exhausts a class (its own deque, the shared queue, and
+/// the deques of the victims) before moving to the next one.
+///
+/// The number of workers is read from the SHAD_WS_WORKERS environment
+/// variable (default: hardware concurrency).
+class WsScheduler {
+ public:
+  using TaskTy = std::function<void()>;
+  using RangeTaskTy = std::function<void(size_t, size_t)>;
+
+  /// @brief Get the singleton instance of the scheduler.
+  static WsScheduler &Instance();
+
+  /// @brief Start the workers.
+  void Start();
+  /// @brief Stop the workers, once every pending task has run.
+  void Stop();
+
+  size_t NumWorkers() const { return numWorkers_; }
+
+  /// @brief Schedule a task with the priority of the calling thread.
+  void Spawn(TaskTy &&task);
+
+  /// @brief Approximate number of tasks of class p waiting to be executed.
+  size_t QueueDepth(Priority p) const;
+
+  /// @brief Execute one queued task, if any, on the calling thread.
+  /// @return true if a task has been executed.
+  bool RunOne();
+
+  /// @brief Execute [0, numIters) splitting the range recursively among the
+  /// workers, and attach the pieces to counter.
+  void AsyncParallelFor(const std::shared_ptr<WsCounter> &counter,
+                        size_t numIters, RangeTaskTy &&task);
+  /// @brief Execute [0, numIters) splitting the range recursively among the
+  /// workers.  The calling thread takes part in the execution.
+  void ParallelFor(size_t numIters, RangeTaskTy &&task);
+
+ private:
+  WsScheduler();
+  ~WsScheduler();
+
+  void WorkerLoop(size_t id);
+  TaskTy *FindTask(Priority *priority);
+  bool HasWork();
+  void WakeUp();
+  size_t GrainSize(size_t numIters) const;
+  void SplitRange(const std::shared_ptr<WsCounter> &counter,
+                  const std::shared_ptr<RangeTaskTy> &task, size_t begin,
+                  size_t end, size_t grain);
+
+  size_t numWorkers_;
+  std::vector<std::unique_ptr<WsDeque<TaskTy *>>> deques_[kNumPriorities];
+  std::vector<std::thread> workers_;
+
+  std::mutex injectionLock_;
+  std::deque<TaskTy *> injection_[kNumPriorities];
+  std::atomic<size_t> injectionSize_[kNumPriorities];
+
+  std::mutex sleepLock_;
+  std::condition_variable sleepCv_;
+  std::atomic<size_t> numSleeping_;
+  std::atomic<bool> stop_;
+};
+
+}  // namespace impl
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_MAPPINGS_WS_WS_SCHEDULER_H_
@@ -0,0 +1,113 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_MAPPINGS_WS_WS_TRAITS_MAPPING_H_
+#define INCLUDE_SHAD_RUNTIME_MAPPINGS_WS_WS_TRAITS_MAPPING_H_
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "shad/runtime/mapping_traits.h"
+#include "shad/runtime/mappings/ws/ws_scheduler.h"
+
+namespace shad {
+
+namespace rt {
+namespace impl {
+
+struct ws_tag {};
+
+template <>
+struct HandleTrait<ws_tag> {
+  using HandleTy = std::shared_ptr<WsCounter>;
+  using ParameterTy = std::shared_ptr<WsCounter> &;
+  using ConstParameterTy = const std::shared_ptr<WsCounter> &;
+
+  static void Init(ParameterTy H, ConstParameterTy V) { H = V; }
+
+  static HandleTy NullValue() { return std::shared_ptr<WsCounter>(nullptr); }
+
+  static bool Equal(ConstParameterTy lhs, ConstParameterTy rhs) {
+    return lhs == rhs;
+  }
+
+  static std::string toString(ConstParameterTy H) { return ""; }
+
+  static uint64_t toUnsignedInt(ConstParameterTy H) {
+    return reinterpret_cast<uint64_t>(H.get());
+  }
+
+  static HandleTy CreateNewHandle() {
+    return std::make_shared<WsCounter>();
+  }
+
+  static void WaitFor(ParameterTy H) {
+    if (H == nullptr) return;
+    H->Wait();
+  }
+};
+
+template <>
+struct LockTrait<ws_tag> {
+  using LockTy = std::mutex;
+
+  static void lock(LockTy &L) { L.lock(); }
+  static void unlock(LockTy &L) { L.unlock(); }
+};
+
+template <>
+struct RuntimeInternalsTrait<ws_tag> {
+  static void Initialize(int argc, char *argv[]) {}
+
+  static void Finalize() {}
+
+  static size_t Concurrency() { return WsScheduler::Instance().NumWorkers(); }
+
+  static void Yield() {
+    std::this_thread::yield();
+  }
+
+  static uint32_t ThisLocality() { return 0; }
+  static uint32_t NullLocality() { return -1; }
+  static uint32_t NumLocalities() { return 1; }
+
+  static uint32_t NumProcessLocalities() { return 1; }
+  static uint32_t ProcessLocalityIndex() { return 0; }
+
+  static size_t QueueDepth(Priority p) {
+    return WsScheduler::Instance().QueueDepth(p);
+  }
+};
+
+}  // namespace impl
+
+using TargetSystemTag = impl::ws_tag;
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_MAPPINGS_WS_WS_TRAITS_MAPPING_H_
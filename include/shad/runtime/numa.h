@@ -0,0 +1,332 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#ifndef INCLUDE_SHAD_RUNTIME_NUMA_H_
+#define INCLUDE_SHAD_RUNTIME_NUMA_H_
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "shad/runtime/topology.h"
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+/// @brief NUMA domains of the node hosting the calling process.
+///
+/// Domains are the sub-localities of a locality: every domain groups the
+/// CPUs sharing a memory controller.  The topology is read from sysfs and
+/// restricted to the CPUs the process is allowed to run on; systems without
+/// NUMA information are seen as a single domain.
+///
+/// The topology is configured through the following environment variables:
+///  - SHAD_NUMA_DOMAINS: split the available CPUs in the given number of
+///    domains, overriding the ones of the system (useful to emulate a
+///    multi-socket node);
+///  - SHAD_NUMA_PIN: set to 0 to never change the affinity of the threads.
+///
+/// Workers are pinned according to the PinningPolicy of the CpuTopology;
+/// the CPUs of the reserved cores are left out of the domains they bind to.
+class NumaTopology {
+ public:
+  static NumaTopology &Instance() {
+    static NumaTopology *instance = new NumaTopology();
+    return *instance;
+  }
+
+  size_t NumDomains() const { return domains_.size(); }
+
+  /// @brief The CPUs of a domain.
+  const std::vector<int> &Cpus(size_t domain) const {
+    return domains_[domain].cpus;
+  }
+
+  /// @brief The memory node of a domain.
+  int Node(size_t domain) const { return domains_[domain].node; }
+
+  /// @brief The domain of the CPU running the calling thread.
+  size_t ThisDomain() const {
+    if (BoundDomain() != kUnbound) return BoundDomain();
+#if defined(__linux__)
+    return DomainOf(sched_getcpu());
+#else
+    return 0;
+#endif
+  }
+
+  /// @brief Pin the calling worker thread.
+  ///
+  /// Workers are assigned to the domains (or to the CPUs, with the compact
+  /// and scatter policies) round-robin, in the order they call this method.
+  /// It has no effect on threads that are already pinned, when pinning is
+  /// disabled, or on single-domain systems with the domain policy and no
+  /// reserved core.
+  void PinWorker() {
+    if (!pinning_ || BoundDomain() != kUnbound) return;
+    auto &cpus = CpuTopology::Instance();
+    switch (cpus.Policy()) {
+      case PinningPolicy::kNone:
+        return;
+      case PinningPolicy::kDomain: {
+        if (domains_.size() < 2 && cpus.NumReservedCores() == 0) return;
+        size_t domain = nextWorker_.fetch_add(1) % domains_.size();
+        if (Bind(domain)) BoundDomain() = domain;
+        return;
+      }
+      default: {
+        int cpu = cpus.WorkerCpu(nextWorker_.fetch_add(1));
+        if (CpuTopology::Bind({cpu})) BoundDomain() = DomainOf(cpu);
+        return;
+      }
+    }
+  }
+
+  /// @brief Skip the worker slots of the localities hosted by the other
+  /// processes of the node, so that their workers are not pinned to the same
+  /// domains and CPUs as the ones of the calling process.
+  void SkipWorkers(size_t numWorkers) { nextWorker_.fetch_add(numWorkers); }
+
+  /// @brief Distribute the pages of [address, address + numBytes) among the
+  /// domains in contiguous blocks, the first block going to domain 0.
+  ///
+  /// Pages that have not been touched yet are allocated on their domain
+  /// when first accessed; pages already allocated are migrated.
+  void Place(void *address, size_t numBytes) const {
+    if (domains_.size() < 2) return;
+    size_t blockSize = numBytes / domains_.size();
+    auto base = static_cast<uint8_t *>(address);
+    for (size_t d = 0; d < domains_.size(); ++d) {
+      size_t size = d + 1 == domains_.size() ? numBytes - d * blockSize
+                                             : blockSize;
+      PlaceOnDomain(base + d * blockSize, size, d);
+    }
+  }
+
+  /// @brief Place the pages of [address, address + numBytes) on a domain.
+  ///
+  /// Only the pages entirely contained in the range are affected.
+  void PlaceOnDomain(void *address, size_t numBytes, size_t domain) const {
+#if defined(__linux__)
+    if (domains_.size() < 2) return;
+    uintptr_t begin = reinterpret_cast<uintptr_t>(address);
+    uintptr_t end = begin + numBytes;
+    begin = (begin + pageSize_ - 1) & ~(pageSize_ - 1);
+    end &= ~(pageSize_ - 1);
+    if (begin >= end) return;
+
+    int node = domains_[domain].node;
+    std::vector<unsigned long> nodeMask(node / (8 * sizeof(unsigned long)) + 1,
+                                        0);
+    nodeMask[node / (8 * sizeof(unsigned long))] |=
+        1UL << (node % (8 * sizeof(unsigned long)));
+    // A failure leaves the pages where they are: placement is a hint.
+    syscall(SYS_mbind, begin, end - begin, MPOL_PREFERRED, nodeMask.data(),
+            nodeMask.size() * 8 * sizeof(unsigned long) + 1, MPOL_MF_MOVE);
+#endif
+  }
+
+ private:
+  friend class DomainScope;
+
+  static constexpr size_t kUnbound = static_cast<size_t>(-1);
+
+  struct Domain {
+    int node;
+    std::vector<int> cpus;
+  };
+
+  NumaTopology() : nextWorker_(0), pinning_(true), pageSize_(4096) {
+    std::vector<int> available = CpuTopology::AvailableCpus();
+#if defined(__linux__)
+    pageSize_ = sysconf(_SC_PAGESIZE);
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string nodes;
+    if (online && std::getline(online, nodes)) {
+      for (int node : parseCpuList(nodes)) ReadNode(node, available);
+    }
+#endif
+    // Memory-only nodes, or nodes the process cannot run on, are not
+    // domains.
+    domains_.erase(
+        std::remove_if(domains_.begin(), domains_.end(),
+                       [](const Domain &domain) { return domain.cpus.empty(); }),
+        domains_.end());
+    if (domains_.empty()) domains_.push_back(Domain{0, available});
+
+    const char *numDomains = std::getenv("SHAD_NUMA_DOMAINS");
+    if (numDomains != nullptr && *numDomains != '\0')
+      Emulate(std::max<size_t>(std::stoul(numDomains), 1), available);
+
+    const char *pin = std::getenv("SHAD_NUMA_PIN");
+    if (pin != nullptr && std::string(pin) == "0") pinning_ = false;
+  }
+
+  static size_t &BoundDomain() {
+    static thread_local size_t domain = kUnbound;
+    return domain;
+  }
+
+  void ReadNode(int node, const std::vector<int> &available) {
+    std::ifstream file("/sys/devices/system/node/node" +
+                       std::to_string(node) + "/cpulist");
+    std::string list;
+    if (!file || !std::getline(file, list)) return;
+
+    Domain domain{node, {}};
+    for (int cpu : parseCpuList(list))
+      if (std::binary_search(available.begin(), available.end(), cpu))
+        domain.cpus.push_back(cpu);
+    domains_.push_back(domain);
+  }
+
+  // Split the available CPUs in numDomains contiguous groups, each placed on
+  // the memory node of its first CPU.  With more domains than CPUs, domains
+  // share the CPUs round-robin.
+  void Emulate(size_t numDomains, const std::vector<int> &available) {
+    std::vector<Domain> domains;
+    for (size_t d = 0; d < numDomains; ++d) {
+      size_t first = d * available.size() / numDomains;
+      size_t last = (d + 1) * available.size() / numDomains;
+      if (first == last) {
+        first = d % available.size();
+        last = first + 1;
+      }
+      Domain domain{NodeOf(available[first]), {}};
+      domain.cpus.assign(available.begin() + first, available.begin() + last);
+      domains.push_back(domain);
+    }
+    domains_.swap(domains);
+  }
+
+  int NodeOf(int cpu) const { return domains_[DomainOf(cpu)].node; }
+
+  size_t DomainOf(int cpu) const {
+    for (size_t d = 0; d < domains_.size(); ++d) {
+      auto &cpus = domains_[d].cpus;
+      if (std::binary_search(cpus.begin(), cpus.end(), cpu)) return d;
+    }
+    return 0;
+  }
+
+  // Restrict the calling thread to the CPUs of a domain, but the ones of the
+  // reserved cores (unless they are all the domain has).
+  bool Bind(size_t domain) const {
+    auto &reserved = CpuTopology::Instance().ReservedCpus();
+    std::vector<int> cpus;
+    for (int cpu : domains_[domain].cpus)
+      if (!std::binary_search(reserved.begin(), reserved.end(), cpu))
+        cpus.push_back(cpu);
+    return CpuTopology::Bind(cpus.empty() ? domains_[domain].cpus : cpus);
+  }
+
+  std::vector<Domain> domains_;
+  std::atomic<size_t> nextWorker_;
+  bool pinning_;
+  uintptr_t pageSize_;
+};
+
+/// @brief Run the calling thread on a domain for the lifetime of the object.
+///
+/// Threads already bound to the domain are left untouched; the others get
+/// their previous affinity back on destruction.
+class DomainScope {
+ public:
+  explicit DomainScope(size_t domain)
+      : restore_(false), previousDomain_(NumaTopology::kUnbound) {
+    auto &topology = NumaTopology::Instance();
+    if (topology.NumDomains() < 2 || !topology.pinning_) return;
+    previousDomain_ = NumaTopology::BoundDomain();
+    if (previousDomain_ == domain) return;
+#if defined(__linux__)
+    if (pthread_getaffinity_np(pthread_self(), sizeof(previous_),
+                               &previous_) != 0)
+      return;
+    if (!topology.Bind(domain)) return;
+    NumaTopology::BoundDomain() = domain;
+    restore_ = true;
+#endif
+  }
+
+  ~DomainScope() {
+#if defined(__linux__)
+    if (!restore_) return;
+    pthread_setaffinity_np(pthread_self(), sizeof(previous_), &previous_);
+    NumaTopology::BoundDomain() = previousDomain_;
+#endif
+  }
+
+  DomainScope(const DomainScope &) = delete;
+  DomainScope &operator=(const DomainScope &) = delete;
+
+ private:
+  bool restore_;
+  size_t previousDomain_;
+#if defined(__linux__)
+  cpu_set_t previous_;
+#endif
+};
+
+}  // namespace impl
+
+/// @brief Number of NUMA domains (sub-localities) of the calling locality.
+inline uint32_t numDomains() {
+  return impl::NumaTopology::Instance().NumDomains();
+}
+
+/// @brief The NUMA domain the calling thread is running on.
+inline uint32_t thisDomain() {
+  return impl::NumaTopology::Instance().ThisDomain();
+}
+
+/// @brief The home domain of the i-th of n equal parts of a local range.
+///
+/// Ranges placed with NumaTopology::Place assign contiguous blocks to the
+/// domains: part i lives (mostly) on the domain returned by this function.
+inline uint32_t homeDomain(size_t i, size_t n) {
+  return n == 0 ? 0 : (i * numDomains()) / n;
+}
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_NUMA_H_
@@ -0,0 +1,97 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#ifndef INCLUDE_SHAD_RUNTIME_PRIORITY_H_
+#define INCLUDE_SHAD_RUNTIME_PRIORITY_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace shad {
+namespace rt {
+
+/// @brief Scheduling classes of the tasks.
+///
+/// Every mapping with a scheduler of its own keeps one queue per class and
+/// always serves the most urgent non-empty queue first, so that short,
+/// latency-sensitive requests do not wait behind bulk work.
+enum class Priority : uint8_t {
+  /// Latency-critical requests (e.g., point lookups).
+  kLatency = 0,
+  /// The default class.
+  kNormal = 1,
+  /// Background work (e.g., scans and buffer flushes).
+  kBulk = 2
+};
+
+/// @brief Number of scheduling classes.
+constexpr size_t kNumPriorities = 3;
+
+namespace impl {
+
+/// @brief The priority of the tasks spawned by the calling thread.
+///
+/// Workers set it to the priority of the task they are executing, so that
+/// tasks inherit the class of the task that spawned them.
+inline Priority &CurrentPriority() {
+  static thread_local Priority priority = Priority::kNormal;
+  return priority;
+}
+
+}  // namespace impl
+
+/// @brief Set the priority of the tasks spawned by the calling thread for
+/// the lifetime of the object.
+///
+/// Typical Usage:
+/// @code
+/// {
+///   shad::rt::PriorityScope scope(shad::rt::Priority::kLatency);
+///   map->Lookup(key, &value);
+/// }
+/// @endcode
+class PriorityScope {
+ public:
+  explicit PriorityScope(Priority priority)
+      : previous_(impl::CurrentPriority()) {
+    impl::CurrentPriority() = priority;
+  }
+
+  ~PriorityScope() { impl::CurrentPriority() = previous_; }
+
+  PriorityScope(const PriorityScope &) = delete;
+  PriorityScope &operator=(const PriorityScope &) = delete;
+
+ private:
+  Priority previous_;
+};
+
+/// @brief The priority of the tasks spawned by the calling thread.
+inline Priority currentPriority() { return impl::CurrentPriority(); }
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_PRIORITY_H_
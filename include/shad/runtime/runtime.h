@@ -34,16 +34,25 @@
 #include <map>
 #include <memory>
 #include <set>
+#include <type_traits>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "shad/config/config.h"
+#include "shad/runtime/atomics.h"
+#include "shad/runtime/coalescing.h"
+#include "shad/runtime/dma.h"
 #include "shad/runtime/handle.h"
 #include "shad/runtime/locality.h"
 #include "shad/runtime/mapping_traits.h"
 #include "shad/runtime/mappings/available_mappings.h"
+#include "shad/runtime/numa.h"
+#include "shad/runtime/priority.h"
 #include "shad/runtime/synchronous_interface.h"
+#include "shad/runtime/task_arena.h"
+#include "shad/runtime/topology.h"
+#include "shad/runtime/tracing.h"
 
 /// @namespace shad
 namespace shad {
@@ -76,14 +85,94 @@ inline size_t getConcurrency() {
 }
 
 /// @brief Initialize the runtime environment.
+///
+/// The pinning policy of the workers is read from the command line (see
+/// CpuTopology) before the runtime starts them.
+///
 /// @param argc pointer to argument count
 /// @param argv pointer to array of char *
 inline void initialize(int argc, char *argv[]) {
+  CpuTopology::Instance().Configure(argc, argv);
   RuntimeInternalsTrait<TargetSystemTag>::Initialize(argc, argv);
 }
 
+void exportTraces();
+
 /// @brief Finailize the runtime environment prior to program termination.
-inline void finalize() { RuntimeInternalsTrait<TargetSystemTag>::Finalize(); }
+///
+/// When the tracing is enabled, it also writes the traces of all the
+/// localities.
+inline void finalize() {
+  exportTraces();
+  RuntimeInternalsTrait<TargetSystemTag>::Finalize();
+}
+
+/// @brief Number of localities hosted by the calling process.
+///
+/// Process-wide singletons that hold per-locality state (e.g., the catalog of
+/// the data structures) must keep one instance for each of these localities.
+inline uint32_t numProcessLocalities() {
+  return RuntimeInternalsTrait<TargetSystemTag>::NumProcessLocalities();
+}
+
+/// @brief Index of the calling locality among the ones hosted by the calling
+/// process.
+inline uint32_t processLocalityIndex() {
+  return RuntimeInternalsTrait<TargetSystemTag>::ProcessLocalityIndex();
+}
+
+/// @brief Record a call of the calling locality directed to dst.
+inline void traceCall(TraceOp op, const Locality &dst, size_t numBytes) {
+#if defined(SHAD_ENABLE_TRACING)
+  Tracer::Instance().RecordCall(
+      op, RuntimeInternalsTrait<TargetSystemTag>::ThisLocality(),
+      static_cast<uint32_t>(dst), numBytes);
+#endif
+}
+
+/// @brief Record a call of the calling locality directed to all the
+/// localities.
+inline void traceBroadcast(TraceOp op, size_t numBytes) {
+#if defined(SHAD_ENABLE_TRACING)
+  Tracer::Instance().RecordBroadcast(
+      op, RuntimeInternalsTrait<TargetSystemTag>::ThisLocality(),
+      RuntimeInternalsTrait<TargetSystemTag>::NumLocalities(), numBytes);
+#endif
+}
+
+/// @brief Record numBytes received by the calling locality from src.
+inline void traceReceived(const Locality &src, size_t numBytes) {
+#if defined(SHAD_ENABLE_TRACING)
+  Tracer::Instance().RecordReceived(
+      RuntimeInternalsTrait<TargetSystemTag>::ThisLocality(),
+      static_cast<uint32_t>(src), numBytes);
+#endif
+}
+
+/// @brief Record the result of an asynchronous call to src as received by the
+/// calling locality once handle completes: numBytes if resultSize is null,
+/// the value of *resultSize at completion otherwise.
+inline void traceReceivedOnCompletion(const Handle &handle,
+                                      const Locality &src,
+                                      const uint32_t *resultSize,
+                                      size_t numBytes) {
+#if defined(SHAD_ENABLE_TRACING)
+  Tracer::Instance().DeferReceived(
+      RuntimeInternalsTrait<TargetSystemTag>::ThisLocality(),
+      static_cast<uint64_t>(handle), static_cast<uint32_t>(src), resultSize,
+      numBytes);
+#endif
+}
+
+/// @brief Record the results of the calls of the calling locality that handle
+/// has completed.
+inline void traceCompleted(const Handle &handle) {
+#if defined(SHAD_ENABLE_TRACING)
+  Tracer::Instance().CompleteReceived(
+      RuntimeInternalsTrait<TargetSystemTag>::ThisLocality(),
+      static_cast<uint64_t>(handle));
+#endif
+}
 
 /// @brief Creates a new Handle.
 inline Handle createHandle() {
@@ -112,6 +201,16 @@ inline std::set<Locality> allLocalities() {
   return result;
 }
 
+/// @brief Number of tasks of a scheduling class waiting to be executed on
+/// the calling locality.
+///
+/// Mappings that do not classify their tasks always return 0.
+///
+/// @param p The scheduling class.
+inline size_t queueDepth(Priority p) {
+  return impl::RuntimeInternalsTrait<TargetSystemTag>::QueueDepth(p);
+}
+
 /// @brief Execute a function on a selected locality synchronously.
 ///
 /// Typical Usage:
@@ -144,6 +243,7 @@ inline std::set<Locality> allLocalities() {
 /// @param args The arguments to be passed to the function.
 template <typename FunT, typename InArgsT>
 void executeAt(const Locality &loc, FunT &&func, const InArgsT &args) {
+  impl::traceCall(impl::TraceOp::kExecuteAt, loc, sizeof(InArgsT));
   impl::SynchronousInterface<TargetSystemTag>::executeAt(loc, func, args);
 }
 
@@ -184,6 +284,7 @@ template <typename FunT>
 void executeAt(const Locality &loc, FunT &&func,
                const std::shared_ptr<uint8_t> &argsBuffer,
                const uint32_t bufferSize) {
+  impl::traceCall(impl::TraceOp::kExecuteAt, loc, bufferSize);
   impl::SynchronousInterface<TargetSystemTag>::executeAt(loc, func, argsBuffer,
                                                          bufferSize);
 }
@@ -232,8 +333,10 @@ void executeAt(const Locality &loc, FunT &&func,
 template <typename FunT, typename InArgsT>
 void executeAtWithRetBuff(const Locality &loc, FunT &&func, const InArgsT &args,
                           uint8_t *resultBuffer, uint32_t *resultSize) {
+  impl::traceCall(impl::TraceOp::kExecuteAtWithRet, loc, sizeof(InArgsT));
   impl::SynchronousInterface<TargetSystemTag>::executeAtWithRetBuff(
       loc, func, args, resultBuffer, resultSize);
+  impl::traceReceived(loc, *resultSize);
 }
 
 /// @brief Execute a function on a selected locality synchronously and
@@ -286,8 +389,10 @@ void executeAtWithRetBuff(const Locality &loc, FunT &&func,
                           const std::shared_ptr<uint8_t> &argsBuffer,
                           const uint32_t bufferSize, uint8_t *resultBuffer,
                           uint32_t *resultSize) {
+  impl::traceCall(impl::TraceOp::kExecuteAtWithRet, loc, bufferSize);
   impl::SynchronousInterface<TargetSystemTag>::executeAtWithRetBuff(
       loc, func, argsBuffer, bufferSize, resultBuffer, resultSize);
+  impl::traceReceived(loc, *resultSize);
 }
 
 /// @brief Execute a function on a selected locality synchronously and return a
@@ -332,8 +437,10 @@ void executeAtWithRetBuff(const Locality &loc, FunT &&func,
 template <typename FunT, typename InArgsT, typename ResT>
 void executeAtWithRet(const Locality &loc, FunT &&func, const InArgsT &args,
                       ResT *result) {
+  impl::traceCall(impl::TraceOp::kExecuteAtWithRet, loc, sizeof(InArgsT));
   impl::SynchronousInterface<TargetSystemTag>::executeAtWithRet(loc, func, args,
                                                                 result);
+  impl::traceReceived(loc, sizeof(ResT));
 }
 
 /// @brief Execute a function on a selected locality synchronously and
@@ -383,8 +490,10 @@ template <typename FunT, typename ResT>
 void executeAtWithRet(const Locality &loc, FunT &&func,
                       const std::shared_ptr<uint8_t> &argsBuffer,
                       const uint32_t bufferSize, ResT *result) {
+  impl::traceCall(impl::TraceOp::kExecuteAtWithRet, loc, bufferSize);
   impl::SynchronousInterface<TargetSystemTag>::executeAtWithRet(
       loc, func, argsBuffer, bufferSize, result);
+  impl::traceReceived(loc, sizeof(ResT));
 }
 
 /// @brief Execute a function on all localities synchronously.
@@ -416,6 +525,7 @@ void executeAtWithRet(const Locality &loc, FunT &&func,
 /// @param args The arguments to be passed to the function.
 template <typename FunT, typename InArgsT>
 void executeOnAll(FunT &&func, const InArgsT &args) {
+  impl::traceBroadcast(impl::TraceOp::kExecuteOnAll, sizeof(InArgsT));
   impl::SynchronousInterface<TargetSystemTag>::executeOnAll(func, args);
 }
 
@@ -452,10 +562,67 @@ void executeOnAll(FunT &&func, const InArgsT &args) {
 template <typename FunT>
 void executeOnAll(FunT &&func, const std::shared_ptr<uint8_t> &argsBuffer,
                   const uint32_t bufferSize) {
+  impl::traceBroadcast(impl::TraceOp::kExecuteOnAll, bufferSize);
   impl::SynchronousInterface<TargetSystemTag>::executeOnAll(func, argsBuffer,
                                                             bufferSize);
 }
 
+/// @brief Enable the coalescing of small asynchronous tasks on all localities.
+///
+/// Once enabled, asyncExecuteAt calls directed to a remote locality, whose
+/// function is a plain function (or a lambda without captures) and whose
+/// argument is trivially copyable and at most
+/// impl::Coalescer::kMaxArgsSize bytes, are packed per Handle and destination
+/// and shipped in a single message.  A batch is shipped when it is full, when
+/// a task joins it after maxDelayNs, when the Handle is waited, or once the
+/// locality that built it has no more urgent work.  Coalesced tasks complete
+/// when the Handle is waited.
+///
+/// Typical Usage:
+/// @code
+/// shad::rt::enableCoalescing();
+///
+/// Handle handle;
+/// for (size_t i = 0; i < numUpdates; ++i)
+///   asyncExecuteAt(handle, locality, update, args[i]);
+///
+/// waitForCompletion(handle);
+/// shad::rt::disableCoalescing();
+/// @endcode
+///
+/// @param maxBatchBytes The size in bytes that triggers the shipping of a
+/// batch.
+/// @param maxDelayNs The age in nanoseconds after which a batch is shipped
+/// by the next task joining it.
+inline void enableCoalescing(
+    size_t maxBatchBytes = impl::Coalescer::kDefaultMaxBatchBytes,
+    uint64_t maxDelayNs = impl::Coalescer::kDefaultMaxDelayNs) {
+  struct Args {
+    size_t maxBatchBytes;
+    uint64_t maxDelayNs;
+  };
+  executeOnAll(
+      [](const Args &args) {
+        impl::Coalescer::Instance().Configure(true, args.maxBatchBytes,
+                                              args.maxDelayNs);
+      },
+      Args{maxBatchBytes, maxDelayNs});
+}
+
+/// @brief Disable the coalescing of small asynchronous tasks on all localities.
+///
+/// Tasks already coalesced are shipped and complete when their Handle is
+/// waited.
+inline void disableCoalescing() {
+  executeOnAll(
+      [](const bool &) {
+        impl::Coalescer::Instance().Configure(
+            false, impl::Coalescer::kDefaultMaxBatchBytes,
+            impl::Coalescer::kDefaultMaxDelayNs);
+      },
+      false);
+}
+
 /// @brief Execute a parallel loop at a specific locality.
 ///
 /// Typical Usage:
@@ -492,6 +659,7 @@ void executeOnAll(FunT &&func, const std::shared_ptr<uint8_t> &argsBuffer,
 template <typename FunT, typename InArgsT>
 void forEachAt(const Locality &loc, FunT &&func, const InArgsT &args,
                const size_t numIters) {
+  impl::traceCall(impl::TraceOp::kForEachAt, loc, sizeof(InArgsT));
   impl::SynchronousInterface<TargetSystemTag>::forEachAt(loc, func, args,
                                                          numIters);
 }
@@ -527,6 +695,7 @@ template <typename FunT>
 void forEachAt(const Locality &loc, FunT &&func,
                const std::shared_ptr<uint8_t> &argsBuffer,
                const uint32_t bufferSize, const size_t numIters) {
+  impl::traceCall(impl::TraceOp::kForEachAt, loc, bufferSize);
   impl::SynchronousInterface<TargetSystemTag>::forEachAt(loc, func, argsBuffer,
                                                          bufferSize, numIters);
 }
@@ -566,6 +735,7 @@ void forEachAt(const Locality &loc, FunT &&func,
 /// @param numIters  The total number of iteration of the loop.
 template <typename FunT, typename InArgsT>
 void forEachOnAll(FunT &&func, const InArgsT &args, const size_t numIters) {
+  impl::traceBroadcast(impl::TraceOp::kForEachOnAll, sizeof(InArgsT));
   impl::SynchronousInterface<TargetSystemTag>::forEachOnAll(func, args,
                                                             numIters);
 }
@@ -599,6 +769,7 @@ void forEachOnAll(FunT &&func, const InArgsT &args, const size_t numIters) {
 template <typename FunT>
 void forEachOnAll(FunT &&func, const std::shared_ptr<uint8_t> &argsBuffer,
                   const uint32_t bufferSize, const size_t numIters) {
+  impl::traceBroadcast(impl::TraceOp::kForEachOnAll, bufferSize);
   impl::SynchronousInterface<TargetSystemTag>::forEachOnAll(
       func, argsBuffer, bufferSize, numIters);
 }
@@ -640,10 +811,71 @@ void forEachOnAll(FunT &&func, const std::shared_ptr<uint8_t> &argsBuffer,
 template <typename FunT, typename InArgsT>
 void asyncExecuteAt(Handle &handle, const Locality &loc, FunT &&func,
                     const InArgsT &args) {
+  impl::traceCall(impl::TraceOp::kAsyncExecuteAt, loc, sizeof(InArgsT));
+  using FunctionTy = void (*)(Handle &, const InArgsT &);
+  if constexpr (std::is_convertible<FunT, FunctionTy>::value &&
+                impl::Coalescer::IsCoalescible<InArgsT>()) {
+    if (impl::Coalescer::ShouldCoalesce(loc)) {
+      FunctionTy function = func;
+      impl::Coalescer::Instance().Enqueue(handle, loc, function, args);
+      return;
+    }
+  }
   impl::AsynchronousInterface<TargetSystemTag>::asyncExecuteAt(handle, loc,
                                                                func, args);
 }
 
+/// @brief Execute a function on a selected locality asynchronously, moving
+/// the arguments into the task.
+///
+/// Selected when the arguments are a temporary: the runtimes running the task
+/// in the same address space move them into the task closure instead of
+/// copying them, so that large arguments are not copied twice.
+///
+/// Typical Usage:
+/// @code
+/// struct Args {
+///   std::array<uint8_t, 4096> data;
+/// };
+///
+/// void task(Handle & handle, const Args & args) {  /* do something */ }
+///
+/// Handle handle;
+/// Args args = /* fill the arguments */;
+/// asyncExecuteAt(handle, locality, task, std::move(args));
+/// waitForCompletion(handle);
+/// @endcode
+///
+/// @tparam FunT The type of the function to be executed.  The function
+/// prototype must be:
+/// @code
+/// void(Handle &, const InArgsT &);
+/// @endcode
+///
+/// @tparam InArgsT The type of the argument accepted by the function.  The type
+/// can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @param handle An Handle for the associated task-group.
+/// @param loc The Locality where the function must be executed.
+/// @param func The function to execute.
+/// @param args The arguments to be moved into the task.
+template <typename FunT, typename InArgsT,
+          typename = typename std::enable_if<
+              !std::is_reference<InArgsT>::value>::type>
+void asyncExecuteAt(Handle &handle, const Locality &loc, FunT &&func,
+                    InArgsT &&args) {
+  if constexpr (impl::Coalescer::IsCoalescible<InArgsT>()) {
+    // Small arguments are copied into the batches anyway.
+    const InArgsT &argsRef = args;
+    asyncExecuteAt(handle, loc, std::forward<FunT>(func), argsRef);
+  } else {
+    impl::traceCall(impl::TraceOp::kAsyncExecuteAt, loc, sizeof(InArgsT));
+    impl::AsynchronousInterface<TargetSystemTag>::asyncExecuteAt(
+        handle, loc, func, std::move(args));
+  }
+}
+
 /// @brief Execute a function on a selected locality asynchronously.
 ///
 /// Typical Usage:
@@ -660,8 +892,7 @@ void asyncExecuteAt(Handle &handle, const Locality &loc, FunT &&func,
 /// Args args { 2, 'a' };
 /// /* Args doesn't need a dynamic allocated buffer but
 ///  * more complicated data structure might need it */
-/// std::shared_ptr<uint8_t> ptr(new uint8_t[sizeof(Args)],
-///                              std::default_delete<uint8_t[]>());
+/// std::shared_ptr<uint8_t> ptr = allocateArgsBuffer(sizeof(Args));
 /// memcpy(ptr.get(), &args, sizeof(Args));
 ///
 /// Handle handle;
@@ -672,6 +903,9 @@ void asyncExecuteAt(Handle &handle, const Locality &loc, FunT &&func,
 /// waitForCompletion(handle)
 /// @endcode
 ///
+/// Buffers obtained from allocateArgsBuffer are recycled by the runtime when
+/// the tasks using them complete.
+///
 /// @tparam FunT The type of the function to be executed.  The function
 /// prototype must be:
 /// @code
@@ -687,6 +921,7 @@ template <typename FunT>
 void asyncExecuteAt(Handle &handle, const Locality &loc, FunT &&func,
                     const std::shared_ptr<uint8_t> &argsBuffer,
                     const uint32_t bufferSize) {
+  impl::traceCall(impl::TraceOp::kAsyncExecuteAt, loc, bufferSize);
   impl::AsynchronousInterface<TargetSystemTag>::asyncExecuteAt(
       handle, loc, func, argsBuffer, bufferSize);
 }
@@ -749,8 +984,10 @@ template <typename FunT, typename InArgsT>
 void asyncExecuteAtWithRetBuff(Handle &handle, const Locality &loc, FunT &&func,
                                const InArgsT &args, uint8_t *resultBuffer,
                                uint32_t *resultSize) {
+  impl::traceCall(impl::TraceOp::kAsyncExecuteAtWithRet, loc, sizeof(InArgsT));
   impl::AsynchronousInterface<TargetSystemTag>::asyncExecuteAtWithRetBuff(
       handle, loc, func, args, resultBuffer, resultSize);
+  impl::traceReceivedOnCompletion(handle, loc, resultSize, 0);
 }
 
 /// @brief Execute a function on a selected locality asynchronously and return a
@@ -814,8 +1051,10 @@ void asyncExecuteAtWithRetBuff(Handle &handle, const Locality &loc, FunT &&func,
                                const std::shared_ptr<uint8_t> &argsBuffer,
                                const uint32_t bufferSize, uint8_t *resultBuffer,
                                uint32_t *resultSize) {
+  impl::traceCall(impl::TraceOp::kAsyncExecuteAtWithRet, loc, bufferSize);
   impl::AsynchronousInterface<TargetSystemTag>::asyncExecuteAtWithRetBuff(
       handle, loc, func, argsBuffer, bufferSize, resultBuffer, resultSize);
+  impl::traceReceivedOnCompletion(handle, loc, resultSize, 0);
 }
 
 /// @brief Execute a function on a selected locality asynchronously and return a
@@ -866,8 +1105,10 @@ void asyncExecuteAtWithRetBuff(Handle &handle, const Locality &loc, FunT &&func,
 template <typename FunT, typename InArgsT, typename ResT>
 void asyncExecuteAtWithRet(Handle &handle, const Locality &loc, FunT &&func,
                            const InArgsT &args, ResT *result) {
+  impl::traceCall(impl::TraceOp::kAsyncExecuteAtWithRet, loc, sizeof(InArgsT));
   impl::AsynchronousInterface<TargetSystemTag>::asyncExecuteAtWithRet(
       handle, loc, func, args, result);
+  impl::traceReceivedOnCompletion(handle, loc, nullptr, sizeof(ResT));
 }
 
 /// @brief Execute a function on a selected locality asynchronously and return a
@@ -921,8 +1162,10 @@ template <typename FunT, typename ResT>
 void asyncExecuteAtWithRet(Handle &handle, const Locality &loc, FunT &&func,
                            const std::shared_ptr<uint8_t> &argsBuffer,
                            const uint32_t bufferSize, ResT *result) {
+  impl::traceCall(impl::TraceOp::kAsyncExecuteAtWithRet, loc, bufferSize);
   impl::AsynchronousInterface<TargetSystemTag>::asyncExecuteAtWithRet(
       handle, loc, func, argsBuffer, bufferSize, result);
+  impl::traceReceivedOnCompletion(handle, loc, nullptr, sizeof(ResT));
 }
 
 /// @brief Execute a function on all localities asynchronously.
@@ -958,6 +1201,7 @@ void asyncExecuteAtWithRet(Handle &handle, const Locality &loc, FunT &&func,
 /// @param args The arguments to be passed to the function.
 template <typename FunT, typename InArgsT>
 void asyncExecuteOnAll(Handle &handle, FunT &&func, const InArgsT &args) {
+  impl::traceBroadcast(impl::TraceOp::kAsyncExecuteOnAll, sizeof(InArgsT));
   impl::AsynchronousInterface<TargetSystemTag>::asyncExecuteOnAll(handle, func,
                                                                   args);
 }
@@ -1001,6 +1245,7 @@ template <typename FunT>
 void asyncExecuteOnAll(Handle &handle, FunT &&func,
                        const std::shared_ptr<uint8_t> &argsBuffer,
                        const uint32_t bufferSize) {
+  impl::traceBroadcast(impl::TraceOp::kAsyncExecuteOnAll, bufferSize);
   impl::AsynchronousInterface<TargetSystemTag>::asyncExecuteOnAll(
       handle, func, argsBuffer, bufferSize);
 }
@@ -1043,6 +1288,7 @@ void asyncExecuteOnAll(Handle &handle, FunT &&func,
 template <typename FunT, typename InArgsT>
 void asyncForEachAt(Handle &handle, const Locality &loc, FunT &&func,
                     const InArgsT &args, const size_t numIters) {
+  impl::traceCall(impl::TraceOp::kAsyncForEachAt, loc, sizeof(InArgsT));
   impl::AsynchronousInterface<TargetSystemTag>::asyncForEachAt(
       handle, loc, func, args, numIters);
 }
@@ -1084,6 +1330,7 @@ template <typename FunT>
 void asyncForEachAt(Handle &handle, const Locality &loc, FunT &&func,
                     const std::shared_ptr<uint8_t> &argsBuffer,
                     const uint32_t bufferSize, const size_t numIters) {
+  impl::traceCall(impl::TraceOp::kAsyncForEachAt, loc, bufferSize);
   impl::AsynchronousInterface<TargetSystemTag>::asyncForEachAt(
       handle, loc, func, argsBuffer, bufferSize, numIters);
 }
@@ -1128,6 +1375,7 @@ void asyncForEachAt(Handle &handle, const Locality &loc, FunT &&func,
 template <typename FunT, typename InArgsT>
 void asyncForEachOnAll(Handle &handle, FunT &&func, const InArgsT &args,
                        const size_t numIters) {
+  impl::traceBroadcast(impl::TraceOp::kAsyncForEachOnAll, sizeof(InArgsT));
   impl::AsynchronousInterface<TargetSystemTag>::asyncForEachOnAll(
       handle, func, args, numIters);
 }
@@ -1167,6 +1415,7 @@ template <typename FunT>
 void asyncForEachOnAll(Handle &handle, FunT &&func,
                        const std::shared_ptr<uint8_t> &argsBuffer,
                        const uint32_t bufferSize, const size_t numIters) {
+  impl::traceBroadcast(impl::TraceOp::kAsyncForEachOnAll, bufferSize);
   impl::AsynchronousInterface<TargetSystemTag>::asyncForEachOnAll(
       handle, func, argsBuffer, bufferSize, numIters);
 }
@@ -1181,6 +1430,7 @@ void asyncForEachOnAll(Handle &handle, FunT &&func,
 template <typename T>
 void dma(const Locality &destLoc, const T* remoteAddress,
          const T* localData, const size_t numElements) {
+  impl::traceCall(impl::TraceOp::kDma, destLoc, numElements * sizeof(T));
   impl::SynchronousInterface<TargetSystemTag>::dma(
       destLoc, remoteAddress, localData, numElements);
 }
@@ -1195,6 +1445,8 @@ void dma(const Locality &destLoc, const T* remoteAddress,
 template <typename T>
 void dma(const T* localAddress, const Locality &srcLoc,
          const T* remoteData, const size_t numElements) {
+  impl::traceCall(impl::TraceOp::kDma, srcLoc, 0);
+  impl::traceReceived(srcLoc, numElements * sizeof(T));
   impl::SynchronousInterface<TargetSystemTag>::dma(
       localAddress, srcLoc, remoteData, numElements);
 }
@@ -1212,6 +1464,10 @@ template <typename T>
 void asyncDma(Handle &handle,
               const Locality &destLoc, const T* remoteAddress,
               const T* localData, const size_t numElements) {
+#if defined(SHAD_ENABLE_TRACING)
+  impl::Tracer::Instance().CountCall(impl::TraceOp::kAsyncDma,
+                                     static_cast<uint32_t>(thisLocality()));
+#endif
   using args_t = std::tuple<const Locality, const T*, const T*,const size_t>;
   args_t args(destLoc, remoteAddress, localData, numElements);
   asyncExecuteAt(handle, thisLocality(),
@@ -1235,6 +1491,10 @@ template <typename T>
 void asyncDma(Handle &handle,
               const T* localAddress, const Locality &srcLoc,
               const T* remoteData, const size_t numElements) {
+#if defined(SHAD_ENABLE_TRACING)
+  impl::Tracer::Instance().CountCall(impl::TraceOp::kAsyncDma,
+                                     static_cast<uint32_t>(thisLocality()));
+#endif
   using args_t = std::tuple<const T*, const Locality,
                             const T*, const size_t>;
   args_t args(localAddress, srcLoc, remoteData, numElements);
@@ -1246,10 +1506,502 @@ void asyncDma(Handle &handle,
         args); 
 }
 
+/// @brief Copies contiguous local data to a list of segments of a
+/// potentially remote locality, in a single transfer.
+///
+/// @tparam T type of the data to copy.
+/// @param destLoc The locality where to copy to.
+/// @param remoteSegments The segments of destLoc to copy to, in order.
+/// @param numSegments The number of segments.
+/// @param localData The pointer to the memory allocation to copy from.
+template <typename T>
+void dmaScatter(const Locality &destLoc, const DmaSegment<T> *remoteSegments,
+                const size_t numSegments, const T *localData) {
+  impl::traceCall(
+      impl::TraceOp::kDma, destLoc,
+      impl::numSegmentElements(remoteSegments, numSegments) * sizeof(T));
+  impl::SynchronousInterface<TargetSystemTag>::dmaScatter(
+      destLoc, remoteSegments, numSegments, localData);
+}
+
+/// @brief Copies a list of segments of a potentially remote locality to
+/// contiguous local memory, in a single transfer.
+///
+/// @tparam T type of the data to copy.
+/// @param localAddress The pointer to the local memory allocation.
+/// @param srcLoc The locality where to copy from.
+/// @param remoteSegments The segments of srcLoc to copy from, in order.
+/// @param numSegments The number of segments.
+template <typename T>
+void dmaGather(const T *localAddress, const Locality &srcLoc,
+               const DmaSegment<T> *remoteSegments, const size_t numSegments) {
+  impl::traceCall(impl::TraceOp::kDma, srcLoc, 0);
+  impl::traceReceived(
+      srcLoc,
+      impl::numSegmentElements(remoteSegments, numSegments) * sizeof(T));
+  impl::SynchronousInterface<TargetSystemTag>::dmaGather(
+      localAddress, srcLoc, remoteSegments, numSegments);
+}
+
+/// @brief Copies contiguous local data to strided elements of a potentially
+/// remote locality.
+///
+/// @tparam T type of the data to copy.
+/// @param destLoc The locality where to copy to.
+/// @param remoteBase The pointer to the first element to copy to.
+/// @param stride The distance, in elements, between two elements of destLoc.
+/// @param localData The pointer to the memory allocation to copy from.
+/// @param numElements Number of elements to copy.
+template <typename T>
+void dmaStrided(const Locality &destLoc, const T *remoteBase,
+                const size_t stride, const T *localData,
+                const size_t numElements) {
+  impl::traceCall(impl::TraceOp::kDma, destLoc, numElements * sizeof(T));
+  impl::SynchronousInterface<TargetSystemTag>::dmaStrided(
+      destLoc, remoteBase, stride, localData, numElements);
+}
+
+/// @brief Copies strided elements of a potentially remote locality to
+/// contiguous local memory.
+///
+/// @tparam T type of the data to copy.
+/// @param localAddress The pointer to the local memory allocation.
+/// @param srcLoc The locality where to copy from.
+/// @param remoteBase The pointer to the first element to copy from.
+/// @param stride The distance, in elements, between two elements of srcLoc.
+/// @param numElements Number of elements to copy.
+template <typename T>
+void dmaStrided(const T *localAddress, const Locality &srcLoc,
+                const T *remoteBase, const size_t stride,
+                const size_t numElements) {
+  impl::traceCall(impl::TraceOp::kDma, srcLoc, 0);
+  impl::traceReceived(srcLoc, numElements * sizeof(T));
+  impl::SynchronousInterface<TargetSystemTag>::dmaStrided(
+      localAddress, srcLoc, remoteBase, stride, numElements);
+}
+
+/// @brief Copies contiguous local data to a list of segments of a
+/// potentially remote locality, asynchronously.
+///
+/// The segments and the local data must stay valid until the handle has
+/// been waited for.
+///
+/// @tparam T type of the data to copy.
+/// @param handle An Handle for the associated task-group.
+/// @param destLoc The locality where to copy to.
+/// @param remoteSegments The segments of destLoc to copy to, in order.
+/// @param numSegments The number of segments.
+/// @param localData The pointer to the memory allocation to copy from.
+template <typename T>
+void asyncDmaScatter(Handle &handle, const Locality &destLoc,
+                     const DmaSegment<T> *remoteSegments,
+                     const size_t numSegments, const T *localData) {
+#if defined(SHAD_ENABLE_TRACING)
+  impl::Tracer::Instance().CountCall(impl::TraceOp::kAsyncDma,
+                                     static_cast<uint32_t>(thisLocality()));
+#endif
+  using args_t = std::tuple<const Locality, const DmaSegment<T> *,
+                            const size_t, const T *>;
+  args_t args(destLoc, remoteSegments, numSegments, localData);
+  asyncExecuteAt(handle, thisLocality(),
+        [](Handle &, const args_t &args) {
+          dmaScatter(std::get<0>(args), std::get<1>(args),
+                     std::get<2>(args), std::get<3>(args));
+        },
+        args);
+}
+
+/// @brief Copies a list of segments of a potentially remote locality to
+/// contiguous local memory, asynchronously.
+///
+/// The segments must stay valid until the handle has been waited for.
+///
+/// @tparam T type of the data to copy.
+/// @param handle An Handle for the associated task-group.
+/// @param localAddress The pointer to the local memory allocation.
+/// @param srcLoc The locality where to copy from.
+/// @param remoteSegments The segments of srcLoc to copy from, in order.
+/// @param numSegments The number of segments.
+template <typename T>
+void asyncDmaGather(Handle &handle, const T *localAddress,
+                    const Locality &srcLoc,
+                    const DmaSegment<T> *remoteSegments,
+                    const size_t numSegments) {
+#if defined(SHAD_ENABLE_TRACING)
+  impl::Tracer::Instance().CountCall(impl::TraceOp::kAsyncDma,
+                                     static_cast<uint32_t>(thisLocality()));
+#endif
+  using args_t = std::tuple<const T *, const Locality,
+                            const DmaSegment<T> *, const size_t>;
+  args_t args(localAddress, srcLoc, remoteSegments, numSegments);
+  asyncExecuteAt(handle, thisLocality(),
+        [](Handle &, const args_t &args) {
+          dmaGather(std::get<0>(args), std::get<1>(args),
+                    std::get<2>(args), std::get<3>(args));
+        },
+        args);
+}
+
+/// @brief Copies contiguous local data to strided elements of a potentially
+/// remote locality, asynchronously.
+///
+/// @tparam T type of the data to copy.
+/// @param handle An Handle for the associated task-group.
+/// @param destLoc The locality where to copy to.
+/// @param remoteBase The pointer to the first element to copy to.
+/// @param stride The distance, in elements, between two elements of destLoc.
+/// @param localData The pointer to the memory allocation to copy from.
+/// @param numElements Number of elements to copy.
+template <typename T>
+void asyncDmaStrided(Handle &handle, const Locality &destLoc,
+                     const T *remoteBase, const size_t stride,
+                     const T *localData, const size_t numElements) {
+#if defined(SHAD_ENABLE_TRACING)
+  impl::Tracer::Instance().CountCall(impl::TraceOp::kAsyncDma,
+                                     static_cast<uint32_t>(thisLocality()));
+#endif
+  using args_t = std::tuple<const Locality, const T *, const size_t,
+                            const T *, const size_t>;
+  args_t args(destLoc, remoteBase, stride, localData, numElements);
+  asyncExecuteAt(handle, thisLocality(),
+        [](Handle &, const args_t &args) {
+          dmaStrided(std::get<0>(args), std::get<1>(args), std::get<2>(args),
+                     std::get<3>(args), std::get<4>(args));
+        },
+        args);
+}
+
+/// @brief Copies strided elements of a potentially remote locality to
+/// contiguous local memory, asynchronously.
+///
+/// @tparam T type of the data to copy.
+/// @param handle An Handle for the associated task-group.
+/// @param localAddress The pointer to the local memory allocation.
+/// @param srcLoc The locality where to copy from.
+/// @param remoteBase The pointer to the first element to copy from.
+/// @param stride The distance, in elements, between two elements of srcLoc.
+/// @param numElements Number of elements to copy.
+template <typename T>
+void asyncDmaStrided(Handle &handle, const T *localAddress,
+                     const Locality &srcLoc, const T *remoteBase,
+                     const size_t stride, const size_t numElements) {
+#if defined(SHAD_ENABLE_TRACING)
+  impl::Tracer::Instance().CountCall(impl::TraceOp::kAsyncDma,
+                                     static_cast<uint32_t>(thisLocality()));
+#endif
+  using args_t = std::tuple<const T *, const Locality, const T *,
+                            const size_t, const size_t>;
+  args_t args(localAddress, srcLoc, remoteBase, stride, numElements);
+  asyncExecuteAt(handle, thisLocality(),
+        [](Handle &, const args_t &args) {
+          dmaStrided(std::get<0>(args), std::get<1>(args), std::get<2>(args),
+                     std::get<3>(args), std::get<4>(args));
+        },
+        args);
+}
+
+namespace impl {
+
+template <typename T>
+T atomic(const Locality &loc, const AtomicArgs<T> &args) {
+  traceCall(TraceOp::kAtomic, loc, sizeof(args));
+  traceReceived(loc, sizeof(T));
+  return SynchronousInterface<TargetSystemTag>::atomic(loc, args);
+}
+
+template <typename T>
+void asyncAtomic(Handle &handle, const Locality &loc,
+                 const AtomicArgs<T> &args, T *result) {
+  traceCall(TraceOp::kAsyncAtomic, loc, sizeof(args));
+  AsynchronousInterface<TargetSystemTag>::asyncAtomic(handle, loc, args,
+                                                      result);
+  if (result != nullptr)
+    traceReceivedOnCompletion(handle, loc, nullptr, sizeof(T));
+}
+
+}  // namespace impl
+
+/// @brief Atomically adds operand to a potentially remote integer.
+///
+/// The operation is executed by loc with a native atomic instruction.
+///
+/// @tparam T integral type of the target.
+/// @param loc The locality owning the target.
+/// @param remoteAddress The address of the target in the memory of loc.
+/// @param operand The operand.
+/// @return The value of the target before the operation.
+template <typename T>
+T atomicFetchAdd(const Locality &loc, T *remoteAddress, T operand) {
+  static_assert(std::is_integral<T>::value,
+                "atomicFetchAdd requires an integral type");
+  impl::AtomicArgs<T> args{impl::AtomicOp::kFetchAdd, remoteAddress, operand,
+                           T()};
+  return impl::atomic(loc, args);
+}
+
+/// @brief Atomically subtracts operand from a potentially remote integer.
+///
+/// The operation is executed by loc with a native atomic instruction.
+///
+/// @tparam T integral type of the target.
+/// @param loc The locality owning the target.
+/// @param remoteAddress The address of the target in the memory of loc.
+/// @param operand The operand.
+/// @return The value of the target before the operation.
+template <typename T>
+T atomicFetchSub(const Locality &loc, T *remoteAddress, T operand) {
+  static_assert(std::is_integral<T>::value,
+                "atomicFetchSub requires an integral type");
+  impl::AtomicArgs<T> args{impl::AtomicOp::kFetchSub, remoteAddress, operand,
+                           T()};
+  return impl::atomic(loc, args);
+}
+
+/// @brief Atomically ands operand into a potentially remote integer.
+///
+/// The operation is executed by loc with a native atomic instruction.
+///
+/// @tparam T integral type of the target.
+/// @param loc The locality owning the target.
+/// @param remoteAddress The address of the target in the memory of loc.
+/// @param operand The operand.
+/// @return The value of the target before the operation.
+template <typename T>
+T atomicFetchAnd(const Locality &loc, T *remoteAddress, T operand) {
+  static_assert(std::is_integral<T>::value,
+                "atomicFetchAnd requires an integral type");
+  impl::AtomicArgs<T> args{impl::AtomicOp::kFetchAnd, remoteAddress, operand,
+                           T()};
+  return impl::atomic(loc, args);
+}
+
+/// @brief Atomically ors operand into a potentially remote integer.
+///
+/// The operation is executed by loc with a native atomic instruction.
+///
+/// @tparam T integral type of the target.
+/// @param loc The locality owning the target.
+/// @param remoteAddress The address of the target in the memory of loc.
+/// @param operand The operand.
+/// @return The value of the target before the operation.
+template <typename T>
+T atomicFetchOr(const Locality &loc, T *remoteAddress, T operand) {
+  static_assert(std::is_integral<T>::value,
+                "atomicFetchOr requires an integral type");
+  impl::AtomicArgs<T> args{impl::AtomicOp::kFetchOr, remoteAddress, operand,
+                           T()};
+  return impl::atomic(loc, args);
+}
+
+/// @brief Atomically xors operand into a potentially remote integer.
+///
+/// The operation is executed by loc with a native atomic instruction.
+///
+/// @tparam T integral type of the target.
+/// @param loc The locality owning the target.
+/// @param remoteAddress The address of the target in the memory of loc.
+/// @param operand The operand.
+/// @return The value of the target before the operation.
+template <typename T>
+T atomicFetchXor(const Locality &loc, T *remoteAddress, T operand) {
+  static_assert(std::is_integral<T>::value,
+                "atomicFetchXor requires an integral type");
+  impl::AtomicArgs<T> args{impl::AtomicOp::kFetchXor, remoteAddress, operand,
+                           T()};
+  return impl::atomic(loc, args);
+}
+
+/// @brief Atomically replaces a potentially remote value with desired, if it
+/// is equal to expected.
+///
+/// @tparam T trivially copyable type of the target.
+/// @param loc The locality owning the target.
+/// @param remoteAddress The address of the target in the memory of loc.
+/// @param expected The value expected in the target.
+/// @param desired The value to store in the target.
+/// @return The value of the target before the operation: the exchange took
+/// place if it is equal to expected.
+template <typename T>
+T atomicCompareExchange(const Locality &loc, T *remoteAddress, T expected,
+                        T desired) {
+  impl::AtomicArgs<T> args{impl::AtomicOp::kCompareExchange, remoteAddress,
+                           desired, expected};
+  return impl::atomic(loc, args);
+}
+
+/// @brief Atomically adds operand to a potentially remote integer,
+/// asynchronously.
+///
+/// @tparam T integral type of the target.
+/// @param handle An Handle for the associated task-group.
+/// @param loc The locality owning the target.
+/// @param remoteAddress The address of the target in the memory of loc.
+/// @param operand The operand.
+/// @param result Receives the value of the target before the operation
+/// (can be nullptr).
+template <typename T>
+void asyncAtomicFetchAdd(Handle &handle, const Locality &loc,
+                         T *remoteAddress, T operand, T *result = nullptr) {
+  static_assert(std::is_integral<T>::value,
+                "asyncAtomicFetchAdd requires an integral type");
+  impl::AtomicArgs<T> args{impl::AtomicOp::kFetchAdd, remoteAddress, operand,
+                           T()};
+  impl::asyncAtomic(handle, loc, args, result);
+}
+
+/// @brief Atomically subtracts operand from a potentially remote integer,
+/// asynchronously.
+///
+/// @tparam T integral type of the target.
+/// @param handle An Handle for the associated task-group.
+/// @param loc The locality owning the target.
+/// @param remoteAddress The address of the target in the memory of loc.
+/// @param operand The operand.
+/// @param result Receives the value of the target before the operation
+/// (can be nullptr).
+template <typename T>
+void asyncAtomicFetchSub(Handle &handle, const Locality &loc,
+                         T *remoteAddress, T operand, T *result = nullptr) {
+  static_assert(std::is_integral<T>::value,
+                "asyncAtomicFetchSub requires an integral type");
+  impl::AtomicArgs<T> args{impl::AtomicOp::kFetchSub, remoteAddress, operand,
+                           T()};
+  impl::asyncAtomic(handle, loc, args, result);
+}
+
+/// @brief Atomically ands operand into a potentially remote integer,
+/// asynchronously.
+///
+/// @tparam T integral type of the target.
+/// @param handle An Handle for the associated task-group.
+/// @param loc The locality owning the target.
+/// @param remoteAddress The address of the target in the memory of loc.
+/// @param operand The operand.
+/// @param result Receives the value of the target before the operation
+/// (can be nullptr).
+template <typename T>
+void asyncAtomicFetchAnd(Handle &handle, const Locality &loc,
+                         T *remoteAddress, T operand, T *result = nullptr) {
+  static_assert(std::is_integral<T>::value,
+                "asyncAtomicFetchAnd requires an integral type");
+  impl::AtomicArgs<T> args{impl::AtomicOp::kFetchAnd, remoteAddress, operand,
+                           T()};
+  impl::asyncAtomic(handle, loc, args, result);
+}
+
+/// @brief Atomically ors operand into a potentially remote integer,
+/// asynchronously.
+///
+/// @tparam T integral type of the target.
+/// @param handle An Handle for the associated task-group.
+/// @param loc The locality owning the target.
+/// @param remoteAddress The address of the target in the memory of loc.
+/// @param operand The operand.
+/// @param result Receives the value of the target before the operation
+/// (can be nullptr).
+template <typename T>
+void asyncAtomicFetchOr(Handle &handle, const Locality &loc,
+                        T *remoteAddress, T operand, T *result = nullptr) {
+  static_assert(std::is_integral<T>::value,
+                "asyncAtomicFetchOr requires an integral type");
+  impl::AtomicArgs<T> args{impl::AtomicOp::kFetchOr, remoteAddress, operand,
+                           T()};
+  impl::asyncAtomic(handle, loc, args, result);
+}
+
+/// @brief Atomically xors operand into a potentially remote integer,
+/// asynchronously.
+///
+/// @tparam T integral type of the target.
+/// @param handle An Handle for the associated task-group.
+/// @param loc The locality owning the target.
+/// @param remoteAddress The address of the target in the memory of loc.
+/// @param operand The operand.
+/// @param result Receives the value of the target before the operation
+/// (can be nullptr).
+template <typename T>
+void asyncAtomicFetchXor(Handle &handle, const Locality &loc,
+                         T *remoteAddress, T operand, T *result = nullptr) {
+  static_assert(std::is_integral<T>::value,
+                "asyncAtomicFetchXor requires an integral type");
+  impl::AtomicArgs<T> args{impl::AtomicOp::kFetchXor, remoteAddress, operand,
+                           T()};
+  impl::asyncAtomic(handle, loc, args, result);
+}
+
+/// @brief Atomically replaces a potentially remote value with desired, if it
+/// is equal to expected, asynchronously.
+///
+/// @tparam T trivially copyable type of the target.
+/// @param handle An Handle for the associated task-group.
+/// @param loc The locality owning the target.
+/// @param remoteAddress The address of the target in the memory of loc.
+/// @param expected The value expected in the target.
+/// @param desired The value to store in the target.
+/// @param result Receives the value of the target before the operation
+/// (can be nullptr).
+template <typename T>
+void asyncAtomicCompareExchange(Handle &handle, const Locality &loc,
+                                T *remoteAddress, T expected, T desired,
+                                T *result = nullptr) {
+  impl::AtomicArgs<T> args{impl::AtomicOp::kCompareExchange, remoteAddress,
+                           desired, expected};
+  impl::asyncAtomic(handle, loc, args, result);
+}
+
 /// @brief Wait for completion of a set of tasks
 inline void waitForCompletion(Handle &handle) {
+  // Tasks coalesced here need not wait for their flush task.
+  if (impl::Coalescer::IsEnabled()) impl::Coalescer::Instance().Flush(handle);
   impl::HandleTrait<TargetSystemTag>::WaitFor(handle.id_);
+  impl::traceCompleted(handle);
 }
+
+namespace impl {
+
+/// @brief Write the traces of all the localities.
+///
+/// The recording is paused everywhere first; then the bytes sent by every
+/// locality are reported to their destinations, and each locality writes its
+/// own files.
+inline void exportTraces() {
+#if defined(SHAD_ENABLE_TRACING)
+  struct ReceivedArgs {
+    uint32_t src;
+    uint64_t numBytes;
+  };
+
+  Tracer::Instance().Pause(true);
+  executeOnAll([](const bool &paused) { Tracer::Instance().Pause(paused); },
+               true);
+  executeOnAll(
+      [](const bool &) {
+        Tracer::Instance().PublishSent(
+            RuntimeInternalsTrait<TargetSystemTag>::ThisLocality(),
+            [](uint32_t dst, uint32_t src, uint64_t numBytes) {
+              // Calls to localities that do not exist fail, but are counted.
+              if (dst >= numLocalities()) return;
+              executeAt(Locality(dst),
+                        [](const ReceivedArgs &args) {
+                          Tracer::Instance().RecordReceived(
+                              RuntimeInternalsTrait<
+                                  TargetSystemTag>::ThisLocality(),
+                              args.src, args.numBytes);
+                        },
+                        ReceivedArgs{src, numBytes});
+            });
+      },
+      true);
+  executeOnAll(
+      [](const bool &) {
+        Tracer::Instance().Export(
+            RuntimeInternalsTrait<TargetSystemTag>::ThisLocality());
+      },
+      true);
+#endif
+}
+
+}  // namespace impl
 /// @}
 
 }  // namespace rt
@@ -0,0 +1,675 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#ifndef INCLUDE_SHAD_RUNTIME_SCHEDULING_POLICY_H_
+#define INCLUDE_SHAD_RUNTIME_SCHEDULING_POLICY_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "shad/runtime/runtime.h"
+
+namespace shad {
+namespace rt {
+
+/// @brief How the iterations of a parallel loop are split in chunks.
+///
+/// The iterations of a chunk are executed in sequence by the same worker,
+/// and chunks are distributed to the workers by the runtime.  Policies are
+/// applied by every locality to the iterations it executes.
+///
+/// Typical Usage:
+/// @code
+/// forEachAt(locality, task, args, numIters, SchedulingPolicy::Dynamic(64));
+/// @endcode
+class SchedulingPolicy {
+ public:
+  enum class Kind : uint8_t {
+    /// One contiguous chunk per worker.
+    kStatic,
+    /// Chunks of a fixed number of iterations.
+    kDynamic,
+    /// Chunks of decreasing size, down to a minimum number of iterations.
+    kGuided,
+    /// Chunks sized from the measured cost of the first iterations.
+    kAuto
+  };
+
+  /// @brief Split the iterations in one chunk per worker.
+  static SchedulingPolicy Static() {
+    return SchedulingPolicy(Kind::kStatic, 1);
+  }
+
+  /// @brief Split the iterations in chunks of grain iterations.
+  static SchedulingPolicy Dynamic(size_t grain) {
+    return SchedulingPolicy(Kind::kDynamic, std::max<size_t>(grain, 1));
+  }
+
+  /// @brief Split the iterations in chunks of decreasing size.
+  ///
+  /// The first half of the iterations is split in one chunk per worker, the
+  /// following quarter in one chunk per worker, and so on, until chunks
+  /// would be smaller than minGrain iterations.
+  static SchedulingPolicy Guided(size_t minGrain = 1) {
+    return SchedulingPolicy(Kind::kGuided, std::max<size_t>(minGrain, 1));
+  }
+
+  /// @brief Size the chunks from the measured cost of an iteration.
+  ///
+  /// The first iterations are executed in sequence to measure their cost,
+  /// and the remaining ones are split in chunks of about kAutoChunkTime.
+  static SchedulingPolicy Auto() { return SchedulingPolicy(Kind::kAuto, 1); }
+
+  /// Target execution time of a chunk of the Auto policy.
+  static constexpr std::chrono::microseconds kAutoChunkTime{50};
+
+  Kind Type() const { return kind_; }
+
+  /// @brief The (minimum) number of iterations of a chunk.
+  size_t Grain() const { return grain_; }
+
+ private:
+  SchedulingPolicy(Kind kind, size_t grain) : kind_(kind), grain_(grain) {}
+
+  Kind kind_;
+  size_t grain_;
+};
+
+namespace impl {
+
+/// @brief The chunks of a parallel loop over [begin, end).
+///
+/// Chunks are computed in constant time from their index, so that they can
+/// be handed out by the parallel loops of the runtime.
+class LoopSchedule {
+ public:
+  LoopSchedule(const SchedulingPolicy &policy, size_t begin, size_t end,
+               size_t concurrency)
+      : kind_(policy.Type()),
+        begin_(begin),
+        numIters_(end - begin),
+        parts_(std::max<size_t>(concurrency, 1)),
+        grain_(policy.Grain()),
+        numLevels_(0) {
+    switch (kind_) {
+      case SchedulingPolicy::Kind::kStatic:
+        parts_ = std::min(parts_, numIters_);
+        numChunks_ = parts_;
+        break;
+      case SchedulingPolicy::Kind::kGuided:
+        while (numLevels_ < 63 && numIters_ >> numLevels_ != 0 &&
+               LevelSize(numLevels_) / parts_ >= grain_)
+          ++numLevels_;
+        numChunks_ = numLevels_ * parts_ +
+                     ((numIters_ >> numLevels_) + grain_ - 1) / grain_;
+        break;
+      default:
+        kind_ = SchedulingPolicy::Kind::kDynamic;
+        numChunks_ = (numIters_ + grain_ - 1) / grain_;
+        break;
+    }
+  }
+
+  size_t NumChunks() const { return numChunks_; }
+
+  /// @brief The [begin, end) iterations of a chunk.
+  std::pair<size_t, size_t> Chunk(size_t chunk) const {
+    size_t offset = 0, size = numIters_;
+    if (kind_ == SchedulingPolicy::Kind::kStatic) {
+      return Part(0, numIters_, parts_, chunk);
+    } else if (kind_ == SchedulingPolicy::Kind::kGuided) {
+      size_t level = chunk / parts_;
+      if (level < numLevels_)
+        return Part(numIters_ - (numIters_ >> level), LevelSize(level), parts_,
+                    chunk % parts_);
+      chunk -= numLevels_ * parts_;
+      offset = numIters_ - (numIters_ >> numLevels_);
+      size = numIters_ >> numLevels_;
+    }
+    size_t first = std::min(chunk * grain_, size);
+    size_t last = std::min(first + grain_, size);
+    return std::make_pair(begin_ + offset + first, begin_ + offset + last);
+  }
+
+ private:
+  // The iterations of a level of the guided schedule.
+  size_t LevelSize(size_t level) const {
+    return (numIters_ >> level) - (numIters_ >> (level + 1));
+  }
+
+  // Part i of n balanced parts of [begin_ + offset, begin_ + offset + size).
+  std::pair<size_t, size_t> Part(size_t offset, size_t size, size_t n,
+                                 size_t i) const {
+    size_t quotient = size / n, remainder = size % n;
+    size_t first = i * quotient + std::min(i, remainder);
+    size_t last = first + quotient + (i < remainder ? 1 : 0);
+    return std::make_pair(begin_ + offset + first, begin_ + offset + last);
+  }
+
+  SchedulingPolicy::Kind kind_;
+  size_t begin_;
+  size_t numIters_;
+  size_t parts_;
+  size_t grain_;
+  size_t numLevels_;
+  size_t numChunks_;
+};
+
+/// @brief Measure the cost of the first iterations of [*begin, end) and
+/// compute the grain of the Auto policy.
+///
+/// The iterations measured are executed through run and removed from the
+/// range.  At most 1 / (4 * concurrency) of the iterations are measured.
+template <typename RunT>
+size_t autoTuneGrain(RunT &&run, size_t *begin, size_t end,
+                     size_t concurrency) {
+  using Clock = std::chrono::steady_clock;
+  const auto target =
+      std::chrono::duration_cast<Clock::duration>(
+          SchedulingPolicy::kAutoChunkTime) /
+      4;
+  size_t limit = std::max<size_t>((end - *begin) / (4 * concurrency), 1);
+
+  size_t measured = 0, probe = 1;
+  Clock::duration elapsed(0);
+  while (*begin != end && measured < limit && elapsed < target) {
+    size_t last = *begin + std::min(probe, std::min(limit - measured,
+                                                    end - *begin));
+    auto start = Clock::now();
+    run(*begin, last);
+    elapsed += Clock::now() - start;
+    measured += last - *begin;
+    *begin = last;
+    probe *= 2;
+  }
+
+  // Every worker gets at least a chunk of the remaining iterations.
+  size_t maxGrain = std::max<size_t>((end - *begin) / concurrency, 1);
+  if (elapsed.count() == 0) return maxGrain;
+  auto grain = static_cast<size_t>(
+      std::chrono::duration_cast<Clock::duration>(
+          SchedulingPolicy::kAutoChunkTime)
+          .count() *
+      measured / elapsed.count());
+  return std::min(std::max<size_t>(grain, 1), maxGrain);
+}
+
+/// @brief Where the iterations executed by a locality come from.
+///
+/// By default, a locality executes the iterations of its slice of the loop.
+/// A placement can instead skip the iterations owned by other localities,
+/// or number contiguously the blocks of iterations cyclically assigned to
+/// the locality.
+struct LoopPlacement {
+  /// When not null, the iterations i with owner(i) != thisLocality() are
+  /// skipped.
+  uint32_t (*owner)(size_t);
+  /// When not zero, iteration j of the locality is the (j % blockSize)-th
+  /// iteration of its (j / blockSize)-th block.
+  size_t blockSize;
+  /// The iterations of the whole loop, when blockSize is not zero.
+  size_t numIters;
+
+  /// @brief The number of iterations executed by a locality.
+  size_t LocalIters(size_t locality, size_t numLocalities) const {
+    size_t numBlocks = (numIters + blockSize - 1) / blockSize;
+    if (locality >= numBlocks) return 0;
+    size_t localBlocks = (numBlocks - locality - 1) / numLocalities + 1;
+    size_t localIters = localBlocks * blockSize;
+    if ((numBlocks - 1) % numLocalities == locality)
+      localIters -= numBlocks * blockSize - numIters;
+    return localIters;
+  }
+
+  /// @brief Call run on the maximal ranges of loop iterations corresponding
+  /// to the [begin, end) iterations of the calling locality.
+  template <typename RunT>
+  void ForEachRun(size_t begin, size_t end, RunT &&run) const {
+    if (blockSize != 0) {
+      size_t locality = static_cast<uint32_t>(thisLocality());
+      size_t stride = numLocalities() * blockSize;
+      while (begin < end) {
+        size_t offset = begin % blockSize;
+        size_t length = std::min(blockSize - offset, end - begin);
+        size_t first =
+            (begin / blockSize) * stride + locality * blockSize + offset;
+        run(first, first + length);
+        begin += length;
+      }
+    } else if (owner != nullptr) {
+      uint32_t locality = static_cast<uint32_t>(thisLocality());
+      while (begin < end) {
+        while (begin < end && owner(begin) != locality) ++begin;
+        size_t last = begin;
+        while (last < end && owner(last) == locality) ++last;
+        if (begin != last) run(begin, last);
+        begin = last;
+      }
+    } else {
+      run(begin, end);
+    }
+  }
+};
+
+template <typename InArgsT>
+struct LoopArgs {
+  void (*function)();
+  bool ranged;
+  bool onAll;
+  SchedulingPolicy policy;
+  size_t begin;
+  size_t end;
+  LoopPlacement placement;
+  InArgsT args;
+};
+
+template <typename InArgsT>
+struct LoopChunkArgs {
+  void (*function)();
+  bool ranged;
+  LoopSchedule schedule;
+  LoopPlacement placement;
+  InArgsT args;
+};
+
+template <typename InArgsT>
+void runLoopRange(const LoopChunkArgs<InArgsT> &loop, size_t begin,
+                  size_t end) {
+  loop.placement.ForEachRun(begin, end, [&](size_t first, size_t last) {
+    if (loop.ranged) {
+      using FunctionTy = void (*)(const InArgsT &, size_t, size_t);
+      reinterpret_cast<FunctionTy>(loop.function)(loop.args, first, last);
+    } else {
+      using FunctionTy = void (*)(const InArgsT &, size_t);
+      auto function = reinterpret_cast<FunctionTy>(loop.function);
+      for (size_t i = first; i < last; ++i) function(loop.args, i);
+    }
+  });
+}
+
+template <typename InArgsT>
+void asyncRunLoopRange(Handle &handle, const LoopChunkArgs<InArgsT> &loop,
+                       size_t begin, size_t end) {
+  loop.placement.ForEachRun(begin, end, [&](size_t first, size_t last) {
+    if (loop.ranged) {
+      using FunctionTy = void (*)(Handle &, const InArgsT &, size_t, size_t);
+      reinterpret_cast<FunctionTy>(loop.function)(handle, loop.args, first,
+                                                  last);
+    } else {
+      using FunctionTy = void (*)(Handle &, const InArgsT &, size_t);
+      auto function = reinterpret_cast<FunctionTy>(loop.function);
+      for (size_t i = first; i < last; ++i) function(handle, loop.args, i);
+    }
+  });
+}
+
+template <typename InArgsT>
+void loopChunkTask(const LoopChunkArgs<InArgsT> &loop, size_t chunk) {
+  auto range = loop.schedule.Chunk(chunk);
+  runLoopRange(loop, range.first, range.second);
+}
+
+template <typename InArgsT>
+void asyncLoopChunkTask(Handle &handle, const LoopChunkArgs<InArgsT> &loop,
+                        size_t chunk) {
+  auto range = loop.schedule.Chunk(chunk);
+  asyncRunLoopRange(handle, loop, range.first, range.second);
+}
+
+/// @brief The iterations of a loop executed by this locality.
+template <typename InArgsT>
+std::pair<size_t, size_t> loopSlice(const LoopArgs<InArgsT> &loop) {
+  size_t n = numLocalities();
+  size_t i = static_cast<uint32_t>(thisLocality());
+  if (loop.placement.blockSize != 0)
+    return std::make_pair(size_t(0), loop.placement.LocalIters(i, n));
+  if (!loop.onAll) return std::make_pair(loop.begin, loop.end);
+  size_t numIters = loop.end - loop.begin;
+  size_t quotient = numIters / n, remainder = numIters % n;
+  size_t first = loop.begin + i * quotient + std::min(i, remainder);
+  return std::make_pair(first, first + quotient + (i < remainder ? 1 : 0));
+}
+
+template <typename InArgsT, typename RunT>
+LoopChunkArgs<InArgsT> scheduleLoop(const LoopArgs<InArgsT> &loop,
+                                    RunT &&run) {
+  auto slice = loopSlice(loop);
+  size_t concurrency = std::max<size_t>(getConcurrency(), 1);
+  SchedulingPolicy policy = loop.policy;
+  if (policy.Type() == SchedulingPolicy::Kind::kAuto) {
+    size_t grain =
+        autoTuneGrain(std::forward<RunT>(run), &slice.first, slice.second,
+                      concurrency);
+    policy = SchedulingPolicy::Dynamic(grain);
+  }
+  return LoopChunkArgs<InArgsT>{
+      loop.function, loop.ranged,
+      LoopSchedule(policy, slice.first, slice.second, concurrency),
+      loop.placement, loop.args};
+}
+
+template <typename InArgsT>
+void loopTask(const LoopArgs<InArgsT> &loop) {
+  LoopChunkArgs<InArgsT> probe{loop.function, loop.ranged,
+                               LoopSchedule(loop.policy, 0, 0, 1),
+                               loop.placement, loop.args};
+  auto chunks = scheduleLoop(loop, [&](size_t begin, size_t end) {
+    runLoopRange(probe, begin, end);
+  });
+  forEachAt(thisLocality(), loopChunkTask<InArgsT>, chunks,
+            chunks.schedule.NumChunks());
+}
+
+template <typename InArgsT>
+void asyncLoopTask(Handle &handle, const LoopArgs<InArgsT> &loop) {
+  LoopChunkArgs<InArgsT> probe{loop.function, loop.ranged,
+                               LoopSchedule(loop.policy, 0, 0, 1),
+                               loop.placement, loop.args};
+  auto chunks = scheduleLoop(loop, [&](size_t begin, size_t end) {
+    asyncRunLoopRange(handle, probe, begin, end);
+  });
+  asyncForEachAt(handle, thisLocality(), asyncLoopChunkTask<InArgsT>, chunks,
+                 chunks.schedule.NumChunks());
+}
+
+template <typename FunctionTy, typename InArgsT>
+LoopArgs<InArgsT> makeLoopArgs(FunctionTy function, bool ranged, bool onAll,
+                               const SchedulingPolicy &policy,
+                               size_t numIters, const InArgsT &args) {
+  return LoopArgs<InArgsT>{reinterpret_cast<void (*)()>(function),
+                           ranged,
+                           onAll,
+                           policy,
+                           0,
+                           numIters,
+                           LoopPlacement{nullptr, 0, 0},
+                           args};
+}
+
+}  // namespace impl
+
+/// @brief Execute a parallel loop at a specific locality, with a scheduling
+/// policy.
+///
+/// Typical Usage:
+/// @code
+/// forEachAt(locality,
+///     [](const Args & input, size_t itrNum) {
+///         // Do something.
+///     },
+///     args, iterations, SchedulingPolicy::Guided(16));
+/// @endcode
+///
+/// @tparam FunT The type of the function to be executed.  The function
+/// prototype must be:
+/// @code
+/// void(const ArgsT &, size_t itrNum);
+/// @endcode
+/// where the itrNum is the n-th iteration of the loop.
+///
+/// @tparam InArgsT The type of the argument accepted by the function.  The type
+/// can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @param loc The Locality where the function must be executed.
+/// @param func The function to execute.
+/// @param args The arguments to be passed to the function.
+/// @param numIters The total number of iteration of the loop.
+/// @param policy How the iterations are split in chunks.
+template <typename FunT, typename InArgsT>
+void forEachAt(const Locality &loc, FunT &&func, const InArgsT &args,
+               const size_t numIters, const SchedulingPolicy &policy) {
+  using FunctionTy = void (*)(const InArgsT &, size_t);
+  FunctionTy fn = std::forward<decltype(func)>(func);
+  executeAt(loc, impl::loopTask<InArgsT>,
+            impl::makeLoopArgs(fn, false, false, policy, numIters, args));
+}
+
+/// @brief Execute a parallel loop on the whole system, with a scheduling
+/// policy.
+///
+/// The iterations are split in contiguous blocks among the localities, and
+/// every locality applies the policy to its block.
+///
+/// @tparam FunT The type of the function to be executed.  The function
+/// prototype must be:
+/// @code
+/// void(const ArgsT &, size_t itrNum);
+/// @endcode
+/// where the itrNum is the n-th iteration of the loop.
+///
+/// @tparam InArgsT The type of the argument accepted by the function.  The type
+/// can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @param func The function to execute.
+/// @param args The arguments to be passed to the function.
+/// @param numIters The total number of iteration of the loop.
+/// @param policy How the iterations are split in chunks.
+template <typename FunT, typename InArgsT>
+void forEachOnAll(FunT &&func, const InArgsT &args, const size_t numIters,
+                  const SchedulingPolicy &policy) {
+  using FunctionTy = void (*)(const InArgsT &, size_t);
+  FunctionTy fn = std::forward<decltype(func)>(func);
+  executeOnAll(impl::loopTask<InArgsT>,
+               impl::makeLoopArgs(fn, false, true, policy, numIters, args));
+}
+
+/// @brief Execute asynchronously a parallel loop at a specific locality,
+/// with a scheduling policy.
+///
+/// @tparam FunT The type of the function to be executed.  The function
+/// prototype must be:
+/// @code
+/// void(Handle &, const ArgsT &, size_t itrNum);
+/// @endcode
+/// where the itrNum is the n-th iteration of the loop.
+///
+/// @tparam InArgsT The type of the argument accepted by the function.  The type
+/// can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @param handle An Handle for the associated task-group.
+/// @param loc The Locality where the function must be executed.
+/// @param func The function to execute.
+/// @param args The arguments to be passed to the function.
+/// @param numIters The total number of iteration of the loop.
+/// @param policy How the iterations are split in chunks.
+template <typename FunT, typename InArgsT>
+void asyncForEachAt(Handle &handle, const Locality &loc, FunT &&func,
+                    const InArgsT &args, const size_t numIters,
+                    const SchedulingPolicy &policy) {
+  using FunctionTy = void (*)(Handle &, const InArgsT &, size_t);
+  FunctionTy fn = std::forward<decltype(func)>(func);
+  asyncExecuteAt(handle, loc, impl::asyncLoopTask<InArgsT>,
+                 impl::makeLoopArgs(fn, false, false, policy, numIters, args));
+}
+
+/// @brief Execute asynchronously a parallel loop on the whole system, with a
+/// scheduling policy.
+///
+/// @tparam FunT The type of the function to be executed.  The function
+/// prototype must be:
+/// @code
+/// void(Handle &, const ArgsT &, size_t itrNum);
+/// @endcode
+/// where the itrNum is the n-th iteration of the loop.
+///
+/// @tparam InArgsT The type of the argument accepted by the function.  The type
+/// can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @param handle An Handle for the associated task-group.
+/// @param func The function to execute.
+/// @param args The arguments to be passed to the function.
+/// @param numIters The total number of iteration of the loop.
+/// @param policy How the iterations are split in chunks.
+template <typename FunT, typename InArgsT>
+void asyncForEachOnAll(Handle &handle, FunT &&func, const InArgsT &args,
+                       const size_t numIters, const SchedulingPolicy &policy) {
+  using FunctionTy = void (*)(Handle &, const InArgsT &, size_t);
+  FunctionTy fn = std::forward<decltype(func)>(func);
+  asyncExecuteOnAll(handle, impl::asyncLoopTask<InArgsT>,
+                    impl::makeLoopArgs(fn, false, true, policy, numIters,
+                                       args));
+}
+
+/// @brief Execute a parallel loop at a specific locality, passing chunks of
+/// iterations to the function.
+///
+/// Loops with tiny bodies amortize the cost of a call over a whole chunk,
+/// and the body can be vectorized by the compiler.
+///
+/// Typical Usage:
+/// @code
+/// forEachRangeAt(locality,
+///     [](const Args & input, size_t begin, size_t end) {
+///         for (size_t i = begin; i < end; ++i) /* Do something. */;
+///     },
+///     args, iterations);
+/// @endcode
+///
+/// @tparam FunT The type of the function to be executed.  The function
+/// prototype must be:
+/// @code
+/// void(const ArgsT &, size_t begin, size_t end);
+/// @endcode
+/// where [begin, end) are the iterations of the chunk.
+///
+/// @tparam InArgsT The type of the argument accepted by the function.  The type
+/// can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @param loc The Locality where the function must be executed.
+/// @param func The function to execute.
+/// @param args The arguments to be passed to the function.
+/// @param numIters The total number of iteration of the loop.
+/// @param policy How the iterations are split in chunks.
+template <typename FunT, typename InArgsT>
+void forEachRangeAt(const Locality &loc, FunT &&func, const InArgsT &args,
+                    const size_t numIters,
+                    const SchedulingPolicy &policy = SchedulingPolicy::Auto()) {
+  using FunctionTy = void (*)(const InArgsT &, size_t, size_t);
+  FunctionTy fn = std::forward<decltype(func)>(func);
+  executeAt(loc, impl::loopTask<InArgsT>,
+            impl::makeLoopArgs(fn, true, false, policy, numIters, args));
+}
+
+/// @brief Execute a parallel loop on the whole system, passing chunks of
+/// iterations to the function.
+///
+/// @tparam FunT The type of the function to be executed.  The function
+/// prototype must be:
+/// @code
+/// void(const ArgsT &, size_t begin, size_t end);
+/// @endcode
+/// where [begin, end) are the iterations of the chunk.
+///
+/// @tparam InArgsT The type of the argument accepted by the function.  The type
+/// can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @param func The function to execute.
+/// @param args The arguments to be passed to the function.
+/// @param numIters The total number of iteration of the loop.
+/// @param policy How the iterations are split in chunks.
+template <typename FunT, typename InArgsT>
+void forEachRangeOnAll(
+    FunT &&func, const InArgsT &args, const size_t numIters,
+    const SchedulingPolicy &policy = SchedulingPolicy::Auto()) {
+  using FunctionTy = void (*)(const InArgsT &, size_t, size_t);
+  FunctionTy fn = std::forward<decltype(func)>(func);
+  executeOnAll(impl::loopTask<InArgsT>,
+               impl::makeLoopArgs(fn, true, true, policy, numIters, args));
+}
+
+/// @brief Execute asynchronously a parallel loop at a specific locality,
+/// passing chunks of iterations to the function.
+///
+/// @tparam FunT The type of the function to be executed.  The function
+/// prototype must be:
+/// @code
+/// void(Handle &, const ArgsT &, size_t begin, size_t end);
+/// @endcode
+/// where [begin, end) are the iterations of the chunk.
+///
+/// @tparam InArgsT The type of the argument accepted by the function.  The type
+/// can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @param handle An Handle for the associated task-group.
+/// @param loc The Locality where the function must be executed.
+/// @param func The function to execute.
+/// @param args The arguments to be passed to the function.
+/// @param numIters The total number of iteration of the loop.
+/// @param policy How the iterations are split in chunks.
+template <typename FunT, typename InArgsT>
+void asyncForEachRangeAt(
+    Handle &handle, const Locality &loc, FunT &&func, const InArgsT &args,
+    const size_t numIters,
+    const SchedulingPolicy &policy = SchedulingPolicy::Auto()) {
+  using FunctionTy = void (*)(Handle &, const InArgsT &, size_t, size_t);
+  FunctionTy fn = std::forward<decltype(func)>(func);
+  asyncExecuteAt(handle, loc, impl::asyncLoopTask<InArgsT>,
+                 impl::makeLoopArgs(fn, true, false, policy, numIters, args));
+}
+
+/// @brief Execute asynchronously a parallel loop on the whole system,
+/// passing chunks of iterations to the function.
+///
+/// @tparam FunT The type of the function to be executed.  The function
+/// prototype must be:
+/// @code
+/// void(Handle &, const ArgsT &, size_t begin, size_t end);
+/// @endcode
+/// where [begin, end) are the iterations of the chunk.
+///
+/// @tparam InArgsT The type of the argument accepted by the function.  The type
+/// can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @param handle An Handle for the associated task-group.
+/// @param func The function to execute.
+/// @param args The arguments to be passed to the function.
+/// @param numIters The total number of iteration of the loop.
+/// @param policy How the iterations are split in chunks.
+template <typename FunT, typename InArgsT>
+void asyncForEachRangeOnAll(
+    Handle &handle, FunT &&func, const InArgsT &args, const size_t numIters,
+    const SchedulingPolicy &policy = SchedulingPolicy::Auto()) {
+  using FunctionTy = void (*)(Handle &, const InArgsT &, size_t, size_t);
+  FunctionTy fn = std::forward<decltype(func)>(func);
+  asyncExecuteOnAll(handle, impl::asyncLoopTask<InArgsT>,
+                    impl::makeLoopArgs(fn, true, true, policy, numIters,
+                                       args));
+}
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_SCHEDULING_POLICY_H_
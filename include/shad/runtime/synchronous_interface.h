@@ -29,6 +29,8 @@
 #include <cstdint>
 #include <memory>
 
+#include "shad/runtime/atomics.h"
+#include "shad/runtime/dma.h"
 #include "shad/runtime/locality.h"
 
 namespace shad {
@@ -101,7 +103,29 @@ struct SynchronousInterface {
   template <typename T>
   static void dma(const T* localAddress, const Locality &srcLoc,
                   const T* remoteData, const size_t numElements);
-  
+
+  template <typename T>
+  static void dmaScatter(const Locality &destLoc,
+                         const DmaSegment<T> *remoteSegments,
+                         const size_t numSegments, const T *localData);
+
+  template <typename T>
+  static void dmaGather(const T *localAddress, const Locality &srcLoc,
+                        const DmaSegment<T> *remoteSegments,
+                        const size_t numSegments);
+
+  template <typename T>
+  static void dmaStrided(const Locality &destLoc, const T *remoteBase,
+                         const size_t stride, const T *localData,
+                         const size_t numElements);
+
+  template <typename T>
+  static void dmaStrided(const T *localAddress, const Locality &srcLoc,
+                         const T *remoteBase, const size_t stride,
+                         const size_t numElements);
+
+  template <typename T>
+  static T atomic(const Locality &loc, const AtomicArgs<T> &args);
   };
 
 }  // namespace impl
@@ -0,0 +1,340 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#ifndef INCLUDE_SHAD_RUNTIME_TASK_ARENA_H_
+#define INCLUDE_SHAD_RUNTIME_TASK_ARENA_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+/// @brief Size-class allocator for task closures and argument buffers.
+///
+/// Blocks are rounded up to a power of two between kMinBlockBytes and
+/// kMaxBlockBytes, and recycled through per-thread free lists, so that the
+/// workers spawning and running tasks at a high rate do not go through the
+/// system allocator.  A thread caching too many blocks of a class returns a
+/// batch of them to a shared pool, where threads that mostly allocate (e.g.
+/// the ones receiving messages) find them.  Larger blocks are served by
+/// operator new.
+///
+/// Blocks can be released by any thread.
+class TaskArena {
+ public:
+  /// Size of the smallest class.
+  static constexpr size_t kMinBlockBytes = 64;
+  /// Number of size classes: from 64 B to 64 KB.
+  static constexpr size_t kNumClasses = 11;
+  /// Size of the largest class.
+  static constexpr size_t kMaxBlockBytes = kMinBlockBytes << (kNumClasses - 1);
+  /// Bytes of every class cached by a thread before returning blocks to the
+  /// shared pool.
+  static constexpr size_t kMaxThreadBytes = 1 << 20;
+  /// Bytes of every class kept in the shared pool.
+  static constexpr size_t kMaxSharedBytes = 16 << 20;
+
+  /// @brief Allocate a block of at least size bytes, aligned as
+  /// std::max_align_t.
+  static void *Allocate(size_t size) {
+    uint32_t sizeClass = SizeClass(size);
+    Block *block = nullptr;
+    if (sizeClass == kNumClasses) {
+      block = static_cast<Block *>(::operator new(sizeof(Block) + size));
+    } else {
+      auto &list = tlsLists_[sizeClass];
+      if (list.head == nullptr) Refill(sizeClass);
+      if (list.head != nullptr) {
+        block = list.head;
+        list.head = block->next;
+        --list.count;
+      } else {
+        block = static_cast<Block *>(
+            ::operator new(sizeof(Block) + ClassBytes(sizeClass)));
+      }
+    }
+    block->sizeClass = sizeClass;
+    return block + 1;
+  }
+
+  /// @brief Release a block returned by Allocate.
+  static void Deallocate(void *ptr) {
+    if (ptr == nullptr) return;
+    Block *block = static_cast<Block *>(ptr) - 1;
+    uint32_t sizeClass = block->sizeClass;
+    if (sizeClass == kNumClasses || tlsExited_) {
+      ::operator delete(block);
+      return;
+    }
+
+    auto &list = tlsLists_[sizeClass];
+    if (list.head == nullptr) RegisterThread();
+    block->next = list.head;
+    list.head = block;
+    if (++list.count > MaxThreadBlocks(sizeClass)) Spill(sizeClass);
+  }
+
+  /// @brief Construct an object in a block of the arena.
+  ///
+  /// Over-aligned objects do not fit the alignment of the blocks: they are
+  /// allocated with the aligned operator new instead.
+  template <typename T, typename... Args>
+  static T *New(Args &&... args) {
+    if constexpr (alignof(T) > alignof(std::max_align_t)) {
+      return new T(std::forward<Args>(args)...);
+    } else {
+      void *ptr = Allocate(sizeof(T));
+      return new (ptr) T(std::forward<Args>(args)...);
+    }
+  }
+
+  /// @brief Destroy an object created with New.
+  template <typename T>
+  static void Delete(T *object) {
+    if constexpr (alignof(T) > alignof(std::max_align_t)) {
+      delete object;
+    } else {
+      object->~T();
+      Deallocate(object);
+    }
+  }
+
+ private:
+  union alignas(std::max_align_t) Block {
+    Block *next;
+    uint32_t sizeClass;
+  };
+
+  struct FreeList {
+    Block *head;
+    size_t count;
+  };
+
+  struct SharedList {
+    std::mutex lock;
+    FreeList list = {nullptr, 0};
+  };
+
+  // Releases the blocks cached by a thread when it exits.  The lists are
+  // kept in trivially destructible thread_locals, that remain valid while
+  // the other thread_locals of the thread are destroyed.
+  struct ThreadCache {
+    ~ThreadCache() {
+      for (uint32_t c = 0; c < kNumClasses; ++c) {
+        auto &list = tlsLists_[c];
+        while (list.head != nullptr) {
+          Block *block = list.head;
+          list.head = block->next;
+          ::operator delete(block);
+        }
+        list.count = 0;
+      }
+      tlsExited_ = true;
+    }
+  };
+
+  static void RegisterThread() {
+    static thread_local ThreadCache cache;
+    (void)cache;
+  }
+
+  static uint32_t SizeClass(size_t size) {
+    if (size > kMaxBlockBytes) return kNumClasses;
+    uint32_t sizeClass = 0;
+    while (ClassBytes(sizeClass) < size) ++sizeClass;
+    return sizeClass;
+  }
+
+  static constexpr size_t ClassBytes(uint32_t sizeClass) {
+    return kMinBlockBytes << sizeClass;
+  }
+
+  static constexpr size_t MaxThreadBlocks(uint32_t sizeClass) {
+    return kMaxThreadBytes / ClassBytes(sizeClass) < 8
+               ? 8
+               : kMaxThreadBytes / ClassBytes(sizeClass);
+  }
+
+  static constexpr size_t MaxSharedBlocks(uint32_t sizeClass) {
+    return kMaxSharedBytes / ClassBytes(sizeClass);
+  }
+
+  static SharedList &Shared(uint32_t sizeClass) {
+    static SharedList *lists = new SharedList[kNumClasses];
+    return lists[sizeClass];
+  }
+
+  // Move the least recently released half of the blocks cached by this
+  // thread to the shared pool.
+  static void Spill(uint32_t sizeClass) {
+    auto &list = tlsLists_[sizeClass];
+    size_t keep = list.count / 2;
+    Block *last = list.head;
+    for (size_t i = 1; i < keep; ++i) last = last->next;
+    Block *spilled = last->next;
+    last->next = nullptr;
+    list.count = keep;
+
+    auto &shared = Shared(sizeClass);
+    std::lock_guard<std::mutex> _(shared.lock);
+    while (spilled != nullptr) {
+      Block *block = spilled;
+      spilled = block->next;
+      if (shared.list.count < MaxSharedBlocks(sizeClass)) {
+        block->next = shared.list.head;
+        shared.list.head = block;
+        ++shared.list.count;
+      } else {
+        ::operator delete(block);
+      }
+    }
+  }
+
+  // Take a batch of blocks from the shared pool.
+  static void Refill(uint32_t sizeClass) {
+    if (tlsExited_) return;
+    RegisterThread();
+
+    auto &list = tlsLists_[sizeClass];
+    auto &shared = Shared(sizeClass);
+    size_t batch = MaxThreadBlocks(sizeClass) / 2;
+    std::lock_guard<std::mutex> _(shared.lock);
+    for (size_t i = 0; i < batch && shared.list.head != nullptr; ++i) {
+      Block *block = shared.list.head;
+      shared.list.head = block->next;
+      --shared.list.count;
+      block->next = list.head;
+      list.head = block;
+      ++list.count;
+    }
+  }
+
+  static thread_local std::array<FreeList, kNumClasses> tlsLists_;
+  static thread_local bool tlsExited_;
+};
+
+inline thread_local std::array<TaskArena::FreeList, TaskArena::kNumClasses>
+    TaskArena::tlsLists_ = {};
+inline thread_local bool TaskArena::tlsExited_ = false;
+
+/// @brief Standard allocator drawing from the TaskArena.
+template <typename T>
+struct TaskArenaAllocator {
+  using value_type = T;
+
+  TaskArenaAllocator() = default;
+  template <typename U>
+  TaskArenaAllocator(const TaskArenaAllocator<U> &) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(TaskArena::Allocate(n * sizeof(T)));
+  }
+  void deallocate(T *ptr, size_t) { TaskArena::Deallocate(ptr); }
+
+  template <typename U>
+  bool operator==(const TaskArenaAllocator<U> &) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const TaskArenaAllocator<U> &) const {
+    return false;
+  }
+};
+
+/// @brief A task whose closure lives in the TaskArena.
+///
+/// The wrapper only holds a pointer, so that it fits in the inline storage
+/// of std::function and of the task objects of the underlying schedulers,
+/// whatever the size of the captured arguments.  The closure is released
+/// after its first and only invocation: copies of the wrapper share the
+/// same closure and at most one of them can be invoked.
+template <typename TaskT>
+class ArenaTask {
+ public:
+  explicit ArenaTask(TaskT *task) : task_(task) {}
+
+  template <typename... Args>
+  void operator()(Args &&... args) const {
+    std::unique_ptr<TaskT, Release> task(task_);
+    (*task)(std::forward<Args>(args)...);
+  }
+
+ private:
+  struct Release {
+    void operator()(TaskT *task) const { TaskArena::Delete(task); }
+  };
+
+  TaskT *task_;
+};
+
+/// @brief Move a task closure into the TaskArena.
+template <typename TaskT>
+ArenaTask<typename std::decay<TaskT>::type> makeArenaTask(TaskT &&task) {
+  using ClosureTy = typename std::decay<TaskT>::type;
+  return ArenaTask<ClosureTy>(
+      TaskArena::New<ClosureTy>(std::forward<TaskT>(task)));
+}
+
+struct ArgsBufferDeleter {
+  void operator()(uint8_t *buffer) const { TaskArena::Deallocate(buffer); }
+};
+
+}  // namespace impl
+
+/// @brief Allocate a buffer to be passed to the buffer-based asynchronous
+/// methods.
+///
+/// The buffer and its reference count are drawn from per-thread pools of
+/// recycled blocks and return there when the last task using the buffer
+/// completes, instead of going through the system allocator for every task.
+///
+/// Typical Usage:
+/// @code
+/// std::shared_ptr<uint8_t> buffer = allocateArgsBuffer(size);
+/// memcpy(buffer.get(), data, size);
+/// asyncExecuteAt(handle, locality, task, buffer, size);
+/// @endcode
+///
+/// @param size The size in bytes of the buffer.
+/// @return A buffer of size bytes, aligned as std::max_align_t.
+inline std::shared_ptr<uint8_t> allocateArgsBuffer(size_t size) {
+  return std::shared_ptr<uint8_t>(
+      static_cast<uint8_t *>(impl::TaskArena::Allocate(size)),
+      impl::ArgsBufferDeleter(), impl::TaskArenaAllocator<uint8_t>());
+}
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_TASK_ARENA_H_
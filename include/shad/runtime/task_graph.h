@@ -0,0 +1,272 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_TASK_GRAPH_H_
+#define INCLUDE_SHAD_RUNTIME_TASK_GRAPH_H_
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "shad/runtime/future.h"
+#include "shad/runtime/runtime.h"
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+template <typename FunctionTy, typename InArgsT>
+struct VoidTaskArgs {
+  FunctionTy function;
+  InArgsT args;
+};
+
+template <typename FunctionTy, typename InArgsT>
+void runVoidTask(Handle &handle, const VoidTaskArgs<FunctionTy, InArgsT> &args,
+                 bool *done) {
+  args.function(handle, args.args);
+  *done = true;
+}
+
+/// @brief Classify the functions that can be added to a TaskGraph.
+template <typename FunctionTy>
+struct TaskGraphFunction;
+
+template <typename InArgsT>
+struct TaskGraphFunction<void (*)(Handle &, const InArgsT &)> {
+  using ArgsTy = InArgsT;
+  using ResultTy = void;
+};
+
+template <typename InArgsT, typename ResT>
+struct TaskGraphFunction<void (*)(Handle &, const InArgsT &, ResT *)> {
+  using ArgsTy = InArgsT;
+  using ResultTy = ResT;
+};
+
+}  // namespace impl
+
+/// @brief A graph of tasks with explicit dependencies.
+///
+/// Each task runs on the Locality chosen when it is added, and is released as
+/// soon as all the tasks it depends on have completed, so that the stages of
+/// an algorithm overlap across localities instead of being separated by
+/// waitForCompletion.  The results of the tasks are collected on the locality
+/// running the graph, where they can be used to build the arguments of the
+/// tasks that depend on them.
+///
+/// Typical Usage:
+/// @code
+/// void partial(Handle &, const Range &range, int *sum) { /* local sum */ }
+/// void publish(Handle &, const int &total) { /* use the total */ }
+///
+/// TaskGraph graph;
+/// auto a = graph.AddTask(Locality(0), partial, rangeOnZero);
+/// auto b = graph.AddTask(Locality(1), partial, rangeOnOne);
+/// graph.AddDeferredTask(Locality(2), publish,
+///     [a, b](const TaskGraph &graph) {
+///       return graph.Result<int>(a) + graph.Result<int>(b);
+///     }, {a, b});
+///
+/// Handle handle;
+/// graph.Run(handle);
+/// waitForCompletion(handle);
+/// @endcode
+///
+/// The graph must outlive the completion of the Handle passed to Run.
+class TaskGraph {
+ public:
+  /// The identifier of a task in the graph.
+  using TaskId = size_t;
+
+  TaskGraph() = default;
+
+  // Tasks refer to the graph that contains them.
+  TaskGraph(const TaskGraph &) = delete;
+  TaskGraph &operator=(const TaskGraph &) = delete;
+
+  /// @brief Add a task to the graph.
+  ///
+  /// @tparam FunT The type of the function to be executed.  The function must
+  /// be convertible to a function pointer with one of the prototypes:
+  /// @code
+  /// void(Handle &, const InArgsT &);
+  /// void(Handle &, const InArgsT &, ResT *);
+  /// @endcode
+  /// where the result written in the last argument is available through
+  /// Result<ResT>() once the task has completed.
+  ///
+  /// @tparam InArgsT The type of the argument accepted by the function.  The
+  /// type must be memcopy-able.
+  ///
+  /// @param loc The Locality where the task must be executed.
+  /// @param func The function to execute.
+  /// @param args The arguments to be passed to the function.
+  /// @param dependencies The tasks that must complete before this one starts.
+  ///
+  /// @return The identifier of the new task.
+  template <typename FunT, typename InArgsT>
+  TaskId AddTask(const Locality &loc, FunT &&func, const InArgsT &args,
+                 const std::vector<TaskId> &dependencies = {}) {
+    return AddDeferredTask(
+        loc, std::forward<FunT>(func),
+        [args](const TaskGraph &) { return args; }, dependencies);
+  }
+
+  /// @brief Add a task whose arguments are built when it is released.
+  ///
+  /// @tparam FunT The type of the function to be executed (see AddTask).
+  ///
+  /// @tparam BuilderT The type of the builder of the arguments.  The prototype
+  /// must be:
+  /// @code
+  /// InArgsT(const TaskGraph &);
+  /// @endcode
+  /// The builder runs on the locality running the graph, and can access the
+  /// results of the dependencies.
+  ///
+  /// @param loc The Locality where the task must be executed.
+  /// @param func The function to execute.
+  /// @param builder The builder of the arguments of the function.
+  /// @param dependencies The tasks that must complete before this one starts.
+  ///
+  /// @return The identifier of the new task.
+  template <typename FunT, typename BuilderT>
+  TaskId AddDeferredTask(const Locality &loc, FunT &&func, BuilderT &&builder,
+                         const std::vector<TaskId> &dependencies = {}) {
+    using FunctionTy = decltype(+std::declval<std::decay_t<FunT>>());
+    using ResultTy = typename impl::TaskGraphFunction<FunctionTy>::ResultTy;
+
+    TaskId id = nodes_.size();
+    for (auto dependency : dependencies) {
+      if (dependency >= id) {
+        std::stringstream ss;
+        ss << "Task " << id << " depends on task " << dependency
+           << ", that has not been added yet.";
+        throw std::system_error(0xdeadc0de, std::generic_category(),
+                                ss.str());
+      }
+    }
+
+    std::unique_ptr<Node> node(new Node());
+    node->launch = MakeLauncher<FunctionTy>(
+        loc, +func, std::forward<BuilderT>(builder),
+        std::is_void<ResultTy>());
+    node->numDependencies = dependencies.size();
+    nodes_.emplace_back(std::move(node));
+
+    for (auto dependency : dependencies)
+      nodes_[dependency]->successors.push_back(id);
+    return id;
+  }
+
+  /// @brief Release the tasks of the graph.
+  ///
+  /// The tasks are attached to handle, and waitForCompletion(handle) returns
+  /// once all of them have completed.
+  ///
+  /// @param handle An Handle for the associated task-group.
+  void Run(Handle &handle) {
+    if (handle.IsNull()) handle = impl::createHandle();
+
+    // All the counters are set before any task can complete.
+    for (auto &node : nodes_) node->pending = node->numDependencies;
+    for (TaskId id = 0; id < nodes_.size(); ++id)
+      if (nodes_[id]->numDependencies == 0) nodes_[id]->launch(handle, id);
+  }
+
+  /// @brief Get the result of a completed task.
+  ///
+  /// @tparam ResT The type of the result of the task.
+  /// @param id The identifier of the task.
+  template <typename ResT>
+  const ResT &Result(TaskId id) const {
+    return *static_cast<const ResT *>(nodes_[id]->result.get());
+  }
+
+  /// @brief Number of tasks in the graph.
+  size_t NumTasks() const { return nodes_.size(); }
+
+ private:
+  struct Node {
+    std::function<void(Handle &, TaskId)> launch;
+    std::vector<TaskId> successors;
+    size_t numDependencies;
+    std::atomic<size_t> pending;
+    std::shared_ptr<void> result;
+  };
+
+  template <typename FunctionTy, typename BuilderT>
+  std::function<void(Handle &, TaskId)> MakeLauncher(const Locality &loc,
+                                                     FunctionTy function,
+                                                     BuilderT &&builder,
+                                                     std::true_type) {
+    using InArgsT = typename impl::TaskGraphFunction<FunctionTy>::ArgsTy;
+    return [this, loc, function, builder](Handle &handle, TaskId id) {
+      impl::VoidTaskArgs<FunctionTy, InArgsT> args{function, builder(*this)};
+      asyncExecuteAtWithRet(handle, loc,
+                            impl::runVoidTask<FunctionTy, InArgsT>, args)
+          .then([this, id](Handle &handle, const bool &) {
+            Complete(handle, id);
+          });
+    };
+  }
+
+  template <typename FunctionTy, typename BuilderT>
+  std::function<void(Handle &, TaskId)> MakeLauncher(const Locality &loc,
+                                                     FunctionTy function,
+                                                     BuilderT &&builder,
+                                                     std::false_type) {
+    using ResT = typename impl::TaskGraphFunction<FunctionTy>::ResultTy;
+    return [this, loc, function, builder](Handle &handle, TaskId id) {
+      asyncExecuteAtWithRet(handle, loc, function, builder(*this))
+          .then([this, id](Handle &handle, const ResT &result) {
+            nodes_[id]->result = std::make_shared<ResT>(result);
+            Complete(handle, id);
+          });
+    };
+  }
+
+  void Complete(Handle &handle, TaskId id) {
+    for (auto successor : nodes_[id]->successors) {
+      Node &node = *nodes_[successor];
+      if (node.pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        node.launch(handle, successor);
+    }
+  }
+
+  std::vector<std::unique_ptr<Node>> nodes_;
+};
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_TASK_GRAPH_H_
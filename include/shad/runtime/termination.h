@@ -0,0 +1,283 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#ifndef INCLUDE_SHAD_RUNTIME_TERMINATION_H_
+#define INCLUDE_SHAD_RUNTIME_TERMINATION_H_
+
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <system_error>
+#include <utility>
+
+#include "shad/runtime/collectives.h"
+#include "shad/runtime/runtime.h"
+
+namespace shad {
+namespace rt {
+
+class Epoch;
+
+namespace impl {
+
+inline uint32_t epochSlot(const Epoch &epoch);
+
+/// @brief The per-locality state of the open epochs.
+///
+/// Every epoch uses the same slot on all the localities.  The slots are
+/// assigned by Locality 0, so that the tasks of an epoch find their counters
+/// without any lookup.
+class EpochTable {
+ public:
+  /// Maximum number of epochs open at the same time.
+  static constexpr uint32_t kMaxEpochs = 64;
+
+  struct Slot {
+    /// Tasks of the epoch spawned by this locality.
+    std::atomic<uint64_t> spawned{0};
+    /// Tasks of the epoch completed on this locality.
+    std::atomic<uint64_t> completed{0};
+    /// The Handle tracking the tasks of the epoch spawned by this locality.
+    Handle handle;
+  };
+
+  /// @brief Get the table of the calling locality.
+  static EpochTable &Instance() {
+    // One table for each of the localities hosted by this process.
+    static std::unique_ptr<EpochTable[]> instances(
+        new EpochTable[numProcessLocalities()]);
+    return instances[processLocalityIndex()];
+  }
+
+  Slot &operator[](uint32_t slot) { return slots_[slot]; }
+
+  /// @brief Reserve a free slot.  Must be called on Locality 0.
+  uint32_t Acquire() {
+    std::lock_guard<Lock> _(lock_);
+    for (uint32_t i = 0; i < kMaxEpochs; ++i) {
+      if (!used_[i]) {
+        used_[i] = true;
+        return i;
+      }
+    }
+    std::stringstream ss;
+    ss << "More than " << kMaxEpochs << " epochs open at the same time";
+    throw std::system_error(0xdeadc0de, std::generic_category(), ss.str());
+  }
+
+  /// @brief Return a slot reserved with Acquire.  Must be called on Locality
+  /// 0.
+  void Release(uint32_t slot) {
+    std::lock_guard<Lock> _(lock_);
+    used_[slot] = false;
+  }
+
+ private:
+  std::array<Slot, kMaxEpochs> slots_;
+  Lock lock_;
+  std::bitset<kMaxEpochs> used_;
+};
+
+struct EpochCounters {
+  uint64_t spawned;
+  uint64_t completed;
+};
+
+inline void acquireEpochSlot(const uint8_t &, uint32_t *slot) {
+  *slot = EpochTable::Instance().Acquire();
+}
+
+inline void releaseEpochSlot(const uint32_t &slot) {
+  EpochTable::Instance().Release(slot);
+}
+
+inline void openEpoch(const uint32_t &slot) {
+  auto &state = EpochTable::Instance()[slot];
+  state.spawned = 0;
+  state.completed = 0;
+  state.handle = createHandle();
+}
+
+inline void closeEpoch(const uint32_t &slot) {
+  // All the tasks have completed: this only releases the Handle.
+  waitForCompletion(EpochTable::Instance()[slot].handle);
+}
+
+inline void readEpochCounters(const uint32_t &slot, EpochCounters *counters) {
+  auto &state = EpochTable::Instance()[slot];
+  // Reading completed first never reports more completed than spawned tasks.
+  counters->completed = state.completed.load();
+  counters->spawned = state.spawned.load();
+}
+
+inline EpochCounters sumEpochCounters(const EpochCounters &lhs,
+                                      const EpochCounters &rhs) {
+  return EpochCounters{lhs.spawned + rhs.spawned,
+                       lhs.completed + rhs.completed};
+}
+
+}  // namespace impl
+
+/// @brief A termination-detection epoch.
+///
+/// Tasks spawned within an epoch can spawn further tasks of the same epoch on
+/// any locality, only passing the epoch around.  waitForTermination returns
+/// once all the tasks spawned transitively within the epoch have completed,
+/// without threading a Handle through the tasks and without global barriers.
+///
+/// Termination is detected with the four-counter method: every locality
+/// counts the tasks it spawns and the tasks it completes, and the caller of
+/// waitForTermination sums the counters with successive tree reductions.  The
+/// epoch has terminated when the tasks completed in a wave match the tasks
+/// spawned in the following one.
+///
+/// Typical Usage:
+/// @code
+/// void visit(const Epoch &epoch, const Vertex &v) {
+///   for (auto &w : /* neighbors of v */)
+///     asyncExecuteAt(epoch, /* owner of w */, visit, w);
+/// }
+///
+/// Epoch epoch = createEpoch();
+/// asyncExecuteAt(epoch, /* owner of root */, visit, root);
+/// waitForTermination(epoch);
+/// @endcode
+///
+/// Epochs are cheap to copy and can be passed as (part of) task arguments.
+class Epoch {
+ public:
+  /// @brief Constructor.  Initialize the newly created object to a null
+  /// value.
+  Epoch() : slot_(kNullSlot) {}
+
+  /// @brief Null Test.
+  /// @return true if the Epoch is null, false otherwise.
+  bool IsNull() const { return slot_ == kNullSlot; }
+
+ private:
+  static constexpr uint32_t kNullSlot = ~uint32_t(0);
+
+  explicit Epoch(uint32_t slot) : slot_(slot) {}
+
+  friend Epoch createEpoch();
+  friend uint32_t impl::epochSlot(const Epoch &);
+
+  uint32_t slot_;
+};
+
+namespace impl {
+
+inline uint32_t epochSlot(const Epoch &epoch) { return epoch.slot_; }
+
+template <typename InArgsT>
+struct EpochTaskArgs {
+  void (*function)(const Epoch &, const InArgsT &);
+  Epoch epoch;
+  InArgsT args;
+};
+
+template <typename InArgsT>
+void epochTask(Handle &, const EpochTaskArgs<InArgsT> &args) {
+  args.function(args.epoch, args.args);
+  // Counted after the task, so that the tasks it spawned are already counted.
+  EpochTable::Instance()[epochSlot(args.epoch)].completed.fetch_add(1);
+}
+
+}  // namespace impl
+
+/// @brief Open a new epoch.
+///
+/// The epoch is registered on all the localities, and must be closed with
+/// waitForTermination.
+///
+/// @return The new epoch.
+inline Epoch createEpoch() {
+  uint32_t slot;
+  executeAtWithRet(Locality(0), impl::acquireEpochSlot, uint8_t(0), &slot);
+  broadcast(impl::openEpoch, slot);
+  return Epoch(slot);
+}
+
+/// @brief Execute a function on a selected locality asynchronously, within
+/// an epoch.
+///
+/// @tparam FunT The type of the function to be executed.  The function
+/// prototype must be:
+/// @code
+/// void(const Epoch &, const InArgsT &);
+/// @endcode
+///
+/// @tparam InArgsT The type of the argument accepted by the function.  The type
+/// can be a structure or a class but with the restriction that must be
+/// memcopy-able.
+///
+/// @param epoch The epoch the task belongs to.
+/// @param loc The Locality where the function must be executed.
+/// @param func The function to execute.
+/// @param args The arguments to be passed to the function.
+template <typename FunT, typename InArgsT>
+void asyncExecuteAt(const Epoch &epoch, const Locality &loc, FunT &&func,
+                    const InArgsT &args) {
+  using FunctionTy = void (*)(const Epoch &, const InArgsT &);
+  FunctionTy fn = std::forward<decltype(func)>(func);
+
+  auto &state = impl::EpochTable::Instance()[impl::epochSlot(epoch)];
+  state.spawned.fetch_add(1);
+  impl::EpochTaskArgs<InArgsT> taskArgs{fn, epoch, args};
+  asyncExecuteAt(state.handle, loc, impl::epochTask<InArgsT>,
+                 std::move(taskArgs));
+}
+
+/// @brief Wait until all the tasks spawned within an epoch have completed,
+/// and close the epoch.
+///
+/// No task of the epoch may be spawned from outside the epoch once this
+/// method has been called.
+///
+/// @param epoch The epoch to wait for.  The epoch is null on return.
+inline void waitForTermination(Epoch &epoch) {
+  uint32_t slot = impl::epochSlot(epoch);
+
+  impl::EpochCounters previous, current;
+  reduce(impl::readEpochCounters, slot, impl::sumEpochCounters, &previous);
+  while (true) {
+    reduce(impl::readEpochCounters, slot, impl::sumEpochCounters, &current);
+    if (previous.completed == current.spawned) break;
+    previous = current;
+    impl::yield();
+  }
+
+  broadcast(impl::closeEpoch, slot);
+  executeAt(Locality(0), impl::releaseEpochSlot, slot);
+  epoch = Epoch();
+}
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_TERMINATION_H_
@@ -0,0 +1,394 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#ifndef INCLUDE_SHAD_RUNTIME_TOPOLOGY_H_
+#define INCLUDE_SHAD_RUNTIME_TOPOLOGY_H_
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace shad {
+namespace rt {
+
+/// @brief How the runtime places its worker threads on the CPUs.
+enum class PinningPolicy : uint8_t {
+  /// Leave the affinity of the workers alone.
+  kNone,
+  /// Bind every worker to a NUMA domain, round-robin (default).
+  kDomain,
+  /// Bind every worker to a hardware thread, filling the SMT siblings of a
+  /// core, then the cores of a socket, before moving to the next one.
+  kCompact,
+  /// Bind every worker to a hardware thread, spreading the workers over the
+  /// sockets first and over the SMT siblings last.
+  kScatter
+};
+
+namespace impl {
+
+// Parse a sysfs list of CPUs or nodes (e.g., "0-3,8-11").
+inline std::vector<int> parseCpuList(const std::string &list) {
+  std::vector<int> cpus;
+  std::stringstream stream(list);
+  std::string range;
+  while (std::getline(stream, range, ',')) {
+    if (range.empty() || range == "\n") continue;
+    size_t dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first
+                                         : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+/// @brief Sockets, cores, hardware threads and caches of the node hosting
+/// the calling process, restricted to the CPUs the process can run on.
+///
+/// The topology is read from /sys/devices/system/cpu; CPUs without
+/// topology information are seen as single-threaded cores of one socket.
+/// The CPUs of the workers are assigned according to a PinningPolicy,
+/// set through rt::initialize:
+///  - --shad-pin=none|domain|compact|scatter, or SHAD_PIN;
+///  - --shad-reserved-cores=N, or SHAD_RESERVED_CORES: keep the hardware
+///    threads of the last N cores for the communication and progress threads
+///    of the runtime.  Workers never run there.
+/// Command line options take precedence over the environment.
+class CpuTopology {
+ public:
+  /// @brief A cache level, as seen by one CPU.
+  struct Cache {
+    uint32_t level;
+    /// Size in bytes of one instance of the cache.
+    size_t size;
+    size_t lineSize;
+    /// Number of available CPUs sharing one instance of the cache.
+    size_t numSharing;
+  };
+
+  static CpuTopology &Instance() {
+    static CpuTopology *instance = new CpuTopology();
+    return *instance;
+  }
+
+  /// @brief Read the pinning options from the command line and from the
+  /// environment.  Options that are not recognized are ignored.
+  ///
+  /// The environment alone is read when the topology is first accessed.
+  void Configure(int argc, char *argv[]) {
+    policy_ = PinningPolicy::kDomain;
+    size_t reservedCores = 0;
+
+    const char *pin = std::getenv("SHAD_PIN");
+    if (pin != nullptr && *pin != '\0') ParsePolicy(pin, &policy_);
+    const char *reserved = std::getenv("SHAD_RESERVED_CORES");
+    if (reserved != nullptr && *reserved != '\0')
+      reservedCores = std::stoul(reserved);
+
+    static const char kPinOption[] = "--shad-pin=";
+    static const char kReservedOption[] = "--shad-reserved-cores=";
+    for (int i = 1; i < argc && argv != nullptr; ++i) {
+      if (argv[i] == nullptr) continue;
+      std::string option(argv[i]);
+      if (option.compare(0, sizeof(kPinOption) - 1, kPinOption) == 0)
+        ParsePolicy(option.substr(sizeof(kPinOption) - 1), &policy_);
+      else if (option.compare(0, sizeof(kReservedOption) - 1,
+                              kReservedOption) == 0)
+        reservedCores = std::stoul(option.substr(sizeof(kReservedOption) - 1));
+    }
+    Reserve(reservedCores);
+  }
+
+  size_t NumSockets() const { return numSockets_; }
+  size_t NumCores() const { return numCores_; }
+  size_t NumHardwareThreads() const { return cpus_.size(); }
+
+  /// @brief The caches of the first available CPU, from the innermost.
+  /// Instruction caches are not listed.
+  const std::vector<Cache> &Caches() const { return caches_; }
+
+  PinningPolicy Policy() const { return policy_; }
+
+  size_t NumReservedCores() const { return numReservedCores_; }
+
+  /// @brief The CPUs the workers run on, in the order of the policy.
+  const std::vector<int> &WorkerCpus() const { return workerCpus_; }
+
+  /// @brief The CPUs kept for the communication and progress threads.
+  const std::vector<int> &ReservedCpus() const { return reservedCpus_; }
+
+  /// @brief The CPU of the i-th worker of the node.  When there are more
+  /// workers than CPUs they wrap around.
+  int WorkerCpu(size_t i) const { return workerCpus_[i % workerCpus_.size()]; }
+
+  /// @brief Pin the calling communication or progress thread on the
+  /// reserved CPUs.  It has no effect when no core is reserved.
+  void PinProgressThread() const {
+    if (reservedCpus_.empty() || policy_ == PinningPolicy::kNone) return;
+    Bind(reservedCpus_);
+  }
+
+  /// @brief Restrict the calling thread to a set of CPUs.
+  static bool Bind(const std::vector<int> &cpus) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+  }
+
+  /// @brief The CPUs the calling process is allowed to run on.
+  static std::vector<int> AvailableCpus() {
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+      for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+    }
+#endif
+    if (cpus.empty()) cpus.push_back(0);
+    return cpus;
+  }
+
+ private:
+  struct Cpu {
+    int id;
+    int socket;
+    int core;
+    // Index of the CPU among the available SMT siblings of its core.
+    int thread;
+  };
+
+  CpuTopology()
+      : numSockets_(1),
+        numCores_(1),
+        policy_(PinningPolicy::kDomain),
+        numReservedCores_(0) {
+    for (int id : AvailableCpus()) {
+      Cpu cpu{id, ReadInt(id, "topology/physical_package_id", 0),
+              ReadInt(id, "topology/core_id", id), 0};
+      cpus_.push_back(cpu);
+    }
+
+    // Compact order: sockets, then cores, then SMT siblings.
+    std::sort(cpus_.begin(), cpus_.end(), [](const Cpu &a, const Cpu &b) {
+      return std::tie(a.socket, a.core, a.id) <
+             std::tie(b.socket, b.core, b.id);
+    });
+    numCores_ = 0;
+    numSockets_ = 0;
+    for (size_t i = 0; i < cpus_.size(); ++i) {
+      bool newSocket = i == 0 || cpus_[i].socket != cpus_[i - 1].socket;
+      bool newCore = newSocket || cpus_[i].core != cpus_[i - 1].core;
+      numSockets_ += newSocket;
+      numCores_ += newCore;
+      cpus_[i].thread = newCore ? 0 : cpus_[i - 1].thread + 1;
+    }
+
+    ReadCaches(cpus_.front().id);
+    Configure(0, nullptr);
+  }
+
+  static bool ParsePolicy(const std::string &name, PinningPolicy *policy) {
+    if (name == "none" || name == "0") {
+      *policy = PinningPolicy::kNone;
+    } else if (name == "domain") {
+      *policy = PinningPolicy::kDomain;
+    } else if (name == "compact") {
+      *policy = PinningPolicy::kCompact;
+    } else if (name == "scatter") {
+      *policy = PinningPolicy::kScatter;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  // Keep the hardware threads of the last numCores cores (at least one core
+  // is left to the workers), and order the others as the policy dictates.
+  void Reserve(size_t numCores) {
+    numReservedCores_ = std::min(numCores, numCores_ - 1);
+    size_t firstReserved = cpus_.size();
+    for (size_t cores = 0; cores < numReservedCores_;) {
+      --firstReserved;
+      cores += cpus_[firstReserved].thread == 0;
+    }
+
+    std::vector<Cpu> workers(cpus_.begin(), cpus_.begin() + firstReserved);
+    if (policy_ == PinningPolicy::kScatter) {
+      // Rank the cores within their socket, then interleave the sockets.
+      std::vector<int> coreRank(workers.size(), 0);
+      for (size_t i = 1; i < workers.size(); ++i) {
+        if (workers[i].socket != workers[i - 1].socket)
+          coreRank[i] = 0;
+        else
+          coreRank[i] = coreRank[i - 1] + (workers[i].thread == 0);
+      }
+      std::vector<std::tuple<int, int, int, int>> order;
+      for (size_t i = 0; i < workers.size(); ++i)
+        order.emplace_back(workers[i].thread, coreRank[i], workers[i].socket,
+                           workers[i].id);
+      std::sort(order.begin(), order.end());
+      workerCpus_.clear();
+      for (auto &cpu : order) workerCpus_.push_back(std::get<3>(cpu));
+    } else {
+      workerCpus_.clear();
+      for (auto &cpu : workers) workerCpus_.push_back(cpu.id);
+    }
+
+    reservedCpus_.clear();
+    for (size_t i = firstReserved; i < cpus_.size(); ++i)
+      reservedCpus_.push_back(cpus_[i].id);
+    std::sort(reservedCpus_.begin(), reservedCpus_.end());
+  }
+
+  static std::string ReadLine(int cpu, const std::string &file) {
+    std::ifstream stream("/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+                         "/" + file);
+    std::string line;
+    if (stream) std::getline(stream, line);
+    return line;
+  }
+
+  static int ReadInt(int cpu, const std::string &file, int fallback) {
+    std::string line = ReadLine(cpu, file);
+    if (line.empty()) return fallback;
+    return std::stoi(line);
+  }
+
+  // Sizes are reported as, e.g., "32K" or "8192K".
+  static size_t ParseSize(const std::string &size) {
+    if (size.empty()) return 0;
+    size_t value = std::stoul(size);
+    switch (size.back()) {
+      case 'K': return value << 10;
+      case 'M': return value << 20;
+      case 'G': return value << 30;
+      default: return value;
+    }
+  }
+
+  void ReadCaches(int cpu) {
+    for (int index = 0;; ++index) {
+      std::string dir = "cache/index" + std::to_string(index) + "/";
+      std::string type = ReadLine(cpu, dir + "type");
+      if (type.empty()) break;
+      if (type == "Instruction") continue;
+
+      Cache cache{static_cast<uint32_t>(ReadInt(cpu, dir + "level", 0)),
+                  ParseSize(ReadLine(cpu, dir + "size")),
+                  static_cast<size_t>(
+                      ReadInt(cpu, dir + "coherency_line_size", 64)),
+                  0};
+      auto sharing = parseCpuList(ReadLine(cpu, dir + "shared_cpu_list"));
+      for (auto &available : cpus_)
+        cache.numSharing +=
+            std::count(sharing.begin(), sharing.end(), available.id);
+      cache.numSharing = std::max<size_t>(cache.numSharing, 1);
+      caches_.push_back(cache);
+    }
+    std::sort(caches_.begin(), caches_.end(),
+              [](const Cache &a, const Cache &b) { return a.level < b.level; });
+  }
+
+  std::vector<Cpu> cpus_;
+  size_t numSockets_;
+  size_t numCores_;
+  std::vector<Cache> caches_;
+  PinningPolicy policy_;
+  size_t numReservedCores_;
+  std::vector<int> workerCpus_;
+  std::vector<int> reservedCpus_;
+};
+
+}  // namespace impl
+
+/// @brief Number of sockets available to the calling process.
+inline uint32_t numSockets() {
+  return impl::CpuTopology::Instance().NumSockets();
+}
+
+/// @brief Number of physical cores available to the calling process.
+inline uint32_t numCores() { return impl::CpuTopology::Instance().NumCores(); }
+
+/// @brief Number of hardware threads available to the calling process.
+inline uint32_t numHardwareThreads() {
+  return impl::CpuTopology::Instance().NumHardwareThreads();
+}
+
+/// @brief Number of hardware threads the workers of the runtime run on, that
+/// is the available ones minus the ones of the reserved cores.
+inline uint32_t numWorkerThreads() {
+  return impl::CpuTopology::Instance().WorkerCpus().size();
+}
+
+/// @brief The policy used to pin the workers of the runtime.
+inline PinningPolicy pinningPolicy() {
+  return impl::CpuTopology::Instance().Policy();
+}
+
+/// @brief Size in bytes of one instance of a data (or unified) cache level,
+/// or 0 when the level is not present or not known.
+inline size_t cacheSize(uint32_t level) {
+  for (auto &cache : impl::CpuTopology::Instance().Caches())
+    if (cache.level == level) return cache.size;
+  return 0;
+}
+
+/// @brief Number of hardware threads sharing one instance of a cache level,
+/// or 0 when the level is not present or not known.
+inline size_t cacheSharing(uint32_t level) {
+  for (auto &cache : impl::CpuTopology::Instance().Caches())
+    if (cache.level == level) return cache.numSharing;
+  return 0;
+}
+
+/// @brief Size in bytes of a cache line of the innermost data cache.
+inline size_t cacheLineSize() {
+  auto &caches = impl::CpuTopology::Instance().Caches();
+  return caches.empty() ? 64 : caches.front().lineSize;
+}
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_TOPOLOGY_H_
@@ -0,0 +1,422 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef INCLUDE_SHAD_RUNTIME_TRACING_H_
+#define INCLUDE_SHAD_RUNTIME_TRACING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "shad/config/config.h"
+
+#if defined(SHAD_ENABLE_TRACING)
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#endif
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+/// @brief The runtime operations counted by the tracer.
+enum class TraceOp : uint8_t {
+  kExecuteAt = 0,
+  kExecuteAtWithRet,
+  kExecuteOnAll,
+  kForEachAt,
+  kForEachOnAll,
+  kAsyncExecuteAt,
+  kAsyncExecuteAtWithRet,
+  kAsyncExecuteOnAll,
+  kAsyncForEachAt,
+  kAsyncForEachOnAll,
+  kDma,
+  kAsyncDma,
+  kAtomic,
+  kAsyncAtomic,
+  kNumOps
+};
+
+/// @brief Number of operations counted by the tracer.
+constexpr size_t kNumTraceOps = static_cast<size_t>(TraceOp::kNumOps);
+
+/// @brief The name of op in the exported traces.
+inline const char *TraceOpName(TraceOp op) {
+  static const char *names[kNumTraceOps] = {
+      "executeAt",         "executeAtWithRet",      "executeOnAll",
+      "forEachAt",         "forEachOnAll",          "asyncExecuteAt",
+      "asyncExecuteAtWithRet", "asyncExecuteOnAll", "asyncForEachAt",
+      "asyncForEachOnAll", "dma",                   "asyncDma",
+      "atomic",            "asyncAtomic"};
+  return names[static_cast<size_t>(op)];
+}
+
+#if defined(SHAD_ENABLE_TRACING)
+
+/// @brief Per-locality instrumentation of the runtime.
+///
+/// The tracer is enabled at configure time with -DSHAD_ENABLE_TRACING=ON.  For
+/// every locality hosted by the process it counts the calls to the runtime
+/// interface, the messages and the bytes exchanged with every other locality,
+/// and it keeps two histograms of the time spent by the tasks in the queues
+/// of the scheduler and in execution.  It also records a bounded timeline of
+/// calls and tasks.  rt::impl::finalize() writes, for every locality L,
+/// <prefix>.L.json with the counters and <prefix>.L.trace.json with the
+/// timeline in the Chrome trace-event format (chrome://tracing, Perfetto).
+/// The prefix is read from SHAD_TRACE_PREFIX and defaults to shad_trace.
+///
+/// When the tracer is disabled, all its entry points are empty inline
+/// functions and the tasks are queued unchanged.
+class Tracer {
+ public:
+  /// Number of buckets of the histograms: bucket i counts the durations in
+  /// [2^i, 2^(i + 1)) nanoseconds, bucket 0 includes zero.
+  static constexpr size_t kHistogramBuckets = 40;
+  /// Maximum number of timeline events kept per locality.
+  static constexpr size_t kMaxEvents = 1 << 18;
+
+  /// @brief Get the tracer of the process.
+  static Tracer &Instance() {
+    static Tracer *instance = new Tracer();
+    return *instance;
+  }
+
+  /// @brief Time in nanoseconds of the monotonic clock shared by the
+  /// processes of the machine.
+  static uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  /// @brief Stop or resume the recording on the calling process.
+  void Pause(bool paused) { paused_.store(paused); }
+
+  /// @brief Count a call of src that is not a message on its own.
+  void CountCall(TraceOp op, uint32_t src) {
+    if (paused_.load(std::memory_order_relaxed)) return;
+    At(src).calls[static_cast<size_t>(op)].fetch_add(
+        1, std::memory_order_relaxed);
+  }
+
+  /// @brief Record a call of src to dst carrying numBytes.
+  void RecordCall(TraceOp op, uint32_t src, uint32_t dst, size_t numBytes) {
+    RecordCall(op, src, dst, dst + 1, numBytes);
+  }
+
+  /// @brief Record a call of src to all the numLocalities localities, each
+  /// receiving numBytes.
+  void RecordBroadcast(TraceOp op, uint32_t src, uint32_t numLocalities,
+                       size_t numBytes) {
+    RecordCall(op, src, 0, numLocalities, numBytes);
+  }
+
+  /// @brief Record numBytes received by dst from src.
+  void RecordReceived(uint32_t dst, uint32_t src, size_t numBytes) {
+    auto &trace = At(dst);
+    std::lock_guard<std::mutex> _(trace.mutex);
+    trace.peers[src].bytesReceived += numBytes;
+  }
+
+  /// @brief Record the result of an asynchronous call of dst to src as
+  /// received when dst completes handle: numBytes if resultSize is null,
+  /// *resultSize read at completion otherwise.
+  void DeferReceived(uint32_t dst, uint64_t handle, uint32_t src,
+                     const uint32_t *resultSize, size_t numBytes) {
+    auto &trace = At(dst);
+    std::lock_guard<std::mutex> _(trace.mutex);
+    trace.pending.emplace(handle, PendingReceive{src, resultSize, numBytes});
+  }
+
+  /// @brief Record the results of the calls of locality that handle has
+  /// just completed.
+  void CompleteReceived(uint32_t locality, uint64_t handle) {
+    auto &trace = At(locality);
+    std::lock_guard<std::mutex> _(trace.mutex);
+    auto range = trace.pending.equal_range(handle);
+    for (auto it = range.first; it != range.second; ++it) {
+      auto &pending = it->second;
+      trace.peers[pending.src].bytesReceived +=
+          pending.resultSize != nullptr ? *pending.resultSize
+                                        : pending.numBytes;
+    }
+    trace.pending.erase(range.first, range.second);
+  }
+
+  /// @brief Record a task run by locality that was queued at enqueued, and
+  /// started at start.
+  void RecordTask(uint32_t locality, uint64_t enqueued, uint64_t start) {
+    if (paused_.load(std::memory_order_relaxed)) return;
+    auto end = Now();
+    auto &trace = At(locality);
+    trace.queueWait[Bucket(start - enqueued)].fetch_add(
+        1, std::memory_order_relaxed);
+    trace.execution[Bucket(end - start)].fetch_add(1,
+                                                   std::memory_order_relaxed);
+    std::lock_guard<std::mutex> _(trace.mutex);
+    AddEvent(trace, Event{start, end - start, ThreadId(), 0,
+                          TraceOp::kNumOps, false});
+  }
+
+  /// @brief Number of calls of type op made by locality.
+  uint64_t Calls(uint32_t locality, TraceOp op) {
+    return At(locality).calls[static_cast<size_t>(op)].load();
+  }
+
+  /// @brief Bytes sent by locality to dst.
+  uint64_t BytesSent(uint32_t locality, uint32_t dst) {
+    auto &trace = At(locality);
+    std::lock_guard<std::mutex> _(trace.mutex);
+    auto peer = trace.peers.find(dst);
+    return peer != trace.peers.end() ? peer->second.bytesSent : 0;
+  }
+
+  /// @brief Bytes received by locality from src.
+  uint64_t BytesReceived(uint32_t locality, uint32_t src) {
+    auto &trace = At(locality);
+    std::lock_guard<std::mutex> _(trace.mutex);
+    auto peer = trace.peers.find(src);
+    return peer != trace.peers.end() ? peer->second.bytesReceived : 0;
+  }
+
+  /// @brief Number of tasks executed by locality.
+  uint64_t Tasks(uint32_t locality) {
+    uint64_t tasks = 0;
+    for (auto &bucket : At(locality).execution) tasks += bucket.load();
+    return tasks;
+  }
+
+  /// @brief Turn the bytes sent by locality into bytes received by the
+  /// destinations, through send(dst, src, bytes).
+  template <typename SendTy>
+  void PublishSent(uint32_t locality, SendTy &&send) {
+    std::vector<std::pair<uint32_t, uint64_t>> sent;
+    {
+      auto &trace = At(locality);
+      std::lock_guard<std::mutex> _(trace.mutex);
+      for (auto &peer : trace.peers)
+        if (peer.second.bytesSent != 0)
+          sent.emplace_back(peer.first, peer.second.bytesSent);
+    }
+    for (auto &entry : sent) send(entry.first, locality, entry.second);
+  }
+
+  /// @brief Write the counters and the timeline of locality.
+  void Export(uint32_t locality) {
+    auto &trace = At(locality);
+    const char *env = std::getenv("SHAD_TRACE_PREFIX");
+    std::string prefix = std::string(env != nullptr ? env : "shad_trace") +
+                         "." + std::to_string(locality);
+    std::lock_guard<std::mutex> _(trace.mutex);
+
+    std::ofstream counters(prefix + ".json");
+    counters << "{\n  \"locality\": " << locality << ",\n  \"calls\": {";
+    for (size_t i = 0; i < kNumTraceOps; ++i)
+      counters << (i ? ", " : "") << "\""
+               << TraceOpName(static_cast<TraceOp>(i))
+               << "\": " << trace.calls[i].load();
+    counters << "},\n  \"peers\": [";
+    bool first = true;
+    for (auto &peer : trace.peers) {
+      counters << (first ? "" : ",") << "\n    {\"locality\": " << peer.first
+               << ", \"messagesSent\": " << peer.second.messagesSent
+               << ", \"bytesSent\": " << peer.second.bytesSent
+               << ", \"bytesReceived\": " << peer.second.bytesReceived << "}";
+      first = false;
+    }
+    counters << "\n  ],\n  \"queueWaitNs\": ";
+    WriteHistogram(counters, trace.queueWait);
+    counters << ",\n  \"executionNs\": ";
+    WriteHistogram(counters, trace.execution);
+    counters << ",\n  \"droppedEvents\": " << trace.droppedEvents << "\n}\n";
+
+    std::ofstream timeline(prefix + ".trace.json");
+    timeline << "{\"traceEvents\": [";
+    first = true;
+    for (auto &event : trace.events) {
+      timeline << (first ? "" : ",") << "\n  {\"pid\": " << locality
+               << ", \"ts\": " << event.start / 1000.0;
+      if (event.isCall) {
+        timeline << ", \"tid\": 0, \"ph\": \"i\", \"s\": \"t\", \"name\": \""
+                 << TraceOpName(event.op) << "\", \"args\": {\"dst\": ";
+        if (event.peer == kAllLocalities)
+          timeline << "\"all\"";
+        else
+          timeline << event.peer;
+        timeline << ", \"bytes\": " << event.numBytes << "}}";
+      } else {
+        timeline << ", \"tid\": " << event.peer
+                 << ", \"ph\": \"X\", \"name\": \"task\", \"dur\": "
+                 << event.duration / 1000.0 << "}";
+      }
+      first = false;
+    }
+    timeline << "\n]}\n";
+  }
+
+ private:
+  struct Peer {
+    uint64_t messagesSent = 0;
+    uint64_t bytesSent = 0;
+    uint64_t bytesReceived = 0;
+  };
+
+  struct Event {
+    uint64_t start;
+    uint64_t duration;
+    // The destination of a call, the thread of a task.
+    uint32_t peer;
+    uint64_t numBytes;
+    TraceOp op;
+    bool isCall;
+  };
+
+  struct PendingReceive {
+    uint32_t src;
+    const uint32_t *resultSize;
+    size_t numBytes;
+  };
+
+  using HistogramTy = std::array<std::atomic<uint64_t>, kHistogramBuckets>;
+
+  /// Destination of the events of the broadcasting calls.
+  static constexpr uint32_t kAllLocalities = -1;
+
+  struct LocalityTrace {
+    std::array<std::atomic<uint64_t>, kNumTraceOps> calls{};
+    HistogramTy queueWait{};
+    HistogramTy execution{};
+    std::mutex mutex;
+    std::map<uint32_t, Peer> peers;
+    std::vector<Event> events;
+    uint64_t droppedEvents = 0;
+    // The asynchronous results not yet received, by handle.
+    std::multimap<uint64_t, PendingReceive> pending;
+  };
+
+  Tracer() = default;
+
+  void RecordCall(TraceOp op, uint32_t src, uint32_t first, uint32_t last,
+                  size_t numBytes) {
+    if (paused_.load(std::memory_order_relaxed)) return;
+    auto &trace = At(src);
+    trace.calls[static_cast<size_t>(op)].fetch_add(1,
+                                                   std::memory_order_relaxed);
+    auto now = Now();
+    std::lock_guard<std::mutex> _(trace.mutex);
+    for (uint32_t dst = first; dst < last; ++dst) {
+      auto &peer = trace.peers[dst];
+      peer.messagesSent += 1;
+      peer.bytesSent += numBytes;
+    }
+    uint32_t dst = last - first == 1 ? first : kAllLocalities;
+    AddEvent(trace, Event{now, 0, dst, numBytes, op, true});
+  }
+
+  LocalityTrace &At(uint32_t locality) {
+    // Localities hosted by the process never go away: cache the last lookup.
+    static thread_local uint32_t cachedLocality = -1;
+    static thread_local LocalityTrace *cachedTrace = nullptr;
+    if (cachedLocality == locality) return *cachedTrace;
+
+    std::lock_guard<std::mutex> _(mutex_);
+    auto &trace = traces_[locality];
+    if (!trace) trace.reset(new LocalityTrace());
+    cachedLocality = locality;
+    cachedTrace = trace.get();
+    return *trace;
+  }
+
+  static size_t Bucket(uint64_t ns) {
+    size_t bucket = 0;
+    while (ns > 1 && bucket < kHistogramBuckets - 1) {
+      ns >>= 1;
+      ++bucket;
+    }
+    return bucket;
+  }
+
+  static uint32_t ThreadId() {
+    static std::atomic<uint32_t> nextId(1);
+    static thread_local uint32_t id = nextId.fetch_add(1);
+    return id;
+  }
+
+  static void AddEvent(LocalityTrace &trace, const Event &event) {
+    if (trace.events.size() < kMaxEvents)
+      trace.events.push_back(event);
+    else
+      ++trace.droppedEvents;
+  }
+
+  static void WriteHistogram(std::ostream &out, const HistogramTy &histogram) {
+    out << "[";
+    for (size_t i = 0; i < kHistogramBuckets; ++i)
+      out << (i ? ", " : "") << histogram[i].load();
+    out << "]";
+  }
+
+  std::atomic<bool> paused_{false};
+  std::mutex mutex_;
+  std::map<uint32_t, std::unique_ptr<LocalityTrace>> traces_;
+};
+
+
+/// @brief Wrap a task queued on locality, so that its queue wait and its
+/// execution time are recorded.
+template <typename TaskTy>
+auto TraceTask(uint32_t locality, TaskTy &&task) {
+  return [locality, enqueued = Tracer::Now(),
+          task = std::forward<TaskTy>(task)]() {
+    auto start = Tracer::Now();
+    task();
+    Tracer::Instance().RecordTask(locality, enqueued, start);
+  };
+}
+
+#else
+
+template <typename TaskTy>
+TaskTy &&TraceTask(uint32_t, TaskTy &&task) {
+  return std::forward<TaskTy>(task);
+}
+
+#endif  // defined(SHAD_ENABLE_TRACING)
+
+}  // namespace impl
+
+}  // namespace rt
+}  // namespace shad
+
+#endif  // INCLUDE_SHAD_RUNTIME_TRACING_H_
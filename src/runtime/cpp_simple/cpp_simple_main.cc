@@ -22,10 +22,17 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "shad/runtime/runtime.h"
+
 namespace shad {
 
 extern int main(int argc, char *argv[]);
 
 }  // namespace shad
 
-int main(int argc, char *argv[]) { return shad::main(argc, argv); }
+int main(int argc, char *argv[]) {
+  shad::rt::impl::initialize(argc, argv);
+  int ret = shad::main(argc, argv);
+  shad::rt::impl::finalize();
+  return ret;
+}
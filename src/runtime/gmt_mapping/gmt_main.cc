@@ -24,6 +24,8 @@
 
 #include "gmt/gmt.h"
 
+#include "shad/runtime/runtime.h"
+
 namespace shad {
 
 extern int main(int argc, char* argv[]);
@@ -31,5 +33,8 @@ extern int main(int argc, char* argv[]);
 }  // namespace shad
 
 extern "C" int gmt_main(uint64_t argc, char* argv[]) {
-  return shad::main(argc, argv);
+  shad::rt::impl::initialize(argc, argv);
+  int ret = shad::main(argc, argv);
+  shad::rt::impl::finalize();
+  return ret;
 }
@@ -0,0 +1,49 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+#include "shad/runtime/mappings/shm/shm_scheduler.h"
+#include "shad/runtime/runtime.h"
+
+namespace shad {
+
+extern int main(int argc, char *argv[]);
+
+}  // namespace shad
+
+int main(int argc, char *argv[]) {
+  shad::rt::impl::initialize(argc, argv);
+
+  auto &scheduler = shad::rt::impl::ShmScheduler::Instance();
+
+  scheduler.Start();
+  if (scheduler.ThisLocality() != 0) {
+    scheduler.Serve();
+    return scheduler.Stop();
+  }
+
+  int ret = shad::main(argc, argv);
+  shad::rt::impl::finalize();
+  ret |= scheduler.Stop();
+
+  return ret;
+}
@@ -0,0 +1,1029 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#include "shad/runtime/mappings/shm/shm_scheduler.h"
+
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "shad/runtime/numa.h"
+#include "shad/runtime/task_arena.h"
+#include "shad/runtime/topology.h"
+#include "shad/runtime/tracing.h"
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+namespace {
+
+// Maximum number of threads a locality can spawn to compensate blocked
+// workers.
+constexpr size_t kMaxWorkers = 1024;
+
+// Rounds the progress thread polls the rings before going to sleep.
+constexpr unsigned kSpinRounds = 4096;
+
+// Timeout of the sleep of the progress thread.
+constexpr long kSleepNanoseconds = 1000000;
+
+enum MessageType : uint32_t {
+  kCall,
+  kSpawn,
+  kCallInline,
+  kSpawnInline,
+  kReply,
+  kResult,
+  kAck,
+  kShutdown
+};
+
+uint32_t gLocality = 0;
+thread_local bool tlsIsWorker = false;
+thread_local bool tlsIsProgress = false;
+
+uint64_t readEnv(const char *name, uint64_t defaultValue) {
+  const char *value = std::getenv(name);
+  if (value == nullptr || *value == '\0') return defaultValue;
+  return std::stoull(value);
+}
+
+size_t roundUpToPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value) result <<= 1;
+  return result;
+}
+
+long futex(std::atomic<uint32_t> *address, int operation, uint32_t value,
+           const struct timespec *timeout) {
+  return syscall(SYS_futex, reinterpret_cast<uint32_t *>(address), operation,
+                 value, timeout, nullptr, 0);
+}
+
+struct alignas(64) LocalityControl {
+  std::atomic<uint32_t> doorbell;
+  std::atomic<uint32_t> sleeping;
+  std::atomic<uint32_t> ready;
+  std::atomic<int32_t> pid;
+};
+
+struct alignas(64) RingControl {
+  std::atomic<uint64_t> head;
+  alignas(64) std::atomic<uint64_t> tail;
+};
+
+struct CallState {
+  ShmCounter done;
+  uint8_t *result;
+  uint32_t *resultSize;
+};
+
+void dmaPutWrapper(const uint8_t *payload, size_t size,
+                   ShmCounter *, uint8_t *,
+                   uint32_t *) {
+  uint8_t *address = *reinterpret_cast<uint8_t *const *>(payload);
+  memcpy(address, payload + sizeof(address), size - sizeof(address));
+}
+
+void dmaGetWrapper(const uint8_t *payload, size_t,
+                   ShmCounter *, uint8_t *result,
+                   uint32_t *resultSize) {
+  const uint8_t *address = *reinterpret_cast<const uint8_t *const *>(payload);
+  size_t numBytes = *reinterpret_cast<const size_t *>(payload + sizeof(address));
+  memcpy(result, address, numBytes);
+  *resultSize = numBytes;
+}
+
+// Payload of the vectored transfers: the number of segments, the segments
+// and, for the scatter, the data.
+void dmaScatterWrapper(const uint8_t *payload, size_t,
+                       ShmCounter *, uint8_t *, uint32_t *) {
+  size_t numSegments = *reinterpret_cast<const size_t *>(payload);
+  auto segments = reinterpret_cast<const DmaSegment<uint8_t> *>(
+      payload + sizeof(numSegments));
+  scatterSegments(segments, numSegments,
+                  reinterpret_cast<const uint8_t *>(segments + numSegments));
+}
+
+void dmaGatherWrapper(const uint8_t *payload, size_t,
+                      ShmCounter *, uint8_t *result, uint32_t *resultSize) {
+  size_t numSegments = *reinterpret_cast<const size_t *>(payload);
+  auto segments = reinterpret_cast<const DmaSegment<uint8_t> *>(
+      payload + sizeof(numSegments));
+  gatherSegments(result, segments, numSegments);
+  *resultSize = numSegmentElements(segments, numSegments);
+}
+
+// Transfer the segments with one system call per group of at most IOV_MAX
+// segments.  Returns the number of segments transferred before cross memory
+// attach failed.
+template <typename VectoredCallTy>
+size_t crossMemoryAttachSegments(VectoredCallTy &&call, uint8_t *localData,
+                                 const DmaSegment<uint8_t> *segments,
+                                 size_t numSegments) {
+  constexpr size_t kMaxIov = IOV_MAX;
+  std::vector<struct iovec> remote(std::min(numSegments, kMaxIov));
+  size_t done = 0;
+  while (done < numSegments) {
+    size_t count = std::min(numSegments - done, kMaxIov);
+    size_t numBytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+      remote[i].iov_base = const_cast<uint8_t *>(segments[done + i].address);
+      remote[i].iov_len = segments[done + i].numElements;
+      numBytes += segments[done + i].numElements;
+    }
+    struct iovec local = {localData, numBytes};
+    ssize_t transferred = call(&local, remote.data(), count);
+    if (transferred != static_cast<ssize_t>(numBytes)) {
+      if (transferred < 0 && errno != EPERM && errno != ENOSYS)
+        throw std::system_error(errno, std::generic_category(),
+                                "Remote vectored transfer failed");
+      return done;
+    }
+    localData += numBytes;
+    done += count;
+  }
+  return done;
+}
+
+}  // namespace
+
+struct ShmScheduler::MessageHeader {
+  uint32_t type;
+  uint32_t src;
+  uint64_t size;
+  uint64_t invoker;
+  uint64_t token;
+  uint64_t result;
+  uint64_t resultSize;
+  uint64_t maxResultSize;
+  uint32_t priority;
+};
+
+struct ShmScheduler::ReceiveState {
+  MessageHeader header;
+  size_t headerBytes = 0;
+  std::shared_ptr<uint8_t> payload;
+  size_t payloadBytes = 0;
+};
+
+/// The shared segment starts with this descriptor, followed by the control
+/// block of every locality, and by the control blocks and the data of the
+/// numLocalities^2 rings.  The ring from src to dst is written only by src
+/// and read only by dst.
+struct alignas(64) ShmScheduler::Segment {
+  static size_t Size(uint32_t numLocalities, size_t capacity) {
+    size_t numRings = size_t(numLocalities) * numLocalities;
+    return sizeof(Segment) + sizeof(LocalityControl) * numLocalities +
+           (sizeof(RingControl) + capacity) * numRings;
+  }
+
+  static Segment *Create(uint32_t numLocalities, size_t capacity) {
+    void *base = mmap(nullptr, Size(numLocalities, capacity),
+                      PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED)
+      throw std::system_error(errno, std::generic_category(),
+                              "Unable to allocate the shared segment");
+
+    auto segment = new (base) Segment();
+    segment->numLocalities = numLocalities;
+    segment->capacity = capacity;
+    for (uint32_t L = 0; L < numLocalities; ++L)
+      new (&segment->Control(L)) LocalityControl();
+    for (uint32_t src = 0; src < numLocalities; ++src)
+      for (uint32_t dst = 0; dst < numLocalities; ++dst)
+        new (&segment->Ring(src, dst)) RingControl();
+    return segment;
+  }
+
+  LocalityControl &Control(uint32_t L) {
+    return reinterpret_cast<LocalityControl *>(this + 1)[L];
+  }
+
+  RingControl &Ring(uint32_t src, uint32_t dst) {
+    auto rings = reinterpret_cast<RingControl *>(&Control(numLocalities));
+    return rings[src * numLocalities + dst];
+  }
+
+  uint8_t *RingData(uint32_t src, uint32_t dst) {
+    size_t numRings = size_t(numLocalities) * numLocalities;
+    auto data = reinterpret_cast<uint8_t *>(&Ring(0, 0) + numRings);
+    return data + (src * numLocalities + dst) * capacity;
+  }
+
+  uint32_t numLocalities;
+  size_t capacity;
+};
+
+void ShmCounter::Decrement() {
+  size_t expected = count_.load();
+  while (expected > 1) {
+    if (count_.compare_exchange_weak(expected, expected - 1)) return;
+  }
+
+  // Proxies are not waited for: notify the parent of the task instead.
+  if (parentToken_ != 0) {
+    if (count_.fetch_sub(1) == 1) {
+      ShmScheduler::Instance().SendAck(parentLocality_, parentToken_);
+      delete this;
+    }
+    return;
+  }
+
+  // The last decrement happens under the lock, so that the waiter cannot
+  // destroy the counter before the notification is complete.
+  std::lock_guard<std::mutex> _(mutex_);
+  if (count_.fetch_sub(1) == 1) cv_.notify_all();
+}
+
+void ShmCounter::Wait() {
+  bool blocking = count_ != 0;
+  auto &scheduler = ShmScheduler::Instance();
+  if (blocking) scheduler.EnterBlocking();
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return count_ == 0; });
+  }
+  if (blocking) scheduler.ExitBlocking();
+}
+
+constexpr size_t ShmScheduler::kMaxReturnBufferSize;
+
+ShmScheduler &ShmScheduler::Instance() {
+  static ShmScheduler instance;
+  return instance;
+}
+
+ShmScheduler::ShmScheduler()
+    : segment_(nullptr),
+      crossMemoryAttach_(true),
+      stopProgress_(false),
+      shutdown_(false),
+      stopWorkers_(false),
+      active_(0),
+      idle_(0) {
+  numLocalities_ = std::max<uint64_t>(readEnv("SHAD_SHM_LOCALITIES", 2), 1);
+
+  size_t hwConcurrency = CpuTopology::Instance().WorkerCpus().size();
+  workersPerLocality_ = std::max<uint64_t>(
+      readEnv("SHAD_SHM_WORKERS", hwConcurrency / numLocalities_), 1);
+
+  ringCapacity_ = roundUpToPowerOfTwo(std::max<uint64_t>(
+      readEnv("SHAD_SHM_RING_BYTES", 1 << 20), sizeof(MessageHeader)));
+  segmentSize_ = Segment::Size(numLocalities_, ringCapacity_);
+}
+
+ShmScheduler::~ShmScheduler() {
+  if (segment_ != nullptr) munmap(segment_, segmentSize_);
+}
+
+uint32_t ShmScheduler::ThisLocality() { return gLocality; }
+
+void ShmScheduler::Start() {
+  segment_ = Segment::Create(numLocalities_, ringCapacity_);
+
+  // Fork before starting any thread.
+  pid_t parent = getpid();
+  for (uint32_t L = 1; L < numLocalities_; ++L) {
+    pid_t pid = fork();
+    if (pid < 0)
+      throw std::system_error(errno, std::generic_category(),
+                              "Unable to fork the localities");
+    if (pid == 0) {
+      gLocality = L;
+      prctl(PR_SET_PDEATHSIG, SIGKILL);
+      if (getppid() != parent) _exit(EXIT_FAILURE);
+      break;
+    }
+  }
+
+  // Allow the other localities to access our memory with process_vm_*.
+  prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY, 0, 0, 0);
+
+  auto &control = segment_->Control(gLocality);
+  control.pid = getpid();
+
+  sendLocks_.reset(new std::mutex[numLocalities_]);
+  receiveStates_.resize(numLocalities_);
+
+  // The localities of the node share its CPUs.
+  NumaTopology::Instance().SkipWorkers(gLocality * workersPerLocality_);
+  {
+    std::lock_guard<std::mutex> _(mutex_);
+    for (size_t i = 0; i < workersPerLocality_; ++i) SpawnWorker();
+  }
+  progress_ = std::thread(&ShmScheduler::ProgressLoop, this);
+
+  control.ready = 1;
+  for (uint32_t L = 0; L < numLocalities_; ++L)
+    while (segment_->Control(L).ready == 0) std::this_thread::yield();
+}
+
+void ShmScheduler::Serve() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  shutdownCv_.wait(lock, [this] { return shutdown_; });
+}
+
+int ShmScheduler::Stop() {
+  int status = EXIT_SUCCESS;
+
+  if (gLocality == 0) {
+    {
+      std::lock_guard<std::mutex> _(mutex_);
+      shutdown_ = true;
+    }
+    for (uint32_t L = 1; L < numLocalities_; ++L) {
+      MessageHeader header{kShutdown, gLocality, 0, 0, 0, 0, 0, 0, 0};
+      Send(L, header, nullptr);
+    }
+    for (uint32_t L = 1; L < numLocalities_; ++L) {
+      int childStatus;
+      if (waitpid(segment_->Control(L).pid, &childStatus, 0) < 0 ||
+          !WIFEXITED(childStatus) || WEXITSTATUS(childStatus) != 0)
+        status = EXIT_FAILURE;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> _(mutex_);
+    stopWorkers_ = true;
+    cv_.notify_all();
+  }
+  while (true) {
+    std::vector<std::thread> workers;
+    {
+      std::lock_guard<std::mutex> _(mutex_);
+      workers.swap(workers_);
+    }
+    if (workers.empty()) break;
+    for (auto &worker : workers) worker.join();
+  }
+
+  stopProgress_ = true;
+  auto &control = segment_->Control(gLocality);
+  control.doorbell.fetch_add(1);
+  futex(&control.doorbell, FUTEX_WAKE, 1, nullptr);
+  progress_.join();
+
+  return status;
+}
+
+void ShmScheduler::SpawnWorker() {
+  ++idle_;
+  workers_.emplace_back(&ShmScheduler::WorkerLoop, this);
+}
+
+void ShmScheduler::WorkerLoop() {
+  tlsIsWorker = true;
+  NumaTopology::Instance().PinWorker();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    if (!HasPendingTasks()) {
+      if (stopWorkers_) break;
+      cv_.wait(lock);
+      continue;
+    }
+
+    // Too many workers are running: leave the task to the ones that are
+    // still busy.
+    if (active_ >= workersPerLocality_) {
+      cv_.wait(lock);
+      continue;
+    }
+
+    size_t priority = 0;
+    while (inbox_[priority].empty()) ++priority;
+
+    TaskTy task = std::move(inbox_[priority].front());
+    inbox_[priority].pop_front();
+    --idle_;
+    ++active_;
+    if (HasPendingTasks()) cv_.notify_one();
+    lock.unlock();
+
+    {
+      PriorityScope scope(static_cast<Priority>(priority));
+      task();
+    }
+
+    lock.lock();
+    --active_;
+    ++idle_;
+  }
+  --idle_;
+  cv_.notify_all();
+}
+
+bool ShmScheduler::HasPendingTasks() const {
+  for (auto &queue : inbox_)
+    if (!queue.empty()) return true;
+  return false;
+}
+
+void ShmScheduler::Post(TaskTy &&task, Priority priority) {
+  std::lock_guard<std::mutex> _(mutex_);
+  inbox_[static_cast<size_t>(priority)].push_back(
+      TraceTask(gLocality, std::move(task)));
+  if (idle_ == 0 && active_ < workersPerLocality_ &&
+      workers_.size() < kMaxWorkers && !stopWorkers_)
+    SpawnWorker();
+  cv_.notify_one();
+}
+
+size_t ShmScheduler::QueueDepth(Priority p) {
+  std::lock_guard<std::mutex> _(mutex_);
+  return inbox_[static_cast<size_t>(p)].size();
+}
+
+void ShmScheduler::EnterBlocking() {
+  if (!tlsIsWorker) return;
+
+  std::lock_guard<std::mutex> _(mutex_);
+  --active_;
+  if (idle_ == 0 && HasPendingTasks() && workers_.size() < kMaxWorkers &&
+      !stopWorkers_)
+    SpawnWorker();
+  cv_.notify_one();
+}
+
+void ShmScheduler::ExitBlocking() {
+  if (!tlsIsWorker) return;
+
+  std::lock_guard<std::mutex> _(mutex_);
+  ++active_;
+}
+
+void ShmScheduler::RingWrite(uint32_t dst, const uint8_t *data, size_t size) {
+  auto &ring = segment_->Ring(gLocality, dst);
+  auto &control = segment_->Control(dst);
+  uint8_t *ringData = segment_->RingData(gLocality, dst);
+
+  while (size) {
+    uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    uint64_t head = ring.head.load(std::memory_order_acquire);
+    size_t available = ringCapacity_ - (tail - head);
+    if (available == 0) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    size_t toWrite = std::min(available, size);
+    size_t offset = tail & (ringCapacity_ - 1);
+    size_t firstPart = std::min(toWrite, ringCapacity_ - offset);
+    memcpy(ringData + offset, data, firstPart);
+    memcpy(ringData, data + firstPart, toWrite - firstPart);
+    ring.tail.store(tail + toWrite, std::memory_order_release);
+
+    data += toWrite;
+    size -= toWrite;
+
+    control.doorbell.fetch_add(1);
+    if (control.sleeping.load()) futex(&control.doorbell, FUTEX_WAKE, 1, nullptr);
+  }
+}
+
+void ShmScheduler::Send(uint32_t dst, const MessageHeader &header,
+                        const uint8_t *payload) {
+  std::lock_guard<std::mutex> _(sendLocks_[dst]);
+  RingWrite(dst, reinterpret_cast<const uint8_t *>(&header), sizeof(header));
+  if (header.size) RingWrite(dst, payload, header.size);
+}
+
+bool ShmScheduler::Poll(uint32_t src) {
+  auto &ring = segment_->Ring(src, gLocality);
+  const uint8_t *ringData = segment_->RingData(src, gLocality);
+
+  uint64_t head = ring.head.load(std::memory_order_relaxed);
+  uint64_t tail = ring.tail.load(std::memory_order_acquire);
+  if (head == tail) return false;
+
+  auto read = [&](uint8_t *dst, size_t size) {
+    size_t offset = head & (ringCapacity_ - 1);
+    size_t firstPart = std::min(size, ringCapacity_ - offset);
+    memcpy(dst, ringData + offset, firstPart);
+    memcpy(dst + firstPart, ringData, size - firstPart);
+    head += size;
+  };
+
+  auto &state = receiveStates_[src];
+  while (head != tail) {
+    size_t available = tail - head;
+    if (state.headerBytes < sizeof(MessageHeader)) {
+      size_t toRead =
+          std::min(available, sizeof(MessageHeader) - state.headerBytes);
+      read(reinterpret_cast<uint8_t *>(&state.header) + state.headerBytes,
+           toRead);
+      state.headerBytes += toRead;
+      if (state.headerBytes < sizeof(MessageHeader)) continue;
+      if (state.header.size != 0)
+        state.payload = allocateArgsBuffer(state.header.size);
+      else
+        state.payload.reset();
+      state.payloadBytes = 0;
+    } else {
+      size_t toRead =
+          std::min(available, state.header.size - state.payloadBytes);
+      read(state.payload.get() + state.payloadBytes, toRead);
+      state.payloadBytes += toRead;
+    }
+
+    if (state.payloadBytes == state.header.size) {
+      ring.head.store(head, std::memory_order_release);
+      Dispatch(src, state);
+      state.headerBytes = 0;
+      state.payloadBytes = 0;
+    }
+  }
+  ring.head.store(head, std::memory_order_release);
+  return true;
+}
+
+void ShmScheduler::Dispatch(uint32_t src, ReceiveState &state) {
+  const MessageHeader header = state.header;
+  std::shared_ptr<uint8_t> payload = std::move(state.payload);
+
+  auto priority = static_cast<Priority>(header.priority);
+  switch (header.type) {
+    case kCall:
+      Post([this, header, payload] {
+        std::unique_ptr<uint8_t[]> result(
+            header.maxResultSize ? new uint8_t[header.maxResultSize]
+                                 : nullptr);
+        uint32_t resultSize = 0;
+        auto invoker = reinterpret_cast<ShmInvokerTy>(header.invoker);
+        invoker(payload.get(), header.size, nullptr, result.get(),
+                &resultSize);
+
+        MessageHeader reply{kReply, gLocality, resultSize, 0,
+                            header.token, 0, 0, 0, 0};
+        Send(header.src, reply, result.get());
+      }, priority);
+      break;
+    case kSpawn:
+      Post([this, header, payload] {
+        auto proxy = new ShmCounter(header.src, header.token);
+        std::unique_ptr<uint8_t[]> result(
+            header.maxResultSize ? new uint8_t[header.maxResultSize]
+                                 : nullptr);
+        uint32_t resultSize = 0;
+        auto invoker = reinterpret_cast<ShmInvokerTy>(header.invoker);
+        invoker(payload.get(), header.size, proxy, result.get(), &resultSize);
+
+        if (header.result) {
+          MessageHeader reply{kResult, gLocality,         resultSize, 0, 0,
+                              header.result, header.resultSize, 0,    0};
+          Send(header.src, reply, result.get());
+        }
+        proxy->Decrement();
+      }, priority);
+      break;
+    case kCallInline: {
+      std::shared_ptr<uint8_t> result(
+          header.maxResultSize ? new uint8_t[header.maxResultSize] : nullptr,
+          std::default_delete<uint8_t[]>());
+      uint32_t resultSize = 0;
+      auto invoker = reinterpret_cast<ShmInvokerTy>(header.invoker);
+      invoker(payload.get(), header.size, nullptr, result.get(), &resultSize);
+
+      // The progress thread never writes into the rings (see SendAck).
+      MessageHeader reply{kReply, gLocality, resultSize, 0,
+                          header.token, 0, 0, 0, 0};
+      Post([this, header, reply, result] {
+        Send(header.src, reply, result.get());
+      }, Priority::kLatency);
+      break;
+    }
+    case kSpawnInline: {
+      std::shared_ptr<uint8_t> result(
+          header.maxResultSize ? new uint8_t[header.maxResultSize] : nullptr,
+          std::default_delete<uint8_t[]>());
+      uint32_t resultSize = 0;
+      auto invoker = reinterpret_cast<ShmInvokerTy>(header.invoker);
+      invoker(payload.get(), header.size, nullptr, result.get(), &resultSize);
+
+      Post([this, header, resultSize, result] {
+        if (header.result) {
+          MessageHeader reply{kResult, gLocality,         resultSize, 0, 0,
+                              header.result, header.resultSize, 0,    0};
+          Send(header.src, reply, result.get());
+        }
+        SendAck(header.src, header.token);
+      }, Priority::kLatency);
+      break;
+    }
+    case kReply: {
+      auto call = reinterpret_cast<CallState *>(header.token);
+      if (call->result && header.size)
+        memcpy(call->result, payload.get(), header.size);
+      if (call->resultSize) *call->resultSize = header.size;
+      call->done.Decrement();
+      break;
+    }
+    case kResult:
+      if (header.size)
+        memcpy(reinterpret_cast<uint8_t *>(header.result), payload.get(),
+               header.size);
+      if (header.resultSize)
+        *reinterpret_cast<uint32_t *>(header.resultSize) = header.size;
+      break;
+    case kAck: {
+      reinterpret_cast<ShmCounter *>(header.token)->Decrement();
+      break;
+    }
+    case kShutdown: {
+      std::lock_guard<std::mutex> _(mutex_);
+      shutdown_ = true;
+      shutdownCv_.notify_all();
+      break;
+    }
+  }
+}
+
+void ShmScheduler::CheckLocalities() {
+  if (gLocality != 0) return;
+
+  {
+    std::lock_guard<std::mutex> _(mutex_);
+    if (shutdown_) return;
+  }
+
+  siginfo_t info;
+  info.si_pid = 0;
+  if (waitid(P_ALL, 0, &info, WEXITED | WNOHANG | WNOWAIT) != 0 ||
+      info.si_pid == 0)
+    return;
+
+  fprintf(stderr, "SHAD: a locality terminated unexpectedly, aborting.\n");
+  for (uint32_t L = 1; L < numLocalities_; ++L)
+    kill(segment_->Control(L).pid, SIGKILL);
+  _exit(EXIT_FAILURE);
+}
+
+void ShmScheduler::ProgressLoop() {
+  tlsIsProgress = true;
+  CpuTopology::Instance().PinProgressThread();
+
+  auto &control = segment_->Control(gLocality);
+  unsigned spins = 0;
+  while (!stopProgress_) {
+    bool progress = false;
+    for (uint32_t src = 0; src < numLocalities_; ++src) {
+      if (src != gLocality) progress |= Poll(src);
+    }
+
+    if (progress) {
+      spins = 0;
+      continue;
+    }
+
+    if (++spins < kSpinRounds) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    uint32_t sequence = control.doorbell.load();
+    control.sleeping.store(1);
+    bool pending = false;
+    for (uint32_t src = 0; src < numLocalities_; ++src) {
+      auto &ring = segment_->Ring(src, gLocality);
+      pending |= ring.head.load() != ring.tail.load();
+    }
+    if (!pending && !stopProgress_) {
+      struct timespec timeout = {0, kSleepNanoseconds};
+      futex(&control.doorbell, FUTEX_WAIT, sequence, &timeout);
+    }
+    control.sleeping.store(0);
+    spins = 0;
+
+    CheckLocalities();
+  }
+}
+
+void ShmScheduler::Call(uint32_t dst, ShmInvokerTy invoker,
+                        const uint8_t *payload, size_t size, uint8_t *result,
+                        uint32_t *resultSize, size_t maxResultSize) {
+  if (dst == gLocality) {
+    uint32_t localResultSize = 0;
+    invoker(payload, size, nullptr, result,
+            resultSize ? resultSize : &localResultSize);
+    return;
+  }
+
+  CallState call;
+  call.result = result;
+  call.resultSize = resultSize;
+  call.done.Increment();
+
+  MessageHeader header{kCall,
+                       gLocality,
+                       size,
+                       reinterpret_cast<uint64_t>(invoker),
+                       reinterpret_cast<uint64_t>(&call),
+                       0,
+                       0,
+                       maxResultSize,
+                       static_cast<uint32_t>(CurrentPriority())};
+  Send(dst, header, payload);
+  call.done.Wait();
+}
+
+void ShmScheduler::Spawn(uint32_t dst,
+                         ShmCounter *counter,
+                         ShmInvokerTy invoker, const uint8_t *payload,
+                         size_t size, uint8_t *result, uint32_t *resultSize,
+                         size_t maxResultSize) {
+  counter->Increment();
+
+  if (dst == gLocality) {
+    std::shared_ptr<uint8_t> buffer = allocateArgsBuffer(size);
+    memcpy(buffer.get(), payload, size);
+    Post([=] {
+      uint32_t localResultSize = 0;
+      invoker(buffer.get(), size, counter, result,
+              resultSize ? resultSize : &localResultSize);
+      counter->Decrement();
+    });
+    return;
+  }
+
+  MessageHeader header{kSpawn,
+                       gLocality,
+                       size,
+                       reinterpret_cast<uint64_t>(invoker),
+                       reinterpret_cast<uint64_t>(counter),
+                       reinterpret_cast<uint64_t>(result),
+                       reinterpret_cast<uint64_t>(resultSize),
+                       maxResultSize,
+                       static_cast<uint32_t>(CurrentPriority())};
+  Send(dst, header, payload);
+}
+
+void ShmScheduler::CallInline(uint32_t dst, ShmInvokerTy invoker,
+                              const uint8_t *payload, size_t size,
+                              uint8_t *result, uint32_t *resultSize,
+                              size_t maxResultSize) {
+  if (dst == gLocality) {
+    uint32_t localResultSize = 0;
+    invoker(payload, size, nullptr, result,
+            resultSize ? resultSize : &localResultSize);
+    return;
+  }
+
+  CallState call;
+  call.result = result;
+  call.resultSize = resultSize;
+  call.done.Increment();
+
+  MessageHeader header{kCallInline,
+                       gLocality,
+                       size,
+                       reinterpret_cast<uint64_t>(invoker),
+                       reinterpret_cast<uint64_t>(&call),
+                       0,
+                       0,
+                       maxResultSize,
+                       static_cast<uint32_t>(CurrentPriority())};
+  Send(dst, header, payload);
+  call.done.Wait();
+}
+
+void ShmScheduler::SpawnInline(uint32_t dst, ShmCounter *counter,
+                               ShmInvokerTy invoker, const uint8_t *payload,
+                               size_t size, uint8_t *result,
+                               uint32_t *resultSize, size_t maxResultSize) {
+  if (dst == gLocality) {
+    uint32_t localResultSize = 0;
+    invoker(payload, size, nullptr, result,
+            resultSize ? resultSize : &localResultSize);
+    return;
+  }
+
+  counter->Increment();
+  MessageHeader header{kSpawnInline,
+                       gLocality,
+                       size,
+                       reinterpret_cast<uint64_t>(invoker),
+                       reinterpret_cast<uint64_t>(counter),
+                       reinterpret_cast<uint64_t>(result),
+                       reinterpret_cast<uint64_t>(resultSize),
+                       maxResultSize,
+                       static_cast<uint32_t>(CurrentPriority())};
+  Send(dst, header, payload);
+}
+
+ShmCounter *ShmScheduler::AcquireCounter() {
+  std::lock_guard<std::mutex> _(countersLock_);
+  if (freeCounters_.empty()) return new ShmCounter();
+
+  ShmCounter *counter = freeCounters_.back();
+  freeCounters_.pop_back();
+  return counter;
+}
+
+void ShmScheduler::ReleaseCounter(ShmCounter *counter) {
+  std::lock_guard<std::mutex> _(countersLock_);
+  freeCounters_.push_back(counter);
+}
+
+void ShmScheduler::SendAck(uint32_t dst, uint64_t token) {
+  MessageHeader header{kAck, gLocality, 0, 0, token, 0, 0, 0, 0};
+
+  // The progress thread never writes into the rings: a full ring would stop
+  // it from draining the incoming ones.  Acks release waiting threads, so
+  // they skip the queue.
+  if (tlsIsProgress) {
+    Post([this, dst, header] { Send(dst, header, nullptr); },
+         Priority::kLatency);
+    return;
+  }
+  Send(dst, header, nullptr);
+}
+
+void ShmScheduler::Put(uint32_t dst, void *remoteAddress, const void *localData,
+                       size_t numBytes) {
+  if (dst == gLocality) {
+    memcpy(remoteAddress, localData, numBytes);
+    return;
+  }
+
+  // Single copy through cross memory attach, when the system allows it.
+  if (crossMemoryAttach_.load(std::memory_order_relaxed)) {
+    struct iovec local = {const_cast<void *>(localData), numBytes};
+    struct iovec remote = {remoteAddress, numBytes};
+    ssize_t written = process_vm_writev(segment_->Control(dst).pid, &local, 1,
+                                        &remote, 1, 0);
+    if (written == static_cast<ssize_t>(numBytes)) return;
+    if (written < 0 && errno != EPERM && errno != ENOSYS)
+      throw std::system_error(errno, std::generic_category(),
+                              "Remote write failed");
+    crossMemoryAttach_.store(false, std::memory_order_relaxed);
+  }
+
+  std::vector<uint8_t> payload(sizeof(remoteAddress) + numBytes);
+  memcpy(payload.data(), &remoteAddress, sizeof(remoteAddress));
+  memcpy(payload.data() + sizeof(remoteAddress), localData, numBytes);
+  Call(dst, dmaPutWrapper, payload.data(), payload.size(), nullptr, nullptr,
+       0);
+}
+
+void ShmScheduler::Get(void *localAddress, uint32_t src,
+                       const void *remoteData, size_t numBytes) {
+  if (src == gLocality) {
+    memcpy(localAddress, remoteData, numBytes);
+    return;
+  }
+
+  if (crossMemoryAttach_.load(std::memory_order_relaxed)) {
+    struct iovec local = {localAddress, numBytes};
+    struct iovec remote = {const_cast<void *>(remoteData), numBytes};
+    ssize_t read = process_vm_readv(segment_->Control(src).pid, &local, 1,
+                                    &remote, 1, 0);
+    if (read == static_cast<ssize_t>(numBytes)) return;
+    if (read < 0 && errno != EPERM && errno != ENOSYS)
+      throw std::system_error(errno, std::generic_category(),
+                              "Remote read failed");
+    crossMemoryAttach_.store(false, std::memory_order_relaxed);
+  }
+
+  uint8_t payload[sizeof(remoteData) + sizeof(numBytes)];
+  memcpy(payload, &remoteData, sizeof(remoteData));
+  memcpy(payload + sizeof(remoteData), &numBytes, sizeof(numBytes));
+  Call(src, dmaGetWrapper, payload, sizeof(payload),
+       reinterpret_cast<uint8_t *>(localAddress), nullptr, numBytes);
+}
+
+void ShmScheduler::Scatter(uint32_t dst,
+                           const DmaSegment<uint8_t> *remoteSegments,
+                           size_t numSegments, const void *localData) {
+  auto data = reinterpret_cast<const uint8_t *>(localData);
+  if (dst == gLocality) {
+    scatterSegments(remoteSegments, numSegments, data);
+    return;
+  }
+
+  if (crossMemoryAttach_.load(std::memory_order_relaxed)) {
+    pid_t pid = segment_->Control(dst).pid;
+    size_t done = crossMemoryAttachSegments(
+        [pid](struct iovec *local, struct iovec *remote, size_t count) {
+          return process_vm_writev(pid, local, 1, remote, count, 0);
+        },
+        const_cast<uint8_t *>(data), remoteSegments, numSegments);
+    if (done == numSegments) return;
+    crossMemoryAttach_.store(false, std::memory_order_relaxed);
+    data += numSegmentElements(remoteSegments, done);
+    remoteSegments += done;
+    numSegments -= done;
+  }
+
+  size_t numBytes = numSegmentElements(remoteSegments, numSegments);
+  size_t segmentsSize = numSegments * sizeof(DmaSegment<uint8_t>);
+  std::vector<uint8_t> payload(sizeof(numSegments) + segmentsSize + numBytes);
+  memcpy(payload.data(), &numSegments, sizeof(numSegments));
+  memcpy(payload.data() + sizeof(numSegments), remoteSegments, segmentsSize);
+  memcpy(payload.data() + sizeof(numSegments) + segmentsSize, data, numBytes);
+  Call(dst, dmaScatterWrapper, payload.data(), payload.size(), nullptr,
+       nullptr, 0);
+}
+
+void ShmScheduler::Gather(void *localAddress, uint32_t src,
+                          const DmaSegment<uint8_t> *remoteSegments,
+                          size_t numSegments) {
+  auto data = reinterpret_cast<uint8_t *>(localAddress);
+  if (src == gLocality) {
+    gatherSegments(data, remoteSegments, numSegments);
+    return;
+  }
+
+  if (crossMemoryAttach_.load(std::memory_order_relaxed)) {
+    pid_t pid = segment_->Control(src).pid;
+    size_t done = crossMemoryAttachSegments(
+        [pid](struct iovec *local, struct iovec *remote, size_t count) {
+          return process_vm_readv(pid, local, 1, remote, count, 0);
+        },
+        data, remoteSegments, numSegments);
+    if (done == numSegments) return;
+    crossMemoryAttach_.store(false, std::memory_order_relaxed);
+    data += numSegmentElements(remoteSegments, done);
+    remoteSegments += done;
+    numSegments -= done;
+  }
+
+  size_t segmentsSize = numSegments * sizeof(DmaSegment<uint8_t>);
+  std::vector<uint8_t> payload(sizeof(numSegments) + segmentsSize);
+  memcpy(payload.data(), &numSegments, sizeof(numSegments));
+  memcpy(payload.data() + sizeof(numSegments), remoteSegments, segmentsSize);
+  Call(src, dmaGatherWrapper, payload.data(), payload.size(), data, nullptr,
+       numSegmentElements(remoteSegments, numSegments));
+}
+
+void ShmScheduler::AsyncParallelFor(ShmCounter *counter,
+                                    size_t numIters, RangeTaskTy &&task) {
+  if (numIters == 0) return;
+
+  // Over-decompose to balance the load among the workers.
+  size_t numChunks = std::min(numIters, workersPerLocality_ * 4);
+  size_t chunkSize = (numIters + numChunks - 1) / numChunks;
+  auto sharedTask = std::make_shared<RangeTaskTy>(std::move(task));
+
+  for (size_t begin = 0; begin < numIters; begin += chunkSize) {
+    size_t end = std::min(begin + chunkSize, numIters);
+    counter->Increment();
+    Post([=] {
+      (*sharedTask)(begin, end);
+      counter->Decrement();
+    });
+  }
+}
+
+void ShmScheduler::ParallelFor(size_t numIters, RangeTaskTy &&task) {
+  ShmCounter counter;
+  AsyncParallelFor(&counter, numIters, std::move(task));
+  counter.Wait();
+}
+
+}  // namespace impl
+
+}  // namespace rt
+}  // namespace shad
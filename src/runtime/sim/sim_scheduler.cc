@@ -0,0 +1,342 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#include "shad/runtime/mappings/sim/sim_scheduler.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "shad/runtime/numa.h"
+#include "shad/runtime/topology.h"
+#include "shad/runtime/tracing.h"
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+namespace {
+
+// Maximum number of threads a locality can spawn to compensate blocked
+// workers.
+constexpr size_t kMaxWorkersPerLocality = 1024;
+
+// Injected delays shorter than this are spent spinning: sleeping is not
+// accurate enough at this granularity.
+constexpr std::chrono::microseconds kSpinThreshold(100);
+
+thread_local uint32_t tlsLocality = 0;
+thread_local bool tlsIsWorker = false;
+
+uint64_t readEnv(const char *name, uint64_t defaultValue) {
+  const char *value = std::getenv(name);
+  if (value == nullptr || *value == '\0') return defaultValue;
+  return std::stoull(value);
+}
+
+}  // namespace
+
+struct SimScheduler::LocalityState {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<Message> inbox[kNumPriorities];
+  ClockTy::time_point lastArrival;
+  std::vector<std::thread> workers;
+  size_t active = 0;
+  size_t idle = 0;
+  bool stop = false;
+
+  bool Empty() const {
+    for (auto &queue : inbox)
+      if (!queue.empty()) return false;
+    return true;
+  }
+};
+
+void SimCounter::Wait() {
+  if (count_ == 0) return;
+
+  auto &scheduler = SimScheduler::Instance();
+  scheduler.EnterBlocking();
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return count_ == 0; });
+  }
+  scheduler.ExitBlocking();
+}
+
+SimScheduler &SimScheduler::Instance() {
+  static SimScheduler instance;
+  return instance;
+}
+
+SimScheduler::SimScheduler() : running_(false) {
+  numLocalities_ = std::max<uint64_t>(readEnv("SHAD_SIM_LOCALITIES", 2), 1);
+
+  size_t hwConcurrency = CpuTopology::Instance().WorkerCpus().size();
+  workersPerLocality_ = std::max<uint64_t>(
+      readEnv("SHAD_SIM_WORKERS", hwConcurrency / numLocalities_), 1);
+
+  latency_ = std::chrono::nanoseconds(readEnv("SHAD_SIM_LATENCY_NS", 0));
+
+  // 1 MB/s == 1e-3 bytes/ns.
+  bytesPerNanosecond_ = readEnv("SHAD_SIM_BANDWIDTH_MBPS", 0) * 1e-3;
+
+  for (uint32_t L = 0; L < numLocalities_; ++L)
+    localities_.emplace_back(new LocalityState());
+}
+
+SimScheduler::~SimScheduler() { Stop(); }
+
+uint32_t SimScheduler::ThisLocality() { return tlsLocality; }
+
+void SimScheduler::Start() {
+  if (running_) return;
+  running_ = true;
+
+  for (uint32_t L = 0; L < numLocalities_; ++L) {
+    auto &state = *localities_[L];
+    std::lock_guard<std::mutex> _(state.mutex);
+    state.stop = false;
+    for (size_t i = 0; i < workersPerLocality_; ++i) SpawnWorker(state, L);
+  }
+}
+
+void SimScheduler::Stop() {
+  if (!running_) return;
+
+  for (auto &state : localities_) {
+    std::lock_guard<std::mutex> _(state->mutex);
+    state->stop = true;
+    state->cv.notify_all();
+  }
+
+  // Workers exit once their inbox is drained; compensation workers can still
+  // be spawned while draining, hence the lock around the list of workers.
+  for (auto &state : localities_) {
+    while (true) {
+      std::vector<std::thread> workers;
+      {
+        std::lock_guard<std::mutex> _(state->mutex);
+        workers.swap(state->workers);
+      }
+      if (workers.empty()) break;
+      for (auto &worker : workers) worker.join();
+    }
+  }
+
+  running_ = false;
+}
+
+void SimScheduler::SpawnWorker(LocalityState &state, uint32_t locality) {
+  ++state.idle;
+  state.workers.emplace_back(&SimScheduler::WorkerLoop, this, locality);
+}
+
+void SimScheduler::WorkerLoop(uint32_t locality) {
+  tlsLocality = locality;
+  tlsIsWorker = true;
+  NumaTopology::Instance().PinWorker();
+
+  auto &state = *localities_[locality];
+  std::unique_lock<std::mutex> lock(state.mutex);
+  while (true) {
+    if (state.Empty()) {
+      if (state.stop) break;
+      state.cv.wait(lock);
+      continue;
+    }
+
+    // Too many workers are running: leave the message to the ones that
+    // are still busy.
+    if (state.active >= workersPerLocality_) {
+      state.cv.wait(lock);
+      continue;
+    }
+
+    // Serve the most urgent class with a delivered message.
+    auto now = ClockTy::now();
+    auto nextArrival = ClockTy::time_point::max();
+    size_t selected = kNumPriorities;
+    for (size_t p = 0; p < kNumPriorities; ++p) {
+      if (state.inbox[p].empty()) continue;
+      auto readyAt = state.inbox[p].front().readyAt;
+      if (readyAt <= now) {
+        selected = p;
+        break;
+      }
+      nextArrival = std::min(nextArrival, readyAt);
+    }
+
+    if (selected == kNumPriorities) {
+      auto remaining = nextArrival - now;
+      if (remaining > kSpinThreshold) {
+        state.cv.wait_for(lock, remaining - kSpinThreshold);
+      } else {
+        lock.unlock();
+        std::this_thread::yield();
+        lock.lock();
+      }
+      continue;
+    }
+
+    auto &queue = state.inbox[selected];
+    TaskTy task = std::move(queue.front().task);
+    queue.pop_front();
+    --state.idle;
+    ++state.active;
+    if (!state.Empty()) state.cv.notify_one();
+    lock.unlock();
+
+    {
+      PriorityScope scope(static_cast<Priority>(selected));
+      task();
+    }
+
+    lock.lock();
+    --state.active;
+    ++state.idle;
+  }
+  --state.idle;
+  state.cv.notify_all();
+}
+
+SimScheduler::ClockTy::duration SimScheduler::TransferTime(
+    size_t numBytes) const {
+  if (bytesPerNanosecond_ == 0) return ClockTy::duration::zero();
+  return std::chrono::duration_cast<ClockTy::duration>(
+      std::chrono::nanoseconds(
+          static_cast<uint64_t>(numBytes / bytesPerNanosecond_)));
+}
+
+void SimScheduler::Delay(ClockTy::duration duration) const {
+  if (duration <= ClockTy::duration::zero()) return;
+
+  auto deadline = ClockTy::now() + duration;
+  if (duration > kSpinThreshold)
+    std::this_thread::sleep_until(deadline - kSpinThreshold);
+  while (ClockTy::now() < deadline) std::this_thread::yield();
+}
+
+void SimScheduler::Post(uint32_t dst, size_t numBytes, TaskTy &&task) {
+  auto &state = *localities_[dst];
+  auto now = ClockTy::now();
+
+  std::lock_guard<std::mutex> _(state.mutex);
+  ClockTy::time_point readyAt = now;
+  if (dst != tlsLocality) {
+    // The inbound link of the target locality is shared by all the senders:
+    // a message starts its transfer when the previous one is delivered.
+    readyAt = std::max(now + latency_, state.lastArrival) +
+              TransferTime(numBytes);
+    state.lastArrival = readyAt;
+  }
+  auto priority = static_cast<size_t>(CurrentPriority());
+  state.inbox[priority].push_back(
+      Message{readyAt, TraceTask(dst, std::move(task))});
+
+  if (state.idle == 0 && state.active < workersPerLocality_ &&
+      state.workers.size() < kMaxWorkersPerLocality && !state.stop)
+    SpawnWorker(state, dst);
+  state.cv.notify_one();
+}
+
+size_t SimScheduler::QueueDepth(uint32_t locality, Priority p) {
+  auto &state = *localities_[locality];
+  std::lock_guard<std::mutex> _(state.mutex);
+  return state.inbox[static_cast<size_t>(p)].size();
+}
+
+void SimScheduler::Call(uint32_t dst, size_t numBytes,
+                        const std::function<size_t()> &task) {
+  if (dst == tlsLocality) {
+    task();
+    return;
+  }
+
+  auto done = std::make_shared<SimCounter>();
+  auto replyBytes = std::make_shared<size_t>(0);
+  done->Increment();
+  Post(dst, numBytes, [&task, done, replyBytes] {
+    *replyBytes = task();
+    done->Decrement();
+  });
+  done->Wait();
+
+  Delay(latency_ + TransferTime(*replyBytes));
+}
+
+void SimScheduler::AsyncParallelFor(const std::shared_ptr<SimCounter> &counter,
+                                    size_t numIters, RangeTaskTy &&task) {
+  if (numIters == 0) return;
+
+  // Over-decompose to balance the load among the workers.
+  size_t numChunks = std::min(numIters, workersPerLocality_ * 4);
+  size_t chunkSize = (numIters + numChunks - 1) / numChunks;
+  auto sharedTask = std::make_shared<RangeTaskTy>(std::move(task));
+
+  for (size_t begin = 0; begin < numIters; begin += chunkSize) {
+    size_t end = std::min(begin + chunkSize, numIters);
+    counter->Increment();
+    Post(tlsLocality, 0, [=] {
+      (*sharedTask)(begin, end);
+      counter->Decrement();
+    });
+  }
+}
+
+void SimScheduler::ParallelFor(size_t numIters, RangeTaskTy &&task) {
+  auto counter = std::make_shared<SimCounter>();
+  AsyncParallelFor(counter, numIters, std::move(task));
+  counter->Wait();
+}
+
+void SimScheduler::EnterBlocking() {
+  if (!tlsIsWorker) return;
+
+  auto &state = *localities_[tlsLocality];
+  std::lock_guard<std::mutex> _(state.mutex);
+  --state.active;
+  if (state.idle == 0 && !state.Empty() &&
+      state.workers.size() < kMaxWorkersPerLocality && !state.stop)
+    SpawnWorker(state, tlsLocality);
+  state.cv.notify_one();
+}
+
+void SimScheduler::ExitBlocking() {
+  if (!tlsIsWorker) return;
+
+  auto &state = *localities_[tlsLocality];
+  std::lock_guard<std::mutex> _(state.mutex);
+  ++state.active;
+}
+
+}  // namespace impl
+
+}  // namespace rt
+}  // namespace shad
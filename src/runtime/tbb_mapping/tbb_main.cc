@@ -22,10 +22,43 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "tbb/global_control.h"
+#include "tbb/task_scheduler_observer.h"
+
+#include "shad/runtime/numa.h"
+#include "shad/runtime/runtime.h"
+
 namespace shad {
 
 extern int main(int argc, char *argv[]);
 
+namespace {
+
+// Pins the workers of TBB to the NUMA domains when they first join the
+// arena of the main thread.
+class NumaObserver : public tbb::task_scheduler_observer {
+ public:
+  NumaObserver() { observe(true); }
+  ~NumaObserver() { observe(false); }
+
+  void on_scheduler_entry(bool isWorker) override {
+    if (isWorker) rt::impl::NumaTopology::Instance().PinWorker();
+  }
+};
+
+}  // namespace
+
 }  // namespace shad
 
-int main(int argc, char *argv[]) { return shad::main(argc, argv); }
+int main(int argc, char *argv[]) {
+  shad::rt::impl::initialize(argc, argv);
+
+  // Keep the workers off the reserved cores.
+  tbb::global_control parallelism(
+      tbb::global_control::max_allowed_parallelism,
+      shad::rt::impl::getConcurrency());
+  shad::NumaObserver observer;
+  int ret = shad::main(argc, argv);
+  shad::rt::impl::finalize();
+  return ret;
+}
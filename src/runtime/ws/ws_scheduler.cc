@@ -0,0 +1,287 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#include "shad/runtime/mappings/ws/ws_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+#include "shad/runtime/numa.h"
+#include "shad/runtime/task_arena.h"
+#include "shad/runtime/topology.h"
+#include "shad/runtime/tracing.h"
+
+namespace shad {
+namespace rt {
+
+namespace impl {
+
+namespace {
+
+// Rounds an idle thread looks for work before going to sleep.
+constexpr unsigned kSpinRounds = 256;
+
+// Number of pieces per worker a parallel loop is split into.
+constexpr size_t kPiecesPerWorker = 8;
+
+constexpr size_t kNotAWorker = static_cast<size_t>(-1);
+
+thread_local size_t tlsWorkerId = kNotAWorker;
+thread_local uint64_t tlsSeed = 0;
+
+size_t randomVictim(size_t numWorkers) {
+  if (tlsSeed == 0)
+    tlsSeed = std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1;
+  tlsSeed ^= tlsSeed << 13;
+  tlsSeed ^= tlsSeed >> 7;
+  tlsSeed ^= tlsSeed << 17;
+  return tlsSeed % numWorkers;
+}
+
+}  // namespace
+
+void WsCounter::Wait() {
+  auto &scheduler = WsScheduler::Instance();
+  unsigned idleRounds = 0;
+  while (count_.load() != 0) {
+    if (scheduler.RunOne()) {
+      idleRounds = 0;
+      continue;
+    }
+
+    if (++idleRounds < kSpinRounds) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    // Nothing to help with: the outstanding tasks are running elsewhere.
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait_for(lock, std::chrono::microseconds(100),
+                 [this] { return count_.load() == 0; });
+    idleRounds = 0;
+  }
+}
+
+WsScheduler &WsScheduler::Instance() {
+  static WsScheduler instance;
+  return instance;
+}
+
+WsScheduler::WsScheduler() : numSleeping_(0), stop_(false) {
+  numWorkers_ = CpuTopology::Instance().WorkerCpus().size();
+  const char *workers = std::getenv("SHAD_WS_WORKERS");
+  if (workers != nullptr && *workers != '\0')
+    numWorkers_ = std::max<size_t>(std::stoul(workers), 1);
+
+  for (size_t p = 0; p < kNumPriorities; ++p) {
+    injectionSize_[p] = 0;
+    for (size_t i = 0; i < numWorkers_; ++i)
+      deques_[p].emplace_back(new WsDeque<TaskTy *>());
+  }
+}
+
+WsScheduler::~WsScheduler() {}
+
+void WsScheduler::Start() {
+  for (size_t i = 0; i < numWorkers_; ++i)
+    workers_.emplace_back(&WsScheduler::WorkerLoop, this, i);
+}
+
+void WsScheduler::Stop() {
+  stop_ = true;
+  {
+    std::lock_guard<std::mutex> _(sleepLock_);
+    sleepCv_.notify_all();
+  }
+  for (auto &worker : workers_) worker.join();
+  workers_.clear();
+
+  // Tasks injected while the workers were leaving.
+  while (HasWork()) RunOne();
+}
+
+void WsScheduler::Spawn(TaskTy &&task) {
+  auto newTask = TaskArena::New<TaskTy>(TraceTask(0, std::move(task)));
+  auto p = static_cast<size_t>(CurrentPriority());
+  if (tlsWorkerId != kNotAWorker) {
+    deques_[p][tlsWorkerId]->Push(newTask);
+  } else {
+    std::lock_guard<std::mutex> _(injectionLock_);
+    injection_[p].push_back(newTask);
+    ++injectionSize_[p];
+  }
+  WakeUp();
+}
+
+size_t WsScheduler::QueueDepth(Priority p) const {
+  auto index = static_cast<size_t>(p);
+  size_t depth = injectionSize_[index].load();
+  for (auto &deque : deques_[index]) depth += deque->Size();
+  return depth;
+}
+
+void WsScheduler::WakeUp() {
+  // Pairs with the fence in WorkerLoop: either the sleeper sees the new
+  // task, or we see the sleeper.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (numSleeping_.load(std::memory_order_relaxed) == 0) return;
+
+  std::lock_guard<std::mutex> _(sleepLock_);
+  sleepCv_.notify_one();
+}
+
+WsScheduler::TaskTy *WsScheduler::FindTask(Priority *priority) {
+  size_t victim = randomVictim(numWorkers_);
+  for (size_t p = 0; p < kNumPriorities; ++p) {
+    *priority = static_cast<Priority>(p);
+    auto &deques = deques_[p];
+
+    TaskTy *task = nullptr;
+    if (tlsWorkerId != kNotAWorker) {
+      task = deques[tlsWorkerId]->Pop();
+      if (task != nullptr) return task;
+    }
+
+    if (injectionSize_[p].load(std::memory_order_relaxed) != 0) {
+      std::lock_guard<std::mutex> _(injectionLock_);
+      if (!injection_[p].empty()) {
+        task = injection_[p].front();
+        injection_[p].pop_front();
+        --injectionSize_[p];
+        return task;
+      }
+    }
+
+    for (size_t i = 0; i < numWorkers_; ++i) {
+      size_t target = (victim + i) % numWorkers_;
+      if (target == tlsWorkerId) continue;
+      task = deques[target]->Steal();
+      if (task != nullptr) return task;
+    }
+  }
+  return nullptr;
+}
+
+bool WsScheduler::HasWork() {
+  for (size_t p = 0; p < kNumPriorities; ++p) {
+    if (injectionSize_[p].load() != 0) return true;
+    for (auto &deque : deques_[p])
+      if (!deque->Empty()) return true;
+  }
+  return false;
+}
+
+bool WsScheduler::RunOne() {
+  Priority priority;
+  TaskTy *task = FindTask(&priority);
+  if (task == nullptr) return false;
+
+  {
+    PriorityScope scope(priority);
+    (*task)();
+  }
+  TaskArena::Delete(task);
+  return true;
+}
+
+void WsScheduler::WorkerLoop(size_t id) {
+  tlsWorkerId = id;
+  NumaTopology::Instance().PinWorker();
+
+  unsigned idleRounds = 0;
+  while (!stop_.load(std::memory_order_relaxed)) {
+    if (RunOne()) {
+      idleRounds = 0;
+      continue;
+    }
+
+    if (++idleRounds < kSpinRounds) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleepLock_);
+    numSleeping_.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!HasWork() && !stop_) {
+      sleepCv_.wait_for(lock, std::chrono::milliseconds(1));
+    }
+    numSleeping_.fetch_sub(1);
+    idleRounds = 0;
+  }
+
+  // Drain the deques of every worker and the injection queues before
+  // leaving: the tasks run here may spawn more tasks anywhere.
+  while (HasWork()) RunOne();
+}
+
+size_t WsScheduler::GrainSize(size_t numIters) const {
+  return std::max<size_t>(numIters / (numWorkers_ * kPiecesPerWorker), 1);
+}
+
+void WsScheduler::SplitRange(const std::shared_ptr<WsCounter> &counter,
+                             const std::shared_ptr<RangeTaskTy> &task,
+                             size_t begin, size_t end, size_t grain) {
+  // Hand the upper halves to thieves and keep splitting the lower one.
+  while (end - begin > grain) {
+    size_t middle = begin + (end - begin) / 2;
+    counter->Increment();
+    Spawn(makeArenaTask([this, counter, task, middle, end, grain] {
+      SplitRange(counter, task, middle, end, grain);
+      counter->Decrement();
+    }));
+    end = middle;
+  }
+  (*task)(begin, end);
+}
+
+void WsScheduler::AsyncParallelFor(const std::shared_ptr<WsCounter> &counter,
+                                   size_t numIters, RangeTaskTy &&task) {
+  if (numIters == 0) return;
+
+  auto sharedTask = std::make_shared<RangeTaskTy>(std::move(task));
+  size_t grain = GrainSize(numIters);
+  counter->Increment();
+  Spawn(makeArenaTask([this, counter, sharedTask, numIters, grain] {
+    SplitRange(counter, sharedTask, 0, numIters, grain);
+    counter->Decrement();
+  }));
+}
+
+void WsScheduler::ParallelFor(size_t numIters, RangeTaskTy &&task) {
+  if (numIters == 0) return;
+
+  auto counter = std::make_shared<WsCounter>();
+  auto sharedTask = std::make_shared<RangeTaskTy>(std::move(task));
+  SplitRange(counter, sharedTask, 0, numIters, GrainSize(numIters));
+  counter->Wait();
+}
+
+}  // namespace impl
+
+}  // namespace rt
+}  // namespace shad
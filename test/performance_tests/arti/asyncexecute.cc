@@ -28,6 +28,7 @@
 #include <iostream>
 #include <random>
 #include <thread>
+#include <utility>
 
 #include <benchmark/benchmark.h>
 
@@ -102,6 +103,38 @@ BENCHMARK_F(TestFixture, test_asyncExecuteAtInputBuffer)
   }
 }
 
+BENCHMARK_F(TestFixture, test_asyncExecuteAtMoveArgs)(benchmark::State &state) {
+  int i = 0;
+
+  for (auto _ : state) {
+    exData data{"hello"};
+    shad::rt::Handle handle;
+    shad::rt::asyncExecuteAt(
+        handle, shad::rt::Locality(i++ % shad::rt::numLocalities()),
+        testFunctionAsyncExecuteAt, std::move(data));
+
+    shad::rt::waitForCompletion(handle);
+  }
+}
+
+BENCHMARK_F(TestFixture, test_asyncExecuteAtArenaBuffer)
+(benchmark::State &state) {
+  exData value{1, 2};
+  int i = 0;
+
+  for (auto _ : state) {
+    std::shared_ptr<uint8_t> data =
+        shad::rt::allocateArgsBuffer(sizeof(exData));
+    std::memcpy(data.get(), &value, sizeof(exData));
+    shad::rt::Handle handle;
+    shad::rt::asyncExecuteAt(
+        handle, shad::rt::Locality(i++ % shad::rt::numLocalities()),
+        testFunctionAsyncExecuteAtInputBuffer, data, sizeof(exData));
+
+    shad::rt::waitForCompletion(handle);
+  }
+}
+
 void testFunctionAsyncExecuteAtWithRetBuff(shad::rt::Handle &,
                                            const exData &data, uint8_t *,
                                            uint32_t *size) {
@@ -227,6 +260,59 @@ BENCHMARK_F(TestFixture, test_asyncExecuteOnAllInputBuffer)
   }
 }
 
+void testFunctionAsyncExecuteAtSmall(shad::rt::Handle &, const size_t &value) {
+  globalCounter += value;
+}
+
+// Per-task overhead: many small tasks attached to a single handle.
+BENCHMARK_DEFINE_F(TestFixture, test_asyncExecuteAtManyTasks)
+(benchmark::State &state) {
+  size_t numTasks = state.range(0);
+
+  for (auto _ : state) {
+    shad::rt::Handle handle;
+    for (size_t i = 0; i < numTasks; ++i) {
+      shad::rt::asyncExecuteAt(
+          handle, shad::rt::Locality(i % shad::rt::numLocalities()),
+          testFunctionAsyncExecuteAtSmall, i);
+    }
+    shad::rt::waitForCompletion(handle);
+  }
+  state.SetItemsProcessed(state.iterations() * numTasks);
+}
+
+BENCHMARK_REGISTER_F(TestFixture, test_asyncExecuteAtManyTasks)
+    ->Arg(1 << 10)
+    ->Arg(1 << 14);
+
+void testFunctionAsyncExecuteAtNested(shad::rt::Handle &, const size_t &value) {
+  shad::rt::Handle nested;
+  shad::rt::asyncExecuteAt(nested, shad::rt::thisLocality(),
+                           testFunctionAsyncExecuteAtSmall, value);
+  shad::rt::waitForCompletion(nested);
+}
+
+// Handle creation and wait inside tasks, as in LocalHashmap::AsyncForEachEntry.
+BENCHMARK_DEFINE_F(TestFixture, test_asyncExecuteAtNestedHandles)
+(benchmark::State &state) {
+  size_t numTasks = state.range(0);
+
+  for (auto _ : state) {
+    shad::rt::Handle handle;
+    for (size_t i = 0; i < numTasks; ++i) {
+      shad::rt::asyncExecuteAt(
+          handle, shad::rt::Locality(i % shad::rt::numLocalities()),
+          testFunctionAsyncExecuteAtNested, i);
+    }
+    shad::rt::waitForCompletion(handle);
+  }
+  state.SetItemsProcessed(state.iterations() * numTasks);
+}
+
+BENCHMARK_REGISTER_F(TestFixture, test_asyncExecuteAtNestedHandles)
+    ->Arg(1 << 10)
+    ->Arg(1 << 14);
+
 namespace shad {
 int main(int argc, char **argv) {
   ::benchmark::Initialize(&argc, argv);
@@ -0,0 +1,143 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "shad/data_structures/compare_and_hash_utils.h"
+#include "shad/runtime/runtime.h"
+#include "shad/util/measure.h"
+
+namespace shad {
+
+namespace hash_perf_test {
+static size_t kNumKeys = 10000000;
+static size_t kNumBuckets = 1021;
+
+struct Key {
+  uint64_t a;
+  uint64_t b;
+  uint64_t c;
+};
+}  // namespace hash_perf_test
+
+static void PrintParameters() {
+  std::cout << " Running Hash Function Performance test with"
+            << "\n   NumKeys: " << hash_perf_test::kNumKeys
+            << "\n   NumBuckets: " << hash_perf_test::kNumBuckets << std::endl;
+}
+
+// Chi-squared of the bucket loads normalized by its expected value (the
+// number of buckets minus one): values close to 1 denote a uniform hash.
+static double Uniformity(const std::vector<uint64_t> &hashes) {
+  std::vector<double> load(hash_perf_test::kNumBuckets, 0);
+  for (auto h : hashes) load[h % hash_perf_test::kNumBuckets] += 1;
+  double expected = double(hashes.size()) / hash_perf_test::kNumBuckets;
+  double chi2 = 0;
+  for (auto l : load) chi2 += (l - expected) * (l - expected) / expected;
+  return chi2 / (hash_perf_test::kNumBuckets - 1);
+}
+
+template <typename KeyT, typename HashT>
+void Run(const std::string &label, const std::vector<KeyT> &keys,
+         HashT &&hashFn) {
+  std::vector<uint64_t> hashes(keys.size());
+  auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+      shad::measure<>::duration([&]() { hashFn(keys, hashes); }));
+  auto dc = duration.count();
+  std::cout << label << ": " << dc << " us, throughput:: ";
+  if (dc)
+    std::cout << (double)keys.size() / dc * 1000000;
+  else
+    std::cout << "N/A";
+  std::cout << " keys/s, uniformity: " << Uniformity(hashes) << std::endl;
+}
+
+template <typename KeyT>
+void Compare(const std::string &label, const std::vector<KeyT> &keys) {
+  using KeysT = std::vector<KeyT>;
+  Run(label + " HashFunction", keys,
+      [](const KeysT &keys, std::vector<uint64_t> &hashes) {
+        for (size_t i = 0; i < keys.size(); ++i)
+          hashes[i] = shad::HashFunction(keys[i], 0u);
+      });
+  Run(label + " FastHashFunction", keys,
+      [](const KeysT &keys, std::vector<uint64_t> &hashes) {
+        for (size_t i = 0; i < keys.size(); ++i)
+          hashes[i] = shad::FastHashFunction(keys[i]);
+      });
+  // The hash of the containers: std::hash for the keys it supports.
+  Run(label + " HashMany", keys,
+      [](const KeysT &keys, std::vector<uint64_t> &hashes) {
+        shad::HashMany(keys.data(), keys.size(), hashes.data());
+      });
+  std::cout << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  for (size_t argIndex = 1; argIndex < argc - 1; argIndex++) {
+    std::string arg(argv[argIndex]);
+    if (arg == "--NumKeys") {
+      ++argIndex;
+      hash_perf_test::kNumKeys = atoi(argv[argIndex]);
+      if (hash_perf_test::kNumKeys == 0) {
+        std::cout << "Invalid Number of keys: " << argv[argIndex] << std::endl;
+        return 0;
+      }
+    } else if (arg == "--NumBuckets") {
+      ++argIndex;
+      hash_perf_test::kNumBuckets = atoi(argv[argIndex]);
+      if (hash_perf_test::kNumBuckets == 0) {
+        std::cout << "Invalid number of buckets: " << argv[argIndex]
+                  << std::endl;
+        return 0;
+      }
+    }
+  }
+  PrintParameters();
+
+  // Strided keys: the low bits are the same for every key.
+  std::vector<uint64_t> words(hash_perf_test::kNumKeys);
+  for (size_t i = 0; i < words.size(); ++i) words[i] = i << 16;
+  Compare("uint64_t", words);
+
+  std::vector<hash_perf_test::Key> structs(hash_perf_test::kNumKeys);
+  for (size_t i = 0; i < structs.size(); ++i)
+    structs[i] = hash_perf_test::Key{i, i * 3, 42};
+  Compare("24-byte struct", structs);
+
+  std::vector<std::vector<uint64_t>> vectors(hash_perf_test::kNumKeys / 10);
+  for (size_t i = 0; i < vectors.size(); ++i) {
+    vectors[i].resize(8);
+    std::iota(vectors[i].begin(), vectors[i].end(), i);
+  }
+  Compare("64-byte vector", vectors);
+  return 0;
+}
+}  // namespace shad
@@ -25,6 +25,8 @@
 #include <atomic>
 #include <chrono>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <random>
 #include <thread>
 
@@ -39,6 +41,7 @@ static size_t kNumKeys = 1000000;
 static size_t kKeySize = 1;
 static size_t kValueSize = 1;
 static size_t kNumBuckets = 1024;
+static size_t kNumScanHits = 0;
 }  // namespace localhmap_perf_test
 
 static void PrintParameters() {
@@ -62,6 +65,30 @@ void print_time(const std::string &label, duration_t duration) {
   std::cout << " ops/s\n\n" << std::endl;
 }
 
+// Populate a map of 4-byte keys and 8-byte values stored with LAYOUT, then
+// report its memory footprint and the time to scan its keys.
+template <typename LAYOUT>
+static void RunLayout(const std::string &label) {
+  using MapT = LocalHashmap<uint32_t, uint64_t, MemCmp<uint32_t>,
+                            Overwriter<uint64_t>, LAYOUT>;
+  MapT hmap(localhmap_perf_test::kNumBuckets);
+  for (size_t i = 0; i < localhmap_perf_test::kNumKeys; ++i) hmap.Insert(i, i);
+
+  size_t bytes = hmap.MemoryFootprint();
+  std::cout << "Memory footprint (" << label << "): " << bytes << " bytes, "
+            << (double)bytes / hmap.Size() << " bytes/entry" << std::endl;
+
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      shad::measure<>::duration([&]() {
+        hmap.ForEachKey([](const uint32_t &key) {
+          if (key == std::numeric_limits<uint32_t>::max())
+            ++localhmap_perf_test::kNumScanHits;
+        });
+      }));
+
+  print_time("ForEachKey (" + label + ")", duration);
+}
+
 int main(int argc, char *argv[]) {
   if (shad::rt::numLocalities() != 1) {
     std::cout
@@ -173,6 +200,24 @@ int main(int argc, char *argv[]) {
 
   print_time("Async-Lookup", duration);
 
+  std::vector<std::vector<uint64_t>> batchKeys(localhmap_perf_test::kNumKeys);
+  std::vector<std::vector<uint64_t>> batchValues(localhmap_perf_test::kNumKeys);
+  std::unique_ptr<bool[]> found(new bool[localhmap_perf_test::kNumKeys]);
+  for (size_t i = 0; i < localhmap_perf_test::kNumKeys; i++)
+    batchKeys[i] = input[i].first;
+  static const size_t kBatchSize = 1024;
+
+  duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      shad::measure<>::duration([&]() {
+        for (size_t i = 0; i < localhmap_perf_test::kNumKeys;
+             i += kBatchSize) {
+          size_t n = std::min(kBatchSize, localhmap_perf_test::kNumKeys - i);
+          hmap.LookupBatch(&batchKeys[i], n, &batchValues[i], &found[i]);
+        }
+      }));
+
+  print_time("Batch-Lookup", duration);
+
   auto AsyncForEachKeyLambda = [](shad::rt::Handle &,
                                   const std::vector<uint64_t> &) {};
 
@@ -193,6 +238,9 @@ int main(int argc, char *argv[]) {
         shad::rt::waitForCompletion(handle);
       }));
 
+  RunLayout<AoSLayout>("AoS");
+  RunLayout<SoALayout>("SoA");
+
   return 0;
 }
 }  // namespace shad
@@ -23,6 +23,8 @@
 //===----------------------------------------------------------------------===//
 
 #include <functional>
+#include <memory>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -101,6 +103,24 @@ TYPED_TEST(ATF, adjacent_difference) {
       shad_test_stl::ordered_checksum<it_t>, diff_f{});
 }
 
+// The differences are all distinct, so that every element written at the wrong
+// position is detected, including at the boundaries of the localities.
+TYPED_TEST(ATF, adjacent_difference_positions) {
+  using val_t = typename TypeParam::value_type;
+  auto in = std::make_shared<TypeParam>();
+  for (size_t i = 0; i < in->size(); ++i) in->at(i) = i * i;
+  auto out = std::make_shared<TypeParam>();
+  std::vector<val_t> expected(in->size());
+  for (size_t i = 0; i < in->size(); ++i)
+    expected[i] = i == 0 ? 0 : 2 * i - 1;
+
+  auto res = shad::adjacent_difference(shad::distributed_parallel_tag{},
+                                       in->begin(), in->end(), out->begin(),
+                                       std::minus<val_t>{});
+  ASSERT_EQ(res, out->end());
+  for (size_t i = 0; i < out->size(); ++i) ASSERT_EQ(out->at(i), expected[i]);
+}
+
 TYPED_TEST(ATF, inclusive_scan) {
   using it_t = typeof(this->in->begin());
   using val_t = typename TypeParam::value_type;
@@ -23,6 +23,8 @@
 //===----------------------------------------------------------------------===//
 
 #include <algorithm>
+#include <atomic>
+#include <utility>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -174,6 +176,31 @@ TEST_F(ArrayTest, RangedAsyncInsertAndAsyncGetElements) {
   shad::Array<size_t>::Destroy(edsPtr->GetGlobalID());
 }
 
+TEST_F(ArrayTest, AsyncGatherElements) {
+  auto edsPtr = shad::Array<size_t>::Create(kArraySize, kInitValue);
+  edsPtr->FillPtrs();
+  shad::rt::Handle handle;
+  edsPtr->AsyncInsertAt(handle, 0, inputData_.data(), kArraySize);
+  shad::rt::waitForCompletion(handle);
+
+  // Runs of consecutive positions mixed with scattered ones.
+  std::vector<uint64_t> indices;
+  for (size_t i = 0; i < kArraySize; i += 7) {
+    indices.push_back(i);
+    if (i + 1 < kArraySize) indices.push_back(i + 1);
+    indices.push_back((i * 13) % kArraySize);
+  }
+  std::vector<size_t> values(indices.size(), 0);
+  edsPtr->AsyncGatherElements(handle, values.data(), indices.data(),
+                              indices.size());
+  shad::rt::waitForCompletion(handle);
+
+  for (size_t i = 0; i < indices.size(); i++) {
+    ASSERT_EQ(values[i], indices[i] + 1);
+  }
+  shad::Array<size_t>::Destroy(edsPtr->GetGlobalID());
+}
+
 TEST_F(ArrayTest, BufferedSyncInsertAndSyncGet) {
   auto edsPtr = shad::Array<size_t>::Create(kArraySize, kInitValue);
   for (size_t i = 0; i < kArraySize; i++) {
@@ -793,3 +820,45 @@ TEST_F(ArrayTest, SmallAsyncInsertAsyncForEachAndAsyncGet) {
   }
   shad::Array<size_t>::Destroy(edsPtr->GetGlobalID());
 }
+
+static std::atomic<size_t> affinityVisits(0);
+static std::atomic<size_t> affinityMisses(0);
+
+static void recordLocality(size_t, size_t &element) {
+  element = static_cast<uint32_t>(shad::rt::thisLocality());
+}
+
+static void affinityVisit(const shad::Array<size_t>::ObjectID &oid,
+                          size_t i) {
+  auto edsPtr = shad::Array<size_t>::GetPtr(oid);
+  affinityVisits++;
+  if (edsPtr->At(i) != static_cast<uint32_t>(shad::rt::thisLocality()))
+    affinityMisses++;
+}
+
+static void drainAffinityCounters(const bool &,
+                                  std::pair<size_t, size_t> *result) {
+  *result = std::make_pair(affinityVisits.exchange(0),
+                           affinityMisses.exchange(0));
+}
+
+TEST_F(ArrayTest, AffinityForEachOnAll) {
+  for (size_t size : {kSmallArraySize_, kArraySize}) {
+    auto edsPtr = shad::Array<size_t>::Create(size, kInitValue);
+    // Every element records the locality storing it.
+    edsPtr->ForEach(recordLocality);
+    shad::rt::forEachOnAll(edsPtr->Affinity(), affinityVisit,
+                           edsPtr->GetGlobalID(), size);
+    size_t visits = 0, misses = 0;
+    for (auto &locality : shad::rt::allLocalities()) {
+      std::pair<size_t, size_t> counters;
+      shad::rt::executeAtWithRet(locality, drainAffinityCounters, false,
+                                 &counters);
+      visits += counters.first;
+      misses += counters.second;
+    }
+    ASSERT_EQ(visits, size);
+    ASSERT_EQ(misses, 0);
+    shad::Array<size_t>::Destroy(edsPtr->GetGlobalID());
+  }
+}
@@ -0,0 +1,132 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "shad/data_structures/compare_and_hash_utils.h"
+
+class HashTest : public ::testing::Test {
+ public:
+  HashTest() {}
+  void SetUp() {}
+  void TearDown() {}
+
+  static constexpr uint64_t kNumKeys = 1 << 16;
+  static constexpr uint64_t kNumBuckets = 1 << 10;
+
+  struct Key {
+    uint64_t a;
+    uint32_t b;
+    uint32_t c;
+  };
+
+  // The largest bucket load when hashing n keys in kNumBuckets buckets.
+  static size_t MaxBucketLoad(const std::vector<uint64_t> &hashes) {
+    std::vector<size_t> load(kNumBuckets, 0);
+    for (auto h : hashes) ++load[h % kNumBuckets];
+    return *std::max_element(load.begin(), load.end());
+  }
+};
+
+TEST_F(HashTest, IntegralKeys) {
+  std::vector<uint64_t> keys(kNumKeys), hashes(kNumKeys);
+  for (uint64_t i = 0; i < kNumKeys; ++i) keys[i] = i << 12;
+  for (uint64_t i = 0; i < kNumKeys; ++i)
+    hashes[i] = shad::FastHashFunction(keys[i]);
+
+  std::set<uint64_t> distinct(hashes.begin(), hashes.end());
+  ASSERT_EQ(distinct.size(), kNumKeys);
+  // Keys sharing their low bits are spread over all the buckets.
+  ASSERT_LT(MaxBucketLoad(hashes), 2 * kNumKeys / kNumBuckets);
+
+  ASSERT_EQ(shad::FastHashFunction(uint32_t(42)),
+            shad::FastHashFunction(uint64_t(42)));
+  ASSERT_NE(shad::FastHashFunction(uint64_t(42), 1),
+            shad::FastHashFunction(uint64_t(42), 2));
+}
+
+TEST_F(HashTest, PODKeys) {
+  std::vector<Key> keys(kNumKeys);
+  std::vector<uint64_t> hashes(kNumKeys);
+  for (uint64_t i = 0; i < kNumKeys; ++i) {
+    std::memset(&keys[i], 0, sizeof(Key));
+    keys[i].a = 7;
+    keys[i].b = i / 256;
+    keys[i].c = i % 256;
+  }
+  for (uint64_t i = 0; i < kNumKeys; ++i)
+    hashes[i] = shad::FastHashFunction(keys[i]);
+
+  std::set<uint64_t> distinct(hashes.begin(), hashes.end());
+  ASSERT_EQ(distinct.size(), kNumKeys);
+  ASSERT_LT(MaxBucketLoad(hashes), 2 * kNumKeys / kNumBuckets);
+  ASSERT_EQ(hashes[3], shad::hash<Key>{}(keys[3]));
+}
+
+TEST_F(HashTest, HashMany) {
+  // The batches are hashed as the containers hash single keys.
+  std::vector<uint64_t> words(kNumKeys), hashes(kNumKeys);
+  for (uint64_t i = 0; i < kNumKeys; ++i) words[i] = i << 12;
+  shad::HashMany(words.data(), words.size(), hashes.data());
+  for (uint64_t i = 0; i < kNumKeys; ++i)
+    ASSERT_EQ(hashes[i], shad::hash<uint64_t>{}(words[i]));
+
+  std::vector<Key> keys(kNumKeys);
+  for (uint64_t i = 0; i < kNumKeys; ++i) {
+    std::memset(&keys[i], 0, sizeof(Key));
+    keys[i].a = i;
+    keys[i].b = i % 7;
+  }
+  shad::HashMany(keys.data(), keys.size(), hashes.data());
+  for (uint64_t i = 0; i < kNumKeys; ++i) {
+    ASSERT_EQ(hashes[i], shad::hash<Key>{}(keys[i]));
+    ASSERT_EQ(hashes[i], shad::FastHashFunction(keys[i]));
+  }
+}
+
+TEST_F(HashTest, ByteSequences) {
+  // Every length exercises a different path of the byte hashing.
+  std::set<uint64_t> distinct;
+  for (size_t len = 0; len <= 128; ++len) {
+    std::vector<uint8_t> key(len, 0xAB);
+    auto hash = shad::FastHashFunction(key);
+    ASSERT_EQ(hash, shad::FastHashFunction(key));
+    distinct.insert(hash);
+    if (len > 0) {
+      key[len / 2] ^= 1;
+      ASSERT_NE(hash, shad::FastHashFunction(key));
+    }
+  }
+  ASSERT_EQ(distinct.size(), 129);
+
+  std::vector<uint64_t> words = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  std::array<uint64_t, 9> array = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  ASSERT_EQ(shad::FastHashFunction(words), shad::FastHashFunction(array));
+}
@@ -22,11 +22,14 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
+#include <utility>
 #include <vector>
 
 #include "gtest/gtest.h"
 
 #include "shad/data_structures/hashmap.h"
+#include "shad/data_structures/local_flat_hashmap.h"
 #include "shad/runtime/runtime.h"
 
 static const size_t kToInsert = 10000;
@@ -241,6 +244,35 @@ TEST_F(HashmapTest, BufferedInsertAsyncLookupTest) {
   HashmapType::Destroy(mapPtr->GetGlobalID());
 }
 
+TEST_F(HashmapTest, BulkInsertAsyncLookupTest) {
+  auto mapPtr = HashmapType::Create(kToInsert);
+  // Every locality generates a strided slice of the keys.
+  auto generator = [](const uint8_t &, HashmapType::BulkInserter &inserter) {
+    uint64_t L = static_cast<uint32_t>(shad::rt::thisLocality());
+    for (uint64_t i = L; i < kToInsert; i += shad::rt::numLocalities()) {
+      Key keys;
+      Value values;
+      FillKey(&keys, i);
+      FillValue(&values, i + 11);
+      inserter.Insert(keys, values);
+    }
+  };
+  mapPtr->BulkInsert(generator, uint8_t(0));
+  ASSERT_EQ(mapPtr->Size(), kToInsert);
+  HashmapType::LookupResult *values = new HashmapType::LookupResult[kToInsert];
+  shad::rt::Handle handle;
+  for (uint64_t i = 0; i < kToInsert; i++) {
+    DoAsyncLookup(handle, mapPtr->GetGlobalID(), i, &values[i]);
+  }
+  shad::rt::waitForCompletion(handle);
+  for (uint64_t i = 0; i < kToInsert; i++) {
+    ASSERT_TRUE(values[i].found);
+    CheckValue(&(values[i].value), i + 11);
+  }
+  delete[] values;
+  HashmapType::Destroy(mapPtr->GetGlobalID());
+}
+
 TEST_F(HashmapTest, BufferedAsyncInsertAsyncLookupTest) {
   auto mapPtr = HashmapType::Create(kToInsert);
   shad::rt::Handle handle;
@@ -570,3 +602,119 @@ TEST_F(HashmapTest, AsyncApply) {
   shad::rt::waitForCompletion(handle);
   HashmapType::Destroy(mapPtr->GetGlobalID());
 }
+
+static std::atomic<size_t> affinityVisits(0);
+static std::atomic<size_t> affinityMisses(0);
+
+using IdMapType = shad::Hashmap<uint64_t, uint64_t>;
+
+static void drainAffinityCounters(const bool &,
+                                  std::pair<size_t, size_t> *result) {
+  *result = std::make_pair(affinityVisits.exchange(0),
+                           affinityMisses.exchange(0));
+}
+
+TEST_F(HashmapTest, KeyAffinityForEachOnAll) {
+  auto mapPtr = IdMapType::Create(kToInsert);
+  for (uint64_t i = 0; i < kToInsert; ++i) mapPtr->Insert(i, 0);
+  // Every entry records the locality storing it.
+  mapPtr->ForEachEntry([](const uint64_t &, uint64_t &value) {
+    value = static_cast<uint32_t>(shad::rt::thisLocality());
+  });
+
+  shad::rt::forEachOnAll(
+      IdMapType::KeyAffinity(),
+      [](const IdMapType::ObjectID &oid, size_t i) {
+        auto mapPtr = IdMapType::GetPtr(oid);
+        uint64_t value;
+        affinityVisits++;
+        if (!mapPtr->Lookup(i, &value) ||
+            value != static_cast<uint32_t>(shad::rt::thisLocality()))
+          affinityMisses++;
+      },
+      mapPtr->GetGlobalID(), kToInsert);
+
+  size_t visits = 0, misses = 0;
+  for (auto &locality : shad::rt::allLocalities()) {
+    std::pair<size_t, size_t> counters;
+    shad::rt::executeAtWithRet(locality, drainAffinityCounters, false,
+                               &counters);
+    visits += counters.first;
+    misses += counters.second;
+  }
+  ASSERT_EQ(visits, kToInsert);
+  ASSERT_EQ(misses, 0);
+  IdMapType::Destroy(mapPtr->GetGlobalID());
+}
+
+using FlatMapType =
+    shad::Hashmap<uint64_t, uint64_t, shad::MemCmp<uint64_t>,
+                  shad::Overwriter<uint64_t>, shad::LocalFlatHashmap>;
+
+TEST_F(HashmapTest, FlatLocalMap) {
+  auto mapPtr = FlatMapType::Create(kToInsert);
+  for (uint64_t i = 0; i < kToInsert; ++i) mapPtr->BufferedInsert(i, i + 11);
+  mapPtr->WaitForBufferedInsert();
+  ASSERT_EQ(mapPtr->Size(), kToInsert);
+
+  uint64_t value;
+  for (uint64_t i = 0; i < kToInsert; ++i) {
+    ASSERT_TRUE(mapPtr->Lookup(i, &value));
+    ASSERT_EQ(value, i + 11);
+  }
+  ASSERT_FALSE(mapPtr->Lookup(kToInsert, &value));
+
+  mapPtr->ForEachEntry([](const uint64_t &key, uint64_t &value) {
+    ASSERT_EQ(value, key + 11);
+    value = key;
+  });
+  uint64_t checksum = 0;
+  for (auto entry : *mapPtr) {
+    ASSERT_EQ(entry.first, entry.second);
+    checksum += entry.second;
+  }
+  ASSERT_EQ(checksum, kToInsert * (kToInsert - 1) / 2);
+
+  for (uint64_t i = 0; i < kToInsert; i += 2) mapPtr->Erase(i);
+  ASSERT_EQ(mapPtr->Size(), kToInsert / 2);
+  for (uint64_t i = 0; i < kToInsert; ++i)
+    ASSERT_EQ(mapPtr->Lookup(i, &value), (i % 2) != 0u);
+  FlatMapType::Destroy(mapPtr->GetGlobalID());
+}
+
+using SoAMapType =
+    shad::Hashmap<uint32_t, uint64_t, shad::MemCmp<uint32_t>,
+                  shad::Overwriter<uint64_t>, shad::LocalSoAHashmap>;
+
+TEST_F(HashmapTest, SoALocalMap) {
+  auto mapPtr = SoAMapType::Create(kToInsert);
+  for (uint32_t i = 0; i < kToInsert; ++i) mapPtr->BufferedInsert(i, i + 11);
+  mapPtr->WaitForBufferedInsert();
+  ASSERT_EQ(mapPtr->Size(), kToInsert);
+
+  uint64_t value;
+  for (uint32_t i = 0; i < kToInsert; ++i) {
+    ASSERT_TRUE(mapPtr->Lookup(i, &value));
+    ASSERT_EQ(value, i + 11);
+  }
+  uint64_t checksum = 0;
+  for (auto entry : *mapPtr) checksum += entry.second - entry.first;
+  ASSERT_EQ(checksum, kToInsert * 11);
+
+  for (uint32_t i = 0; i < kToInsert; i += 2) mapPtr->Erase(i);
+  ASSERT_EQ(mapPtr->Size(), kToInsert / 2);
+  SoAMapType::Destroy(mapPtr->GetGlobalID());
+}
+
+TEST_F(HashmapTest, InsertIteratorDuringResize) {
+  // A small map, so that the insertions resize the local maps.
+  auto mapPtr = shad::Hashmap<uint64_t, uint64_t>::Create(1);
+  for (uint64_t i = 0; i < kToInsert; ++i) {
+    auto res = mapPtr->Insert(i, i + 11);
+    ASSERT_TRUE(res.second);
+    ASSERT_EQ((*res.first).first, i);
+    ASSERT_EQ((*res.first).second, i + 11);
+  }
+  ASSERT_EQ(mapPtr->Size(), kToInsert);
+  shad::Hashmap<uint64_t, uint64_t>::Destroy(mapPtr->GetGlobalID());
+}
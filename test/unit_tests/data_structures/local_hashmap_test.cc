@@ -22,6 +22,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
+#include <memory>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -159,6 +161,41 @@ class LocalHashmapTest : public ::testing::Test {
     ASSERT_TRUE(DoLookup(hm, start_it + iter, &values));
     CheckValue(values, start_it + iter);
   }
+
+  static void InsertLookupTestParallelFunc(
+      const std::tuple<HashmapType *, size_t> &t, const size_t iter) {
+    HashmapType *hm = std::get<0>(t);
+    const uint64_t seed = std::get<1>(t) + iter;
+    DoInsert(hm, seed, seed);
+    Key keys;
+    Value values;
+    FillKey(&keys, seed);
+    ASSERT_TRUE(hm->Lookup(keys, &values));
+    CheckValue(&values, seed);
+  }
+
+  static void CheckAllEntries(HashmapType *hm, uint64_t numEntries) {
+    ASSERT_EQ(hm->Size(), numEntries);
+    for (uint64_t i = 0; i < numEntries; ++i) {
+      Key keys;
+      Value values;
+      FillKey(&keys, i);
+      ASSERT_TRUE(hm->Lookup(keys, &values));
+      CheckValue(&values, i);
+    }
+    uint64_t cnt = 0;
+    uint64_t *cntPtr = &cnt;
+    hm->ForEachEntry(
+        [](const Key &key, Value &value, uint64_t *&cntPtr) {
+          CheckValue(&value, GetSeed(&key));
+          __sync_fetch_and_add(cntPtr, 1);
+        },
+        cntPtr);
+    ASSERT_EQ(cnt, numEntries);
+    cnt = 0;
+    for (auto entry : *hm) ++cnt;
+    ASSERT_EQ(cnt, numEntries);
+  }
 };
 
 TEST_F(LocalHashmapTest, InsertLookupTest) {
@@ -280,6 +317,154 @@ TEST_F(LocalHashmapTest, InsertLookupParallel1) {
   }
 }
 
+TEST_F(LocalHashmapTest, ResizeUnderConcurrentInserts) {
+  HashmapType hmap(1);
+  uint64_t toInsert = 8 * kToInsert;
+  shad::rt::forEachAt(shad::rt::thisLocality(), InsertLookupTestParallelFunc,
+                      std::make_tuple(&hmap, 0lu), toInsert);
+  CheckAllEntries(&hmap, toInsert);
+
+  for (uint64_t i = 0; i < toInsert; i += 2) {
+    Key k;
+    FillKey(&k, i);
+    hmap.Erase(k);
+  }
+  ASSERT_EQ(hmap.Size(), toInsert / 2);
+  for (uint64_t i = 0; i < toInsert; ++i) {
+    Key k;
+    FillKey(&k, i);
+    ASSERT_EQ(hmap.Lookup(k) == nullptr, i % 2 == 0);
+  }
+
+  hmap.Clear();
+  ASSERT_EQ(hmap.Size(), 0);
+  shad::rt::forEachAt(shad::rt::thisLocality(), InsertLookupTestParallelFunc,
+                      std::make_tuple(&hmap, 0lu), kToInsert);
+  CheckAllEntries(&hmap, kToInsert);
+}
+
+TEST_F(LocalHashmapTest, InsertIteratorDuringResize) {
+  // With one initial bucket, most insertions start or help a resize that
+  // migrates the chain holding the new entry.
+  shad::LocalHashmap<uint64_t, uint64_t> hmap(1);
+  for (uint64_t i = 0; i < kToInsert; ++i) {
+    auto res = hmap.Insert(i, i + 11);
+    ASSERT_TRUE(res.second);
+    ASSERT_EQ((*res.first).first, i);
+    ASSERT_EQ((*res.first).second, i + 11);
+  }
+  for (uint64_t i = 0; i < kToInsert; ++i) {
+    auto res = hmap.Insert(i, i + 13);
+    ASSERT_EQ((*res.first).first, i);
+    ASSERT_EQ((*res.first).second, i + 13);
+  }
+  ASSERT_EQ(hmap.Size(), size_t(kToInsert));
+}
+
+TEST_F(LocalHashmapTest, FinishResizeWithinVisitor) {
+  // The chain held by a visitor cannot migrate: the insertions of the
+  // visitor start a resize it leaves ongoing, which the iterators and the
+  // footprint of the map do not wait for.
+  using MapT = shad::LocalHashmap<uint64_t, uint64_t>;
+  MapT hmap(4);
+  for (uint64_t i = 0; i < 64; ++i) hmap.Insert(i, i);
+  std::atomic<bool> done(false);
+  auto visit = [](const uint64_t &, uint64_t &, MapT *&map,
+                  std::atomic<bool> *&done) {
+    if (done->exchange(true)) return;
+    for (uint64_t i = 64; i < kToInsert; ++i) map->Insert(i, i);
+    size_t numEntries = 0;
+    for (auto entry : *map) {
+      ASSERT_EQ(entry.first, entry.second);
+      ++numEntries;
+    }
+    ASSERT_EQ(numEntries, size_t(kToInsert));
+    ASSERT_GT(map->MemoryFootprint(), kToInsert * 2 * sizeof(uint64_t));
+    map->Reserve(2 * kToInsert);
+  };
+  MapT *mapPtr = &hmap;
+  std::atomic<bool> *donePtr = &done;
+  hmap.ForEachEntry(visit, mapPtr, donePtr);
+  ASSERT_TRUE(done.load());
+
+  uint64_t checksum = 0;
+  for (auto entry : hmap) checksum += entry.first;
+  ASSERT_EQ(checksum, kToInsert * (kToInsert - 1) / 2);
+  for (uint64_t i = 0; i < kToInsert; ++i) {
+    uint64_t *value = hmap.Lookup(i);
+    ASSERT_NE(value, nullptr);
+    ASSERT_EQ(*value, i);
+  }
+}
+
+TEST_F(LocalHashmapTest, Reserve) {
+  HashmapType hmap(1);
+  uint64_t toInsert = 8 * kToInsert;
+  shad::rt::forEachAt(shad::rt::thisLocality(), InsertLookupTestParallelFunc,
+                      std::make_tuple(&hmap, 0lu), toInsert / 2);
+  hmap.Reserve(toInsert);
+  CheckAllEntries(&hmap, toInsert / 2);
+  shad::rt::forEachAt(shad::rt::thisLocality(), InsertLookupTestParallelFunc,
+                      std::make_tuple(&hmap, toInsert / 2), toInsert / 2);
+  CheckAllEntries(&hmap, toInsert);
+}
+
+TEST_F(LocalHashmapTest, BatchOperations) {
+  HashmapType hmap(kNumBuckets);
+  std::vector<Key> keys(kToInsert);
+  std::vector<Value> values(kToInsert);
+  for (uint64_t i = 0; i < kToInsert; i++) {
+    FillKey(&keys[i], i);
+    FillValue(&values[i], i + 11);
+  }
+  // Insert the even keys.
+  std::vector<Key> evenKeys;
+  std::vector<Value> evenValues;
+  for (uint64_t i = 0; i < kToInsert; i += 2) {
+    evenKeys.push_back(keys[i]);
+    evenValues.push_back(values[i]);
+  }
+  hmap.InsertBatch(evenKeys.data(), evenValues.data(), evenKeys.size());
+  ASSERT_EQ(hmap.Size(), kToInsert / 2);
+
+  std::vector<Value> out(kToInsert);
+  std::unique_ptr<bool[]> found(new bool[kToInsert]);
+  hmap.LookupBatch(keys.data(), kToInsert, out.data(), found.get());
+  for (uint64_t i = 0; i < kToInsert; i++) {
+    ASSERT_EQ(found[i], i % 2 == 0);
+    if (found[i]) CheckValue(&out[i], i + 11);
+  }
+
+  // Entries with key and value members, as in the Hashmap buffers.
+  struct Entry {
+    Key key;
+    Value value;
+  };
+  std::vector<Entry> entries(kToInsert);
+  for (uint64_t i = 0; i < kToInsert; i++) {
+    entries[i].key = keys[i];
+    FillValue(&entries[i].value, i + 22);
+  }
+  hmap.InsertBatch(entries.data(), entries.size());
+  ASSERT_EQ(hmap.Size(), size_t(kToInsert));
+
+  size_t numApplied = 0;
+  hmap.ApplyBatch(
+      keys.data(), kToInsert,
+      [](const Key &key, Value &value, size_t &numApplied) {
+        ++numApplied;
+        value.value[0] += 1;
+      },
+      numApplied);
+  ASSERT_EQ(numApplied, size_t(kToInsert));
+  for (uint64_t i = 0; i < kToInsert; i++) {
+    Value value;
+    ASSERT_TRUE(hmap.Lookup(keys[i], &value));
+    ASSERT_EQ(value.value[0], i + 23);
+    ASSERT_EQ(value.value[1], i + 23);
+  }
+}
+
 TEST_F(LocalHashmapTest, Erase) {
   HashmapType hmap(kNumBuckets);
   size_t it_chunk = 1;
@@ -636,3 +821,54 @@ TEST_F(LocalHashmapTest, LocalIteratorPartitions) {
     ASSERT_EQ(exp_checksum, obs_checksum);
   }
 }
+
+using SoAHashmapType = shad::LocalSoAHashmap<uint32_t, uint64_t>;
+
+TEST_F(LocalHashmapTest, SoALayout) {
+  // One initial bucket, so that the insertions resize the hashmap.
+  SoAHashmapType hmap(1);
+  for (uint32_t i = 0; i < kToInsert; ++i)
+    ASSERT_TRUE(hmap.Insert(i, i + 11).second);
+  ASSERT_EQ(hmap.Size(), size_t(kToInsert));
+  for (uint32_t i = 0; i < kToInsert; ++i) {
+    uint64_t *value = hmap.Lookup(i);
+    ASSERT_NE(value, nullptr);
+    ASSERT_EQ(*value, i + 11);
+  }
+  ASSERT_EQ(hmap.Lookup(kToInsert), nullptr);
+
+  for (uint32_t i = 0; i < kToInsert; i += 2) hmap.Erase(i);
+  ASSERT_EQ(hmap.Size(), size_t(kToInsert / 2));
+  size_t numKeys = 0;
+  size_t *numKeysPtr = &numKeys;
+  hmap.ForEachKey(
+      [](const uint32_t &key, size_t *&numKeys) {
+        ASSERT_EQ(key % 2, 1);
+        __sync_fetch_and_add(numKeys, 1);
+      },
+      numKeysPtr);
+  ASSERT_EQ(numKeys, size_t(kToInsert / 2));
+
+  uint64_t checksum = 0;
+  for (auto entry : hmap) {
+    ASSERT_EQ(entry.second, entry.first + 11);
+    checksum += entry.first;
+  }
+  ASSERT_EQ(checksum, (kToInsert / 2) * (kToInsert / 2));
+}
+
+TEST_F(LocalHashmapTest, MemoryFootprint) {
+  shad::LocalHashmap<uint32_t, uint64_t> aos(kNumBuckets);
+  SoAHashmapType soa(kNumBuckets);
+  size_t emptyBytes = soa.MemoryFootprint();
+  for (uint32_t i = 0; i < kToInsert; ++i) {
+    aos.Insert(i, i);
+    soa.Insert(i, i);
+  }
+  ASSERT_GT(soa.MemoryFootprint(), emptyBytes);
+  // Entries take 24 bytes with the AoSLayout and 13 with the SoALayout.
+  ASSERT_LT(soa.MemoryFootprint(), aos.MemoryFootprint());
+
+  soa.Clear();
+  ASSERT_EQ(soa.MemoryFootprint(), emptyBytes);
+}
@@ -26,6 +26,7 @@
 
 #include "gtest/gtest.h"
 
+#include "shad/data_structures/local_flat_set.h"
 #include "shad/data_structures/local_set.h"
 #include "shad/runtime/runtime.h"
 
@@ -114,6 +115,28 @@ class LocalSetTest : public ::testing::Test {
     const size_t start_it = std::get<1>(t);
     ASSERT_TRUE(DoFind(setPtr, start_it + iter));
   }
+
+  static void InsertFindTestParallelFunc(
+      const std::tuple<shad::LocalSet<Entry> *, size_t> &t, const size_t iter) {
+    auto setPtr = std::get<0>(t);
+    const size_t start_it = std::get<1>(t);
+    ASSERT_TRUE(DoInsert(setPtr, start_it + iter).second);
+    ASSERT_TRUE(DoFind(setPtr, start_it + iter));
+  }
+
+  static void CheckAllElements(shad::LocalSet<Entry> *setPtr, size_t n) {
+    ASSERT_EQ(setPtr->Size(), n);
+    std::vector<bool> seen(n, false);
+    for (auto &element : *setPtr) {
+      uint64_t seed = GetSeed(&element);
+      ASSERT_LT(seed, n);
+      ASSERT_FALSE(seen[seed]);
+      seen[seed] = true;
+      CheckElement(&element, seed);
+    }
+    shad::rt::forEachAt(shad::rt::thisLocality(), FindTestParallelFunc,
+                        std::make_tuple(setPtr, 0lu), n);
+  }
 };
 
 TEST_F(LocalSetTest, InsertFindTest) {
@@ -206,6 +229,59 @@ TEST_F(LocalSetTest, InsertFindParallel) {
   }
 }
 
+TEST_F(LocalSetTest, ResizeUnderConcurrentInserts) {
+  shad::LocalSet<Entry> set(1);
+  uint64_t toInsert = 8 * kToInsert;
+  shad::rt::forEachAt(shad::rt::thisLocality(), InsertFindTestParallelFunc,
+                      std::make_tuple(&set, 0lu), toInsert);
+  CheckAllElements(&set, toInsert);
+
+  for (uint64_t i = 0; i < toInsert; i += 2) {
+    Entry k;
+    FillEntry(&k, i);
+    set.Erase(k);
+  }
+  ASSERT_EQ(set.Size(), toInsert / 2);
+  for (uint64_t i = 0; i < toInsert; ++i) {
+    ASSERT_EQ(DoFind(&set, i), i % 2 != 0);
+  }
+
+  set.Clear();
+  ASSERT_EQ(set.Size(), 0);
+  shad::rt::forEachAt(shad::rt::thisLocality(), InsertFindTestParallelFunc,
+                      std::make_tuple(&set, 0lu), size_t(kToInsert));
+  CheckAllElements(&set, kToInsert);
+}
+
+TEST_F(LocalSetTest, InsertIteratorDuringResize) {
+  // With one initial bucket, most insertions start or help a resize that
+  // migrates the chain holding the new element.
+  shad::LocalSet<uint64_t> set(1);
+  for (uint64_t i = 0; i < kToInsert; ++i) {
+    auto res = set.Insert(i);
+    ASSERT_TRUE(res.second);
+    ASSERT_EQ(*res.first, i);
+  }
+  for (uint64_t i = 0; i < kToInsert; ++i) {
+    auto res = set.Insert(i);
+    ASSERT_FALSE(res.second);
+    ASSERT_EQ(*res.first, i);
+  }
+  ASSERT_EQ(set.Size(), size_t(kToInsert));
+}
+
+TEST_F(LocalSetTest, Reserve) {
+  shad::LocalSet<Entry> set(1);
+  uint64_t toInsert = 8 * kToInsert;
+  shad::rt::forEachAt(shad::rt::thisLocality(), InsertFindTestParallelFunc,
+                      std::make_tuple(&set, 0lu), toInsert / 2);
+  set.Reserve(toInsert);
+  CheckAllElements(&set, toInsert / 2);
+  shad::rt::forEachAt(shad::rt::thisLocality(), InsertFindTestParallelFunc,
+                      std::make_tuple(&set, toInsert / 2), toInsert / 2);
+  CheckAllElements(&set, toInsert);
+}
+
 TEST_F(LocalSetTest, Erase) {
   shad::LocalSet<Entry> set(kNumBuckets);
   size_t it_chunk = 1;
@@ -277,6 +353,28 @@ TEST_F(LocalSetTest, AsyncErase) {
   }
 }
 
+// Erasures of elements of the same chains run concurrently, and move the last
+// entries of the chains.
+TEST_F(LocalSetTest, ConcurrentErase) {
+  for (size_t round = 0; round < 10; ++round) {
+    shad::LocalSet<uint64_t> set(1);
+    for (uint64_t i = 0; i < kToInsert; ++i) set.Insert(i);
+
+    shad::rt::Handle handle;
+    auto eraseFun = [](shad::rt::Handle &,
+                       shad::LocalSet<uint64_t> *const &setPtr, size_t i) {
+      if ((i % 3) != 0u) setPtr->Erase(i);
+    };
+    shad::rt::asyncForEachAt(handle, shad::rt::thisLocality(), eraseFun,
+                             &set, kToInsert);
+    shad::rt::waitForCompletion(handle);
+
+    ASSERT_EQ(set.Size(), (kToInsert + 2) / 3);
+    for (uint64_t i = 0; i < kToInsert; ++i)
+      ASSERT_EQ(set.Find(i), (i % 3) == 0u);
+  }
+}
+
 TEST_F(LocalSetTest, ForEachElement) {
   shad::LocalSet<Entry> set(kNumBuckets);
   auto args = std::make_tuple(&set, 0lu);
@@ -407,3 +505,43 @@ TEST_F(LocalSetTest, LocalIteratorPartitions) {
     ASSERT_EQ(exp_checksum, obs_checksum);
   }
 }
+
+TEST_F(LocalSetTest, LocalFlatSet) {
+  using FlatSetT = shad::LocalFlatSet<uint64_t>;
+  FlatSetT set;
+  for (uint64_t i = 0; i < kToInsert; i++) {
+    auto res = set.Insert(i);
+    ASSERT_TRUE(res.second);
+    ASSERT_EQ(*res.first, i);
+  }
+  for (uint64_t i = 0; i < kToInsert; i++) {
+    auto res = set.Insert(i);
+    ASSERT_FALSE(res.second);
+    ASSERT_EQ(*res.first, i);
+  }
+  size_t toinsert = kToInsert;
+  ASSERT_EQ(set.Size(), toinsert);
+
+  for (uint64_t i = 0; i < kToInsert; i += 3) set.Erase(i);
+  uint64_t cnt = 0;
+  uint64_t *cntPtr = &cnt;
+  set.ForEachElement(
+      [](const uint64_t &element, uint64_t *&cntPtr) {
+        ASSERT_NE(element % 3, 0);
+        __sync_fetch_and_add(cntPtr, 1);
+      },
+      cntPtr);
+  ASSERT_EQ(cnt, set.Size());
+  uint64_t checksum = 0, expChecksum = 0;
+  for (auto element : set) checksum += element;
+  for (uint64_t i = 0; i < kToInsert; i++) {
+    ASSERT_EQ(set.Find(i), (i % 3) != 0u);
+    if ((i % 3) != 0u) expChecksum += i;
+  }
+  ASSERT_EQ(checksum, expChecksum);
+
+  set.Reset(kToInsert);
+  ASSERT_EQ(set.Size(), 0);
+  ASSERT_TRUE(set.begin() == set.end());
+  ASSERT_FALSE(set.Find(1));
+}
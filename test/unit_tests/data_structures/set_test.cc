@@ -26,6 +26,7 @@
 
 #include "gtest/gtest.h"
 
+#include "shad/data_structures/local_flat_set.h"
 #include "shad/data_structures/set.h"
 #include "shad/runtime/runtime.h"
 
@@ -167,6 +168,28 @@ TEST_F(SetTest, AsyncInsertAsyncFindTest) {
   shad::Set<Entry>::Destroy(oid);
 }
 
+TEST_F(SetTest, BulkInsertFindTest) {
+  auto setPtr = shad::Set<Entry>::Create(kToInsert);
+  auto oid = setPtr->GetGlobalID();
+  // Every locality generates all the elements: duplicates must be merged.
+  auto generator = [](const uint8_t &,
+                      shad::Set<Entry>::BulkInserter &inserter) {
+    for (uint64_t i = 1; i <= kToInsert; i++) {
+      Entry entry;
+      FillEntry(&entry, i);
+      inserter.Insert(entry);
+    }
+  };
+  setPtr->BulkInsert(generator, uint8_t(0));
+  size_t toinsert = kToInsert;
+  ASSERT_EQ(setPtr->Size(), toinsert);
+  for (uint64_t i = 1; i <= kToInsert; i++) {
+    ASSERT_TRUE(DoFind(oid, i));
+  }
+  ASSERT_FALSE(DoFind(oid, 1234567890));
+  shad::Set<Entry>::Destroy(oid);
+}
+
 TEST_F(SetTest, InsertFindParallel) {
   auto setPtr = shad::Set<Entry>::Create(kToInsert);
   auto oid = setPtr->GetGlobalID();
@@ -327,3 +350,25 @@ TEST_F(SetTest, AsyncForEachElement) {
   shad::rt::waitForCompletion(handle);
   shad::Set<Entry>::Destroy(oid);
 }
+
+TEST_F(SetTest, FlatLocalSet) {
+  using FlatSetT = shad::Set<uint64_t, shad::MemCmp<uint64_t>,
+                             shad::LocalFlatSet>;
+  auto setPtr = FlatSetT::Create(kToInsert);
+  for (uint64_t i = 0; i < kToInsert; ++i) setPtr->BufferedInsert(i);
+  setPtr->WaitForBufferedInsert();
+  size_t toinsert = kToInsert;
+  ASSERT_EQ(setPtr->Size(), toinsert);
+  for (uint64_t i = 0; i < kToInsert; ++i) ASSERT_TRUE(setPtr->Find(i));
+  ASSERT_FALSE(setPtr->Find(uint64_t(kToInsert)));
+
+  uint64_t checksum = 0;
+  for (auto element : *setPtr) checksum += element;
+  ASSERT_EQ(checksum, kToInsert * (kToInsert - 1) / 2);
+
+  for (uint64_t i = 0; i < kToInsert; i += 2) setPtr->Erase(i);
+  ASSERT_EQ(setPtr->Size(), toinsert / 2);
+  setPtr->ForEachElement(
+      [](const uint64_t &element) { ASSERT_NE(element % 2, 0); });
+  FlatSetT::Destroy(setPtr->GetGlobalID());
+}
@@ -424,3 +424,46 @@ TEST_F(EdgeIndexTest, AsyncInsertAsyncForeachEdgeTest) {
   shad::rt::waitForCompletion(handle);
   EIType::Destroy(oid);
 }
+
+using FlatEIType = shad::EdgeIndex<
+    uint64_t, int,
+    shad::DefaultEdgeIndexStorage<uint64_t, int, shad::LocalFlatSet<int>,
+                                  shad::LocalFlatHashmap>>;
+
+TEST_F(EdgeIndexTest, FlatStorageAsyncInsertEraseTest) {
+  auto eidxPtr = FlatEIType::Create(kToInsert);
+  auto oid = eidxPtr->GetGlobalID();
+  shad::rt::Handle handle;
+  shad::rt::asyncForEachOnAll(
+      handle,
+      [](shad::rt::Handle &handle, const FlatEIType::ObjectID &oid,
+         size_t i) {
+        auto eiptr = FlatEIType::GetPtr(oid);
+        size_t nsize = std::max<size_t>(i % kMaxNLSize, 1);
+        for (size_t j = 0; j < nsize; j++) {
+          eiptr->AsyncInsert(handle, i, i + j);
+        }
+      },
+      oid, kToInsert);
+  shad::rt::waitForCompletion(handle);
+  ASSERT_EQ(eidxPtr->Size(), kToInsert);
+  ASSERT_EQ(eidxPtr->NumEdges(), expectedNumEdges_);
+  shad::rt::forEachOnAll(
+      [](const FlatEIType::ObjectID &oid, size_t i) {
+        auto eiptr = FlatEIType::GetPtr(oid);
+        size_t nsize = std::max<size_t>(i % kMaxNLSize, 1);
+        for (size_t j = 1; j < nsize; j += 2) {
+          eiptr->Erase(i, i + j);
+        }
+      },
+      oid, kToInsert);
+  ASSERT_EQ(eidxPtr->Size(), kToInsert);
+  ASSERT_EQ(eidxPtr->NumEdges(), expectedNumEdgesAfterErase_);
+  auto ForEachELambda = [](const uint64_t &src, const int &dest) {
+    size_t nsize = std::max<size_t>(src % kMaxNLSize, 1);
+    ASSERT_TRUE(dest >= src && dest < (src + nsize));
+    ASSERT_EQ((dest - src) % 2, 0);
+  };
+  eidxPtr->ForEachEdge(ForEachELambda);
+  FlatEIType::Destroy(oid);
+}
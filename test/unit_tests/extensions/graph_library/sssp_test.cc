@@ -0,0 +1,84 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include <limits>
+
+#include "gtest/gtest.h"
+
+#include "shad/extensions/graph_library/algorithms/sssp.h"
+#include "shad/extensions/graph_library/edge_index.h"
+#include "shad/runtime/runtime.h"
+
+using GraphType = shad::EdgeIndex<size_t, size_t>;
+
+static const size_t kNumVertices = 64;
+static const size_t kSource = 0;
+
+class SSSPTest : public ::testing::Test {
+ public:
+  SSSPTest() : gid_(GraphType::ObjectID::kNullID) {}
+
+  // A ring over all the vertices but the last one, with a shortcut out of
+  // every vertex, so that paths of different lengths reach most vertices.
+  // The last vertex only has an out-edge: it is not reachable from kSource.
+  void SetUp() {
+    auto graphPtr = GraphType::Create(kNumVertices);
+    gid_ = graphPtr->GetGlobalID();
+    shad::rt::forEachOnAll(
+        [](const GraphType::ObjectID &gid, size_t i) {
+          auto graphPtr = GraphType::GetPtr(gid);
+          const size_t ring = kNumVertices - 1;
+          if (i == ring) {
+            graphPtr->Insert(i, kSource);
+            return;
+          }
+          graphPtr->Insert(i, (i + 1) % ring);
+          graphPtr->Insert(i, (3 * i + 7) % ring);
+        },
+        gid_, kNumVertices);
+  }
+
+  void TearDown() { GraphType::Destroy(gid_); }
+
+  GraphType::ObjectID gid_;
+};
+
+TEST_F(SSSPTest, AsyncAgreesWithLevelSynchronous) {
+  ASSERT_EQ(GraphType::GetPtr(gid_)->Size(), kNumVertices);
+  for (size_t dest = 0; dest < kNumVertices; dest++) {
+    size_t length = sssp_length<GraphType, size_t>(gid_, kSource, dest);
+    size_t asyncLength =
+        async_sssp_length<GraphType, size_t>(gid_, kSource, dest);
+    ASSERT_EQ(asyncLength, length) << "destination " << dest;
+  }
+}
+
+TEST_F(SSSPTest, UnreachableVertex) {
+  const size_t dest = kNumVertices - 1;
+  ASSERT_EQ((sssp_length<GraphType, size_t>(gid_, kSource, dest)),
+            std::numeric_limits<size_t>::max());
+  ASSERT_EQ((async_sssp_length<GraphType, size_t>(gid_, kSource, dest)),
+            std::numeric_limits<size_t>::max());
+}
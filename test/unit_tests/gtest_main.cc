@@ -59,9 +59,10 @@ class DistributedSystemCheck : public testing::EmptyTestEventListener {
 int main(int argc, char *argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
 
-  if (rt::numLocalities() > 1) {
+  if (rt::numLocalities() > rt::impl::numProcessLocalities()) {
     // Add the handler that deals with remote asserts when
-    // we have more than one locality.
+    // we have more than one locality.  Localities hosted by this process
+    // already report to the same test instance.
     shad::rt::executeOnAll(
         [](const size_t &) {
           testing::TestEventListeners &listeners =
@@ -0,0 +1,152 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "shad/runtime/affinity.h"
+#include "shad/runtime/runtime.h"
+
+using shad::rt::IterationAffinity;
+
+static const size_t kNumIters = 10007;
+static std::atomic<uint64_t> count(0);
+static std::atomic<uint64_t> sum(0);
+static std::atomic<uint64_t> misplaced(0);
+
+enum class Mode { kBlocks, kCyclic, kOwner };
+
+struct LoopArgs {
+  Mode mode;
+  size_t numIters;
+};
+
+static uint32_t ownerOf(size_t i) {
+  return (i * 7 + i / 3) % shad::rt::numLocalities();
+}
+
+// Locality 0 owns nothing, the last locality owns the iterations past the
+// last offset.
+static IterationAffinity makeAffinity(Mode mode, size_t numIters) {
+  if (mode == Mode::kCyclic) return IterationAffinity::CyclicBlocks(7);
+  if (mode == Mode::kOwner) return IterationAffinity::Owner(ownerOf);
+  size_t n = shad::rt::numLocalities();
+  std::vector<size_t> offsets(1, 0);
+  for (size_t L = 0; L < n; ++L)
+    offsets.push_back(L == 0 && n > 1 ? 0 : (L + 1) * numIters / (n + 1));
+  return IterationAffinity::Blocks(offsets);
+}
+
+static void visit(const LoopArgs &args, size_t i) {
+  count.fetch_add(1);
+  sum.fetch_add(i);
+  auto affinity = makeAffinity(args.mode, args.numIters);
+  if (affinity.OwnerOf(i) != shad::rt::thisLocality()) misplaced.fetch_add(1);
+}
+
+static void indexTask(const LoopArgs &args, size_t i) { visit(args, i); }
+
+static void rangeTask(const LoopArgs &args, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; ++i) visit(args, i);
+}
+
+static void asyncIndexTask(shad::rt::Handle &, const LoopArgs &args,
+                           size_t i) {
+  visit(args, i);
+}
+
+static void asyncRangeTask(shad::rt::Handle &, const LoopArgs &args,
+                           size_t begin, size_t end) {
+  for (size_t i = begin; i < end; ++i) visit(args, i);
+}
+
+static void drainCounters(const bool &, uint8_t *result, uint32_t *resSize) {
+  uint64_t counters[3] = {count.exchange(0), sum.exchange(0),
+                          misplaced.exchange(0)};
+  memcpy(result, counters, sizeof(counters));
+  *resSize = sizeof(counters);
+}
+
+class AffinityTest : public ::testing::Test {
+ protected:
+  void CheckVisits(size_t numIters) {
+    uint64_t total[3] = {0, 0, 0};
+    for (auto &locality : shad::rt::allLocalities()) {
+      uint64_t counters[3];
+      uint32_t size;
+      shad::rt::executeAtWithRetBuff(locality, drainCounters, false,
+                                     reinterpret_cast<uint8_t *>(counters),
+                                     &size);
+      for (size_t i = 0; i < 3; ++i) total[i] += counters[i];
+    }
+    ASSERT_EQ(total[0], numIters);
+    ASSERT_EQ(total[1], numIters * (numIters - 1) / 2);
+    ASSERT_EQ(total[2], 0);
+  }
+};
+
+TEST_F(AffinityTest, OwnerOf) {
+  size_t n = shad::rt::numLocalities();
+  auto blocks = makeAffinity(Mode::kBlocks, 100);
+  ASSERT_EQ(blocks.OwnerOf(0), shad::rt::Locality(n > 1 ? 1 : 0));
+  ASSERT_EQ(blocks.OwnerOf(1000), shad::rt::Locality(n - 1));
+  auto cyclic = makeAffinity(Mode::kCyclic, 100);
+  for (size_t i = 0; i < 100; ++i)
+    ASSERT_EQ(cyclic.OwnerOf(i), shad::rt::Locality((i / 7) % n));
+}
+
+TEST_F(AffinityTest, ForEachOnAll) {
+  for (auto mode : {Mode::kBlocks, Mode::kCyclic, Mode::kOwner}) {
+    for (size_t numIters : {size_t(1), size_t(20), kNumIters}) {
+      LoopArgs args{mode, numIters};
+      auto affinity = makeAffinity(mode, numIters);
+      shad::rt::forEachOnAll(affinity, indexTask, args, numIters);
+      CheckVisits(numIters);
+      shad::rt::forEachRangeOnAll(affinity, rangeTask, args, numIters,
+                                  shad::rt::SchedulingPolicy::Dynamic(5));
+      CheckVisits(numIters);
+    }
+  }
+}
+
+TEST_F(AffinityTest, AsyncForEachOnAll) {
+  for (auto mode : {Mode::kBlocks, Mode::kCyclic, Mode::kOwner}) {
+    LoopArgs args{mode, kNumIters};
+    auto affinity = makeAffinity(mode, kNumIters);
+    shad::rt::Handle handle;
+    shad::rt::asyncForEachOnAll(handle, affinity, asyncIndexTask, args,
+                                kNumIters);
+    shad::rt::waitForCompletion(handle);
+    CheckVisits(kNumIters);
+    shad::rt::asyncForEachRangeOnAll(handle, affinity, asyncRangeTask, args,
+                                     kNumIters);
+    shad::rt::waitForCompletion(handle);
+    CheckVisits(kNumIters);
+  }
+}
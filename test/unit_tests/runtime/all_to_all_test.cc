@@ -0,0 +1,218 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include <atomic>
+#include <cstdint>
+#include <set>
+
+#include "gtest/gtest.h"
+
+#include "shad/runtime/all_to_all.h"
+#include "shad/runtime/runtime.h"
+
+static const uint32_t kMaxLocalities = 64;
+// Enough values to span several chunks.
+static const uint64_t kValuesPerPair = 20000;
+
+// One slot per locality, also when the localities share the statics.
+static std::atomic<uint64_t> receivedCount[kMaxLocalities];
+static std::atomic<uint64_t> receivedSum[kMaxLocalities];
+static std::atomic<uint64_t> receivedErrors[kMaxLocalities];
+static std::atomic<uint32_t> lastRound[kMaxLocalities];
+
+struct Record {
+  uint32_t src;
+  uint32_t dst;
+  uint64_t index;
+};
+
+static uint64_t NumValues(uint32_t src, uint32_t dst, uint64_t scale) {
+  return scale * (src + 1) + dst;
+}
+
+static void clearReceived(const uint8_t &) {
+  uint32_t L = static_cast<uint32_t>(shad::rt::thisLocality());
+  receivedCount[L] = 0;
+  receivedSum[L] = 0;
+  receivedErrors[L] = 0;
+  lastRound[L] = 0;
+}
+
+static void pack(const uint64_t &scale,
+                 shad::rt::AllToAllVBuffers<Record> &buffers) {
+  uint32_t L = static_cast<uint32_t>(shad::rt::thisLocality());
+  for (auto &dst : shad::rt::allLocalities()) {
+    uint32_t D = static_cast<uint32_t>(dst);
+    for (uint64_t i = 0; i < NumValues(L, D, scale); ++i)
+      buffers.Insert(dst, Record{L, D, i});
+    if (buffers.Size(dst) != NumValues(L, D, scale)) ++receivedErrors[L];
+  }
+}
+
+static void receive(const uint64_t &, const shad::rt::Locality &src,
+                    const Record *records, size_t count) {
+  uint32_t L = static_cast<uint32_t>(shad::rt::thisLocality());
+  uint64_t sum = 0;
+  for (size_t i = 0; i < count; ++i) {
+    if (records[i].src != static_cast<uint32_t>(src) || records[i].dst != L)
+      ++receivedErrors[L];
+    sum += records[i].index;
+  }
+  receivedCount[L] += count;
+  receivedSum[L] += sum;
+}
+
+// Only the odd localities send, and only to the even ones.
+static void packSparse(const uint8_t &,
+                       shad::rt::AllToAllVBuffers<uint8_t> &buffers) {
+  uint32_t L = static_cast<uint32_t>(shad::rt::thisLocality());
+  if (L % 2 == 0) return;
+  for (auto &dst : shad::rt::allLocalities())
+    if (static_cast<uint32_t>(dst) % 2 == 0)
+      buffers.Insert(dst, static_cast<uint8_t>(L));
+}
+
+static void receiveSparse(const uint8_t &, const shad::rt::Locality &src,
+                          const uint8_t *values, size_t count) {
+  uint32_t L = static_cast<uint32_t>(shad::rt::thisLocality());
+  if (L % 2 != 0 || count != 1 || values[0] != static_cast<uint32_t>(src))
+    ++receivedErrors[L];
+  receivedCount[L] += count;
+}
+
+// Every locality sends a single value to every other locality.
+static void packRounds(const uint8_t &,
+                       shad::rt::AllToAllVBuffers<uint32_t> &buffers) {
+  uint32_t L = static_cast<uint32_t>(shad::rt::thisLocality());
+  for (auto &dst : shad::rt::allLocalities())
+    if (static_cast<uint32_t>(dst) != L) buffers.Insert(dst, L);
+}
+
+// The values must arrive in the order of the rounds that ship them.
+static void receiveRounds(const uint8_t &, const shad::rt::Locality &src,
+                          const uint32_t *, size_t) {
+  uint32_t L = static_cast<uint32_t>(shad::rt::thisLocality());
+  uint32_t S = static_cast<uint32_t>(src);
+  uint32_t P = shad::rt::numLocalities();
+  uint32_t round = 1;
+  while (shad::rt::impl::allToAllVPeer(S, round, P) != L) ++round;
+  if (round <= lastRound[L]) ++receivedErrors[L];
+  lastRound[L] = round;
+  ++receivedCount[L];
+}
+
+class AllToAllTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    if (shad::rt::numLocalities() > kMaxLocalities)
+      GTEST_SKIP() << "too many localities";
+    shad::rt::executeOnAll(clearReceived, uint8_t(0));
+  }
+
+  uint64_t Count(const shad::rt::Locality &locality) {
+    uint64_t value;
+    shad::rt::executeAtWithRet(
+        locality,
+        [](const uint32_t &L, uint64_t *value) { *value = receivedCount[L]; },
+        static_cast<uint32_t>(locality), &value);
+    return value;
+  }
+
+  uint64_t Sum(const shad::rt::Locality &locality) {
+    uint64_t value;
+    shad::rt::executeAtWithRet(
+        locality,
+        [](const uint32_t &L, uint64_t *value) { *value = receivedSum[L]; },
+        static_cast<uint32_t>(locality), &value);
+    return value;
+  }
+
+  uint64_t Errors(const shad::rt::Locality &locality) {
+    uint64_t value;
+    shad::rt::executeAtWithRet(
+        locality,
+        [](const uint32_t &L, uint64_t *value) { *value = receivedErrors[L]; },
+        static_cast<uint32_t>(locality), &value);
+    return value;
+  }
+};
+
+TEST_F(AllToAllTest, PeersCoverAllLocalities) {
+  for (uint32_t size : {1, 2, 3, 4, 5, 7, 8, 12, 16}) {
+    for (uint32_t rank = 0; rank < size; ++rank) {
+      std::set<uint32_t> peers;
+      for (uint32_t round = 1; round < size; ++round)
+        peers.insert(shad::rt::impl::allToAllVPeer(rank, round, size));
+      ASSERT_EQ(peers.size(), size - 1);
+      ASSERT_EQ(peers.count(rank), 0);
+    }
+    // Every rank receives from a single peer per round.
+    for (uint32_t round = 1; round < size; ++round) {
+      std::set<uint32_t> destinations;
+      for (uint32_t rank = 0; rank < size; ++rank)
+        destinations.insert(shad::rt::impl::allToAllVPeer(rank, round, size));
+      ASSERT_EQ(destinations.size(), size);
+    }
+  }
+}
+
+TEST_F(AllToAllTest, Exchange) {
+  shad::rt::allToAllV<Record>(pack, receive, kValuesPerPair);
+
+  uint32_t P = shad::rt::numLocalities();
+  for (auto &locality : shad::rt::allLocalities()) {
+    uint32_t D = static_cast<uint32_t>(locality);
+    uint64_t count = 0, sum = 0;
+    for (uint32_t src = 0; src < P; ++src) {
+      uint64_t n = NumValues(src, D, kValuesPerPair);
+      count += n;
+      sum += n * (n - 1) / 2;
+    }
+    ASSERT_EQ(Errors(locality), 0);
+    ASSERT_EQ(Count(locality), count);
+    ASSERT_EQ(Sum(locality), sum);
+  }
+}
+
+TEST_F(AllToAllTest, SparseExchange) {
+  shad::rt::allToAllV<uint8_t>(packSparse, receiveSparse, uint8_t(0));
+
+  uint32_t P = shad::rt::numLocalities();
+  for (auto &locality : shad::rt::allLocalities()) {
+    uint32_t D = static_cast<uint32_t>(locality);
+    ASSERT_EQ(Errors(locality), 0);
+    ASSERT_EQ(Count(locality), D % 2 == 0 ? P / 2 : 0);
+  }
+}
+
+TEST_F(AllToAllTest, RoundsAreInLockstep) {
+  shad::rt::allToAllV<uint32_t>(packRounds, receiveRounds, uint8_t(0));
+
+  uint32_t P = shad::rt::numLocalities();
+  for (auto &locality : shad::rt::allLocalities()) {
+    ASSERT_EQ(Errors(locality), 0);
+    ASSERT_EQ(Count(locality), P - 1);
+  }
+}
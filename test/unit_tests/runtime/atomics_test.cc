@@ -0,0 +1,143 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "shad/runtime/runtime.h"
+
+static const uint32_t kMaxLocalities = 64;
+static const size_t kNumIters = 1024;
+
+// One target per locality, also when the localities share the statics.
+static uint64_t targets[kMaxLocalities];
+
+static void targetAddress(const uint32_t &locality, uint64_t **address) {
+  *address = &targets[locality];
+}
+
+static uint64_t *target(const shad::rt::Locality &locality) {
+  uint64_t *address = nullptr;
+  shad::rt::executeAtWithRet(locality, targetAddress,
+                             static_cast<uint32_t>(locality), &address);
+  shad::rt::atomicFetchAnd(locality, address, uint64_t(0));
+  return address;
+}
+
+class AtomicsTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    if (shad::rt::numLocalities() > kMaxLocalities)
+      GTEST_SKIP() << "too many localities";
+  }
+};
+
+TEST_F(AtomicsTest, FetchOperations) {
+  for (auto &locality : shad::rt::allLocalities()) {
+    uint64_t *address = target(locality);
+    ASSERT_EQ(shad::rt::atomicFetchAdd(locality, address, uint64_t(5)), 0);
+    ASSERT_EQ(shad::rt::atomicFetchSub(locality, address, uint64_t(2)), 5);
+    ASSERT_EQ(shad::rt::atomicFetchOr(locality, address, uint64_t(0x10)), 3);
+    ASSERT_EQ(shad::rt::atomicFetchXor(locality, address, uint64_t(0x1)),
+              0x13);
+    ASSERT_EQ(shad::rt::atomicFetchAnd(locality, address, uint64_t(0x10)),
+              0x12);
+    ASSERT_EQ(shad::rt::atomicFetchOr(locality, address, uint64_t(0)), 0x10);
+  }
+}
+
+TEST_F(AtomicsTest, CompareExchange) {
+  for (auto &locality : shad::rt::allLocalities()) {
+    uint64_t *address = target(locality);
+    ASSERT_EQ(shad::rt::atomicCompareExchange(locality, address, uint64_t(1),
+                                              uint64_t(7)),
+              0);
+    ASSERT_EQ(shad::rt::atomicCompareExchange(locality, address, uint64_t(0),
+                                              uint64_t(7)),
+              0);
+    ASSERT_EQ(shad::rt::atomicCompareExchange(locality, address, uint64_t(7),
+                                              uint64_t(9)),
+              7);
+    ASSERT_EQ(shad::rt::atomicFetchOr(locality, address, uint64_t(0)), 9);
+  }
+}
+
+TEST_F(AtomicsTest, AsyncFetchAdd) {
+  std::vector<uint64_t *> addresses;
+  for (auto &locality : shad::rt::allLocalities())
+    addresses.push_back(target(locality));
+
+  std::vector<std::vector<uint64_t>> results(
+      shad::rt::numLocalities(), std::vector<uint64_t>(kNumIters));
+  shad::rt::Handle handle;
+  for (auto &locality : shad::rt::allLocalities()) {
+    uint32_t L = static_cast<uint32_t>(locality);
+    for (size_t i = 0; i < kNumIters; ++i) {
+      shad::rt::asyncAtomicFetchAdd(handle, locality, addresses[L],
+                                    uint64_t(1), &results[L][i]);
+      shad::rt::asyncAtomicFetchAdd(handle, locality, addresses[L],
+                                    uint64_t(1));
+    }
+  }
+  shad::rt::waitForCompletion(handle);
+
+  for (auto &locality : shad::rt::allLocalities()) {
+    uint32_t L = static_cast<uint32_t>(locality);
+    ASSERT_EQ(shad::rt::atomicFetchOr(locality, addresses[L], uint64_t(0)),
+              2 * kNumIters);
+    // Every fetch returned a different value.
+    std::sort(results[L].begin(), results[L].end());
+    ASSERT_EQ(std::unique(results[L].begin(), results[L].end()),
+              results[L].end());
+  }
+}
+
+TEST_F(AtomicsTest, AsyncCompareExchange) {
+  shad::rt::Handle handle;
+  for (auto &locality : shad::rt::allLocalities()) {
+    uint64_t *address = target(locality);
+    uint64_t previous = 42;
+    shad::rt::asyncAtomicCompareExchange(handle, locality, address,
+                                         uint64_t(0), uint64_t(3), &previous);
+    shad::rt::waitForCompletion(handle);
+    ASSERT_EQ(previous, 0);
+    ASSERT_EQ(shad::rt::atomicFetchOr(locality, address, uint64_t(0)), 3);
+  }
+}
+
+static void incrementTarget(uint64_t *const &address, size_t) {
+  shad::rt::atomicFetchAdd(shad::rt::Locality(0), address, uint64_t(1));
+}
+
+TEST_F(AtomicsTest, ConcurrentFetchAdd) {
+  uint64_t *address = target(shad::rt::Locality(0));
+  size_t numIters = kNumIters * shad::rt::numLocalities();
+  shad::rt::forEachOnAll(incrementTarget, address, numIters);
+  ASSERT_EQ(
+      shad::rt::atomicFetchOr(shad::rt::Locality(0), address, uint64_t(0)),
+      numIters);
+}
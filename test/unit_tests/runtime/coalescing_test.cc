@@ -0,0 +1,210 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+#include "gtest/gtest.h"
+
+#include "shad/runtime/runtime.h"
+
+struct CoalescedArgs {
+  uint32_t source;
+  uint32_t value;
+};
+
+struct LargeArgs {
+  uint8_t payload[shad::rt::impl::Coalescer::kMaxArgsSize + 8];
+  uint32_t value;
+};
+
+static const size_t kNumTasks = 10000;
+static std::atomic<uint64_t> received(0);
+static std::atomic<uint64_t> sum(0);
+
+static void resetCounters(const bool &) {
+  received = 0;
+  sum = 0;
+}
+
+static void drainCounters(const bool &, uint8_t *result, uint32_t *resSize) {
+  uint64_t counters[2] = {received.exchange(0), sum.exchange(0)};
+  memcpy(result, counters, sizeof(counters));
+  *resSize = sizeof(counters);
+}
+
+static void coalescedTask(shad::rt::Handle & /*unused*/,
+                          const CoalescedArgs &args) {
+  received.fetch_add(1);
+  sum.fetch_add(args.value);
+}
+
+static void forwardingTask(shad::rt::Handle &handle,
+                           const CoalescedArgs &args) {
+  received.fetch_add(1);
+  auto next = shad::rt::Locality(
+      (static_cast<uint32_t>(shad::rt::thisLocality()) + 1) %
+      shad::rt::numLocalities());
+  shad::rt::asyncExecuteAt(handle, next, coalescedTask, args);
+}
+
+static void largeTask(shad::rt::Handle & /*unused*/, const LargeArgs &args) {
+  received.fetch_add(1);
+  sum.fetch_add(args.value);
+}
+
+class CoalescingTest : public ::testing::Test {
+ protected:
+  void SetUp() { shad::rt::executeOnAll(resetCounters, false); }
+
+  void TearDown() { shad::rt::disableCoalescing(); }
+
+  // Every locality must have received expected tasks, each with the given
+  // value.  Counters are drained, so that localities sharing the process
+  // address space are not counted twice.
+  void CheckAll(uint64_t expected, uint64_t value) {
+    uint64_t totalReceived = 0;
+    uint64_t totalSum = 0;
+    for (auto &locality : shad::rt::allLocalities()) {
+      uint64_t counters[2];
+      uint32_t size = 0;
+      shad::rt::executeAtWithRetBuff(locality, drainCounters, false,
+                                     reinterpret_cast<uint8_t *>(counters),
+                                     &size);
+      ASSERT_EQ(size, sizeof(counters));
+      totalReceived += counters[0];
+      totalSum += counters[1];
+    }
+    ASSERT_EQ(totalReceived, expected * shad::rt::numLocalities());
+    ASSERT_EQ(totalSum, expected * value * shad::rt::numLocalities());
+  }
+};
+
+TEST_F(CoalescingTest, ManySmallTasks) {
+  shad::rt::enableCoalescing();
+
+  shad::rt::Handle handle;
+  for (auto &locality : shad::rt::allLocalities()) {
+    for (size_t i = 0; i < kNumTasks; ++i) {
+      CoalescedArgs args{static_cast<uint32_t>(shad::rt::thisLocality()), 3};
+      shad::rt::asyncExecuteAt(handle, locality, coalescedTask, args);
+    }
+  }
+  shad::rt::waitForCompletion(handle);
+
+  CheckAll(kNumTasks, 3);
+}
+
+TEST_F(CoalescingTest, SmallBatchesAndNoDelay) {
+  shad::rt::enableCoalescing(64, 0);
+
+  shad::rt::Handle handle;
+  for (auto &locality : shad::rt::allLocalities()) {
+    for (size_t i = 0; i < kNumTasks; ++i) {
+      CoalescedArgs args{static_cast<uint32_t>(shad::rt::thisLocality()), 5};
+      shad::rt::asyncExecuteAt(handle, locality, coalescedTask, args);
+    }
+  }
+  shad::rt::waitForCompletion(handle);
+
+  CheckAll(kNumTasks, 5);
+}
+
+TEST_F(CoalescingTest, NestedTasks) {
+  shad::rt::enableCoalescing();
+
+  shad::rt::Handle handle;
+  for (auto &locality : shad::rt::allLocalities()) {
+    for (size_t i = 0; i < kNumTasks; ++i) {
+      CoalescedArgs args{static_cast<uint32_t>(shad::rt::thisLocality()), 0};
+      shad::rt::asyncExecuteAt(handle, locality, forwardingTask, args);
+    }
+  }
+  shad::rt::waitForCompletion(handle);
+
+  // Every locality runs kNumTasks forwarding tasks and kNumTasks forwarded.
+  CheckAll(2 * kNumTasks, 0);
+}
+
+TEST_F(CoalescingTest, LargeArgumentsAreNotCoalesced) {
+  static_assert(!shad::rt::impl::Coalescer::IsCoalescible<LargeArgs>(),
+                "LargeArgs must not be coalesced");
+  shad::rt::enableCoalescing();
+
+  shad::rt::Handle handle;
+  LargeArgs args{};
+  args.value = 7;
+  for (auto &locality : shad::rt::allLocalities()) {
+    for (size_t i = 0; i < kNumTasks / 10; ++i)
+      shad::rt::asyncExecuteAt(handle, locality, largeTask, args);
+  }
+  shad::rt::waitForCompletion(handle);
+
+  CheckAll(kNumTasks / 10, 7);
+}
+
+TEST_F(CoalescingTest, DisabledCoalescing) {
+  shad::rt::Handle handle;
+  for (auto &locality : shad::rt::allLocalities()) {
+    for (size_t i = 0; i < kNumTasks / 10; ++i) {
+      CoalescedArgs args{static_cast<uint32_t>(shad::rt::thisLocality()), 1};
+      shad::rt::asyncExecuteAt(handle, locality, coalescedTask, args);
+    }
+  }
+  shad::rt::waitForCompletion(handle);
+
+  CheckAll(kNumTasks / 10, 1);
+}
+
+TEST_F(CoalescingTest, BatchesAreShippedBeforeWaiting) {
+  // The time threshold is never reached, and the Handle is waited last.
+  shad::rt::enableCoalescing(shad::rt::impl::Coalescer::kDefaultMaxBatchBytes,
+                             uint64_t(60) * 1000000000);
+
+  shad::rt::Handle handle;
+  for (auto &locality : shad::rt::allLocalities()) {
+    if (locality == shad::rt::thisLocality()) continue;
+    CoalescedArgs args{static_cast<uint32_t>(shad::rt::thisLocality()), 1};
+    shad::rt::asyncExecuteAt(handle, locality, coalescedTask, args);
+  }
+
+  uint64_t totalReceived = 0;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+  while (totalReceived < shad::rt::numLocalities() - 1 &&
+         std::chrono::steady_clock::now() < deadline) {
+    for (auto &locality : shad::rt::allLocalities()) {
+      uint64_t counters[2];
+      uint32_t size = 0;
+      shad::rt::executeAtWithRetBuff(locality, drainCounters, false,
+                                     reinterpret_cast<uint8_t *>(counters),
+                                     &size);
+      totalReceived += counters[0];
+    }
+  }
+  shad::rt::waitForCompletion(handle);
+
+  ASSERT_EQ(totalReceived, shad::rt::numLocalities() - 1);
+}
@@ -0,0 +1,194 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "shad/runtime/collectives.h"
+#include "shad/runtime/runtime.h"
+
+static const uint32_t kMaxLocalities = 64;
+static const uint32_t kBufferSize = 128;
+
+// One slot per locality, also when the localities share the statics.
+static std::atomic<uint64_t> received[kMaxLocalities];
+
+static void clearReceived(const uint8_t &) {
+  received[static_cast<uint32_t>(shad::rt::thisLocality())] = 0;
+}
+
+static void receive(const uint64_t &value) {
+  received[static_cast<uint32_t>(shad::rt::thisLocality())] += value;
+}
+
+static void receiveBuffer(const uint8_t *buffer, const uint32_t size) {
+  uint64_t sum = 0;
+  for (uint32_t i = 0; i < size; ++i) sum += buffer[i];
+  receive(sum);
+}
+
+static void contribution(const uint64_t &offset, uint64_t *value) {
+  *value = static_cast<uint32_t>(shad::rt::thisLocality()) + offset;
+}
+
+static uint64_t sum(const uint64_t &lhs, const uint64_t &rhs) {
+  return lhs + rhs;
+}
+
+static uint64_t max(const uint64_t &lhs, const uint64_t &rhs) {
+  return std::max(lhs, rhs);
+}
+
+using Vector = std::array<uint64_t, 4>;
+
+static void vectorContribution(const uint8_t &, Vector *value) {
+  uint64_t L = static_cast<uint32_t>(shad::rt::thisLocality());
+  *value = {L, 1, L * L, 2};
+}
+
+static Vector vectorSum(const Vector &lhs, const Vector &rhs) {
+  Vector sum;
+  for (size_t i = 0; i < sum.size(); ++i) sum[i] = lhs[i] + rhs[i];
+  return sum;
+}
+
+static void deliver(const uint64_t &, const uint64_t &value) {
+  receive(value);
+}
+
+class CollectivesTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    if (shad::rt::numLocalities() > kMaxLocalities)
+      GTEST_SKIP() << "too many localities";
+    shad::rt::executeOnAll(clearReceived, uint8_t(0));
+  }
+
+  uint64_t Received(const shad::rt::Locality &locality) {
+    uint64_t value;
+    shad::rt::executeAtWithRet(
+        locality,
+        [](const uint32_t &L, uint64_t *value) { *value = received[L]; },
+        static_cast<uint32_t>(locality), &value);
+    return value;
+  }
+
+  // The sum of contribution(offset) over all localities.
+  uint64_t ExpectedSum(uint64_t offset) {
+    uint64_t P = shad::rt::numLocalities();
+    return P * (P - 1) / 2 + P * offset;
+  }
+};
+
+TEST_F(CollectivesTest, Broadcast) {
+  shad::rt::broadcast(receive, uint64_t(3));
+  shad::rt::broadcast(receive, uint64_t(4));
+  for (auto &locality : shad::rt::allLocalities())
+    ASSERT_EQ(Received(locality), 7);
+}
+
+TEST_F(CollectivesTest, BroadcastBuffer) {
+  std::shared_ptr<uint8_t> buffer(new uint8_t[kBufferSize],
+                                  std::default_delete<uint8_t[]>());
+  std::memset(buffer.get(), 1, kBufferSize);
+  shad::rt::broadcast(receiveBuffer, buffer, kBufferSize);
+  for (auto &locality : shad::rt::allLocalities())
+    ASSERT_EQ(Received(locality), kBufferSize);
+}
+
+TEST_F(CollectivesTest, BroadcastFromLastLocality) {
+  shad::rt::Locality last(shad::rt::numLocalities() - 1);
+  shad::rt::executeAt(
+      last,
+      [](const uint64_t &value) { shad::rt::broadcast(receive, value); },
+      uint64_t(5));
+  for (auto &locality : shad::rt::allLocalities())
+    ASSERT_EQ(Received(locality), 5);
+}
+
+TEST_F(CollectivesTest, Reduce) {
+  uint64_t sum = 0;
+  shad::rt::reduce(contribution, uint64_t(1), &sum);
+  ASSERT_EQ(sum, ExpectedSum(1));
+
+  uint64_t largest = 0;
+  shad::rt::reduce(contribution, uint64_t(10), max, &largest);
+  ASSERT_EQ(largest, shad::rt::numLocalities() - 1 + 10);
+}
+
+TEST_F(CollectivesTest, ReduceArray) {
+  Vector sum;
+  shad::rt::reduce(vectorContribution, uint8_t(0), vectorSum, &sum);
+
+  uint64_t P = shad::rt::numLocalities();
+  ASSERT_EQ(sum[0], P * (P - 1) / 2);
+  ASSERT_EQ(sum[1], P);
+  ASSERT_EQ(sum[2], (P - 1) * P * (2 * P - 1) / 6);
+  ASSERT_EQ(sum[3], 2 * P);
+}
+
+TEST_F(CollectivesTest, ReduceFromLastLocality) {
+  shad::rt::Locality last(shad::rt::numLocalities() - 1);
+  uint64_t sum = 0;
+  shad::rt::executeAtWithRet(
+      last,
+      [](const uint64_t &offset, uint64_t *sum) {
+        shad::rt::reduce(contribution, offset, sum);
+      },
+      uint64_t(2), &sum);
+  ASSERT_EQ(sum, ExpectedSum(2));
+}
+
+TEST_F(CollectivesTest, AllReduce) {
+  uint64_t sum = 0;
+  shad::rt::allReduce(contribution, uint64_t(3), ::sum, deliver, &sum);
+  ASSERT_EQ(sum, ExpectedSum(3));
+  for (auto &locality : shad::rt::allLocalities())
+    ASSERT_EQ(Received(locality), ExpectedSum(3));
+}
+
+TEST_F(CollectivesTest, ConcurrentCollectives) {
+  // Every locality runs its own collectives at the same time.
+  shad::rt::executeOnAll(
+      [](const uint8_t &) {
+        shad::rt::barrier();
+        shad::rt::broadcast(receive, uint64_t(1));
+        uint64_t sum = 0;
+        shad::rt::reduce(contribution, uint64_t(0), &sum);
+        receive(sum);
+        shad::rt::barrier();
+      },
+      uint8_t(0));
+
+  uint64_t P = shad::rt::numLocalities();
+  for (auto &locality : shad::rt::allLocalities())
+    ASSERT_EQ(Received(locality), P + ExpectedSum(0));
+}
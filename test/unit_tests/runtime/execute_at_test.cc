@@ -22,6 +22,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cstring>
 #include <sstream>
 #include <string>
@@ -41,36 +42,43 @@ struct exData {
   }
 };
 
-static exData globalData = {0, shad::rt::Locality(), 0ul};
+static const uint32_t kMaxLocalities = 64;
+// One slot per locality, also when the localities share the statics.
+static exData globalData[kMaxLocalities];
+
+static exData &localData() {
+  return globalData[static_cast<uint32_t>(shad::rt::thisLocality())];
+}
+
 static const unsigned kNumIters = 100;
 static const size_t kValue = 3;
 
 static void incrFun(const exData &data) {
-  globalData.counter += data.counter;
-  globalData.locality = data.locality;
+  localData().counter += data.counter;
+  localData().locality = data.locality;
 };
 
 static void asyncIncrFun(shad::rt::Handle & /*unused*/, const exData &data) {
-  __sync_fetch_and_add(&globalData.counter, data.counter);
-  globalData.locality = data.locality;
+  __sync_fetch_and_add(&localData().counter, data.counter);
+  localData().locality = data.locality;
 };
 
 static void incrFunWithRetBuff(const exData &data, uint8_t *result,
                                uint32_t *resSize) {
-  globalData.counter += data.counter;
-  globalData.locality = data.locality;
-  *resSize = sizeof(globalData);
-  memcpy(result, &globalData, *resSize);
+  localData().counter += data.counter;
+  localData().locality = data.locality;
+  *resSize = sizeof(exData);
+  memcpy(result, &localData(), *resSize);
 };
 
 static void incrFunWithRetBuffExplicit(const uint8_t *argsBuffer,
                                        const uint32_t /*bufferSize*/,
                                        uint8_t *result, uint32_t *resSize) {
   const exData data = *reinterpret_cast<const exData *>(argsBuffer);
-  globalData.counter += data.counter;
-  globalData.locality = data.locality;
-  *resSize = sizeof(globalData);
-  memcpy(result, &globalData, *resSize);
+  localData().counter += data.counter;
+  localData().locality = data.locality;
+  *resSize = sizeof(exData);
+  memcpy(result, &localData(), *resSize);
 };
 
 static void asynIncrFunWithRetBuffExplicit(shad::rt::Handle & /*unused*/,
@@ -78,56 +86,68 @@ static void asynIncrFunWithRetBuffExplicit(shad::rt::Handle & /*unused*/,
                                            const uint32_t /*bufferSize*/,
                                            uint8_t *result, uint32_t *resSize) {
   const exData &data = *reinterpret_cast<const exData *>(argsBuffer);
-  __sync_fetch_and_add(&globalData.counter, data.counter);
-  globalData.locality = data.locality;
+  __sync_fetch_and_add(&localData().counter, data.counter);
+  localData().locality = data.locality;
   exData res{data.counter + 1, data.locality};
 
   *resSize = sizeof(res);
   *reinterpret_cast<exData *>(result) = res;
 };
 
+static void fillRetBuff(const uint32_t &size, uint8_t *result,
+                        uint32_t *resSize) {
+  for (uint32_t i = 0; i < size; ++i) result[i] = static_cast<uint8_t>(i);
+  *resSize = size;
+};
+
+static void asyncFillRetBuff(shad::rt::Handle & /*unused*/,
+                             const uint32_t &size, uint8_t *result,
+                             uint32_t *resSize) {
+  fillRetBuff(size, result, resSize);
+};
+
 static void incrFunWithRetExplicit(const uint8_t *argsBuffer,
                                    const uint32_t /*bufferSize*/,
                                    exData *result) {
   const exData data = *reinterpret_cast<const exData *>(argsBuffer);
-  globalData.counter += data.counter;
-  globalData.locality = data.locality;
-  *result = globalData;
+  localData().counter += data.counter;
+  localData().locality = data.locality;
+  *result = localData();
 };
 
 static void incrFunWithRet(const exData &data, exData *result) {
-  globalData.counter += data.counter;
-  globalData.locality = data.locality;
-  *result = globalData;
+  localData().counter += data.counter;
+  localData().locality = data.locality;
+  *result = localData();
 };
 
 static void incrFunExplicit(const uint8_t *argsBuffer,
                             const uint32_t /*bufferSize*/) {
   const exData data = *reinterpret_cast<const exData *>(argsBuffer);
-  globalData.counter += data.counter;
-  globalData.locality = data.locality;
+  localData().counter += data.counter;
+  localData().locality = data.locality;
 };
 
 static void asyncIncrFunExplicit(shad::rt::Handle & /*unused*/,
                                  const uint8_t *argsBuffer,
                                  const uint32_t /*bufferSize*/) {
   const exData data = *reinterpret_cast<const exData *>(argsBuffer);
-  __sync_fetch_and_add(&globalData.counter, data.counter);
+  __sync_fetch_and_add(&localData().counter, data.counter);
 
-  globalData.locality = data.locality;
+  localData().locality = data.locality;
 }
 
 static void check(const uint8_t * /*unused*/, const uint32_t /*unused*/) {
-  std::cout << globalData.locality << "counter: " << globalData.counter
+  std::cout << localData().locality << "counter: " << localData().counter
             << std::endl;
-  ASSERT_EQ(globalData.locality, shad::rt::thisLocality());
-  ASSERT_EQ(globalData.counter,
-            (kValue + static_cast<uint32_t>(globalData.locality)) * kNumIters);
+  ASSERT_EQ(localData().locality, shad::rt::thisLocality());
+  ASSERT_EQ(localData().counter,
+            (kValue + static_cast<uint32_t>(localData().locality)) * kNumIters);
 };
 
 static void resetLocalityData(const uint8_t * /*unused*/,
                               const uint32_t /*unused*/) {
-  globalData.reset();
+  localData().reset();
 };
 
 static void resetGlobalData() {
@@ -141,7 +161,11 @@ class ExecuteAtTest : public ::testing::Test {
  public:
   ExecuteAtTest() {}
 
-  void SetUp() { resetGlobalData(); }
+  void SetUp() {
+    if (shad::rt::numLocalities() > kMaxLocalities)
+      GTEST_SKIP() << "too many localities";
+    resetGlobalData();
+  }
 
   void TearDown() {}
 };
@@ -310,6 +334,32 @@ TEST_F(ExecuteAtTest, SyncExecuteAtWithRetBuff) {
   }
 }
 
+// Results from a few bytes up to the 64 KiB supported by every mapping.
+TEST_F(ExecuteAtTest, ExecuteAtWithRetBuffSizes) {
+  std::vector<uint8_t> retBuffer(64 << 10);
+  for (uint32_t size : {0u, 8u, 16u << 10, 64u << 10}) {
+    for (auto loc : shad::rt::allLocalities()) {
+      uint32_t retSize = 0;
+      std::fill(retBuffer.begin(), retBuffer.end(), 0xFF);
+      shad::rt::executeAtWithRetBuff(loc, fillRetBuff, size, retBuffer.data(),
+                                     &retSize);
+      ASSERT_EQ(retSize, size);
+      for (uint32_t i = 0; i < size; ++i)
+        ASSERT_EQ(retBuffer[i], static_cast<uint8_t>(i));
+
+      shad::rt::Handle handle;
+      retSize = 0;
+      std::fill(retBuffer.begin(), retBuffer.end(), 0xFF);
+      shad::rt::asyncExecuteAtWithRetBuff(handle, loc, asyncFillRetBuff, size,
+                                          retBuffer.data(), &retSize);
+      shad::rt::waitForCompletion(handle);
+      ASSERT_EQ(retSize, size);
+      for (uint32_t i = 0; i < size; ++i)
+        ASSERT_EQ(retBuffer[i], static_cast<uint8_t>(i));
+    }
+  }
+}
+
 TEST_F(ExecuteAtTest, SyncExecuteAtWithRetExplicit) {
   for (auto loc : shad::rt::allLocalities()) {
     size_t value = kValue + static_cast<uint32_t>(loc);
@@ -369,13 +419,13 @@ TEST_F(ExecuteAtTest, AsyncExecuteAtWithRet) {
             ASSERT_EQ(data.counter,
                       kValue + static_cast<uint32_t>(shad::rt::thisLocality()));
 
-            globalData.locality = data.locality;
+            localData().locality = data.locality;
 
-            ASSERT_GE(static_cast<uint32_t>(globalData.locality), 0);
-            ASSERT_LT(static_cast<uint32_t>(globalData.locality),
+            ASSERT_GE(static_cast<uint32_t>(localData().locality), 0);
+            ASSERT_LT(static_cast<uint32_t>(localData().locality),
                       shad::rt::numLocalities());
 
-            __sync_fetch_and_add(&globalData.counter, data.counter);
+            __sync_fetch_and_add(&localData().counter, data.counter);
             *result = data;
           },
           argv[localityNumber], &retData[i]);
@@ -414,13 +464,13 @@ TEST_F(ExecuteAtTest, AsyncExecuteAtWithRetExplicit) {
             ASSERT_EQ(ptr->counter,
                       kValue + static_cast<uint32_t>(shad::rt::thisLocality()));
 
-            globalData.locality = ptr->locality;
+            localData().locality = ptr->locality;
 
-            ASSERT_GE(static_cast<uint32_t>(globalData.locality), 0);
-            ASSERT_LT(static_cast<uint32_t>(globalData.locality),
+            ASSERT_GE(static_cast<uint32_t>(localData().locality), 0);
+            ASSERT_LT(static_cast<uint32_t>(localData().locality),
                       shad::rt::numLocalities());
 
-            __sync_fetch_and_add(&globalData.counter, ptr->counter);
+            __sync_fetch_and_add(&localData().counter, ptr->counter);
             *result = *ptr;
           },
           data, sizeof(exData), &retData[i]);
@@ -477,13 +527,13 @@ TEST_F(ExecuteAtTest, AsyncExecuteAtWithRetDifferentSizes) {
             ASSERT_EQ(ptr->counter,
                       kValue + static_cast<uint32_t>(shad::rt::thisLocality()));
 
-            globalData.locality = ptr->locality;
+            localData().locality = ptr->locality;
 
-            ASSERT_GE(static_cast<uint32_t>(globalData.locality), 0);
-            ASSERT_LT(static_cast<uint32_t>(globalData.locality),
+            ASSERT_GE(static_cast<uint32_t>(localData().locality), 0);
+            ASSERT_LT(static_cast<uint32_t>(localData().locality),
                       shad::rt::numLocalities());
 
-            __sync_fetch_and_add(&globalData.counter, ptr->counter);
+            __sync_fetch_and_add(&localData().counter, ptr->counter);
             result->a = ptr->counter;
           },
           data, sizeof(exData), &retData1[j]);
@@ -508,12 +558,12 @@ TEST_F(ExecuteAtTest, AsyncExecuteAtWithRetDifferentSizes) {
             ASSERT_EQ(ptr->counter,
                       kValue + static_cast<uint32_t>(shad::rt::thisLocality()));
 
-            globalData.locality = ptr->locality;
+            localData().locality = ptr->locality;
 
-            ASSERT_GE(static_cast<uint32_t>(globalData.locality), 0);
-            ASSERT_LT(static_cast<uint32_t>(globalData.locality),
+            ASSERT_GE(static_cast<uint32_t>(localData().locality), 0);
+            ASSERT_LT(static_cast<uint32_t>(localData().locality),
                       shad::rt::numLocalities());
-            __sync_fetch_and_add(&globalData.counter, ptr->counter);
+            __sync_fetch_and_add(&localData().counter, ptr->counter);
             result->a = ptr->counter;
           },
           data, sizeof(exData), &retData2[i]);
@@ -523,6 +573,38 @@ TEST_F(ExecuteAtTest, AsyncExecuteAtWithRetDifferentSizes) {
   shad::rt::waitForCompletion(handle);
 }
 
+#if !defined(HAVE_SHM) && !defined(HAVE_GMT)
+// Copies of a Handle keep referring to its tasks after the Handle has been
+// waited for, so new Handles never share their state.
+TEST_F(ExecuteAtTest, WaitForCompletionOnHandleCopy) {
+  exData data = {kValue, shad::rt::thisLocality()};
+  shad::rt::Handle handle;
+  for (size_t i = 0; i < kNumIters; i++)
+    shad::rt::asyncExecuteAt(handle, shad::rt::thisLocality(), asyncIncrFun,
+                             data);
+  shad::rt::Handle copy(handle);
+  shad::rt::waitForCompletion(handle);
+  ASSERT_EQ(localData().counter, kNumIters * kValue);
+
+  shad::rt::Handle other;
+  shad::rt::asyncExecuteAt(other, shad::rt::thisLocality(), asyncIncrFun,
+                           data);
+  ASSERT_FALSE(other == copy);
+  shad::rt::waitForCompletion(copy);
+  shad::rt::waitForCompletion(other);
+  ASSERT_EQ(localData().counter, (kNumIters + 1) * kValue);
+
+  shad::rt::Handle first, second;
+  shad::rt::asyncExecuteAt(first, shad::rt::thisLocality(), asyncIncrFun,
+                           data);
+  shad::rt::asyncExecuteAt(second, shad::rt::thisLocality(), asyncIncrFun,
+                           data);
+  ASSERT_FALSE(first == second);
+  shad::rt::waitForCompletion(first);
+  shad::rt::waitForCompletion(second);
+}
+#endif
+
 TEST_F(ExecuteAtTest, NotExistingLocality) {
   shad::rt::Locality badLocality(shad::rt::numLocalities());
 
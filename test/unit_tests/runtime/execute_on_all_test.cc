@@ -28,20 +28,29 @@
 
 #include "shad/runtime/runtime.h"
 
+static const uint32_t kMaxLocalities = 64;
+
 class ExecuteOnAllTest : public ::testing::Test {
  public:
-  static std::atomic<int> Counter;
+  // One slot per locality, also when the localities share the statics.
+  static std::atomic<int> Counters[kMaxLocalities];
+
+  static std::atomic<int> &Counter() {
+    return Counters[static_cast<uint32_t>(shad::rt::thisLocality())];
+  }
 
   void SetUp() {
+    if (shad::rt::numLocalities() > kMaxLocalities)
+      GTEST_SKIP() << "too many localities";
     for (auto &loc : shad::rt::allLocalities()) {
-      shad::rt::executeAt(loc, [](const bool &) { Counter = 0; }, false);
+      shad::rt::executeAt(loc, [](const bool &) { Counter() = 0; }, false);
     }
   }
 
   void TearDown() {}
 };
 
-std::atomic<int> ExecuteOnAllTest::Counter(0);
+std::atomic<int> ExecuteOnAllTest::Counters[kMaxLocalities];
 
 struct TestStruct {
   int valueA;
@@ -50,38 +59,38 @@ struct TestStruct {
 
 TEST_F(ExecuteOnAllTest, ExecuteOnAllWithStruct) {
   for (auto &loc : shad::rt::allLocalities()) {
-    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter, 0); },
+    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter(), 0); },
                         false);
   }
 
-  shad::rt::executeOnAll([](const bool &) { Counter++; }, false);
+  shad::rt::executeOnAll([](const bool &) { Counter()++; }, false);
 
   for (auto &loc : shad::rt::allLocalities()) {
-    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter, 1); },
+    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter(), 1); },
                         false);
   }
 
   shad::rt::executeOnAll(
-      [](const TestStruct &S) { Counter = S.valueA + S.valueB; },
+      [](const TestStruct &S) { Counter() = S.valueA + S.valueB; },
       TestStruct{5, 5});
 
   for (auto &loc : shad::rt::allLocalities()) {
-    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter, 10); },
+    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter(), 10); },
                         false);
   }
 }
 
 TEST_F(ExecuteOnAllTest, ExecuteOnAllWithBuffer) {
   for (auto &loc : shad::rt::allLocalities()) {
-    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter, 0); },
+    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter(), 0); },
                         false);
   }
 
-  shad::rt::executeOnAll([](const uint8_t *, const uint32_t) { Counter++; },
+  shad::rt::executeOnAll([](const uint8_t *, const uint32_t) { Counter()++; },
                          nullptr, 0);
 
   for (auto &loc : shad::rt::allLocalities()) {
-    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter, 1); },
+    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter(), 1); },
                         false);
   }
 
@@ -90,32 +99,32 @@ TEST_F(ExecuteOnAllTest, ExecuteOnAllWithBuffer) {
   shad::rt::executeOnAll(
       [](const uint8_t *B, const uint32_t S) {
         ASSERT_EQ(S, sizeof(uint8_t) << 1);
-        Counter = B[0] + B[1];
+        Counter() = B[0] + B[1];
       },
       buffer, sizeof(uint8_t) << 1);
 
   for (auto &loc : shad::rt::allLocalities()) {
-    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter, 10); },
+    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter(), 10); },
                         false);
   }
 }
 
 TEST_F(ExecuteOnAllTest, AsyncExecuteOnAllWithStruct) {
   for (auto &loc : shad::rt::allLocalities()) {
-    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter, 0); },
+    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter(), 0); },
                         false);
   }
 
   {
     shad::rt::Handle handle;
     shad::rt::asyncExecuteOnAll(
-        handle, [](shad::rt::Handle &, const bool &) { Counter++; }, false);
+        handle, [](shad::rt::Handle &, const bool &) { Counter()++; }, false);
 
     shad::rt::waitForCompletion(handle);
   }
 
   for (auto &loc : shad::rt::allLocalities()) {
-    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter, 1); },
+    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter(), 1); },
                         false);
   }
 
@@ -123,7 +132,7 @@ TEST_F(ExecuteOnAllTest, AsyncExecuteOnAllWithStruct) {
     shad::rt::Handle handle;
     shad::rt::asyncExecuteOnAll(handle,
                                 [](shad::rt::Handle &, const TestStruct &S) {
-                                  Counter = S.valueA + S.valueB;
+                                  Counter() = S.valueA + S.valueB;
                                 },
                                 TestStruct{5, 5});
 
@@ -131,14 +140,14 @@ TEST_F(ExecuteOnAllTest, AsyncExecuteOnAllWithStruct) {
   }
 
   for (auto &loc : shad::rt::allLocalities()) {
-    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter, 10); },
+    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter(), 10); },
                         false);
   }
 }
 
 TEST_F(ExecuteOnAllTest, AsyncExecuteOnAllWithBuffer) {
   for (auto &loc : shad::rt::allLocalities()) {
-    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter, 0); },
+    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter(), 0); },
                         false);
   }
 
@@ -146,14 +155,16 @@ TEST_F(ExecuteOnAllTest, AsyncExecuteOnAllWithBuffer) {
     shad::rt::Handle handle;
     shad::rt::asyncExecuteOnAll(
         handle,
-        [](shad::rt::Handle &, const uint8_t *, const uint32_t) { Counter++; },
+        [](shad::rt::Handle &, const uint8_t *, const uint32_t) {
+          Counter()++;
+        },
         nullptr, 0);
 
     shad::rt::waitForCompletion(handle);
   }
 
   for (auto &loc : shad::rt::allLocalities()) {
-    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter, 1); },
+    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter(), 1); },
                         false);
   }
 
@@ -167,7 +178,7 @@ TEST_F(ExecuteOnAllTest, AsyncExecuteOnAllWithBuffer) {
         handle,
         [](shad::rt::Handle &, const uint8_t *B, const uint32_t S) {
           ASSERT_EQ(S, sizeof(uint8_t) << 1);
-          Counter = B[0] + B[1];
+          Counter() = B[0] + B[1];
         },
         buffer, 2);
 
@@ -175,7 +186,7 @@ TEST_F(ExecuteOnAllTest, AsyncExecuteOnAllWithBuffer) {
   }
 
   for (auto &loc : shad::rt::allLocalities()) {
-    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter, 10); },
+    shad::rt::executeAt(loc, [](const bool &) { ASSERT_EQ(Counter(), 10); },
                         false);
   }
 }
@@ -28,20 +28,29 @@
 
 #include "shad/runtime/runtime.h"
 
+static const uint32_t kMaxLocalities = 64;
+
 class ForEachTest : public ::testing::Test {
  public:
-  static std::atomic<int> Counter;
+  // One slot per locality, also when the localities share the statics.
+  static std::atomic<int> Counters[kMaxLocalities];
+
+  static std::atomic<int> &Counter() {
+    return Counters[static_cast<uint32_t>(shad::rt::thisLocality())];
+  }
 
   void SetUp() {
+    if (shad::rt::numLocalities() > kMaxLocalities)
+      GTEST_SKIP() << "too many localities";
     for (auto &loc : shad::rt::allLocalities()) {
-      shad::rt::executeAt(loc, [](const bool &) { Counter = 0; }, false);
+      shad::rt::executeAt(loc, [](const bool &) { Counter() = 0; }, false);
     }
   }
 
   void TearDown() {}
 };
 
-std::atomic<int> ForEachTest::Counter(0);
+std::atomic<int> ForEachTest::Counters[kMaxLocalities];
 
 struct TestStruct {
   int valueA;
@@ -49,7 +58,7 @@ struct TestStruct {
 };
 
 TEST_F(ForEachTest, ForEachOnAllWithStruct) {
-  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter, 0); }, false);
+  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter(), 0); }, false);
 
   shad::rt::forEachOnAll(
       [](const TestStruct &args, size_t i) {
@@ -58,14 +67,14 @@ TEST_F(ForEachTest, ForEachOnAllWithStruct) {
                   shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
         ASSERT_EQ(args.valueA, 5);
         ASSERT_EQ(args.valueB, 5);
-        Counter++;
+        Counter()++;
       },
       TestStruct{5, 5},
       shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
 
   shad::rt::executeOnAll(
       [](const bool &) {
-        ASSERT_EQ(Counter, shad::rt::impl::getConcurrency());
+        ASSERT_EQ(Counter(), shad::rt::impl::getConcurrency());
       },
       false);
 
@@ -76,20 +85,20 @@ TEST_F(ForEachTest, ForEachOnAllWithStruct) {
                   shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
         ASSERT_EQ(args.valueA, 5);
         ASSERT_EQ(args.valueB, 5);
-        Counter += args.valueA + args.valueB;
+        Counter() += args.valueA + args.valueB;
       },
       TestStruct{5, 5},
       shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
 
   shad::rt::executeOnAll(
       [](const bool &) {
-        ASSERT_EQ(Counter, 11 * shad::rt::impl::getConcurrency());
+        ASSERT_EQ(Counter(), 11 * shad::rt::impl::getConcurrency());
       },
       false);
 }
 
 TEST_F(ForEachTest, ForEachOnAllWithBuffer) {
-  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter, 0); }, false);
+  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter(), 0); }, false);
 
   std::shared_ptr<uint8_t> buffer(new uint8_t[2]{5, 5},
                                   std::default_delete<uint8_t[]>());
@@ -102,13 +111,13 @@ TEST_F(ForEachTest, ForEachOnAllWithBuffer) {
                   shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
         ASSERT_EQ(input[0], 5);
         ASSERT_EQ(input[1], 5);
-        Counter++;
+        Counter()++;
       },
       buffer, 2, shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
 
   shad::rt::executeOnAll(
       [](const bool &) {
-        ASSERT_EQ(Counter, shad::rt::impl::getConcurrency());
+        ASSERT_EQ(Counter(), shad::rt::impl::getConcurrency());
       },
       false);
 
@@ -120,19 +129,19 @@ TEST_F(ForEachTest, ForEachOnAllWithBuffer) {
                   shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
         ASSERT_EQ(input[0], 5);
         ASSERT_EQ(input[1], 5);
-        Counter += input[0] + input[1];
+        Counter() += input[0] + input[1];
       },
       buffer, 2, shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
 
   shad::rt::executeOnAll(
       [](const bool &) {
-        ASSERT_EQ(Counter, 11 * shad::rt::impl::getConcurrency());
+        ASSERT_EQ(Counter(), 11 * shad::rt::impl::getConcurrency());
       },
       false);
 }
 
 TEST_F(ForEachTest, ForEachAtWithStruct) {
-  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter, 0); }, false);
+  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter(), 0); }, false);
 
   for (auto &locality : shad::rt::allLocalities()) {
     shad::rt::forEachAt(locality,
@@ -142,14 +151,14 @@ TEST_F(ForEachTest, ForEachAtWithStruct) {
                                            shad::rt::impl::getConcurrency());
                           ASSERT_EQ(args.valueA, 5);
                           ASSERT_EQ(args.valueB, 5);
-                          Counter++;
+                          Counter()++;
                         },
                         TestStruct{5, 5}, shad::rt::impl::getConcurrency());
   }
 
   shad::rt::executeOnAll(
       [](const bool &) {
-        ASSERT_EQ(Counter, shad::rt::impl::getConcurrency());
+        ASSERT_EQ(Counter(), shad::rt::impl::getConcurrency());
       },
       false);
 
@@ -161,19 +170,19 @@ TEST_F(ForEachTest, ForEachAtWithStruct) {
                                            shad::rt::impl::getConcurrency());
                           ASSERT_EQ(args.valueA, 5);
                           ASSERT_EQ(args.valueB, 5);
-                          Counter += args.valueA + args.valueB;
+                          Counter() += args.valueA + args.valueB;
                         },
                         TestStruct{5, 5}, shad::rt::impl::getConcurrency());
   }
   shad::rt::executeOnAll(
       [](const bool &) {
-        ASSERT_EQ(Counter, 11 * shad::rt::impl::getConcurrency());
+        ASSERT_EQ(Counter(), 11 * shad::rt::impl::getConcurrency());
       },
       false);
 }
 
 TEST_F(ForEachTest, ForEachAtWithBuffer) {
-  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter, 0); }, false);
+  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter(), 0); }, false);
 
   std::shared_ptr<uint8_t> buffer(new uint8_t[2]{5, 5},
                                   std::default_delete<uint8_t[]>());
@@ -188,14 +197,14 @@ TEST_F(ForEachTest, ForEachAtWithBuffer) {
           ASSERT_EQ(input[0], 5);
           ASSERT_EQ(input[1], 5);
 
-          Counter++;
+          Counter()++;
         },
         buffer, 2, shad::rt::impl::getConcurrency());
   }
 
   shad::rt::executeOnAll(
       [](const bool &) {
-        ASSERT_EQ(Counter, shad::rt::impl::getConcurrency());
+        ASSERT_EQ(Counter(), shad::rt::impl::getConcurrency());
       },
       false);
 
@@ -209,20 +218,20 @@ TEST_F(ForEachTest, ForEachAtWithBuffer) {
           ASSERT_EQ(input[0], 5);
           ASSERT_EQ(input[1], 5);
 
-          Counter += input[0] + input[1];
+          Counter() += input[0] + input[1];
         },
         buffer, 2, shad::rt::impl::getConcurrency());
   }
 
   shad::rt::executeOnAll(
       [](const bool &) {
-        ASSERT_EQ(Counter, 11 * shad::rt::impl::getConcurrency());
+        ASSERT_EQ(Counter(), 11 * shad::rt::impl::getConcurrency());
       },
       false);
 }
 
 TEST_F(ForEachTest, AsyncForEachOnAllWithStruct) {
-  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter, 0); }, false);
+  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter(), 0); }, false);
 
   {
     shad::rt::Handle handle;
@@ -235,7 +244,7 @@ TEST_F(ForEachTest, AsyncForEachOnAllWithStruct) {
               i, shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
           ASSERT_EQ(args.valueA, 5);
           ASSERT_EQ(args.valueB, 5);
-          Counter++;
+          Counter()++;
         },
         TestStruct{5, 5},
         shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
@@ -245,7 +254,7 @@ TEST_F(ForEachTest, AsyncForEachOnAllWithStruct) {
 
   shad::rt::executeOnAll(
       [](const bool &) {
-        ASSERT_EQ(Counter, shad::rt::impl::getConcurrency());
+        ASSERT_EQ(Counter(), shad::rt::impl::getConcurrency());
       },
       false);
 
@@ -260,7 +269,7 @@ TEST_F(ForEachTest, AsyncForEachOnAllWithStruct) {
               i, shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
           ASSERT_EQ(args.valueA, 5);
           ASSERT_EQ(args.valueB, 5);
-          Counter += args.valueA + args.valueB;
+          Counter() += args.valueA + args.valueB;
         },
         TestStruct{5, 5},
         shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
@@ -270,13 +279,13 @@ TEST_F(ForEachTest, AsyncForEachOnAllWithStruct) {
 
   shad::rt::executeOnAll(
       [](const bool &) {
-        ASSERT_EQ(Counter, 11 * shad::rt::impl::getConcurrency());
+        ASSERT_EQ(Counter(), 11 * shad::rt::impl::getConcurrency());
       },
       false);
 }
 
 TEST_F(ForEachTest, AsyncForEachOnAllWithBuffer) {
-  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter, 0); }, false);
+  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter(), 0); }, false);
 
   std::shared_ptr<uint8_t> buffer(new uint8_t[2]{5, 5},
                                   std::default_delete<uint8_t[]>());
@@ -293,7 +302,7 @@ TEST_F(ForEachTest, AsyncForEachOnAllWithBuffer) {
               i, shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
           ASSERT_EQ(input[0], 5);
           ASSERT_EQ(input[1], 5);
-          Counter++;
+          Counter()++;
         },
         buffer, 2,
         shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
@@ -303,7 +312,7 @@ TEST_F(ForEachTest, AsyncForEachOnAllWithBuffer) {
 
   shad::rt::executeOnAll(
       [](const bool &) {
-        ASSERT_EQ(Counter, shad::rt::impl::getConcurrency());
+        ASSERT_EQ(Counter(), shad::rt::impl::getConcurrency());
       },
       false);
 
@@ -320,7 +329,7 @@ TEST_F(ForEachTest, AsyncForEachOnAllWithBuffer) {
               i, shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
           ASSERT_EQ(input[0], 5);
           ASSERT_EQ(input[1], 5);
-          Counter += input[0] + input[1];
+          Counter() += input[0] + input[1];
         },
         buffer, 2,
         shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
@@ -330,13 +339,13 @@ TEST_F(ForEachTest, AsyncForEachOnAllWithBuffer) {
 
   shad::rt::executeOnAll(
       [](const bool &) {
-        ASSERT_EQ(Counter, 11 * shad::rt::impl::getConcurrency());
+        ASSERT_EQ(Counter(), 11 * shad::rt::impl::getConcurrency());
       },
       false);
 }
 
 TEST_F(ForEachTest, AsyncForEachAtWithStruct) {
-  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter, 0); }, false);
+  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter(), 0); }, false);
 
   {
     shad::rt::Handle handle;
@@ -350,7 +359,7 @@ TEST_F(ForEachTest, AsyncForEachAtWithStruct) {
                              shad::rt::impl::getConcurrency());
             ASSERT_EQ(args.valueA, 5);
             ASSERT_EQ(args.valueB, 5);
-            Counter++;
+            Counter()++;
           },
           TestStruct{5, 5}, shad::rt::impl::getConcurrency());
     }
@@ -360,7 +369,7 @@ TEST_F(ForEachTest, AsyncForEachAtWithStruct) {
 
   shad::rt::executeOnAll(
       [](const bool &) {
-        ASSERT_EQ(Counter, shad::rt::impl::getConcurrency());
+        ASSERT_EQ(Counter(), shad::rt::impl::getConcurrency());
       },
       false);
 
@@ -377,7 +386,7 @@ TEST_F(ForEachTest, AsyncForEachAtWithStruct) {
                              shad::rt::impl::getConcurrency());
             ASSERT_EQ(args.valueA, 5);
             ASSERT_EQ(args.valueB, 5);
-            Counter += args.valueA + args.valueB;
+            Counter() += args.valueA + args.valueB;
           },
           TestStruct{5, 5}, shad::rt::impl::getConcurrency());
     }
@@ -387,13 +396,13 @@ TEST_F(ForEachTest, AsyncForEachAtWithStruct) {
 
   shad::rt::executeOnAll(
       [](const bool &) {
-        ASSERT_EQ(Counter, 11 * shad::rt::impl::getConcurrency());
+        ASSERT_EQ(Counter(), 11 * shad::rt::impl::getConcurrency());
       },
       false);
 }
 
 TEST_F(ForEachTest, AsyncForEachAtWithBuffer) {
-  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter, 0); }, false);
+  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter(), 0); }, false);
 
   std::shared_ptr<uint8_t> buffer(new uint8_t[2]{5, 5},
                                   std::default_delete<uint8_t[]>());
@@ -413,7 +422,7 @@ TEST_F(ForEachTest, AsyncForEachAtWithBuffer) {
             ASSERT_EQ(input[0], 5);
             ASSERT_EQ(input[1], 5);
 
-            Counter++;
+            Counter()++;
           },
           buffer, 2, shad::rt::impl::getConcurrency());
     }
@@ -423,7 +432,7 @@ TEST_F(ForEachTest, AsyncForEachAtWithBuffer) {
 
   shad::rt::executeOnAll(
       [](const bool &) {
-        ASSERT_EQ(Counter, shad::rt::impl::getConcurrency())
+        ASSERT_EQ(Counter(), shad::rt::impl::getConcurrency())
             << shad::rt::thisLocality();
       },
       false);
@@ -442,7 +451,7 @@ TEST_F(ForEachTest, AsyncForEachAtWithBuffer) {
             ASSERT_EQ(input[0], 5);
             ASSERT_EQ(input[1], 5);
 
-            Counter += input[0] + input[1];
+            Counter() += input[0] + input[1];
           },
           buffer, 2, shad::rt::impl::getConcurrency());
     }
@@ -452,7 +461,7 @@ TEST_F(ForEachTest, AsyncForEachAtWithBuffer) {
 
   shad::rt::executeOnAll(
       [](const bool &) {
-        ASSERT_EQ(Counter, 11 * shad::rt::impl::getConcurrency());
+        ASSERT_EQ(Counter(), 11 * shad::rt::impl::getConcurrency());
       },
       false);
 }
@@ -461,7 +470,7 @@ TEST_F(ForEachTest, SyncZeroIterations) {
   std::shared_ptr<uint8_t> data(new uint8_t[2]{5, 5},
                                 std::default_delete<uint8_t[]>());
 
-  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter, 0); }, false);
+  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter(), 0); }, false);
 
   for (auto &locality : shad::rt::allLocalities()) {
     shad::rt::forEachAt(locality,
@@ -471,7 +480,7 @@ TEST_F(ForEachTest, SyncZeroIterations) {
                                            shad::rt::impl::getConcurrency());
                           ASSERT_EQ(args.valueA, 5);
                           ASSERT_EQ(args.valueB, 5);
-                          Counter++;
+                          Counter()++;
                         },
                         TestStruct{5, 5}, 0);
   }
@@ -486,7 +495,7 @@ TEST_F(ForEachTest, SyncZeroIterations) {
           ASSERT_EQ(input[0], 5);
           ASSERT_EQ(input[1], 5);
 
-          Counter++;
+          Counter()++;
         },
         data, 2, 0);
   }
@@ -499,7 +508,7 @@ TEST_F(ForEachTest, SyncZeroIterations) {
                   shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
         ASSERT_EQ(input[0], 5);
         ASSERT_EQ(input[1], 5);
-        Counter += input[0] + input[1];
+        Counter() += input[0] + input[1];
       },
       data, 2, 0);
 
@@ -510,18 +519,18 @@ TEST_F(ForEachTest, SyncZeroIterations) {
                   shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
         ASSERT_EQ(args.valueA, 5);
         ASSERT_EQ(args.valueB, 5);
-        Counter += args.valueA + args.valueB;
+        Counter() += args.valueA + args.valueB;
       },
       TestStruct{5, 5}, 0);
 
-  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter, 0); }, false);
+  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter(), 0); }, false);
 }
 
 TEST_F(ForEachTest, AsyncZeroIterations) {
   std::shared_ptr<uint8_t> buffer(new uint8_t[2]{5, 5},
                                   std::default_delete<uint8_t[]>());
 
-  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter, 0); }, false);
+  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter(), 0); }, false);
 
   shad::rt::Handle handle;
 
@@ -534,7 +543,7 @@ TEST_F(ForEachTest, AsyncZeroIterations) {
               i, shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
           ASSERT_EQ(args.valueA, 5);
           ASSERT_EQ(args.valueB, 5);
-          Counter += args.valueA + args.valueB;
+          Counter() += args.valueA + args.valueB;
         },
         TestStruct{5, 5}, 0);
   }
@@ -549,7 +558,7 @@ TEST_F(ForEachTest, AsyncZeroIterations) {
                                ASSERT_EQ(input[0], 5);
                                ASSERT_EQ(input[1], 5);
 
-                               Counter += input[0] + input[1];
+                               Counter() += input[0] + input[1];
                              },
                              buffer, 2, 0);
   }
@@ -564,7 +573,7 @@ TEST_F(ForEachTest, AsyncZeroIterations) {
                   shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
         ASSERT_EQ(input[0], 5);
         ASSERT_EQ(input[1], 5);
-        Counter += input[0] + input[1];
+        Counter() += input[0] + input[1];
       },
       buffer, 2, 0);
 
@@ -576,13 +585,13 @@ TEST_F(ForEachTest, AsyncZeroIterations) {
                   shad::rt::numLocalities() * shad::rt::impl::getConcurrency());
         ASSERT_EQ(args.valueA, 5);
         ASSERT_EQ(args.valueB, 5);
-        Counter++;
+        Counter()++;
       },
       TestStruct{5, 5}, 0);
 
   shad::rt::waitForCompletion(handle);
 
-  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter, 0); }, false);
+  shad::rt::executeOnAll([](const bool &) { ASSERT_EQ(Counter(), 0); }, false);
 }
 
 TEST_F(ForEachTest, NotExistingLocality) {
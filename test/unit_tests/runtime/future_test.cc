@@ -0,0 +1,200 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <cstdint>
+
+#include "gtest/gtest.h"
+
+#include "shad/runtime/future.h"
+#include "shad/runtime/runtime.h"
+
+struct LookupArgs {
+  uint64_t key;
+};
+
+static const uint64_t kChainLength = 16;
+static std::atomic<uint64_t> completed(0);
+static std::atomic<uint64_t> updated(0);
+
+static void lookup(shad::rt::Handle & /*unused*/, const LookupArgs &args,
+                   uint64_t *result) {
+  *result = args.key * 2 + static_cast<uint32_t>(shad::rt::thisLocality());
+}
+
+static void update(shad::rt::Handle & /*unused*/, const uint64_t &value) {
+  updated.fetch_add(value);
+}
+
+static void drainUpdated(const bool &, uint64_t *result) {
+  *result = updated.exchange(0);
+}
+
+// Sum of the updates on all the localities.
+static uint64_t totalUpdated() {
+  uint64_t total = 0;
+  for (auto &locality : shad::rt::allLocalities()) {
+    uint64_t value = 0;
+    shad::rt::executeAtWithRet(locality, drainUpdated, false, &value);
+    total += value;
+  }
+  return total;
+}
+
+static shad::rt::Locality nextLocality(uint64_t key) {
+  return shad::rt::Locality(key % shad::rt::numLocalities());
+}
+
+// Each step looks up the key on its owner and uses the value as the next key.
+static void chain(shad::rt::Handle &handle, uint64_t key, uint64_t steps) {
+  if (steps == 0) {
+    completed.fetch_add(1);
+    return;
+  }
+  auto future = shad::rt::asyncExecuteAtWithRet(handle, nextLocality(key),
+                                                lookup, LookupArgs{key});
+  future.then([steps](shad::rt::Handle &handle, const uint64_t &value) {
+    chain(handle, value % 1024, steps - 1);
+  });
+}
+
+class FutureTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    completed = 0;
+    updated = 0;
+  }
+};
+
+TEST_F(FutureTest, GetAfterWait) {
+  shad::rt::Handle handle;
+  std::vector<shad::rt::Future<uint64_t>> futures;
+  for (auto &locality : shad::rt::allLocalities())
+    futures.emplace_back(shad::rt::asyncExecuteAtWithRet(
+        handle, locality, lookup,
+        LookupArgs{static_cast<uint32_t>(locality)}));
+  shad::rt::waitForCompletion(handle);
+
+  for (uint32_t L = 0; L < futures.size(); ++L) {
+    ASSERT_TRUE(futures[L].ready());
+    ASSERT_EQ(futures[L].get(), L * 3);
+  }
+}
+
+TEST_F(FutureTest, GetBeforeReadyThrows) {
+  shad::rt::Future<uint64_t> future(
+      std::make_shared<shad::rt::impl::FutureState<uint64_t>>(
+          shad::rt::Handle()));
+  ASSERT_FALSE(future.ready());
+  ASSERT_THROW(future.get(), std::system_error);
+}
+
+TEST_F(FutureTest, Then) {
+  shad::rt::Handle handle;
+  for (auto &locality : shad::rt::allLocalities()) {
+    auto future = shad::rt::asyncExecuteAtWithRet(
+        handle, locality, lookup, LookupArgs{static_cast<uint32_t>(locality)});
+    future.then([](shad::rt::Handle &handle, const uint64_t &value) {
+      shad::rt::asyncExecuteAt(handle, nextLocality(value), update, value);
+    });
+  }
+  shad::rt::waitForCompletion(handle);
+
+  uint64_t expected = 0;
+  for (uint32_t L = 0; L < shad::rt::numLocalities(); ++L) expected += L * 3;
+  ASSERT_EQ(totalUpdated(), expected);
+}
+
+TEST_F(FutureTest, ThenOnReadyFuture) {
+  shad::rt::Handle handle;
+  auto future = shad::rt::asyncExecuteAtWithRet(
+      handle, shad::rt::thisLocality(), lookup, LookupArgs{21});
+  // Continuations registered on a ready Future run immediately.
+  future.then([future](shad::rt::Handle &, const uint64_t &) mutable {
+    future.then([](shad::rt::Handle &, const uint64_t &value) {
+      updated.fetch_add(value);
+    });
+    ASSERT_EQ(updated.load(), future.get());
+  });
+  shad::rt::waitForCompletion(handle);
+
+  ASSERT_EQ(updated.load(),
+            42 + static_cast<uint32_t>(shad::rt::thisLocality()));
+}
+
+TEST_F(FutureTest, DependentChains) {
+  static const uint64_t kNumChains = 64;
+  shad::rt::Handle handle;
+  for (uint64_t i = 0; i < kNumChains; ++i) chain(handle, i, kChainLength);
+  shad::rt::waitForCompletion(handle);
+
+  ASSERT_EQ(completed.load(), kNumChains);
+}
+
+#if defined(__cpp_impl_coroutine)
+static shad::rt::Coroutine lookupAndUpdate(shad::rt::Handle handle,
+                                           uint64_t key) {
+  uint64_t value = co_await shad::rt::asyncExecuteAtWithRet(
+      handle, nextLocality(key), lookup, LookupArgs{key});
+  value = co_await shad::rt::asyncExecuteAtWithRet(
+      handle, nextLocality(value), lookup, LookupArgs{value % 1024});
+  shad::rt::asyncExecuteAt(handle, nextLocality(value), update, value);
+}
+
+TEST_F(FutureTest, Coroutines) {
+  static const uint64_t kNumCoroutines = 32;
+  shad::rt::Handle handle = shad::rt::impl::createHandle();
+  for (uint64_t i = 0; i < kNumCoroutines; ++i) lookupAndUpdate(handle, i);
+  shad::rt::waitForCompletion(handle);
+
+  uint64_t expected = 0;
+  for (uint64_t i = 0; i < kNumCoroutines; ++i) {
+    uint64_t value = i * 2 + i % shad::rt::numLocalities();
+    expected += (value % 1024) * 2 + value % shad::rt::numLocalities();
+  }
+  ASSERT_EQ(totalUpdated(), expected);
+}
+
+static shad::rt::Coroutine updateAllAndCount(shad::rt::Handle group,
+                                             uint64_t value) {
+  shad::rt::Handle updates;
+  for (auto &locality : shad::rt::allLocalities())
+    shad::rt::asyncExecuteAt(updates, locality, update, value);
+  co_await shad::rt::completionOf(group, updates);
+  completed.fetch_add(1);
+}
+
+TEST_F(FutureTest, CoroutinesAwaitingHandles) {
+  static const uint64_t kNumCoroutines = 32;
+  shad::rt::Handle handle = shad::rt::impl::createHandle();
+  for (uint64_t i = 0; i < kNumCoroutines; ++i) updateAllAndCount(handle, i);
+  shad::rt::waitForCompletion(handle);
+
+  ASSERT_EQ(completed.load(), kNumCoroutines);
+  ASSERT_EQ(totalUpdated(), kNumCoroutines * (kNumCoroutines - 1) / 2 *
+                                shad::rt::numLocalities());
+}
+#elif defined(SHAD_TEST_COROUTINES)
+#error "future_cxx20_test must be compiled with coroutine support"
+#endif
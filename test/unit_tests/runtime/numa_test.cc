@@ -0,0 +1,90 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "shad/runtime/runtime.h"
+
+static std::atomic<uint64_t> outOfRange(0);
+
+static void checkDomain(const bool &, size_t) {
+  if (shad::rt::thisDomain() >= shad::rt::numDomains())
+    outOfRange.fetch_add(1);
+}
+
+static void drainOutOfRange(const bool &, uint64_t *result) {
+  *result = outOfRange.exchange(0);
+}
+
+TEST(NumaTest, WorkersRunOnTheirDomains) {
+  ASSERT_GE(shad::rt::numDomains(), 1);
+  ASSERT_LT(shad::rt::thisDomain(), shad::rt::numDomains());
+
+  shad::rt::forEachOnAll(checkDomain, false, 1024);
+  uint64_t total = 0;
+  for (auto &locality : shad::rt::allLocalities()) {
+    uint64_t value = 0;
+    shad::rt::executeAtWithRet(locality, drainOutOfRange, false, &value);
+    total += value;
+  }
+  ASSERT_EQ(total, 0);
+}
+
+TEST(NumaTest, HomeDomains) {
+  uint32_t numDomains = shad::rt::numDomains();
+  for (size_t n : {1, 2, 7, 64}) {
+    ASSERT_EQ(shad::rt::homeDomain(0, n), 0);
+    for (size_t i = 1; i < n; ++i) {
+      ASSERT_GE(shad::rt::homeDomain(i, n), shad::rt::homeDomain(i - 1, n));
+      ASSERT_LT(shad::rt::homeDomain(i, n), numDomains);
+    }
+    if (n >= numDomains)
+      ASSERT_EQ(shad::rt::homeDomain(n - 1, n), numDomains - 1);
+  }
+}
+
+TEST(NumaTest, DomainScope) {
+  uint32_t initial = shad::rt::thisDomain();
+  for (uint32_t d = 0; d < shad::rt::numDomains(); ++d) {
+    shad::rt::impl::DomainScope scope(d);
+    ASSERT_EQ(shad::rt::thisDomain(), d);
+  }
+  if (shad::rt::numDomains() == 1) ASSERT_EQ(shad::rt::thisDomain(), initial);
+}
+
+TEST(NumaTest, PlacementPreservesContent) {
+  std::vector<uint64_t> data(1 << 18);
+  for (size_t i = 0; i < data.size(); ++i) data[i] = i;
+
+  auto &topology = shad::rt::impl::NumaTopology::Instance();
+  topology.Place(data.data(), data.size() * sizeof(uint64_t));
+  topology.PlaceOnDomain(data.data() + 7, 1 << 16, topology.NumDomains() - 1);
+
+  for (size_t i = 0; i < data.size(); ++i) ASSERT_EQ(data[i], i);
+}
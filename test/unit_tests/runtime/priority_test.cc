@@ -0,0 +1,138 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include <atomic>
+#include <cstdint>
+
+#include "gtest/gtest.h"
+
+#include "shad/runtime/runtime.h"
+
+static std::atomic<uint64_t> executed(0);
+static std::atomic<uint64_t> mismatches(0);
+
+static void drainCounters(const bool &, uint64_t *result) {
+  result[0] = executed.exchange(0);
+  result[1] = mismatches.exchange(0);
+}
+
+// Counters summed over all the localities.
+static void totalCounters(uint64_t *total) {
+  total[0] = total[1] = 0;
+  for (auto &locality : shad::rt::allLocalities()) {
+    uint64_t values[2] = {0, 0};
+    shad::rt::executeAtWithRet(locality, drainCounters, false, values);
+    total[0] += values[0];
+    total[1] += values[1];
+  }
+}
+
+static shad::rt::Locality nextLocality() {
+  return shad::rt::Locality(
+      (static_cast<uint32_t>(shad::rt::thisLocality()) + 1) %
+      shad::rt::numLocalities());
+}
+
+static void checkPriority(shad::rt::Handle & /*unused*/,
+                          const shad::rt::Priority &expected) {
+  executed.fetch_add(1);
+  if (shad::rt::currentPriority() != expected) mismatches.fetch_add(1);
+}
+
+static void checkPriorityAt(shad::rt::Handle & /*unused*/,
+                            const shad::rt::Priority &expected, size_t) {
+  executed.fetch_add(1);
+  if (shad::rt::currentPriority() != expected) mismatches.fetch_add(1);
+}
+
+// Checks its own priority and spawns a child on the next locality, which
+// inherits it.
+static void spawnChild(shad::rt::Handle &handle,
+                       const shad::rt::Priority &expected) {
+  checkPriority(handle, expected);
+  shad::rt::asyncExecuteAt(handle, nextLocality(), checkPriority, expected);
+}
+
+class PriorityTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    uint64_t total[2];
+    totalCounters(total);
+  }
+};
+
+TEST_F(PriorityTest, Scope) {
+  ASSERT_EQ(shad::rt::currentPriority(), shad::rt::Priority::kNormal);
+  {
+    shad::rt::PriorityScope outer(shad::rt::Priority::kBulk);
+    ASSERT_EQ(shad::rt::currentPriority(), shad::rt::Priority::kBulk);
+    {
+      shad::rt::PriorityScope inner(shad::rt::Priority::kLatency);
+      ASSERT_EQ(shad::rt::currentPriority(), shad::rt::Priority::kLatency);
+    }
+    ASSERT_EQ(shad::rt::currentPriority(), shad::rt::Priority::kBulk);
+  }
+  ASSERT_EQ(shad::rt::currentPriority(), shad::rt::Priority::kNormal);
+}
+
+#if !defined(HAVE_GMT)
+TEST_F(PriorityTest, TasksInheritThePriority) {
+  static const uint64_t kNumTasks = 64;
+  static const uint64_t kNumIters = 256;
+
+  for (auto priority :
+       {shad::rt::Priority::kLatency, shad::rt::Priority::kNormal,
+        shad::rt::Priority::kBulk}) {
+    shad::rt::Handle handle;
+    {
+      shad::rt::PriorityScope scope(priority);
+      for (uint64_t i = 0; i < kNumTasks; ++i) {
+        shad::rt::Locality locality(i % shad::rt::numLocalities());
+        shad::rt::asyncExecuteAt(handle, locality, spawnChild, priority);
+      }
+      shad::rt::asyncForEachOnAll(handle, checkPriorityAt, priority,
+                                  kNumIters);
+    }
+    shad::rt::waitForCompletion(handle);
+
+    uint64_t total[2];
+    totalCounters(total);
+    ASSERT_EQ(total[0], 2 * kNumTasks + kNumIters);
+    ASSERT_EQ(total[1], 0);
+  }
+}
+#endif
+
+TEST_F(PriorityTest, QueuesAreDrained) {
+  shad::rt::Handle handle;
+  {
+    shad::rt::PriorityScope scope(shad::rt::Priority::kBulk);
+    shad::rt::asyncForEachOnAll(handle, checkPriorityAt,
+                                shad::rt::Priority::kBulk, 1024);
+  }
+  shad::rt::waitForCompletion(handle);
+
+  ASSERT_EQ(shad::rt::queueDepth(shad::rt::Priority::kBulk), 0);
+}
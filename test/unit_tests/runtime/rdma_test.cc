@@ -22,6 +22,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cstring>
 #include <sstream>
 #include <string>
@@ -187,7 +188,132 @@ TEST_F(RDMATest, async_put_async_get) {
   }
 }
 
-  
+
+static const size_t kVectoredSize = 4096;
+static const size_t kStride = 3;
+std::vector<uint64_t> vectoredData(kVectoredSize, 0);
+
+static uint64_t *vectoredAddress(const shad::rt::Locality &loc) {
+  uint64_t *raddress;
+  shad::rt::executeAtWithRet(
+      loc,
+      [](const size_t &, uint64_t **addr) {
+        std::fill(vectoredData.begin(), vectoredData.end(), 0);
+        *addr = vectoredData.data();
+      },
+      size_t(0), &raddress);
+  return raddress;
+}
+
+// Every fourth run of 7 elements, starting at offset 5.
+static std::vector<shad::rt::DmaSegment<uint64_t>> vectoredSegments(
+    uint64_t *raddress) {
+  std::vector<shad::rt::DmaSegment<uint64_t>> segments;
+  for (size_t offset = 5; offset + 7 <= kVectoredSize; offset += 28)
+    segments.push_back({raddress + offset, 7});
+  return segments;
+}
+
+TEST_F(RDMATest, synch_scatter_gather) {
+  for (auto loc : shad::rt::allLocalities()) {
+    uint64_t *raddress = vectoredAddress(loc);
+    auto segments = vectoredSegments(raddress);
+    size_t numElements = segments.size() * 7;
+    std::vector<uint64_t> localData(numElements);
+    for (size_t i = 0; i < numElements; ++i)
+      localData[i] = i + static_cast<uint32_t>(loc);
+
+    shad::rt::dmaScatter(loc, segments.data(), segments.size(),
+                         localData.data());
+
+    std::vector<uint64_t> remote(kVectoredSize);
+    shad::rt::dma(remote.data(), loc, raddress, kVectoredSize);
+    size_t next = 0;
+    for (size_t i = 0; i < kVectoredSize; ++i) {
+      if (i >= 5 && (i - 5) % 28 < 7 && next < numElements)
+        ASSERT_EQ(remote[i], localData[next++]);
+      else
+        ASSERT_EQ(remote[i], 0u);
+    }
+    ASSERT_EQ(next, numElements);
+
+    std::vector<uint64_t> gathered(numElements, 0);
+    shad::rt::dmaGather(gathered.data(), loc, segments.data(),
+                        segments.size());
+    ASSERT_EQ(gathered, localData);
+  }
+}
+
+TEST_F(RDMATest, synch_strided) {
+  size_t numElements = kVectoredSize / kStride;
+  for (auto loc : shad::rt::allLocalities()) {
+    uint64_t *raddress = vectoredAddress(loc);
+    std::vector<uint64_t> localData(numElements);
+    for (size_t i = 0; i < numElements; ++i)
+      localData[i] = 2 * i + 1 + static_cast<uint32_t>(loc);
+
+    shad::rt::dmaStrided(loc, raddress, kStride, localData.data(),
+                         numElements);
+
+    std::vector<uint64_t> remote(kVectoredSize);
+    shad::rt::dma(remote.data(), loc, raddress, kVectoredSize);
+    for (size_t i = 0; i < kVectoredSize; ++i) {
+      if (i % kStride == 0 && i / kStride < numElements)
+        ASSERT_EQ(remote[i], localData[i / kStride]);
+      else
+        ASSERT_EQ(remote[i], 0u);
+    }
+
+    std::vector<uint64_t> gathered(numElements, 0);
+    shad::rt::dmaStrided(gathered.data(), loc, raddress, kStride,
+                         numElements);
+    ASSERT_EQ(gathered, localData);
+  }
+}
+
+TEST_F(RDMATest, async_scatter_gather_strided) {
+  size_t numLocalities = shad::rt::numLocalities();
+  std::vector<uint64_t *> raddresses(numLocalities);
+  std::vector<std::vector<shad::rt::DmaSegment<uint64_t>>> segments(
+      numLocalities);
+  std::vector<uint64_t> localData(kVectoredSize);
+  for (size_t i = 0; i < kVectoredSize; ++i) localData[i] = 3 * i + 7;
+
+  shad::rt::Handle handle;
+  for (auto loc : shad::rt::allLocalities()) {
+    uint32_t l = static_cast<uint32_t>(loc);
+    raddresses[l] = vectoredAddress(loc);
+    segments[l] = vectoredSegments(raddresses[l]);
+    shad::rt::asyncDmaScatter(handle, loc, segments[l].data(),
+                              segments[l].size(), localData.data());
+  }
+  shad::rt::waitForCompletion(handle);
+
+  std::vector<std::vector<uint64_t>> gathered(numLocalities);
+  std::vector<std::vector<uint64_t>> strided(numLocalities);
+  for (auto loc : shad::rt::allLocalities()) {
+    uint32_t l = static_cast<uint32_t>(loc);
+    gathered[l].resize(segments[l].size() * 7);
+    strided[l].resize(kVectoredSize / kStride);
+    shad::rt::asyncDmaGather(handle, gathered[l].data(), loc,
+                             segments[l].data(), segments[l].size());
+    shad::rt::asyncDmaStrided(handle, strided[l].data(), loc, raddresses[l],
+                              kStride, strided[l].size());
+  }
+  shad::rt::waitForCompletion(handle);
+
+  for (auto loc : shad::rt::allLocalities()) {
+    uint32_t l = static_cast<uint32_t>(loc);
+    for (size_t i = 0; i < gathered[l].size(); ++i)
+      ASSERT_EQ(gathered[l][i], localData[i]);
+    std::vector<uint64_t> expected(kVectoredSize, 0);
+    for (size_t k = 0; k < segments[l].size(); ++k)
+      for (size_t j = 0; j < 7; ++j)
+        expected[5 + 28 * k + j] = localData[7 * k + j];
+    for (size_t i = 0; i < strided[l].size(); ++i)
+      ASSERT_EQ(strided[l][i], expected[i * kStride]);
+  }
+}
 
 #if 0
 TEST_F(ExecuteAtTest, AsyncExecuteAtExplicit) {
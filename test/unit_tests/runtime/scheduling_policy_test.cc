@@ -0,0 +1,204 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "shad/runtime/runtime.h"
+#include "shad/runtime/scheduling_policy.h"
+
+using shad::rt::SchedulingPolicy;
+
+static const size_t kNumIters = 10007;
+static std::atomic<uint64_t> count(0);
+static std::atomic<uint64_t> sum(0);
+static std::atomic<uint64_t> squares(0);
+
+static void resetCounters(const bool &) {
+  count = 0;
+  sum = 0;
+  squares = 0;
+}
+
+static void drainCounters(const bool &, uint8_t *result, uint32_t *resSize) {
+  uint64_t counters[3] = {count.exchange(0), sum.exchange(0),
+                          squares.exchange(0)};
+  memcpy(result, counters, sizeof(counters));
+  *resSize = sizeof(counters);
+}
+
+static void visit(size_t i) {
+  count.fetch_add(1);
+  sum.fetch_add(i);
+  squares.fetch_add(i * i);
+}
+
+static void indexTask(const size_t &offset, size_t i) { visit(offset + i); }
+
+static void rangeTask(const size_t &offset, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; ++i) visit(offset + i);
+}
+
+static void asyncIndexTask(shad::rt::Handle &, const size_t &offset,
+                           size_t i) {
+  visit(offset + i);
+}
+
+static void asyncRangeTask(shad::rt::Handle &, const size_t &offset,
+                           size_t begin, size_t end) {
+  for (size_t i = begin; i < end; ++i) visit(offset + i);
+}
+
+static std::vector<SchedulingPolicy> AllPolicies() {
+  return {SchedulingPolicy::Static(), SchedulingPolicy::Dynamic(1),
+          SchedulingPolicy::Dynamic(100), SchedulingPolicy::Guided(),
+          SchedulingPolicy::Guided(50), SchedulingPolicy::Auto()};
+}
+
+class SchedulingPolicyTest : public ::testing::Test {
+ protected:
+  void SetUp() { shad::rt::executeOnAll(resetCounters, false); }
+
+  // Every iteration in [offset, offset + numIters) was visited once.
+  void CheckVisits(size_t offset, size_t numIters) {
+    uint64_t total[3] = {0, 0, 0};
+    for (auto &locality : shad::rt::allLocalities()) {
+      uint64_t counters[3];
+      uint32_t size;
+      shad::rt::executeAtWithRetBuff(locality, drainCounters, false,
+                                     reinterpret_cast<uint8_t *>(counters),
+                                     &size);
+      for (size_t i = 0; i < 3; ++i) total[i] += counters[i];
+    }
+    uint64_t expectedSum = 0, expectedSquares = 0;
+    for (size_t i = offset; i < offset + numIters; ++i) {
+      expectedSum += i;
+      expectedSquares += i * i;
+    }
+    ASSERT_EQ(total[0], numIters);
+    ASSERT_EQ(total[1], expectedSum);
+    ASSERT_EQ(total[2], expectedSquares);
+  }
+};
+
+TEST_F(SchedulingPolicyTest, ChunksCoverRange) {
+  for (auto policy : AllPolicies()) {
+    if (policy.Type() == SchedulingPolicy::Kind::kAuto) continue;
+    for (size_t numIters : {0, 1, 7, 1000, 12345}) {
+      for (size_t concurrency : {1, 3, 8}) {
+        shad::rt::impl::LoopSchedule schedule(policy, 5, 5 + numIters,
+                                              concurrency);
+        size_t next = 5, previousSize = numIters;
+        for (size_t c = 0; c < schedule.NumChunks(); ++c) {
+          auto chunk = schedule.Chunk(c);
+          ASSERT_EQ(chunk.first, next);
+          ASSERT_LT(chunk.first, chunk.second);
+          size_t size = chunk.second - chunk.first;
+          if (policy.Type() == SchedulingPolicy::Kind::kGuided) {
+            // Chunk sizes never grow, and only the last one can be smaller
+            // than the grain.
+            ASSERT_LE(size, previousSize + 1);
+            if (c + 1 != schedule.NumChunks()) ASSERT_GE(size, policy.Grain());
+          }
+          if (policy.Type() == SchedulingPolicy::Kind::kDynamic)
+            ASSERT_LE(size, policy.Grain());
+          previousSize = size;
+          next = chunk.second;
+        }
+        ASSERT_EQ(next, 5 + numIters);
+        if (policy.Type() == SchedulingPolicy::Kind::kStatic)
+          ASSERT_LE(schedule.NumChunks(), concurrency);
+      }
+    }
+  }
+}
+
+TEST_F(SchedulingPolicyTest, ForEachAt) {
+  for (auto policy : AllPolicies()) {
+    for (auto &locality : shad::rt::allLocalities()) {
+      shad::rt::forEachAt(locality, indexTask, size_t(3), kNumIters, policy);
+      CheckVisits(3, kNumIters);
+    }
+  }
+}
+
+TEST_F(SchedulingPolicyTest, ForEachOnAll) {
+  for (auto policy : AllPolicies()) {
+    shad::rt::forEachOnAll(indexTask, size_t(0), kNumIters, policy);
+    CheckVisits(0, kNumIters);
+  }
+}
+
+TEST_F(SchedulingPolicyTest, ForEachRange) {
+  for (auto policy : AllPolicies()) {
+    shad::rt::forEachRangeAt(shad::rt::Locality(0), rangeTask, size_t(1),
+                             kNumIters, policy);
+    CheckVisits(1, kNumIters);
+    shad::rt::forEachRangeOnAll(rangeTask, size_t(2), kNumIters, policy);
+    CheckVisits(2, kNumIters);
+  }
+}
+
+TEST_F(SchedulingPolicyTest, AsyncForEach) {
+  for (auto policy : AllPolicies()) {
+    shad::rt::Handle handle;
+    for (auto &locality : shad::rt::allLocalities())
+      shad::rt::asyncForEachAt(handle, locality, asyncIndexTask, size_t(0),
+                               kNumIters, policy);
+    shad::rt::asyncForEachOnAll(handle, asyncIndexTask, size_t(0), kNumIters,
+                                policy);
+    shad::rt::waitForCompletion(handle);
+    uint64_t expected = kNumIters * (shad::rt::numLocalities() + 1);
+    uint64_t total = 0;
+    for (auto &locality : shad::rt::allLocalities()) {
+      uint64_t counters[3];
+      uint32_t size;
+      shad::rt::executeAtWithRetBuff(locality, drainCounters, false,
+                                     reinterpret_cast<uint8_t *>(counters),
+                                     &size);
+      total += counters[0];
+    }
+    ASSERT_EQ(total, expected);
+  }
+}
+
+TEST_F(SchedulingPolicyTest, AsyncForEachRange) {
+  for (auto policy : AllPolicies()) {
+    shad::rt::Handle handle;
+    shad::rt::asyncForEachRangeAt(handle, shad::rt::Locality(0),
+                                  asyncRangeTask, size_t(4), kNumIters,
+                                  policy);
+    shad::rt::waitForCompletion(handle);
+    CheckVisits(4, kNumIters);
+    shad::rt::asyncForEachRangeOnAll(handle, asyncRangeTask, size_t(6),
+                                     kNumIters, policy);
+    shad::rt::waitForCompletion(handle);
+    CheckVisits(6, kNumIters);
+  }
+}
@@ -0,0 +1,194 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "shad/runtime/runtime.h"
+#include "shad/runtime/task_arena.h"
+
+using TaskArena = shad::rt::impl::TaskArena;
+
+struct LargeArgs {
+  uint8_t payload[4000];
+  uint32_t value;
+};
+
+static const size_t kNumTasks = 1000;
+static const size_t kNumBlocks = 100000;
+static std::atomic<uint64_t> received(0);
+static std::atomic<uint64_t> sum(0);
+
+static void resetCounters(const bool &) {
+  received = 0;
+  sum = 0;
+}
+
+static void drainCounters(const bool &, uint8_t *result, uint32_t *resSize) {
+  uint64_t counters[2] = {received.exchange(0), sum.exchange(0)};
+  memcpy(result, counters, sizeof(counters));
+  *resSize = sizeof(counters);
+}
+
+static void largeTask(shad::rt::Handle &, const LargeArgs &args) {
+  received.fetch_add(1);
+  sum.fetch_add(args.value + args.payload[0] + args.payload[3999]);
+}
+
+static void bufferTask(shad::rt::Handle &, const uint8_t *buffer,
+                       const uint32_t size) {
+  received.fetch_add(1);
+  sum.fetch_add(buffer[0] + buffer[size - 1]);
+}
+
+class TaskArenaTest : public ::testing::Test {
+ protected:
+  void SetUp() { shad::rt::executeOnAll(resetCounters, false); }
+
+  void CheckCounters(uint64_t expectedReceived, uint64_t expectedSum) {
+    uint64_t totalReceived = 0, totalSum = 0;
+    for (auto &locality : shad::rt::allLocalities()) {
+      uint64_t counters[2];
+      uint32_t size;
+      shad::rt::executeAtWithRetBuff(locality, drainCounters, false,
+                                     reinterpret_cast<uint8_t *>(counters),
+                                     &size);
+      totalReceived += counters[0];
+      totalSum += counters[1];
+    }
+    ASSERT_EQ(totalReceived, expectedReceived);
+    ASSERT_EQ(totalSum, expectedSum);
+  }
+};
+
+TEST_F(TaskArenaTest, AllocateSizes) {
+  std::vector<std::pair<uint8_t *, size_t>> blocks;
+  for (size_t size = 1; size <= 4 * TaskArena::kMaxBlockBytes; size *= 3) {
+    auto block = static_cast<uint8_t *>(TaskArena::Allocate(size));
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(block) % alignof(std::max_align_t),
+              0);
+    memset(block, static_cast<int>(size), size);
+    blocks.emplace_back(block, size);
+  }
+  for (auto &block : blocks) {
+    ASSERT_EQ(block.first[0], static_cast<uint8_t>(block.second));
+    ASSERT_EQ(block.first[block.second - 1],
+              static_cast<uint8_t>(block.second));
+    TaskArena::Deallocate(block.first);
+  }
+}
+
+TEST_F(TaskArenaTest, RecycleBlocks) {
+  void *first = TaskArena::Allocate(100);
+  TaskArena::Deallocate(first);
+  // The block returns to the free list of its class and is handed out again.
+  void *second = TaskArena::Allocate(120);
+  ASSERT_EQ(first, second);
+  TaskArena::Deallocate(second);
+}
+
+TEST_F(TaskArenaTest, ReleaseFromOtherThreads) {
+  std::vector<void *> blocks(kNumBlocks);
+  for (size_t i = 0; i < kNumBlocks; ++i)
+    blocks[i] = TaskArena::Allocate(64 + i % 1000);
+
+  // Blocks released by the other threads spill to the shared pool.
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&blocks, t] {
+      for (size_t i = t; i < kNumBlocks; i += 4)
+        TaskArena::Deallocate(blocks[i]);
+    });
+  }
+  for (auto &thread : threads) thread.join();
+
+  for (size_t i = 0; i < kNumBlocks; ++i)
+    blocks[i] = TaskArena::Allocate(64 + i % 1000);
+  for (auto block : blocks) TaskArena::Deallocate(block);
+}
+
+TEST_F(TaskArenaTest, ArenaTaskReleasesClosure) {
+  auto token = std::make_shared<int>(0);
+  auto task = shad::rt::impl::makeArenaTask(
+      [token](int value) { *token += value; });
+  ASSERT_EQ(token.use_count(), 2);
+  task(3);
+  ASSERT_EQ(*token, 3);
+  ASSERT_EQ(token.use_count(), 1);
+}
+
+TEST_F(TaskArenaTest, OverAlignedClosure) {
+  struct alignas(128) Aligned {
+    uint64_t value;
+  };
+  Aligned aligned{5};
+  uint64_t result = 0;
+  auto task = shad::rt::impl::makeArenaTask(
+      [aligned, &result] {
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(&aligned) % alignof(Aligned), 0);
+        result = aligned.value;
+      });
+  task();
+  ASSERT_EQ(result, 5);
+}
+
+TEST_F(TaskArenaTest, MoveArgs) {
+  shad::rt::Handle handle;
+  for (size_t i = 0; i < kNumTasks; ++i) {
+    for (auto &locality : shad::rt::allLocalities()) {
+      LargeArgs args;
+      memset(args.payload, 1, sizeof(args.payload));
+      args.value = 1;
+      shad::rt::asyncExecuteAt(handle, locality, largeTask, std::move(args));
+    }
+  }
+  shad::rt::waitForCompletion(handle);
+  uint64_t numTasks = kNumTasks * shad::rt::numLocalities();
+  CheckCounters(numTasks, 3 * numTasks);
+}
+
+TEST_F(TaskArenaTest, ArgsBuffer) {
+  const uint32_t kBufferSize = 5000;
+  shad::rt::Handle handle;
+  for (size_t i = 0; i < kNumTasks; ++i) {
+    for (auto &locality : shad::rt::allLocalities()) {
+      std::shared_ptr<uint8_t> buffer =
+          shad::rt::allocateArgsBuffer(kBufferSize);
+      memset(buffer.get(), 2, kBufferSize);
+      shad::rt::asyncExecuteAt(handle, locality, bufferTask, buffer,
+                               kBufferSize);
+    }
+  }
+  shad::rt::waitForCompletion(handle);
+  uint64_t numTasks = kNumTasks * shad::rt::numLocalities();
+  CheckCounters(numTasks, 4 * numTasks);
+}
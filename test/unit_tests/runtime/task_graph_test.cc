@@ -0,0 +1,159 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <cstdint>
+#include <system_error>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "shad/runtime/runtime.h"
+#include "shad/runtime/task_graph.h"
+
+static std::atomic<uint64_t> executed(0);
+
+static shad::rt::Locality localityOf(uint64_t i) {
+  return shad::rt::Locality(i % shad::rt::numLocalities());
+}
+
+static void increment(shad::rt::Handle & /*unused*/, const uint64_t &value,
+                      uint64_t *result) {
+  executed.fetch_add(1);
+  *result = value + 1;
+}
+
+static void count(shad::rt::Handle & /*unused*/, const uint64_t &value) {
+  executed.fetch_add(value);
+}
+
+static void drainExecuted(const bool &, uint64_t *result) {
+  *result = executed.exchange(0);
+}
+
+// Sum of the executions on all the localities.
+static uint64_t totalExecuted() {
+  uint64_t total = 0;
+  for (auto &locality : shad::rt::allLocalities()) {
+    uint64_t value = 0;
+    shad::rt::executeAtWithRet(locality, drainExecuted, false, &value);
+    total += value;
+  }
+  return total;
+}
+
+class TaskGraphTest : public ::testing::Test {
+ protected:
+  void SetUp() { totalExecuted(); }
+};
+
+TEST_F(TaskGraphTest, Diamond) {
+  using TaskId = shad::rt::TaskGraph::TaskId;
+  shad::rt::TaskGraph graph;
+  TaskId top = graph.AddTask(localityOf(0), increment, uint64_t(0));
+  auto fromTop = [top](const shad::rt::TaskGraph &graph) {
+    return graph.Result<uint64_t>(top);
+  };
+  TaskId left = graph.AddDeferredTask(localityOf(1), increment, fromTop, {top});
+  TaskId right =
+      graph.AddDeferredTask(localityOf(2), increment, fromTop, {top});
+  TaskId bottom = graph.AddDeferredTask(
+      localityOf(3), increment,
+      [left, right](const shad::rt::TaskGraph &graph) {
+        return graph.Result<uint64_t>(left) + graph.Result<uint64_t>(right);
+      },
+      {left, right});
+
+  shad::rt::Handle handle;
+  graph.Run(handle);
+  shad::rt::waitForCompletion(handle);
+
+  ASSERT_EQ(graph.NumTasks(), 4);
+  ASSERT_EQ(totalExecuted(), 4);
+  ASSERT_EQ(graph.Result<uint64_t>(top), 1);
+  ASSERT_EQ(graph.Result<uint64_t>(left), 2);
+  ASSERT_EQ(graph.Result<uint64_t>(right), 2);
+  ASSERT_EQ(graph.Result<uint64_t>(bottom), 5);
+}
+
+TEST_F(TaskGraphTest, IndependentChains) {
+  static const uint64_t kNumChains = 16;
+  static const uint64_t kChainLength = 32;
+  using TaskId = shad::rt::TaskGraph::TaskId;
+
+  shad::rt::TaskGraph graph;
+  std::vector<TaskId> last;
+  for (uint64_t c = 0; c < kNumChains; ++c)
+    last.push_back(graph.AddTask(localityOf(c), increment, c));
+  for (uint64_t step = 1; step < kChainLength; ++step) {
+    for (uint64_t c = 0; c < kNumChains; ++c) {
+      TaskId previous = last[c];
+      last[c] = graph.AddDeferredTask(
+          localityOf(c + step), increment,
+          [previous](const shad::rt::TaskGraph &graph) {
+            return graph.Result<uint64_t>(previous);
+          },
+          {previous});
+    }
+  }
+  // A void task joining all the chains.
+  graph.AddDeferredTask(
+      localityOf(0), count,
+      [last](const shad::rt::TaskGraph &graph) {
+        uint64_t sum = 0;
+        for (auto id : last) sum += graph.Result<uint64_t>(id);
+        return sum;
+      },
+      last);
+
+  shad::rt::Handle handle;
+  graph.Run(handle);
+  shad::rt::waitForCompletion(handle);
+
+  uint64_t expected = kNumChains * kChainLength;
+  for (uint64_t c = 0; c < kNumChains; ++c) {
+    ASSERT_EQ(graph.Result<uint64_t>(last[c]), c + kChainLength);
+    expected += c + kChainLength;
+  }
+  ASSERT_EQ(totalExecuted(), expected);
+}
+
+TEST_F(TaskGraphTest, RunTwice) {
+  shad::rt::TaskGraph graph;
+  auto first = graph.AddTask(localityOf(1), count, uint64_t(1));
+  graph.AddTask(localityOf(2), count, uint64_t(2), {first});
+
+  for (int i = 0; i < 2; ++i) {
+    shad::rt::Handle handle;
+    graph.Run(handle);
+    shad::rt::waitForCompletion(handle);
+  }
+  ASSERT_EQ(totalExecuted(), 6);
+}
+
+TEST_F(TaskGraphTest, ForwardDependencyThrows) {
+  shad::rt::TaskGraph graph;
+  ASSERT_THROW(graph.AddTask(localityOf(0), count, uint64_t(1), {0}),
+               std::system_error);
+}
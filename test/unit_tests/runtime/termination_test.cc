@@ -0,0 +1,132 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include <atomic>
+#include <cstdint>
+
+#include "gtest/gtest.h"
+
+#include "shad/runtime/collectives.h"
+#include "shad/runtime/runtime.h"
+#include "shad/runtime/termination.h"
+
+static const uint32_t kMaxLocalities = 64;
+static const uint32_t kFanOut = 3;
+static const uint32_t kDepth = 7;
+
+// One slot per locality, also when the localities share the statics.
+static std::atomic<uint64_t> visits[kMaxLocalities];
+
+static void clearVisits(const uint8_t &) {
+  visits[static_cast<uint32_t>(shad::rt::thisLocality())] = 0;
+}
+
+static void countVisits(const uint8_t &, uint64_t *count) {
+  *count = visits[static_cast<uint32_t>(shad::rt::thisLocality())];
+}
+
+// Every task spawns kFanOut tasks on the following localities, until depth
+// reaches 0.
+static void visit(const shad::rt::Epoch &epoch, const uint32_t &depth) {
+  uint32_t L = static_cast<uint32_t>(shad::rt::thisLocality());
+  ++visits[L];
+  if (depth == 0) return;
+  for (uint32_t i = 1; i <= kFanOut; ++i) {
+    shad::rt::Locality next((L + i) % shad::rt::numLocalities());
+    shad::rt::asyncExecuteAt(epoch, next, visit, depth - 1);
+  }
+}
+
+class TerminationTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    if (shad::rt::numLocalities() > kMaxLocalities)
+      GTEST_SKIP() << "too many localities";
+    shad::rt::executeOnAll(clearVisits, uint8_t(0));
+  }
+
+  uint64_t TotalVisits() {
+    uint64_t total;
+    shad::rt::reduce(countVisits, uint8_t(0), &total);
+    return total;
+  }
+
+  // The number of tasks spawned by visit(depth).
+  static uint64_t TreeSize(uint32_t depth) {
+    uint64_t size = 1, level = 1;
+    for (uint32_t i = 0; i < depth; ++i) {
+      level *= kFanOut;
+      size += level;
+    }
+    return size;
+  }
+};
+
+TEST_F(TerminationTest, EmptyEpoch) {
+  auto epoch = shad::rt::createEpoch();
+  ASSERT_FALSE(epoch.IsNull());
+  shad::rt::waitForTermination(epoch);
+  ASSERT_TRUE(epoch.IsNull());
+}
+
+TEST_F(TerminationTest, RecursiveSpawn) {
+  auto epoch = shad::rt::createEpoch();
+  shad::rt::asyncExecuteAt(epoch, shad::rt::thisLocality(), visit, kDepth);
+  shad::rt::waitForTermination(epoch);
+  ASSERT_EQ(TotalVisits(), TreeSize(kDepth));
+}
+
+TEST_F(TerminationTest, SpawnFromAllLocalities) {
+  auto epoch = shad::rt::createEpoch();
+  // Every locality seeds the epoch from a plain task.
+  shad::rt::executeOnAll(
+      [](const shad::rt::Epoch &epoch) {
+        shad::rt::asyncExecuteAt(epoch, shad::rt::thisLocality(), visit,
+                                 kDepth - 2);
+      },
+      epoch);
+  shad::rt::waitForTermination(epoch);
+  ASSERT_EQ(TotalVisits(), shad::rt::numLocalities() * TreeSize(kDepth - 2));
+}
+
+TEST_F(TerminationTest, ConcurrentEpochs) {
+  auto first = shad::rt::createEpoch();
+  auto second = shad::rt::createEpoch();
+  shad::rt::asyncExecuteAt(first, shad::rt::thisLocality(), visit, kDepth - 1);
+  shad::rt::asyncExecuteAt(second, shad::rt::thisLocality(), visit, kDepth);
+  shad::rt::waitForTermination(second);
+  shad::rt::waitForTermination(first);
+  ASSERT_EQ(TotalVisits(), TreeSize(kDepth - 1) + TreeSize(kDepth));
+}
+
+TEST_F(TerminationTest, ReuseSlots) {
+  for (uint32_t i = 0; i < 2 * shad::rt::impl::EpochTable::kMaxEpochs; ++i) {
+    auto epoch = shad::rt::createEpoch();
+    shad::rt::asyncExecuteAt(epoch, shad::rt::thisLocality(), visit, 1u);
+    shad::rt::waitForTermination(epoch);
+  }
+  ASSERT_EQ(TotalVisits(), 2 * shad::rt::impl::EpochTable::kMaxEpochs *
+                               TreeSize(1));
+}
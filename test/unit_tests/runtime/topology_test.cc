@@ -0,0 +1,134 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+
+#include <algorithm>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "shad/runtime/runtime.h"
+#include "shad/runtime/topology.h"
+
+using CpuTopology = shad::rt::impl::CpuTopology;
+
+class TopologyTest : public ::testing::Test {
+ protected:
+  // Back to the configuration of the environment.
+  void TearDown() { CpuTopology::Instance().Configure(0, nullptr); }
+
+  // Workers and reserved cores partition the available CPUs.
+  void CheckPartition() {
+    auto &topology = CpuTopology::Instance();
+    std::vector<int> cpus(topology.WorkerCpus());
+    cpus.insert(cpus.end(), topology.ReservedCpus().begin(),
+                topology.ReservedCpus().end());
+    std::sort(cpus.begin(), cpus.end());
+    ASSERT_EQ(cpus, CpuTopology::AvailableCpus());
+    ASSERT_GE(topology.WorkerCpus().size(), 1);
+  }
+};
+
+TEST_F(TopologyTest, Counts) {
+  ASSERT_GE(shad::rt::numSockets(), 1);
+  ASSERT_GE(shad::rt::numCores(), shad::rt::numSockets());
+  ASSERT_GE(shad::rt::numHardwareThreads(), shad::rt::numCores());
+  ASSERT_GE(shad::rt::numWorkerThreads(), 1);
+  ASSERT_LE(shad::rt::numWorkerThreads(), shad::rt::numHardwareThreads());
+
+  size_t lineSize = shad::rt::cacheLineSize();
+  ASSERT_GT(lineSize, 0);
+  ASSERT_EQ(lineSize & (lineSize - 1), 0);
+  uint32_t previous = 0;
+  for (auto &cache : CpuTopology::Instance().Caches()) {
+    ASSERT_GE(cache.level, previous);
+    ASSERT_GE(cache.numSharing, 1);
+    ASSERT_EQ(shad::rt::cacheSize(cache.level) == 0, cache.size == 0);
+    previous = cache.level;
+  }
+  ASSERT_EQ(shad::rt::cacheSize(100), 0);
+  CheckPartition();
+}
+
+TEST_F(TopologyTest, ParseCpuList) {
+  std::vector<int> expected = {0, 1, 2, 3, 8, 10, 11};
+  ASSERT_EQ(shad::rt::impl::parseCpuList("0-3,8,10-11\n"), expected);
+  ASSERT_TRUE(shad::rt::impl::parseCpuList("").empty());
+}
+
+TEST_F(TopologyTest, Policies) {
+  auto &topology = CpuTopology::Instance();
+  char program[] = "test";
+  char compact[] = "--shad-pin=compact";
+  char scatter[] = "--shad-pin=scatter";
+  char none[] = "--shad-pin=none";
+  char unknown[] = "--shad-unknown";
+
+  char *compactArgs[] = {program, compact, unknown};
+  topology.Configure(3, compactArgs);
+  ASSERT_EQ(shad::rt::pinningPolicy(), shad::rt::PinningPolicy::kCompact);
+  CheckPartition();
+  std::vector<int> compactCpus(topology.WorkerCpus());
+
+  char *scatterArgs[] = {program, scatter};
+  topology.Configure(2, scatterArgs);
+  ASSERT_EQ(shad::rt::pinningPolicy(), shad::rt::PinningPolicy::kScatter);
+  CheckPartition();
+  // The same CPUs, in a different order.
+  std::vector<int> scatterCpus(topology.WorkerCpus());
+  std::sort(compactCpus.begin(), compactCpus.end());
+  std::sort(scatterCpus.begin(), scatterCpus.end());
+  ASSERT_EQ(compactCpus, scatterCpus);
+  for (size_t i = 0; i < scatterCpus.size(); ++i)
+    ASSERT_NE(std::find(scatterCpus.begin(), scatterCpus.end(),
+                        topology.WorkerCpu(i)),
+              scatterCpus.end());
+
+  char *noneArgs[] = {program, none};
+  topology.Configure(2, noneArgs);
+  ASSERT_EQ(shad::rt::pinningPolicy(), shad::rt::PinningPolicy::kNone);
+}
+
+TEST_F(TopologyTest, ReservedCores) {
+  auto &topology = CpuTopology::Instance();
+  char program[] = "test";
+  char reserveOne[] = "--shad-reserved-cores=1";
+  char reserveAll[] = "--shad-reserved-cores=100000";
+
+  char *oneArgs[] = {program, reserveOne};
+  topology.Configure(2, oneArgs);
+  CheckPartition();
+  if (topology.NumCores() > 1) {
+    ASSERT_EQ(topology.NumReservedCores(), 1);
+    ASSERT_FALSE(topology.ReservedCpus().empty());
+  } else {
+    ASSERT_EQ(topology.NumReservedCores(), 0);
+  }
+
+  // At least one core is left to the workers.
+  char *allArgs[] = {program, reserveAll};
+  topology.Configure(2, allArgs);
+  CheckPartition();
+  ASSERT_EQ(topology.NumReservedCores(), topology.NumCores() - 1);
+}
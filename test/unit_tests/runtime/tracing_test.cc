@@ -0,0 +1,248 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+//                                     SHAD
+//
+//      The Scalable High-performance Algorithms and Data Structure Library
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright 2018 Battelle Memorial Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy
+// of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "shad/runtime/runtime.h"
+
+using shad::rt::impl::TraceOp;
+
+struct Payload {
+  uint64_t values[3];
+};
+
+static void consume(const Payload &) {}
+
+static void asyncConsume(shad::rt::Handle &, const Payload &) {}
+
+#if !defined(SHAD_ENABLE_TRACING)
+
+TEST(TracingTest, DisabledTracingIsTransparent) {
+  using TaskTy = std::function<void()>;
+  static_assert(
+      std::is_same<decltype(shad::rt::impl::TraceTask(0,
+                                                      std::declval<TaskTy>())),
+                   TaskTy &&>::value,
+      "Tasks must be queued unchanged when the tracing is disabled");
+
+  // The instrumented calls behave as usual.
+  Payload payload{{1, 2, 3}};
+  shad::rt::Handle handle;
+  for (auto &locality : shad::rt::allLocalities()) {
+    shad::rt::executeAt(locality, consume, payload);
+    shad::rt::asyncExecuteAt(handle, locality, asyncConsume, payload);
+  }
+  shad::rt::waitForCompletion(handle);
+}
+
+#else
+
+static uint32_t thisLocality() {
+  return static_cast<uint32_t>(shad::rt::thisLocality());
+}
+
+static uint64_t calls(TraceOp op) {
+  return shad::rt::impl::Tracer::Instance().Calls(thisLocality(), op);
+}
+
+static uint64_t bytesSent(const shad::rt::Locality &dst) {
+  return shad::rt::impl::Tracer::Instance().BytesSent(
+      thisLocality(), static_cast<uint32_t>(dst));
+}
+
+static uint64_t bytesReceived(const shad::rt::Locality &src) {
+  return shad::rt::impl::Tracer::Instance().BytesReceived(
+      thisLocality(), static_cast<uint32_t>(src));
+}
+
+static void asyncFillResult(shad::rt::Handle &, const uint32_t &size,
+                            uint8_t *result, uint32_t *resultSize) {
+  std::fill(result, result + size, 42);
+  *resultSize = size;
+}
+
+static void asyncDouble(shad::rt::Handle &, const uint64_t &value,
+                        uint64_t *result) {
+  *result = 2 * value;
+}
+
+static void tasksOf(const bool &, uint64_t *result) {
+  *result = shad::rt::impl::Tracer::Instance().Tasks(thisLocality());
+}
+
+static uint64_t tasksAt(const shad::rt::Locality &locality) {
+  uint64_t tasks = 0;
+  shad::rt::executeAtWithRet(locality, tasksOf, false, &tasks);
+  return tasks;
+}
+
+TEST(TracingTest, CallsAndBytesPerDestination) {
+  static const uint64_t kNumCalls = 16;
+  auto localities = shad::rt::allLocalities();
+  Payload payload{{1, 2, 3}};
+
+  auto executeAtCalls = calls(TraceOp::kExecuteAt);
+  auto asyncExecuteAtCalls = calls(TraceOp::kAsyncExecuteAt);
+  auto executeOnAllCalls = calls(TraceOp::kExecuteOnAll);
+  std::vector<uint64_t> sent;
+  for (auto &locality : localities) sent.push_back(bytesSent(locality));
+
+  shad::rt::Handle handle;
+  for (uint64_t i = 0; i < kNumCalls; ++i) {
+    for (auto &locality : localities) {
+      shad::rt::executeAt(locality, consume, payload);
+      shad::rt::asyncExecuteAt(handle, locality, asyncConsume, payload);
+    }
+  }
+  shad::rt::waitForCompletion(handle);
+  shad::rt::executeOnAll(consume, payload);
+
+  ASSERT_EQ(calls(TraceOp::kExecuteAt) - executeAtCalls,
+            kNumCalls * localities.size());
+  ASSERT_EQ(calls(TraceOp::kAsyncExecuteAt) - asyncExecuteAtCalls,
+            kNumCalls * localities.size());
+  ASSERT_EQ(calls(TraceOp::kExecuteOnAll) - executeOnAllCalls, 1);
+  size_t i = 0;
+  for (auto &locality : localities) {
+    ASSERT_EQ(bytesSent(locality) - sent[i++],
+              (2 * kNumCalls + 1) * sizeof(Payload));
+  }
+}
+
+TEST(TracingTest, AsyncResultsAreReceivedOnCompletion) {
+  static const uint32_t kResultSize = 40;
+  auto localities = shad::rt::allLocalities();
+
+  std::vector<uint64_t> received;
+  for (auto &locality : localities) received.push_back(bytesReceived(locality));
+
+  shad::rt::Handle handle;
+  std::vector<uint8_t> buffers(localities.size() * kResultSize);
+  std::vector<uint32_t> sizes(localities.size(), 0);
+  std::vector<uint64_t> doubled(localities.size(), 0);
+  size_t i = 0;
+  for (auto &locality : localities) {
+    shad::rt::asyncExecuteAtWithRetBuff(handle, locality, asyncFillResult,
+                                        kResultSize, &buffers[i * kResultSize],
+                                        &sizes[i]);
+    shad::rt::asyncExecuteAtWithRet(handle, locality, asyncDouble, uint64_t(i),
+                                    &doubled[i]);
+    ++i;
+  }
+
+  // Nothing is received before the handle completes.
+  i = 0;
+  for (auto &locality : localities)
+    ASSERT_EQ(bytesReceived(locality), received[i++]);
+
+  shad::rt::waitForCompletion(handle);
+  i = 0;
+  for (auto &locality : localities) {
+    ASSERT_EQ(sizes[i], kResultSize);
+    ASSERT_EQ(doubled[i], 2 * i);
+    ASSERT_EQ(bytesReceived(locality) - received[i++],
+              kResultSize + sizeof(uint64_t));
+  }
+}
+
+TEST(TracingTest, DmaBytes) {
+  static const size_t kNumElements = 1024;
+  std::vector<uint64_t> source(kNumElements, 42), destination(kNumElements);
+  auto here = shad::rt::thisLocality();
+
+  auto dmaCalls = calls(TraceOp::kDma);
+  auto sent = bytesSent(here);
+  shad::rt::dma(here, destination.data(), source.data(), kNumElements);
+
+  ASSERT_EQ(calls(TraceOp::kDma) - dmaCalls, 1);
+  ASSERT_EQ(bytesSent(here) - sent, kNumElements * sizeof(uint64_t));
+  ASSERT_EQ(destination, source);
+}
+
+#if defined(HAVE_SIM) || defined(HAVE_SHM) || defined(HAVE_WS) || \
+    defined(HAVE_TBB)
+TEST(TracingTest, TasksAreTimed) {
+  static const uint64_t kNumTasks = 32;
+  auto localities = shad::rt::allLocalities();
+  Payload payload{{1, 2, 3}};
+
+  std::vector<uint64_t> tasks;
+  for (auto &locality : localities) tasks.push_back(tasksAt(locality));
+
+  shad::rt::Handle handle;
+  for (uint64_t i = 0; i < kNumTasks; ++i)
+    for (auto &locality : localities)
+      shad::rt::asyncExecuteAt(handle, locality, asyncConsume, payload);
+  shad::rt::waitForCompletion(handle);
+
+  // A task is recorded when it returns, which may be after waitForCompletion
+  // has observed its completion.
+  size_t i = 0;
+  for (auto &locality : localities) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (tasksAt(locality) - tasks[i] < kNumTasks &&
+           std::chrono::steady_clock::now() < deadline)
+      std::this_thread::yield();
+    ASSERT_GE(tasksAt(locality) - tasks[i++], kNumTasks);
+  }
+}
+#endif
+
+TEST(TracingTest, Export) {
+  std::string prefix = ::testing::TempDir() + "shad_tracing_test";
+  setenv("SHAD_TRACE_PREFIX", prefix.c_str(), 1);
+  shad::rt::executeAt(shad::rt::thisLocality(), consume, Payload{{1, 2, 3}});
+  shad::rt::impl::Tracer::Instance().Export(thisLocality());
+  unsetenv("SHAD_TRACE_PREFIX");
+
+  std::string base = prefix + "." + std::to_string(thisLocality());
+  std::ifstream counters(base + ".json");
+  ASSERT_TRUE(counters.good());
+  std::stringstream content;
+  content << counters.rdbuf();
+  ASSERT_NE(content.str().find("\"executeAt\": "), std::string::npos);
+  ASSERT_NE(content.str().find("\"queueWaitNs\": ["), std::string::npos);
+
+  std::ifstream timeline(base + ".trace.json");
+  ASSERT_TRUE(timeline.good());
+  std::stringstream events;
+  events << timeline.rdbuf();
+  ASSERT_EQ(events.str().find("{\"traceEvents\": ["), 0);
+  ASSERT_NE(events.str().find("\"name\": \"executeAt\""), std::string::npos);
+}
+
+#endif  // !defined(SHAD_ENABLE_TRACING)